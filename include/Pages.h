@@ -87,7 +87,6 @@ void doBacklightSlider(BDSlider *  aTheTouchedSlider,  uint16_t aBrightness);
 #endif
 
 void initClockSettingElements(void);
-void deinitClockSettingElements(void);
 void drawClockSettingElements(void);
 
 void startSettingsPage(void);
@@ -147,6 +146,13 @@ void startTestsPage(void);
 void loopTestsPage(void);
 void stopTestsPage(void);
 
+/**
+ * From Benchmark page
+ */
+void startBenchmarkPage(void);
+void loopBenchmarkPage(void);
+void stopBenchmarkPage(void);
+
 /**
  * From Info page
  */
@@ -489,6 +489,7 @@ bool setDisplayRange(int aNewDisplayRangeIndex, bool aClipToIndexInputRange);
 void adjustPreTriggerBuffer(void);
 uint16_t computeNumberOfSamplesToTimeout(int8_t aTimebaseIndex);
 void computeMinMaxAverageAndPeriodFrequency(void);
+void DMACheckForTriggerCondition(void);
 bool setDisplayRange(int aNewRangeIndex);
 void setOffsetGridCountAccordingToACMode(void);
 void setACMode(bool aACRangeEnable);
@@ -108,6 +108,10 @@ public:
 
 #ifdef LOCAL_DISPLAY_EXISTS
     void deinit(void);
+#ifdef USE_BUTTON_POOL
+    static void startButtonPage(void);
+    static void deinitAllButtonsOfPage(void);
+#endif
     TouchButton * mLocalButtonPtr;
 #endif
 
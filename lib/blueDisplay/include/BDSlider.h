@@ -108,6 +108,10 @@ public:
     uint16_t getPositionXRight(void) const;
     uint16_t getPositionYBottom(void) const;
     void deinit(void);
+#ifdef USE_SLIDER_POOL
+    static void startSliderPage(void);
+    static void deinitAllSlidersOfPage(void);
+#endif
     TouchSlider * mLocalSliderPointer;
 #endif
 
@@ -51,6 +51,19 @@ typedef uint16_t Color_t; // is needed in EventHandler.h
 #define DISPLAY_DEFAULT_WIDTH 320
 #define STRING_BUFFER_STACK_SIZE 22 // Buffer size allocated on stack for ...PGM() functions.
 
+/*
+ * Last sent value, color and caption of buttons and value of sliders are cached,
+ * in order not to send setters which would not change the state of the remote side.
+ * Activate the define to save the RAM of the cache.
+ */
+//#define DO_NOT_CACHE_GUI_STATE
+#ifdef AVR
+#define DO_NOT_CACHE_GUI_STATE
+#endif
+#define GUI_STATE_CACHE_NUMBER_OF_BUTTONS 40 // handles above are never cached
+#define GUI_STATE_CACHE_NUMBER_OF_SLIDERS 16
+#define GUI_STATE_CACHE_CAPTION_LENGTH 12 // longer captions are always sent
+
 /*
  * Basic colors
  */
@@ -381,6 +394,8 @@ struct ThickLine {
     Color_t BackgroundColor;
 };
 
+#define REFRESH_VECTORS_MAX_NUMBER 8 // for refreshVectors()
+
 #ifdef __cplusplus
 #define MAX_NUMBER_OF_ARGS_FOR_BD_FUNCTIONS 12 // for sending
 
@@ -404,6 +419,10 @@ public:
     void setLongTouchDownTimeout(uint16_t aLongTouchDownTimeoutMillis);
 
     void clearDisplay(Color_t aColor);
+    void startFrame(void);
+    void endFrame(void);
+    void startReplaceableStream(uint8_t aStreamIndex);
+    void endReplaceableStream(void);
     void drawDisplayDirect(void);
     void setScreenOrientationLock(uint8_t aLockMode);
 
@@ -417,6 +436,12 @@ public:
     uint16_t drawChar(uint16_t aPosX, uint16_t aPosY, char aChar, uint16_t aCharSize, Color_t aFGColor, Color_t aBGColor);
     uint16_t drawText(uint16_t aXStart, uint16_t aYStart, const char *aStringPtr, uint16_t aFontSize, Color_t aFGColor,
             Color_t aBGColor);
+    uint16_t drawRegisteredText(uint16_t aXStart, uint16_t aYStart, const char *aStringPtr, uint16_t aFontSize,
+            Color_t aFGColor, Color_t aBGColor);
+    uint8_t getRegisteredStringID(const char * aStringPtr);
+    void setStringRegistration(bool aEnable);
+    void resetRegisteredStrings(void);
+    void resendRegisteredStrings(void);
 
     uint16_t drawByte(uint16_t aPosX, uint16_t aPosY, int8_t aByte, uint16_t aTextSize, Color_t aFGColor, Color_t aBGColor);
     uint16_t drawUnsignedByte(uint16_t aPosX, uint16_t aPosY, uint8_t aUnsignedByte, uint16_t aTextSize, Color_t aFGColor,
@@ -445,6 +470,8 @@ public:
             size_t aByteBufferLength);
     void drawChartByteBuffer(uint16_t aXOffset, uint16_t aYOffset, Color_t aColor, Color_t aClearBeforeColor, uint8_t aChartIndex,
     bool aDoDrawDirect, uint8_t *aByteBuffer, size_t aByteBufferLength);
+    void setChartDeltaEncoding(bool aEnable);
+    void resetChartDeltaReferences(void);
 
     struct XYSize * getMaxDisplaySize(void);
     uint16_t getMaxDisplayWidth(void);
@@ -460,6 +487,7 @@ public:
     bool isDisplayOrientationLandscape(void);
 
     void refreshVector(struct ThickLine * aLine, int16_t aNewRelEndX, int16_t aNewRelEndY);
+    void refreshVectors(struct ThickLine * const aLines[], const int16_t aNewRelEnds[][2], uint8_t aNumberOfVectors);
 
     void getNumber(void (*aNumberHandler)(float));
     void getNumberWithShortPrompt(void (*aNumberHandler)(float), const char *aShortPromptString);
@@ -509,6 +537,12 @@ public:
     void setButtonsGlobalFlags(uint16_t aFlags);
     void setButtonsTouchTone(uint8_t aToneIndex, uint8_t aToneVolume);
 
+    void setGUIStateCaching(bool aEnable);
+    void resetGUIStateCache(void);
+    void cacheButtonState(BDButtonHandle_t aButtonNumber, Color_t aButtonColor, int16_t aValue, const char * aCaption);
+    void resetButtonStateCache(BDButtonHandle_t aButtonNumber);
+    void resetSliderStateCache(BDSliderHandle_t aSliderNumber);
+
 #ifdef AVR
     BDButtonHandle_t createButtonPGM(uint16_t aPositionX, uint16_t aPositionY, uint16_t aWidthX, uint16_t aHeightY,
             Color_t aButtonColor, const char * aPGMCaption, uint8_t aCaptionSize, uint8_t aFlags, int16_t aValue,
@@ -545,6 +579,9 @@ public:
 
     volatile bool mConnectionEstablished;
     volatile bool mOrientationIsLandscape;
+    bool mChartDeltaEncodingEnabled; // remote side must support FUNCTION_DRAW_CHART_DELTA
+    bool mStringRegistrationEnabled; // remote side must support FUNCTION_REGISTER_STRING
+    bool mGUIStateCachingEnabled;
 
     /* for tests */
     void drawGreyscale(uint16_t aXPos, uint16_t tYPos, uint16_t aHeight);
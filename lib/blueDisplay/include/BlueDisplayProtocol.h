@@ -89,6 +89,8 @@
 #define EVENT_REORIENTATION 0x12
 // disconnect event sent if manually disconnected (does not cover out of range etc.)
 #define EVENT_DISCONNECT 0x14
+// answer to FUNCTION_BAUD_NEGOTIATION and FUNCTION_BAUD_TEST_PATTERN
+#define EVENT_BAUD_NEGOTIATION 0x15
 
 // command sizes
 #define TOUCH_COMMAND_MAX_DATA_SIZE 15
@@ -154,6 +156,12 @@ struct Swipe {
     uint16_t TouchDeltaAbsMax; // max of TouchDeltaXAbs and TouchDeltaYAbs to easily decide if swipe is large enough to be accepted
 };
 
+struct BaudNegotiationInfo {
+    uint16_t SubFunction; // SUBFUNCTION_BAUD_* of the request
+    uint16_t Value; // 1 if proposed baud rate is accepted or CRC of received test pattern
+    uint32_t BaudRate; // proposed baud rate or length of received test pattern
+};
+
 union ShortLongFloatUnion {
     uint16_t Int16Value;
     uint32_t Int32Value;
@@ -197,6 +205,7 @@ struct BluetoothEvent {
         struct Swipe SwipeInfo;
         struct SensorCallback SensorCallbackInfo;
         struct IntegerInfoCallback IntegerInfoCallbackData;
+        struct BaudNegotiationInfo BaudNegotiationInfo;
     } EventData;
 };
 
@@ -232,6 +241,20 @@ static const int FUNCTION_REQUEST_MAX_CANVAS_SIZE = 0x09;
  *********************/
 static const int FUNCTION_SENSOR_SETTINGS = 0x0A;
 
+/**********************
+ * Baud rate negotiation - see negotiateUSARTBaudRate() in BlueSerial.cpp
+ *********************/
+static const int FUNCTION_BAUD_NEGOTIATION = 0x0B;
+// Sub functions for BAUD_NEGOTIATION. Each is answered by EVENT_BAUD_NEGOTIATION.
+// 2 additional parameters are the low and high word of the proposed baud rate.
+// Answer is sent with the old baud rate, then the remote side switches to the proposed one.
+static const int SUBFUNCTION_BAUD_PROPOSE = 0x00;
+// Sent with the new baud rate after the test patterns were received without error.
+// Without it the remote side falls back to the old baud rate after BAUD_NEGOTIATION_REVERT_MILLIS.
+static const int SUBFUNCTION_BAUD_CONFIRM = 0x01;
+// used in EVENT_BAUD_NEGOTIATION as answer to FUNCTION_BAUD_TEST_PATTERN
+static const int SUBFUNCTION_BAUD_TEST_PATTERN = 0x02;
+
 /**********************
  * Miscellaneous functions
  *********************/
@@ -256,6 +279,8 @@ const int FUNCTION_DRAW_DISPLAY = 0x11;
 const int FUNCTION_DRAW_PIXEL = 0x14;
 // 6 parameter
 const int FUNCTION_DRAW_CHAR = 0x16;
+// 6 parameter. Like FUNCTION_DRAW_STRING, but last parameter is the ID of a string registered by FUNCTION_REGISTER_STRING.
+const int FUNCTION_DRAW_REGISTERED_STRING = 0x17;
 // 5 parameter
 const int FUNCTION_DRAW_LINE_REL = 0x20;
 const int FUNCTION_DRAW_LINE = 0x21;
@@ -278,6 +303,8 @@ const int INDEX_LAST_FUNCTION_WITHOUT_DATA = 0x5F;
 const int FUNCTION_DRAW_STRING = 0x60;
 const int FUNCTION_DEBUG_STRING = 0x61;
 const int FUNCTION_WRITE_STRING = 0x62;
+// 1 parameter is the ID (0 to STRING_TABLE_SIZE - 1) under which the string is stored. See StringTable.h.
+const int FUNCTION_REGISTER_STRING = 0x63;
 
 const int FUNCTION_GET_NUMBER_WITH_SHORT_PROMPT = 0x64;
 const int FUNCTION_GET_TEXT_WITH_SHORT_PROMPT = 0x65;
@@ -286,6 +313,11 @@ const int FUNCTION_DRAW_PATH = 0x68;
 const int FUNCTION_FILL_PATH = 0x69;
 const int FUNCTION_DRAW_CHART = 0x6A;
 const int FUNCTION_DRAW_CHART_WITHOUT_DIRECT_RENDERING = 0x6B;
+// Data is delta encoded against last chart with same index - see ChartDelta.h. 5. parameter is the decoded length.
+const int FUNCTION_DRAW_CHART_DELTA = 0x6C;
+const int FUNCTION_DRAW_CHART_DELTA_WITHOUT_DIRECT_RENDERING = 0x6D;
+// No parameter. Answered by EVENT_BAUD_NEGOTIATION with CRC16 CCITT and length of the received data.
+const int FUNCTION_BAUD_TEST_PATTERN = 0x6E;
 
 /**********************
  * Button functions
@@ -309,6 +341,9 @@ const int SUBFUNCTION_BUTTON_RESET_ACTIVE = 0x11;
 const int SUBFUNCTION_BUTTON_SET_AUTOREPEAT_TIMING = 0x12;
 
 const int FUNCTION_BUTTON_REMOVE = 0x43;
+// 2 parameter button index and ID of a string registered by FUNCTION_REGISTER_STRING
+const int FUNCTION_BUTTON_SET_REGISTERED_CAPTION = 0x44;
+const int FUNCTION_BUTTON_SET_REGISTERED_CAPTION_AND_DRAW_BUTTON = 0x45;
 
 // static functions
 const int FUNCTION_BUTTON_ACTIVATE_ALL = 0x48;
@@ -37,6 +37,8 @@
 #include "stm32f3xx_hal_conf.h" // for UART_HandleTypeDef
 #endif
 #include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
 
 #define BAUD_STRING_4800 "4800"
 #define BAUD_STRING_9600 "9600"
@@ -60,6 +62,72 @@
 #define BAUD_921600 ( 921600)
 #define BAUD_1382400 (1382400)
 
+#define UART_SEND_BUFFER_SIZE 1024
+#define SEND_TIMEOUT_MILLIS 300 // enough for 256 bytes at 9600
+// Inside a frame a transfer is started if this number of bytes is collected, so sending overlaps computation
+#define SEND_FRAME_FLUSH_THRESHOLD 128
+// not a multiple of TOUCH_COMMAND_SIZE_BYTE in order to discover overruns
+#define USART_RECEIVE_BUFFER_SIZE (TOUCH_COMMAND_MAX_DATA_SIZE * 10 -1)
+// Number of received events which can wait for checkAndHandleEvents(). One entry is always unused.
+#define RECEIVE_EVENT_QUEUE_SIZE 16
+
+/*
+ * Replaceable streams - a newer message supersedes an unsent older one if the link is saturated
+ */
+#define SEND_STREAM_CHART_0 0
+#define SEND_STREAM_CHART_1 1
+#define SEND_STREAM_INFO 2
+#define NUMBER_OF_SEND_STREAMS 3
+#define SEND_STREAM_NONE 0xFF
+#define SEND_STREAM_SLOT_SIZE 352 // 320 byte chart + command and data header
+// Stream data is not written to send buffer if less than this space would be left for control traffic
+#define SEND_BUFFER_CONTROL_RESERVE 128
+
+// Number of data buffers given to sendUSARTBufferNoCopy() which can be queued
+#define USART_NO_COPY_QUEUE_SIZE 8
+// Constant data from flash with this size or more is not copied to send buffer
+#define USART_NO_COPY_MIN_LENGTH 64
+
+/*
+ * Retained display list of the actual page, which is sent again on reconnect or redraw request
+ * instead of calling the redraw callback. Needs DISPLAY_LIST_SIZE bytes RAM.
+ */
+//#define USE_DISPLAY_LIST
+
+/*
+ * Baud rate negotiation
+ */
+#define BAUD_TEST_PATTERN_LENGTH 256
+#define BAUD_TEST_PATTERN_REPEATS 4 // 1 kByte for throughput measurement
+#define BAUD_NEGOTIATION_ANSWER_TIMEOUT_MILLIS 200 // plus the transfer time of the test patterns
+#define BAUD_NEGOTIATION_SETTLE_MILLIS 5 // time for remote side to switch after sending its answer
+#define BAUD_NEGOTIATION_REVERT_MILLIS 1000 // remote side falls back to old baud rate if not confirmed after this time
+#define BAUD_NEGOTIATION_MAX_BAUD_RATE BAUD_1382400 // maximum of HC-05
+
+struct BaudNegotiationStatistics {
+    uint32_t BaudRate; // result of last negotiation
+    uint32_t BytesPerSecond; // effective throughput of test pattern round trip, 0 if remote does not support negotiation
+    uint16_t Fallbacks; // baud rates accepted by remote but failed the test pattern
+    uint16_t Rejected; // baud rates not supported by remote
+};
+extern struct BaudNegotiationStatistics BaudNegotiationStatistics;
+
+struct SendStatistics {
+    uint32_t Superseded; // unsent stream messages replaced by a newer one
+    uint32_t Dropped; // stream messages not fitting in SEND_STREAM_SLOT_SIZE
+    uint32_t MaxBlockingMillis; // longest wait of control traffic for free buffer space
+    uint32_t Timeouts; // control commands skipped, since buffer space was not available after SEND_TIMEOUT_MILLIS
+};
+extern struct SendStatistics SendStatistics;
+
+struct ReceiveStatistics {
+    uint32_t Events; // complete events received
+    uint32_t Overflows; // events dropped because the event queue was full
+    uint32_t SyncErrors; // messages discarded because of invalid length or missing sync token
+    uint16_t MaxQueueLength; // maximum number of events waiting in queue
+};
+extern struct ReceiveStatistics ReceiveStatistics;
+
 /*
  * common functions
  */
@@ -108,6 +176,37 @@ void sendUSART5ArgsAndShortBuffer(uint8_t aFunctionTag, uint16_t aXStart, uint16
 #define BLUETOOTH_PAIRED_DETECT_PORT    GPIOA
 #endif
 
+#ifdef HOST_SIMULATION
+// No UART on host, the paired state is set by the host test program
+extern bool HostBluetoothPaired;
+static inline bool USART_isBluetoothPaired(void) {
+    return HostBluetoothPaired;
+}
+
+/*
+ * Simulated link of BlueSerial_Host.cpp.
+ * Time is only simulated and advanced by hostAdvanceLinkTime() and by waiting for free buffer space.
+ */
+struct HostLinkCounter {
+    uint32_t Transfers; // DMA transfers started
+    uint32_t Bytes;
+    uint32_t BlockingWaits; // waits for free space in send buffer
+    uint64_t BusyNanos; // time the line was busy including transfer overhead
+};
+extern struct HostLinkCounter HostLinkCounters;
+extern uint64_t HostLinkNanos; // simulated time
+extern uint32_t HostLinkTransferOverheadNanos; // ISR, DMA restart and gap on line for each transfer
+extern void (*HostLinkWriteCallback)(const uint8_t * aData, size_t aLength);
+extern void (*HostLinkReadCallback)(void); // called before checking for received data, may call hostReceiveBytes()
+// Time step for polling the receive buffer during blocking waits, if HostLinkReadCallback is set
+#define HOST_RECEIVE_POLL_NANOS 1000000
+
+void hostResetLinkCounters(void);
+void hostAdvanceLinkTime(uint32_t aNanos);
+void hostWaitForUSARTTransferComplete(void);
+void hostFlushLink(void);
+void hostReceiveBytes(const uint8_t * aData, size_t aLength);
+#else
 // The UART used by BlueDisplay
 extern UART_HandleTypeDef UART_BD_Handle;
 #ifdef __cplusplus
@@ -124,12 +223,26 @@ __STATIC_INLINE bool USART_isBluetoothPaired(void) {
     }
     return false;
 }
+#endif
 
 // Send functions using buffer and DMA
 int getSendBufferFreeSpace(void);
+void startSendFrame(void);
+void endSendFrame(void);
+void startSendStream(uint8_t aStreamIndex);
+void endSendStream(void);
+void flushSendStreams(void);
+void discardSendStreams(void);
+bool isSendStreamPending(uint8_t aStreamIndex);
+bool isSendStreamActive(void);
+void resetSendStatistics(void);
+void UART_BD_DMA_TX_start(uint8_t * aMemoryBaseAddr, uint32_t aBufferSize);
+bool chainUSARTTransfer(void);
 
 void UART_BD_initialize(uint32_t aBaudRate);
+#ifndef HOST_SIMULATION
 void HAL_UART_MspInit(UART_HandleTypeDef* aUARTHandle);
+#endif
 
 uint32_t getUSART_BD_BaudRate(void);
 void setUART_BD_BaudRate(uint32_t aBaudRate);
@@ -141,6 +254,146 @@ void sendUSARTBufferSimple(uint8_t * aParameterBufferPointer, size_t aParameterB
 // Function using DMA
 void sendUSARTBufferNoSizeCheck(uint8_t * aParameterBufferPointer, size_t aParameterBufferLength,
         uint8_t * aDataBufferPointer, size_t aDataBufferLength);
+void sendUSARTBufferNoCopy(uint8_t * aParameterBufferPointer, size_t aParameterBufferLength,
+        uint8_t * aDataBufferPointer, size_t aDataBufferLength);
+void waitForUSARTNoCopyTransfersComplete(void);
+void waitForUSARTSendComplete(void);
+void sendUSARTBuffer(uint8_t * aParameterBufferPointer, size_t aParameterBufferLength, uint8_t * aDataBufferPointer,
+        size_t aDataBufferLength);
+int32_t getReceiveBytesAvailable(void);
+void receiveUSARTEvents(void);
+bool isReceivedDataPending(void);
 void checkAndHandleMessageReceived(void);
+void resetReceiveStatistics(void);
+
+#ifdef USE_DISPLAY_LIST
+#include "DisplayList.h"
+extern struct DisplayList RetainedDisplayList;
+void setDisplayListRecording(bool aEnable);
+bool isDisplayListRecording(void);
+bool isDisplayListReplayable(void);
+void discardDisplayList(void);
+bool replayDisplayList(void);
+#endif
+
+uint32_t negotiateUSARTBaudRate(uint32_t aMaxBaudRate);
+uint32_t measureUSARTThroughput(void);
+void handleBaudNegotiationEvent(struct BaudNegotiationInfo * aBaudNegotiationInfo);
+void fillBaudTestPattern(uint8_t * aBuffer);
+uint16_t computeCRC16CCITT(const uint8_t * aData, size_t aLength);
+
+#ifdef __cplusplus
+#include "BlueDisplayProtocol.h"
+#include <type_traits>
+
+/*
+ * Command encoders with compile time checks.
+ * The parameters are written as uint16_t into a parameter buffer of compile time known size,
+ * so there is no va_list walk and no widening to int like for sendUSARTArgs().
+ * The number of parameters is checked against the BD_FUNCTION_ARGS() entry of the function tag
+ * and tags without an entry do not compile. Tags which are computed at runtime must use sendUSARTArgs().
+ */
+template<int aFunctionTag> struct BDFunctionArgs;
+
+#define BD_FUNCTION_ARGS(aFunctionTag, aMinNumberOfArgs, aMaxNumberOfArgs) \
+template<> struct BDFunctionArgs<aFunctionTag> { \
+    static const int Min = aMinNumberOfArgs; \
+    static const int Max = aMaxNumberOfArgs; \
+}
+
+BD_FUNCTION_ARGS(FUNCTION_GLOBAL_SETTINGS, 2, 4);
+BD_FUNCTION_ARGS(FUNCTION_PLAY_TONE, 1, 3);
+BD_FUNCTION_ARGS(FUNCTION_SENSOR_SETTINGS, 4, 4);
+BD_FUNCTION_ARGS(FUNCTION_BAUD_NEGOTIATION, 1, 3);
+BD_FUNCTION_ARGS(FUNCTION_REQUEST_MAX_CANVAS_SIZE, 0, 0);
+BD_FUNCTION_ARGS(FUNCTION_CLEAR_DISPLAY, 1, 1);
+BD_FUNCTION_ARGS(FUNCTION_DRAW_DISPLAY, 0, 0);
+BD_FUNCTION_ARGS(FUNCTION_DRAW_PIXEL, 3, 3);
+BD_FUNCTION_ARGS(FUNCTION_DRAW_CHAR, 6, 6);
+BD_FUNCTION_ARGS(FUNCTION_DRAW_REGISTERED_STRING, 6, 6);
+BD_FUNCTION_ARGS(FUNCTION_DRAW_LINE_REL, 5, 6);
+BD_FUNCTION_ARGS(FUNCTION_DRAW_LINE, 5, 6);
+BD_FUNCTION_ARGS(FUNCTION_DRAW_RECT_REL, 5, 6);
+BD_FUNCTION_ARGS(FUNCTION_FILL_RECT_REL, 5, 5);
+BD_FUNCTION_ARGS(FUNCTION_DRAW_RECT, 5, 6);
+BD_FUNCTION_ARGS(FUNCTION_FILL_RECT, 5, 5);
+BD_FUNCTION_ARGS(FUNCTION_DRAW_CIRCLE, 5, 5);
+BD_FUNCTION_ARGS(FUNCTION_FILL_CIRCLE, 4, 4);
+BD_FUNCTION_ARGS(FUNCTION_WRITE_SETTINGS, 3, 5);
+BD_FUNCTION_ARGS(FUNCTION_BUTTON_DRAW, 1, 1);
+BD_FUNCTION_ARGS(FUNCTION_BUTTON_DRAW_CAPTION, 1, 1);
+BD_FUNCTION_ARGS(FUNCTION_BUTTON_SETTINGS, 2, 7);
+BD_FUNCTION_ARGS(FUNCTION_BUTTON_REMOVE, 2, 2);
+BD_FUNCTION_ARGS(FUNCTION_BUTTON_SET_REGISTERED_CAPTION, 2, 2);
+BD_FUNCTION_ARGS(FUNCTION_BUTTON_SET_REGISTERED_CAPTION_AND_DRAW_BUTTON, 2, 2);
+BD_FUNCTION_ARGS(FUNCTION_BUTTON_ACTIVATE_ALL, 0, 0);
+BD_FUNCTION_ARGS(FUNCTION_BUTTON_DEACTIVATE_ALL, 0, 0);
+BD_FUNCTION_ARGS(FUNCTION_BUTTON_GLOBAL_SETTINGS, 1, 4);
+BD_FUNCTION_ARGS(FUNCTION_SLIDER_CREATE, 11, 12);
+BD_FUNCTION_ARGS(FUNCTION_SLIDER_DRAW, 1, 1);
+BD_FUNCTION_ARGS(FUNCTION_SLIDER_SETTINGS, 2, 7);
+BD_FUNCTION_ARGS(FUNCTION_SLIDER_DRAW_BORDER, 1, 1);
+BD_FUNCTION_ARGS(FUNCTION_SLIDER_ACTIVATE_ALL, 0, 0);
+BD_FUNCTION_ARGS(FUNCTION_SLIDER_DEACTIVATE_ALL, 0, 0);
+// functions with data field
+BD_FUNCTION_ARGS(FUNCTION_DRAW_STRING, 5, 5);
+BD_FUNCTION_ARGS(FUNCTION_DEBUG_STRING, 0, 0);
+BD_FUNCTION_ARGS(FUNCTION_WRITE_STRING, 0, 0);
+BD_FUNCTION_ARGS(FUNCTION_REGISTER_STRING, 1, 1);
+BD_FUNCTION_ARGS(FUNCTION_DRAW_CHART, 4, 4);
+BD_FUNCTION_ARGS(FUNCTION_DRAW_CHART_WITHOUT_DIRECT_RENDERING, 4, 4);
+BD_FUNCTION_ARGS(FUNCTION_BAUD_TEST_PATTERN, 0, 0);
+BD_FUNCTION_ARGS(FUNCTION_BUTTON_SET_CAPTION, 1, 1);
+BD_FUNCTION_ARGS(FUNCTION_BUTTON_SET_CAPTION_AND_DRAW_BUTTON, 1, 1);
+BD_FUNCTION_ARGS(FUNCTION_SLIDER_SET_CAPTION, 1, 1);
+BD_FUNCTION_ARGS(FUNCTION_SLIDER_PRINT_VALUE, 1, 1);
+BD_FUNCTION_ARGS(FUNCTION_NOP, 0, 0);
+
+// true if all parameter types can be converted to uint16_t without loss, i.e. integers or enums of at most 16 bit.
+// Wider values like int expressions or 32 bit values must be cast explicitly at the call site.
+template<typename ... Args> struct BDAreShortArgs {
+    static const bool Value = true;
+};
+template<typename First, typename ... Rest> struct BDAreShortArgs<First, Rest...> {
+    static const bool Value = (std::is_integral<First>::value || std::is_enum<First>::value)
+            && sizeof(First) <= sizeof(uint16_t) && BDAreShortArgs<Rest...>::Value;
+};
+
+template<int aFunctionTag, typename ... Args>
+inline void checkBDFunctionArgs(void) {
+    static_assert(sizeof...(Args) >= BDFunctionArgs<aFunctionTag>::Min && sizeof...(Args) <= BDFunctionArgs<aFunctionTag>::Max,
+            "wrong number of parameters for function tag");
+    static_assert(BDAreShortArgs<Args...>::Value, "parameters must be integers of at most 16 bit, cast wider values explicitly");
+}
+
+/**
+ * send:
+ * 1. Sync Byte A5
+ * 2. Byte Function token
+ * 3. Short length of parameters
+ * 4. Short n parameters
+ */
+template<int aFunctionTag, typename ... Args>
+inline void sendUSARTCommand(Args ... aArgs) {
+    checkBDFunctionArgs<aFunctionTag, Args...>();
+    static_assert(aFunctionTag <= INDEX_LAST_FUNCTION_WITHOUT_DATA, "function tag requires data, use sendUSARTCommandAndByteBuffer()");
+    uint16_t tParamBuffer[sizeof...(Args) + 2] = { aFunctionTag << 8 | SYNC_TOKEN, sizeof...(Args) * 2,
+            static_cast<uint16_t>(aArgs)... };
+    sendUSARTBufferNoSizeCheck((uint8_t*) &tParamBuffer[0], sizeof(tParamBuffer), NULL, 0);
+}
+
+/**
+ * Like sendUSARTCommand() and appends the header for the data field and the data.
+ * The data is given before the parameters, since it cannot follow the parameter pack.
+ */
+template<int aFunctionTag, typename ... Args>
+inline void sendUSARTCommandAndByteBuffer(const void * aDataBufferPointer, size_t aDataBufferLength, Args ... aArgs) {
+    checkBDFunctionArgs<aFunctionTag, Args...>();
+    static_assert(aFunctionTag > INDEX_LAST_FUNCTION_WITHOUT_DATA, "function tag has no data, use sendUSARTCommand()");
+    uint16_t tParamBuffer[sizeof...(Args) + 4] = { aFunctionTag << 8 | SYNC_TOKEN, sizeof...(Args) * 2,
+            static_cast<uint16_t>(aArgs)..., DATAFIELD_TAG_BYTE << 8 | SYNC_TOKEN, static_cast<uint16_t>(aDataBufferLength) };
+    sendUSARTBuffer((uint8_t*) &tParamBuffer[0], sizeof(tParamBuffer), (uint8_t*) aDataBufferPointer, aDataBufferLength);
+}
+#endif // __cplusplus
 
 #endif /* BLUESERIAL_H_ */
@@ -0,0 +1,57 @@
+/*
+ * ChartDelta.h
+ *
+ * Delta and run length encoding of chart byte buffers against the previously sent chart.
+ * Used for FUNCTION_DRAW_CHART_DELTA which transfers only the changes of a chart.
+ *
+ * The encoded data is a sequence of groups. The upper 2 bits of the first byte of a group is the opcode,
+ * the lower 6 bits are the number of columns - 1 (1 to 64).
+ * CHART_DELTA_OP_SKIP     columns are unchanged. No data bytes.
+ * CHART_DELTA_OP_NIBBLES  signed 4 bit deltas (-8 to 7) to reference. Packed 2 per byte, high nibble first.
+ * CHART_DELTA_OP_LITERAL  one byte with the new value per column follows.
+ * CHART_DELTA_OP_REPEAT   one byte follows, which is the new value for all columns.
+ *
+ * The reference for a chart index is the data of the last FUNCTION_DRAW_CHART* command for this index,
+ * so a plain FUNCTION_DRAW_CHART is the key frame.
+ *
+ *  This file is part of BlueDisplay.
+ *  BlueDisplay is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/gpl.html>.
+ *
+ */
+
+#ifndef CHARTDELTA_H_
+#define CHARTDELTA_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define CHART_DELTA_OP_SKIP     0x00
+#define CHART_DELTA_OP_NIBBLES  0x40
+#define CHART_DELTA_OP_LITERAL  0x80
+#define CHART_DELTA_OP_REPEAT   0xC0
+#define CHART_DELTA_OP_MASK     0xC0
+#define CHART_DELTA_MAX_GROUP_LENGTH 64
+
+// Charts with higher index or longer buffers are always sent plain
+#define CHART_DELTA_NUMBER_OF_CHARTS 2
+#define CHART_DELTA_MAX_LENGTH 320 // DISPLAY_DEFAULT_WIDTH
+// Every n-th chart is sent plain to recover from lost or corrupted frames
+#define CHART_DELTA_KEY_FRAME_INTERVAL 32
+
+size_t encodeChartDelta(const uint8_t * aReference, const uint8_t * aNewData, size_t aLength, uint8_t * aEncodedBuffer,
+        size_t aEncodedBufferSize);
+bool decodeChartDelta(const uint8_t * aEncodedData, size_t aEncodedLength, uint8_t * aReferenceAndResult, size_t aLength);
+
+#endif /* CHARTDELTA_H_ */
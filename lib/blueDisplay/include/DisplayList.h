@@ -0,0 +1,58 @@
+/*
+ * DisplayList.h
+ *
+ * Retained display list of the commands which built the actual page at the remote side.
+ * The commands are stored as sent, i.e. sync token, function tag, parameter length and parameters,
+ * followed by data header and data for functions with data, so the list can be sent by one DMA transfer.
+ *
+ * A page starts with FUNCTION_CLEAR_DISPLAY. A command with data replaces the data of an earlier command
+ * with the same parameters and data length, so periodically redrawn charts and values do not fill the list.
+ * If the page does not fit, the list is incomplete until the next FUNCTION_CLEAR_DISPLAY.
+ * Commands which do not draw like settings, creation of buttons and sliders, requests and debug output are not stored.
+ *
+ *  This file is part of BlueDisplay.
+ *  BlueDisplay is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/gpl.html>.
+ *
+ */
+
+#ifndef DISPLAYLIST_H_
+#define DISPLAYLIST_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define DISPLAY_LIST_SIZE 3072 // holds the DSO settings page or the AccuCapacity chart page
+
+// Return values of appendToDisplayList()
+#define DISPLAY_LIST_APPENDED 0
+#define DISPLAY_LIST_REPLACED 1
+#define DISPLAY_LIST_IGNORED 2 // no drawing command
+#define DISPLAY_LIST_OVERFLOW 3
+
+struct DisplayList {
+    uint8_t Data[DISPLAY_LIST_SIZE];
+    uint16_t Length;
+    uint16_t NumberOfCommands;
+    bool Complete; // false -> no FUNCTION_CLEAR_DISPLAY since start or page did not fit
+};
+
+bool isDisplayListFunction(uint8_t aFunctionTag);
+void clearDisplayList(struct DisplayList * aList);
+void invalidateDisplayList(struct DisplayList * aList);
+uint8_t appendToDisplayList(struct DisplayList * aList, const uint8_t * aParameterBufferPointer, size_t aParameterBufferLength,
+        const uint8_t * aDataBufferPointer, size_t aDataBufferLength);
+size_t getDisplayListCommandLength(const uint8_t * aCommand);
+
+#endif /* DISPLAYLIST_H_ */
@@ -47,6 +47,36 @@
 #define TOUCH_SWIPE_THRESHOLD 10  // threshold for swipe detection to suppress long touch handler calling
 #define TOUCH_SWIPE_RESOLUTION_MILLIS 20
 
+#ifndef DO_NOT_COALESCE_MOVE_EVENTS
+//#define DO_NOT_COALESCE_MOVE_EVENTS // dispatch each touch move and slider callback event as received
+#endif
+/*
+ * Consecutive touch move events of the same pointer and slider callbacks of the same slider are merged to the newest one,
+ * which is dispatched at most once per period. Same period as the sampling of the local touch panel.
+ */
+#define MOVE_EVENT_MIN_PERIOD_MILLIS TOUCH_SWIPE_RESOLUTION_MILLIS
+
+#ifndef DO_NOT_USE_KINETIC_SCROLL
+//#define DO_NOT_USE_KINETIC_SCROLL // saves the scroll state and the scroll callback handling
+#endif
+#if defined(AVR) || defined(DO_NOT_NEED_BASIC_TOUCH_EVENTS)
+#define DO_NOT_USE_KINETIC_SCROLL // velocity is computed from the touch move events
+#endif
+#ifndef DO_NOT_USE_KINETIC_SCROLL
+#include "KineticScroll.h"
+#endif
+
+#ifndef DO_NOT_COALESCE_MOVE_EVENTS
+struct MoveEventStatistics {
+    uint32_t Received; // touch move and slider callback events
+    uint32_t Dispatched;
+    uint32_t Coalesced; // replaced by a newer event before dispatch
+};
+extern struct MoveEventStatistics MoveEventStatistics;
+void resetMoveEventStatistics(void);
+void setMoveEventCoalescingEnabled(bool aMoveEventCoalescingEnabled);
+#endif
+
 #ifdef LOCAL_DISPLAY_EXISTS
 extern struct BluetoothEvent localTouchEvent;
 /*
@@ -76,12 +106,21 @@ extern struct TouchEvent sUpPosition;
 void delayMillisWithCheckAndHandleEvents(unsigned long aTimeMillis);
 
 void checkAndHandleEvents(void);
+void checkAndHandleEventsAndIdle(uint32_t aMaxIdleMillis);
 
 void registerLongTouchDownCallback(void (*aLongTouchCallback)(struct TouchEvent *), uint16_t aLongTouchTimeoutMillis);
 
 void registerSwipeEndCallback(void (*aSwipeEndCallback)(struct Swipe *));
 void setSwipeEndCallbackEnabled(bool aSwipeEndCallbackEnabled);
 
+#ifndef DO_NOT_USE_KINETIC_SCROLL
+/*
+ * Scroll callback is called at most every SCROLL_FRAME_PERIOD_MILLIS while dragging and after touch up until the fling has ended
+ */
+void registerScrollCallback(void (*aScrollCallback)(struct Scroll *));
+void stopScroll(void);
+#endif
+
 void registerConnectCallback(void (*aConnectCallback)(void));
 void registerReorientationCallback(void (*aReorientationCallback)(void));
 
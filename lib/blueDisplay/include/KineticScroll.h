@@ -0,0 +1,95 @@
+/*
+ * KineticScroll.h
+ *
+ * Scrolling by touch drag with inertia.
+ * The velocity at touch up is estimated by a least squares fit of the timestamped positions
+ * of the last VELOCITY_TRACKER_WINDOW_MILLIS. If it is high enough, scrolling continues with this velocity,
+ * which decays exponentially with the time constant KINETIC_SCROLL_TIME_CONSTANT_MILLIS.
+ * The scrolled distance is reported at most once per SCROLL_FRAME_PERIOD_MILLIS, while dragging and while flinging.
+ * Integer arithmetic only, positions have KINETIC_SCROLL_FRACTION_SHIFT fractional bits.
+ *
+ *  This file is part of BlueDisplay.
+ *  BlueDisplay is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/gpl.html>.
+ *
+ */
+
+#ifndef KINETICSCROLL_H_
+#define KINETICSCROLL_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define SCROLL_FRAME_PERIOD_MILLIS 20 // 50 frames per second, same as MOVE_EVENT_MIN_PERIOD_MILLIS
+#define SCROLL_START_THRESHOLD 10 // same as TOUCH_SWIPE_THRESHOLD, a touch which moves less does not scroll
+
+#define VELOCITY_TRACKER_SIZE 8
+#define VELOCITY_TRACKER_WINDOW_MILLIS 100 // older samples are not used for velocity
+
+#define KINETIC_SCROLL_MIN_VELOCITY 150 // pixel per second - a slower touch up stops at once
+#define KINETIC_SCROLL_STOP_VELOCITY 20 // pixel per second - fling ends if velocity has decayed below
+#define KINETIC_SCROLL_MAX_VELOCITY 4000 // pixel per second
+#define KINETIC_SCROLL_TIME_CONSTANT_MILLIS 325 // fling distance is velocity * time constant
+#define KINETIC_SCROLL_FRACTION_SHIFT 8
+
+struct VelocityTracker {
+    uint32_t Millis[VELOCITY_TRACKER_SIZE];
+    int16_t PositionX[VELOCITY_TRACKER_SIZE];
+    int16_t PositionY[VELOCITY_TRACKER_SIZE];
+    uint8_t Index; // of next sample
+    uint8_t NumberOfSamples;
+};
+
+/*
+ * Passed to the scroll callback
+ */
+struct Scroll {
+    int16_t DeltaX; // pixel since last callback, same sign as finger movement
+    int16_t DeltaY;
+    int16_t VelocityX; // pixel per second
+    int16_t VelocityY;
+    uint16_t TouchStartX;
+    uint16_t TouchStartY;
+    bool IsKinetic; // false -> finger is down
+    bool IsLast; // scrolling has ended, delta may be 0
+};
+
+struct KineticScroll {
+    struct VelocityTracker Tracker;
+    int32_t PositionX; // with KINETIC_SCROLL_FRACTION_SHIFT fractional bits, relative to touch start
+    int32_t PositionY;
+    int16_t ReportedX; // pixel reported until last frame, relative to touch start
+    int16_t ReportedY;
+    int32_t VelocityX; // pixel per second
+    int32_t VelocityY;
+    uint16_t TouchStartX;
+    uint16_t TouchStartY;
+    uint32_t LastFrameMillis;
+    uint32_t FlingMillis; // time of last fling step
+    bool IsDragging; // touch is down
+    bool IsScrolling; // touch has moved more than SCROLL_START_THRESHOLD
+    bool IsFlinging;
+    bool EndIsDue; // IsLast must be reported
+};
+
+void addVelocityTrackerSample(struct VelocityTracker * aTracker, uint32_t aMillis, int16_t aPositionX, int16_t aPositionY);
+bool getVelocity(const struct VelocityTracker * aTracker, int32_t * aVelocityXPtr, int32_t * aVelocityYPtr);
+
+void startKineticScrollDrag(struct KineticScroll * aScroll, uint32_t aMillis, uint16_t aPositionX, uint16_t aPositionY);
+void moveKineticScrollDrag(struct KineticScroll * aScroll, uint32_t aMillis, uint16_t aPositionX, uint16_t aPositionY);
+bool endKineticScrollDrag(struct KineticScroll * aScroll, uint32_t aMillis, uint16_t aPositionX, uint16_t aPositionY);
+void stopKineticScroll(struct KineticScroll * aScroll);
+bool isKineticScrollActive(const struct KineticScroll * aScroll);
+bool getKineticScrollFrame(struct KineticScroll * aScroll, uint32_t aMillis, struct Scroll * aScrollInfo);
+
+#endif /* KINETICSCROLL_H_ */
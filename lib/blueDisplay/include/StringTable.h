@@ -0,0 +1,50 @@
+/*
+ * StringTable.h
+ *
+ * Table of strings which are registered at the remote side under a small ID by FUNCTION_REGISTER_STRING,
+ * so that repeated texts and button captions can be drawn by sending only the ID.
+ *
+ * The local table mirrors the table of the remote side. If the table is full, the oldest entry is replaced
+ * and registered again with the same ID. Strings longer than STRING_TABLE_MAX_STRING_LENGTH are always sent inline.
+ * The same functions are used by the host tools to decode the ID based commands like the remote side.
+ *
+ *  This file is part of BlueDisplay.
+ *  BlueDisplay is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/gpl.html>.
+ *
+ */
+
+#ifndef STRINGTABLE_H_
+#define STRINGTABLE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define STRING_TABLE_SIZE 32
+#define STRING_TABLE_MAX_STRING_LENGTH 19 // holds all constant texts and captions of the DSO
+#define STRING_TABLE_NO_ID 0xFF
+
+struct StringTable {
+    uint8_t Lengths[STRING_TABLE_SIZE]; // 0 -> entry is unused
+    char Strings[STRING_TABLE_SIZE][STRING_TABLE_MAX_STRING_LENGTH]; // not null terminated
+    uint8_t NextReplaceIndex;
+};
+
+void clearStringTable(struct StringTable * aTable);
+uint8_t findStringInTable(const struct StringTable * aTable, const char * aString, size_t aLength);
+uint8_t addStringToTable(struct StringTable * aTable, const char * aString, size_t aLength);
+bool setStringTableEntry(struct StringTable * aTable, uint8_t aID, const char * aString, size_t aLength);
+const char * getStringTableEntry(const struct StringTable * aTable, uint8_t aID, size_t * aLengthPtr);
+
+#endif /* STRINGTABLE_H_ */
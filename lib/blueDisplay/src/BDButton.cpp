@@ -90,19 +90,28 @@ void BDButton::init(uint16_t aPositionX, uint16_t aPositionY, uint16_t aWidthX,
 #ifndef AVR
         sendUSARTArgsAndByteBuffer(FUNCTION_BUTTON_CREATE, 11, tButtonNumber, aPositionX, aPositionY, aWidthX,
                 aHeightY, aButtonColor, aCaptionSize, aFlags, aValue, aOnTouchHandler,
-                (reinterpret_cast<uint32_t>(aOnTouchHandler) >> 16), strlen(aCaption), aCaption);
+                (reinterpret_cast<uintptr_t>(aOnTouchHandler) >> 16), strlen(aCaption), aCaption);
 #else
         sendUSARTArgsAndByteBuffer(FUNCTION_BUTTON_CREATE, 10, tButtonNumber, aPositionX, aPositionY, aWidthX, aHeightY,
                 aButtonColor, aCaptionSize, aFlags, aValue, aOnTouchHandler, strlen(aCaption), aCaption);
 #endif
+        BlueDisplay1.cacheButtonState(tButtonNumber, aButtonColor, aValue, aCaption);
     }
     mButtonHandle = tButtonNumber;
 #ifdef LOCAL_DISPLAY_EXISTS
+#ifdef USE_BUTTON_POOL
+    if (aFlags & BUTTON_FLAG_TYPE_AUTOREPEAT) {
+        mLocalButtonPtr = TouchButtonAutorepeat::allocAutorepeatButton();
+    } else {
+        mLocalButtonPtr = TouchButton::allocButton(false);
+    }
+#else
     if (aFlags & BUTTON_FLAG_TYPE_AUTOREPEAT) {
         mLocalButtonPtr = new TouchButtonAutorepeat();
     } else {
         mLocalButtonPtr = new TouchButton();
     }
+#endif
     // Cast needed here. At runtime the right pointer is returned because of FLAG_USE_BDBUTTON_FOR_CALLBACK
     mLocalButtonPtr->initButton(aPositionX, aPositionY, aWidthX, aHeightY, aButtonColor, aCaption, aCaptionSize,
             aFlags | FLAG_USE_BDBUTTON_FOR_CALLBACK, aValue,
@@ -119,8 +128,42 @@ void BDButton::init(uint16_t aPositionX, uint16_t aPositionY, uint16_t aWidthX,
  */
 void BDButton::deinit(void) {
     sLocalButtonIndex--;
+#ifdef USE_BUTTON_POOL
+    mLocalButtonPtr->setFree();
+#else
     delete mLocalButtonPtr;
+#endif
+}
+
+#ifdef USE_BUTTON_POOL
+static BDButtonHandle_t sButtonPageStartIndex[TOUCH_POOL_MAX_PAGE_LEVEL]; // the button stack pointers of the pages
+static uint8_t sButtonPageLevel = 0;
+
+/**
+ * Buttons initialized from now on belong to a new page, which can be deinitialized at once by deinitAllButtonsOfPage()
+ */
+void BDButton::startButtonPage(void) {
+    if (sButtonPageLevel < TOUCH_POOL_MAX_PAGE_LEVEL) {
+        sButtonPageStartIndex[sButtonPageLevel] = sLocalButtonIndex;
+    }
+    sButtonPageLevel++;
+    TouchButton::startButtonPage();
 }
+
+/**
+ * Replaces the deinit() of each button of a page. Frees the local buttons in constant time.
+ */
+void BDButton::deinitAllButtonsOfPage(void) {
+    if (sButtonPageLevel == 0) {
+        return;
+    }
+    sButtonPageLevel--;
+    if (sButtonPageLevel < TOUCH_POOL_MAX_PAGE_LEVEL) {
+        sLocalButtonIndex = sButtonPageStartIndex[sButtonPageLevel];
+    }
+    TouchButton::freeAllButtonsOfPage();
+}
+#endif
 #endif
 
 void BDButton::drawButton(void) {
@@ -128,7 +171,7 @@ void BDButton::drawButton(void) {
     mLocalButtonPtr->drawButton();
 #endif
     if (USART_isBluetoothPaired()) {
-        sendUSARTArgs(FUNCTION_BUTTON_DRAW, 1, mButtonHandle);
+        sendUSARTCommand<FUNCTION_BUTTON_DRAW>(mButtonHandle);
     }
 }
 
@@ -137,7 +180,7 @@ void BDButton::removeButton(Color_t aBackgroundColor) {
     mLocalButtonPtr->removeButton(aBackgroundColor);
 #endif
     if (USART_isBluetoothPaired()) {
-        sendUSARTArgs(FUNCTION_BUTTON_REMOVE, 2, mButtonHandle, aBackgroundColor);
+        sendUSARTCommand<FUNCTION_BUTTON_REMOVE>(mButtonHandle, aBackgroundColor);
     }
 }
 
@@ -146,7 +189,7 @@ void BDButton::drawCaption(void) {
     mLocalButtonPtr->drawCaption();
 #endif
     if (USART_isBluetoothPaired()) {
-        sendUSARTArgs(FUNCTION_BUTTON_DRAW_CAPTION, 1, mButtonHandle);
+        sendUSARTCommand<FUNCTION_BUTTON_DRAW_CAPTION>(mButtonHandle);
     }
 }
 
@@ -154,9 +197,7 @@ void BDButton::setCaption(const char * aCaption) {
 #ifdef LOCAL_DISPLAY_EXISTS
     mLocalButtonPtr->setCaption(aCaption);
 #endif
-    if (USART_isBluetoothPaired()) {
-        sendUSARTArgsAndByteBuffer(FUNCTION_BUTTON_SET_CAPTION, 1, mButtonHandle, strlen(aCaption), aCaption);
-    }
+    BlueDisplay1.setButtonCaption(mButtonHandle, aCaption, false);
 }
 
 void BDButton::setCaptionAndDraw(const char * aCaption) {
@@ -164,9 +205,7 @@ void BDButton::setCaptionAndDraw(const char * aCaption) {
     mLocalButtonPtr->setCaption(aCaption);
     mLocalButtonPtr->drawButton();
 #endif
-    if (USART_isBluetoothPaired()) {
-        sendUSARTArgsAndByteBuffer(FUNCTION_BUTTON_SET_CAPTION_AND_DRAW_BUTTON, 1, mButtonHandle, strlen(aCaption), aCaption);
-    }
+    BlueDisplay1.setButtonCaption(mButtonHandle, aCaption, true);
 }
 
 void BDButton::setCaption(const char * aCaption, bool doDrawButton) {
@@ -176,22 +215,14 @@ void BDButton::setCaption(const char * aCaption, bool doDrawButton) {
         mLocalButtonPtr->drawButton();
     }
 #endif
-    if (USART_isBluetoothPaired()) {
-        uint8_t tFunctionCode = FUNCTION_BUTTON_SET_CAPTION;
-        if (doDrawButton) {
-            tFunctionCode = FUNCTION_BUTTON_SET_CAPTION_AND_DRAW_BUTTON;
-        }
-        sendUSARTArgsAndByteBuffer(tFunctionCode, 1, mButtonHandle, strlen(aCaption), aCaption);
-    }
+    BlueDisplay1.setButtonCaption(mButtonHandle, aCaption, doDrawButton);
 }
 
 void BDButton::setValue(int16_t aValue) {
 #ifdef LOCAL_DISPLAY_EXISTS
     mLocalButtonPtr->setValue(aValue);
 #endif
-    if (USART_isBluetoothPaired()) {
-        sendUSARTArgs(FUNCTION_BUTTON_SETTINGS, 3, mButtonHandle, SUBFUNCTION_BUTTON_SET_VALUE, aValue);
-    }
+    BlueDisplay1.setButtonValue(mButtonHandle, aValue);
 }
 
 void BDButton::setValueAndDraw(int16_t aValue) {
@@ -199,18 +230,14 @@ void BDButton::setValueAndDraw(int16_t aValue) {
     mLocalButtonPtr->setValue(aValue);
     mLocalButtonPtr->drawButton();
 #endif
-    if (USART_isBluetoothPaired()) {
-        sendUSARTArgs(FUNCTION_BUTTON_SETTINGS, 3, mButtonHandle, SUBFUNCTION_BUTTON_SET_VALUE_AND_DRAW, aValue);
-    }
+    BlueDisplay1.setButtonValueAndDraw(mButtonHandle, aValue);
 }
 
 void BDButton::setButtonColor(Color_t aButtonColor) {
 #ifdef LOCAL_DISPLAY_EXISTS
     mLocalButtonPtr->setButtonColor(aButtonColor);
 #endif
-    if (USART_isBluetoothPaired()) {
-        sendUSARTArgs(FUNCTION_BUTTON_SETTINGS, 3, mButtonHandle, SUBFUNCTION_BUTTON_SET_BUTTON_COLOR, aButtonColor);
-    }
+    BlueDisplay1.setButtonColor(mButtonHandle, aButtonColor);
 }
 
 void BDButton::setButtonColorAndDraw(Color_t aButtonColor) {
@@ -218,9 +245,7 @@ void BDButton::setButtonColorAndDraw(Color_t aButtonColor) {
     mLocalButtonPtr->setButtonColor(aButtonColor);
     mLocalButtonPtr->drawButton();
 #endif
-    if (USART_isBluetoothPaired()) {
-        sendUSARTArgs(FUNCTION_BUTTON_SETTINGS, 3, mButtonHandle, SUBFUNCTION_BUTTON_SET_BUTTON_COLOR_AND_DRAW, aButtonColor);
-    }
+    BlueDisplay1.setButtonColorAndDraw(mButtonHandle, aButtonColor);
 }
 
 void BDButton::setPosition(int16_t aPositionX, int16_t aPositionY) {
@@ -228,7 +253,7 @@ void BDButton::setPosition(int16_t aPositionX, int16_t aPositionY) {
     mLocalButtonPtr->setPosition(aPositionX, aPositionY);
 #endif
     if (USART_isBluetoothPaired()) {
-        sendUSARTArgs(FUNCTION_BUTTON_SETTINGS, 4, mButtonHandle, SUBFUNCTION_BUTTON_SET_POSITION, aPositionX, aPositionY);
+        sendUSARTCommand<FUNCTION_BUTTON_SETTINGS>(mButtonHandle, (uint16_t) SUBFUNCTION_BUTTON_SET_POSITION, aPositionX, aPositionY);
     }
 }
 
@@ -243,7 +268,7 @@ void BDButton::setButtonAutorepeatTiming(uint16_t aMillisFirstDelay, uint16_t aM
             aFirstCount, aMillisSecondRate);
 #endif
     if (USART_isBluetoothPaired()) {
-        sendUSARTArgs(FUNCTION_BUTTON_SETTINGS, 7, mButtonHandle, SUBFUNCTION_BUTTON_SET_AUTOREPEAT_TIMING, aMillisFirstDelay,
+        sendUSARTCommand<FUNCTION_BUTTON_SETTINGS>(mButtonHandle, (uint16_t) SUBFUNCTION_BUTTON_SET_AUTOREPEAT_TIMING, aMillisFirstDelay,
                 aMillisFirstRate, aFirstCount, aMillisSecondRate);
     }
 }
@@ -253,7 +278,7 @@ void BDButton::activate(void) {
     mLocalButtonPtr->activate();
 #endif
     if (USART_isBluetoothPaired()) {
-        sendUSARTArgs(FUNCTION_BUTTON_SETTINGS, 2, mButtonHandle, SUBFUNCTION_BUTTON_SET_ACTIVE);
+        sendUSARTCommand<FUNCTION_BUTTON_SETTINGS>(mButtonHandle, (uint16_t) SUBFUNCTION_BUTTON_SET_ACTIVE);
     }
 }
 
@@ -262,7 +287,7 @@ void BDButton::deactivate(void) {
     mLocalButtonPtr->deactivate();
 #endif
     if (USART_isBluetoothPaired()) {
-        sendUSARTArgs(FUNCTION_BUTTON_SETTINGS, 2, mButtonHandle, SUBFUNCTION_BUTTON_RESET_ACTIVE);
+        sendUSARTCommand<FUNCTION_BUTTON_SETTINGS>(mButtonHandle, (uint16_t) SUBFUNCTION_BUTTON_RESET_ACTIVE);
     }
 }
 
@@ -275,7 +300,7 @@ void BDButton::resetAllButtons(void) {
 
 void BDButton::setGlobalFlags(uint16_t aFlags) {
     if (USART_isBluetoothPaired()) {
-        sendUSARTArgs(FUNCTION_BUTTON_GLOBAL_SETTINGS, 1, aFlags);
+        sendUSARTCommand<FUNCTION_BUTTON_GLOBAL_SETTINGS>(aFlags);
     }
 }
 
@@ -284,19 +309,19 @@ void BDButton::setGlobalFlags(uint16_t aFlags) {
  */
 void BDButton::setButtonsTouchTone(uint8_t aToneIndex, uint16_t aToneDuration) {
     if (USART_isBluetoothPaired()) {
-        sendUSARTArgs(FUNCTION_BUTTON_GLOBAL_SETTINGS, 3, BUTTONS_SET_BEEP_TONE, aToneIndex, aToneDuration);
+        sendUSARTCommand<FUNCTION_BUTTON_GLOBAL_SETTINGS>((uint16_t) BUTTONS_SET_BEEP_TONE, aToneIndex, aToneDuration);
     }
 }
 
 void BDButton::setButtonsTouchTone(uint8_t aToneIndex, uint16_t aToneDuration, uint8_t aToneVolume) {
     if (USART_isBluetoothPaired()) {
-        sendUSARTArgs(FUNCTION_BUTTON_GLOBAL_SETTINGS, 4, BUTTONS_SET_BEEP_TONE, aToneIndex, aToneDuration, aToneVolume);
+        sendUSARTCommand<FUNCTION_BUTTON_GLOBAL_SETTINGS>((uint16_t) BUTTONS_SET_BEEP_TONE, aToneIndex, aToneDuration, aToneVolume);
     }
 }
 
 void BDButton::activateAllButtons(void) {
     if (USART_isBluetoothPaired()) {
-        sendUSARTArgs(FUNCTION_BUTTON_ACTIVATE_ALL, 0);
+        sendUSARTCommand<FUNCTION_BUTTON_ACTIVATE_ALL>();
     }
 }
 
@@ -305,7 +330,7 @@ void BDButton::deactivateAllButtons(void) {
     TouchButton::deactivateAllButtons();
 #endif
     if (USART_isBluetoothPaired()) {
-        sendUSARTArgs(FUNCTION_BUTTON_DEACTIVATE_ALL, 0);
+        sendUSARTCommand<FUNCTION_BUTTON_DEACTIVATE_ALL>();
     }
 }
 
@@ -343,7 +368,7 @@ void BDButton::setCaptionPGM(const char * aPGMCaption) {
         if (tCaptionLength < STRING_BUFFER_STACK_SIZE) {
             char StringBuffer[STRING_BUFFER_STACK_SIZE];
             strcpy_P(StringBuffer, aPGMCaption);
-            sendUSARTArgsAndByteBuffer(FUNCTION_BUTTON_SET_CAPTION, 1, mButtonHandle, tCaptionLength, StringBuffer);
+            sendUSARTCommandAndByteBuffer<FUNCTION_BUTTON_SET_CAPTION>(StringBuffer, tCaptionLength, mButtonHandle);
         }
     }
 }
@@ -29,6 +29,7 @@
 #include "BDSlider.h"
 #include "BlueDisplayProtocol.h"
 #include "BlueSerial.h"
+#include "BlueDisplay.h" // for BlueDisplay1
 
 #include <string.h>  // for strlen
 #include <stdlib.h> // for malloc/free
@@ -67,16 +68,21 @@ void BDSlider::init(uint16_t aPositionX, uint16_t aPositionY, uint16_t aBarWidth
 #ifndef AVR
         sendUSARTArgs(FUNCTION_SLIDER_CREATE, 12, tSliderNumber, aPositionX, aPositionY, aBarWidth, aBarLength,
                 aThresholdValue, aInitalValue, aSliderColor, aBarColor, aFlags, aOnChangeHandler,
-                (reinterpret_cast<uint32_t>(aOnChangeHandler) >> 16));
+                (reinterpret_cast<uintptr_t>(aOnChangeHandler) >> 16));
 #else
         sendUSARTArgs(FUNCTION_SLIDER_CREATE, 11, tSliderNumber, aPositionX, aPositionY, aBarWidth, aBarLength, aThresholdValue,
                 aInitalValue, aSliderColor, aBarColor, aFlags, aOnChangeHandler);
 #endif
+        BlueDisplay1.resetSliderStateCache(tSliderNumber);
     }
     mSliderHandle = tSliderNumber;
 
 #ifdef LOCAL_DISPLAY_EXISTS
+#ifdef USE_SLIDER_POOL
+    mLocalSliderPointer = TouchSlider::allocSlider();
+#else
     mLocalSliderPointer = new TouchSlider();
+#endif
     // Cast needed here. At runtime the right pointer is returned because of FLAG_USE_INDEX_FOR_CALLBACK
     mLocalSliderPointer->initSlider(aPositionX, aPositionY, aBarWidth, aBarLength, aThresholdValue, aInitalValue,
             aSliderColor, aBarColor, aFlags | FLAG_USE_BDSLIDER_FOR_CALLBACK,
@@ -89,8 +95,42 @@ void BDSlider::init(uint16_t aPositionX, uint16_t aPositionY, uint16_t aBarWidth
 #ifdef LOCAL_DISPLAY_EXISTS
 void BDSlider::deinit(void) {
     sLocalSliderIndex--;
+#ifdef USE_SLIDER_POOL
+    mLocalSliderPointer->setFree();
+#else
     delete mLocalSliderPointer;
+#endif
+}
+
+#ifdef USE_SLIDER_POOL
+static BDSliderHandle_t sSliderPageStartIndex[TOUCH_POOL_MAX_PAGE_LEVEL]; // the slider stack pointers of the pages
+static uint8_t sSliderPageLevel = 0;
+
+/**
+ * Sliders initialized from now on belong to a new page, which can be deinitialized at once by deinitAllSlidersOfPage()
+ */
+void BDSlider::startSliderPage(void) {
+    if (sSliderPageLevel < TOUCH_POOL_MAX_PAGE_LEVEL) {
+        sSliderPageStartIndex[sSliderPageLevel] = sLocalSliderIndex;
+    }
+    sSliderPageLevel++;
+    TouchSlider::startSliderPage();
 }
+
+/**
+ * Replaces the deinit() of each slider of a page. Frees the local sliders in constant time.
+ */
+void BDSlider::deinitAllSlidersOfPage(void) {
+    if (sSliderPageLevel == 0) {
+        return;
+    }
+    sSliderPageLevel--;
+    if (sSliderPageLevel < TOUCH_POOL_MAX_PAGE_LEVEL) {
+        sLocalSliderIndex = sSliderPageStartIndex[sSliderPageLevel];
+    }
+    TouchSlider::freeAllSlidersOfPage();
+}
+#endif
 #endif
 
 void BDSlider::drawSlider(void) {
@@ -98,7 +138,7 @@ void BDSlider::drawSlider(void) {
     mLocalSliderPointer->drawSlider();
 #endif
     if (USART_isBluetoothPaired()) {
-        sendUSARTArgs(FUNCTION_SLIDER_DRAW, 1, mSliderHandle);
+        sendUSARTCommand<FUNCTION_SLIDER_DRAW>(mSliderHandle);
     }
 }
 
@@ -107,7 +147,7 @@ void BDSlider::drawBorder(void) {
     mLocalSliderPointer->drawBorder();
 #endif
     if (USART_isBluetoothPaired()) {
-        sendUSARTArgs(FUNCTION_SLIDER_DRAW_BORDER, 1, mSliderHandle);
+        sendUSARTCommand<FUNCTION_SLIDER_DRAW_BORDER>(mSliderHandle);
     }
 }
 
@@ -115,9 +155,7 @@ void BDSlider::setActualValueAndDrawBar(int16_t aActualValue) {
 #ifdef LOCAL_DISPLAY_EXISTS
     mLocalSliderPointer->setActualValueAndDrawBar(aActualValue);
 #endif
-    if (USART_isBluetoothPaired()) {
-        sendUSARTArgs(FUNCTION_SLIDER_SETTINGS, 3, mSliderHandle, SUBFUNCTION_SLIDER_SET_VALUE_AND_DRAW_BAR, aActualValue);
-    }
+    BlueDisplay1.setSliderActualValueAndDrawBar(mSliderHandle, aActualValue);
 }
 
 void BDSlider::setBarThresholdColor(Color_t aBarThresholdColor) {
@@ -125,7 +163,7 @@ void BDSlider::setBarThresholdColor(Color_t aBarThresholdColor) {
     mLocalSliderPointer->setBarThresholdColor(aBarThresholdColor);
 #endif
     if (USART_isBluetoothPaired()) {
-        sendUSARTArgs(FUNCTION_SLIDER_SETTINGS, 3, mSliderHandle, SUBFUNCTION_SLIDER_SET_COLOR_THRESHOLD, aBarThresholdColor);
+        sendUSARTCommand<FUNCTION_SLIDER_SETTINGS>(mSliderHandle, (uint16_t) SUBFUNCTION_SLIDER_SET_COLOR_THRESHOLD, aBarThresholdColor);
     }
 }
 
@@ -134,7 +172,8 @@ void BDSlider::setBarBackgroundColor(Color_t aBarBackgroundColor) {
     mLocalSliderPointer->setBarBackgroundColor(aBarBackgroundColor);
 #endif
     if (USART_isBluetoothPaired()) {
-        sendUSARTArgs(FUNCTION_SLIDER_SETTINGS, 3, mSliderHandle, SUBFUNCTION_SLIDER_SET_COLOR_BAR_BACKGROUND, aBarBackgroundColor);
+        sendUSARTCommand<FUNCTION_SLIDER_SETTINGS>(mSliderHandle, (uint16_t) SUBFUNCTION_SLIDER_SET_COLOR_BAR_BACKGROUND,
+                aBarBackgroundColor);
     }
 }
 
@@ -144,7 +183,7 @@ void BDSlider::setCaptionProperties(uint8_t aCaptionSize, uint8_t aCaptionPositi
     mLocalSliderPointer->setCaptionColors(aCaptionColor, aCaptionBackgroundColor);
 #endif
     if (USART_isBluetoothPaired()) {
-        sendUSARTArgs(FUNCTION_SLIDER_SETTINGS, 7, mSliderHandle, SUBFUNCTION_SLIDER_SET_CAPTION_PROPERTIES, aCaptionSize,
+        sendUSARTCommand<FUNCTION_SLIDER_SETTINGS>(mSliderHandle, (uint16_t) SUBFUNCTION_SLIDER_SET_CAPTION_PROPERTIES, aCaptionSize,
                 aCaptionPosition, aCaptionMargin, aCaptionColor, aCaptionBackgroundColor);
     }
 }
@@ -154,7 +193,7 @@ void BDSlider::setCaption(const char * aCaption) {
     mLocalSliderPointer->setCaption(aCaption);
 #endif
     if (USART_isBluetoothPaired()) {
-        sendUSARTArgsAndByteBuffer(FUNCTION_SLIDER_SET_CAPTION, 1, mSliderHandle, strlen(aCaption), aCaption);
+        sendUSARTCommandAndByteBuffer<FUNCTION_SLIDER_SET_CAPTION>(aCaption, strlen(aCaption), mSliderHandle);
     }
 }
 
@@ -164,8 +203,8 @@ void BDSlider::setPrintValueProperties(uint8_t aPrintValueTextSize, uint8_t aPri
     mLocalSliderPointer->setValueStringColors(aPrintValueColor, aPrintValueBackgroundColor);
 #endif
     if (USART_isBluetoothPaired()) {
-        sendUSARTArgs(FUNCTION_SLIDER_SETTINGS, 7, mSliderHandle, SUBFUNCTION_SLIDER_SET_VALUE_STRING_PROPERTIES, aPrintValueTextSize,
-                aPrintValuePosition, aPrintValueMargin, aPrintValueColor, aPrintValueBackgroundColor);
+        sendUSARTCommand<FUNCTION_SLIDER_SETTINGS>(mSliderHandle, (uint16_t) SUBFUNCTION_SLIDER_SET_VALUE_STRING_PROPERTIES,
+                aPrintValueTextSize, aPrintValuePosition, aPrintValueMargin, aPrintValueColor, aPrintValueBackgroundColor);
     }
 }
 
@@ -177,8 +216,8 @@ void BDSlider::setPrintValueProperties(uint8_t aPrintValueTextSize, uint8_t aPri
 void BDSlider::setValueScaleFactor(float aScaleFactorValue) {
     if (USART_isBluetoothPaired()) {
         long tScaleFactorValue = *reinterpret_cast<uint32_t*>(&aScaleFactorValue);
-        sendUSARTArgs(FUNCTION_SLIDER_SETTINGS, 4, mSliderHandle, SUBFUNCTION_SLIDER_SET_VALUE_SCALE_FACTOR,
-                (uint16_t) tScaleFactorValue & 0XFFFF, (uint16_t) (tScaleFactorValue >> 16));
+        sendUSARTCommand<FUNCTION_SLIDER_SETTINGS>(mSliderHandle, (uint16_t) SUBFUNCTION_SLIDER_SET_VALUE_SCALE_FACTOR,
+                (uint16_t) (tScaleFactorValue & 0XFFFF), (uint16_t) (tScaleFactorValue >> 16));
     }
 }
 #pragma GCC diagnostic pop
@@ -188,7 +227,7 @@ void BDSlider::printValue(const char * aValueString) {
     mLocalSliderPointer->printValue(aValueString);
 #endif
     if (USART_isBluetoothPaired()) {
-        sendUSARTArgsAndByteBuffer(FUNCTION_SLIDER_PRINT_VALUE, 1, mSliderHandle, strlen(aValueString), aValueString);
+        sendUSARTCommandAndByteBuffer<FUNCTION_SLIDER_PRINT_VALUE>(aValueString, strlen(aValueString), mSliderHandle);
     }
 }
 
@@ -197,7 +236,7 @@ void BDSlider::activate(void) {
     mLocalSliderPointer->activate();
 #endif
     if (USART_isBluetoothPaired()) {
-        sendUSARTArgs(FUNCTION_SLIDER_SETTINGS, 2, mSliderHandle, SUBFUNCTION_SLIDER_SET_ACTIVE);
+        sendUSARTCommand<FUNCTION_SLIDER_SETTINGS>(mSliderHandle, (uint16_t) SUBFUNCTION_SLIDER_SET_ACTIVE);
     }
 }
 
@@ -206,7 +245,7 @@ void BDSlider::deactivate(void) {
     mLocalSliderPointer->deactivate();
 #endif
     if (USART_isBluetoothPaired()) {
-        sendUSARTArgs(FUNCTION_SLIDER_SETTINGS, 2, mSliderHandle, SUBFUNCTION_SLIDER_RESET_ACTIVE);
+        sendUSARTCommand<FUNCTION_SLIDER_SETTINGS>(mSliderHandle, (uint16_t) SUBFUNCTION_SLIDER_RESET_ACTIVE);
     }
 }
 
@@ -245,7 +284,7 @@ void BDSlider::activateAllSliders(void) {
     TouchSlider::activateAllSliders();
 #endif
     if (USART_isBluetoothPaired()) {
-        sendUSARTArgs(FUNCTION_SLIDER_ACTIVATE_ALL, 0);
+        sendUSARTCommand<FUNCTION_SLIDER_ACTIVATE_ALL>();
     }
 }
 
@@ -254,7 +293,7 @@ void BDSlider::deactivateAllSliders(void) {
     TouchSlider::deactivateAllSliders();
 #endif
     if (USART_isBluetoothPaired()) {
-        sendUSARTArgs(FUNCTION_SLIDER_DEACTIVATE_ALL, 0);
+        sendUSARTCommand<FUNCTION_SLIDER_DEACTIVATE_ALL>();
     }
 }
 
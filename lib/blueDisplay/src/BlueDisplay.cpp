@@ -29,6 +29,8 @@
  */
 
 #include "BlueDisplay.h"
+#include "ChartDelta.h"
+#include "StringTable.h"
 
 #ifdef LOCAL_DISPLAY_EXISTS
 #include "thickLine.h"
@@ -48,6 +50,9 @@ BlueDisplay::BlueDisplay(void) {
     mReferenceDisplaySize.XWidth = DISPLAY_DEFAULT_WIDTH;
     mReferenceDisplaySize.YHeight = DISPLAY_DEFAULT_HEIGHT;
     mConnectionEstablished = false;
+    mChartDeltaEncodingEnabled = false;
+    mStringRegistrationEnabled = false;
+    mGUIStateCachingEnabled = true;
 }
 
 // One instance of BlueDisplay called BlueDisplay1
@@ -55,6 +60,130 @@ BlueDisplay BlueDisplay1;
 
 bool isLocalDisplayAvailable = false;
 
+/*
+ * Last sent chart data for delta encoding
+ */
+struct ChartDeltaReference {
+    uint8_t Data[CHART_DELTA_MAX_LENGTH];
+    uint16_t Length; // 0 -> next chart is sent plain
+    uint8_t FramesSinceKeyFrame;
+};
+static struct ChartDeltaReference sChartDeltaReferences[CHART_DELTA_NUMBER_OF_CHARTS];
+static uint8_t sChartDeltaEncodeBuffer[CHART_DELTA_MAX_LENGTH];
+
+/*
+ * Mirror of the strings registered at the remote side
+ */
+static struct StringTable sRegisteredStrings;
+
+#ifndef DO_NOT_CACHE_GUI_STATE
+/*
+ * Last state sent to the remote buttons and sliders
+ */
+#define BUTTON_STATE_VALUE_VALID 0x01
+#define BUTTON_STATE_COLOR_VALID 0x02
+#define BUTTON_STATE_CAPTION_VALID 0x04
+struct ButtonState {
+    Color_t ButtonColor;
+    int16_t Value;
+    uint8_t ValidFlags;
+    uint8_t CaptionLength;
+    char Caption[GUI_STATE_CACHE_CAPTION_LENGTH];
+};
+static struct ButtonState sButtonStates[GUI_STATE_CACHE_NUMBER_OF_BUTTONS];
+
+struct SliderState {
+    int16_t ActualValue;
+    bool ValueValid; // false after clearDisplay(), since setting the value also draws the bar
+};
+static struct SliderState sSliderStates[GUI_STATE_CACHE_NUMBER_OF_SLIDERS];
+
+/**
+ * @return NULL if state of button is not cached or command may not be sent since a replaceable stream is assembled
+ */
+static struct ButtonState * getButtonStateForUpdate(BDButtonHandle_t aButtonNumber, uint8_t aValidFlag) {
+    if (!BlueDisplay1.mGUIStateCachingEnabled || aButtonNumber >= GUI_STATE_CACHE_NUMBER_OF_BUTTONS) {
+        return NULL;
+    }
+    struct ButtonState * tState = &sButtonStates[aButtonNumber];
+    if (isSendStreamActive()) {
+        tState->ValidFlags &= ~aValidFlag;
+        return NULL;
+    }
+    return tState;
+}
+
+/**
+ * Store value which is sent next
+ * @return true if value was already sent, i.e. command can be skipped
+ */
+static bool checkAndCacheButtonValue(BDButtonHandle_t aButtonNumber, int16_t aValue) {
+    struct ButtonState * tState = getButtonStateForUpdate(aButtonNumber, BUTTON_STATE_VALUE_VALID);
+    if (tState == NULL) {
+        return false;
+    }
+    if ((tState->ValidFlags & BUTTON_STATE_VALUE_VALID) && tState->Value == aValue) {
+        return true;
+    }
+    tState->Value = aValue;
+    tState->ValidFlags |= BUTTON_STATE_VALUE_VALID;
+    return false;
+}
+
+static bool checkAndCacheButtonColor(BDButtonHandle_t aButtonNumber, Color_t aButtonColor) {
+    struct ButtonState * tState = getButtonStateForUpdate(aButtonNumber, BUTTON_STATE_COLOR_VALID);
+    if (tState == NULL) {
+        return false;
+    }
+    if ((tState->ValidFlags & BUTTON_STATE_COLOR_VALID) && tState->ButtonColor == aButtonColor) {
+        return true;
+    }
+    tState->ButtonColor = aButtonColor;
+    tState->ValidFlags |= BUTTON_STATE_COLOR_VALID;
+    return false;
+}
+
+/*
+ * Caption content is compared, since captions are often built in the same RAM buffer
+ */
+static bool checkAndCacheButtonCaption(BDButtonHandle_t aButtonNumber, const char * aCaption) {
+    struct ButtonState * tState = getButtonStateForUpdate(aButtonNumber, BUTTON_STATE_CAPTION_VALID);
+    if (tState == NULL) {
+        return false;
+    }
+    size_t tLength = strlen(aCaption);
+    if (tLength > GUI_STATE_CACHE_CAPTION_LENGTH) {
+        tState->ValidFlags &= ~BUTTON_STATE_CAPTION_VALID;
+        return false;
+    }
+    if ((tState->ValidFlags & BUTTON_STATE_CAPTION_VALID) && tState->CaptionLength == tLength
+            && memcmp(tState->Caption, aCaption, tLength) == 0) {
+        return true;
+    }
+    memcpy(tState->Caption, aCaption, tLength);
+    tState->CaptionLength = tLength;
+    tState->ValidFlags |= BUTTON_STATE_CAPTION_VALID;
+    return false;
+}
+
+static bool checkAndCacheSliderValue(BDSliderHandle_t aSliderNumber, int16_t aActualValue) {
+    if (!BlueDisplay1.mGUIStateCachingEnabled || aSliderNumber >= GUI_STATE_CACHE_NUMBER_OF_SLIDERS) {
+        return false;
+    }
+    struct SliderState * tState = &sSliderStates[aSliderNumber];
+    if (isSendStreamActive()) {
+        tState->ValueValid = false;
+        return false;
+    }
+    if (tState->ValueValid && tState->ActualValue == aActualValue) {
+        return true;
+    }
+    tState->ActualValue = aActualValue;
+    tState->ValueValid = true;
+    return false;
+}
+#endif
+
 void BlueDisplay::resetLocal(void) {
     // reset local buttons to be synchronized
     BDButton::resetAllButtons();
@@ -136,7 +265,7 @@ void BlueDisplay::sendSync(void) {
     if (USART_isBluetoothPaired()) {
         char StringBuffer[STRING_BUFFER_STACK_SIZE];
         memset(StringBuffer, 0, STRING_BUFFER_STACK_SIZE);
-        sendUSARTArgsAndByteBuffer(FUNCTION_NOP, 0, STRING_BUFFER_STACK_SIZE, StringBuffer);
+        sendUSARTCommandAndByteBuffer<FUNCTION_NOP>(StringBuffer, STRING_BUFFER_STACK_SIZE);
     }
 }
 
@@ -149,7 +278,7 @@ void BlueDisplay::setFlagsAndSize(uint16_t aFlags, uint16_t aWidth, uint16_t aHe
             BDButton::resetAllButtons();
             BDSlider::resetAllSliders();
         }
-        sendUSARTArgs(FUNCTION_GLOBAL_SETTINGS, 4, SUBFUNCTION_GLOBAL_SET_FLAGS_AND_SIZE, aFlags, aWidth, aHeight);
+        sendUSARTCommand<FUNCTION_GLOBAL_SETTINGS>((uint16_t) SUBFUNCTION_GLOBAL_SET_FLAGS_AND_SIZE, aFlags, aWidth, aHeight);
     }
 }
 
@@ -159,19 +288,19 @@ void BlueDisplay::setFlagsAndSize(uint16_t aFlags, uint16_t aWidth, uint16_t aHe
  */
 void BlueDisplay::setCodePage(uint16_t aCodePageNumber) {
     if (USART_isBluetoothPaired()) {
-        sendUSARTArgs(FUNCTION_GLOBAL_SETTINGS, 2, SUBFUNCTION_GLOBAL_SET_CODEPAGE, aCodePageNumber);
+        sendUSARTCommand<FUNCTION_GLOBAL_SETTINGS>((uint16_t) SUBFUNCTION_GLOBAL_SET_CODEPAGE, aCodePageNumber);
     }
 }
 
 void BlueDisplay::setCharacterMapping(uint8_t aChar, uint16_t aUnicodeChar) {
     if (USART_isBluetoothPaired()) {
-        sendUSARTArgs(FUNCTION_GLOBAL_SETTINGS, 3, SUBFUNCTION_GLOBAL_SET_CHARACTER_CODE_MAPPING, aChar, aUnicodeChar);
+        sendUSARTCommand<FUNCTION_GLOBAL_SETTINGS>((uint16_t) SUBFUNCTION_GLOBAL_SET_CHARACTER_CODE_MAPPING, aChar, aUnicodeChar);
     }
 }
 
 void BlueDisplay::setLongTouchDownTimeout(uint16_t aLongTouchDownTimeoutMillis) {
     if (USART_isBluetoothPaired()) {
-        sendUSARTArgs(FUNCTION_GLOBAL_SETTINGS, 2, SUBFUNCTION_GLOBAL_SET_LONG_TOUCH_DOWN_TIMEOUT, aLongTouchDownTimeoutMillis);
+        sendUSARTCommand<FUNCTION_GLOBAL_SETTINGS>((uint16_t) SUBFUNCTION_GLOBAL_SET_LONG_TOUCH_DOWN_TIMEOUT, aLongTouchDownTimeoutMillis);
     }
 }
 
@@ -181,13 +310,13 @@ void BlueDisplay::setLongTouchDownTimeout(uint16_t aLongTouchDownTimeoutMillis)
  */
 void BlueDisplay::setScreenOrientationLock(uint8_t aLockMode) {
     if (USART_isBluetoothPaired()) {
-        sendUSARTArgs(FUNCTION_GLOBAL_SETTINGS, 2, SUBFUNCTION_GLOBAL_SET_SCREEN_ORIENTATION_LOCKATION_LOCK, aLockMode);
+        sendUSARTCommand<FUNCTION_GLOBAL_SETTINGS>((uint16_t) SUBFUNCTION_GLOBAL_SET_SCREEN_ORIENTATION_LOCKATION_LOCK, aLockMode);
     }
 }
 
 void BlueDisplay::playTone(void) {
     if (USART_isBluetoothPaired()) {
-        sendUSARTArgs(FUNCTION_PLAY_TONE, 1, TONE_DEFAULT);
+        sendUSARTCommand<FUNCTION_PLAY_TONE>((uint16_t) TONE_DEFAULT);
     }
 }
 
@@ -197,7 +326,7 @@ void BlueDisplay::playTone(void) {
  */
 void BlueDisplay::playTone(uint8_t aToneIndex) {
     if (USART_isBluetoothPaired()) {
-        sendUSARTArgs(FUNCTION_PLAY_TONE, 1, aToneIndex);
+        sendUSARTCommand<FUNCTION_PLAY_TONE>(aToneIndex);
     }
 }
 
@@ -207,7 +336,7 @@ void BlueDisplay::playTone(uint8_t aToneIndex) {
  */
 void BlueDisplay::playTone(uint8_t aToneIndex, int16_t aToneDuration) {
     if (USART_isBluetoothPaired()) {
-        sendUSARTArgs(FUNCTION_PLAY_TONE, 2, aToneIndex, aToneDuration);
+        sendUSARTCommand<FUNCTION_PLAY_TONE>(aToneIndex, aToneDuration);
     }
 }
 
@@ -217,7 +346,7 @@ void BlueDisplay::playTone(uint8_t aToneIndex, int16_t aToneDuration) {
  */
 void BlueDisplay::playTone(uint8_t aToneIndex, int16_t aToneDuration, uint8_t aToneVolume) {
     if (USART_isBluetoothPaired()) {
-        sendUSARTArgs(FUNCTION_PLAY_TONE, 3, aToneIndex, aToneDuration, aToneVolume);
+        sendUSARTCommand<FUNCTION_PLAY_TONE>(aToneIndex, aToneDuration, aToneVolume);
     }
 }
 
@@ -234,14 +363,50 @@ void BlueDisplay::clearDisplay(Color_t aColor) {
     LocalDisplay.clearDisplay(aColor);
 #endif
     if (USART_isBluetoothPaired()) {
-        sendUSARTArgs(FUNCTION_CLEAR_DISPLAY, 1, aColor);
+        // waiting stream messages belong to the old page and must not be drawn after clear
+        discardSendStreams();
+        sendUSARTCommand<FUNCTION_CLEAR_DISPLAY>(aColor);
+    }
+#ifndef DO_NOT_CACHE_GUI_STATE
+    // slider bars must be drawn again
+    for (uint8_t i = 0; i < GUI_STATE_CACHE_NUMBER_OF_SLIDERS; ++i) {
+        sSliderStates[i].ValueValid = false;
     }
+#endif
+}
+
+/**
+ * Collect all following commands until endFrame() and send them with few DMA transfers
+ * of at least SEND_FRAME_FLUSH_THRESHOLD bytes. Can be nested.
+ */
+void BlueDisplay::startFrame(void) {
+    startSendFrame();
+}
+
+/**
+ * Send all commands collected since startFrame()
+ */
+void BlueDisplay::endFrame(void) {
+    endSendFrame();
+}
+
+/**
+ * All following commands until endReplaceableStream() are one message of a replaceable stream, e.g. an info text.
+ * If the link is saturated, the message does not block and is superseded by the next message of the stream.
+ * @param aStreamIndex SEND_STREAM_INFO etc.
+ */
+void BlueDisplay::startReplaceableStream(uint8_t aStreamIndex) {
+    startSendStream(aStreamIndex);
+}
+
+void BlueDisplay::endReplaceableStream(void) {
+    endSendStream();
 }
 
 // forces an rendering of the drawn bitmap
 void BlueDisplay::drawDisplayDirect(void) {
     if (USART_isBluetoothPaired()) {
-        sendUSARTArgs(FUNCTION_DRAW_DISPLAY, 0);
+        sendUSARTCommand<FUNCTION_DRAW_DISPLAY>();
     }
 }
 
@@ -250,7 +415,7 @@ void BlueDisplay::drawPixel(uint16_t aXPos, uint16_t aYPos, Color_t aColor) {
     LocalDisplay.drawPixel(aXPos, aYPos, aColor);
 #endif
     if (USART_isBluetoothPaired()) {
-        sendUSARTArgs(FUNCTION_DRAW_PIXEL, 3, aXPos, aYPos, aColor);
+        sendUSARTCommand<FUNCTION_DRAW_PIXEL>(aXPos, aYPos, aColor);
     }
 }
 
@@ -259,7 +424,7 @@ void BlueDisplay::drawLine(uint16_t aXStart, uint16_t aYStart, uint16_t aXEnd, u
     LocalDisplay.drawLine(aXStart, aYStart, aXEnd, aYEnd, aColor);
 #endif
     if (USART_isBluetoothPaired()) {
-        sendUSART5Args(FUNCTION_DRAW_LINE, aXStart, aYStart, aXEnd, aYEnd, aColor);
+        sendUSARTCommand<FUNCTION_DRAW_LINE>(aXStart, aYStart, aXEnd, aYEnd, aColor);
     }
 }
 
@@ -268,7 +433,7 @@ void BlueDisplay::drawLineRel(uint16_t aXStart, uint16_t aYStart, uint16_t aXDel
     LocalDisplay.drawLine(aXStart, aYStart, aXStart + aXDelta, aYStart + aYDelta, aColor);
 #endif
     if (USART_isBluetoothPaired()) {
-        sendUSART5Args(FUNCTION_DRAW_LINE_REL, aXStart, aYStart, aXDelta, aYDelta, aColor);
+        sendUSARTCommand<FUNCTION_DRAW_LINE_REL>(aXStart, aYStart, aXDelta, aYDelta, aColor);
     }
 }
 
@@ -284,7 +449,7 @@ void BlueDisplay::drawLineFastOneX(uint16_t aXStart, uint16_t aYStart, uint16_t
 #endif
     if (USART_isBluetoothPaired()) {
         // Just draw plain line, no need to speed up
-        sendUSART5Args(FUNCTION_DRAW_LINE, aXStart, aYStart, aXStart + 1, aYEnd, aColor);
+        sendUSARTCommand<FUNCTION_DRAW_LINE>(aXStart, aYStart, (uint16_t) (aXStart + 1), aYEnd, aColor);
     }
 }
 
@@ -294,7 +459,7 @@ void BlueDisplay::drawLineWithThickness(uint16_t aXStart, uint16_t aYStart, uint
     drawThickLine(aXStart, aYStart, aXEnd, aYEnd, aThickness, LINE_THICKNESS_MIDDLE, aColor);
 #endif
     if (USART_isBluetoothPaired()) {
-        sendUSARTArgs(FUNCTION_DRAW_LINE, 6, aXStart, aYStart, aXEnd, aYEnd, aColor, aThickness);
+        sendUSARTCommand<FUNCTION_DRAW_LINE>(aXStart, aYStart, aXEnd, aYEnd, aColor, aThickness);
     }
 }
 
@@ -304,7 +469,7 @@ void BlueDisplay::drawRect(uint16_t aXStart, uint16_t aYStart, uint16_t aXEnd, u
     LocalDisplay.drawRect(aXStart, aYStart, aXEnd - 1, aYEnd - 1, aColor);
 #endif
     if (USART_isBluetoothPaired()) {
-        sendUSARTArgs(FUNCTION_DRAW_RECT, 6, aXStart, aYStart, aXEnd, aYEnd, aColor, aStrokeWidth);
+        sendUSARTCommand<FUNCTION_DRAW_RECT>(aXStart, aYStart, aXEnd, aYEnd, aColor, aStrokeWidth);
     }
 }
 
@@ -314,7 +479,7 @@ void BlueDisplay::drawRectRel(uint16_t aXStart, uint16_t aYStart, uint16_t aWidt
     LocalDisplay.drawRect(aXStart, aYStart, aXStart + aWidth - 1, aYStart + aHeight - 1, aColor);
 #endif
     if (USART_isBluetoothPaired()) {
-        sendUSARTArgs(FUNCTION_DRAW_RECT_REL, 6, aXStart, aYStart, aWidth, aHeight, aColor, aStrokeWidth);
+        sendUSARTCommand<FUNCTION_DRAW_RECT_REL>(aXStart, aYStart, aWidth, aHeight, aColor, aStrokeWidth);
     }
 }
 
@@ -323,7 +488,7 @@ void BlueDisplay::fillRect(uint16_t aXStart, uint16_t aYStart, uint16_t aXEnd, u
     LocalDisplay.fillRect(aXStart, aYStart, aXEnd, aYEnd, aColor);
 #endif
     if (USART_isBluetoothPaired()) {
-        sendUSART5Args(FUNCTION_FILL_RECT, aXStart, aYStart, aXEnd, aYEnd, aColor);
+        sendUSARTCommand<FUNCTION_FILL_RECT>(aXStart, aYStart, aXEnd, aYEnd, aColor);
     }
 }
 
@@ -332,7 +497,7 @@ void BlueDisplay::fillRectRel(uint16_t aXStart, uint16_t aYStart, uint16_t aWidt
     LocalDisplay.fillRect(aXStart, aYStart, aXStart + aWidth - 1, aYStart + aHeight - 1, aColor);
 #endif
     if (USART_isBluetoothPaired()) {
-        sendUSART5Args(FUNCTION_FILL_RECT_REL, aXStart, aYStart, aWidth, aHeight, aColor);
+        sendUSARTCommand<FUNCTION_FILL_RECT_REL>(aXStart, aYStart, aWidth, aHeight, aColor);
     }
 }
 
@@ -341,7 +506,7 @@ void BlueDisplay::drawCircle(uint16_t aXCenter, uint16_t aYCenter, uint16_t aRad
     LocalDisplay.drawCircle(aXCenter, aYCenter, aRadius, aColor);
 #endif
     if (USART_isBluetoothPaired()) {
-        sendUSART5Args(FUNCTION_DRAW_CIRCLE, aXCenter, aYCenter, aRadius, aColor, aStrokeWidth);
+        sendUSARTCommand<FUNCTION_DRAW_CIRCLE>(aXCenter, aYCenter, aRadius, aColor, aStrokeWidth);
     }
 }
 
@@ -350,7 +515,7 @@ void BlueDisplay::fillCircle(uint16_t aXCenter, uint16_t aYCenter, uint16_t aRad
     LocalDisplay.fillCircle(aXCenter, aYCenter, aRadius, aColor);
 #endif
     if (USART_isBluetoothPaired()) {
-        sendUSARTArgs(FUNCTION_FILL_CIRCLE, 4, aXCenter, aYCenter, aRadius, aColor);
+        sendUSARTCommand<FUNCTION_FILL_CIRCLE>(aXCenter, aYCenter, aRadius, aColor);
     }
 }
 
@@ -365,7 +530,7 @@ uint16_t BlueDisplay::drawChar(uint16_t aPosX, uint16_t aPosY, char aChar, uint1
 #endif
     if (USART_isBluetoothPaired()) {
         tRetValue = aPosX + getTextWidth(aCharSize);
-        sendUSARTArgs(FUNCTION_DRAW_CHAR, 6, aPosX, aPosY, aCharSize, aFGColor, aBGColor, aChar);
+        sendUSARTCommand<FUNCTION_DRAW_CHAR>(aPosX, aPosY, aCharSize, aFGColor, aBGColor, aChar);
     }
     return tRetValue;
 }
@@ -386,12 +551,86 @@ uint16_t BlueDisplay::drawText(uint16_t aPosX, uint16_t aPosY, const char *aStri
 #endif
     if (USART_isBluetoothPaired()) {
         tRetValue = aPosX + strlen(aStringPtr) * getTextWidth(aTextSize);
-        sendUSART5ArgsAndByteBuffer(FUNCTION_DRAW_STRING, aPosX, aPosY, aTextSize, aFGColor, aBGColor, (uint8_t*) aStringPtr,
-                strlen(aStringPtr));
+        sendUSARTCommandAndByteBuffer<FUNCTION_DRAW_STRING>(aStringPtr, strlen(aStringPtr), aPosX, aPosY, aTextSize, aFGColor,
+                aBGColor);
+    }
+    return tRetValue;
+}
+
+/**
+ * Like drawText(), but the string is registered once at the remote side and then only referenced by its ID.
+ * Use it for texts which are drawn repeatedly, like labels and constant texts of a page.
+ * The content is compared, so the string may be in a buffer. Strings which change often should be drawn by drawText(),
+ * since each new string replaces another one in the table of the remote side.
+ */
+uint16_t BlueDisplay::drawRegisteredText(uint16_t aPosX, uint16_t aPosY, const char *aStringPtr, uint16_t aTextSize,
+        Color_t aFGColor, Color_t aBGColor) {
+    uint8_t tStringID = STRING_TABLE_NO_ID;
+    if (USART_isBluetoothPaired()) {
+        tStringID = getRegisteredStringID(aStringPtr);
+    }
+    if (tStringID == STRING_TABLE_NO_ID) {
+        return drawText(aPosX, aPosY, aStringPtr, aTextSize, aFGColor, aBGColor);
     }
+    uint16_t tRetValue = 0;
+#ifdef LOCAL_DISPLAY_EXISTS
+    tRetValue = LocalDisplay.drawText(aPosX, aPosY - getTextAscend(aTextSize), (char *) aStringPtr, getLocalTextSize(aTextSize),
+            aFGColor, aBGColor);
+#endif
+    tRetValue = aPosX + strlen(aStringPtr) * getTextWidth(aTextSize);
+    sendUSARTCommand<FUNCTION_DRAW_REGISTERED_STRING>(aPosX, aPosY, aTextSize, aFGColor, aBGColor, tStringID);
     return tRetValue;
 }
 
+/**
+ * Registers the string at the remote side if not already done.
+ * @return ID of the string at the remote side or STRING_TABLE_NO_ID if string must be sent inline,
+ * i.e. registration is disabled, string is too long or a replaceable stream is assembled
+ */
+uint8_t BlueDisplay::getRegisteredStringID(const char * aStringPtr) {
+    if (!mStringRegistrationEnabled || isSendStreamActive()) {
+        return STRING_TABLE_NO_ID;
+    }
+    size_t tLength = strlen(aStringPtr);
+    uint8_t tStringID = findStringInTable(&sRegisteredStrings, aStringPtr, tLength);
+    if (tStringID == STRING_TABLE_NO_ID) {
+        tStringID = addStringToTable(&sRegisteredStrings, aStringPtr, tLength);
+        if (tStringID != STRING_TABLE_NO_ID) {
+            sendUSARTCommandAndByteBuffer<FUNCTION_REGISTER_STRING>(aStringPtr, tLength, tStringID);
+        }
+    }
+    return tStringID;
+}
+
+/**
+ * Enables drawRegisteredText() and setButtonCaption() to reference strings by ID.
+ */
+void BlueDisplay::setStringRegistration(bool aEnable) {
+    mStringRegistrationEnabled = aEnable;
+    resetRegisteredStrings();
+}
+
+/**
+ * Strings are registered again on next use. Must be called if remote side may have lost its table e.g. on reconnect.
+ */
+void BlueDisplay::resetRegisteredStrings(void) {
+    clearStringTable(&sRegisteredStrings);
+}
+
+/**
+ * Registers all strings of the local table again with the same ID.
+ * Used on reconnect before replaying a display list, which references the strings by ID.
+ */
+void BlueDisplay::resendRegisteredStrings(void) {
+    for (uint8_t i = 0; i < STRING_TABLE_SIZE; ++i) {
+        size_t tLength;
+        const char * tStringPtr = getStringTableEntry(&sRegisteredStrings, i, &tLength);
+        if (tStringPtr != NULL) {
+            sendUSARTCommandAndByteBuffer<FUNCTION_REGISTER_STRING>(tStringPtr, tLength, i);
+        }
+    }
+}
+
 uint16_t BlueDisplay::drawByte(uint16_t aPosX, uint16_t aPosY, int8_t aByte, uint16_t aTextSize, Color_t aFGColor,
         Color_t aBGColor) {
     uint16_t tRetValue = 0;
@@ -407,7 +646,7 @@ uint16_t BlueDisplay::drawByte(uint16_t aPosX, uint16_t aPosY, int8_t aByte, uin
 #endif
     if (USART_isBluetoothPaired()) {
         tRetValue = aPosX + 4 * getTextWidth(aTextSize);
-        sendUSART5ArgsAndByteBuffer(FUNCTION_DRAW_STRING, aPosX, aPosY, aTextSize, aFGColor, aBGColor, (uint8_t*) tStringBuffer, 4);
+        sendUSARTCommandAndByteBuffer<FUNCTION_DRAW_STRING>(tStringBuffer, 4, aPosX, aPosY, aTextSize, aFGColor, aBGColor);
     }
     return tRetValue;
 }
@@ -426,7 +665,7 @@ uint16_t BlueDisplay::drawUnsignedByte(uint16_t aPosX, uint16_t aPosY, uint8_t a
 #endif
     if (USART_isBluetoothPaired()) {
         tRetValue = aPosX + 3 * getTextWidth(aTextSize);
-        sendUSART5ArgsAndByteBuffer(FUNCTION_DRAW_STRING, aPosX, aPosY, aTextSize, aFGColor, aBGColor, (uint8_t*) tStringBuffer, 3);
+        sendUSARTCommandAndByteBuffer<FUNCTION_DRAW_STRING>(tStringBuffer, 3, aPosX, aPosY, aTextSize, aFGColor, aBGColor);
     }
     return tRetValue;
 }
@@ -446,7 +685,7 @@ uint16_t BlueDisplay::drawShort(uint16_t aPosX, uint16_t aPosY, int16_t aShort,
 #endif
     if (USART_isBluetoothPaired()) {
         tRetValue = aPosX + 6 * getTextWidth(aTextSize);
-        sendUSART5ArgsAndByteBuffer(FUNCTION_DRAW_STRING, aPosX, aPosY, aTextSize, aFGColor, aBGColor, (uint8_t*) tStringBuffer, 6);
+        sendUSARTCommandAndByteBuffer<FUNCTION_DRAW_STRING>(tStringBuffer, 6, aPosX, aPosY, aTextSize, aFGColor, aBGColor);
     }
     return tRetValue;
 }
@@ -466,8 +705,7 @@ uint16_t BlueDisplay::drawLong(uint16_t aPosX, uint16_t aPosY, int32_t aLong, ui
 #endif
     if (USART_isBluetoothPaired()) {
         tRetValue = aPosX + 11 * getTextWidth(aTextSize);
-        sendUSART5ArgsAndByteBuffer(FUNCTION_DRAW_STRING, aPosX, aPosY, aTextSize, aFGColor, aBGColor, (uint8_t*) tStringBuffer,
-                11);
+        sendUSARTCommandAndByteBuffer<FUNCTION_DRAW_STRING>(tStringBuffer, 11, aPosX, aPosY, aTextSize, aFGColor, aBGColor);
     }
     return tRetValue;
 }
@@ -482,7 +720,7 @@ bool aClearOnNewScreen) {
     printSetOptions(getLocalTextSize(aPrintSize), aPrintColor, aPrintBackgroundColor, aClearOnNewScreen);
 #endif
     if (USART_isBluetoothPaired()) {
-        sendUSARTArgs(FUNCTION_WRITE_SETTINGS, 5, FLAG_WRITE_SETTINGS_SET_SIZE_AND_COLORS_AND_FLAGS, aPrintSize, aPrintColor,
+        sendUSARTCommand<FUNCTION_WRITE_SETTINGS>((uint16_t) FLAG_WRITE_SETTINGS_SET_SIZE_AND_COLORS_AND_FLAGS, aPrintSize, aPrintColor,
                 aPrintBackgroundColor, aClearOnNewScreen);
     }
 }
@@ -492,7 +730,7 @@ void BlueDisplay::setPrintfPosition(uint16_t aPosX, uint16_t aPosY) {
     printSetPosition(aPosX, aPosY);
 #endif
     if (USART_isBluetoothPaired()) {
-        sendUSARTArgs(FUNCTION_WRITE_SETTINGS, 3, FLAG_WRITE_SETTINGS_SET_POSITION, aPosX, aPosY);
+        sendUSARTCommand<FUNCTION_WRITE_SETTINGS>((uint16_t) FLAG_WRITE_SETTINGS_SET_POSITION, aPosX, aPosY);
     }
 }
 
@@ -501,7 +739,7 @@ void BlueDisplay::setPrintfPositionColumnLine(uint16_t aColumnNumber, uint16_t a
     printSetPositionColumnLine(aColumnNumber, aLineNumber);
 #endif
     if (USART_isBluetoothPaired()) {
-        sendUSARTArgs(FUNCTION_WRITE_SETTINGS, 3, FLAG_WRITE_SETTINGS_SET_LINE_COLUMN, aColumnNumber, aLineNumber);
+        sendUSARTCommand<FUNCTION_WRITE_SETTINGS>((uint16_t) FLAG_WRITE_SETTINGS_SET_LINE_COLUMN, aColumnNumber, aLineNumber);
     }
 }
 
@@ -510,7 +748,7 @@ void BlueDisplay::writeString(const char *aStringPtr, uint8_t aStringLength) {
     myPrint(aStringPtr, aStringLength);
 #endif
     if (USART_isBluetoothPaired()) {
-        sendUSARTArgsAndByteBuffer(FUNCTION_WRITE_STRING, 0, aStringLength, (uint8_t*) aStringPtr);
+        sendUSARTCommandAndByteBuffer<FUNCTION_WRITE_STRING>(aStringPtr, aStringLength);
     }
 }
 
@@ -520,7 +758,7 @@ extern "C" void writeStringC(const char *aStringPtr, uint8_t aStringLength) {
     myPrint(aStringPtr, aStringLength);
 #endif
     if (USART_isBluetoothPaired()) {
-        sendUSARTArgsAndByteBuffer(FUNCTION_WRITE_STRING, 0, aStringLength, (uint8_t*) aStringPtr);
+        sendUSARTCommandAndByteBuffer<FUNCTION_WRITE_STRING>(aStringPtr, aStringLength);
     }
 }
 #endif
@@ -530,7 +768,7 @@ extern "C" void writeStringC(const char *aStringPtr, uint8_t aStringLength) {
  */
 void BlueDisplay::debugMessage(const char *aStringPtr) {
     if (USART_isBluetoothPaired()) {
-        sendUSARTArgsAndByteBuffer(FUNCTION_DEBUG_STRING, 0, strlen(aStringPtr), (uint8_t*) aStringPtr);
+        sendUSARTCommandAndByteBuffer<FUNCTION_DEBUG_STRING>(aStringPtr, strlen(aStringPtr));
     }
 }
 
@@ -542,7 +780,7 @@ void BlueDisplay::debug(uint8_t aByte) {
     sprintf(tStringBuffer, "%3hhu %#2X", aByte, aByte);
 #endif
     if (USART_isBluetoothPaired()) {
-        sendUSARTArgsAndByteBuffer(FUNCTION_DEBUG_STRING, 0, strlen(tStringBuffer), tStringBuffer);
+        sendUSARTCommandAndByteBuffer<FUNCTION_DEBUG_STRING>(tStringBuffer, strlen(tStringBuffer));
     }
 }
 
@@ -554,7 +792,7 @@ void BlueDisplay::debug(uint16_t aShort) {
     sprintf(tStringBuffer, "%5hu %#X", aShort, aShort);
 #endif
     if (USART_isBluetoothPaired()) {
-        sendUSARTArgsAndByteBuffer(FUNCTION_DEBUG_STRING, 0, strlen(tStringBuffer), tStringBuffer);
+        sendUSARTCommandAndByteBuffer<FUNCTION_DEBUG_STRING>(tStringBuffer, strlen(tStringBuffer));
     }
 }
 
@@ -566,7 +804,7 @@ void BlueDisplay::debug(uint32_t aLong) {
     sprintf(tStringBuffer, "%10lu %#lX", aLong, aLong);
 #endif
     if (USART_isBluetoothPaired()) {
-        sendUSARTArgsAndByteBuffer(FUNCTION_DEBUG_STRING, 0, strlen(tStringBuffer), tStringBuffer);
+        sendUSARTCommandAndByteBuffer<FUNCTION_DEBUG_STRING>(tStringBuffer, strlen(tStringBuffer));
     }
 }
 
@@ -576,8 +814,10 @@ void BlueDisplay::debug(uint32_t aLong) {
 void BlueDisplay::drawChartByteBuffer(uint16_t aXOffset, uint16_t aYOffset, Color_t aColor, Color_t aClearBeforeColor,
         uint8_t *aByteBuffer, size_t aByteBufferLength) {
     if (USART_isBluetoothPaired()) {
-        sendUSARTArgsAndByteBuffer(FUNCTION_DRAW_CHART, 4, aXOffset, aYOffset, aColor, aClearBeforeColor, aByteBufferLength,
-                aByteBuffer);
+        startSendStream(SEND_STREAM_CHART_0);
+        sendUSARTCommandAndByteBuffer<FUNCTION_DRAW_CHART>(aByteBuffer, aByteBufferLength, aXOffset, aYOffset, aColor,
+                aClearBeforeColor);
+        endSendStream();
     }
 }
 
@@ -593,7 +833,60 @@ void BlueDisplay::drawChartByteBuffer(uint16_t aXOffset, uint16_t aYOffset, Colo
         if (aDoDrawDirect) {
             tFunctionTag = FUNCTION_DRAW_CHART;
         }
+        // Chart index 0 and 1 are replaceable streams
+        uint8_t tStreamIndex = SEND_STREAM_NONE;
+        if (aChartIndex <= SEND_STREAM_CHART_1) {
+            tStreamIndex = SEND_STREAM_CHART_0 + aChartIndex;
+        }
+        bool tUseDeltaEncoding = mChartDeltaEncodingEnabled;
+#ifdef USE_DISPLAY_LIST
+        // display list can only be replayed with plain charts
+        tUseDeltaEncoding = tUseDeltaEncoding && !isDisplayListRecording();
+#endif
+        if (tUseDeltaEncoding && aChartIndex < CHART_DELTA_NUMBER_OF_CHARTS && aByteBufferLength <= CHART_DELTA_MAX_LENGTH) {
+            struct ChartDeltaReference * tReference = &sChartDeltaReferences[aChartIndex];
+            // a waiting chart will be superseded, so the remote side never gets our reference
+            if (tReference->Length == aByteBufferLength && tReference->FramesSinceKeyFrame < CHART_DELTA_KEY_FRAME_INTERVAL - 1
+                    && aByteBufferLength > 2 && !isSendStreamPending(tStreamIndex)) {
+                // encoded data must save at least the additional length parameter
+                size_t tEncodedLength = encodeChartDelta(tReference->Data, aByteBuffer, aByteBufferLength,
+                        sChartDeltaEncodeBuffer, aByteBufferLength - 2);
+                if (tEncodedLength > 0) {
+                    tReference->FramesSinceKeyFrame++;
+                    memcpy(tReference->Data, aByteBuffer, aByteBufferLength);
+                    startSendStream(tStreamIndex);
+                    sendUSARTArgsAndByteBuffer(tFunctionTag + (FUNCTION_DRAW_CHART_DELTA - FUNCTION_DRAW_CHART), 5, aXOffset,
+                            aYOffset, aColor, aClearBeforeColor, aByteBufferLength, tEncodedLength, sChartDeltaEncodeBuffer);
+                    endSendStream();
+                    return;
+                }
+            }
+            // send key frame
+            tReference->Length = aByteBufferLength;
+            tReference->FramesSinceKeyFrame = 0;
+            memcpy(tReference->Data, aByteBuffer, aByteBufferLength);
+        }
+        startSendStream(tStreamIndex);
         sendUSARTArgsAndByteBuffer(tFunctionTag, 4, aXOffset, aYOffset, aColor, aClearBeforeColor, aByteBufferLength, aByteBuffer);
+        endSendStream();
+    }
+}
+
+/**
+ * Enables sending of charts with index < CHART_DELTA_NUMBER_OF_CHARTS as FUNCTION_DRAW_CHART_DELTA.
+ * Only the changes against the previous chart with the same index are sent, a plain chart every CHART_DELTA_KEY_FRAME_INTERVAL.
+ */
+void BlueDisplay::setChartDeltaEncoding(bool aEnable) {
+    mChartDeltaEncodingEnabled = aEnable;
+    resetChartDeltaReferences();
+}
+
+/**
+ * Forces next chart to be sent plain. Must be called if remote side may have lost its chart data e.g. on reconnect.
+ */
+void BlueDisplay::resetChartDeltaReferences(void) {
+    for (uint8_t i = 0; i < CHART_DELTA_NUMBER_OF_CHARTS; ++i) {
+        sChartDeltaReferences[i].Length = 0;
     }
 }
 
@@ -641,39 +934,125 @@ bool BlueDisplay::isDisplayOrientationLandscape(void) {
  * Vector for ThickLine
  *****************************************************************************/
 
+/**
+ * Clips new end point of vector to display
+ * Ignore warning since we know that values are positive when compared :-)
+ */
+static void clipVectorEnd(int16_t * aEndX, int16_t * aEndY, struct XYSize * aDisplaySize) {
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wsign-compare"
+    if (*aEndX < 0) {
+        *aEndX = 0;
+    } else if (*aEndX > aDisplaySize->XWidth - 1) {
+        *aEndX = aDisplaySize->XWidth - 1;
+    }
+    if (*aEndY < 0) {
+        *aEndY = 0;
+    } else if (*aEndY > aDisplaySize->YHeight - 1) {
+        *aEndY = aDisplaySize->YHeight - 1;
+    }
+#pragma GCC diagnostic pop
+}
+
+/**
+ * @return true if the intervals [aStart1, aEnd1] and [aStart2, aEnd2] in any order have less than aMargin distance
+ */
+static bool isIntervalOverlapping(int16_t aStart1, int16_t aEnd1, int16_t aStart2, int16_t aEnd2, int16_t aMargin) {
+    if (aStart1 > aEnd1) {
+        int16_t tTemp = aStart1;
+        aStart1 = aEnd1;
+        aEnd1 = tTemp;
+    }
+    if (aStart2 > aEnd2) {
+        int16_t tTemp = aStart2;
+        aStart2 = aEnd2;
+        aEnd2 = tTemp;
+    }
+    return (aStart2 <= aEnd1 + aMargin && aStart1 <= aEnd2 + aMargin);
+}
+
+/**
+ * @return true if the bounding boxes of both lines including thickness overlap
+ */
+static bool isLineOverlapping(struct ThickLine * aLine, int16_t aEndX, int16_t aEndY, struct ThickLine * aOtherLine) {
+    int16_t tMargin = (aLine->Thickness + aOtherLine->Thickness) / 2 + 1;
+    return isIntervalOverlapping(aLine->StartX, aEndX, aOtherLine->StartX, aOtherLine->EndX, tMargin)
+            && isIntervalOverlapping(aLine->StartY, aEndY, aOtherLine->StartY, aOtherLine->EndY, tMargin);
+}
+
 /**
  * aNewRelEndX + Y are new x and y values relative to start point
  */
 void BlueDisplay::refreshVector(struct ThickLine * aLine, int16_t aNewRelEndX, int16_t aNewRelEndY) {
     int16_t tNewEndX = aLine->StartX + aNewRelEndX;
     int16_t tNewEndY = aLine->StartY + aNewRelEndY;
-    if (aLine->EndX != tNewEndX || aLine->EndX != tNewEndY) {
+    clipVectorEnd(&tNewEndX, &tNewEndY, &mReferenceDisplaySize);
+    if (aLine->EndX != tNewEndX || aLine->EndY != tNewEndY) {
         //clear old line
         drawLineWithThickness(aLine->StartX, aLine->StartY, aLine->EndX, aLine->EndY, aLine->Thickness, aLine->BackgroundColor);
         // Draw new line
-        /**
-         * clipping
-         * Ignore warning since we know that values are positive when compared :-)
-         */
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wsign-compare"
-        if (tNewEndX < 0) {
-            tNewEndX = 0;
-        } else if (tNewEndX > mReferenceDisplaySize.XWidth - 1) {
-            tNewEndX = mReferenceDisplaySize.XWidth - 1;
-        }
         aLine->EndX = tNewEndX;
+        aLine->EndY = tNewEndY;
+        drawLineWithThickness(aLine->StartX, aLine->StartY, tNewEndX, tNewEndY, aLine->Thickness, aLine->Color);
+    }
+}
 
-        if (tNewEndY < 0) {
-            tNewEndY = 0;
-        } else if (tNewEndY > mReferenceDisplaySize.YHeight - 1) {
-            tNewEndY = mReferenceDisplaySize.YHeight - 1;
+/**
+ * Refreshes up to REFRESH_VECTORS_MAX_NUMBER vectors with one frame, i.e. one transfer.
+ * Vectors whose end point did not move by a pixel are skipped. First all moved vectors are erased,
+ * then they are drawn together with the unmoved vectors which may be overlapped by an erased or a new one,
+ * so that crossing vectors are not left partially erased and keep their order.
+ * @param aNewRelEnds new x and y values relative to start point for each line
+ */
+void BlueDisplay::refreshVectors(struct ThickLine * const aLines[], const int16_t aNewRelEnds[][2], uint8_t aNumberOfVectors) {
+    if (aNumberOfVectors > REFRESH_VECTORS_MAX_NUMBER) {
+        aNumberOfVectors = REFRESH_VECTORS_MAX_NUMBER;
+    }
+    int16_t tNewEnds[REFRESH_VECTORS_MAX_NUMBER][2];
+    uint8_t tMovedMask = 0;
+    for (uint8_t i = 0; i < aNumberOfVectors; ++i) {
+        tNewEnds[i][0] = aLines[i]->StartX + aNewRelEnds[i][0];
+        tNewEnds[i][1] = aLines[i]->StartY + aNewRelEnds[i][1];
+        clipVectorEnd(&tNewEnds[i][0], &tNewEnds[i][1], &mReferenceDisplaySize);
+        if (aLines[i]->EndX != tNewEnds[i][0] || aLines[i]->EndY != tNewEnds[i][1]) {
+            tMovedMask |= 1 << i;
         }
-#pragma GCC diagnostic pop
-        aLine->EndY = tNewEndY;
+    }
+    if (tMovedMask == 0) {
+        return;
+    }
 
-        drawLineWithThickness(aLine->StartX, aLine->StartY, tNewEndX, tNewEndY, aLine->Thickness, aLine->Color);
+    uint8_t tDrawMask = tMovedMask;
+    for (uint8_t i = 0; i < aNumberOfVectors; ++i) {
+        if (!(tMovedMask & (1 << i))) {
+            for (uint8_t j = 0; j < aNumberOfVectors; ++j) {
+                if ((tMovedMask & (1 << j))
+                        && (isLineOverlapping(aLines[j], aLines[j]->EndX, aLines[j]->EndY, aLines[i])
+                                || isLineOverlapping(aLines[j], tNewEnds[j][0], tNewEnds[j][1], aLines[i]))) {
+                    tDrawMask |= 1 << i;
+                    break;
+                }
+            }
+        }
+    }
+
+    startFrame();
+    for (uint8_t i = 0; i < aNumberOfVectors; ++i) {
+        if (tMovedMask & (1 << i)) {
+            struct ThickLine * tLine = aLines[i];
+            drawLineWithThickness(tLine->StartX, tLine->StartY, tLine->EndX, tLine->EndY, tLine->Thickness,
+                    tLine->BackgroundColor);
+        }
+    }
+    for (uint8_t i = 0; i < aNumberOfVectors; ++i) {
+        if (tDrawMask & (1 << i)) {
+            struct ThickLine * tLine = aLines[i];
+            tLine->EndX = tNewEnds[i][0];
+            tLine->EndY = tNewEnds[i][1];
+            drawLineWithThickness(tLine->StartX, tLine->StartY, tLine->EndX, tLine->EndY, tLine->Thickness, tLine->Color);
+        }
     }
+    endFrame();
 }
 
 // for use in syscalls.c
@@ -696,8 +1075,8 @@ void BlueDisplay::drawMLText(uint16_t aPosX, uint16_t aPosY, const char *aString
     LocalDisplay.drawMLText(aPosX, aPosY - getTextAscend(aTextSize), (char *) aStringPtr, getLocalTextSize(aTextSize), aFGColor,
             aBGColor);
     if (USART_isBluetoothPaired()) {
-        sendUSART5ArgsAndByteBuffer(FUNCTION_DRAW_STRING, aPosX, aPosY, aTextSize, aFGColor, aBGColor, (uint8_t*) aStringPtr,
-                strlen(aStringPtr));
+        sendUSARTCommandAndByteBuffer<FUNCTION_DRAW_STRING>(aStringPtr, strlen(aStringPtr), aPosX, aPosY, aTextSize, aFGColor,
+                aBGColor);
     }
 }
 #endif
@@ -718,8 +1097,8 @@ uint16_t BlueDisplay::drawTextPGM(uint16_t aPosX, uint16_t aPosY, const char * a
 #endif
     if (USART_isBluetoothPaired()) {
         tRetValue = aPosX + tCaptionLength * getTextWidth(aTextSize);
-        sendUSART5ArgsAndByteBuffer(FUNCTION_DRAW_STRING, aPosX, aPosY, aTextSize, aFGColor, aBGColor, (uint8_t*) StringBuffer,
-                tCaptionLength);
+        sendUSARTCommandAndByteBuffer<FUNCTION_DRAW_STRING>(StringBuffer, tCaptionLength, aPosX, aPosY, aTextSize, aFGColor,
+                aBGColor);
     }
     return tRetValue;
 }
@@ -734,7 +1113,7 @@ uint16_t BlueDisplay::drawTextPGM(uint16_t aPosX, uint16_t aPosY, const char * a
 void BlueDisplay::getNumber(void (*aNumberHandler)(float)) {
     if (USART_isBluetoothPaired()) {
 #ifndef AVR
-        sendUSARTArgs(FUNCTION_GET_NUMBER, 2, aNumberHandler, (reinterpret_cast<uint32_t>(aNumberHandler) >> 16));
+        sendUSARTArgs(FUNCTION_GET_NUMBER, 2, aNumberHandler, (reinterpret_cast<uintptr_t>(aNumberHandler) >> 16));
 #else
         sendUSARTArgs(FUNCTION_GET_NUMBER, 1, aNumberHandler);
 #endif
@@ -748,7 +1127,7 @@ void BlueDisplay::getNumberWithShortPrompt(void (*aNumberHandler)(float), const
     if (USART_isBluetoothPaired()) {
 #ifndef AVR
         sendUSARTArgsAndByteBuffer(FUNCTION_GET_NUMBER_WITH_SHORT_PROMPT, 2, aNumberHandler,
-                (reinterpret_cast<uint32_t>(aNumberHandler) >> 16), strlen(aShortPromptString), (uint8_t*) aShortPromptString);
+                (reinterpret_cast<uintptr_t>(aNumberHandler) >> 16), strlen(aShortPromptString), (uint8_t*) aShortPromptString);
 #else
         sendUSARTArgsAndByteBuffer(FUNCTION_GET_NUMBER_WITH_SHORT_PROMPT, 1, aNumberHandler, strlen(aShortPromptString),
                 (uint8_t*) aShortPromptString);
@@ -768,7 +1147,7 @@ void BlueDisplay::getNumberWithShortPrompt(void (*aNumberHandler)(float), const
         floatToShortArray.floatValue = aInitialValue;
 #ifndef AVR
         sendUSARTArgsAndByteBuffer(FUNCTION_GET_NUMBER_WITH_SHORT_PROMPT, 4, aNumberHandler,
-                (reinterpret_cast<uint32_t>(aNumberHandler) >> 16), floatToShortArray.shortArray[0],
+                (reinterpret_cast<uintptr_t>(aNumberHandler) >> 16), floatToShortArray.shortArray[0],
                 floatToShortArray.shortArray[1], strlen(aShortPromptString), (uint8_t*) aShortPromptString);
 #else
         sendUSARTArgsAndByteBuffer(FUNCTION_GET_NUMBER_WITH_SHORT_PROMPT, 3, aNumberHandler, floatToShortArray.shortArray[0],
@@ -780,7 +1159,7 @@ void BlueDisplay::getNumberWithShortPrompt(void (*aNumberHandler)(float), const
 //void BlueDisplay::getText(void (*aTextHandler)(char *)) {
 //    if (USART_isBluetoothPaired()) {
 //#ifndef AVR
-//        sendUSARTArgs(FUNCTION_GET_TEXT, 2, aTextHandler, (reinterpret_cast<uint32_t>(aTextHandler) >> 16));
+//        sendUSARTArgs(FUNCTION_GET_TEXT, 2, aTextHandler, (reinterpret_cast<uintptr_t>(aTextHandler) >> 16));
 //#else
 //        sendUSARTArgs(FUNCTION_GET_TEXT, 1, aTextHandler);
 //#endif
@@ -790,7 +1169,7 @@ void BlueDisplay::getNumberWithShortPrompt(void (*aNumberHandler)(float), const
 void BlueDisplay::getInfo(uint16_t aInfoSubcommand, void (*aInfoHandler)(uint8_t *)) {
     if (USART_isBluetoothPaired()) {
 #ifndef AVR
-        sendUSARTArgs(FUNCTION_GET_INFO, 3, aInfoSubcommand, aInfoHandler, (reinterpret_cast<uint32_t>(aInfoHandler) >> 16));
+        sendUSARTArgs(FUNCTION_GET_INFO, 3, aInfoSubcommand, aInfoHandler, (reinterpret_cast<uintptr_t>(aInfoHandler) >> 16));
 #else
         sendUSARTArgs(FUNCTION_GET_INFO, 2, aInfoSubcommand, aInfoHandler);
 #endif
@@ -802,7 +1181,7 @@ void BlueDisplay::getInfo(uint16_t aInfoSubcommand, void (*aInfoHandler)(uint8_t
  */
 void BlueDisplay::requestMaxCanvasSize(void) {
     if (USART_isBluetoothPaired()) {
-        sendUSARTArgs(FUNCTION_REQUEST_MAX_CANVAS_SIZE, 0);
+        sendUSARTCommand<FUNCTION_REQUEST_MAX_CANVAS_SIZE>();
     }
 }
 
@@ -848,7 +1227,7 @@ void BlueDisplay::getNumberWithShortPromptPGM(void (*aNumberHandler)(float), con
 //
 //#ifndef AVR
 //            sendUSARTArgsAndByteBuffer(FUNCTION_GET_TEXT_WITH_SHORT_PROMPT, 2, aTextHandler,
-//                    (reinterpret_cast<uint32_t>(aTextHandler) >> 16), tShortPromptLength, (uint8_t*) StringBuffer);
+//                    (reinterpret_cast<uintptr_t>(aTextHandler) >> 16), tShortPromptLength, (uint8_t*) StringBuffer);
 //#else
 //            sendUSARTArgsAndByteBuffer(FUNCTION_GET_TEXT_WITH_SHORT_PROMPT, 1, aTextHandler, tShortPromptLength, (uint8_t*) StringBuffer);
 //#endif
@@ -872,7 +1251,7 @@ void BlueDisplay::getNumberWithShortPromptPGM(void (*aNumberHandler)(float), con
 void BlueDisplay::setSensor(uint8_t aSensorType, bool aDoActivate, uint8_t aSensorRate, uint8_t aFilterFlag) {
     aSensorRate &= 0x03;
     if (USART_isBluetoothPaired()) {
-        sendUSARTArgs(FUNCTION_SENSOR_SETTINGS, 4, aSensorType, aDoActivate, aSensorRate, aFilterFlag);
+        sendUSARTCommand<FUNCTION_SENSOR_SETTINGS>(aSensorType, aDoActivate, aSensorRate, aFilterFlag);
     }
 }
 
@@ -891,35 +1270,54 @@ BDButtonHandle_t BlueDisplay::createButton(uint16_t aPositionX, uint16_t aPositi
 #ifndef AVR
         sendUSARTArgsAndByteBuffer(FUNCTION_BUTTON_CREATE, 10, tButtonNumber, aPositionX, aPositionY, aWidthX, aHeightY,
                 aButtonColor, aCaptionSize | (aFlags << 8), aValue, aOnTouchHandler,
-                (reinterpret_cast<uint32_t>(aOnTouchHandler) >> 16), strlen(aCaption), aCaption);
+                (reinterpret_cast<uintptr_t>(aOnTouchHandler) >> 16), strlen(aCaption), aCaption);
 #else
         sendUSARTArgsAndByteBuffer(FUNCTION_BUTTON_CREATE, 9, tButtonNumber, aPositionX, aPositionY, aWidthX, aHeightY,
                 aButtonColor, aCaptionSize | (aFlags << 8), aValue, aOnTouchHandler, strlen(aCaption), aCaption);
 #endif
+        cacheButtonState(tButtonNumber, aButtonColor, aValue, aCaption);
     }
     return tButtonNumber;
 }
 
 void BlueDisplay::drawButton(BDButtonHandle_t aButtonNumber) {
     if (USART_isBluetoothPaired()) {
-        sendUSARTArgs(FUNCTION_BUTTON_DRAW, 1, aButtonNumber);
+        sendUSARTCommand<FUNCTION_BUTTON_DRAW>(aButtonNumber);
     }
 }
 
 void BlueDisplay::removeButton(BDButtonHandle_t aButtonNumber, Color_t aBackgroundColor) {
     if (USART_isBluetoothPaired()) {
-        sendUSARTArgs(FUNCTION_BUTTON_REMOVE, 2, aButtonNumber, aBackgroundColor);
+        sendUSARTCommand<FUNCTION_BUTTON_REMOVE>(aButtonNumber, aBackgroundColor);
     }
 }
 
 void BlueDisplay::drawButtonCaption(BDButtonHandle_t aButtonNumber) {
     if (USART_isBluetoothPaired()) {
-        sendUSARTArgs(FUNCTION_BUTTON_DRAW_CAPTION, 1, aButtonNumber);
+        sendUSARTCommand<FUNCTION_BUTTON_DRAW_CAPTION>(aButtonNumber);
     }
 }
 
+/**
+ * Captions are sent as ID of a registered string if enabled by setStringRegistration()
+ * Setting the caption sent last without drawing is skipped.
+ */
 void BlueDisplay::setButtonCaption(BDButtonHandle_t aButtonNumber, const char * aCaption, bool doDrawButton) {
     if (USART_isBluetoothPaired()) {
+#ifndef DO_NOT_CACHE_GUI_STATE
+        if (checkAndCacheButtonCaption(aButtonNumber, aCaption) && !doDrawButton) {
+            return;
+        }
+#endif
+        uint8_t tStringID = getRegisteredStringID(aCaption);
+        if (tStringID != STRING_TABLE_NO_ID) {
+            uint8_t tFunctionCode = FUNCTION_BUTTON_SET_REGISTERED_CAPTION;
+            if (doDrawButton) {
+                tFunctionCode = FUNCTION_BUTTON_SET_REGISTERED_CAPTION_AND_DRAW_BUTTON;
+            }
+            sendUSARTArgs(tFunctionCode, 2, aButtonNumber, tStringID);
+            return;
+        }
         uint8_t tFunctionCode = FUNCTION_BUTTON_SET_CAPTION;
         if (doDrawButton) {
             tFunctionCode = FUNCTION_BUTTON_SET_CAPTION_AND_DRAW_BUTTON;
@@ -928,59 +1326,87 @@ void BlueDisplay::setButtonCaption(BDButtonHandle_t aButtonNumber, const char *
     }
 }
 
+/**
+ * Setting the value sent last is skipped
+ */
 void BlueDisplay::setButtonValue(BDButtonHandle_t aButtonNumber, int16_t aValue) {
     if (USART_isBluetoothPaired()) {
-        sendUSARTArgs(FUNCTION_BUTTON_SETTINGS, 3, aButtonNumber, SUBFUNCTION_BUTTON_SET_VALUE, aValue);
+#ifndef DO_NOT_CACHE_GUI_STATE
+        if (checkAndCacheButtonValue(aButtonNumber, aValue)) {
+            return;
+        }
+#endif
+        sendUSARTCommand<FUNCTION_BUTTON_SETTINGS>(aButtonNumber, (uint16_t) SUBFUNCTION_BUTTON_SET_VALUE, aValue);
     }
 }
 
+/**
+ * Is always sent, since button may be overdrawn
+ */
 void BlueDisplay::setButtonValueAndDraw(BDButtonHandle_t aButtonNumber, int16_t aValue) {
     if (USART_isBluetoothPaired()) {
-        sendUSARTArgs(FUNCTION_BUTTON_SETTINGS, 3, aButtonNumber, SUBFUNCTION_BUTTON_SET_VALUE_AND_DRAW, aValue);
+#ifndef DO_NOT_CACHE_GUI_STATE
+        checkAndCacheButtonValue(aButtonNumber, aValue);
+#endif
+        sendUSARTCommand<FUNCTION_BUTTON_SETTINGS>(aButtonNumber, (uint16_t) SUBFUNCTION_BUTTON_SET_VALUE_AND_DRAW, aValue);
     }
 }
 
+/**
+ * Setting the color sent last is skipped
+ */
 void BlueDisplay::setButtonColor(BDButtonHandle_t aButtonNumber, Color_t aButtonColor) {
     if (USART_isBluetoothPaired()) {
-        sendUSARTArgs(FUNCTION_BUTTON_SETTINGS, 3, aButtonNumber, SUBFUNCTION_BUTTON_SET_BUTTON_COLOR, aButtonColor);
+#ifndef DO_NOT_CACHE_GUI_STATE
+        if (checkAndCacheButtonColor(aButtonNumber, aButtonColor)) {
+            return;
+        }
+#endif
+        sendUSARTCommand<FUNCTION_BUTTON_SETTINGS>(aButtonNumber, (uint16_t) SUBFUNCTION_BUTTON_SET_BUTTON_COLOR, aButtonColor);
     }
 }
 
+/**
+ * Is always sent, since button may be overdrawn
+ */
 void BlueDisplay::setButtonColorAndDraw(BDButtonHandle_t aButtonNumber, Color_t aButtonColor) {
     if (USART_isBluetoothPaired()) {
-        sendUSARTArgs(FUNCTION_BUTTON_SETTINGS, 3, aButtonNumber, SUBFUNCTION_BUTTON_SET_BUTTON_COLOR_AND_DRAW, aButtonColor);
+#ifndef DO_NOT_CACHE_GUI_STATE
+        checkAndCacheButtonColor(aButtonNumber, aButtonColor);
+#endif
+        sendUSARTCommand<FUNCTION_BUTTON_SETTINGS>(aButtonNumber, (uint16_t) SUBFUNCTION_BUTTON_SET_BUTTON_COLOR_AND_DRAW, aButtonColor);
     }
 }
 
 void BlueDisplay::setButtonPosition(BDButtonHandle_t aButtonNumber, int16_t aPositionX, int16_t aPositionY) {
     if (USART_isBluetoothPaired()) {
-        sendUSARTArgs(FUNCTION_BUTTON_SETTINGS, 4, aButtonNumber, SUBFUNCTION_BUTTON_SET_POSITION, aPositionX, aPositionY);
+        sendUSARTCommand<FUNCTION_BUTTON_SETTINGS>(aButtonNumber, (uint16_t) SUBFUNCTION_BUTTON_SET_POSITION, aPositionX, aPositionY);
     }
 }
 
 void BlueDisplay::setButtonAutorepeatTiming(BDButtonHandle_t aButtonNumber, uint16_t aMillisFirstDelay, uint16_t aMillisFirstRate,
         uint16_t aFirstCount, uint16_t aMillisSecondRate) {
     if (USART_isBluetoothPaired()) {
-        sendUSARTArgs(FUNCTION_BUTTON_SETTINGS, 7, aButtonNumber, SUBFUNCTION_BUTTON_SET_AUTOREPEAT_TIMING, aMillisFirstDelay,
+        sendUSARTCommand<FUNCTION_BUTTON_SETTINGS>(aButtonNumber, (uint16_t) SUBFUNCTION_BUTTON_SET_AUTOREPEAT_TIMING, aMillisFirstDelay,
                 aMillisFirstRate, aFirstCount, aMillisSecondRate);
     }
 }
 
 void BlueDisplay::activateButton(BDButtonHandle_t aButtonNumber) {
     if (USART_isBluetoothPaired()) {
-        sendUSARTArgs(FUNCTION_BUTTON_SETTINGS, 2, aButtonNumber, SUBFUNCTION_BUTTON_SET_ACTIVE);
+        sendUSARTCommand<FUNCTION_BUTTON_SETTINGS>(aButtonNumber, (uint16_t) SUBFUNCTION_BUTTON_SET_ACTIVE);
     }
 }
 
 void BlueDisplay::deactivateButton(BDButtonHandle_t aButtonNumber) {
     if (USART_isBluetoothPaired()) {
-        sendUSARTArgs(FUNCTION_BUTTON_SETTINGS, 2, aButtonNumber, SUBFUNCTION_BUTTON_RESET_ACTIVE);
+        sendUSARTCommand<FUNCTION_BUTTON_SETTINGS>(aButtonNumber, (uint16_t) SUBFUNCTION_BUTTON_RESET_ACTIVE);
     }
 }
 
 void BlueDisplay::setButtonsGlobalFlags(uint16_t aFlags) {
     if (USART_isBluetoothPaired()) {
-        sendUSARTArgs(FUNCTION_BUTTON_GLOBAL_SETTINGS, 1, aFlags);
+        sendUSARTCommand<FUNCTION_BUTTON_GLOBAL_SETTINGS>(aFlags);
     }
 }
 
@@ -989,20 +1415,62 @@ void BlueDisplay::setButtonsGlobalFlags(uint16_t aFlags) {
  */
 void BlueDisplay::setButtonsTouchTone(uint8_t aToneIndex, uint8_t aToneVolume) {
     if (USART_isBluetoothPaired()) {
-        sendUSARTArgs(FUNCTION_BUTTON_GLOBAL_SETTINGS, 3, BUTTONS_SET_BEEP_TONE, aToneIndex, aToneVolume);
+        sendUSARTCommand<FUNCTION_BUTTON_GLOBAL_SETTINGS>((uint16_t) BUTTONS_SET_BEEP_TONE, aToneIndex, aToneVolume);
     }
 }
 
 void BlueDisplay::activateAllButtons(void) {
     if (USART_isBluetoothPaired()) {
-        sendUSARTArgs(FUNCTION_BUTTON_ACTIVATE_ALL, 0);
+        sendUSARTCommand<FUNCTION_BUTTON_ACTIVATE_ALL>();
     }
 }
 
 void BlueDisplay::deactivateAllButtons(void) {
     if (USART_isBluetoothPaired()) {
-        sendUSARTArgs(FUNCTION_BUTTON_DEACTIVATE_ALL, 0);
+        sendUSARTCommand<FUNCTION_BUTTON_DEACTIVATE_ALL>();
+    }
+}
+
+/**
+ * Enables skipping of button and slider setters which would not change the state of the remote side.
+ * Default is enabled.
+ */
+void BlueDisplay::setGUIStateCaching(bool aEnable) {
+    mGUIStateCachingEnabled = aEnable;
+    resetGUIStateCache();
+}
+
+/**
+ * Next setters are sent unconditionally. Must be called if remote side may have lost its buttons and sliders e.g. on reconnect.
+ */
+void BlueDisplay::resetGUIStateCache(void) {
+#ifndef DO_NOT_CACHE_GUI_STATE
+    memset(sButtonStates, 0, sizeof(sButtonStates));
+    memset(sSliderStates, 0, sizeof(sSliderStates));
+#endif
+}
+
+/**
+ * Stores the state a button was created with
+ */
+void BlueDisplay::cacheButtonState(BDButtonHandle_t aButtonNumber, Color_t aButtonColor, int16_t aValue,
+        const char * aCaption) {
+#ifndef DO_NOT_CACHE_GUI_STATE
+    checkAndCacheButtonColor(aButtonNumber, aButtonColor);
+    checkAndCacheButtonValue(aButtonNumber, aValue);
+    checkAndCacheButtonCaption(aButtonNumber, aCaption);
+#endif
+}
+
+/**
+ * Must be called if the remote side changed the state by itself e.g. on touch of a red green button
+ */
+void BlueDisplay::resetButtonStateCache(BDButtonHandle_t aButtonNumber) {
+#ifndef DO_NOT_CACHE_GUI_STATE
+    if (aButtonNumber < GUI_STATE_CACHE_NUMBER_OF_BUTTONS) {
+        sButtonStates[aButtonNumber].ValidFlags = 0;
     }
+#endif
 }
 
 #ifdef AVR
@@ -1071,83 +1539,105 @@ BDSliderHandle_t BlueDisplay::createSlider(uint16_t aPositionX, uint16_t aPositi
 
         sendUSARTArgs(FUNCTION_SLIDER_CREATE, 12, tSliderNumber, aPositionX, aPositionY, aBarWidth, aBarLength, aThresholdValue,
                 aInitalValue, aSliderColor, aBarColor, aFlags, aOnChangeHandler,
-                (reinterpret_cast<uint32_t>(aOnChangeHandler) >> 16));
+                (reinterpret_cast<uintptr_t>(aOnChangeHandler) >> 16));
 #else
         sendUSARTArgs(FUNCTION_SLIDER_CREATE, 11, tSliderNumber, aPositionX, aPositionY, aBarWidth, aBarLength, aThresholdValue,
                 aInitalValue, aSliderColor, aBarColor, aFlags, aOnChangeHandler);
 #endif
+        // bar is not drawn before drawSlider()
+        resetSliderStateCache(tSliderNumber);
     }
     return tSliderNumber;
 }
 
 void BlueDisplay::drawSlider(BDSliderHandle_t aSliderNumber) {
     if (USART_isBluetoothPaired()) {
-        sendUSARTArgs(FUNCTION_SLIDER_DRAW, 1, aSliderNumber);
+        sendUSARTCommand<FUNCTION_SLIDER_DRAW>(aSliderNumber);
     }
 }
 
 void BlueDisplay::drawSliderBorder(BDSliderHandle_t aSliderNumber) {
     if (USART_isBluetoothPaired()) {
-        sendUSARTArgs(FUNCTION_SLIDER_DRAW_BORDER, 1, aSliderNumber);
+        sendUSARTCommand<FUNCTION_SLIDER_DRAW_BORDER>(aSliderNumber);
     }
 }
 
+/**
+ * Setting the value sent last is skipped, if display was not cleared since
+ */
 void BlueDisplay::setSliderActualValueAndDrawBar(BDSliderHandle_t aSliderNumber, int16_t aActualValue) {
     if (USART_isBluetoothPaired()) {
-        sendUSARTArgs(FUNCTION_SLIDER_SETTINGS, 3, aSliderNumber, SUBFUNCTION_SLIDER_SET_VALUE_AND_DRAW_BAR, aActualValue);
+#ifndef DO_NOT_CACHE_GUI_STATE
+        if (checkAndCacheSliderValue(aSliderNumber, aActualValue)) {
+            return;
+        }
+#endif
+        sendUSARTCommand<FUNCTION_SLIDER_SETTINGS>(aSliderNumber, (uint16_t) SUBFUNCTION_SLIDER_SET_VALUE_AND_DRAW_BAR, aActualValue);
     }
 }
 
 void BlueDisplay::setSliderColorBarThreshold(BDSliderHandle_t aSliderNumber, uint16_t aBarThresholdColor) {
     if (USART_isBluetoothPaired()) {
-        sendUSARTArgs(FUNCTION_SLIDER_SETTINGS, 3, aSliderNumber, SUBFUNCTION_SLIDER_SET_COLOR_THRESHOLD, aBarThresholdColor);
+        sendUSARTCommand<FUNCTION_SLIDER_SETTINGS>(aSliderNumber, (uint16_t) SUBFUNCTION_SLIDER_SET_COLOR_THRESHOLD, aBarThresholdColor);
     }
 }
 
 void BlueDisplay::setSliderColorBarBackground(BDSliderHandle_t aSliderNumber, uint16_t aBarBackgroundColor) {
     if (USART_isBluetoothPaired()) {
-        sendUSARTArgs(FUNCTION_SLIDER_SETTINGS, 3, aSliderNumber, SUBFUNCTION_SLIDER_SET_COLOR_BAR_BACKGROUND, aBarBackgroundColor);
+        sendUSARTCommand<FUNCTION_SLIDER_SETTINGS>(aSliderNumber, (uint16_t) SUBFUNCTION_SLIDER_SET_COLOR_BAR_BACKGROUND,
+                aBarBackgroundColor);
     }
 }
 
 void BlueDisplay::setSliderCaptionProperties(BDSliderHandle_t aSliderNumber, uint8_t aCaptionSize, uint8_t aCaptionPosition,
         uint8_t aCaptionMargin, Color_t aCaptionColor, Color_t aCaptionBackgroundColor) {
     if (USART_isBluetoothPaired()) {
-        sendUSARTArgs(FUNCTION_SLIDER_SETTINGS, 7, aSliderNumber, SUBFUNCTION_SLIDER_SET_CAPTION_PROPERTIES, aCaptionSize,
+        sendUSARTCommand<FUNCTION_SLIDER_SETTINGS>(aSliderNumber, (uint16_t) SUBFUNCTION_SLIDER_SET_CAPTION_PROPERTIES, aCaptionSize,
                 aCaptionPosition, aCaptionMargin, aCaptionColor, aCaptionBackgroundColor);
     }
 }
 
 void BlueDisplay::setSliderCaption(BDSliderHandle_t aSliderNumber, const char * aCaption) {
     if (USART_isBluetoothPaired()) {
-        sendUSARTArgsAndByteBuffer(FUNCTION_SLIDER_SET_CAPTION, 1, aSliderNumber, strlen(aCaption), aCaption);
+        sendUSARTCommandAndByteBuffer<FUNCTION_SLIDER_SET_CAPTION>(aCaption, strlen(aCaption), aSliderNumber);
     }
 }
 
 void BlueDisplay::activateSlider(BDSliderHandle_t aSliderNumber) {
     if (USART_isBluetoothPaired()) {
-        sendUSARTArgs(FUNCTION_SLIDER_SETTINGS, 2, aSliderNumber, SUBFUNCTION_SLIDER_SET_ACTIVE);
+        sendUSARTCommand<FUNCTION_SLIDER_SETTINGS>(aSliderNumber, (uint16_t) SUBFUNCTION_SLIDER_SET_ACTIVE);
     }
 }
 
 void BlueDisplay::deactivateSlider(BDSliderHandle_t aSliderNumber) {
     if (USART_isBluetoothPaired()) {
-        sendUSARTArgs(FUNCTION_SLIDER_SETTINGS, 2, aSliderNumber, SUBFUNCTION_SLIDER_RESET_ACTIVE);
+        sendUSARTCommand<FUNCTION_SLIDER_SETTINGS>(aSliderNumber, (uint16_t) SUBFUNCTION_SLIDER_RESET_ACTIVE);
     }
 }
 
 void BlueDisplay::activateAllSliders(void) {
     if (USART_isBluetoothPaired()) {
-        sendUSARTArgs(FUNCTION_SLIDER_ACTIVATE_ALL, 0);
+        sendUSARTCommand<FUNCTION_SLIDER_ACTIVATE_ALL>();
     }
 }
 
 void BlueDisplay::deactivateAllSliders(void) {
     if (USART_isBluetoothPaired()) {
-        sendUSARTArgs(FUNCTION_SLIDER_DEACTIVATE_ALL, 0);
+        sendUSARTCommand<FUNCTION_SLIDER_DEACTIVATE_ALL>();
     }
 }
 
+/**
+ * Must be called if the remote side changed the value by itself e.g. on touch
+ */
+void BlueDisplay::resetSliderStateCache(BDSliderHandle_t aSliderNumber) {
+#ifndef DO_NOT_CACHE_GUI_STATE
+    if (aSliderNumber < GUI_STATE_CACHE_NUMBER_OF_SLIDERS) {
+        sSliderStates[aSliderNumber].ValueValid = false;
+    }
+#endif
+}
+
 /***************************************************************************************************************************************************
  *
  * Text sizes
@@ -30,23 +30,31 @@
 #include "BlueDisplay.h"
 
 #include "EventHandler.h"
+#include "EventTrace.h"
 #include "timing.h"
+#ifndef HOST_SIMULATION
 #include "stm32fx0xPeripherals.h" // For Watchdog_reload()
+#endif
 
 #include <string.h> // for memcpy
 #include <stdarg.h>  // for varargs
 
 //#define USE_SIMPLE_SERIAL
 
+#ifndef HOST_SIMULATION
 DMA_HandleTypeDef DMA_UART_BD_TXHandle;
 DMA_HandleTypeDef DMA_UART_BD_RXHandle;
 UART_HandleTypeDef UART_BD_Handle;
+#endif
 
 /**
  * UART receive is done via continuous DMA transfer to a circular receive buffer.
  * At this time only touch events of 6 byte are transferred.
- * The thread process checks the receive buffer via checkTouchReceived
- * and marks processed events by just clearing the data.
+ * The received bytes are parsed block wise up to the end of the circular buffer by a state machine,
+ * complete events are put into a FIFO which is consumed by checkAndHandleMessageReceived(),
+ * and processed bytes are marked by just clearing the data.
+ * While the main loop blocks in a send function, events are saved into the FIFO to avoid overrun of the receive buffer.
+ * If the FIFO is full, the newest event is dropped and counted in ReceiveStatistics.
  * Buffer overrun is detected by using a Buffer size of (n*6)-1 so the sync token
  * in case of overrun is on another position than the one expected.
  *
@@ -55,26 +63,72 @@ UART_HandleTypeDef UART_BD_Handle;
  * The next write then waits for the ongoing transmission(s) to end (blocking wait) until enough free space is available.
  * If an transmission ends, the buffer space used for this transmission gets available for next send data.
  * If there is more data in the buffer to send, then the next DMA transfer for the remaining data is started immediately.
+ *
+ * Between startSendFrame() and endSendFrame() the data is written to the send buffer
+ * and the DMA is started only if SEND_FRAME_FLUSH_THRESHOLD bytes are collected and at endSendFrame().
+ * This saves the DMA setup and the transfer complete interrupt for each of the many small draw commands of a page,
+ * if computation is interleaved with the commands. The threshold keeps sending overlapped with computation.
+ *
+ * Commands are control traffic (buttons, sliders, drawing) which is never dropped and blocks if the buffer is full,
+ * or belong to a replaceable stream (charts, info text) between startSendStream() and endSendStream().
+ * If the link is saturated, the newest message of each stream is kept and sent if space is available,
+ * so the main loop is not blocked by streaming data.
+ *
+ * For HOST_SIMULATION the UART and DMA hardware functions are implemented in BlueSerial_Host.cpp.
  */
 
 /*
  * UART constants
  */
 // send buffer
-#define UART_SEND_BUFFER_SIZE 1024
 uint8_t * sUSARTSendBufferPointerIn; // only set by thread - point to first byte of free buffer space
 volatile uint8_t * sUSARTSendBufferPointerOut; // only set by ISR - point to first byte not yet transfered
 uint8_t USARTSendBuffer[UART_SEND_BUFFER_SIZE] __attribute__ ((aligned(4)));
 uint8_t * sUSARTSendBufferPointerOutTmp; // value of sUSARTSendBufferPointerOut after transfer complete
 volatile bool sDMATransferOngoing = false;  // synchronizing flag for ISR <-> thread
+uint8_t sSendFrameNestingLevel = 0; // != 0 => do not start a DMA transfer for each command
+
+// Queue of payloads which are sent directly from their source by DMA
+struct USARTNoCopyDescriptor {
+    uint8_t * InsertPosition; // position in send buffer, where payload has to be inserted into data stream
+    uint8_t * Address;
+    uint16_t Length;
+};
+struct USARTNoCopyDescriptor sNoCopyQueue[USART_NO_COPY_QUEUE_SIZE];
+volatile uint8_t sNoCopyQueueIn = 0; // only set by thread
+volatile uint8_t sNoCopyQueueOut = 0; // only set by ISR
+volatile bool sNoCopyTransferOngoing = false;
+
+// Replaceable streams
+struct SendStreamSlot {
+    uint8_t Data[SEND_STREAM_SLOT_SIZE];
+    uint16_t Length; // 0 -> no message waiting
+};
+static struct SendStreamSlot sSendStreamSlots[NUMBER_OF_SEND_STREAMS];
+static uint8_t sStreamAssemblyBuffer[SEND_STREAM_SLOT_SIZE];
+static uint16_t sStreamAssemblyLength;
+static bool sStreamAssemblyOverflow;
+static uint8_t sSendStreamIndex = SEND_STREAM_NONE;
+struct SendStatistics SendStatistics;
+#ifndef USE_SIMPLE_SERIAL
+static void startNoCopyTransfer(uint8_t * aParameterBufferPointer, size_t aParameterBufferLength, uint8_t * aDataBufferPointer,
+        size_t aDataBufferLength);
+#endif
+
+#ifdef USE_DISPLAY_LIST
+// Commands of the actual page
+struct DisplayList RetainedDisplayList;
+static bool sDisplayListRecording = false;
+static uint16_t sDisplayListReplayLength = 0; // != 0 -> this part of the list may still be read by DMA
+#endif
 
 // Circular receive buffer
-#define USART_RECEIVE_BUFFER_SIZE (TOUCH_COMMAND_MAX_DATA_SIZE * 10 -1) // not a multiple of TOUCH_COMMAND_SIZE_BYTE in order to discover overruns
 uint8_t USARTReceiveBuffer[USART_RECEIVE_BUFFER_SIZE] __attribute__ ((aligned(4)));
 uint8_t * sUSARTReceiveBufferPointer; // point to first byte not yet processed (of next received message)
 int32_t sLastRXDMACount;
 bool sReceiveBufferOutOfSync = false;
 
+#ifndef HOST_SIMULATION
 /**
  * Init the input for Bluetooth HC-05 state pin
  * Initialization of clock and the RX and TX pins
@@ -192,6 +246,10 @@ void UART_BD_initialize(uint32_t aBaudRate) {
 
 //    USART_ITConfig(UART_BD_Handle.Instance, USART_IT_RXNE, ENABLE);   // enable Receive and overrun Interrupt
 //    USART_ITConfig(UART_BD_Handle.Instance, USART_IT_TC, ENABLE); // enable the UART transfer_complete interrupt
+#ifdef USE_TICKLESS_IDLE
+    // Receive is done by DMA without interrupt, the idle line interrupt after each message wakes up idleMillis()
+    __HAL_UART_ENABLE_IT(&UART_BD_Handle, UART_IT_IDLE);
+#endif
 
     /* Enable USART IRQ to lowest prio*/
     NVIC_SetPriority((IRQn_Type) (UART_BD_IRQ), 3);
@@ -226,13 +284,84 @@ void UART_BD_DMA_RX_reset(void) {
     UART_BD_Handle.hdmarx->Instance->CNDTR = USART_RECEIVE_BUFFER_SIZE;
     UART_BD_Handle.hdmarx->Instance->CCR |= DMA_CCR_EN; // No interrupts!
 }
+#endif // HOST_SIMULATION
+
+static inline bool isNoCopyQueueEmpty(void) {
+    return (sNoCopyQueueIn == sNoCopyQueueOut);
+}
+
+static inline bool isSendDataPending(void) {
+    return (sUSARTSendBufferPointerOut != sUSARTSendBufferPointerIn || !isNoCopyQueueEmpty());
+}
+
+/*
+ * Outside a frame all data is sent at once, inside a frame only if enough data is collected
+ */
+static bool isSendDataToBeSent(void) {
+    return (sSendFrameNestingLevel == 0
+            || UART_SEND_BUFFER_SIZE - getSendBufferFreeSpace() >= SEND_FRAME_FLUSH_THRESHOLD);
+}
 
+/**
+ * Starts DMA for the data between sUSARTSendBufferPointerOut and sUSARTSendBufferPointerIn
+ * or up to the insert position of the next no copy payload. If this position is reached, the payload is sent.
+ * On buffer wrap around only the tail of the buffer is sent, the head is sent by the next transfer complete interrupt.
+ */
+void startUSARTTransferOfPendingData(void) {
+    if (sDMATransferOngoing) {
+        return;
+    }
+    uint8_t * tUSARTSendBufferPointerOut = (uint8_t *) sUSARTSendBufferPointerOut;
+    uint8_t * tUSARTSendBufferPointerIn = sUSARTSendBufferPointerIn;
+    if (!isNoCopyQueueEmpty()) {
+        struct USARTNoCopyDescriptor * tDescriptor = &sNoCopyQueue[sNoCopyQueueOut];
+        if (tDescriptor->InsertPosition == tUSARTSendBufferPointerOut) {
+            // all data before payload is sent
+            sNoCopyTransferOngoing = true;
+            sUSARTSendBufferPointerOutTmp = tUSARTSendBufferPointerOut;
+            UART_BD_DMA_TX_start(tDescriptor->Address, tDescriptor->Length);
+            return;
+        }
+        tUSARTSendBufferPointerIn = tDescriptor->InsertPosition;
+    }
+    if (tUSARTSendBufferPointerOut < tUSARTSendBufferPointerIn) {
+        sUSARTSendBufferPointerOutTmp = tUSARTSendBufferPointerIn;
+        UART_BD_DMA_TX_start(tUSARTSendBufferPointerOut, (uint32_t) (tUSARTSendBufferPointerIn - tUSARTSendBufferPointerOut));
+    } else {
+        // buffer wrap around occurred - send tail of buffer
+        sUSARTSendBufferPointerOutTmp = &USARTSendBuffer[0];
+        UART_BD_DMA_TX_start(tUSARTSendBufferPointerOut, &USARTSendBuffer[UART_SEND_BUFFER_SIZE] - tUSARTSendBufferPointerOut);
+    }
+}
+
+/**
+ * Called on USART transfer complete. Releases the buffer space of the last transfer and starts the next one.
+ * Inside a frame the data is kept until endSendFrame() or until SEND_FRAME_FLUSH_THRESHOLD bytes are collected.
+ * @return false if no more data to send
+ */
+bool chainUSARTTransfer(void) {
+    if (sNoCopyTransferOngoing) {
+        sNoCopyTransferOngoing = false;
+        sNoCopyQueueOut = (sNoCopyQueueOut + 1) % USART_NO_COPY_QUEUE_SIZE;
+    } else {
+        sUSARTSendBufferPointerOut = sUSARTSendBufferPointerOutTmp;
+    }
+    sDMATransferOngoing = false;
+    if (!isSendDataPending() || !isSendDataToBeSent()) {
+        // transfer complete and no new data arrived in buffer or not enough data of frame
+        return false;
+    }
+    startUSARTTransferOfPendingData();
+    return true;
+}
+
+#ifndef HOST_SIMULATION
 /**
  * Starts a new DMA to USART transfer with the given parameters.
  * Assert that USART is ready for new transfer.
  * No further parameter check is done here!
  */
-void UART_BD_DMA_TX_start(uint32_t aMemoryBaseAddr, uint32_t aBufferSize) {
+void UART_BD_DMA_TX_start(uint8_t * aMemoryBaseAddr, uint32_t aBufferSize) {
     if (sDMATransferOngoing) {
         return; // not allowed to start a new transfer, because DMA is busy
     }
@@ -242,27 +371,19 @@ void UART_BD_DMA_TX_start(uint32_t aMemoryBaseAddr, uint32_t aBufferSize) {
 
     sDMATransferOngoing = true;
 
-    // Compute next buffer out pointer
-    uint8_t * tUSARTSendBufferPointerOutTmp = (uint8_t *) (aMemoryBaseAddr + aBufferSize);
-    // check for buffer wrap around
-    if (tUSARTSendBufferPointerOutTmp >= &USARTSendBuffer[UART_SEND_BUFFER_SIZE]) {
-        tUSARTSendBufferPointerOutTmp = &USARTSendBuffer[0];
-    }
-    sUSARTSendBufferPointerOutTmp = tUSARTSendBufferPointerOutTmp;
-
     if (aBufferSize == 1) {
         // no DMA needed just put data to TDR register
 #ifdef STM32F30X
-        UART_BD_Handle.Instance->TDR = *(uint8_t*) aMemoryBaseAddr;
+        UART_BD_Handle.Instance->TDR = *aMemoryBaseAddr;
 #else
-        UART_BD_Handle.Instance->DR = *(uint8_t*) aMemoryBaseAddr;
+        UART_BD_Handle.Instance->DR = *aMemoryBaseAddr;
 #endif
     } else {
         // Disable DMA channel - it is really needed here!
         UART_BD_Handle.hdmatx->Instance->CCR &= ~DMA_CCR_EN;
 
         // Write to DMA Channel CMAR
-        UART_BD_Handle.hdmatx->Instance->CMAR = aMemoryBaseAddr;
+        UART_BD_Handle.hdmatx->Instance->CMAR = (uint32_t) aMemoryBaseAddr;
         // Write to DMA Channel CNDTR
         UART_BD_Handle.hdmatx->Instance->CNDTR = aBufferSize;
         //USART_ClearFlag(UART_BD_Handle.Instance, USART_FLAG_TC);
@@ -285,13 +406,19 @@ void UART_BD_DMA_TX_start(uint32_t aMemoryBaseAddr, uint32_t aBufferSize) {
  * Therefore we must use USART and not the DMA TC interrupt!
  */
 extern "C" void UART_BD_IRQHANDLER(void) {
+#ifdef USE_TICKLESS_IDLE
+    if (__HAL_UART_GET_FLAG(&UART_BD_Handle, UART_FLAG_IDLE) != RESET) {
+        // only wake up, received data is handled by main loop
+        __HAL_UART_CLEAR_IDLEFLAG(&UART_BD_Handle);
+    }
+    // TC flag stays set after transfer, so check if interrupt is for TC
+    if (__HAL_UART_GET_IT_SOURCE(&UART_BD_Handle, UART_IT_TC) == RESET) {
+        return;
+    }
+#endif
     //if (USART_GetITStatus(UART_BD_Handle.Instance, USART_IT_TC) != RESET) {
     if (__HAL_UART_GET_FLAG(&UART_BD_Handle, UART_FLAG_TC) != RESET) {
-
-        sUSARTSendBufferPointerOut = sUSARTSendBufferPointerOutTmp;
-        sDMATransferOngoing = false;
-        if (sUSARTSendBufferPointerOut == sUSARTSendBufferPointerIn) {
-            // transfer complete and no new data arrived in buffer
+        if (!chainUSARTTransfer()) {
             /*
              * !! USART_ClearFlag(UART_BD_Handle.Instance, USART_FLAG_TC) has no effect on the TC Flag !!!! => next interrupt will happen after return from ISR
              * Must disable interrupt here otherwise it will interrupt forever (STM bug???)
@@ -299,20 +426,10 @@ extern "C" void UART_BD_IRQHANDLER(void) {
             __HAL_UART_DISABLE_IT(&UART_BD_Handle, UART_IT_TC);
             //USART_ITConfig(UART_BD_Handle.Instance, USART_IT_TC, DISABLE);
             //USART_ClearFlag(UART_BD_Handle.Instance, USART_FLAG_TC );
-        } else {
-            uint8_t * tUSARTSendBufferPointerIn = sUSARTSendBufferPointerIn;
-            if (sUSARTSendBufferPointerOut < tUSARTSendBufferPointerIn) {
-                // new data in buffer -> start new transfer
-                UART_BD_DMA_TX_start((uint32_t) sUSARTSendBufferPointerOut,
-                        (uint32_t) (tUSARTSendBufferPointerIn - sUSARTSendBufferPointerOut));
-            } else {
-                // new data, but buffer wrap around occurred - send tail of buffer
-                UART_BD_DMA_TX_start((uint32_t) sUSARTSendBufferPointerOut,
-                        &USARTSendBuffer[UART_SEND_BUFFER_SIZE] - sUSARTSendBufferPointerOut);
-            }
         }
     }
 }
+#endif // HOST_SIMULATION
 
 /*
  * Buffer handling
@@ -331,7 +448,7 @@ uint8_t * putSendBuffer(uint8_t * aUSARTSendBufferPointerIn, uint8_t aData) {
 }
 
 int getSendBufferFreeSpace(void) {
-    if (sUSARTSendBufferPointerOut == sUSARTSendBufferPointerIn && !sDMATransferOngoing) {
+    if (sUSARTSendBufferPointerOut == sUSARTSendBufferPointerIn && (!sDMATransferOngoing || sNoCopyTransferOngoing)) {
         // buffer empty
         return UART_SEND_BUFFER_SIZE;
     }
@@ -343,65 +460,110 @@ int getSendBufferFreeSpace(void) {
 }
 
 /**
- * Copy content of both buffers to send buffer, check for buffer wrap around and call USART_BD_DMA_TX_start() with right parameters.
- * Do blocking wait if not enough space left in buffer
+ * Commands sent until the matching endSendFrame() are only written to the send buffer.
+ * Calls can be nested.
  */
-void sendUSARTBufferNoSizeCheck(uint8_t * aParameterBufferPointer, size_t aParameterBufferLength,
-        uint8_t * aDataBufferPointer, size_t aDataBufferLength) {
-#ifdef USE_SIMPLE_SERIAL
-    sendUSARTBufferSimple(aParameterBufferPointer, aParameterBufferLength, aDataBufferPointer, aDataBufferLength);
-    return;
-#else
+void startSendFrame(void) {
+    sSendFrameNestingLevel++;
+}
 
-    if (!sDMATransferOngoing) {
-        // safe to reset buffer pointers since no transmit pending
-        sUSARTSendBufferPointerOut = &USARTSendBuffer[0];
-        sUSARTSendBufferPointerIn = &USARTSendBuffer[0];
+/**
+ * The outermost call starts the transfer of the rest of the commands collected since startSendFrame()
+ */
+void endSendFrame(void) {
+    if (sSendFrameNestingLevel > 0) {
+        sSendFrameNestingLevel--;
     }
-    uint8_t * tUSARTSendBufferPointerIn = sUSARTSendBufferPointerIn;
-    int tSize = aParameterBufferLength + aDataBufferLength;
-    /*
-     * check (and wait) for enough free space
-     */
-    if (getSendBufferFreeSpace() < tSize) {
-        // not enough space left - wait for transfer (chain) to complete or for size
-        // get interrupt level
-        uint32_t tISPR = (__get_IPSR() & 0xFF);
-        setTimeoutMillis(300); // enough for 256 bytes at 9600
-        while (sDMATransferOngoing) {
-            // is needed here, because early watchdog ISR sends also data
+    if (sSendFrameNestingLevel == 0 && !sDMATransferOngoing && isSendDataPending()) {
+        startUSARTTransferOfPendingData();
+    }
+    flushSendStreams();
+}
+
+#ifdef HOST_SIMULATION
+#define getSendClockMillis() ((uint32_t) (HostLinkNanos / 1000000)) // simulated link time
+#define isAddressInFlash(aAddress) (false)
+#else
+#define getSendClockMillis() getMillisSinceBoot()
+// 256 kByte flash of STM32F303VC
+#define isAddressInFlash(aAddress) (((uintptr_t) (aAddress) - FLASH_BASE) < 0x40000)
+#endif
+
+/**
+ * Body of busy wait loops for the end of the current transfer
+ */
+static void waitForUSARTTransferProgress(void) {
+    // is needed here, because early watchdog ISR sends also data
 #ifdef HAL_WWDG_MODULE_ENABLED
-            Watchdog_reload();
+    Watchdog_reload();
 #endif
-            if (tISPR > 0) {
-                // here in ISR, check manually for TransferComplete interrupt flag
-                if (__HAL_UART_GET_FLAG(&UART_BD_Handle, UART_FLAG_TC) != RESET) {
-                    // call ISR Handler manually
-                    UART_BD_IRQHANDLER();
-                    // Assertion
-                    assert_param(__HAL_UART_GET_FLAG(&UART_BD_Handle, UART_FLAG_TC) == RESET);
-                }
-            }
+#ifdef HOST_SIMULATION
+    hostWaitForUSARTTransferComplete();
+    receiveUSARTEvents();
+#else
+    if ((__get_IPSR() & 0xFF) > 0) {
+        // here in ISR, check manually for TransferComplete interrupt flag
+        if (__HAL_UART_GET_FLAG(&UART_BD_Handle, UART_FLAG_TC) != RESET) {
+            // call ISR Handler manually
+            UART_BD_IRQHANDLER();
+            // Assertion
+            assert_param(__HAL_UART_GET_FLAG(&UART_BD_Handle, UART_FLAG_TC) == RESET);
+        }
+    } else {
+        // save received events from being overwritten in the receive buffer while main loop is blocked
+        receiveUSARTEvents();
+    }
+#endif
+}
 
-            if (getSendBufferFreeSpace() >= tSize) {
-                break;
-            }
-            if (isTimeoutSimple()) {
-                // skip transfer, don't overwrite
-                return;
-            }
+/**
+ * Blocking wait until aSize bytes are free in send buffer.
+ * @return false if the space is not available after SEND_TIMEOUT_MILLIS, then the command must be skipped
+ */
+static bool waitForSendBufferFreeSpace(int aSize) {
+    if (!sDMATransferOngoing && sSendFrameNestingLevel > 0 && getSendBufferFreeSpace() <= aSize) {
+        // buffer filled up by frame - send it now. Never fill it completely, since then In == Out like for empty buffer.
+        startUSARTTransferOfPendingData();
+    }
+    if (getSendBufferFreeSpace() >= aSize) {
+        return true;
+    }
+    // not enough space left - wait for transfer (chain) to complete or for size
+    bool tSpaceAvailable = true;
+    uint32_t tStartMillis = getSendClockMillis();
+    while (getSendBufferFreeSpace() < aSize) {
+        if (!sDMATransferOngoing) {
+            // chain stopped e.g. inside a frame - send pending data to get space
+            startUSARTTransferOfPendingData();
+        }
+        waitForUSARTTransferProgress();
+        if (getSendClockMillis() - tStartMillis > SEND_TIMEOUT_MILLIS) {
+            // skip command, don't overwrite
+            SendStatistics.Timeouts++;
+            tSpaceAvailable = false;
+            break;
         }
     }
+    uint32_t tBlockingMillis = getSendClockMillis() - tStartMillis;
+    if (SendStatistics.MaxBlockingMillis < tBlockingMillis) {
+        SendStatistics.MaxBlockingMillis = tBlockingMillis;
+    }
+    return tSpaceAvailable;
+}
 
-    /*
-     * enough space here
-     */
-    uint8_t * tStartBufferPointer = tUSARTSendBufferPointerIn;
+/**
+ * Copy content of both buffers to send buffer, check for buffer wrap around and start DMA
+ * if not collecting a frame or if enough data of the frame is collected.
+ * Enough space must be available.
+ */
+static void copyToSendBuffer(uint8_t * aParameterBufferPointer, size_t aParameterBufferLength, uint8_t * aDataBufferPointer,
+        size_t aDataBufferLength, bool aStartTransfer) {
+    int tSize = aParameterBufferLength + aDataBufferLength;
+    uint8_t * tUSARTSendBufferPointerIn = sUSARTSendBufferPointerIn;
 
     int tBufferSizeToEndOfBuffer = (&USARTSendBuffer[UART_SEND_BUFFER_SIZE] - tUSARTSendBufferPointerIn);
     if (tBufferSizeToEndOfBuffer < tSize) {
         //transfer possible, but must be done in 2 chunks since DMA cannot handle buffer wrap around during a transfer
-        tSize = tBufferSizeToEndOfBuffer; // set size for 1. chunk
         // copy parameter the hard way
         while (aParameterBufferLength > 0) {
             tUSARTSendBufferPointerIn = putSendBuffer(tUSARTSendBufferPointerIn, *aParameterBufferPointer++);
@@ -429,14 +591,326 @@ void sendUSARTBufferNoSizeCheck(uint8_t * aParameterBufferPointer, size_t aParam
 // the only statement which writes the variable sUSARTSendBufferPointerIn
     sUSARTSendBufferPointerIn = tUSARTSendBufferPointerIn;
 
-// start DMA if not already running
-    UART_BD_DMA_TX_start((uint32_t) tStartBufferPointer, tSize);
+// start DMA if not already running and not collecting a frame
+    if (aStartTransfer && isSendDataToBeSent()) {
+        startUSARTTransferOfPendingData();
+    }
+}
+
+static void resetSendBufferIfEmpty(void) {
+    if (!sDMATransferOngoing && sUSARTSendBufferPointerOut == sUSARTSendBufferPointerIn && isNoCopyQueueEmpty()) {
+        // safe to reset buffer pointers since no transmit and no data of a frame or no copy payload pending
+        sUSARTSendBufferPointerOut = &USARTSendBuffer[0];
+        sUSARTSendBufferPointerIn = &USARTSendBuffer[0];
+    }
+}
+
+/*
+ * Replaceable streams
+ */
+/**
+ * Commands sent until endSendStream() form one message of a replaceable stream like a chart or an info text.
+ * If the link is saturated, the message is kept and replaced by the next message of the same stream,
+ * instead of blocking the caller.
+ * @param aStreamIndex one of SEND_STREAM_CHART_0 ... SEND_STREAM_INFO
+ */
+void startSendStream(uint8_t aStreamIndex) {
+    if (aStreamIndex >= NUMBER_OF_SEND_STREAMS) {
+        return;
+    }
+    sSendStreamIndex = aStreamIndex;
+    sStreamAssemblyLength = 0;
+    sStreamAssemblyOverflow = false;
+}
+
+void endSendStream(void) {
+    uint8_t tStreamIndex = sSendStreamIndex;
+    if (tStreamIndex == SEND_STREAM_NONE) {
+        return;
+    }
+    sSendStreamIndex = SEND_STREAM_NONE;
+    if (sStreamAssemblyOverflow) {
+        SendStatistics.Dropped++;
+        return;
+    }
+    if (sStreamAssemblyLength == 0) {
+        return;
+    }
+    struct SendStreamSlot * tSlot = &sSendStreamSlots[tStreamIndex];
+    if (tSlot->Length > 0) {
+        // newer message replaces the unsent older one
+        SendStatistics.Superseded++;
+        tSlot->Length = 0;
+    }
+    // older messages of other streams first
+    flushSendStreams();
+    resetSendBufferIfEmpty();
+    if (getSendBufferFreeSpace() >= sStreamAssemblyLength + SEND_BUFFER_CONTROL_RESERVE) {
+        copyToSendBuffer(sStreamAssemblyBuffer, sStreamAssemblyLength, NULL, 0, true);
+    } else {
+        // link saturated - keep it until space is available
+        memcpy(tSlot->Data, sStreamAssemblyBuffer, sStreamAssemblyLength);
+        tSlot->Length = sStreamAssemblyLength;
+    }
+}
+
+/**
+ * Copy waiting stream messages to send buffer if space is available. Does not block.
+ * Called by all send functions and by checkAndHandleEvents().
+ */
+void flushSendStreams(void) {
+    for (uint8_t i = 0; i < NUMBER_OF_SEND_STREAMS; ++i) {
+        struct SendStreamSlot * tSlot = &sSendStreamSlots[i];
+        if (tSlot->Length > 0) {
+            resetSendBufferIfEmpty();
+            if (getSendBufferFreeSpace() < tSlot->Length + SEND_BUFFER_CONTROL_RESERVE) {
+                return; // keep order of streams
+            }
+            copyToSendBuffer(tSlot->Data, tSlot->Length, NULL, 0, true);
+            tSlot->Length = 0;
+        }
+    }
+}
+
+/**
+ * Drops all waiting stream messages e.g. if the whole page is sent again
+ */
+void discardSendStreams(void) {
+    for (uint8_t i = 0; i < NUMBER_OF_SEND_STREAMS; ++i) {
+        if (sSendStreamSlots[i].Length > 0) {
+            sSendStreamSlots[i].Length = 0;
+            SendStatistics.Superseded++;
+        }
+    }
+}
+
+/**
+ * @return true if an unsent message of this stream is waiting. The next message of this stream will replace it.
+ */
+bool isSendStreamPending(uint8_t aStreamIndex) {
+    return (aStreamIndex < NUMBER_OF_SEND_STREAMS && sSendStreamSlots[aStreamIndex].Length > 0);
+}
+
+/**
+ * @return true between startSendStream() and endSendStream(), i.e. commands may be superseded and not reach the remote side
+ */
+bool isSendStreamActive(void) {
+    return (sSendStreamIndex != SEND_STREAM_NONE);
+}
+
+void resetSendStatistics(void) {
+    memset(&SendStatistics, 0, sizeof(SendStatistics));
+}
+
+#ifdef USE_DISPLAY_LIST
+/*
+ * Retained display list
+ */
+/**
+ * Stores the command in the display list. Called for each command sent, also for commands of replaceable streams,
+ * since the remote side shows at least the newest message of each stream.
+ */
+static void recordDisplayListCommand(uint8_t * aParameterBufferPointer, size_t aParameterBufferLength,
+        uint8_t * aDataBufferPointer, size_t aDataBufferLength) {
+    if (!sDisplayListRecording) {
+        return;
+    }
+    if (sDisplayListReplayLength > 0) {
+        if (isNoCopyQueueEmpty()) {
+            sDisplayListReplayLength = 0;
+        } else if (aParameterBufferPointer[1] == FUNCTION_CLEAR_DISPLAY || aDataBufferLength > 0
+                || RetainedDisplayList.Length < sDisplayListReplayLength) {
+            // the part of the list which is sent by DMA must not be overwritten
+            waitForUSARTNoCopyTransfersComplete();
+            sDisplayListReplayLength = 0;
+        }
+    }
+    appendToDisplayList(&RetainedDisplayList, aParameterBufferPointer, aParameterBufferLength, aDataBufferPointer,
+            aDataBufferLength);
+}
+
+/**
+ * Recording should only be enabled if the page can be restored by sending the same commands again,
+ * i.e. the redraw callback does not depend on the new display size.
+ * Charts are sent plain while recording.
+ */
+void setDisplayListRecording(bool aEnable) {
+    if (sDisplayListReplayLength > 0) {
+        waitForUSARTNoCopyTransfersComplete();
+        sDisplayListReplayLength = 0;
+    }
+    sDisplayListRecording = aEnable;
+    // start with the next FUNCTION_CLEAR_DISPLAY
+    invalidateDisplayList(&RetainedDisplayList);
+}
+
+bool isDisplayListRecording(void) {
+    return sDisplayListRecording;
+}
+
+/**
+ * @return true if the actual page is completely contained in the display list
+ */
+bool isDisplayListReplayable(void) {
+    return (sDisplayListRecording && RetainedDisplayList.Complete && RetainedDisplayList.Length > 0);
+}
+
+/**
+ * Must be called if the page layout may change without a FUNCTION_CLEAR_DISPLAY e.g. on reorientation
+ */
+void discardDisplayList(void) {
+    invalidateDisplayList(&RetainedDisplayList);
+}
+#endif
+
+/**
+ * Copy content of both buffers to send buffer, check for buffer wrap around and call USART_BD_DMA_TX_start() with right parameters.
+ * Do blocking wait if not enough space left in buffer, skip the command if waiting takes longer than SEND_TIMEOUT_MILLIS.
+ * Inside startSendStream() / endSendStream() data is only collected and never blocks.
+ * Commands sent by an ISR are not part of the stream message of the interrupted main loop.
+ */
+void sendUSARTBufferNoSizeCheck(uint8_t * aParameterBufferPointer, size_t aParameterBufferLength,
+        uint8_t * aDataBufferPointer, size_t aDataBufferLength) {
+    TRACE_SCOPE(TRACE_ID_SEND_USART, aParameterBufferLength + aDataBufferLength);
+#ifdef USE_DISPLAY_LIST
+    recordDisplayListCommand(aParameterBufferPointer, aParameterBufferLength, aDataBufferPointer, aDataBufferLength);
+#endif
+#ifdef USE_SIMPLE_SERIAL
+    sendUSARTBufferSimple(aParameterBufferPointer, aParameterBufferLength, aDataBufferPointer, aDataBufferLength);
+    return;
+#else
+    int tSize = aParameterBufferLength + aDataBufferLength;
+    if (sSendStreamIndex != SEND_STREAM_NONE && !IN_INTERRUPT_SERVICE_ROUTINE) {
+        if (sStreamAssemblyLength + tSize > SEND_STREAM_SLOT_SIZE) {
+            sStreamAssemblyOverflow = true;
+            return;
+        }
+        memcpy(&sStreamAssemblyBuffer[sStreamAssemblyLength], aParameterBufferPointer, aParameterBufferLength);
+        sStreamAssemblyLength += aParameterBufferLength;
+        if (aDataBufferLength > 0) {
+            memcpy(&sStreamAssemblyBuffer[sStreamAssemblyLength], aDataBufferPointer, aDataBufferLength);
+            sStreamAssemblyLength += aDataBufferLength;
+        }
+        return;
+    }
+
+    if (aDataBufferLength >= USART_NO_COPY_MIN_LENGTH && isAddressInFlash(aDataBufferPointer) && !IN_INTERRUPT_SERVICE_ROUTINE) {
+        // constant data is valid until transfer complete. The descriptor queue is only written by thread.
+        flushSendStreams();
+        startNoCopyTransfer(aParameterBufferPointer, aParameterBufferLength, aDataBufferPointer, aDataBufferLength);
+        return;
+    }
+    if (!IN_INTERRUPT_SERVICE_ROUTINE) {
+        // slots may be just written by the interrupted main loop
+        flushSendStreams();
+    }
+    resetSendBufferIfEmpty();
+    if (waitForSendBufferFreeSpace(tSize)) {
+        copyToSendBuffer(aParameterBufferPointer, aParameterBufferLength, aDataBufferPointer, aDataBufferLength, true);
+    }
 #endif
 }
 
+/**
+ * Only the parameter buffer is copied to the send buffer. The data buffer is sent directly by DMA
+ * and must not be changed until waitForUSARTNoCopyTransfersComplete() returns.
+ * Do blocking wait if not enough space left in buffer or descriptor queue.
+ */
+void sendUSARTBufferNoCopy(uint8_t * aParameterBufferPointer, size_t aParameterBufferLength, uint8_t * aDataBufferPointer,
+        size_t aDataBufferLength) {
+#ifdef USE_SIMPLE_SERIAL
+    sendUSARTBufferSimple(aParameterBufferPointer, aParameterBufferLength, aDataBufferPointer, aDataBufferLength);
+    return;
+#else
+    if (sSendStreamIndex != SEND_STREAM_NONE || aDataBufferLength == 0 || IN_INTERRUPT_SERVICE_ROUTINE) {
+        // stream messages must be copied anyway and the descriptor queue is only written by thread
+        sendUSARTBufferNoSizeCheck(aParameterBufferPointer, aParameterBufferLength, aDataBufferPointer, aDataBufferLength);
+        return;
+    }
+#ifdef USE_DISPLAY_LIST
+    recordDisplayListCommand(aParameterBufferPointer, aParameterBufferLength, aDataBufferPointer, aDataBufferLength);
+#endif
+    flushSendStreams();
+    startNoCopyTransfer(aParameterBufferPointer, aParameterBufferLength, aDataBufferPointer, aDataBufferLength);
+#endif
+}
+
+#ifndef USE_SIMPLE_SERIAL
+/**
+ * Must not be called by ISR, since it writes sNoCopyQueueIn and may wait for a free descriptor.
+ * Pending stream slots must be flushed by caller before.
+ */
+static void startNoCopyTransfer(uint8_t * aParameterBufferPointer, size_t aParameterBufferLength, uint8_t * aDataBufferPointer,
+        size_t aDataBufferLength) {
+    uint8_t tNextQueueIn = (sNoCopyQueueIn + 1) % USART_NO_COPY_QUEUE_SIZE;
+    if (tNextQueueIn == sNoCopyQueueOut) {
+        // queue full - wait for its oldest entry
+        uint8_t tQueueOut = sNoCopyQueueOut;
+        while (sNoCopyQueueOut == tQueueOut) {
+            if (!sDMATransferOngoing) {
+                startUSARTTransferOfPendingData();
+            }
+            waitForUSARTTransferProgress();
+        }
+    }
+    resetSendBufferIfEmpty();
+    // + 1 since buffer must not be filled completely, because then the insert position can not be distinguished from empty buffer
+    if (!waitForSendBufferFreeSpace(aParameterBufferLength + 1)) {
+        return;
+    }
+    copyToSendBuffer(aParameterBufferPointer, aParameterBufferLength, NULL, 0, false);
+
+    struct USARTNoCopyDescriptor * tDescriptor = &sNoCopyQueue[sNoCopyQueueIn];
+    tDescriptor->InsertPosition = sUSARTSendBufferPointerIn;
+    tDescriptor->Address = aDataBufferPointer;
+    tDescriptor->Length = aDataBufferLength;
+    // the only statement which writes the variable sNoCopyQueueIn
+    sNoCopyQueueIn = tNextQueueIn;
+
+    if (isSendDataToBeSent() || aDataBufferLength >= SEND_FRAME_FLUSH_THRESHOLD) {
+        startUSARTTransferOfPendingData();
+    }
+}
+#endif
+
+#ifdef USE_DISPLAY_LIST
+/**
+ * Sends the commands of the actual page with one DMA transfer directly from the display list.
+ * Registered strings must be registered again before, if the remote side lost its table.
+ * @return false if the list does not contain a complete page and the page must be drawn by the application
+ */
+bool replayDisplayList(void) {
+    if (!isDisplayListReplayable()) {
+        return false;
+    }
+#ifdef USE_SIMPLE_SERIAL
+    sendUSARTBufferSimple(NULL, 0, RetainedDisplayList.Data, RetainedDisplayList.Length);
+#else
+    // the list contains the newest message of each stream
+    discardSendStreams();
+    sDisplayListReplayLength = RetainedDisplayList.Length;
+    startNoCopyTransfer(NULL, 0, RetainedDisplayList.Data, RetainedDisplayList.Length);
+#endif
+    return true;
+}
+#endif
+
+/**
+ * Blocking wait until all data buffers given to sendUSARTBufferNoCopy() are sent
+ */
+void waitForUSARTNoCopyTransfersComplete(void) {
+    while (!isNoCopyQueueEmpty()) {
+        if (!sDMATransferOngoing) {
+            startUSARTTransferOfPendingData();
+        }
+        waitForUSARTTransferProgress();
+    }
+}
+
 #include <stdlib.h> // for abs()
 /**
  * used if databuffer can be greater than USART_SEND_BUFFER_SIZE
+ * Large data buffers are sent directly by DMA and the function returns after the data is sent.
  */
 void sendUSARTBuffer(uint8_t * aParameterBufferPointer, size_t aParameterBufferLength, uint8_t * aDataBufferPointer,
         size_t aDataBufferLength) {
@@ -444,20 +918,10 @@ void sendUSARTBuffer(uint8_t * aParameterBufferPointer, size_t aParameterBufferL
     sendUSARTBufferSimple(aParameterBufferPointer, aParameterBufferLength, aDataBufferPointer, aDataBufferLength);
     return;
 #else
-    if ((aParameterBufferLength + aDataBufferLength) > UART_SEND_BUFFER_SIZE) {
-        // first send command
-        sendUSARTBufferNoSizeCheck(aParameterBufferPointer, aParameterBufferLength, NULL, 0);
-        // then send data in USART_SEND_BUFFER_SIZE chunks
-        int tSize = aDataBufferLength;
-        while (tSize > 0) {
-            int tSendSize = UART_SEND_BUFFER_SIZE;
-            if (tSize < UART_SEND_BUFFER_SIZE) {
-                tSendSize = tSize;
-            }
-            sendUSARTBufferNoSizeCheck(aDataBufferPointer, tSendSize, NULL, 0);
-            aDataBufferPointer += UART_SEND_BUFFER_SIZE;
-            tSize -= UART_SEND_BUFFER_SIZE;
-        }
+    if ((aParameterBufferLength + aDataBufferLength) > UART_SEND_BUFFER_SIZE && sSendStreamIndex == SEND_STREAM_NONE) {
+        sendUSARTBufferNoCopy(aParameterBufferPointer, aParameterBufferLength, aDataBufferPointer, aDataBufferLength);
+        // data buffer is only valid until return
+        waitForUSARTNoCopyTransfersComplete();
     } else {
         sendUSARTBufferNoSizeCheck(aParameterBufferPointer, aParameterBufferLength, aDataBufferPointer,
                 aDataBufferLength);
@@ -465,7 +929,7 @@ void sendUSARTBuffer(uint8_t * aParameterBufferPointer, size_t aParameterBufferL
 #endif
 }
 
-#ifdef USE_SIMPLE_SERIAL
+#if defined(USE_SIMPLE_SERIAL) && !defined(HOST_SIMULATION)
 /**
  * very simple blocking USART send routine - works 100%!
  */
@@ -576,7 +1040,7 @@ void sendUSARTArgsAndByteBuffer(uint8_t aFunctionTag, int aNumberOfArgs, ...) {
     *tBufferPointer++ = DATAFIELD_TAG_BYTE << 8 | SYNC_TOKEN; // start new transmission block
     uint16_t tLength = va_arg(argp, int); // length in byte
     *tBufferPointer++ = tLength;
-    uint8_t * aBufferPtr = (uint8_t *) va_arg(argp, int); // Buffer address
+    uint8_t * aBufferPtr = va_arg(argp, uint8_t *); // Buffer address
     va_end(argp);
 
     sendUSARTBufferNoSizeCheck((uint8_t*) &tParamBuffer[0], aNumberOfArgs * 2 + 8, aBufferPtr, tLength);
@@ -678,6 +1142,7 @@ uint8_t getReceiveBufferByte(void) {
     return tResult;
 }
 
+#ifndef HOST_SIMULATION
 /*
  * computes received bytes since LastRXDMACount
  */
@@ -690,73 +1155,386 @@ int32_t getReceiveBytesAvailable(void) {
         return sLastRXDMACount + (USART_RECEIVE_BUFFER_SIZE - tCount);
     }
 }
+#endif
 
-/**
- * Check if a touch event has completely received by USART
- * Function is not synchronized because it should only be used by main thread
+/*
+ * Received events are parsed in blocks from the circular DMA receive buffer
+ * and complete events are put into a FIFO, which is emptied by checkAndHandleMessageReceived().
+ * Parsing is also done during blocking waits of the send functions, so that a busy main loop
+ * does not lose events by an overrun of the small receive buffer.
  */
-static uint8_t sReceivedEventType = EVENT_NO_EVENT;
+#define RECEIVE_STATE_LENGTH 0
+#define RECEIVE_STATE_EVENT_TYPE 1
+#define RECEIVE_STATE_DATA 2
+#define RECEIVE_STATE_SYNC 3
+static uint8_t sReceiveState = RECEIVE_STATE_LENGTH;
 static uint8_t sReceivedDataSize;
+static uint8_t sReceivedDataIndex;
+static struct BluetoothEvent sReceiveAssemblyEvent;
 
-void checkAndHandleMessageReceived(void) {
-// get actual DMA byte count
-    int32_t tBytesAvailable = getReceiveBytesAvailable();
-    if (tBytesAvailable == 0) {
+static struct BluetoothEvent sReceivedEventQueue[RECEIVE_EVENT_QUEUE_SIZE];
+static uint8_t sReceivedEventQueueIn = 0;
+static uint8_t sReceivedEventQueueOut = 0;
+struct ReceiveStatistics ReceiveStatistics;
+
+void resetReceiveStatistics(void) {
+    memset(&ReceiveStatistics, 0, sizeof(ReceiveStatistics));
+}
+
+static inline bool isReceivedEventQueueFull(void) {
+    return ((sReceivedEventQueueIn + 1) % RECEIVE_EVENT_QUEUE_SIZE == sReceivedEventQueueOut);
+}
+
+static void putReceivedEventInQueue(void) {
+    ReceiveStatistics.Events++;
+    if (isReceivedEventQueueFull()) {
+        // drop newest event
+        ReceiveStatistics.Overflows++;
         return;
     }
-    if (sReceiveBufferOutOfSync) {
-        while (tBytesAvailable-- > 0) {
+    sReceivedEventQueue[sReceivedEventQueueIn] = sReceiveAssemblyEvent;
+    sReceivedEventQueueIn = (sReceivedEventQueueIn + 1) % RECEIVE_EVENT_QUEUE_SIZE;
+    uint8_t tQueueLength = (sReceivedEventQueueIn + RECEIVE_EVENT_QUEUE_SIZE - sReceivedEventQueueOut)
+            % RECEIVE_EVENT_QUEUE_SIZE;
+    if (ReceiveStatistics.MaxQueueLength < tQueueLength) {
+        ReceiveStatistics.MaxQueueLength = tQueueLength;
+    }
+}
+
+/**
+ * Runs the parser over a contiguous block of received bytes
+ * @param aStopIfQueueFull - if true, parsing stops before a new message if the event queue is full
+ * @return number of bytes processed
+ */
+static int32_t parseReceivedBlock(const uint8_t * aBlock, int32_t aLength, bool aStopIfQueueFull) {
+    const uint8_t * tBlockStart = aBlock;
+    const uint8_t * tBlockEnd = aBlock + aLength;
+    while (aBlock < tBlockEnd) {
+        if (sReceiveBufferOutOfSync) {
             // just wait for next sync token
-            if (getReceiveBufferByte() == SYNC_TOKEN) {
-                sReceiveBufferOutOfSync = false;
-                sReceivedEventType = EVENT_NO_EVENT;
+            const uint8_t * tSyncPosition = (const uint8_t *) memchr(aBlock, SYNC_TOKEN, tBlockEnd - aBlock);
+            if (tSyncPosition == NULL) {
+                return aLength;
+            }
+            aBlock = tSyncPosition + 1;
+            sReceiveBufferOutOfSync = false;
+            sReceiveState = RECEIVE_STATE_LENGTH;
+            continue;
+        }
+        switch (sReceiveState) {
+        case RECEIVE_STATE_LENGTH:
+            if (aStopIfQueueFull && isReceivedEventQueueFull()) {
+                return aBlock - tBlockStart;
+            }
+            // First byte is raw length so subtract 3 for sync+eventType+length bytes
+            sReceivedDataSize = *aBlock++ - 3;
+            if (sReceivedDataSize > RECEIVE_MAX_DATA_SIZE) {
+                // invalid length
+                ReceiveStatistics.SyncErrors++;
+                sReceiveBufferOutOfSync = true;
                 break;
             }
+            sReceiveState = RECEIVE_STATE_EVENT_TYPE;
+            break;
+        case RECEIVE_STATE_EVENT_TYPE:
+            sReceiveAssemblyEvent.EventType = *aBlock++;
+            sReceivedDataIndex = 0;
+            sReceiveState = (sReceivedDataSize > 0) ? RECEIVE_STATE_DATA : RECEIVE_STATE_SYNC;
+            break;
+        case RECEIVE_STATE_DATA: {
+            // copy as much data as available in this block
+            uint8_t tCount = sReceivedDataSize - sReceivedDataIndex;
+            if (tCount > tBlockEnd - aBlock) {
+                tCount = tBlockEnd - aBlock;
+            }
+            memcpy(&sReceiveAssemblyEvent.EventData.ByteArray[sReceivedDataIndex], aBlock, tCount);
+            aBlock += tCount;
+            sReceivedDataIndex += tCount;
+            if (sReceivedDataIndex == sReceivedDataSize) {
+                sReceiveState = RECEIVE_STATE_SYNC;
+            }
+            break;
         }
-    }
-    if (!sReceiveBufferOutOfSync) {
-        /*
-         * regular operation here
-         * enough bytes available for next step?
-         */
-        if (sReceivedEventType == EVENT_NO_EVENT) {
-            if (tBytesAvailable >= 2) {
-                /*
-                 * read message length and event tag first
-                 */
-                // First byte is raw length so subtract 3 for sync+eventType+length bytes
-                sReceivedDataSize = getReceiveBufferByte() - 3;
-                if (sReceivedDataSize > RECEIVE_MAX_DATA_SIZE) {
-                    // invalid length
-                    sReceiveBufferOutOfSync = true;
-                    return;
-                }
-                sReceivedEventType = getReceiveBufferByte();
-                tBytesAvailable -= 2;
+        default: // RECEIVE_STATE_SYNC
+            if (*aBlock++ == SYNC_TOKEN) {
+                putReceivedEventInQueue();
+            } else {
+                ReceiveStatistics.SyncErrors++;
+                sReceiveBufferOutOfSync = true;
             }
+            sReceiveState = RECEIVE_STATE_LENGTH;
+            break;
         }
-        if (sReceivedEventType != EVENT_NO_EVENT) {
-            if (tBytesAvailable > sReceivedDataSize) {
-                // touch or size event complete received, now read data and sync token
-                // copy buffer to structure
-                unsigned char * tByteArrayPtr = remoteEvent.EventData.ByteArray;
-                int i;
-                for (i = 0; i < sReceivedDataSize; ++i) {
-                    *tByteArrayPtr++ = getReceiveBufferByte();
-                }
-                // Check for sync token
-                if (getReceiveBufferByte() == SYNC_TOKEN) {
-                    remoteEvent.EventType = sReceivedEventType;
-                    sReceivedEventType = EVENT_NO_EVENT;
-                    handleEvent(&remoteEvent);
-                } else {
-                    sReceiveBufferOutOfSync = true;
-                }
+    }
+    return aLength;
+}
+
+/**
+ * Parses the bytes received since last call and puts complete events into the event queue.
+ * @return true if parsing stopped because the event queue is full
+ */
+static bool parseReceivedBytes(bool aStopIfQueueFull) {
+    int32_t tBytesAvailable = getReceiveBytesAvailable();
+    while (tBytesAvailable > 0) {
+        // process up to the end of the circular buffer at once
+        int32_t tBlockLength = &USARTReceiveBuffer[USART_RECEIVE_BUFFER_SIZE] - sUSARTReceiveBufferPointer;
+        if (tBlockLength > tBytesAvailable) {
+            tBlockLength = tBytesAvailable;
+        }
+        int32_t tProcessedLength = parseReceivedBlock(sUSARTReceiveBufferPointer, tBlockLength, aStopIfQueueFull);
+        // mark bytes as processed
+        memset(sUSARTReceiveBufferPointer, 0, tProcessedLength);
+        sUSARTReceiveBufferPointer += tProcessedLength;
+        if (sUSARTReceiveBufferPointer >= &USARTReceiveBuffer[USART_RECEIVE_BUFFER_SIZE]) {
+            sUSARTReceiveBufferPointer = &USARTReceiveBuffer[0];
+        }
+        sLastRXDMACount -= tProcessedLength;
+        if (sLastRXDMACount <= 0) {
+            sLastRXDMACount += USART_RECEIVE_BUFFER_SIZE;
+        }
+        if (tProcessedLength < tBlockLength) {
+            return true;
+        }
+        tBytesAvailable -= tBlockLength;
+    }
+    return false;
+}
+
+/**
+ * Puts received events into the event queue without handling them.
+ * Called during blocking waits of the send functions. If the queue is full, new events are dropped and counted.
+ * Function is not synchronized because it should only be used by main thread.
+ */
+void receiveUSARTEvents(void) {
+    parseReceivedBytes(false);
+}
+
+/**
+ * @return true if received bytes or events are not yet handled by checkAndHandleMessageReceived()
+ */
+bool isReceivedDataPending(void) {
+    return (sReceivedEventQueueOut != sReceivedEventQueueIn || getReceiveBytesAvailable() > 0);
+}
+
+/**
+ * Receives new events and calls handleEvent() for all queued events in the order of reception.
+ * Handlers may call this function recursively, e.g. by delayMillisWithCheckAndHandleEvents().
+ * Function is not synchronized because it should only be used by main thread
+ */
+void checkAndHandleMessageReceived(void) {
+    bool tQueueWasFull;
+    do {
+        tQueueWasFull = parseReceivedBytes(true);
+        while (sReceivedEventQueueOut != sReceivedEventQueueIn) {
+            remoteEvent = sReceivedEventQueue[sReceivedEventQueueOut];
+            sReceivedEventQueueOut = (sReceivedEventQueueOut + 1) % RECEIVE_EVENT_QUEUE_SIZE;
+            handleEvent(&remoteEvent);
+        }
+    } while (tQueueWasFull);
+}
+
+/*
+ * Baud rate negotiation
+ *
+ * The baud rate is stepped up as long as the remote side accepts the proposed rate
+ * and the test patterns sent with the new rate are received without error by both sides.
+ * 1. FUNCTION_BAUD_NEGOTIATION SUBFUNCTION_BAUD_PROPOSE is sent with the old baud rate.
+ *    The remote side answers with the old rate and switches to the new one.
+ * 2. BAUD_TEST_PATTERN_REPEATS * FUNCTION_BAUD_TEST_PATTERN are sent with the new rate. The CRC of each is answered.
+ * 3. SUBFUNCTION_BAUD_CONFIRM is sent and answered with the new rate.
+ * If an answer is missing or wrong, both sides fall back to the old baud rate, the remote side by timeout.
+ * The HC-05 can not change its baud rate in data mode, so with it the first step always falls back.
+ */
+struct BaudNegotiationStatistics BaudNegotiationStatistics;
+
+static const uint32_t sNegotiationBaudRates[] = { BAUD_115200, BAUD_230400, BAUD_460800, BAUD_921600, BAUD_1382400 };
+static struct BaudNegotiationInfo sBaudNegotiationAnswer; // the last answer received
+static uint8_t sBaudNegotiationAnswerCount;
+static bool sBaudNegotiationRemoteAnswered; // remote side supports negotiation
+static bool sBaudTestPatternError;
+static uint16_t sBaudTestPatternCRC;
+
+/**
+ * CRC-16/CCITT with polynomial 0x1021 and start value 0xFFFF
+ */
+uint16_t computeCRC16CCITT(const uint8_t * aData, size_t aLength) {
+    uint16_t tCRC = 0xFFFF;
+    while (aLength-- > 0) {
+        tCRC ^= (uint16_t) (*aData++) << 8;
+        for (uint8_t i = 0; i < 8; ++i) {
+            if (tCRC & 0x8000) {
+                tCRC = (tCRC << 1) ^ 0x1021;
+            } else {
+                tCRC <<= 1;
             }
         }
     }
+    return tCRC;
+}
+
+/**
+ * All 256 byte values in mixed order, including the sync token and alternating bit patterns
+ * @param aBuffer must have BAUD_TEST_PATTERN_LENGTH bytes
+ */
+void fillBaudTestPattern(uint8_t * aBuffer) {
+    for (int i = 0; i < BAUD_TEST_PATTERN_LENGTH; ++i) {
+        // 167 is odd, so the values are a permutation of 0 to 255
+        aBuffer[i] = i * 167;
+    }
+}
+
+/**
+ * Called by handleEvent() for EVENT_BAUD_NEGOTIATION
+ */
+void handleBaudNegotiationEvent(struct BaudNegotiationInfo * aBaudNegotiationInfo) {
+    if (aBaudNegotiationInfo->SubFunction == SUBFUNCTION_BAUD_TEST_PATTERN
+            && (aBaudNegotiationInfo->Value != sBaudTestPatternCRC
+                    || aBaudNegotiationInfo->BaudRate != BAUD_TEST_PATTERN_LENGTH)) {
+        sBaudTestPatternError = true;
+    }
+    sBaudNegotiationAnswer = *aBaudNegotiationInfo;
+    sBaudNegotiationAnswerCount++;
+    sBaudNegotiationRemoteAnswered = true;
+}
+
+/**
+ * Blocking wait until all data including no copy payloads is sent
+ */
+void waitForUSARTSendComplete(void) {
+    while (sDMATransferOngoing || isSendDataPending()) {
+        if (!sDMATransferOngoing) {
+            // chain stops inside a frame
+            startUSARTTransferOfPendingData();
+        }
+        waitForUSARTTransferProgress();
+    }
+}
+
+/**
+ * Handles received messages until aNumberOfAnswers answers are received
+ * @return false on timeout or if the last answer does not belong to aSubFunction
+ */
+static bool waitForBaudNegotiationAnswers(uint8_t aNumberOfAnswers, uint16_t aSubFunction, uint32_t aTimeoutMillis) {
+    uint32_t tStartMillis = getMillisSinceBoot();
+    while (sBaudNegotiationAnswerCount < aNumberOfAnswers) {
+        if (getMillisSinceBoot() - tStartMillis > aTimeoutMillis) {
+            return false;
+        }
+#ifdef HAL_WWDG_MODULE_ENABLED
+        Watchdog_reload();
+#endif
+        checkAndHandleMessageReceived();
+    }
+    return (sBaudNegotiationAnswer.SubFunction == aSubFunction);
+}
+
+/**
+ * Sends BAUD_TEST_PATTERN_REPEATS test patterns with the actual baud rate and checks the CRCs answered by the remote side.
+ * @return effective throughput in bytes per second for the round trip of all patterns or 0 if an error occurred
+ */
+uint32_t measureUSARTThroughput(void) {
+    uint8_t tPattern[BAUD_TEST_PATTERN_LENGTH];
+    fillBaudTestPattern(tPattern);
+    sBaudTestPatternCRC = computeCRC16CCITT(tPattern, BAUD_TEST_PATTERN_LENGTH);
+    uint32_t tTimeoutMillis = BAUD_NEGOTIATION_ANSWER_TIMEOUT_MILLIS
+            + (BAUD_TEST_PATTERN_LENGTH * BAUD_TEST_PATTERN_REPEATS * 10 * 1000) / getUSART_BD_BaudRate();
+
+    waitForUSARTSendComplete();
+    sBaudNegotiationAnswerCount = 0;
+    sBaudTestPatternError = false;
+    uint32_t tStartMillis = getMillisSinceBoot();
+    for (int i = 0; i < BAUD_TEST_PATTERN_REPEATS; ++i) {
+        sendUSARTCommandAndByteBuffer<FUNCTION_BAUD_TEST_PATTERN>(tPattern, BAUD_TEST_PATTERN_LENGTH);
+    }
+    // answers are kept in receive buffer meanwhile
+    waitForUSARTSendComplete();
+    if (!waitForBaudNegotiationAnswers(BAUD_TEST_PATTERN_REPEATS, SUBFUNCTION_BAUD_TEST_PATTERN, tTimeoutMillis)
+            || sBaudTestPatternError) {
+        return 0;
+    }
+    uint32_t tMillis = getMillisSinceBoot() - tStartMillis;
+    if (tMillis == 0) {
+        tMillis = 1;
+    }
+    return (BAUD_TEST_PATTERN_LENGTH * BAUD_TEST_PATTERN_REPEATS * 1000) / tMillis;
+}
+
+/**
+ * Switches both sides to aBaudRate if the remote side accepts it and the test patterns are transferred without error
+ * @return false if baud rate is unchanged
+ */
+static bool tryUSARTBaudRate(uint32_t aBaudRate) {
+    uint32_t tOldBaudRate = getUSART_BD_BaudRate();
+    waitForUSARTSendComplete();
+    sBaudNegotiationAnswerCount = 0;
+    sendUSARTCommand<FUNCTION_BAUD_NEGOTIATION>((uint16_t) SUBFUNCTION_BAUD_PROPOSE, (uint16_t) (aBaudRate & 0xFFFF),
+            (uint16_t) (aBaudRate >> 16));
+    if (!waitForBaudNegotiationAnswers(1, SUBFUNCTION_BAUD_PROPOSE, BAUD_NEGOTIATION_ANSWER_TIMEOUT_MILLIS)) {
+        return false;
+    }
+    if (sBaudNegotiationAnswer.Value == 0 || sBaudNegotiationAnswer.BaudRate != aBaudRate) {
+        BaudNegotiationStatistics.Rejected++;
+        return false;
+    }
+
+    uint32_t tSwitchMillis = getMillisSinceBoot();
+    delayMillis(BAUD_NEGOTIATION_SETTLE_MILLIS);
+    setUART_BD_BaudRate(aBaudRate);
+    if (measureUSARTThroughput() > 0) {
+        sBaudNegotiationAnswerCount = 0;
+        sendUSARTCommand<FUNCTION_BAUD_NEGOTIATION>((uint16_t) SUBFUNCTION_BAUD_CONFIRM);
+        if (waitForBaudNegotiationAnswers(1, SUBFUNCTION_BAUD_CONFIRM, BAUD_NEGOTIATION_ANSWER_TIMEOUT_MILLIS)) {
+            return true;
+        }
+    }
+
+    /*
+     * Fall back and wait for the remote side to do the same
+     */
+    BaudNegotiationStatistics.Fallbacks++;
+    waitForUSARTSendComplete();
+    setUART_BD_BaudRate(tOldBaudRate);
+    while (getMillisSinceBoot() - tSwitchMillis < BAUD_NEGOTIATION_REVERT_MILLIS + BAUD_NEGOTIATION_ANSWER_TIMEOUT_MILLIS) {
+#ifdef HAL_WWDG_MODULE_ENABLED
+        Watchdog_reload();
+#endif
+        // discard data received with the wrong baud rate
+        checkAndHandleMessageReceived();
+    }
+    return false;
+}
+
+/**
+ * Steps the baud rate up to the highest rate which is supported by both sides and works without errors.
+ * Blocks for some 100 milliseconds and up to one second for each fallback.
+ * Updates BaudNegotiationStatistics including the effective throughput of the resulting baud rate.
+ * @param aMaxBaudRate e.g. BAUD_NEGOTIATION_MAX_BAUD_RATE
+ * @return the resulting baud rate
+ */
+uint32_t negotiateUSARTBaudRate(uint32_t aMaxBaudRate) {
+    memset(&BaudNegotiationStatistics, 0, sizeof(BaudNegotiationStatistics));
+    sBaudNegotiationRemoteAnswered = false;
+    for (unsigned int i = 0; i < sizeof(sNegotiationBaudRates) / sizeof(sNegotiationBaudRates[0]); ++i) {
+        uint32_t tBaudRate = sNegotiationBaudRates[i];
+        if (tBaudRate <= getUSART_BD_BaudRate()) {
+            continue;
+        }
+        if (tBaudRate > aMaxBaudRate) {
+            break;
+        }
+        if (!tryUSARTBaudRate(tBaudRate)) {
+            break;
+        }
+    }
+    BaudNegotiationStatistics.BaudRate = getUSART_BD_BaudRate();
+    if (sBaudNegotiationRemoteAnswered) {
+        // a remote side not supporting negotiation would not answer the test pattern
+        BaudNegotiationStatistics.BytesPerSecond = measureUSARTThroughput();
+    }
+    return BaudNegotiationStatistics.BaudRate;
 }
 
+#ifndef HOST_SIMULATION
 /*
  * NOT USED YET - maybe useful for Error Interrupt IT_TE2
  */
@@ -781,4 +1559,4 @@ extern "C" void DMA1_Channel2_IRQHandler(void) {
         //DMA_ClearITPendingBit(DMA1_IT_HT2);
     }
 }
-
+#endif // HOST_SIMULATION
@@ -0,0 +1,188 @@
+/*
+ * BlueSerial_Host.cpp
+ *
+ * Host (x86 Linux) implementation of the UART and DMA functions of BlueSerial.cpp.
+ * The send buffer handling of BlueSerial.cpp is used unchanged.
+ * Each DMA transfer is passed to HostLinkWriteCallback and occupies the simulated line
+ * for 10 bit times per byte plus HostLinkTransferOverheadNanos.
+ * Received data is injected with hostReceiveBytes() which emulates the circular RX DMA,
+ * either directly or by HostLinkReadCallback, which is called when the receive buffer is checked.
+ *
+ * Only compiled if HOST_SIMULATION is defined.
+ *
+ *  This file is part of BlueDisplay.
+ *  BlueDisplay is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/gpl.html>.
+ *
+ */
+
+#ifdef HOST_SIMULATION
+
+#include "BlueSerial.h"
+#include "BlueDisplay.h"
+
+#include <string.h> // for memset
+
+extern uint8_t * sUSARTSendBufferPointerIn;
+extern volatile uint8_t * sUSARTSendBufferPointerOut;
+extern uint8_t USARTSendBuffer[UART_SEND_BUFFER_SIZE];
+extern volatile bool sDMATransferOngoing;
+extern volatile uint8_t sNoCopyQueueIn;
+extern volatile uint8_t sNoCopyQueueOut;
+extern volatile bool sNoCopyTransferOngoing;
+
+extern uint8_t USARTReceiveBuffer[USART_RECEIVE_BUFFER_SIZE];
+extern uint8_t * sUSARTReceiveBufferPointer;
+extern int32_t sLastRXDMACount;
+
+bool HostBluetoothPaired = false; // only local display by default
+struct HostLinkCounter HostLinkCounters;
+uint64_t HostLinkNanos = 0;
+// USART TC ISR plus DMA setup on the F303 and the resulting gap on the line
+uint32_t HostLinkTransferOverheadNanos = 2000;
+void (*HostLinkWriteCallback)(const uint8_t * aData, size_t aLength) = NULL;
+void (*HostLinkReadCallback)(void) = NULL;
+
+static uint32_t sHostBaudRate = BAUD_115200;
+static uint64_t sTransferEndNanos = 0; // simulated time of transfer complete interrupt
+static int32_t sHostRXDMACount = USART_RECEIVE_BUFFER_SIZE; // emulates CNDTR of RX channel
+
+void UART_BD_initialize(uint32_t aBaudRate) {
+    sHostBaudRate = aBaudRate;
+    sUSARTSendBufferPointerIn = &USARTSendBuffer[0];
+    sUSARTSendBufferPointerOut = &USARTSendBuffer[0];
+    sDMATransferOngoing = false;
+    sNoCopyQueueIn = 0;
+    sNoCopyQueueOut = 0;
+    sNoCopyTransferOngoing = false;
+
+    sUSARTReceiveBufferPointer = &USARTReceiveBuffer[0];
+    sLastRXDMACount = USART_RECEIVE_BUFFER_SIZE;
+    sHostRXDMACount = USART_RECEIVE_BUFFER_SIZE;
+    memset(USARTReceiveBuffer, 0, USART_RECEIVE_BUFFER_SIZE);
+}
+
+void setUART_BD_BaudRate(uint32_t aBaudRate) {
+    sHostBaudRate = aBaudRate;
+}
+
+uint32_t getUSART_BD_BaudRate(void) {
+    return sHostBaudRate;
+}
+
+void UART_BD_DMA_TX_start(uint8_t * aMemoryBaseAddr, uint32_t aBufferSize) {
+    if (sDMATransferOngoing) {
+        return; // not allowed to start a new transfer, because DMA is busy
+    }
+    sDMATransferOngoing = true;
+
+    if (HostLinkWriteCallback != NULL) {
+        HostLinkWriteCallback(aMemoryBaseAddr, aBufferSize);
+    }
+    uint64_t tTransferNanos = ((uint64_t) aBufferSize * 10 * 1000000000) / sHostBaudRate + HostLinkTransferOverheadNanos;
+    if (sTransferEndNanos < HostLinkNanos) {
+        sTransferEndNanos = HostLinkNanos;
+    }
+    sTransferEndNanos += tTransferNanos;
+    HostLinkCounters.Transfers++;
+    HostLinkCounters.Bytes += aBufferSize;
+    HostLinkCounters.BusyNanos += tTransferNanos;
+}
+
+/*
+ * Calls the transfer complete "ISR" for all transfers ending until actual simulated time
+ */
+static void processTransferComplete(void) {
+    while (sDMATransferOngoing && sTransferEndNanos <= HostLinkNanos) {
+        chainUSARTTransfer();
+    }
+}
+
+void hostAdvanceLinkTime(uint32_t aNanos) {
+    HostLinkNanos += aNanos;
+    processTransferComplete();
+}
+
+/**
+ * Called by sendUSARTBufferNoSizeCheck() while blocking for free buffer space
+ */
+void hostWaitForUSARTTransferComplete(void) {
+    HostLinkCounters.BlockingWaits++;
+    if (sDMATransferOngoing && HostLinkNanos < sTransferEndNanos) {
+        if (HostLinkReadCallback == NULL) {
+            HostLinkNanos = sTransferEndNanos;
+        } else {
+            // remote side sends concurrently, so poll the receive buffer like the busy wait loop does
+            while (HostLinkNanos < sTransferEndNanos) {
+                HostLinkNanos += HOST_RECEIVE_POLL_NANOS;
+                if (HostLinkNanos > sTransferEndNanos) {
+                    HostLinkNanos = sTransferEndNanos;
+                }
+                receiveUSARTEvents();
+            }
+        }
+    }
+    processTransferComplete();
+}
+
+/**
+ * Advance time until all data is sent
+ */
+void hostFlushLink(void) {
+    while (sDMATransferOngoing) {
+        if (HostLinkNanos < sTransferEndNanos) {
+            HostLinkNanos = sTransferEndNanos;
+        }
+        processTransferComplete();
+    }
+}
+
+/**
+ * Resets counters and simulated time. Link must be idle.
+ */
+void hostResetLinkCounters(void) {
+    memset(&HostLinkCounters, 0, sizeof(HostLinkCounters));
+    HostLinkNanos = 0;
+    sTransferEndNanos = 0;
+}
+
+/**
+ * Write data to receive buffer like the circular RX DMA does
+ */
+void hostReceiveBytes(const uint8_t * aData, size_t aLength) {
+    while (aLength-- > 0) {
+        USARTReceiveBuffer[USART_RECEIVE_BUFFER_SIZE - sHostRXDMACount] = *aData++;
+        sHostRXDMACount--;
+        if (sHostRXDMACount == 0) {
+            sHostRXDMACount = USART_RECEIVE_BUFFER_SIZE;
+        }
+    }
+}
+
+/*
+ * computes received bytes since LastRXDMACount
+ */
+int32_t getReceiveBytesAvailable(void) {
+    if (HostLinkReadCallback != NULL) {
+        HostLinkReadCallback();
+    }
+    int32_t tCount = sHostRXDMACount;
+    if (tCount <= sLastRXDMACount) {
+        return sLastRXDMACount - tCount;
+    } else {
+        // DMA wrap around
+        return sLastRXDMACount + (USART_RECEIVE_BUFFER_SIZE - tCount);
+    }
+}
+
+#endif // HOST_SIMULATION
@@ -0,0 +1,195 @@
+/*
+ * ChartDelta.cpp
+ *
+ * Encoder and decoder for FUNCTION_DRAW_CHART_DELTA. See ChartDelta.h for the format.
+ * The decoder is used by the host tools and serves as reference for the remote side.
+ *
+ *  This file is part of BlueDisplay.
+ *  BlueDisplay is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/gpl.html>.
+ *
+ */
+
+#include "ChartDelta.h"
+
+static inline bool fitsNibble(const uint8_t * aReference, const uint8_t * aNewData, size_t aIndex) {
+    int tDelta = (int) aNewData[aIndex] - (int) aReference[aIndex];
+    return (tDelta >= -8 && tDelta <= 7);
+}
+
+static size_t getUnchangedRunLength(const uint8_t * aReference, const uint8_t * aNewData, size_t aIndex, size_t aLength) {
+    size_t tCount = 0;
+    while (aIndex + tCount < aLength && tCount < CHART_DELTA_MAX_GROUP_LENGTH
+            && aNewData[aIndex + tCount] == aReference[aIndex + tCount]) {
+        tCount++;
+    }
+    return tCount;
+}
+
+static size_t getRepeatRunLength(const uint8_t * aNewData, size_t aIndex, size_t aLength) {
+    size_t tCount = 1;
+    while (aIndex + tCount < aLength && tCount < CHART_DELTA_MAX_GROUP_LENGTH
+            && aNewData[aIndex + tCount] == aNewData[aIndex]) {
+        tCount++;
+    }
+    return tCount;
+}
+
+/*
+ * A skip group pays off from 3 unchanged columns on, a repeat group from 4 equal values on
+ */
+static bool isStartOfRun(const uint8_t * aReference, const uint8_t * aNewData, size_t aIndex, size_t aLength) {
+    if (aIndex + 3 <= aLength && aNewData[aIndex] == aReference[aIndex] && aNewData[aIndex + 1] == aReference[aIndex + 1]
+            && aNewData[aIndex + 2] == aReference[aIndex + 2]) {
+        return true;
+    }
+    return (aIndex + 4 <= aLength && aNewData[aIndex + 1] == aNewData[aIndex] && aNewData[aIndex + 2] == aNewData[aIndex]
+            && aNewData[aIndex + 3] == aNewData[aIndex]);
+}
+
+/**
+ * Encodes aNewData against aReference.
+ * @return length of encoded data or 0 if encoded data does not fit in aEncodedBufferSize.
+ *         Use plain transfer in this case.
+ */
+size_t encodeChartDelta(const uint8_t * aReference, const uint8_t * aNewData, size_t aLength, uint8_t * aEncodedBuffer,
+        size_t aEncodedBufferSize) {
+    size_t tIndex = 0;
+    size_t tOut = 0;
+    while (tIndex < aLength) {
+        size_t tCount = getUnchangedRunLength(aReference, aNewData, tIndex, aLength);
+        if (tCount >= 3 || (tCount > 0 && tIndex + tCount == aLength)) {
+            if (tOut + 1 > aEncodedBufferSize) {
+                return 0;
+            }
+            aEncodedBuffer[tOut++] = CHART_DELTA_OP_SKIP | (tCount - 1);
+            tIndex += tCount;
+            continue;
+        }
+
+        tCount = getRepeatRunLength(aNewData, tIndex, aLength);
+        if (tCount >= 4) {
+            if (tOut + 2 > aEncodedBufferSize) {
+                return 0;
+            }
+            aEncodedBuffer[tOut++] = CHART_DELTA_OP_REPEAT | (tCount - 1);
+            aEncodedBuffer[tOut++] = aNewData[tIndex];
+            tIndex += tCount;
+            continue;
+        }
+
+        if (fitsNibble(aReference, aNewData, tIndex)) {
+            tCount = 1;
+            while (tIndex + tCount < aLength && tCount < CHART_DELTA_MAX_GROUP_LENGTH
+                    && fitsNibble(aReference, aNewData, tIndex + tCount)
+                    && !isStartOfRun(aReference, aNewData, tIndex + tCount, aLength)) {
+                tCount++;
+            }
+            if (tOut + 1 + (tCount + 1) / 2 > aEncodedBufferSize) {
+                return 0;
+            }
+            aEncodedBuffer[tOut++] = CHART_DELTA_OP_NIBBLES | (tCount - 1);
+            for (size_t i = 0; i < tCount; ++i) {
+                uint8_t tNibble = (aNewData[tIndex + i] - aReference[tIndex + i]) & 0x0F;
+                if ((i & 0x01) == 0) {
+                    aEncodedBuffer[tOut] = tNibble << 4;
+                } else {
+                    aEncodedBuffer[tOut++] |= tNibble;
+                }
+            }
+            if (tCount & 0x01) {
+                tOut++;
+            }
+            tIndex += tCount;
+            continue;
+        }
+
+        /*
+         * Literal group. Ends if a run starts or at least 2 consecutive columns can be coded as nibbles.
+         */
+        tCount = 1;
+        while (tIndex + tCount < aLength && tCount < CHART_DELTA_MAX_GROUP_LENGTH
+                && !isStartOfRun(aReference, aNewData, tIndex + tCount, aLength)
+                && !(fitsNibble(aReference, aNewData, tIndex + tCount) && tIndex + tCount + 1 < aLength
+                        && fitsNibble(aReference, aNewData, tIndex + tCount + 1))) {
+            tCount++;
+        }
+        if (tOut + 1 + tCount > aEncodedBufferSize) {
+            return 0;
+        }
+        aEncodedBuffer[tOut++] = CHART_DELTA_OP_LITERAL | (tCount - 1);
+        for (size_t i = 0; i < tCount; ++i) {
+            aEncodedBuffer[tOut++] = aNewData[tIndex + i];
+        }
+        tIndex += tCount;
+    }
+    return tOut;
+}
+
+/**
+ * Applies encoded data to the reference buffer in place.
+ * @return false if encoded data is malformed or does not match aLength. Then the reference content is undefined.
+ */
+bool decodeChartDelta(const uint8_t * aEncodedData, size_t aEncodedLength, uint8_t * aReferenceAndResult, size_t aLength) {
+    const uint8_t * tEncodedEnd = aEncodedData + aEncodedLength;
+    size_t tIndex = 0;
+    while (aEncodedData < tEncodedEnd) {
+        uint8_t tOpcode = *aEncodedData & CHART_DELTA_OP_MASK;
+        size_t tCount = (*aEncodedData++ & ~CHART_DELTA_OP_MASK) + 1;
+        if (tIndex + tCount > aLength) {
+            return false;
+        }
+        switch (tOpcode) {
+        case CHART_DELTA_OP_SKIP:
+            break;
+        case CHART_DELTA_OP_NIBBLES:
+            if (aEncodedData + (tCount + 1) / 2 > tEncodedEnd) {
+                return false;
+            }
+            for (size_t i = 0; i < tCount; ++i) {
+                uint8_t tNibble;
+                if ((i & 0x01) == 0) {
+                    tNibble = *aEncodedData >> 4;
+                } else {
+                    tNibble = *aEncodedData++ & 0x0F;
+                }
+                // sign extend 4 bit value
+                int tDelta = (tNibble & 0x08) ? (int) tNibble - 16 : tNibble;
+                aReferenceAndResult[tIndex + i] += tDelta;
+            }
+            if (tCount & 0x01) {
+                aEncodedData++;
+            }
+            break;
+        case CHART_DELTA_OP_LITERAL:
+            if (aEncodedData + tCount > tEncodedEnd) {
+                return false;
+            }
+            for (size_t i = 0; i < tCount; ++i) {
+                aReferenceAndResult[tIndex + i] = *aEncodedData++;
+            }
+            break;
+        default: // CHART_DELTA_OP_REPEAT
+            if (aEncodedData >= tEncodedEnd) {
+                return false;
+            }
+            for (size_t i = 0; i < tCount; ++i) {
+                aReferenceAndResult[tIndex + i] = *aEncodedData;
+            }
+            aEncodedData++;
+            break;
+        }
+        tIndex += tCount;
+    }
+    return (tIndex == aLength);
+}
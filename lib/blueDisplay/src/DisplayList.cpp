@@ -0,0 +1,132 @@
+/*
+ * DisplayList.cpp
+ *
+ * Retained display list for replay of the actual page on reconnect or redraw request. See DisplayList.h.
+ *
+ *  This file is part of BlueDisplay.
+ *  BlueDisplay is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/gpl.html>.
+ *
+ */
+
+#include "DisplayList.h"
+#include "BlueDisplayProtocol.h"
+
+#include <string.h> // for memcmp
+
+/**
+ * Global settings, requests, debug output and creation of buttons and sliders are no part of the page.
+ * Registered strings are registered again before replay and charts are stored plain, never as delta.
+ */
+bool isDisplayListFunction(uint8_t aFunctionTag) {
+    if (aFunctionTag < FUNCTION_CLEAR_DISPLAY) {
+        return false;
+    }
+    switch (aFunctionTag) {
+    case FUNCTION_NOP:
+    case FUNCTION_DEBUG_STRING:
+    case FUNCTION_REGISTER_STRING:
+    case FUNCTION_GET_NUMBER_WITH_SHORT_PROMPT:
+    case FUNCTION_GET_TEXT_WITH_SHORT_PROMPT:
+    case FUNCTION_DRAW_CHART_DELTA:
+    case FUNCTION_DRAW_CHART_DELTA_WITHOUT_DIRECT_RENDERING:
+    case FUNCTION_BAUD_TEST_PATTERN:
+    case FUNCTION_BUTTON_CREATE:
+    case FUNCTION_SLIDER_CREATE:
+        return false;
+    default:
+        return true;
+    }
+}
+
+/**
+ * Starts a new page
+ */
+void clearDisplayList(struct DisplayList * aList) {
+    aList->Length = 0;
+    aList->NumberOfCommands = 0;
+    aList->Complete = true;
+}
+
+/**
+ * List can not be replayed until the next FUNCTION_CLEAR_DISPLAY e.g. if the page layout depends on the new display size
+ */
+void invalidateDisplayList(struct DisplayList * aList) {
+    aList->Length = 0;
+    aList->NumberOfCommands = 0;
+    aList->Complete = false;
+}
+
+/**
+ * @return total length of the command including data header and data
+ */
+size_t getDisplayListCommandLength(const uint8_t * aCommand) {
+    size_t tLength = 4 + (aCommand[2] | (aCommand[3] << 8));
+    if (aCommand[1] > INDEX_LAST_FUNCTION_WITHOUT_DATA) {
+        const uint8_t * tDataHeader = &aCommand[tLength];
+        size_t tDataLength = tDataHeader[2] | (tDataHeader[3] << 8);
+        if (tDataHeader[1] == DATAFIELD_TAG_SHORT) {
+            tDataLength *= 2;
+        }
+        tLength += 4 + tDataLength;
+    }
+    return tLength;
+}
+
+/**
+ * Stores one command as given to the send functions.
+ * @param aParameterBufferPointer function tag, parameters and data header
+ * @return DISPLAY_LIST_APPENDED, DISPLAY_LIST_REPLACED, DISPLAY_LIST_IGNORED or DISPLAY_LIST_OVERFLOW
+ */
+uint8_t appendToDisplayList(struct DisplayList * aList, const uint8_t * aParameterBufferPointer, size_t aParameterBufferLength,
+        const uint8_t * aDataBufferPointer, size_t aDataBufferLength) {
+    if (aParameterBufferLength < 4) {
+        return DISPLAY_LIST_IGNORED;
+    }
+    uint8_t tFunctionTag = aParameterBufferPointer[1];
+    if (tFunctionTag == FUNCTION_CLEAR_DISPLAY) {
+        clearDisplayList(aList);
+    } else if (!isDisplayListFunction(tFunctionTag)) {
+        return DISPLAY_LIST_IGNORED;
+    } else if (!aList->Complete) {
+        return DISPLAY_LIST_OVERFLOW;
+    }
+
+    if (aDataBufferLength > 0) {
+        // new data for the same position e.g. chart or value replaces the old one
+        uint8_t * tCommand = &aList->Data[0];
+        uint8_t * tEnd = &aList->Data[aList->Length];
+        while (tCommand < tEnd) {
+            size_t tCommandLength = getDisplayListCommandLength(tCommand);
+            if (tCommandLength == aParameterBufferLength + aDataBufferLength
+                    && memcmp(tCommand, aParameterBufferPointer, aParameterBufferLength) == 0) {
+                memcpy(tCommand + aParameterBufferLength, aDataBufferPointer, aDataBufferLength);
+                return DISPLAY_LIST_REPLACED;
+            }
+            tCommand += tCommandLength;
+        }
+    }
+
+    if (aList->Length + aParameterBufferLength + aDataBufferLength > DISPLAY_LIST_SIZE) {
+        invalidateDisplayList(aList);
+        return DISPLAY_LIST_OVERFLOW;
+    }
+    memcpy(&aList->Data[aList->Length], aParameterBufferPointer, aParameterBufferLength);
+    aList->Length += aParameterBufferLength;
+    if (aDataBufferLength > 0) {
+        memcpy(&aList->Data[aList->Length], aDataBufferPointer, aDataBufferLength);
+        aList->Length += aDataBufferLength;
+    }
+    aList->NumberOfCommands++;
+    return DISPLAY_LIST_APPENDED;
+}
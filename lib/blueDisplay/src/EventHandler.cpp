@@ -30,6 +30,7 @@
 #include "EventHandler.h"
 #include "BlueSerial.h"
 #include "timing.h"
+#include "CooperativeTask.h"
 
 #ifdef LOCAL_DISPLAY_EXISTS
 #include "TouchButton.h"
@@ -41,8 +42,11 @@
 #ifdef USE_STM32F3_DISCO
 #include "stm32f3_discovery.h"  // For LEDx
 #endif
+#ifndef HOST_SIMULATION
 #include "stm32fx0xPeripherals.h" // For Watchdog_reload()
+#endif
 #include <stdlib.h> // for NULL
+#include <string.h> // for memset
 
 #ifndef DO_NOT_NEED_BASIC_TOUCH_EVENTS
 struct TouchEvent sDownPosition;
@@ -83,6 +87,11 @@ bool sTouchUpCallbackEnabled = false;
 void (*sSwipeEndCallback)(struct Swipe *) = NULL;
 bool sSwipeEndCallbackEnabled = false;
 
+#ifndef DO_NOT_USE_KINETIC_SCROLL
+void (*sScrollCallback)(struct Scroll *) = NULL;
+struct KineticScroll sKineticScroll;
+#endif
+
 void (*sConnectCallback)(void) = NULL;
 void (*sRedrawCallback)(void) = NULL;
 void (*sReorientationCallback)(void) = NULL;
@@ -91,6 +100,14 @@ void (*sSensorChangeCallback)(uint8_t aEventType, struct SensorCallback * aSenso
 
 bool sDisplayXYValuesEnabled = false;  // displays touch values on screen
 
+#ifndef DO_NOT_COALESCE_MOVE_EVENTS
+struct MoveEventStatistics MoveEventStatistics;
+bool sMoveEventCoalescingEnabled = true;
+// Newest move event not yet dispatched. EventType is EVENT_NO_EVENT if empty.
+struct BluetoothEvent sPendingMoveEvent = { EVENT_NO_EVENT, { { 0 } } };
+uint32_t sLastMoveEventDispatchMillis;
+#endif
+
 #ifdef LOCAL_DISPLAY_EXISTS
 /**
  * Callback routine for SysTick handler
@@ -228,6 +245,34 @@ void setSwipeEndCallbackEnabled(bool aSwipeEndCallbackEnabled) {
     }
 }
 
+#ifndef DO_NOT_USE_KINETIC_SCROLL
+/**
+ * Register a callback routine which is called with the scrolled distance while the touch is dragged and while it flings after touch up.
+ * A touch which has scrolled does not call the touch up callback.
+ */
+void registerScrollCallback(void (*aScrollCallback)(struct Scroll *)) {
+    sScrollCallback = aScrollCallback;
+    stopKineticScroll(&sKineticScroll);
+}
+
+/**
+ * Stops dragging and flinging without further callback, e.g. if the end of the scrolled content is reached
+ */
+void stopScroll(void) {
+    stopKineticScroll(&sKineticScroll);
+}
+
+/**
+ * Calls the scroll callback if the scroll position has changed and the last call was at least SCROLL_FRAME_PERIOD_MILLIS ago
+ */
+static void checkAndHandleScroll(void) {
+    struct Scroll tScrollInfo;
+    if (sScrollCallback != NULL && getKineticScrollFrame(&sKineticScroll, getMillisSinceBoot(), &tScrollInfo)) {
+        sScrollCallback(&tScrollInfo);
+    }
+}
+#endif
+
 /**
  *
  * @param aSensorType see see android.hardware.Sensor
@@ -244,14 +289,123 @@ void registerSensorChangeCallback(uint8_t aSensorType, uint8_t aSensorRate, uint
     sSensorChangeCallback = aSensorChangeCallback;
 }
 
+#ifndef DO_NOT_COALESCE_MOVE_EVENTS
+/**
+ * Disabling dispatches every touch move and slider callback event, e.g. for drawing with the finger
+ */
+void setMoveEventCoalescingEnabled(bool aMoveEventCoalescingEnabled) {
+    sMoveEventCoalescingEnabled = aMoveEventCoalescingEnabled;
+    if (!aMoveEventCoalescingEnabled && sPendingMoveEvent.EventType != EVENT_NO_EVENT) {
+        handleEvent(&sPendingMoveEvent);
+    }
+}
+
+void resetMoveEventStatistics(void) {
+    memset(&MoveEventStatistics, 0, sizeof(MoveEventStatistics));
+}
+
+static bool isMoveEvent(struct BluetoothEvent * aEvent) {
+    return (aEvent->EventType == EVENT_TOUCH_ACTION_MOVE || aEvent->EventType == EVENT_SLIDER_CALLBACK);
+}
+
+/**
+ * @return true if aEvent only updates the position or value of the pending move event
+ */
+static bool isSameMoveTarget(struct BluetoothEvent * aEvent) {
+    if (aEvent->EventType != sPendingMoveEvent.EventType) {
+        return false;
+    }
+    if (aEvent->EventType == EVENT_TOUCH_ACTION_MOVE) {
+        return (aEvent->EventData.TouchEventInfo.TouchPointerIndex
+                == sPendingMoveEvent.EventData.TouchEventInfo.TouchPointerIndex);
+    }
+    return (aEvent->EventData.GuiCallbackInfo.ObjectIndex == sPendingMoveEvent.EventData.GuiCallbackInfo.ObjectIndex
+            && aEvent->EventData.GuiCallbackInfo.Handler == sPendingMoveEvent.EventData.GuiCallbackInfo.Handler);
+}
+
+/**
+ * Dispatch the newest move event if the last one was dispatched at least MOVE_EVENT_MIN_PERIOD_MILLIS ago
+ */
+static void checkAndHandlePendingMoveEvent(void) {
+    if (sPendingMoveEvent.EventType != EVENT_NO_EVENT
+            && getMillisSinceBoot() - sLastMoveEventDispatchMillis >= MOVE_EVENT_MIN_PERIOD_MILLIS) {
+        handleEvent(&sPendingMoveEvent);
+    }
+}
+#endif
+
 /*
  * Delay which also checks for events
  */
 void delayMillisWithCheckAndHandleEvents(unsigned long aTimeMillis) {
     unsigned long tStartMillis = getMillisSinceBoot();
-    while (getMillisSinceBoot() - tStartMillis < aTimeMillis) {
-        checkAndHandleEvents();
+    unsigned long tElapsedMillis;
+    while ((tElapsedMillis = getMillisSinceBoot() - tStartMillis) < aTimeMillis) {
+        checkAndHandleEventsAndIdle(aTimeMillis - tElapsedMillis);
+    }
+}
+
+#ifdef USE_TICKLESS_IDLE
+/*
+ * Called by idleMillis() with interrupts disabled.
+ * Includes cooperative tasks, since they can be started by an interrupt after the check in checkAndHandleEventsAndIdle().
+ */
+static bool isEventPending(void) {
+    if (areCooperativeTasksRunning()) {
+        return true;
+    }
+#ifdef LOCAL_DISPLAY_EXISTS
+    if (localTouchEvent.EventType != EVENT_NO_EVENT) {
+        return true;
     }
+#endif
+    return isReceivedDataPending();
+}
+
+/*
+ * @return aMaxIdleMillis limited to the rest of aPeriodMillis, at least 1
+ */
+static uint32_t limitIdleMillis(uint32_t aMaxIdleMillis, uint32_t aElapsedMillis, uint32_t aPeriodMillis) {
+    uint32_t tRestMillis = 1;
+    if (aElapsedMillis < aPeriodMillis) {
+        tRestMillis = aPeriodMillis - aElapsedMillis;
+    }
+    if (tRestMillis < aMaxIdleMillis) {
+        return tRestMillis;
+    }
+    return aMaxIdleMillis;
+}
+#endif
+
+/**
+ * Like checkAndHandleEvents(), but then sleeps until an interrupt occurs, the next delay callback is due,
+ * the time based work of checkAndHandleEvents() is due, or at most aMaxIdleMillis.
+ * For thread main loops, which only wait for events and for flags set by delay callbacks or interrupts.
+ * Does not sleep without USE_TICKLESS_IDLE or if cooperative tasks are running.
+ */
+void checkAndHandleEventsAndIdle(uint32_t aMaxIdleMillis) {
+    checkAndHandleEvents();
+#ifdef USE_TICKLESS_IDLE
+    if (areCooperativeTasksRunning()) {
+        return;
+    }
+    uint32_t tMillis = getMillisSinceBoot();
+#ifndef DO_NOT_COALESCE_MOVE_EVENTS
+    if (sPendingMoveEvent.EventType != EVENT_NO_EVENT) {
+        aMaxIdleMillis = limitIdleMillis(aMaxIdleMillis, tMillis - sLastMoveEventDispatchMillis,
+                MOVE_EVENT_MIN_PERIOD_MILLIS);
+    }
+#endif
+#ifndef DO_NOT_USE_KINETIC_SCROLL
+    if (isKineticScrollActive(&sKineticScroll)) {
+        aMaxIdleMillis = limitIdleMillis(aMaxIdleMillis, tMillis - sKineticScroll.LastFrameMillis,
+                SCROLL_FRAME_PERIOD_MILLIS);
+    }
+#endif
+    idleMillis(aMaxIdleMillis, &isEventPending);
+#else
+    (void) aMaxIdleMillis;
+#endif
 }
 
 /**
@@ -271,6 +425,17 @@ void checkAndHandleEvents(void) {
      * check USART buffer, which in turn calls handleEvent() if event was received
      */
     checkAndHandleMessageReceived();
+#ifndef DO_NOT_COALESCE_MOVE_EVENTS
+    // after all received events are handled, so only the newest position is dispatched
+    checkAndHandlePendingMoveEvent();
+#endif
+#ifndef DO_NOT_USE_KINETIC_SCROLL
+    checkAndHandleScroll();
+#endif
+    // send the newest chart etc. if it was held back because of a saturated link
+    flushSendStreams();
+    // next chunk of long running jobs
+    runCooperativeTasks();
 }
 
 /**
@@ -278,6 +443,38 @@ void checkAndHandleEvents(void) {
  * is indirectly called by thread in main loop
  */
 extern "C" void handleEvent(struct BluetoothEvent * aEvent) {
+#ifndef DO_NOT_COALESCE_MOVE_EVENTS
+    if (aEvent == &sPendingMoveEvent) {
+        MoveEventStatistics.Dispatched++;
+        sLastMoveEventDispatchMillis = getMillisSinceBoot();
+    } else if (isMoveEvent(aEvent)) {
+        MoveEventStatistics.Received++;
+#ifndef DO_NOT_NEED_BASIC_TOUCH_EVENTS
+        if (aEvent->EventType == EVENT_TOUCH_ACTION_MOVE && !sDisableUntilTouchUpIsDone) {
+            // the long touch timeout and the swipe check must see the position already at receive time
+            sActualPosition = aEvent->EventData.TouchEventInfo;
+        }
+#endif
+        if (sMoveEventCoalescingEnabled) {
+            if (sPendingMoveEvent.EventType != EVENT_NO_EVENT) {
+                if (isSameMoveTarget(aEvent)) {
+                    MoveEventStatistics.Coalesced++;
+                } else {
+                    handleEvent(&sPendingMoveEvent);
+                }
+            }
+            // keep only the newest position, it is dispatched by checkAndHandleEvents()
+            sPendingMoveEvent = *aEvent;
+            aEvent->EventType = EVENT_NO_EVENT;
+            return;
+        }
+        MoveEventStatistics.Dispatched++;
+    } else if (sPendingMoveEvent.EventType != EVENT_NO_EVENT
+            && !(aEvent->EventType >= EVENT_FIRST_SENSOR_ACTION_CODE && aEvent->EventType <= EVENT_LAST_SENSOR_ACTION_CODE)) {
+        // keep order of events, e.g. last move before touch up. Sensor events are independent of touch.
+        handleEvent(&sPendingMoveEvent);
+    }
+#endif
     uint8_t tEventType = aEvent->EventType;
 
     // local event since the values in the event may be overwritten if the handler needs long time for its action
@@ -308,6 +505,17 @@ extern "C" void handleEvent(struct BluetoothEvent * aEvent) {
         if (sTouchDownCallback != NULL) {
             sTouchDownCallback(&tEvent.EventData.TouchEventInfo);
         }
+#ifndef DO_NOT_USE_KINETIC_SCROLL
+        // stops a running fling
+        startKineticScrollDrag(&sKineticScroll, getMillisSinceBoot(), tEvent.EventData.TouchEventInfo.TouchPosition.PosX,
+                tEvent.EventData.TouchEventInfo.TouchPosition.PosY);
+#ifdef LOCAL_DISPLAY_EXISTS
+        if (sSliderIsMoveTarget) {
+            // touch moves the slider
+            stopKineticScroll(&sKineticScroll);
+        }
+#endif
+#endif
 
     } else if (tEventType == EVENT_TOUCH_ACTION_MOVE) {
         if (sDisableUntilTouchUpIsDone) {
@@ -317,6 +525,10 @@ extern "C" void handleEvent(struct BluetoothEvent * aEvent) {
             sTouchMoveCallback(&tEvent.EventData.TouchEventInfo);
         }
         sActualPosition = tEvent.EventData.TouchEventInfo;
+#ifndef DO_NOT_USE_KINETIC_SCROLL
+        moveKineticScrollDrag(&sKineticScroll, getMillisSinceBoot(), tEvent.EventData.TouchEventInfo.TouchPosition.PosX,
+                tEvent.EventData.TouchEventInfo.TouchPosition.PosY);
+#endif
 
     } else if (tEventType == EVENT_TOUCH_ACTION_UP) {
         sUpPosition = tEvent.EventData.TouchEventInfo;
@@ -324,6 +536,15 @@ extern "C" void handleEvent(struct BluetoothEvent * aEvent) {
         BSP_LED_Off(LED_BLUE_2); // BLUE Front
 #endif
         sTouchIsStillDown = false;
+#ifndef DO_NOT_USE_KINETIC_SCROLL
+        if (sDisableUntilTouchUpIsDone) {
+            stopKineticScroll(&sKineticScroll);
+        } else if (sScrollCallback != NULL
+                && endKineticScrollDrag(&sKineticScroll, getMillisSinceBoot(), tEvent.EventData.TouchEventInfo.TouchPosition.PosX,
+                        tEvent.EventData.TouchEventInfo.TouchPosition.PosY)) {
+            sDisableTouchUpOnce = true; // touch was no tap
+        }
+#endif
 #ifdef LOCAL_DISPLAY_EXISTS
         // may set sDisableTouchUpOnce
         handleLocalTouchUp();
@@ -344,11 +565,16 @@ extern "C" void handleEvent(struct BluetoothEvent * aEvent) {
 #endif
         sUpPosition = tEvent.EventData.TouchEventInfo;
         sTouchIsStillDown = false;
+#ifndef DO_NOT_USE_KINETIC_SCROLL
+        stopKineticScroll(&sKineticScroll);
+#endif
     } else
 #endif
 
     if (tEventType == EVENT_BUTTON_CALLBACK) {
         sTouchIsStillDown = false; // to disable local touch up detection
+        // remote side may have toggled value and color
+        BlueDisplay1.resetButtonStateCache(tEvent.EventData.GuiCallbackInfo.ObjectIndex);
 
 #ifdef LOCAL_DISPLAY_EXISTS
         void (*tCallback)(BDButton*,
@@ -365,6 +591,7 @@ extern "C" void handleEvent(struct BluetoothEvent * aEvent) {
 
     } else if (tEventType == EVENT_SLIDER_CALLBACK) {
         sTouchIsStillDown = false; // to disable local touch up detection
+        BlueDisplay1.resetSliderStateCache(tEvent.EventData.GuiCallbackInfo.ObjectIndex);
 #ifdef LOCAL_DISPLAY_EXISTS
                 void (*tCallback)(BDSlider *,
                         int16_t) = (void (*)(BDSlider *, int16_t))tEvent.EventData.GuiCallbackInfo.Handler;
@@ -432,6 +659,10 @@ extern "C" void handleEvent(struct BluetoothEvent * aEvent) {
         BlueDisplay1.mLocalMillisForHostTimestamp = getMillisSinceBoot();
         BlueDisplay1.mConnectionEstablished = true;
 
+#ifdef USE_DISPLAY_LIST
+        // layout of page may depend on orientation
+        discardDisplayList();
+#endif
         if (sReorientationCallback != NULL) {
             sReorientationCallback();
         }
@@ -448,8 +679,22 @@ extern "C" void handleEvent(struct BluetoothEvent * aEvent) {
         BlueDisplay1.mLocalMillisForHostTimestamp = getMillisSinceBoot();
         BlueDisplay1.mConnectionEstablished = true;
 
+        // waiting chart and info messages belong to the old connection, the page is sent completely below
+        discardSendStreams();
         // first write a NOP command for synchronizing
         BlueDisplay1.sendSync();
+        // new remote side has no chart data to apply deltas to, no registered strings and new buttons and sliders
+        BlueDisplay1.resetChartDeltaReferences();
+        BlueDisplay1.resetGUIStateCache();
+#ifdef USE_DISPLAY_LIST
+        // the display list which is replayed below references the registered strings by ID
+        bool tResendRegisteredStrings = isDisplayListReplayable();
+        if (!tResendRegisteredStrings) {
+            BlueDisplay1.resetRegisteredStrings();
+        }
+#else
+        BlueDisplay1.resetRegisteredStrings();
+#endif
 
         if (sConnectCallback != NULL) {
             sConnectCallback();
@@ -459,12 +704,21 @@ extern "C" void handleEvent(struct BluetoothEvent * aEvent) {
         // do it after sConnectCallback() since the upper tends to send a reset all command
         TouchButton::reinitAllLocalButtonsForRemote();
         TouchSlider::reinitAllLocalSlidersForRemote();
+#endif
+#ifdef USE_DISPLAY_LIST
+        // after sConnectCallback() since a reset all command may clear the table of the remote side
+        if (tResendRegisteredStrings) {
+            BlueDisplay1.resendRegisteredStrings();
+        }
 #endif
         // Since with simpleSerial we have only buffer for 1 event must also call redraw here
         tEventType = EVENT_REDRAW;
 
     } else if (tEventType == EVENT_DISCONNECT) {
         BlueDisplay1.mConnectionEstablished = false;
+
+    } else if (tEventType == EVENT_BAUD_NEGOTIATION) {
+        handleBaudNegotiationEvent(&tEvent.EventData.BaudNegotiationInfo);
     }
 
     if (tEventType == EVENT_REDRAW) {
@@ -474,7 +728,13 @@ extern "C" void handleEvent(struct BluetoothEvent * aEvent) {
         BlueDisplay1.mActualDisplaySize.XWidth = tEvent.EventData.DisplaySize.XWidth;
         BlueDisplay1.mActualDisplaySize.YHeight = tEvent.EventData.DisplaySize.YHeight;
         if (sRedrawCallback != NULL) {
+#ifdef USE_DISPLAY_LIST
+            if (!replayDisplayList()) {
+                sRedrawCallback();
+            }
+#else
             sRedrawCallback();
+#endif
         }
     }
 }
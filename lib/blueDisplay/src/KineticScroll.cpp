@@ -0,0 +1,232 @@
+/*
+ * KineticScroll.cpp
+ *
+ * Velocity estimation and inertial scrolling. See KineticScroll.h.
+ *
+ * Usage:
+ *  startKineticScrollDrag() at touch down, moveKineticScrollDrag() at each touch move and endKineticScrollDrag() at touch up.
+ *  Then call getKineticScrollFrame() in the main loop until it returns a scroll info with IsLast set.
+ *
+ *  This file is part of BlueDisplay.
+ *  BlueDisplay is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/gpl.html>.
+ *
+ */
+
+#include "KineticScroll.h"
+
+#include <stdlib.h> // for abs
+#include <string.h> // for memset
+
+void addVelocityTrackerSample(struct VelocityTracker * aTracker, uint32_t aMillis, int16_t aPositionX, int16_t aPositionY) {
+    aTracker->Millis[aTracker->Index] = aMillis;
+    aTracker->PositionX[aTracker->Index] = aPositionX;
+    aTracker->PositionY[aTracker->Index] = aPositionY;
+    aTracker->Index++;
+    if (aTracker->Index >= VELOCITY_TRACKER_SIZE) {
+        aTracker->Index = 0;
+    }
+    if (aTracker->NumberOfSamples < VELOCITY_TRACKER_SIZE) {
+        aTracker->NumberOfSamples++;
+    }
+}
+
+/*
+ * Least squares slope of the samples not older than VELOCITY_TRACKER_WINDOW_MILLIS before the newest one.
+ * A finger which rests before touch up has no samples in the window and therefore no velocity.
+ * @return false if less than 2 samples with different time are in window. Velocities are then 0.
+ */
+bool getVelocity(const struct VelocityTracker * aTracker, int32_t * aVelocityXPtr, int32_t * aVelocityYPtr) {
+    *aVelocityXPtr = 0;
+    *aVelocityYPtr = 0;
+    if (aTracker->NumberOfSamples < 2) {
+        return false;
+    }
+    uint8_t tIndex = (aTracker->Index + VELOCITY_TRACKER_SIZE - 1) % VELOCITY_TRACKER_SIZE;
+    uint32_t tNewestMillis = aTracker->Millis[tIndex];
+    int16_t tNewestX = aTracker->PositionX[tIndex];
+    int16_t tNewestY = aTracker->PositionY[tIndex];
+
+    // time and position relative to newest sample keep the sums small
+    int32_t tN = 0;
+    int32_t tSumT = 0, tSumX = 0, tSumY = 0, tSumTT = 0, tSumTX = 0, tSumTY = 0;
+    for (uint8_t i = 0; i < aTracker->NumberOfSamples; ++i) {
+        int32_t tAgeMillis = tNewestMillis - aTracker->Millis[tIndex];
+        if (tAgeMillis > VELOCITY_TRACKER_WINDOW_MILLIS) {
+            break;
+        }
+        int32_t tX = aTracker->PositionX[tIndex] - tNewestX;
+        int32_t tY = aTracker->PositionY[tIndex] - tNewestY;
+        tN++;
+        tSumT -= tAgeMillis;
+        tSumX += tX;
+        tSumY += tY;
+        tSumTT += tAgeMillis * tAgeMillis;
+        tSumTX -= tAgeMillis * tX;
+        tSumTY -= tAgeMillis * tY;
+        tIndex = (tIndex + VELOCITY_TRACKER_SIZE - 1) % VELOCITY_TRACKER_SIZE;
+    }
+    int32_t tDenominator = tN * tSumTT - tSumT * tSumT;
+    if (tN < 2 || tDenominator == 0) {
+        return false;
+    }
+    // pixel per millisecond -> pixel per second
+    *aVelocityXPtr = ((int64_t) (tN * tSumTX - tSumT * tSumX) * 1000) / tDenominator;
+    *aVelocityYPtr = ((int64_t) (tN * tSumTY - tSumT * tSumY) * 1000) / tDenominator;
+    return true;
+}
+
+static int32_t limitVelocity(int32_t aVelocity) {
+    if (aVelocity > KINETIC_SCROLL_MAX_VELOCITY) {
+        return KINETIC_SCROLL_MAX_VELOCITY;
+    }
+    if (aVelocity < -KINETIC_SCROLL_MAX_VELOCITY) {
+        return -KINETIC_SCROLL_MAX_VELOCITY;
+    }
+    return aVelocity;
+}
+
+static void setDragPosition(struct KineticScroll * aScroll, uint32_t aMillis, uint16_t aPositionX, uint16_t aPositionY) {
+    addVelocityTrackerSample(&aScroll->Tracker, aMillis, aPositionX, aPositionY);
+    int16_t tDeltaX = aPositionX - aScroll->TouchStartX;
+    int16_t tDeltaY = aPositionY - aScroll->TouchStartY;
+    aScroll->PositionX = (int32_t) tDeltaX << KINETIC_SCROLL_FRACTION_SHIFT;
+    aScroll->PositionY = (int32_t) tDeltaY << KINETIC_SCROLL_FRACTION_SHIFT;
+    if (!aScroll->IsScrolling && (abs(tDeltaX) >= SCROLL_START_THRESHOLD || abs(tDeltaY) >= SCROLL_START_THRESHOLD)) {
+        aScroll->IsScrolling = true;
+        // report first frame at once
+        aScroll->LastFrameMillis = aMillis - SCROLL_FRAME_PERIOD_MILLIS;
+    }
+}
+
+/**
+ * Stops a running fling without reporting IsLast
+ */
+void startKineticScrollDrag(struct KineticScroll * aScroll, uint32_t aMillis, uint16_t aPositionX, uint16_t aPositionY) {
+    memset(aScroll, 0, sizeof(struct KineticScroll));
+    aScroll->TouchStartX = aPositionX;
+    aScroll->TouchStartY = aPositionY;
+    aScroll->IsDragging = true;
+    addVelocityTrackerSample(&aScroll->Tracker, aMillis, aPositionX, aPositionY);
+}
+
+void moveKineticScrollDrag(struct KineticScroll * aScroll, uint32_t aMillis, uint16_t aPositionX, uint16_t aPositionY) {
+    if (aScroll->IsDragging) {
+        setDragPosition(aScroll, aMillis, aPositionX, aPositionY);
+    }
+}
+
+/**
+ * Starts the fling if velocity at touch up is at least KINETIC_SCROLL_MIN_VELOCITY
+ * @return true if touch has scrolled
+ */
+bool endKineticScrollDrag(struct KineticScroll * aScroll, uint32_t aMillis, uint16_t aPositionX, uint16_t aPositionY) {
+    if (!aScroll->IsDragging) {
+        return false;
+    }
+    setDragPosition(aScroll, aMillis, aPositionX, aPositionY);
+    aScroll->IsDragging = false;
+    if (!aScroll->IsScrolling) {
+        return false;
+    }
+    int32_t tVelocityX, tVelocityY;
+    getVelocity(&aScroll->Tracker, &tVelocityX, &tVelocityY);
+    if (abs(tVelocityX) >= KINETIC_SCROLL_MIN_VELOCITY || abs(tVelocityY) >= KINETIC_SCROLL_MIN_VELOCITY) {
+        aScroll->VelocityX = limitVelocity(tVelocityX);
+        aScroll->VelocityY = limitVelocity(tVelocityY);
+        aScroll->FlingMillis = aMillis;
+        aScroll->IsFlinging = true;
+    } else {
+        aScroll->EndIsDue = true;
+    }
+    return true;
+}
+
+/**
+ * Ends dragging and flinging at once, e.g. if the scrolled content has reached its end
+ */
+void stopKineticScroll(struct KineticScroll * aScroll) {
+    aScroll->IsDragging = false;
+    aScroll->IsScrolling = false;
+    aScroll->IsFlinging = false;
+    aScroll->EndIsDue = false;
+}
+
+bool isKineticScrollActive(const struct KineticScroll * aScroll) {
+    return aScroll->IsScrolling;
+}
+
+/*
+ * Explicit Euler step of the exponential decay
+ */
+static void doFlingStep(struct KineticScroll * aScroll, uint32_t aMillis) {
+    int32_t tElapsedMillis = aMillis - aScroll->FlingMillis;
+    aScroll->FlingMillis = aMillis;
+    if (tElapsedMillis > KINETIC_SCROLL_TIME_CONSTANT_MILLIS / 4) {
+        // main loop was blocked, do not jump
+        tElapsedMillis = KINETIC_SCROLL_TIME_CONSTANT_MILLIS / 4;
+    }
+    aScroll->PositionX += ((aScroll->VelocityX * tElapsedMillis) << KINETIC_SCROLL_FRACTION_SHIFT) / 1000;
+    aScroll->PositionY += ((aScroll->VelocityY * tElapsedMillis) << KINETIC_SCROLL_FRACTION_SHIFT) / 1000;
+    aScroll->VelocityX -= (aScroll->VelocityX * tElapsedMillis) / KINETIC_SCROLL_TIME_CONSTANT_MILLIS;
+    aScroll->VelocityY -= (aScroll->VelocityY * tElapsedMillis) / KINETIC_SCROLL_TIME_CONSTANT_MILLIS;
+    if (abs(aScroll->VelocityX) < KINETIC_SCROLL_STOP_VELOCITY && abs(aScroll->VelocityY) < KINETIC_SCROLL_STOP_VELOCITY) {
+        aScroll->VelocityX = 0;
+        aScroll->VelocityY = 0;
+        aScroll->IsFlinging = false;
+        aScroll->EndIsDue = true;
+    }
+}
+
+/**
+ * To be called in the main loop.
+ * @return true if aScrollInfo was filled, i.e. position has changed or scrolling has ended,
+ *         and the last frame was at least SCROLL_FRAME_PERIOD_MILLIS ago
+ */
+bool getKineticScrollFrame(struct KineticScroll * aScroll, uint32_t aMillis, struct Scroll * aScrollInfo) {
+    if (!aScroll->IsScrolling || aMillis - aScroll->LastFrameMillis < SCROLL_FRAME_PERIOD_MILLIS) {
+        return false;
+    }
+    int32_t tVelocityX, tVelocityY;
+    if (aScroll->IsFlinging) {
+        doFlingStep(aScroll, aMillis);
+        tVelocityX = aScroll->VelocityX;
+        tVelocityY = aScroll->VelocityY;
+    } else if (aScroll->IsDragging) {
+        getVelocity(&aScroll->Tracker, &tVelocityX, &tVelocityY);
+    } else {
+        tVelocityX = 0;
+        tVelocityY = 0;
+    }
+    int16_t tPixelX = aScroll->PositionX >> KINETIC_SCROLL_FRACTION_SHIFT;
+    int16_t tPixelY = aScroll->PositionY >> KINETIC_SCROLL_FRACTION_SHIFT;
+    if (tPixelX == aScroll->ReportedX && tPixelY == aScroll->ReportedY && !aScroll->EndIsDue) {
+        return false;
+    }
+    aScroll->LastFrameMillis = aMillis;
+    aScrollInfo->DeltaX = tPixelX - aScroll->ReportedX;
+    aScrollInfo->DeltaY = tPixelY - aScroll->ReportedY;
+    aScroll->ReportedX = tPixelX;
+    aScroll->ReportedY = tPixelY;
+    aScrollInfo->VelocityX = limitVelocity(tVelocityX);
+    aScrollInfo->VelocityY = limitVelocity(tVelocityY);
+    aScrollInfo->TouchStartX = aScroll->TouchStartX;
+    aScrollInfo->TouchStartY = aScroll->TouchStartY;
+    aScrollInfo->IsKinetic = !aScroll->IsDragging;
+    aScrollInfo->IsLast = aScroll->EndIsDue;
+    if (aScroll->EndIsDue) {
+        aScroll->EndIsDue = false;
+        aScroll->IsScrolling = false;
+    }
+    return true;
+}
@@ -0,0 +1,85 @@
+/*
+ * StringTable.cpp
+ *
+ * Local table of the strings registered at the remote side. See StringTable.h.
+ * setStringTableEntry() and getStringTableEntry() are used by the host tools and serve as reference for the remote side.
+ *
+ *  This file is part of BlueDisplay.
+ *  BlueDisplay is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/gpl.html>.
+ *
+ */
+
+#include "StringTable.h"
+
+#include <string.h> // for memcmp
+
+void clearStringTable(struct StringTable * aTable) {
+    memset(aTable->Lengths, 0, sizeof(aTable->Lengths));
+    aTable->NextReplaceIndex = 0;
+}
+
+/**
+ * @return ID of string or STRING_TABLE_NO_ID if not found
+ */
+uint8_t findStringInTable(const struct StringTable * aTable, const char * aString, size_t aLength) {
+    if (aLength == 0 || aLength > STRING_TABLE_MAX_STRING_LENGTH) {
+        return STRING_TABLE_NO_ID;
+    }
+    for (uint8_t i = 0; i < STRING_TABLE_SIZE; ++i) {
+        // compare length and first character before comparing the whole string
+        if (aTable->Lengths[i] == aLength && aTable->Strings[i][0] == aString[0]
+                && memcmp(aTable->Strings[i], aString, aLength) == 0) {
+            return i;
+        }
+    }
+    return STRING_TABLE_NO_ID;
+}
+
+/**
+ * Puts string into the next free entry or replaces the oldest one.
+ * The caller must register the string at the remote side with the returned ID.
+ * @return ID of string or STRING_TABLE_NO_ID if string is too long
+ */
+uint8_t addStringToTable(struct StringTable * aTable, const char * aString, size_t aLength) {
+    uint8_t tID = aTable->NextReplaceIndex;
+    if (!setStringTableEntry(aTable, tID, aString, aLength)) {
+        return STRING_TABLE_NO_ID;
+    }
+    aTable->NextReplaceIndex = (tID + 1) % STRING_TABLE_SIZE;
+    return tID;
+}
+
+/**
+ * Handles FUNCTION_REGISTER_STRING
+ * @return false if ID or length is invalid
+ */
+bool setStringTableEntry(struct StringTable * aTable, uint8_t aID, const char * aString, size_t aLength) {
+    if (aID >= STRING_TABLE_SIZE || aLength == 0 || aLength > STRING_TABLE_MAX_STRING_LENGTH) {
+        return false;
+    }
+    memcpy(aTable->Strings[aID], aString, aLength);
+    aTable->Lengths[aID] = aLength;
+    return true;
+}
+
+/**
+ * @return pointer to (not null terminated) string or NULL if ID is not registered
+ */
+const char * getStringTableEntry(const struct StringTable * aTable, uint8_t aID, size_t * aLengthPtr) {
+    if (aID >= STRING_TABLE_SIZE || aTable->Lengths[aID] == 0) {
+        return NULL;
+    }
+    *aLengthPtr = aTable->Lengths[aID];
+    return aTable->Strings[aID];
+}
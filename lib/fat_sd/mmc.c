@@ -127,6 +127,7 @@ void deselect(void) {
     CS_HIGH();
     xchg_spi(0xFF);
     /* Dummy clock (force DO hi-z for multiple slave SPI) */
+    SPI1Busy = false;
 }
 
 /*-----------------------------------------------------------------------*/
@@ -136,6 +137,8 @@ void deselect(void) {
 static
 int select(void) /* 1:Successful, 0:Timeout */
 {
+    // no touch sampling until deselect()
+    SPI1Busy = true;
     CS_LOW();
     xchg_spi(0xFF);
     /* Dummy clock (force DO enabled) */
@@ -8,7 +8,7 @@
  * @version 1.5.0
  */
 
-#include "thickline.h"
+#include "thickLine.h"
 #include "MI0283QT2.h"
 
 /** @addtogroup Graphic_Library
@@ -12,6 +12,7 @@
 #define ASSERTERRORANDMISC_H_
 
 #include <stdbool.h>
+#include <stdint.h>
 #ifdef STM32F10X
 #include <stm32f1xx.h>
 #endif
@@ -34,6 +35,14 @@ struct ExceptionStackFrame {
 #endif
 };
 
+#ifdef HOST_SIMULATION
+// no HAL on host
+#define assert_param(expr) ((expr) ? (void)0 : assertFailedParamMessage((uint8_t *)__FILE__, __LINE__, 0, 0, #expr))
+#define IN_INTERRUPT_SERVICE_ROUTINE (false)
+static inline uint32_t getLR14(void) {
+    return 0;
+}
+#else
 #define IN_INTERRUPT_SERVICE_ROUTINE ((__get_IPSR() & 0xFF) != 0)
 
 __attribute__( ( always_inline ))       __STATIC_INLINE uint32_t getLR14(void) {
@@ -41,6 +50,7 @@ __attribute__( ( always_inline ))       __STATIC_INLINE uint32_t getLR14(void) {
     __ASM volatile ("MOV %0, lr" : "=r" (result) );
     return (result);
 }
+#endif
 
 /* Exported macro ------------------------------------------------------------*/
 #ifdef  USE_FULL_ASSERT // if enabled uses appr. 3400 bytes
@@ -0,0 +1,59 @@
+/**
+ * @file Benchmark.h
+ *
+ * Micro benchmarks measured with the DWT cycle counter (on host with the host time scaled to 72 MHz).
+ * Each benchmark is called once for warm up and then BENCHMARK_ITERATIONS times.
+ * Before each call, the BlueDisplay send buffer is drained, so every call starts with the same state.
+ * Minimum, median and maximum of the cycles of the calls are reported.
+ * The median is not affected by single interrupts and is the value to compare between firmware versions.
+ *
+ * The BlueDisplay benchmarks and the plain C signal benchmarks are in this file, to be used by the benchmark page
+ * and by tools/host/BenchmarkSuite.cpp. The signal benchmarks run the trigger scan and min/max loops of the DSO
+ * over a buffer, so the DSO code can be compared between host and target.
+ * Benchmarks of DSO, SD card and UART, which need the hardware, are in src/PageBenchmark.cpp.
+ *
+ * CSV format:
+ *  # benchmark <version> <cycles per second>
+ *  name,iterations,min cycles,median cycles,max cycles,median us,bytes,kbyte/s,target only
+ *  <one line per benchmark, bytes and kbyte/s are 0 if not applicable, target only is 1 if there is no host result>
+ *
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ */
+
+#ifndef BENCHMARK_H_
+#define BENCHMARK_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#define BENCHMARK_ITERATIONS 16 // must be even, since some benchmarks alternate between 2 inputs
+
+struct Benchmark {
+    const char * Name;
+    void (*Function)(int aIteration);
+    uint16_t BytesPerIteration; // for throughput, 0 if not applicable
+    bool TargetOnly; // needs the hardware, so there is no host result to compare with
+};
+
+struct BenchmarkResult {
+    const char * Name;
+    uint32_t MinCycles;
+    uint32_t MedianCycles;
+    uint32_t MaxCycles;
+    uint16_t BytesPerIteration;
+    bool TargetOnly;
+};
+
+extern const struct Benchmark DisplayBenchmarks[];
+#define NUMBER_OF_DISPLAY_BENCHMARKS 4
+extern const struct Benchmark SignalBenchmarks[];
+#define NUMBER_OF_SIGNAL_BENCHMARKS 2
+
+uint32_t getBenchmarkCyclesPerSecond(void);
+void runBenchmark(const struct Benchmark * aBenchmark, struct BenchmarkResult * aResult);
+int formatBenchmarkResult(char * aBuffer, size_t aSize, const struct BenchmarkResult * aResult);
+void writeBenchmarkCSV(const struct BenchmarkResult * aResults, int aNumberOfResults, const char * aVersion,
+        void (*aWriteFunction)(const char * aText, int aLength));
+
+#endif /* BENCHMARK_H_ */
@@ -0,0 +1,58 @@
+/**
+ * @file CooperativeTask.h
+ *
+ * Protothread style cooperative tasks for long running jobs like screenshot, export or Mandelbrot test.
+ * A task function is called again and again by runCooperativeTasks(), which is called by checkAndHandleEvents().
+ * Each call executes one chunk of the job until TASK_YIELD() and returns, so events are handled between two chunks.
+ * The next call continues after the TASK_YIELD(), which is implemented by a switch on the line number stored in the task.
+ *
+ * Restrictions of the task function:
+ *  Local variables are not preserved across TASK_YIELD(), use static variables instead.
+ *  switch statements must not contain a TASK_YIELD().
+ *  Must not call checkAndHandleEvents() or delayMillisWithCheckAndHandleEvents().
+ *
+ * Example:
+ *  static struct CooperativeTask sExportTask;
+ *  static int sIndex;
+ *  static bool exportTask(struct CooperativeTask * aTask) {
+ *      TASK_BEGIN(aTask);
+ *      for (sIndex = 0; sIndex < 100; ++sIndex) {
+ *          writeChunk(sIndex);
+ *          TASK_YIELD(aTask);
+ *      }
+ *      TASK_END(aTask);
+ *  }
+ *  startCooperativeTask(&sExportTask, &exportTask);
+ *
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ */
+
+#ifndef COOPERATIVETASK_H_
+#define COOPERATIVETASK_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+struct CooperativeTask {
+    bool (*TaskFunction)(struct CooperativeTask * aTask); // returns true if task has finished
+    uint16_t ResumeLine; // line of the last TASK_YIELD(), 0 -> start of task
+    volatile bool IsRunning;
+    bool IsLinked;
+    struct CooperativeTask * Next; // in list of all tasks ever started
+    uint32_t Steps; // number of calls of TaskFunction since start
+};
+
+#define TASK_BEGIN(aTask) switch ((aTask)->ResumeLine) { case 0:
+// returns and continues here at the next call of the task function
+#define TASK_YIELD(aTask) do { (aTask)->ResumeLine = __LINE__; return false; case __LINE__:; } while (0)
+#define TASK_WAIT_UNTIL(aTask, aCondition) do { (aTask)->ResumeLine = __LINE__; case __LINE__: if (!(aCondition)) { return false; } } while (0)
+#define TASK_EXIT(aTask) do { (aTask)->ResumeLine = 0; return true; } while (0)
+#define TASK_END(aTask) } (aTask)->ResumeLine = 0; return true
+
+bool startCooperativeTask(struct CooperativeTask * aTask, bool (*aTaskFunction)(struct CooperativeTask * aTask));
+void stopCooperativeTask(struct CooperativeTask * aTask);
+bool isCooperativeTaskRunning(struct CooperativeTask * aTask);
+bool areCooperativeTasksRunning(void);
+bool runCooperativeTasks(void);
+
+#endif /* COOPERATIVETASK_H_ */
@@ -0,0 +1,59 @@
+/**
+ * @file DeferredWork.h
+ *
+ * Lock free queues for work, which an ISR defers to the PendSV interrupt running at lowest priority.
+ * The ISR only captures its data, puts a function and an argument into its queue and sets PendSV pending.
+ * PendSV_Handler() is entered after all other ISRs have finished and calls the queued functions in order.
+ * Each queue has exactly one producer (one ISR or the main loop) and one consumer (PendSV),
+ * so In is only written by the producer and Out only by PendSV and no interrupts must be disabled.
+ *
+ * Example:
+ *  queueDeferredWork(DEFERRED_WORK_QUEUE_IR, &irmpReplaySamples, tSamples);
+ *
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ */
+
+#ifndef DEFERREDWORK_H_
+#define DEFERREDWORK_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * ISRs of DSO and IR page defer their bookkeeping to PendSV instead of doing it at their own priority
+ */
+//#define USE_DEFERRED_WORK
+
+#define DEFERRED_WORK_PENDSV_PRIO 0x0F // lowest possible prio
+#define DEFERRED_WORK_QUEUE_SIZE 8 // must be a power of 2
+
+// one queue for each producer
+#define DEFERRED_WORK_QUEUE_DSO 0 // DMA ISR of ADC
+#define DEFERRED_WORK_QUEUE_IR 1 // TIM15 ISR
+#define NUMBER_OF_DEFERRED_WORK_QUEUES 2
+
+struct DeferredWork {
+    void (*Function)(uint32_t aArgument);
+    uint32_t Argument;
+};
+
+struct DeferredWorkQueue {
+    struct DeferredWork Work[DEFERRED_WORK_QUEUE_SIZE];
+    volatile uint8_t In; // only written by producer
+    volatile uint8_t Out; // only written by PendSV
+    uint8_t MaxFill; // for statistics
+    uint16_t Overflows; // number of rejected work items
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+void initDeferredWork(void);
+bool queueDeferredWork(uint8_t aQueueIndex, void (*aFunction)(uint32_t aArgument), uint32_t aArgument);
+void runDeferredWork(void);
+struct DeferredWorkQueue * getDeferredWorkQueue(uint8_t aQueueIndex);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DEFERREDWORK_H_ */
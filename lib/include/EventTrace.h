@@ -0,0 +1,134 @@
+/**
+ * @file EventTrace.h
+ *
+ * Ring buffer of binary trace records with a timestamp from the DWT cycle counter.
+ * A record is 8 bytes and costs app. 20 cycles, since the counter is read and the ring index is incremented
+ * with interrupts disabled. Records of ISRs contain the exception number, so each ISR gets its own track.
+ * The ring always holds the last EVENT_TRACE_SIZE records. It is saved to the SD card with dumpEventTraceToFile()
+ * and converted on the host to Chrome / Perfetto JSON by tools/host/traceToChrome.py.
+ *
+ * Without USE_EVENT_TRACE all TRACE_* macros expand to nothing.
+ *
+ * Example:
+ *  void drawDataBuffer(...) {
+ *      TRACE_SCOPE(TRACE_ID_DRAW_DATA_BUFFER, aLength); // end is recorded at return
+ *
+ * Dump format (little endian):
+ *  "ETRC" uint16 version uint16 number of records uint32 cycles per second uint32 number of overwritten records
+ *  uint8 number of names, then for each ID its name terminated by 0
+ *  records, oldest first
+ *
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ */
+
+#ifndef EVENTTRACE_H_
+#define EVENTTRACE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Record trace events of DSO, BlueDisplay send path and page transitions. Costs 4 kByte RAM for the ring.
+ */
+//#define USE_EVENT_TRACE
+
+#define EVENT_TRACE_SIZE 512 // must be a power of 2
+#define EVENT_TRACE_VERSION 1
+
+#define TRACE_TYPE_BEGIN 0
+#define TRACE_TYPE_END 1
+#define TRACE_TYPE_INSTANT 2
+#define TRACE_TYPE_SHIFT 6
+#define TRACE_ID_MASK 0x3F
+
+/*
+ * IDs for the names in sEventTraceNames[] of EventTrace.cpp
+ */
+#define TRACE_ID_START_ACQUISITION 0
+#define TRACE_ID_DMA_COMPLETE 1
+#define TRACE_ID_TRIGGER 2 // argument is 1 if trigger found, 0 for timeout
+#define TRACE_ID_DRAW_DATA_BUFFER 3
+#define TRACE_ID_PRINT_INFO 4
+#define TRACE_ID_SEND_USART 5 // argument is number of bytes
+#define TRACE_ID_PAGE 6 // argument is handle of main menu button
+#define NUMBER_OF_TRACE_IDS 7
+
+struct TraceRecord {
+    uint32_t Cycles;
+    uint16_t Argument;
+    uint8_t TypeAndId; // type in upper 2 bits
+    uint8_t Exception; // 0 for thread mode, else exception number of ISR
+};
+
+#ifdef USE_EVENT_TRACE
+#include "timing.h" // for getCycleCount()
+
+extern struct TraceRecord EventTrace[EVENT_TRACE_SIZE];
+extern volatile uint32_t EventTraceIndex; // total number of records
+extern volatile bool EventTraceIsEnabled;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+void initEventTrace(void);
+void dumpEventTrace(void (*aWriteFunction)(const char * aData, int aLength));
+#ifndef HOST_SIMULATION
+bool dumpEventTraceToFile(void);
+#endif
+#ifdef __cplusplus
+}
+#endif
+
+static inline void recordTraceEvent(uint8_t aTypeAndId, uint16_t aArgument) {
+    if (!EventTraceIsEnabled) {
+        return;
+    }
+#ifdef HOST_SIMULATION
+    struct TraceRecord * tRecord = &EventTrace[EventTraceIndex++ & (EVENT_TRACE_SIZE - 1)];
+    tRecord->Cycles = getCycleCount();
+    tRecord->Exception = 0;
+#else
+    uint32_t tPrimask = __get_PRIMASK();
+    __disable_irq();
+    struct TraceRecord * tRecord = &EventTrace[EventTraceIndex++ & (EVENT_TRACE_SIZE - 1)];
+    tRecord->Cycles = getCycleCount();
+    tRecord->Exception = __get_IPSR();
+#endif
+    tRecord->Argument = aArgument;
+    tRecord->TypeAndId = aTypeAndId;
+#ifndef HOST_SIMULATION
+    __set_PRIMASK(tPrimask);
+#endif
+}
+
+#define TRACE_BEGIN(aId, aArgument) recordTraceEvent((TRACE_TYPE_BEGIN << TRACE_TYPE_SHIFT) | (aId), (aArgument))
+#define TRACE_END(aId) recordTraceEvent((TRACE_TYPE_END << TRACE_TYPE_SHIFT) | (aId), 0)
+#define TRACE_INSTANT(aId, aArgument) recordTraceEvent((TRACE_TYPE_INSTANT << TRACE_TYPE_SHIFT) | (aId), (aArgument))
+
+#ifdef __cplusplus
+/*
+ * Records the end when leaving the scope, so functions with multiple returns need only one line
+ */
+class TraceScope {
+public:
+    TraceScope(uint8_t aId, uint16_t aArgument) :
+            mId(aId) {
+        TRACE_BEGIN(aId, aArgument);
+    }
+    ~TraceScope() {
+        TRACE_END(mId);
+    }
+private:
+    uint8_t mId;
+};
+#define TRACE_SCOPE(aId, aArgument) TraceScope tTraceScope((aId), (aArgument))
+#endif
+
+#else
+#define TRACE_BEGIN(aId, aArgument)
+#define TRACE_END(aId)
+#define TRACE_INSTANT(aId, aArgument)
+#define TRACE_SCOPE(aId, aArgument)
+#endif // USE_EVENT_TRACE
+
+#endif /* EVENTTRACE_H_ */
@@ -0,0 +1,67 @@
+/**
+ * @file Profiler.h
+ *
+ * Statistical profiler, which samples the interrupted program counter at each systic (1 kHz).
+ * The PC is taken from the exception stack frame by SysTick_Handler() and counted in a histogram
+ * with one counter for each bucket of code. The bucket size is the smallest power of 2, for which
+ * PROFILER_HISTOGRAM_SIZE buckets cover the code from flash start to _etext, e.g. 64 bytes for 100 kByte code.
+ * Systics suppressed by tickless idle are counted as idle samples.
+ * The profiler stops itself if a counter would overflow, i.e. after 65 seconds at the earliest.
+ * The histogram is dumped as text to the SD card or over USB CDC and can be symbolized on the host with
+ * tools/host/symbolizeProfile.py, which prints a flat profile per function.
+ *
+ * Dump format:
+ *  # PC profile
+ *  samples <number of samples including idle and dropped samples>
+ *  idle <number of suppressed systics>
+ *  dropped <number of samples with PC outside of code, e.g. code in RAM>
+ *  bucket <size of bucket in bytes>
+ *  <start address of bucket in hex> <count>
+ *  ...
+ *  end
+ *
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ */
+
+#ifndef PROFILER_H_
+#define PROFILER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * SysTick_Handler() samples the PC if the profiler is running. Costs 4 kByte RAM for the histogram.
+ */
+//#define USE_PC_SAMPLING_PROFILER
+
+#define PROFILER_HISTOGRAM_SIZE 2048
+#define PROFILER_MIN_BUCKET_SHIFT 2 // 4 bytes
+#ifdef HOST_SIMULATION
+#define PROFILER_CODE_START 0x00400000 // for executables linked with -no-pie
+#else
+#define PROFILER_CODE_START 0x08000000 // flash
+#endif
+
+struct ProfilerStatistics {
+    uint32_t Samples;
+    uint32_t IdleSamples;
+    uint32_t DroppedSamples;
+    uint16_t UsedBuckets; // set by dumpProfiler()
+    uint8_t BucketShift;
+    uint32_t CodeEnd; // _etext
+    uint32_t StartMillis;
+};
+extern struct ProfilerStatistics ProfilerStatistics;
+
+void startProfiler(void);
+void stopProfiler(void);
+bool isProfilerRunning(void);
+void recordProfilerSample(uint32_t aPC);
+void addProfilerIdleSamples(uint32_t aNumberOfSamples);
+void dumpProfiler(void (*aWriteFunction)(const char * aText, int aLength));
+#ifndef HOST_SIMULATION
+bool dumpProfilerToFile(void);
+bool dumpProfilerToUSB(void);
+#endif
+
+#endif /* PROFILER_H_ */
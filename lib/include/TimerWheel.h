@@ -0,0 +1,56 @@
+/**
+ * @file TimerWheel.h
+ *
+ * Hierarchical timer wheel for the delay callbacks of the SysTick handler.
+ * Each timer is in the slot list of its expire tick. Level 0 has one slot for each of the next TIMER_WHEEL_SLOTS ticks,
+ * each higher level slot covers all slots of the level below. When the lower level has wrapped around,
+ * the timers of the next slot of the higher level are distributed to the lower levels.
+ * So each tick only visits the expiring timers and on average less than one redistributed timer per active timer
+ * and level 0 round.
+ * Insert and cancel are O(1). The timers are additionally hashed by callback to find them for changeTimerWheelCallback().
+ *
+ * The timers are taken from an array supplied by initTimerWheel(). Not reentrant, the caller must lock against the tick.
+ *
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ */
+
+#ifndef TIMERWHEEL_H_
+#define TIMERWHEEL_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define TIMER_WHEEL_SLOT_BITS 5
+#define TIMER_WHEEL_SLOTS (1 << TIMER_WHEEL_SLOT_BITS) // 32 slots per level
+#define TIMER_WHEEL_LEVELS 4 // delays up to 31 * 2^15 ticks (17 minutes) without redistribution at the last level
+// larger delays are put into the last slot of the highest level and redistributed there
+#define TIMER_WHEEL_MAX_DELAY (((unsigned long) TIMER_WHEEL_SLOTS - 1) << (TIMER_WHEEL_SLOT_BITS * (TIMER_WHEEL_LEVELS - 1)))
+#define TIMER_WHEEL_HASH_SIZE 16 // must be power of 2
+
+struct TimerWheelEntry {
+    void (*Callback)(void);
+    uint32_t ExpireTick;
+    struct TimerWheelEntry * Next; // in slot list or free list
+    struct TimerWheelEntry ** PreviousNextPtr; // Next of previous entry or slot list head, for unlinking in O(1)
+    struct TimerWheelEntry * NextInHash;
+    struct TimerWheelEntry ** PreviousNextInHashPtr;
+};
+
+struct TimerWheel {
+    uint32_t Tick; // next tick to process
+    struct TimerWheelEntry * Slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+    struct TimerWheelEntry * Hash[TIMER_WHEEL_HASH_SIZE];
+    struct TimerWheelEntry * FreeList;
+    uint16_t NumberOfActiveTimers;
+    uint16_t MaxNumberOfActiveTimers;
+    uint32_t NumberOfRedistributedTimers;
+    bool IsInitialized;
+};
+
+void initTimerWheel(struct TimerWheel * aWheel, struct TimerWheelEntry * aEntries, uint16_t aNumberOfEntries);
+bool addTimerWheelCallback(struct TimerWheel * aWheel, void (*aCallback)(void), uint32_t aDelayTicks);
+bool changeTimerWheelCallback(struct TimerWheel * aWheel, void (*aCallback)(void), uint32_t aDelayTicks);
+uint16_t doTimerWheelTick(struct TimerWheel * aWheel);
+uint32_t getTimerWheelTicksUntilNextExpiry(struct TimerWheel * aWheel, uint32_t aMaxTicks);
+
+#endif /* TIMERWHEEL_H_ */
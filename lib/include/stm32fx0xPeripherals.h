@@ -206,6 +206,10 @@
 #ifdef STM32F30X
 #include <stm32f3xx.h>
 #endif
+#ifdef HOST_SIMULATION
+// register and handle stand-ins of tools/host
+#include "HostHal.h"
+#endif
 
 #include <stdbool.h>
 
@@ -223,7 +227,8 @@ extern TIM_HandleTypeDef TIM15Handle;
 extern RTC_HandleTypeDef RTCHandle;
 extern SPI_HandleTypeDef SPI1Handle;
 
-#ifdef STM32F303xC
+// host uses the pin mapping of the firmware
+#if defined(STM32F303xC) || defined(HOST_SIMULATION)
 /**
  * ADC 1 for DSO
  */
@@ -458,7 +463,7 @@ void ADC12_SetClockPrescaler(uint32_t aValue);
 
 // ADC DMA
 void ADC1_DMA_initialize(void);
-void ADC1_DMA_start(uint32_t aMemoryBaseAddr, uint16_t aBufferSize, bool aModeCircular);
+void ADC1_DMA_start(uintptr_t aMemoryBaseAddr, uint16_t aBufferSize, bool aModeCircular);
 void ADC1_DMA_stop(void);
 uint16_t DMA11_GetCurrDataCounter(void);
 
@@ -577,6 +582,8 @@ extern "C" {
  * SPI
  */
 extern SPI_HandleTypeDef * SPI1HandlePtr;
+// set by main loop users of SPI1 (SD card, gyroscope) for the whole transaction, so the touch sampling interrupt does not interleave
+extern volatile bool SPI1Busy;
 uint8_t SPI1_sendReceiveFast(uint8_t byte);
 void SPI1_setPrescaler(uint16_t aPrescaler);
 
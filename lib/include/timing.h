@@ -23,6 +23,31 @@
 #include <stm32f3xx.h>
 #endif
 
+/*
+ * Main loops, which call checkAndHandleEventsAndIdle() or delayMillisWithCheckAndHandleEvents(), sleep with WFI
+ * until an interrupt occurs or the next delay callback is due, instead of polling.
+ * The systic interrupts in between are suppressed and counted up after wake up.
+ */
+//#define USE_TICKLESS_IDLE
+
+#ifdef HOST_SIMULATION
+// No SysTick on host
+static inline uint32_t getSysticValue(void) {
+    return 0;
+}
+static inline uint32_t getSysticReloadValue(void) {
+    return 0;
+}
+static inline void clearSystic(void) {
+}
+static inline bool hasSysticCounted(void) {
+    return false;
+}
+// No DWT on host, getCycleCount() returns host time scaled to 72 MHz
+static inline void initCycleCounter(void) {
+}
+uint32_t getCycleCount(void);
+#else
 __STATIC_INLINE uint32_t getSysticValue(void) {
     return SysTick->VAL;
 }
@@ -35,6 +60,18 @@ __STATIC_INLINE void clearSystic(void) {
 __STATIC_INLINE bool hasSysticCounted(void) {
     return (SysTick->CTRL & SysTick_CTRL_COUNTFLAG_Msk);
 }
+/*
+ * Enables the DWT cycle counter. The counter is not reset, since it may be used by others.
+ */
+__STATIC_INLINE void initCycleCounter(void) {
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+// wraps around after 59 seconds at 72 MHz
+__STATIC_INLINE uint32_t getCycleCount(void) {
+    return DWT->CYCCNT;
+}
+#endif
 
 // some microsecond values for timing
 #define ONE_SECOND 1000
@@ -68,6 +105,21 @@ void changeDelayCallback(void (*aGenericCallback)(void), int32_t aTimeMillis);
 
 void doOneSystic(void);
 
+#ifdef USE_TICKLESS_IDLE
+struct IdleStatistics {
+    uint32_t StartMillis;
+    uint32_t Sleeps;
+    uint32_t SuppressedSystics;
+    uint64_t SleepNanos;
+    uint32_t MaxWakeUpNanos; // from wake up until the interrupt which has woken up is enabled again
+};
+extern struct IdleStatistics IdleStatistics;
+void resetIdleStatistics(void);
+uint32_t getIdlePercent(void);
+#endif
+// returns at once without USE_TICKLESS_IDLE
+uint32_t idleMillis(uint32_t aMaxMillis, bool (*aIsWorkPendingFunction)(void));
+
 #define NANOS_ONE_LOOP 139
 void displayTimings(uint16_t aYDisplayPos);
 void testTimingsLoop(int aCount);
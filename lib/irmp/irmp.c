@@ -1386,6 +1386,10 @@ static volatile uint8_t irmp_flags;
 static uint8_t IRMP_PIN;
 #endif
 
+#if defined (ARM_STM32) && defined (USE_DEFERRED_WORK)
+uint8_t irmp_deferred_input;
+#endif
+
 /*---------------------------------------------------------------------------------------------------------------------------------------------------
  *  Initialize IRMP decoder
  *  @details  Configures IRMP input pin
@@ -47,7 +47,15 @@
 #    define IRMP_PORT_RCC                       CONCAT(RCC_AHB1Periph_GPIO, IRMP_PORT_LETTER)
 #  endif
 #  define IRMP_PIN                              IRMP_BIT_NUMBER   // for use with input(x) below
-#  define input(x)                              (HAL_GPIO_ReadPin(IRMP_PORT,x))
+#  include "DeferredWork.h"                     // for USE_DEFERRED_WORK
+#  ifdef USE_DEFERRED_WORK
+// pin is sampled by the timer ISR and irmp_ISR() is called later by PendSV with the sampled value
+extern uint8_t                                  irmp_deferred_input;
+#    define irmp_read_pin()                     (HAL_GPIO_ReadPin(IRMP_PORT,IRMP_PIN))
+#    define input(x)                            (irmp_deferred_input)
+#  else
+#    define input(x)                            (HAL_GPIO_ReadPin(IRMP_PORT,x))
+#  endif
 #  ifndef USE_STDPERIPH_DRIVER
 //#    warning The STM32 port of IRMP uses the ST standard peripheral drivers which are not enabled in your build configuration.
 #  endif
@@ -0,0 +1,246 @@
+/**
+ * @file Benchmark.cpp
+ *
+ * Runs micro benchmarks with the DWT cycle counter and writes the results as CSV. See Benchmark.h.
+ *
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ */
+
+#include "Benchmark.h"
+#include "BlueDisplay.h"
+#include "BlueSerial.h" // for waitForUSARTSendComplete()
+#include "timing.h" // for getCycleCount()
+#ifndef HOST_SIMULATION
+#include "stm32fx0xPeripherals.h" // for Watchdog_reload()
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h> // for qsort()
+
+#ifdef HOST_SIMULATION
+#define BENCHMARK_CYCLES_PER_SECOND 72000000 // host cycles are scaled to the 72 MHz of the target
+#else
+#define BENCHMARK_CYCLES_PER_SECOND SystemCoreClock
+#endif
+
+#define BENCHMARK_CHART_LENGTH 320
+
+#define BENCHMARK_SIGNAL_LENGTH 512
+#define BENCHMARK_SIGNAL_PERIOD 64
+// values of the DSO benchmarks of the benchmark page
+#define BENCHMARK_SIGNAL_LOW 1000
+#define BENCHMARK_SIGNAL_HIGH 3000
+#define BENCHMARK_TRIGGER_LEVEL 2000
+#define BENCHMARK_TRIGGER_LEVEL_HYSTERESIS 1900
+
+uint32_t getBenchmarkCyclesPerSecond(void) {
+    return BENCHMARK_CYCLES_PER_SECOND;
+}
+
+/*
+ * BlueDisplay benchmarks. They measure the time to put the command into the send buffer
+ * and to start the transfer, not the time on the line.
+ * They draw only in the lower half of the screen, to keep the buttons of the benchmark page.
+ */
+static void benchmarkFillRect(int aIteration) {
+    BlueDisplay1.fillRectRel(0, 120, 160, 120, (aIteration & 1) ? COLOR_WHITE : COLOR_BLUE);
+}
+
+static void benchmarkDrawText(int aIteration __attribute__((unused))) {
+    BlueDisplay1.drawText(0, 200, "1.234V 50.00Hz", TEXT_SIZE_11, COLOR_BLACK, COLOR_WHITE);
+}
+
+static void benchmarkDrawLine(int aIteration __attribute__((unused))) {
+    BlueDisplay1.drawLine(0, 120, 319, 239, COLOR_RED);
+}
+
+/*
+ * Alternates between 2 signals, so chart delta encoding has the same work for every iteration
+ */
+static void benchmarkDrawChart(int aIteration) {
+    static uint8_t sChartBuffers[2][BENCHMARK_CHART_LENGTH];
+    static bool sChartBuffersInitialized = false;
+    if (!sChartBuffersInitialized) {
+        for (int i = 0; i < BENCHMARK_CHART_LENGTH; ++i) {
+            // triangle, second signal shifted by a quarter period
+            sChartBuffers[0][i] = 20 + abs((i % 64) - 32) * 2;
+            sChartBuffers[1][i] = 20 + abs(((i + 16) % 64) - 32) * 2;
+        }
+        sChartBuffersInitialized = true;
+    }
+    BlueDisplay1.drawChartByteBuffer(0, 120, COLOR_BLUE, COLOR_WHITE, sChartBuffers[aIteration & 1], BENCHMARK_CHART_LENGTH);
+}
+
+const struct Benchmark DisplayBenchmarks[NUMBER_OF_DISPLAY_BENCHMARKS] = { { "fillRect", &benchmarkFillRect, 0, false }, {
+        "drawText", &benchmarkDrawText, 0, false }, { "drawLine", &benchmarkDrawLine, 0, false }, { "drawChartByteBuffer",
+        &benchmarkDrawChart, BENCHMARK_CHART_LENGTH, false } };
+
+/*
+ * Signal benchmarks. Plain C copies of the inner loops of DMACheckForTriggerCondition() and
+ * computeMinMaxAverageAndPeriodFrequency() of the DSO, working on a buffer instead of the DSO data buffer.
+ */
+static uint16_t sSignalBuffer[BENCHMARK_SIGNAL_LENGTH];
+static volatile uint32_t sSignalResult; // keeps the compiler from removing the loops
+
+/*
+ * Low level and then 2 periods of a square wave at the end,
+ * so the trigger scan runs over nearly the whole buffer like the trigger scan of the benchmark page
+ */
+static void initSignalBuffer(void) {
+    static bool sSignalBufferInitialized = false;
+    if (!sSignalBufferInitialized) {
+        for (int i = 0; i < BENCHMARK_SIGNAL_LENGTH; ++i) {
+            uint16_t tValue = ((i / (BENCHMARK_SIGNAL_PERIOD / 2)) & 1) ? BENCHMARK_SIGNAL_HIGH : BENCHMARK_SIGNAL_LOW;
+            if (i < BENCHMARK_SIGNAL_LENGTH - 2 * BENCHMARK_SIGNAL_PERIOD) {
+                tValue = BENCHMARK_SIGNAL_LOW;
+            }
+            sSignalBuffer[i] = tValue;
+        }
+        sSignalBufferInitialized = true;
+    }
+}
+
+/*
+ * Rising slope with hysteresis
+ */
+static void benchmarkTriggerScanBuffer(int aIteration __attribute__((unused))) {
+    initSignalBuffer();
+    bool tBeforeThreshold = false;
+    uint16_t tActualCompareValue = BENCHMARK_TRIGGER_LEVEL_HYSTERESIS;
+    int i;
+    for (i = 0; i < BENCHMARK_SIGNAL_LENGTH; ++i) {
+        bool tValueGreaterRef = (sSignalBuffer[i] > tActualCompareValue);
+        if (!tBeforeThreshold) {
+            // wait for value below 1. threshold
+            if (!tValueGreaterRef) {
+                tBeforeThreshold = true;
+                tActualCompareValue = BENCHMARK_TRIGGER_LEVEL;
+            }
+        } else if (tValueGreaterRef) {
+            // value rises above 2. threshold
+            break;
+        }
+    }
+    sSignalResult = i;
+}
+
+/*
+ * Min, max, average and number of periods
+ */
+static void benchmarkMinMaxBuffer(int aIteration __attribute__((unused))) {
+    initSignalBuffer();
+    uint16_t tMin = sSignalBuffer[0];
+    uint16_t tMax = tMin;
+    uint32_t tIntegrateValue = 0;
+    int tCount = 0;
+    bool tBeforeThreshold = false;
+    uint16_t tActualCompareValue = BENCHMARK_TRIGGER_LEVEL_HYSTERESIS;
+    for (int i = 0; i < BENCHMARK_SIGNAL_LENGTH; ++i) {
+        uint16_t tValue = sSignalBuffer[i];
+        bool tValueGreaterRef = (tValue > tActualCompareValue);
+        if (!tBeforeThreshold) {
+            if (!tValueGreaterRef) {
+                tBeforeThreshold = true;
+                tActualCompareValue = BENCHMARK_TRIGGER_LEVEL;
+            }
+        } else if (tValueGreaterRef) {
+            // found and search for next slope
+            tCount++;
+            tBeforeThreshold = false;
+            tActualCompareValue = BENCHMARK_TRIGGER_LEVEL_HYSTERESIS;
+        }
+        tIntegrateValue += tValue;
+        if (tValue > tMax) {
+            tMax = tValue;
+        }
+        if (tValue < tMin) {
+            tMin = tValue;
+        }
+    }
+    sSignalResult = tMin + tMax + tIntegrateValue / BENCHMARK_SIGNAL_LENGTH + tCount;
+}
+
+const struct Benchmark SignalBenchmarks[NUMBER_OF_SIGNAL_BENCHMARKS] = { { "trigger scan buffer",
+        &benchmarkTriggerScanBuffer, BENCHMARK_SIGNAL_LENGTH * sizeof(sSignalBuffer[0]), false }, { "min/max buffer",
+        &benchmarkMinMaxBuffer, BENCHMARK_SIGNAL_LENGTH * sizeof(sSignalBuffer[0]), false } };
+
+static int compareCycles(const void * aFirst, const void * aSecond) {
+    uint32_t tFirst = *(const uint32_t *) aFirst;
+    uint32_t tSecond = *(const uint32_t *) aSecond;
+    return (tFirst > tSecond) - (tFirst < tSecond);
+}
+
+/**
+ * Calls the function once for warm up and then BENCHMARK_ITERATIONS times.
+ * Draining the send buffer and reloading the watchdog is done before the measurement.
+ */
+void runBenchmark(const struct Benchmark * aBenchmark, struct BenchmarkResult * aResult) {
+    uint32_t tCycles[BENCHMARK_ITERATIONS];
+    // warm up with the input of the last iteration, so the first one sees the same previous state as the others
+    aBenchmark->Function(BENCHMARK_ITERATIONS - 1);
+    for (int i = 0; i < BENCHMARK_ITERATIONS; ++i) {
+        waitForUSARTSendComplete();
+#ifdef HAL_WWDG_MODULE_ENABLED
+        Watchdog_reload();
+#endif
+        uint32_t tStartCycles = getCycleCount();
+        aBenchmark->Function(i);
+        tCycles[i] = getCycleCount() - tStartCycles;
+    }
+    waitForUSARTSendComplete();
+
+    qsort(tCycles, BENCHMARK_ITERATIONS, sizeof(tCycles[0]), &compareCycles);
+    aResult->Name = aBenchmark->Name;
+    aResult->MinCycles = tCycles[0];
+    aResult->MedianCycles = tCycles[BENCHMARK_ITERATIONS / 2];
+    aResult->MaxCycles = tCycles[BENCHMARK_ITERATIONS - 1];
+    aResult->BytesPerIteration = aBenchmark->BytesPerIteration;
+    aResult->TargetOnly = aBenchmark->TargetOnly;
+}
+
+static uint32_t getMedianMicros(const struct BenchmarkResult * aResult) {
+    return ((uint64_t) aResult->MedianCycles * 1000000) / BENCHMARK_CYCLES_PER_SECOND;
+}
+
+/*
+ * kByte/s of median, 0 if not applicable
+ */
+static uint32_t getKBytePerSecond(const struct BenchmarkResult * aResult) {
+    if (aResult->BytesPerIteration == 0 || aResult->MedianCycles == 0) {
+        return 0;
+    }
+    return ((uint64_t) aResult->BytesPerIteration * BENCHMARK_CYCLES_PER_SECOND) / aResult->MedianCycles / 1000;
+}
+
+/**
+ * Formats one line for the display
+ * @return length of string
+ */
+int formatBenchmarkResult(char * aBuffer, size_t aSize, const struct BenchmarkResult * aResult) {
+    int tLength = snprintf(aBuffer, aSize, "%-20s %7lu %7luus", aResult->Name, (unsigned long) aResult->MedianCycles,
+            (unsigned long) getMedianMicros(aResult));
+    if (aResult->BytesPerIteration != 0 && tLength < (int) aSize) {
+        tLength += snprintf(&aBuffer[tLength], aSize - tLength, " %4lukB/s",
+                (unsigned long) getKBytePerSecond(aResult));
+    }
+    return tLength;
+}
+
+void writeBenchmarkCSV(const struct BenchmarkResult * aResults, int aNumberOfResults, const char * aVersion,
+        void (*aWriteFunction)(const char * aText, int aLength)) {
+    char tLine[96];
+    int tLength = snprintf(tLine, sizeof(tLine), "# benchmark %s %lu\n", aVersion,
+            (unsigned long) BENCHMARK_CYCLES_PER_SECOND);
+    aWriteFunction(tLine, tLength);
+    const char tHeader[] = "name,iterations,min cycles,median cycles,max cycles,median us,bytes,kbyte/s,target only\n";
+    aWriteFunction(tHeader, sizeof(tHeader) - 1);
+    for (int i = 0; i < aNumberOfResults; ++i) {
+        const struct BenchmarkResult * tResult = &aResults[i];
+        tLength = snprintf(tLine, sizeof(tLine), "%s,%d,%lu,%lu,%lu,%lu,%u,%lu,%d\n", tResult->Name, BENCHMARK_ITERATIONS,
+                (unsigned long) tResult->MinCycles, (unsigned long) tResult->MedianCycles,
+                (unsigned long) tResult->MaxCycles, (unsigned long) getMedianMicros(tResult),
+                tResult->BytesPerIteration, (unsigned long) getKBytePerSecond(tResult), tResult->TargetOnly);
+        aWriteFunction(tLine, tLength);
+    }
+}
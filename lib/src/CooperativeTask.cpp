@@ -0,0 +1,90 @@
+/**
+ * @file CooperativeTask.cpp
+ *
+ * Cooperative tasks. See CooperativeTask.h.
+ *
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ */
+
+#include "CooperativeTask.h"
+
+#ifndef HOST_SIMULATION
+#include <stm32f3xx.h>
+#include <core_cmInstr.h>
+#endif
+#include <stddef.h> // for NULL
+
+// Tasks are never unlinked, so starting a task from an ISR does not conflict with runCooperativeTasks()
+static struct CooperativeTask * sTaskList = NULL;
+static bool sTasksAreRunning = false; // guard against recursive call by an event handler
+
+/**
+ * May be called from an ISR, e.g. for a screenshot by the user button
+ * @return false if task is already running
+ */
+bool startCooperativeTask(struct CooperativeTask * aTask, bool (*aTaskFunction)(struct CooperativeTask * aTask)) {
+    if (aTask->IsRunning) {
+        return false;
+    }
+    aTask->TaskFunction = aTaskFunction;
+    aTask->ResumeLine = 0;
+    aTask->Steps = 0;
+    if (!aTask->IsLinked) {
+#ifndef HOST_SIMULATION
+        uint32_t tPrimask = __get_PRIMASK();
+        __disable_irq();
+#endif
+        aTask->Next = sTaskList;
+        sTaskList = aTask;
+        aTask->IsLinked = true;
+#ifndef HOST_SIMULATION
+        __set_PRIMASK(tPrimask);
+#endif
+    }
+    aTask->IsRunning = true;
+    return true;
+}
+
+/**
+ * Task function is not called again. Must not be called by the task function itself, use TASK_EXIT() instead.
+ */
+void stopCooperativeTask(struct CooperativeTask * aTask) {
+    aTask->IsRunning = false;
+}
+
+bool isCooperativeTaskRunning(struct CooperativeTask * aTask) {
+    return aTask->IsRunning;
+}
+
+bool areCooperativeTasksRunning(void) {
+    for (struct CooperativeTask * tTask = sTaskList; tTask != NULL; tTask = tTask->Next) {
+        if (tTask->IsRunning) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Calls each running task once
+ * @return true if tasks are still running
+ */
+bool runCooperativeTasks(void) {
+    if (sTasksAreRunning) {
+        return true;
+    }
+    sTasksAreRunning = true;
+    bool tTasksAreStillRunning = false;
+    for (struct CooperativeTask * tTask = sTaskList; tTask != NULL; tTask = tTask->Next) {
+        if (tTask->IsRunning) {
+            tTask->Steps++;
+            if (tTask->TaskFunction(tTask)) {
+                tTask->IsRunning = false;
+            } else if (tTask->IsRunning) {
+                tTasksAreStillRunning = true;
+            }
+        }
+    }
+    sTasksAreRunning = false;
+    return tTasksAreStillRunning;
+}
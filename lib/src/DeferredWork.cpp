@@ -0,0 +1,90 @@
+/**
+ * @file DeferredWork.cpp
+ *
+ * Work deferred by ISRs to PendSV. See DeferredWork.h.
+ *
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ */
+
+#include "DeferredWork.h"
+
+#ifndef HOST_SIMULATION
+#include <stm32f3xx.h>
+#endif
+#include <string.h> // for memset
+
+static struct DeferredWorkQueue sDeferredWorkQueues[NUMBER_OF_DEFERRED_WORK_QUEUES];
+
+/**
+ * Set PendSV to lowest priority, so that deferred work never delays another ISR
+ */
+void initDeferredWork(void) {
+    memset(sDeferredWorkQueues, 0, sizeof(sDeferredWorkQueues));
+#ifndef HOST_SIMULATION
+    NVIC_SetPriority(PendSV_IRQn, DEFERRED_WORK_PENDSV_PRIO);
+#endif
+}
+
+/**
+ * Must only be called by the one producer of the queue.
+ * Work queued by an ISR is executed after the ISR and all other ISRs have ended.
+ * On host, runDeferredWork() must be called explicitly.
+ * @return false if queue is full and work was discarded
+ */
+bool queueDeferredWork(uint8_t aQueueIndex, void (*aFunction)(uint32_t aArgument), uint32_t aArgument) {
+    struct DeferredWorkQueue * tQueue = &sDeferredWorkQueues[aQueueIndex];
+    uint8_t tIn = tQueue->In;
+    uint8_t tFill = (uint8_t) (tIn - tQueue->Out);
+    if (tFill >= DEFERRED_WORK_QUEUE_SIZE) {
+        tQueue->Overflows++;
+        return false;
+    }
+    if (tQueue->MaxFill <= tFill) {
+        tQueue->MaxFill = tFill + 1;
+    }
+    struct DeferredWork * tWork = &tQueue->Work[tIn & (DEFERRED_WORK_QUEUE_SIZE - 1)];
+    tWork->Function = aFunction;
+    tWork->Argument = aArgument;
+#ifdef HOST_SIMULATION
+    __sync_synchronize();
+#else
+    __DMB(); // work item must be complete before PendSV can see the new In
+#endif
+    tQueue->In = tIn + 1;
+#ifndef HOST_SIMULATION
+    SCB->ICSR = SCB_ICSR_PENDSVSET_Msk;
+#endif
+    return true;
+}
+
+/**
+ * Executes all queued work. Work queued while running is executed too.
+ */
+void runDeferredWork(void) {
+    bool tWorkFound;
+    do {
+        tWorkFound = false;
+        for (uint8_t i = 0; i < NUMBER_OF_DEFERRED_WORK_QUEUES; ++i) {
+            struct DeferredWorkQueue * tQueue = &sDeferredWorkQueues[i];
+            uint8_t tOut = tQueue->Out;
+            while (tOut != tQueue->In) {
+                struct DeferredWork * tWork = &tQueue->Work[tOut & (DEFERRED_WORK_QUEUE_SIZE - 1)];
+                tWork->Function(tWork->Argument);
+                tOut++;
+                // slot may be reused by the producer from now on
+                tQueue->Out = tOut;
+                tWorkFound = true;
+            }
+        }
+    } while (tWorkFound);
+}
+
+struct DeferredWorkQueue * getDeferredWorkQueue(uint8_t aQueueIndex) {
+    return &sDeferredWorkQueues[aQueueIndex];
+}
+
+#ifndef HOST_SIMULATION
+extern "C" void PendSV_Handler(void) {
+    runDeferredWork();
+}
+#endif
@@ -0,0 +1,115 @@
+/**
+ * @file EventTrace.cpp
+ *
+ * Ring buffer of trace records with DWT cycle counter timestamps. See EventTrace.h.
+ *
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ */
+
+#include "EventTrace.h"
+
+#ifdef USE_EVENT_TRACE
+#ifndef HOST_SIMULATION
+#include "stm32fx0xPeripherals.h" // for MICROSD_isCardInserted()
+#include "BlueDisplay.h" // for StringBuffer
+extern "C" {
+#include "ff.h"
+}
+#endif
+#include <string.h>
+
+#ifdef HOST_SIMULATION
+#define EVENT_TRACE_CYCLES_PER_SECOND 72000000 // host timestamps are scaled to the 72 MHz of the target
+#else
+#define EVENT_TRACE_CYCLES_PER_SECOND SystemCoreClock
+#endif
+
+struct TraceRecord EventTrace[EVENT_TRACE_SIZE];
+volatile uint32_t EventTraceIndex;
+volatile bool EventTraceIsEnabled = false;
+
+// index is TRACE_ID_*
+static const char * const sEventTraceNames[NUMBER_OF_TRACE_IDS] = { "startAcquisition", "DMA complete", "trigger",
+        "drawDataBuffer", "printInfo", "sendUSARTBuffer", "page" };
+
+/**
+ * Enables the DWT cycle counter and starts recording
+ */
+void initEventTrace(void) {
+    EventTraceIsEnabled = false;
+    memset(EventTrace, 0, sizeof(EventTrace));
+    EventTraceIndex = 0;
+    initCycleCounter();
+    EventTraceIsEnabled = true;
+}
+
+static void writeUint16(void (*aWriteFunction)(const char * aData, int aLength), uint16_t aValue) {
+    char tBytes[2] = { (char) aValue, (char) (aValue >> 8) };
+    aWriteFunction(tBytes, 2);
+}
+
+static void writeUint32(void (*aWriteFunction)(const char * aData, int aLength), uint32_t aValue) {
+    writeUint16(aWriteFunction, aValue);
+    writeUint16(aWriteFunction, aValue >> 16);
+}
+
+/**
+ * Writes the ring, oldest record first. Recording is stopped during the dump and restarted afterwards.
+ */
+void dumpEventTrace(void (*aWriteFunction)(const char * aData, int aLength)) {
+    bool tWasEnabled = EventTraceIsEnabled;
+    EventTraceIsEnabled = false;
+    uint32_t tIndex = EventTraceIndex;
+    uint32_t tNumberOfRecords = EVENT_TRACE_SIZE;
+    if (tIndex < EVENT_TRACE_SIZE) {
+        tNumberOfRecords = tIndex;
+    }
+
+    aWriteFunction("ETRC", 4);
+    writeUint16(aWriteFunction, EVENT_TRACE_VERSION);
+    writeUint16(aWriteFunction, tNumberOfRecords);
+    writeUint32(aWriteFunction, EVENT_TRACE_CYCLES_PER_SECOND);
+    writeUint32(aWriteFunction, tIndex - tNumberOfRecords);
+    char tNumberOfNames = NUMBER_OF_TRACE_IDS;
+    aWriteFunction(&tNumberOfNames, 1);
+    for (int i = 0; i < NUMBER_OF_TRACE_IDS; ++i) {
+        aWriteFunction(sEventTraceNames[i], strlen(sEventTraceNames[i]) + 1);
+    }
+
+    for (uint32_t i = tIndex - tNumberOfRecords; i != tIndex; ++i) {
+        struct TraceRecord * tRecord = &EventTrace[i & (EVENT_TRACE_SIZE - 1)];
+        writeUint32(aWriteFunction, tRecord->Cycles);
+        writeUint16(aWriteFunction, tRecord->Argument);
+        aWriteFunction((const char *) &tRecord->TypeAndId, 1);
+        aWriteFunction((const char *) &tRecord->Exception, 1);
+    }
+    EventTraceIsEnabled = tWasEnabled;
+}
+
+#ifndef HOST_SIMULATION
+static FIL sEventTraceFile;
+
+static void writeToEventTraceFile(const char * aData, int aLength) {
+    UINT tCount;
+    f_write(&sEventTraceFile, aData, aLength, &tCount);
+}
+
+/**
+ * Writes the ring to <date>.trc on the SD card
+ * @return false if no card or file could not be opened
+ */
+bool dumpEventTraceToFile(void) {
+    if (!MICROSD_isCardInserted()) {
+        return false;
+    }
+    RTC_getDateStringForFile(StringBuffer);
+    strcat(StringBuffer, ".trc");
+    if (f_open(&sEventTraceFile, StringBuffer, FA_CREATE_ALWAYS | FA_WRITE) != FR_OK) {
+        return false;
+    }
+    dumpEventTrace(&writeToEventTraceFile);
+    f_close(&sEventTraceFile);
+    return true;
+}
+#endif // HOST_SIMULATION
+#endif // USE_EVENT_TRACE
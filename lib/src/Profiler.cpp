@@ -0,0 +1,178 @@
+/**
+ * @file Profiler.cpp
+ *
+ * Statistical PC sampling profiler. See Profiler.h.
+ *
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ */
+
+#include "Profiler.h"
+
+#ifdef HOST_SIMULATION
+#include "timing.h" // for getMillisSinceBoot()
+#else
+#include "stm32fx0xPeripherals.h" // for MICROSD_isCardInserted()
+#include "timing.h"
+#include "BlueDisplay.h" // for StringBuffer
+extern "C" {
+#include "ff.h"
+#include "usbd_misc.h"
+#include "usbd_cdc.h"
+}
+#endif
+#include <stdio.h>
+#include <string.h>
+
+#ifdef USE_PC_SAMPLING_PROFILER
+struct ProfilerStatistics ProfilerStatistics;
+
+static uint16_t sProfilerHistogram[PROFILER_HISTOGRAM_SIZE];
+static volatile bool sProfilerIsRunning = false;
+extern char CodeEnd asm("_etext");
+
+void startProfiler(void) {
+    sProfilerIsRunning = false;
+    memset(sProfilerHistogram, 0, sizeof(sProfilerHistogram));
+    memset(&ProfilerStatistics, 0, sizeof(ProfilerStatistics));
+    ProfilerStatistics.CodeEnd = (uint32_t) (uintptr_t) &CodeEnd;
+    uint8_t tBucketShift = PROFILER_MIN_BUCKET_SHIFT;
+    while (((ProfilerStatistics.CodeEnd - PROFILER_CODE_START) >> tBucketShift) >= PROFILER_HISTOGRAM_SIZE) {
+        tBucketShift++;
+    }
+    ProfilerStatistics.BucketShift = tBucketShift;
+    ProfilerStatistics.StartMillis = getMillisSinceBoot();
+    sProfilerIsRunning = true;
+}
+
+void stopProfiler(void) {
+    sProfilerIsRunning = false;
+}
+
+bool isProfilerRunning(void) {
+    return sProfilerIsRunning;
+}
+
+/**
+ * Called by SysTick_Handler() with the PC of the interrupted code. Approximately 15 cycles.
+ * Stops the profiler if the counter would overflow, to keep the relations between the counters.
+ */
+void recordProfilerSample(uint32_t aPC) {
+    if (!sProfilerIsRunning) {
+        return;
+    }
+    ProfilerStatistics.Samples++;
+    uint32_t tBucket = (aPC - PROFILER_CODE_START) >> ProfilerStatistics.BucketShift;
+    if (tBucket >= PROFILER_HISTOGRAM_SIZE) {
+        // e.g. code in RAM
+        ProfilerStatistics.DroppedSamples++;
+        return;
+    }
+    if (sProfilerHistogram[tBucket] == 0xFFFF) {
+        ProfilerStatistics.Samples--;
+        sProfilerIsRunning = false;
+        return;
+    }
+    sProfilerHistogram[tBucket]++;
+}
+
+/**
+ * Called after wake up from tickless idle with the number of suppressed systics
+ */
+void addProfilerIdleSamples(uint32_t aNumberOfSamples) {
+    if (sProfilerIsRunning) {
+        ProfilerStatistics.Samples += aNumberOfSamples;
+        ProfilerStatistics.IdleSamples += aNumberOfSamples;
+    }
+}
+
+/**
+ * Writes the histogram as text lines. Should be called after stopProfiler() to get consistent numbers.
+ */
+void dumpProfiler(void (*aWriteFunction)(const char * aText, int aLength)) {
+    char tLine[32];
+    int tLength = snprintf(tLine, sizeof tLine, "# PC profile\n");
+    aWriteFunction(tLine, tLength);
+    tLength = snprintf(tLine, sizeof tLine, "samples %lu\n", (unsigned long) ProfilerStatistics.Samples);
+    aWriteFunction(tLine, tLength);
+    tLength = snprintf(tLine, sizeof tLine, "idle %lu\n", (unsigned long) ProfilerStatistics.IdleSamples);
+    aWriteFunction(tLine, tLength);
+    tLength = snprintf(tLine, sizeof tLine, "dropped %lu\n", (unsigned long) ProfilerStatistics.DroppedSamples);
+    aWriteFunction(tLine, tLength);
+    tLength = snprintf(tLine, sizeof tLine, "bucket %d\n", 1 << ProfilerStatistics.BucketShift);
+    aWriteFunction(tLine, tLength);
+    ProfilerStatistics.UsedBuckets = 0;
+    for (int i = 0; i < PROFILER_HISTOGRAM_SIZE; ++i) {
+        if (sProfilerHistogram[i] != 0) {
+            ProfilerStatistics.UsedBuckets++;
+            tLength = snprintf(tLine, sizeof tLine, "%08lX %u\n",
+                    (unsigned long) (PROFILER_CODE_START + (i << ProfilerStatistics.BucketShift)), sProfilerHistogram[i]);
+            aWriteFunction(tLine, tLength);
+        }
+    }
+    aWriteFunction("end\n", 4);
+}
+
+#ifndef HOST_SIMULATION
+static FIL sProfilerFile;
+
+static void writeToProfilerFile(const char * aText, int aLength) {
+    UINT tCount;
+    f_write(&sProfilerFile, aText, aLength, &tCount);
+}
+
+/**
+ * Writes the histogram to <date>.prf on the SD card
+ * @return false if no card or file could not be opened
+ */
+bool dumpProfilerToFile(void) {
+    if (!MICROSD_isCardInserted()) {
+        return false;
+    }
+    RTC_getDateStringForFile(StringBuffer);
+    strcat(StringBuffer, ".prf");
+    if (f_open(&sProfilerFile, StringBuffer, FA_CREATE_ALWAYS | FA_WRITE) != FR_OK) {
+        return false;
+    }
+    dumpProfiler(&writeToProfilerFile);
+    f_close(&sProfilerFile);
+    return true;
+}
+
+// the USB library reads the buffer while the next line is written to the other one
+static char sProfilerUSBLines[2][32];
+static uint8_t sProfilerUSBLineIndex;
+// if the host does not read, the dump is aborted
+#define PROFILER_USB_TIMEOUT_MILLIS 100
+static bool sProfilerUSBTimeout;
+
+static void writeToUSB(const char * aText, int aLength) {
+    if (sProfilerUSBTimeout) {
+        return;
+    }
+    char * tLine = sProfilerUSBLines[sProfilerUSBLineIndex];
+    sProfilerUSBLineIndex ^= 1;
+    memcpy(tLine, aText, aLength);
+    USBD_CDC_SetTxBuffer(&USBDDeviceHandle, (uint8_t*) tLine, aLength);
+    uint32_t tStartMillis = getMillisSinceBoot();
+    while (USBD_CDC_TransmitPacket(&USBDDeviceHandle) == USBD_BUSY) {
+        if (getMillisSinceBoot() - tStartMillis > PROFILER_USB_TIMEOUT_MILLIS) {
+            sProfilerUSBTimeout = true;
+            return;
+        }
+    }
+}
+
+/**
+ * Sends the histogram over USB CDC, e.g. to be captured by "cat /dev/ttyACM0 > profile.prf"
+ * @return false if USB is not configured as CDC or the host did not read for PROFILER_USB_TIMEOUT_MILLIS
+ */
+bool dumpProfilerToUSB(void) {
+    if (!isUsbCdcReady()) {
+        return false;
+    }
+    sProfilerUSBTimeout = false;
+    dumpProfiler(&writeToUSB);
+    return !sProfilerUSBTimeout;
+}
+#endif // HOST_SIMULATION
+#endif // USE_PC_SAMPLING_PROFILER
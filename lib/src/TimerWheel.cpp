@@ -0,0 +1,222 @@
+/**
+ * @file TimerWheel.cpp
+ *
+ * Hierarchical timer wheel. See TimerWheel.h.
+ *
+ * Usage:
+ *  initTimerWheel() once, then doTimerWheelTick() for each tick.
+ *  addTimerWheelCallback() and changeTimerWheelCallback() with a delay of n ticks call the callback at the n-th following tick.
+ *  getTimerWheelTicksUntilNextExpiry() tells how many ticks can be skipped by a tickless idle.
+ *
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ */
+
+#include "TimerWheel.h"
+
+#include <stddef.h> // for NULL
+#include <stdint.h>
+#include <string.h> // for memset
+
+#define TIMER_WHEEL_SLOT_MASK (TIMER_WHEEL_SLOTS - 1)
+
+static uint8_t getHashIndex(void (*aCallback)(void)) {
+    uintptr_t tAddress = (uintptr_t) aCallback;
+    return ((tAddress >> 2) ^ (tAddress >> 7)) & (TIMER_WHEEL_HASH_SIZE - 1);
+}
+
+static void linkEntry(struct TimerWheelEntry ** aListHeadPtr, struct TimerWheelEntry * aEntry) {
+    aEntry->Next = *aListHeadPtr;
+    if (aEntry->Next != NULL) {
+        aEntry->Next->PreviousNextPtr = &aEntry->Next;
+    }
+    aEntry->PreviousNextPtr = aListHeadPtr;
+    *aListHeadPtr = aEntry;
+}
+
+static void unlinkEntry(struct TimerWheelEntry * aEntry) {
+    *aEntry->PreviousNextPtr = aEntry->Next;
+    if (aEntry->Next != NULL) {
+        aEntry->Next->PreviousNextPtr = aEntry->PreviousNextPtr;
+    }
+}
+
+/*
+ * Puts entry in the slot of the lowest level, which covers its expire tick.
+ * The level is chosen by the distance of the slot of the expire tick to the actual slot and not by the delay,
+ * otherwise the entry could get into the actual slot of a higher level, which is redistributed only at its next round.
+ */
+static void insertEntry(struct TimerWheel * aWheel, struct TimerWheelEntry * aEntry) {
+    uint32_t tDelay = aEntry->ExpireTick - aWheel->Tick;
+    if (tDelay > TIMER_WHEEL_MAX_DELAY) {
+        // put in the last slot, it is redistributed there with its real expire tick
+        tDelay = TIMER_WHEEL_MAX_DELAY;
+    }
+    uint8_t tShift = 0;
+    while (tShift < TIMER_WHEEL_SLOT_BITS * (TIMER_WHEEL_LEVELS - 1)
+            && (((aWheel->Tick & ((1UL << tShift) - 1)) + tDelay) >> tShift) >= TIMER_WHEEL_SLOTS) {
+        tShift += TIMER_WHEEL_SLOT_BITS;
+    }
+    uint32_t tSlotIndex = ((aWheel->Tick >> tShift) + (((aWheel->Tick & ((1UL << tShift) - 1)) + tDelay) >> tShift))
+            & TIMER_WHEEL_SLOT_MASK;
+    linkEntry(&aWheel->Slots[tShift / TIMER_WHEEL_SLOT_BITS][tSlotIndex], aEntry);
+}
+
+/*
+ * Removes entry from its slot and from hash and puts it into the free list
+ */
+static void freeEntry(struct TimerWheel * aWheel, struct TimerWheelEntry * aEntry) {
+    unlinkEntry(aEntry);
+    *aEntry->PreviousNextInHashPtr = aEntry->NextInHash;
+    if (aEntry->NextInHash != NULL) {
+        aEntry->NextInHash->PreviousNextInHashPtr = aEntry->PreviousNextInHashPtr;
+    }
+    aEntry->Callback = NULL;
+    aEntry->Next = aWheel->FreeList;
+    aWheel->FreeList = aEntry;
+    aWheel->NumberOfActiveTimers--;
+}
+
+void initTimerWheel(struct TimerWheel * aWheel, struct TimerWheelEntry * aEntries, uint16_t aNumberOfEntries) {
+    memset(aWheel, 0, sizeof(struct TimerWheel));
+    memset(aEntries, 0, aNumberOfEntries * sizeof(struct TimerWheelEntry));
+    for (uint16_t i = 0; i < aNumberOfEntries; ++i) {
+        aEntries[i].Next = aWheel->FreeList;
+        aWheel->FreeList = &aEntries[i];
+    }
+    aWheel->IsInitialized = true;
+}
+
+/**
+ * Does not check if callback is already registered, if check is needed use changeTimerWheelCallback()
+ * @param aDelayTicks callback is called at the aDelayTicks-th following tick, 0 calls it at the next tick
+ * @return false if no free entry is left
+ */
+bool addTimerWheelCallback(struct TimerWheel * aWheel, void (*aCallback)(void), uint32_t aDelayTicks) {
+    struct TimerWheelEntry * tEntry = aWheel->FreeList;
+    if (tEntry == NULL) {
+        return false;
+    }
+    aWheel->FreeList = tEntry->Next;
+    tEntry->Callback = aCallback;
+    if (aDelayTicks > 0) {
+        aDelayTicks--;
+    }
+    tEntry->ExpireTick = aWheel->Tick + aDelayTicks;
+    insertEntry(aWheel, tEntry);
+
+    struct TimerWheelEntry ** tHashHeadPtr = &aWheel->Hash[getHashIndex(aCallback)];
+    tEntry->NextInHash = *tHashHeadPtr;
+    if (tEntry->NextInHash != NULL) {
+        tEntry->NextInHash->PreviousNextInHashPtr = &tEntry->NextInHash;
+    }
+    tEntry->PreviousNextInHashPtr = tHashHeadPtr;
+    *tHashHeadPtr = tEntry;
+
+    aWheel->NumberOfActiveTimers++;
+    if (aWheel->MaxNumberOfActiveTimers < aWheel->NumberOfActiveTimers) {
+        aWheel->MaxNumberOfActiveTimers = aWheel->NumberOfActiveTimers;
+    }
+    return true;
+}
+
+/**
+ * Changes the delay of the last added timer with this callback or adds one if not existent
+ * @param aDelayTicks 0 cancels the timer
+ * @return false if no free entry is left
+ */
+bool changeTimerWheelCallback(struct TimerWheel * aWheel, void (*aCallback)(void), uint32_t aDelayTicks) {
+    struct TimerWheelEntry * tEntry = aWheel->Hash[getHashIndex(aCallback)];
+    while (tEntry != NULL && tEntry->Callback != aCallback) {
+        tEntry = tEntry->NextInHash;
+    }
+    if (tEntry == NULL) {
+        if (aDelayTicks == 0) {
+            return true;
+        }
+        return addTimerWheelCallback(aWheel, aCallback, aDelayTicks);
+    }
+    if (aDelayTicks == 0) {
+        freeEntry(aWheel, tEntry);
+    } else {
+        unlinkEntry(tEntry);
+        tEntry->ExpireTick = aWheel->Tick + aDelayTicks - 1;
+        insertEntry(aWheel, tEntry);
+    }
+    return true;
+}
+
+/*
+ * Moves the timers of the actual slot of aLevel to the lower levels
+ * @return true if the slot index of aLevel has wrapped around, i.e. the next level must be redistributed too
+ */
+static bool redistributeSlot(struct TimerWheel * aWheel, uint8_t aLevel) {
+    uint8_t tIndex = (aWheel->Tick >> (aLevel * TIMER_WHEEL_SLOT_BITS)) & TIMER_WHEEL_SLOT_MASK;
+    struct TimerWheelEntry * tEntry = aWheel->Slots[aLevel][tIndex];
+    aWheel->Slots[aLevel][tIndex] = NULL;
+    while (tEntry != NULL) {
+        struct TimerWheelEntry * tNextEntry = tEntry->Next;
+        insertEntry(aWheel, tEntry);
+        aWheel->NumberOfRedistributedTimers++;
+        tEntry = tNextEntry;
+    }
+    return tIndex == 0;
+}
+
+/**
+ * Calls the callbacks of all timers expiring at this tick. A callback may add, change or cancel timers.
+ * @return number of called callbacks
+ */
+uint16_t doTimerWheelTick(struct TimerWheel * aWheel) {
+    if ((aWheel->Tick & TIMER_WHEEL_SLOT_MASK) == 0) {
+        uint8_t tLevel = 1;
+        while (tLevel < TIMER_WHEEL_LEVELS && redistributeSlot(aWheel, tLevel)) {
+            tLevel++;
+        }
+    }
+    // detach the expiring list, so timers added by callbacks are not called at this tick
+    struct TimerWheelEntry * tExpiringList = aWheel->Slots[0][aWheel->Tick & TIMER_WHEEL_SLOT_MASK];
+    aWheel->Slots[0][aWheel->Tick & TIMER_WHEEL_SLOT_MASK] = NULL;
+    if (tExpiringList != NULL) {
+        tExpiringList->PreviousNextPtr = &tExpiringList;
+    }
+    aWheel->Tick++;
+
+    uint16_t tNumberOfCallbacks = 0;
+    // take always the first entry, since a callback may cancel other expiring timers
+    while (tExpiringList != NULL) {
+        struct TimerWheelEntry * tEntry = tExpiringList;
+        void (*tCallback)(void) = tEntry->Callback;
+        freeEntry(aWheel, tEntry);
+        tCallback();
+        tNumberOfCallbacks++;
+    }
+    return tNumberOfCallbacks;
+}
+
+/**
+ * Ticks at which a higher level slot is redistributed are counted as possible expire ticks.
+ * The actual slot of a higher level can only contain entries if it is not yet redistributed, see insertEntry().
+ * @return number of the following doTimerWheelTick() call which may call a callback, 1 -> the next call.
+ *         At most aMaxTicks.
+ */
+uint32_t getTimerWheelTicksUntilNextExpiry(struct TimerWheel * aWheel, uint32_t aMaxTicks) {
+    uint32_t tTicks = aMaxTicks;
+    for (uint8_t tLevel = 0; tLevel < TIMER_WHEEL_LEVELS; ++tLevel) {
+        uint8_t tShift = tLevel * TIMER_WHEEL_SLOT_BITS;
+        uint32_t tLevelTick = aWheel->Tick >> tShift;
+        bool tActualSlotIsPending = (aWheel->Tick & ((1UL << tShift) - 1)) == 0;
+        for (uint8_t tDistance = tActualSlotIsPending ? 0 : 1; tDistance < TIMER_WHEEL_SLOTS; ++tDistance) {
+            // number of the call which processes or redistributes this slot
+            uint32_t tSlotTicks = ((tLevelTick + tDistance) << tShift) - aWheel->Tick + 1;
+            if (tSlotTicks >= tTicks) {
+                // the slots of higher levels are even later
+                break;
+            }
+            if (aWheel->Slots[tLevel][(tLevelTick + tDistance) & TIMER_WHEEL_SLOT_MASK] != NULL) {
+                tTicks = tSlotTicks;
+                break;
+            }
+        }
+    }
+    return tTicks;
+}
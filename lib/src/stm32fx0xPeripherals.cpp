@@ -63,6 +63,7 @@ TIM_HandleTypeDef TIM_DSOHandle;
 TIM_HandleTypeDef TIM7Handle;
 RTC_HandleTypeDef RTCHandle;
 SPI_HandleTypeDef * SPI1HandlePtr;
+volatile bool SPI1Busy = false;
 #ifdef HAL_WWDG_MODULE_ENABLED
 WWDG_HandleTypeDef WWDGHandle;
 #endif
@@ -623,7 +624,7 @@ void ADC1_DMA_initialize(void) {
 //    ADC1_2->CCR |= ADC_Mode_Interleave;
 //}
 
-void ADC1_DMA_start(uint32_t aMemoryBaseAddr, uint16_t aBufferSize, bool aModeCircular) {
+void ADC1_DMA_start(uintptr_t aMemoryBaseAddr, uint16_t aBufferSize, bool aModeCircular) {
 // Disable DMA1 channel1 - is really needed here!
     DMA_HandleTypeDef * tDMA_ADCHandle = ADC1Handle.DMA_Handle;
     CLEAR_BIT(tDMA_ADCHandle->Instance->CCR, DMA_CCR_EN);
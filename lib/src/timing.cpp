@@ -14,6 +14,9 @@
 #include "myStrings.h"
 #include "BlueDisplay.h"
 #include "stm32fx0xPeripherals.h"
+#include "TimerWheel.h"
+#include "Profiler.h"
+#include "AssertErrorAndMisc.h" // for struct ExceptionStackFrame
 
 #include <stdint.h>
 #include <stdio.h>
@@ -39,10 +42,11 @@ volatile uint32_t MillisSinceBoot = 0;
 // 1 callback for LCD dimming
 // 1 callback for tone duration
 // 1 one time callback for delayed MMC initialization
-#define CALLBACK_ENTRIES_SIZE 11
-// array of pointer to timer-delay callback function
-void (*DelayCallbackPointer[CALLBACK_ENTRIES_SIZE])(void);
-volatile int32_t DelayCallbackMillis[CALLBACK_ENTRIES_SIZE] = { 0, 0, 0, 0, 0 };
+// 1 callback for touch panel sampling
+#define CALLBACK_ENTRIES_SIZE 16
+// systic only visits the expiring callbacks, see TimerWheel.h
+static struct TimerWheelEntry sDelayCallbackEntries[CALLBACK_ENTRIES_SIZE];
+static struct TimerWheel sDelayCallbackWheel;
 
 /**
  * loop delay of nanoseconds.
@@ -108,33 +112,43 @@ static void delayMillisBusy(int32_t aTimeMillis) {
 /**
  * register for delay callback, does not check if callback is already registered
  * if check is needed use changeDelayCallback()
+ * Callback is called by the aTimeMillis-th following systic. Values <= 0 register nothing.
  */
 void registerDelayCallback(void (*aDelayCallback)(void), int32_t aTimeMillis) {
-    int i;
-    for (i = 0; i < CALLBACK_ENTRIES_SIZE; ++i) {
-        if (DelayCallbackMillis[i] == 0) {
-            DelayCallbackPointer[i] = aDelayCallback;
-            DelayCallbackMillis[i] = aTimeMillis;
-            return;
-        }
+    if (aTimeMillis <= 0) {
+        return;
+    }
+    // lock against systic, which also calls callbacks which register themselves again
+    uint32_t tPrimask = __get_PRIMASK();
+    __disable_irq();
+    if (!sDelayCallbackWheel.IsInitialized) {
+        initTimerWheel(&sDelayCallbackWheel, sDelayCallbackEntries, CALLBACK_ENTRIES_SIZE);
+    }
+    bool tSuccess = addTimerWheelCallback(&sDelayCallbackWheel, aDelayCallback, aTimeMillis);
+    __set_PRIMASK(tPrimask);
+    if (!tSuccess) {
+        failParamMessage(aDelayCallback, "No more free callback entries");
     }
-    failParamMessage(aDelayCallback, "No more free callback entries");
 }
 
 /**
  * change a delay for a already registered callback or insert one if not existent
+ * Values <= 0 cancel the callback
  */
 void changeDelayCallback(void (*aDelayCallback)(void), int32_t aTimeMillis) {
-    int i;
-    for (i = 0; i < CALLBACK_ENTRIES_SIZE; ++i) {
-        if (DelayCallbackPointer[i] == aDelayCallback) {
-            DelayCallbackMillis[i] = aTimeMillis;
-            // entry found, job done
-            return;
-        }
+    if (aTimeMillis < 0) {
+        aTimeMillis = 0;
+    }
+    uint32_t tPrimask = __get_PRIMASK();
+    __disable_irq();
+    if (!sDelayCallbackWheel.IsInitialized) {
+        initTimerWheel(&sDelayCallbackWheel, sDelayCallbackEntries, CALLBACK_ENTRIES_SIZE);
+    }
+    bool tSuccess = changeTimerWheelCallback(&sDelayCallbackWheel, aDelayCallback, aTimeMillis);
+    __set_PRIMASK(tPrimask);
+    if (!tSuccess) {
+        failParamMessage(aDelayCallback, "No more free callback entries");
     }
-    // no entry found -> insert one
-    registerDelayCallback(aDelayCallback, aTimeMillis);
 }
 
 /**
@@ -158,13 +172,8 @@ void doOneSystic(void) {
     /**
      * delays with callback
      */
-    for (i = 0; i < CALLBACK_ENTRIES_SIZE; ++i) {
-        if (DelayCallbackMillis[i] > 0) {
-            DelayCallbackMillis[i]--;
-            if (DelayCallbackMillis[i] == 0) {
-                DelayCallbackPointer[i]();
-            }
-        }
+    if (sDelayCallbackWheel.IsInitialized) {
+        doTimerWheelTick(&sDelayCallbackWheel);
     }
 
     /**
@@ -181,6 +190,155 @@ void doOneSystic(void) {
     }
 }
 
+#ifdef USE_TICKLESS_IDLE
+// a shorter rest of the systic period is done at once after wake up
+#define TICKLESS_IDLE_MIN_RELOAD_COUNTS 500
+struct IdleStatistics IdleStatistics;
+
+void resetIdleStatistics(void) {
+    memset(&IdleStatistics, 0, sizeof(IdleStatistics));
+    IdleStatistics.StartMillis = MillisSinceBoot;
+}
+
+/**
+ * @return percent of time since resetIdleStatistics() spent sleeping, proxy for the current consumption
+ */
+uint32_t getIdlePercent(void) {
+    uint32_t tMillis = MillisSinceBoot - IdleStatistics.StartMillis;
+    if (tMillis == 0) {
+        return 0;
+    }
+    return IdleStatistics.SleepNanos / (tMillis * 10000ULL);
+}
+
+/**
+ * Sleeps with WFI until an interrupt occurs, but at most until the next delay callback is due or aMaxMillis have elapsed.
+ * If more than the actual systic period can be slept, the SysTick is loaded with the whole sleep time,
+ * so the systic interrupts in between are suppressed. After wake up the elapsed systics are done by doOneSystic(),
+ * so getMillisSinceBoot(), HAL_GetTick() and the delays and timeouts stay accurate.
+ * @param aIsWorkPendingFunction is called with interrupts disabled just before sleeping. If it returns true, no sleep is done.
+ *        This avoids sleeping while work from an interrupt which occurred after the last check is pending.
+ * @return number of suppressed systics
+ */
+uint32_t idleMillis(uint32_t aMaxMillis, bool (*aIsWorkPendingFunction)(void)) {
+    if (aMaxMillis == 0) {
+        return 0;
+    }
+    uint32_t tPrimask = __get_PRIMASK();
+    __disable_irq();
+    if ((aIsWorkPendingFunction != NULL && aIsWorkPendingFunction()) || (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk)) {
+        __set_PRIMASK(tPrimask);
+        return 0;
+    }
+    uint32_t tCountsPerSystic = SysTick->LOAD + 1;
+    uint32_t tSleepSystics = aMaxMillis;
+    if (sDelayCallbackWheel.IsInitialized) {
+        tSleepSystics = getTimerWheelTicksUntilNextExpiry(&sDelayCallbackWheel, tSleepSystics);
+    }
+    // 24 bit counter gives 233 ms at 72 MHz
+    if (tSleepSystics > (SysTick_LOAD_RELOAD_Msk + 1) / tCountsPerSystic) {
+        tSleepSystics = (SysTick_LOAD_RELOAD_Msk + 1) / tCountsPerSystic;
+    }
+
+    uint32_t tCountsToFirstSystic;
+    uint32_t tSleepCounts = 0;
+    if (tSleepSystics > 1) {
+        SysTick->CTRL &= ~SysTick_CTRL_ENABLE_Msk;
+        tCountsToFirstSystic = SysTick->VAL;
+        if (tCountsToFirstSystic < TICKLESS_IDLE_MIN_RELOAD_COUNTS || (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk)) {
+            // systic is just due
+            SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+            __set_PRIMASK(tPrimask);
+            return 0;
+        }
+        // the counts while stopped are lost, this is some ppm of the sleep time
+        tSleepCounts = tCountsToFirstSystic + (tSleepSystics - 1) * tCountsPerSystic;
+        SysTick->LOAD = tSleepCounts - 1;
+        SysTick->VAL = 0;
+        SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+    } else {
+        tCountsToFirstSystic = SysTick->VAL;
+    }
+    __DSB();
+    __WFI();
+    uint32_t tWakeUpCounts = SysTick->VAL;
+
+    uint32_t tSuppressedSystics = 0;
+    uint32_t tElapsedCounts;
+    uint32_t tCountsAfterRestart;
+    if (tSleepSystics > 1) {
+        SysTick->CTRL &= ~SysTick_CTRL_ENABLE_Msk;
+        uint32_t tCountsLeft = SysTick->VAL;
+        uint32_t tCountsToNextSystic;
+        if (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) {
+            // whole sleep time elapsed, the pending systic interrupt does the last systic
+            tSuppressedSystics = tSleepSystics - 1;
+            tElapsedCounts = tSleepCounts;
+            // counter was reloaded with the sleep counts
+            tCountsToNextSystic = tCountsPerSystic - ((tSleepCounts - 1) - tCountsLeft);
+            tWakeUpCounts = tCountsLeft;
+        } else {
+            // woken by another interrupt
+            tElapsedCounts = tSleepCounts - tCountsLeft;
+            if (tElapsedCounts >= tCountsToFirstSystic) {
+                tSuppressedSystics = 1 + (tElapsedCounts - tCountsToFirstSystic) / tCountsPerSystic;
+            }
+            tCountsToNextSystic = tCountsLeft % tCountsPerSystic;
+        }
+        if (tCountsToNextSystic < TICKLESS_IDLE_MIN_RELOAD_COUNTS) {
+            // do this systic now, because it may be due before the normal reload value is set again
+            tSuppressedSystics++;
+            tCountsToNextSystic += tCountsPerSystic;
+        }
+        tWakeUpCounts -= tCountsLeft;
+        // continue with the rest of the actual systic period
+        SysTick->LOAD = tCountsToNextSystic - 1;
+        SysTick->VAL = 0;
+        SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+        tCountsAfterRestart = tCountsToNextSystic - 1;
+        for (uint32_t i = 0; i < tSuppressedSystics; ++i) {
+            HAL_IncTick();
+            MillisSinceBoot++;
+            doOneSystic();
+        }
+        // is used at the next reload
+        SysTick->LOAD = tCountsPerSystic - 1;
+    } else {
+        if (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) {
+            tElapsedCounts = tCountsToFirstSystic + tCountsPerSystic - tWakeUpCounts;
+        } else {
+            tElapsedCounts = tCountsToFirstSystic - tWakeUpCounts;
+        }
+        tCountsAfterRestart = tWakeUpCounts;
+        tWakeUpCounts = 0;
+    }
+
+    IdleStatistics.Sleeps++;
+    IdleStatistics.SuppressedSystics += tSuppressedSystics;
+#ifdef USE_PC_SAMPLING_PROFILER
+    addProfilerIdleSamples(tSuppressedSystics);
+#endif
+    IdleStatistics.SleepNanos += (tElapsedCounts * 1000000ULL) / tCountsPerSystic;
+    // a reload after wake up is neglected
+    uint32_t tCountsNow = SysTick->VAL;
+    if (tCountsNow <= tCountsAfterRestart) {
+        tWakeUpCounts += tCountsAfterRestart - tCountsNow;
+        uint32_t tWakeUpNanos = (tWakeUpCounts * 1000000ULL) / tCountsPerSystic;
+        if (IdleStatistics.MaxWakeUpNanos < tWakeUpNanos) {
+            IdleStatistics.MaxWakeUpNanos = tWakeUpNanos;
+        }
+    }
+    __set_PRIMASK(tPrimask);
+    return tSuppressedSystics;
+}
+#else
+uint32_t idleMillis(uint32_t aMaxMillis, bool (*aIsWorkPendingFunction)(void)) {
+    (void) aMaxMillis;
+    (void) aIsWorkPendingFunction;
+    return 0;
+}
+#endif
+
 void displayTimings(uint16_t aYDisplayPos) {
     uint32_t tSysticReloadValue = getSysticReloadValue() + 1;
     clearSystic(); // 1 tick
@@ -330,7 +488,25 @@ void testTimingsLoop(int aCount) {
     }
 }
 
+#ifdef USE_PC_SAMPLING_PROFILER
+/*
+ * Passes the stack frame of the interrupted code like Default_Handler in startup_stm32f30x.S.
+ * LR still contains EXC_RETURN, so the return of SysTickHandlerWithStackFrame() is the return from exception.
+ */
+extern "C" void __attribute__((naked)) SysTick_Handler(void) {
+    __asm volatile (
+            "TST LR, #4\n"
+            "ITE EQ\n"
+            "MRSEQ R0, MSP\n"
+            "MRSNE R0, PSP\n"
+            "B SysTickHandlerWithStackFrame\n");
+}
+
+extern "C" void SysTickHandlerWithStackFrame(struct ExceptionStackFrame * aStackFrame) {
+    recordProfilerSample(aStackFrame->pc);
+#else
 extern "C" void SysTick_Handler(void) {
+#endif
     HAL_IncTick();
 //  Toggle_DebugPin(); // to measure crystal by external counter
     MillisSinceBoot++;
@@ -2,8 +2,15 @@
 #define ADS7846_h
 
 #include "EventHandler.h"
+#include "TouchSampler.h"
 #include <stdint.h>
 
+/*
+ * Activate the define to read the touch panel in the pen interrupt and in the 20 ms move recognition callback
+ * with blocking oversampling loops, like before the background sampling was introduced.
+ */
+//#define DO_NOT_USE_BACKGROUND_TOUCH_SAMPLING
+
 #define CAL_POINT_X1 (20)
 #define CAL_POINT_Y1 (20)
 #define CAL_POINT1   {CAL_POINT_X1,CAL_POINT_Y1}
@@ -91,11 +98,24 @@ public:
 
     bool wasTouched(void);
 
+#ifndef DO_NOT_USE_BACKGROUND_TOUCH_SAMPLING
+    void startSampling(void);
+    void doSamplingStep(void);
+    void getSnapshot(struct TouchSnapshotData * aSnapshotData);
+    struct TouchSampler mSampler;
+#endif
+
 private:
     bool setCalibration(CAL_POINT *lcd, CAL_POINT *tp);
     struct XYPosition mTouchActualPositionRaw; // raw pos (touch panel)
     struct XYPosition mTouchLastCalibratedPositionRaw; // last calibrated raw pos - to avoid calibrating the same position twice
     CAL_MATRIX tp_matrix; // calibrate matrix
+#ifndef DO_NOT_USE_BACKGROUND_TOUCH_SAMPLING
+    volatile bool mIsReading = false; // true while rd_data() or readChannel() is running -> sampling step is skipped
+    struct TouchSnapshot mSnapshot;
+    bool readRawSample(uint16_t * aRawXPtr, uint16_t * aRawYPtr, uint8_t * aPressurePtr);
+    void publishSnapshot(bool aIsTouched);
+#endif
 
     void writeCalibration(CAL_MATRIX aMatrix);
     void readCalibration(CAL_MATRIX *aMatrix);
@@ -14,6 +14,9 @@
 
 #include "fonts.h"
 #include <stdbool.h>
+#ifdef HOST_SIMULATION
+#include <stdio.h> // for FILE
+#endif
 
 /** @addtogroup Graphic_Library
  * @{
@@ -100,6 +103,42 @@ void storeScreenshot(void);
 }
 #endif
 
+#ifdef HOST_SIMULATION
+/*
+ * Host backend of the low level layer (MI0283QT2_Host.cpp).
+ * Emulates the controller registers and the GRAM and counts the bus accesses.
+ */
+// Estimated duration of bus accesses on the STM32F303 @72MHz in nanoseconds
+#define HOST_BUS_NANOS_PER_REGISTER_WRITE   280 // 10 GPIO register writes for address and value
+#define HOST_BUS_NANOS_PER_PIXEL_WRITE      85  // ODR + 2 * BSRR
+#define HOST_BUS_NANOS_PER_READ             420 // includes 300 ns read delay
+
+struct HostDisplayCounter {
+    uint32_t RegisterWrites;
+    uint32_t RegisterReads;
+    uint32_t PixelWrites;
+    uint32_t PixelReads;
+    uint32_t DrawStarts;
+    uint64_t BusNanos; // estimated time spent on the display bus
+};
+
+extern struct HostDisplayCounter HostDisplayCounters;
+
+#ifdef __cplusplus
+// content of GRAM in landscape orientation
+extern uint16_t HostFrameBuffer[LOCAL_DISPLAY_HEIGHT][LOCAL_DISPLAY_WIDTH];
+
+extern "C" {
+#endif
+void hostResetDisplayCounters(void);
+void hostPrintDisplayCounters(FILE * aFile);
+uint16_t hostGetPixel(uint16_t aXPos, uint16_t aYPos);
+bool hostStoreDisplayPPM(const char * aFilename);
+#ifdef __cplusplus
+}
+#endif
+#endif // HOST_SIMULATION
+
 // Tests
 void initalizeDisplay2(void);
 void setGamma(int aIndex);
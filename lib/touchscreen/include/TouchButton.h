@@ -28,6 +28,9 @@ class BDButton;
 #endif
 
 #include <stdint.h>
+#ifdef USE_BUTTON_POOL
+#include "TouchPool.h"
+#endif
 /** @addtogroup Gui_Library
  * @{
  */
@@ -35,11 +38,14 @@ class BDButton;
  * @{
  */
 #ifdef USE_BUTTON_POOL
-// 45 needed for AccuCap/settings/Numberpad
-// 50 needed for DSO/settings/calibrate/Numberpad
-#define NUMBER_OF_BUTTONS_IN_POOL 50
+// the main menu page stays allocated while a page is shown
+// 46 needed for main menu/AccuCap/Numberpad
+// 72 needed for main menu/DSO/frequency generator/Numberpad
+#define NUMBER_OF_BUTTONS_IN_POOL 72
 #endif
 
+#define BUTTON_GRID_MAX_ENTRIES 384 // cells of all active buttons, if exceeded all buttons are checked for each touch
+
 #define TOUCHBUTTON_DEFAULT_CAPTION_COLOR 	COLOR_BLACK
 // Error codes
 #define TOUCHBUTTON_ERROR_X_RIGHT 			-1
@@ -77,11 +83,12 @@ public:
 	static TouchButton * allocAndInitButton(uint16_t aPositionX, uint16_t aPositionY, uint16_t aWidthX,
 			uint16_t aHeightY, uint16_t aButtonColor, const char *aCaption, uint8_t aCaptionSize, uint8_t aFlags,
 			int16_t aValue, void (*aOnTouchHandler)(TouchButton*, int16_t));
-	void setAllocated(bool isAllocated);
 	void setFree(void);
-	bool isAllocated(void) const;
+	static void startButtonPage(void);
+	static void freeAllButtonsOfPage(void);
 	static void infoButtonPool(char * aStringBuffer);
 #endif
+	bool isAllocated(void) const;
 
 	static void setDefaultTouchBorder(uint8_t aDefaultTouchBorder);
 	static void setDefaultCaptionColor(uint16_t aDefaultCaptionColor);
@@ -149,16 +156,19 @@ public:
 private:
 	// Pool stuff
 	static TouchButton TouchButtonPool[NUMBER_OF_BUTTONS_IN_POOL];
-	static bool sButtonPoolIsInitialized;// used by allocButton
+	static struct TouchPool sButtonPool;
 #endif
 
 protected:
 	static uint16_t sDefaultCaptionColor;
 
-	static uint8_t sButtonCombinedPoolSize;
-	static uint8_t sMinButtonPoolSize;
+#ifdef USE_BUTTON_POOL
+	struct TouchPoolEntry mPoolEntry; // links free pool buttons
+	static void initButtonPools(void);
+#endif
 
 	static TouchButton *sButtonListStart; // Root pointer to list of all buttons
+	static void buildButtonGrid(void);
 
 	TouchButton *mNextObject;
 
@@ -167,7 +177,7 @@ protected:
 // Handler for red green button
 void doToggleRedGreenButton(TouchButton * aTheTouchedButton, int16_t aValue);
 
-#ifdef AVR
+#if defined(AVR) || defined(HOST_SIMULATION)
 void FeedbackToneOK(void);
 #endif
 
@@ -37,6 +37,9 @@ public:
 
 #ifdef USE_BUTTON_POOL
     static TouchButtonAutorepeat * allocAutorepeatButton(void);
+    // used by TouchButton::initButtonPools(), startButtonPage() and freeAllButtonsOfPage()
+    static TouchButtonAutorepeat TouchButtonAutorepeatPool[NUMBER_OF_AUTOREPEAT_BUTTONS_IN_POOL];
+    static struct TouchPool sAutorepeatButtonPool;
 #endif
 
     static int checkAllButtons(int aTouchPositionX, int aTouchPositionY, bool doCallback);
@@ -49,11 +52,6 @@ public:
      * Static functions
      */
     TouchButtonAutorepeat();
-#ifdef USE_BUTTON_POOL
-#ifdef REMOTE_DISPLAY_SUPPORTED
-    static void reinitAllLocalAutorepeatButtonsForRemote(void);
-#endif
-#endif
 
     uint16_t mMillisFirstDelay;
     uint16_t mMillisFirstRate;
@@ -61,12 +59,6 @@ public:
     uint16_t mMillisSecondRate;
 
 private:
-#ifdef USE_BUTTON_POOL
-    static TouchButtonAutorepeat TouchButtonAutorepeatPool[NUMBER_OF_AUTOREPEAT_BUTTONS_IN_POOL];
-    static bool sButtonAutorepeatPoolIsInitialized; // used by allocButton
-    static TouchButtonAutorepeat *sAutorepeatButtonListStart; // Root pointer to list of all buttons
-#endif
-
     void (*mOnTouchHandlerAutorepeat)(TouchButton *, int16_t);
     static uint8_t sState;
     static uint16_t sCount;
@@ -0,0 +1,54 @@
+/**
+ * @file TouchGrid.h
+ *
+ * Grid of cells over the local display, which holds the touch areas of buttons or sliders overlapping each cell.
+ * A touch has to be checked only against the objects of the touched cell instead of against all objects.
+ *
+ * The grid is built in 2 passes over the objects in list order, first counting the cells of all touch areas,
+ * then adding the objects. So the objects of a cell are in list order and the first match is the same as with a list scan.
+ * If the objects do not fit, the grid is overflowed and the caller must scan its list.
+ *
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ */
+
+#ifndef TOUCHGRID_H_
+#define TOUCHGRID_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Activate the define to save the RAM of the grids and check all buttons and sliders for each touch.
+ */
+//#define DO_NOT_USE_TOUCH_GRID
+#ifdef AVR
+#define DO_NOT_USE_TOUCH_GRID
+#endif
+
+#define TOUCH_GRID_WIDTH 320 // LOCAL_DISPLAY_WIDTH
+#define TOUCH_GRID_HEIGHT 240 // LOCAL_DISPLAY_HEIGHT
+#define TOUCH_GRID_CELL_SIZE 40
+#define TOUCH_GRID_NUMBER_OF_COLUMNS ((TOUCH_GRID_WIDTH + TOUCH_GRID_CELL_SIZE - 1) / TOUCH_GRID_CELL_SIZE)
+#define TOUCH_GRID_NUMBER_OF_ROWS ((TOUCH_GRID_HEIGHT + TOUCH_GRID_CELL_SIZE - 1) / TOUCH_GRID_CELL_SIZE)
+#define TOUCH_GRID_NUMBER_OF_CELLS (TOUCH_GRID_NUMBER_OF_COLUMNS * TOUCH_GRID_NUMBER_OF_ROWS)
+
+struct TouchGrid {
+    // objects of cell i are Entries[CellStart[i]] to Entries[CellStart[i + 1] - 1]
+    uint16_t CellStart[TOUCH_GRID_NUMBER_OF_CELLS + 1];
+    void ** Entries;
+    uint16_t MaxNumberOfEntries;
+    bool IsValid; // false -> must be built again before next lookup
+    bool IsOverflow; // true -> objects did not fit into Entries
+};
+
+void invalidateTouchGrid(struct TouchGrid * aGrid);
+void startTouchGridCount(struct TouchGrid * aGrid);
+void countTouchGridArea(struct TouchGrid * aGrid, uint16_t aXLeft, uint16_t aYTop, uint16_t aXRight, uint16_t aYBottom);
+void startTouchGridFill(struct TouchGrid * aGrid);
+void addToTouchGrid(struct TouchGrid * aGrid, void * aObject, uint16_t aXLeft, uint16_t aYTop, uint16_t aXRight,
+        uint16_t aYBottom);
+void endTouchGridFill(struct TouchGrid * aGrid);
+void * const * getTouchGridCandidates(const struct TouchGrid * aGrid, uint16_t aTouchPositionX, uint16_t aTouchPositionY,
+        uint16_t * aNumberOfCandidatesPtr);
+
+#endif /* TOUCHGRID_H_ */
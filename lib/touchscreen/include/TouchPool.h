@@ -0,0 +1,56 @@
+/**
+ * @file TouchPool.h
+ *
+ * Pool of preallocated buttons or sliders with an intrusive free list for allocation and free in constant time.
+ * Each element contains a TouchPoolEntry, which links it into the free list while it is not allocated.
+ *
+ * Pages are nested, e.g. main menu -> DSO page -> settings page -> number pad.
+ * Each element is allocated in the actual page level and stamped with the generation of this level.
+ * Freeing all elements of a page only increments the generation of its level, so its elements become stale at once.
+ * Stale elements are put back into the free list, when the free list is empty at the next allocation.
+ *
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ */
+
+#ifndef TOUCHPOOL_H_
+#define TOUCHPOOL_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define TOUCH_POOL_MAX_PAGE_LEVEL 4 // level 0 is for elements not allocated in a page
+
+struct TouchPool;
+
+struct TouchPoolEntry {
+    struct TouchPool * Pool; // NULL -> object is not part of a pool and always allocated
+    struct TouchPoolEntry * NextFree;
+    uint8_t PageLevel;
+    uint8_t PageGeneration;
+    bool IsAllocated; // true and PageGeneration is outdated -> stale, i.e. freed by freeTouchPoolPage()
+};
+
+struct TouchPool {
+    uint8_t * Elements; // start of element array
+    uint8_t * FirstEntry; // entry of first element
+    uint16_t ElementSize;
+    uint8_t NumberOfElements;
+    uint8_t NumberOfAllocatedElements;
+    uint8_t MaxNumberOfAllocatedElements;
+    struct TouchPoolEntry * FreeList;
+    uint8_t PageLevel;
+    uint8_t PageLevelOverflow; // number of pages started at TOUCH_POOL_MAX_PAGE_LEVEL
+    uint8_t PageGeneration[TOUCH_POOL_MAX_PAGE_LEVEL + 1];
+    uint8_t PageNumberOfElements[TOUCH_POOL_MAX_PAGE_LEVEL + 1];
+    bool IsInitialized;
+};
+
+void initTouchPool(struct TouchPool * aPool, void * aElements, struct TouchPoolEntry * aFirstEntry, uint16_t aElementSize,
+        uint8_t aNumberOfElements);
+void * allocTouchPoolElement(struct TouchPool * aPool);
+void freeTouchPoolEntry(struct TouchPoolEntry * aEntry);
+bool isTouchPoolEntryAllocated(const struct TouchPoolEntry * aEntry);
+void startTouchPoolPage(struct TouchPool * aPool);
+void freeTouchPoolPage(struct TouchPool * aPool);
+
+#endif /* TOUCHPOOL_H_ */
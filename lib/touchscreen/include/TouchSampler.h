@@ -0,0 +1,87 @@
+/**
+ * @file TouchSampler.h
+ *
+ * State machine for sampling the touch panel by a periodic timer callback instead of reading it synchronously.
+ * After the pen interrupt the line is debounced, then one raw sample is taken for each period.
+ * Samples far away from the last median are rejected, remaining outliers are rejected by the median
+ * of the last TOUCH_SAMPLER_MEDIAN_SIZE valid samples. The median is smoothed by an IIR low pass. Some consecutive invalid samples end the touch.
+ *
+ * The position is published as snapshot, which is guarded by a sequence counter and can be read without disabling interrupts.
+ *
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ */
+
+#ifndef TOUCHSAMPLER_H_
+#define TOUCHSAMPLER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define TOUCH_SAMPLER_PERIOD_MILLIS 2
+#define TOUCH_SAMPLER_DEBOUNCE_TICKS 5 // 10 ms - the pen interrupt line bounces up to 8 ms
+#define TOUCH_SAMPLER_MEDIAN_SIZE 5 // rejects up to 2 outliers
+#define TOUCH_SAMPLER_OUTLIER_DISTANCE 128 // samples which differ more from last median are rejected
+#define TOUCH_SAMPLER_MAX_OUTLIERS 2 // then the finger is assumed to have jumped and the sample is accepted
+#define TOUCH_SAMPLER_DOWN_SAMPLES 3 // the position of the down event is the median of the first 3 samples
+#define TOUCH_SAMPLER_IIR_SHIFT 3 // weight of new median is 1/8
+#define TOUCH_SAMPLER_IIR_MOVE_DISTANCE 24 // if median differs more from filtered value, finger is assumed to move
+#define TOUCH_SAMPLER_IIR_MOVE_SHIFT 1 // weight of new median is 1/2 while moving
+#define TOUCH_SAMPLER_FRACTION_SHIFT 4 // fractional bits of filtered values
+#define TOUCH_SAMPLER_RELEASE_SAMPLES 3 // number of consecutive invalid samples which end the touch
+
+// States
+#define TOUCH_SAMPLER_IDLE 0
+#define TOUCH_SAMPLER_DEBOUNCE 1
+#define TOUCH_SAMPLER_SAMPLING 2
+
+// Results of addTouchSamplerSample()
+#define TOUCH_SAMPLER_NO_EVENT 0
+#define TOUCH_SAMPLER_DOWN 1
+#define TOUCH_SAMPLER_NEW_POSITION 2
+#define TOUCH_SAMPLER_UP 3
+
+struct TouchSampler {
+    uint8_t State;
+    uint8_t DebounceTicks;
+    uint8_t NumberOfInvalidSamples; // consecutive
+    uint8_t NumberOfOutliers; // consecutive
+    uint8_t NumberOfWindowSamples;
+    uint8_t WindowIndex;
+    uint16_t WindowX[TOUCH_SAMPLER_MEDIAN_SIZE];
+    uint16_t WindowY[TOUCH_SAMPLER_MEDIAN_SIZE];
+    uint16_t MedianX;
+    uint16_t MedianY;
+    int32_t FilteredX; // with TOUCH_SAMPLER_FRACTION_SHIFT fractional bits
+    int32_t FilteredY;
+    bool IsDown; // true -> TOUCH_SAMPLER_DOWN was returned and TOUCH_SAMPLER_UP is due
+    uint32_t NumberOfSamples;
+    uint32_t NumberOfRejectedSamples;
+};
+
+struct TouchSnapshotData {
+    uint16_t PositionX;
+    uint16_t PositionY;
+    uint8_t Pressure;
+    bool IsTouched;
+};
+
+/*
+ * Written only by the sampling interrupt, read by the main loop.
+ * Sequence is odd while the data is written, a reader retries if Sequence was odd or has changed while reading.
+ */
+struct TouchSnapshot {
+    volatile uint32_t Sequence;
+    struct TouchSnapshotData Data;
+};
+
+void initTouchSampler(struct TouchSampler * aSampler);
+void startTouchSamplerDebounce(struct TouchSampler * aSampler);
+uint8_t debounceTouchSampler(struct TouchSampler * aSampler, bool aLineIsActive);
+uint8_t addTouchSamplerSample(struct TouchSampler * aSampler, uint16_t aRawX, uint16_t aRawY, bool aIsValid);
+uint16_t getTouchSamplerX(const struct TouchSampler * aSampler);
+uint16_t getTouchSamplerY(const struct TouchSampler * aSampler);
+
+void writeTouchSnapshot(struct TouchSnapshot * aSnapshot, const struct TouchSnapshotData * aData);
+void readTouchSnapshot(const struct TouchSnapshot * aSnapshot, struct TouchSnapshotData * aData);
+
+#endif /* TOUCHSAMPLER_H_ */
@@ -26,6 +26,15 @@ class BDSlider;
 
 #include <stdint.h>
 
+/*
+ * Activate the define to allocate the local sliders of BDSlider from a pool instead of the heap.
+ */
+//#define USE_SLIDER_POOL
+#ifdef USE_SLIDER_POOL
+#define NUMBER_OF_SLIDERS_IN_POOL 10
+#include "TouchPool.h"
+#endif
+
 /** @addtogroup Gui_Library
  * @{
  */
@@ -60,6 +69,7 @@ class BDSlider;
 #define SLIDER_DEFAULT_BAR_WIDTH            8
 #define SLIDER_MAX_BAR_WIDTH                40 /** global max value of size parameter */
 #define SLIDER_DEFAULT_TOUCH_BORDER         4 /** extension of touch region in pixel */
+#define SLIDER_GRID_MAX_ENTRIES             32 /** cells of all active sliders, if exceeded all sliders are checked for each touch */
 #define SLIDER_DEFAULT_SHOW_CAPTION         true
 #define SLIDER_DEFAULT_SHOW_VALUE           true
 #define SLIDER_DEFAULT_MAX_VALUE            160
@@ -109,6 +119,15 @@ public:
     static void deactivateAllSliders(void);
     static void activateAllSliders(void);
 
+#ifdef USE_SLIDER_POOL
+    // Pool stuff
+    static TouchSlider * allocSlider(void);
+    void setFree(void);
+    static void startSliderPage(void);
+    static void freeAllSlidersOfPage(void);
+#endif
+    bool isAllocated(void) const;
+
     /*
      * Member functions
      */
@@ -162,6 +181,13 @@ public:
 private:
     // Start of list of touch slider
     static TouchSlider * sSliderListStart;
+    static void buildSliderGrid(void);
+#ifdef USE_SLIDER_POOL
+    static TouchSlider TouchSliderPool[NUMBER_OF_SLIDERS_IN_POOL];
+    static struct TouchPool sSliderPool;
+    struct TouchPoolEntry mPoolEntry; // links free pool sliders
+    static void initSliderPool(void);
+#endif
     /*
      * Defaults
      */
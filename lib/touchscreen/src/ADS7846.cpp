@@ -64,6 +64,10 @@ unsigned char ADS7846ChannelMapping[] = { 3, 4, 1, 5, 0, 7, 2, 6 };
 const CAL_MATRIX sInitalMatrix = { 320300, -1400, -52443300, -3500, 237700, -21783300, 1857905 };
 
 void callbackPeriodicTouch(void);
+#ifndef DO_NOT_USE_BACKGROUND_TOUCH_SAMPLING
+void callbackADS7846Sampling(void);
+void callbackADS7846EnableInterrupt(void);
+#endif
 
 //-------------------- Constructor --------------------
 
@@ -88,6 +92,10 @@ void ADS7846::init(void) {
     mTouchActualPosition.PosX = 0; // set by calibrate called by rd_data
     mTouchActualPosition.PosY = 0;
     localTouchEvent.EventType = EVENT_NO_EVENT;
+#ifndef DO_NOT_USE_BACKGROUND_TOUCH_SAMPLING
+    initTouchSampler(&mSampler);
+    publishSnapshot(false);
+#endif
 }
 
 bool ADS7846::setCalibration(CAL_POINT *aTargetValues, CAL_POINT *aRawValues) {
@@ -289,6 +297,9 @@ uint16_t ADS7846::readChannel(uint8_t channel, bool use12Bit, bool useDiffMode,
     uint8_t low, high, i;
 
     //SPI speed-down
+#ifndef DO_NOT_USE_BACKGROUND_TOUCH_SAMPLING
+    mIsReading = true;
+#endif
     uint16_t tPrescaler = SPI1_getPrescaler();
     SPI1_setPrescaler(SPI_BAUDRATEPRESCALER_64);
 
@@ -314,10 +325,17 @@ uint16_t ADS7846::readChannel(uint8_t channel, bool use12Bit, bool useDiffMode,
     }
     ADS7846_CSDisable();
     // enable interrupts after some ms in order to wait for the interrupt line to go high - minimum 3 ms
+#ifndef DO_NOT_USE_BACKGROUND_TOUCH_SAMPLING
+    changeDelayCallback(&callbackADS7846EnableInterrupt, TOUCH_DELAY_AFTER_READ_MILLIS);
+#else
     changeDelayCallback(&ADS7846_clearAndEnableInterrupt, TOUCH_DELAY_AFTER_READ_MILLIS);
+#endif
 
     //restore SPI settings
     SPI1_setPrescaler(tPrescaler);
+#ifndef DO_NOT_USE_BACKGROUND_TOUCH_SAMPLING
+    mIsReading = false;
+#endif
 
     return tRetValue / numberOfReadingsToIntegrate;
 }
@@ -337,6 +355,9 @@ void ADS7846::rd_data(int aOversampling) {
     uint32_t tXValue, tYValue;
 
 //	Set_DebugPin();
+#ifndef DO_NOT_USE_BACKGROUND_TOUCH_SAMPLING
+    mIsReading = true;
+#endif
     /*
      * SPI speed-down
      * datasheet says: optimal is CLK < 125kHz (40-80 kHz)
@@ -422,10 +443,220 @@ void ADS7846::rd_data(int aOversampling) {
     //restore SPI settings
     SPI1_setPrescaler(tPrescaler);
     // enable interrupts after some ms in order to wait for the interrupt line to go high  - minimum 3 ms (2ms give errors)
+#ifndef DO_NOT_USE_BACKGROUND_TOUCH_SAMPLING
+    changeDelayCallback(&callbackADS7846EnableInterrupt, TOUCH_DELAY_AFTER_READ_MILLIS);
+    mIsReading = false;
+#else
     changeDelayCallback(&ADS7846_clearAndEnableInterrupt, TOUCH_DELAY_AFTER_READ_MILLIS);
+#endif
     return;
 }
 
+#ifndef DO_NOT_USE_BACKGROUND_TOUCH_SAMPLING
+/*
+ * Queue for the events of the sampling callback, since localTouchEvent holds only one event
+ * and a main loop, which is slower than a short touch, would miss its down event.
+ * Only accessed in SysTick context.
+ */
+#define TOUCH_EVENT_QUEUE_SIZE 8
+struct TouchEventQueueEntry {
+    uint8_t EventType;
+    struct XYPosition Position;
+};
+static struct TouchEventQueueEntry sTouchEventQueue[TOUCH_EVENT_QUEUE_SIZE];
+static uint8_t sTouchEventQueueOut = 0;
+static uint8_t sTouchEventQueueCount = 0;
+
+/*
+ * A move event only updates the position of a move event queued before.
+ * If main loop does not handle events for a long time, newer events are dropped.
+ */
+static void queueTouchEvent(uint8_t aEventType, struct XYPosition aPosition) {
+    if (sTouchEventQueueCount > 0) {
+        struct TouchEventQueueEntry * tLastEntry = &sTouchEventQueue[(sTouchEventQueueOut + sTouchEventQueueCount - 1)
+                % TOUCH_EVENT_QUEUE_SIZE];
+        if (aEventType == EVENT_TOUCH_ACTION_MOVE && tLastEntry->EventType == EVENT_TOUCH_ACTION_MOVE) {
+            tLastEntry->Position = aPosition;
+            return;
+        }
+    }
+    if (sTouchEventQueueCount >= TOUCH_EVENT_QUEUE_SIZE) {
+        return;
+    }
+    struct TouchEventQueueEntry * tEntry = &sTouchEventQueue[(sTouchEventQueueOut + sTouchEventQueueCount)
+            % TOUCH_EVENT_QUEUE_SIZE];
+    tEntry->EventType = aEventType;
+    tEntry->Position = aPosition;
+    sTouchEventQueueCount++;
+}
+
+/*
+ * Moves oldest event to localTouchEvent if it is empty or holds only a move event
+ */
+static void deliverTouchEvent(void) {
+    if (sTouchEventQueueCount > 0
+            && (localTouchEvent.EventType == EVENT_NO_EVENT || localTouchEvent.EventType == EVENT_TOUCH_ACTION_MOVE)) {
+        struct TouchEventQueueEntry * tEntry = &sTouchEventQueue[sTouchEventQueueOut];
+        localTouchEvent.EventData.TouchEventInfo.TouchPosition = tEntry->Position;
+        localTouchEvent.EventData.TouchEventInfo.TouchPointerIndex = 0;
+        localTouchEvent.EventType = tEntry->EventType;
+        sTouchEventQueueOut = (sTouchEventQueueOut + 1) % TOUCH_EVENT_QUEUE_SIZE;
+        sTouchEventQueueCount--;
+    }
+}
+
+/**
+ * Reads pressure, X and Y once. 100 us at SPI_BaudRatePrescaler_64.
+ * @return false if values are not reasonable, e.g. because touch was released
+ */
+bool ADS7846::readRawSample(uint16_t * aRawXPtr, uint16_t * aRawYPtr, uint8_t * aPressurePtr) {
+    uint8_t a, b;
+    uint16_t tPrescaler = SPI1_getPrescaler();
+    SPI1_setPrescaler(SPI_BAUDRATEPRESCALER_64);
+
+    ADS7846_CSEnable();
+    SPI1_sendReceiveFast(CMD_START | CMD_8BIT | CMD_DIFF | CMD_Z1_POS);
+    a = SPI1_sendReceiveFast(0);
+    SPI1_sendReceiveFast(CMD_START | CMD_8BIT | CMD_DIFF | CMD_Z2_POS);
+    b = SPI1_sendReceiveFast(0);
+    b = 127 - b; // 127 is maximum reading of CMD_Z2_POS!
+    int tPressure = a + b;
+
+    SPI1_sendReceiveFast(CMD_START | CMD_12BIT | CMD_DIFF | CMD_X_POS);
+    a = SPI1_sendReceiveFast(0);
+    b = SPI1_sendReceiveFast(0);
+    uint16_t tX = (a << 5) | (b >> 3);
+
+    SPI1_sendReceiveFast(CMD_START | CMD_12BIT | CMD_DIFF | CMD_Y_POS);
+    a = SPI1_sendReceiveFast(0);
+    b = SPI1_sendReceiveFast(0);
+    uint16_t tY = (a << 5) | (b >> 3);
+    ADS7846_CSDisable();
+    SPI1_setPrescaler(tPrescaler);
+
+    *aPressurePtr = tPressure;
+    // same plausibility checks as rd_data()
+    if (tPressure < MIN_REASONABLE_PRESSURE || tX >= 4000 || tY <= 100) {
+        return false;
+    }
+    *aRawXPtr = 4048 - tX;
+    *aRawYPtr = tY;
+    return true;
+}
+
+void ADS7846::publishSnapshot(bool aIsTouched) {
+    struct TouchSnapshotData tData;
+    tData.PositionX = mTouchActualPosition.PosX;
+    tData.PositionY = mTouchActualPosition.PosY;
+    tData.Pressure = mPressure;
+    tData.IsTouched = aIsTouched;
+    writeTouchSnapshot(&mSnapshot, &tData);
+}
+
+/**
+ * Position, pressure and touch state of the last sample. Can be called from main loop at any time without blocking.
+ */
+void ADS7846::getSnapshot(struct TouchSnapshotData * aSnapshotData) {
+    readTouchSnapshot(&mSnapshot, aSnapshotData);
+}
+
+/**
+ * Called at falling edge of the interrupt line. Disables the interrupt until touch is released.
+ */
+void ADS7846::startSampling(void) {
+    if (mSampler.State == TOUCH_SAMPLER_IDLE) {
+        ADS7846_disableInterrupt();
+        startTouchSamplerDebounce(&mSampler);
+        changeDelayCallback(&callbackADS7846Sampling, TOUCH_SAMPLER_PERIOD_MILLIS);
+    }
+}
+
+/**
+ * One step of the sampling state machine, called every TOUCH_SAMPLER_PERIOD_MILLIS while touched.
+ * Replaces the blocking debounce delay of the pen interrupt and the oversampling of rd_data().
+ * A sample is skipped if the interrupted main loop is just using SPI1, the next step samples again.
+ */
+void ADS7846::doSamplingStep(void) {
+    if (mSampler.State == TOUCH_SAMPLER_DEBOUNCE) {
+        if (debounceTouchSampler(&mSampler, !ADS7846_getInteruptLineLevel()) == TOUCH_SAMPLER_IDLE) {
+            // only a bounce
+            ADS7846_clearAndEnableInterrupt();
+        }
+    } else if (mSampler.State == TOUCH_SAMPLER_SAMPLING && !mIsReading && !SPI1Busy) {
+        uint16_t tRawX, tRawY;
+        uint8_t tPressure;
+        bool tIsValid = readRawSample(&tRawX, &tRawY, &tPressure);
+        uint8_t tResult = addTouchSamplerSample(&mSampler, tRawX, tRawY, tIsValid);
+        if (tResult == TOUCH_SAMPLER_DOWN || tResult == TOUCH_SAMPLER_NEW_POSITION) {
+            // scale down to 11 bit because calibration does not work with 12 bit values
+            mTouchActualPositionRaw.PosX = getTouchSamplerX(&mSampler) >> 1;
+            mTouchActualPositionRaw.PosY = getTouchSamplerY(&mSampler) >> 1;
+            calibrate();
+            mPressure = tPressure;
+            if (tResult == TOUCH_SAMPLER_DOWN) {
+                ADS7846TouchActive = true;
+                ADS7846TouchStart = true;
+                mTouchLastPosition = mTouchActualPosition; // for move detection
+                queueTouchEvent(EVENT_TOUCH_ACTION_DOWN, mTouchActualPosition);
+            } else if (mTouchLastPosition.PosX != mTouchActualPosition.PosX
+                    || mTouchLastPosition.PosY != mTouchActualPosition.PosY) {
+                mTouchLastPosition = mTouchActualPosition;
+                queueTouchEvent(EVENT_TOUCH_ACTION_MOVE, mTouchActualPosition);
+            }
+            publishSnapshot(true);
+        } else if (tResult == TOUCH_SAMPLER_UP) {
+            ADS7846TouchActive = false;
+            mPressure = 0;
+            changeDelayCallback(&callbackPeriodicTouch, DISABLE_TIMER_DELAY_VALUE); // disable periodic interrupts which can call handleTouchRelease
+            queueTouchEvent(EVENT_TOUCH_ACTION_UP, mTouchLastPosition);
+            publishSnapshot(false);
+        }
+        if (mSampler.State == TOUCH_SAMPLER_IDLE) {
+            // enable interrupts after some ms in order to wait for the interrupt line to go high
+            changeDelayCallback(&callbackADS7846EnableInterrupt, TOUCH_DELAY_AFTER_READ_MILLIS);
+        }
+    }
+    deliverTouchEvent();
+    if (mSampler.State != TOUCH_SAMPLER_IDLE || sTouchEventQueueCount > 0) {
+        changeDelayCallback(&callbackADS7846Sampling, TOUCH_SAMPLER_PERIOD_MILLIS);
+    }
+}
+
+/**
+ * Callback routine for SysTick handler
+ */
+void callbackADS7846Sampling(void) {
+    TouchPanel.doSamplingStep();
+}
+
+/**
+ * Callback routine for SysTick handler, replaces ADS7846_clearAndEnableInterrupt().
+ * Starts sampling if line is already active, since its falling edge was missed while interrupt was disabled.
+ */
+void callbackADS7846EnableInterrupt(void) {
+    if (TouchPanel.mSampler.State == TOUCH_SAMPLER_IDLE) {
+        ADS7846_clearAndEnableInterrupt();
+        if (!ADS7846_getInteruptLineLevel()) {
+            TouchPanel.startSampling();
+        }
+    }
+}
+
+/**
+ * This handler is called on both edge of touch interrupt signal.
+ * Only the falling edge starts sampling, which also debounces the line. Release is detected by sampling.
+ */
+extern "C" void EXTI1_IRQHandler(void) {
+    // Clear the EXTI line pending bit
+    ADS7846_ClearITPendingBit();
+    BSP_LED_Toggle(LED_GREEN_2); // GREEN RIGHT
+    if (!ADS7846_getInteruptLineLevel()) {
+        TouchPanel.startSampling();
+    }
+    resetBacklightTimeout();
+}
+
+#else
 /**
  * Callback routine for SysTick handler
  */
@@ -506,6 +737,7 @@ extern "C" void EXTI1_IRQHandler(void) {
     // Clear the EXTI line pending bit and enable new interrupt on other edge
     ADS7846_ClearITPendingBit();
 }
+#endif
 
 /**
  * is called by main loops
@@ -13,18 +13,23 @@
 
 #include "MI0283QT2.h"
 #include "BlueDisplay.h"
-#include "thickline.h"
+#include "thickLine.h"
 #include "myStrings.h"
 #include "STM32TouchScreenDriver.h"
 #include "timing.h"
+#ifndef HOST_SIMULATION
 #include "stm32fx0xPeripherals.h"
+#include "CooperativeTask.h"
+#endif
 
 #include <stdio.h> // for sprintf
 #include <string.h>  // for strcat
 #include <stdlib.h>  // for malloc
 
 extern "C" {
+#ifndef HOST_SIMULATION
 #include "ff.h"
+#endif
 #include "BlueSerial.h"
 }
 
@@ -46,10 +51,19 @@ int LCDLastBacklightValue; //! for state of backlight before dimming
 int LCDDimDelay; //actual dim delay
 
 //-------------------- Private functions --------------------
+/*
+ * Low level bus functions. For HOST_SIMULATION they are implemented in MI0283QT2_Host.cpp
+ */
 void drawStart(void);
+#ifdef HOST_SIMULATION
+void draw(uint16_t color);
+void drawStop(void);
+#else
 inline void draw(uint16_t color);
 inline void drawStop(void);
+#endif
 void writeCommand(int aRegisterAddress, int aRegisterValue);
+uint16_t readCommand(int aRegisterAddress);
 bool initalizeDisplay(void);
 uint16_t * fillDisplayLineBuffer(uint16_t * aBufferPtr, uint16_t yLineNumber);
 void setBrightness(int power); //0-100
@@ -64,14 +78,18 @@ MI0283QT2::MI0283QT2(void) {
 MI0283QT2 LocalDisplay;
 //-------------------- Public --------------------
 void MI0283QT2::init(void) {
+#ifndef HOST_SIMULATION
 //init pins
     MI0283QT2_IO_initalize();
 // init PWM for background LED
     PWM_BL_initalize();
+#endif
     setBrightness(BACKLIGHT_START_VALUE);
 
+#ifndef HOST_SIMULATION
 // deactivate read output control
     HY32D_RD_GPIO_PORT->BSRRL = HY32D_RD_PIN;
+#endif
 //initalize display
     if (initalizeDisplay()) {
         isLocalDisplayAvailable = true;
@@ -102,16 +120,12 @@ void MI0283QT2::clearDisplay(uint16_t aColor) {
 
     drawStart();
     for (size = (LOCAL_DISPLAY_HEIGHT * LOCAL_DISPLAY_WIDTH); size != 0; size--) {
-        HY32D_DATA_GPIO_PORT->ODR = aColor;
-        // Latch data write
-        HY32D_WR_GPIO_PORT->BSRRH = HY32D_WR_PIN;
-        HY32D_WR_GPIO_PORT->BSRRL = HY32D_WR_PIN;
-
+        draw(aColor);
     }
-    HY32D_CS_GPIO_PORT->BSRRL = HY32D_CS_PIN;
-
+    drawStop();
 }
 
+#ifndef HOST_SIMULATION
 /**
  * set register address to LCD_GRAM_READ/WRITE_REGISTER
  */
@@ -140,6 +154,7 @@ inline void draw(uint16_t color) {
 void drawStop(void) {
     HY32D_CS_GPIO_PORT->BSRRL = HY32D_CS_PIN;
 }
+#endif
 
 void MI0283QT2::drawPixel(uint16_t aXPos, uint16_t aYPos, uint16_t aColor) {
     if ((aXPos >= LOCAL_DISPLAY_WIDTH) || (aYPos >= LOCAL_DISPLAY_HEIGHT)) {
@@ -197,7 +212,7 @@ void MI0283QT2::fillRect(uint16_t aXStart, uint16_t aYStart, uint16_t aXEnd, uin
             draw(aColor); //7
             draw(aColor); //8
         }
-        for (i = size - tmp; i != 0; i--) {
+        for (i = size & 0x07; i != 0; i--) {
             draw(aColor);
         }
     } else {
@@ -264,6 +279,7 @@ void MI0283QT2::fillCircle(uint16_t aXCenter, uint16_t aYCenter, uint16_t aRadiu
     }
 }
 
+#ifndef HOST_SIMULATION
 uint16_t readPixel(uint16_t aXPos, uint16_t aYPos) {
     if ((aXPos >= LOCAL_DISPLAY_WIDTH) || (aYPos >= LOCAL_DISPLAY_HEIGHT)) {
         return 0;
@@ -290,6 +306,7 @@ uint16_t readPixel(uint16_t aXPos, uint16_t aYPos) {
 
     return tValue;
 }
+#endif
 
 void MI0283QT2::drawRect(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, uint16_t color) {
     fillRect(x0, y0, x0, y1, color);
@@ -367,10 +384,14 @@ uint16_t MI0283QT2::drawChar(uint16_t x, uint16_t y, char c, uint8_t size, uint1
      * check if a draw in routine which uses setArea() is already executed
      */
     uint32_t tLock;
+#ifdef HOST_SIMULATION
+    tLock = ++sDrawLock;
+#else
     do {
         tLock = __LDREXW(&sDrawLock);
         tLock++;
     } while (__STREXW(tLock, &sDrawLock));
+#endif
 
     if (tLock != 1) {
         // here in ISR, but interrupted process was still in drawChar()
@@ -638,7 +659,9 @@ uint16_t drawInteger(uint16_t x, uint16_t y, int val, uint8_t base, uint8_t size
 }
 
 void setBrightness(int aBacklightValue) {
+#ifndef HOST_SIMULATION
     PWM_BL_setOnRatio(aBacklightValue);
+#endif
     LCDLastBacklightValue = aBacklightValue;
 }
 
@@ -690,6 +713,7 @@ int clipBrightnessValue(int aBrightnessValue) {
     return aBrightnessValue;
 }
 
+#ifndef HOST_SIMULATION
 void writeCommand(int aRegisterAddress, int aRegisterValue) {
 // CS enable (low)
     HY32D_CS_GPIO_PORT->BSRRH = HY32D_CS_PIN;
@@ -741,6 +765,7 @@ uint16_t readCommand(int aRegisterAddress) {
     HY32D_CS_GPIO_PORT->BSRRL = HY32D_CS_PIN;
     return tValue;
 }
+#endif
 
 bool initalizeDisplay(void) {
 // Reset is done by hardware reset button
@@ -878,6 +903,7 @@ void setGamma(int aIndex) {
     }
 }
 
+#ifndef HOST_SIMULATION
 /**
  * reads a display line in BMP 16 Bit format. ie. only 5 bit for green
  */
@@ -910,52 +936,65 @@ uint16_t * fillDisplayLineBuffer(uint16_t * aBufferPtr, uint16_t yLineNumber) {
     return aBufferPtr;
 }
 
-extern "C" void storeScreenshot(void) {
-    uint8_t tFeedbackType = FEEDBACK_TONE_LONG_ERROR;
-    if (MICROSD_isCardInserted()) {
-
-        FIL tFile;
-        FRESULT tOpenResult;
-        UINT tCount;
 //	int filesize = 54 + 2 * LOCAL_DISPLAY_WIDTH * LOCAL_DISPLAY_HEIGHT;
+static const unsigned char bmpfileheader[14] = { 'B', 'M', 54, 88, 02, 0, 0, 0, 0, 0, 54, 0, 0, 0 };
+static const unsigned char bmpinfoheader[40] = { 40, 0, 0, 0, 64, 1, 0, 0, 240, 0, 0, 0, 1, 0, 16, 0 };
 
-        unsigned char bmpfileheader[14] = { 'B', 'M', 54, 88, 02, 0, 0, 0, 0, 0, 54, 0, 0, 0 };
-        unsigned char bmpinfoheader[40] = { 40, 0, 0, 0, 64, 1, 0, 0, 240, 0, 0, 0, 1, 0, 16, 0 };
-
-//	bmpfileheader[2] = (unsigned char) (filesize);
-//	bmpfileheader[3] = (unsigned char) (filesize >> 8);
-//	bmpfileheader[4] = (unsigned char) (filesize >> 16);
-//	bmpfileheader[5] = (unsigned char) (filesize >> 24);
-
-        RTC_getDateStringForFile(StringBuffer);
-        strcat(StringBuffer, ".bmp");
-        tOpenResult = f_open(&tFile, StringBuffer, FA_CREATE_ALWAYS | FA_WRITE);
-        uint16_t * tBufferPtr;
-        if (tOpenResult == FR_OK) {
-            uint16_t * tFourDisplayLinesBufferPointer = (uint16_t *) malloc(sizeof(uint16_t) * 4 * DISPLAY_DEFAULT_WIDTH);
-            if (tFourDisplayLinesBufferPointer == NULL) {
-                failParamMessage(sizeof(uint16_t) * 4 * DISPLAY_DEFAULT_WIDTH, "malloc() fails");
-            }
-            f_write(&tFile, bmpfileheader, 14, &tCount);
-            f_write(&tFile, bmpinfoheader, 40, &tCount);
-            // from left to right and from bottom to top
-            for (int i = LOCAL_DISPLAY_HEIGHT - 1; i >= 0;) {
-                tBufferPtr = tFourDisplayLinesBufferPointer;
-                // write 4 lines at a time to speed up I/O
-                tBufferPtr = fillDisplayLineBuffer(tBufferPtr, i--);
-                tBufferPtr = fillDisplayLineBuffer(tBufferPtr, i--);
-                tBufferPtr = fillDisplayLineBuffer(tBufferPtr, i--);
-                fillDisplayLineBuffer(tBufferPtr, i--);
-                // write a display line
-                f_write(&tFile, tFourDisplayLinesBufferPointer, LOCAL_DISPLAY_WIDTH * 8, &tCount);
-            }
-            free(tFourDisplayLinesBufferPointer);
-            f_close(&tFile);
-            tFeedbackType = FEEDBACK_TONE_NO_ERROR;
-        }
-    }
-    FeedbackTone(tFeedbackType);
+static struct CooperativeTask sScreenshotTask;
+// state of screenshot task, since local variables are not preserved across TASK_YIELD()
+static FIL sScreenshotFile;
+static uint16_t * sFourDisplayLinesBufferPointer;
+static int sScreenshotLine;
+
+/*
+ * Writes 4 display lines at each call, so events are handled in between.
+ * Content drawn by event handlers during the screenshot may be partially captured.
+ */
+static bool screenshotTask(struct CooperativeTask * aTask) {
+    UINT tCount;
+    uint16_t * tBufferPtr;
+    TASK_BEGIN(aTask);
+    if (!MICROSD_isCardInserted()) {
+        FeedbackTone(FEEDBACK_TONE_LONG_ERROR);
+        TASK_EXIT(aTask);
+    }
+    RTC_getDateStringForFile(StringBuffer);
+    strcat(StringBuffer, ".bmp");
+    if (f_open(&sScreenshotFile, StringBuffer, FA_CREATE_ALWAYS | FA_WRITE) != FR_OK) {
+        FeedbackTone(FEEDBACK_TONE_LONG_ERROR);
+        TASK_EXIT(aTask);
+    }
+    sFourDisplayLinesBufferPointer = (uint16_t *) malloc(sizeof(uint16_t) * 4 * DISPLAY_DEFAULT_WIDTH);
+    if (sFourDisplayLinesBufferPointer == NULL) {
+        failParamMessage(sizeof(uint16_t) * 4 * DISPLAY_DEFAULT_WIDTH, "malloc() fails");
+    }
+    f_write(&sScreenshotFile, bmpfileheader, 14, &tCount);
+    f_write(&sScreenshotFile, bmpinfoheader, 40, &tCount);
+    // from left to right and from bottom to top
+    for (sScreenshotLine = LOCAL_DISPLAY_HEIGHT - 1; sScreenshotLine >= 0;) {
+        TASK_YIELD(aTask);
+        tBufferPtr = sFourDisplayLinesBufferPointer;
+        // write 4 lines at a time to speed up I/O
+        tBufferPtr = fillDisplayLineBuffer(tBufferPtr, sScreenshotLine--);
+        tBufferPtr = fillDisplayLineBuffer(tBufferPtr, sScreenshotLine--);
+        tBufferPtr = fillDisplayLineBuffer(tBufferPtr, sScreenshotLine--);
+        fillDisplayLineBuffer(tBufferPtr, sScreenshotLine--);
+        // write a display line
+        f_write(&sScreenshotFile, sFourDisplayLinesBufferPointer, LOCAL_DISPLAY_WIDTH * 8, &tCount);
+    }
+    free(sFourDisplayLinesBufferPointer);
+    f_close(&sScreenshotFile);
+    FeedbackTone(FEEDBACK_TONE_NO_ERROR);
+    TASK_END(aTask);
+}
+
+/**
+ * Starts the screenshot task, which is run by checkAndHandleEvents(). May be called from an ISR.
+ */
+extern "C" void storeScreenshot(void) {
+    startCooperativeTask(&sScreenshotTask, &screenshotTask);
 }
+#endif // HOST_SIMULATION
 
 /** @} */
 /** @} */
@@ -0,0 +1,218 @@
+/**
+ * @file MI0283QT2_Host.cpp
+ *
+ * Host (x86 Linux) implementation of the MI0283QT2 / SSD1289 low level layer.
+ * Emulates the window and cursor registers and the GRAM in a framebuffer,
+ * so all drawing code above setArea/drawStart/draw/drawStop runs unchanged.
+ * Counts register and pixel accesses and estimates the resulting bus time.
+ *
+ * Only compiled if HOST_SIMULATION is defined.
+ *
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ */
+
+#ifdef HOST_SIMULATION
+
+#include "MI0283QT2.h"
+#include "BlueDisplay.h" // for BLUEMASK
+
+#include <stdio.h>
+#include <string.h>
+
+/** @addtogroup Graphic_Library
+ * @{
+ */
+/** @addtogroup MI0283QT2_basic
+ * @{
+ */
+#define LCD_GRAM_WRITE_REGISTER    0x22
+#define LCD_DEVICE_CODE            0x8989
+
+#define REGISTER_WINDOW_Y          0x44 // yStart + (yEnd << 8)
+#define REGISTER_WINDOW_X_START    0x45
+#define REGISTER_WINDOW_X_END      0x46
+#define REGISTER_CURSOR_Y          0x4E
+#define REGISTER_CURSOR_X          0x4F
+
+uint16_t HostFrameBuffer[LOCAL_DISPLAY_HEIGHT][LOCAL_DISPLAY_WIDTH];
+struct HostDisplayCounter HostDisplayCounters;
+
+/*
+ * Controller state
+ */
+static uint16_t sRegisters[0x100];
+static uint16_t sWindowXStart, sWindowXEnd = LOCAL_DISPLAY_WIDTH - 1;
+static uint16_t sWindowYStart, sWindowYEnd = LOCAL_DISPLAY_HEIGHT - 1;
+static uint16_t sCursorX, sCursorY;
+static int sScreenshotNumber = 0;
+
+/*
+ * Increment like the controller does with entry mode 0x6038 in landscape orientation.
+ * X first, then Y, both wrap inside the window.
+ */
+static inline void advanceCursor(void) {
+    if (sCursorX >= sWindowXEnd) {
+        sCursorX = sWindowXStart;
+        if (sCursorY >= sWindowYEnd) {
+            sCursorY = sWindowYStart;
+        } else {
+            sCursorY++;
+        }
+    } else {
+        sCursorX++;
+    }
+}
+
+void writeCommand(int aRegisterAddress, int aRegisterValue) {
+    HostDisplayCounters.RegisterWrites++;
+    HostDisplayCounters.BusNanos += HOST_BUS_NANOS_PER_REGISTER_WRITE;
+
+    sRegisters[aRegisterAddress & 0xFF] = aRegisterValue;
+    switch (aRegisterAddress) {
+    case REGISTER_WINDOW_Y:
+        sWindowYStart = aRegisterValue & 0xFF;
+        sWindowYEnd = (aRegisterValue >> 8) & 0xFF;
+        break;
+    case REGISTER_WINDOW_X_START:
+        sWindowXStart = aRegisterValue;
+        break;
+    case REGISTER_WINDOW_X_END:
+        sWindowXEnd = aRegisterValue;
+        break;
+    case REGISTER_CURSOR_Y:
+        sCursorY = aRegisterValue;
+        break;
+    case REGISTER_CURSOR_X:
+        sCursorX = aRegisterValue;
+        break;
+    default:
+        break;
+    }
+}
+
+uint16_t readCommand(int aRegisterAddress) {
+    HostDisplayCounters.RegisterReads++;
+    HostDisplayCounters.BusNanos += HOST_BUS_NANOS_PER_READ;
+    if (aRegisterAddress == 0x0000) {
+        return LCD_DEVICE_CODE;
+    }
+    return sRegisters[aRegisterAddress & 0xFF];
+}
+
+/**
+ * set register address to LCD_GRAM_READ/WRITE_REGISTER
+ */
+void drawStart(void) {
+    HostDisplayCounters.DrawStarts++;
+    // only the address cycle of a register write
+    HostDisplayCounters.BusNanos += HOST_BUS_NANOS_PER_REGISTER_WRITE / 2;
+}
+
+void draw(uint16_t color) {
+    HostDisplayCounters.PixelWrites++;
+    HostDisplayCounters.BusNanos += HOST_BUS_NANOS_PER_PIXEL_WRITE;
+    if (sCursorX < LOCAL_DISPLAY_WIDTH && sCursorY < LOCAL_DISPLAY_HEIGHT) {
+        HostFrameBuffer[sCursorY][sCursorX] = color;
+    }
+    advanceCursor();
+}
+
+void drawStop(void) {
+}
+
+uint16_t readPixel(uint16_t aXPos, uint16_t aYPos) {
+    if ((aXPos >= LOCAL_DISPLAY_WIDTH) || (aYPos >= LOCAL_DISPLAY_HEIGHT)) {
+        return 0;
+    }
+    writeCommand(REGISTER_CURSOR_Y, aYPos);
+    writeCommand(REGISTER_CURSOR_X, aXPos);
+    drawStart();
+    HostDisplayCounters.PixelReads++;
+    HostDisplayCounters.BusNanos += HOST_BUS_NANOS_PER_READ;
+    return HostFrameBuffer[aYPos][aXPos];
+}
+
+/**
+ * reads a display line in BMP 16 Bit format. ie. only 5 bit for green
+ */
+uint16_t * fillDisplayLineBuffer(uint16_t * aBufferPtr, uint16_t yLineNumber) {
+    setArea(0, yLineNumber, LOCAL_DISPLAY_WIDTH - 1, yLineNumber);
+    drawStart();
+    for (uint16_t i = 0; i < LOCAL_DISPLAY_WIDTH; ++i) {
+        uint16_t tValue = HostFrameBuffer[yLineNumber][i];
+        // shift red and green one bit down so that every color has 5 bits
+        *aBufferPtr++ = (tValue & BLUEMASK) | ((tValue >> 1) & ~BLUEMASK);
+    }
+    // first dummy read + one read per pixel
+    HostDisplayCounters.PixelReads += LOCAL_DISPLAY_WIDTH + 1;
+    HostDisplayCounters.BusNanos += (LOCAL_DISPLAY_WIDTH + 1) * HOST_BUS_NANOS_PER_READ;
+    return aBufferPtr;
+}
+
+/*
+ * Host functions
+ */
+void hostResetDisplayCounters(void) {
+    memset(&HostDisplayCounters, 0, sizeof(HostDisplayCounters));
+}
+
+void hostPrintDisplayCounters(FILE * aFile) {
+    fprintf(aFile, "RegisterWrites=%u RegisterReads=%u DrawStarts=%u PixelWrites=%u PixelReads=%u BusTime=%lluus\n",
+            HostDisplayCounters.RegisterWrites, HostDisplayCounters.RegisterReads, HostDisplayCounters.DrawStarts,
+            HostDisplayCounters.PixelWrites, HostDisplayCounters.PixelReads,
+            (unsigned long long) (HostDisplayCounters.BusNanos / 1000));
+}
+
+/**
+ * Reads framebuffer without affecting counters or cursor. For golden image comparisons.
+ */
+uint16_t hostGetPixel(uint16_t aXPos, uint16_t aYPos) {
+    if ((aXPos >= LOCAL_DISPLAY_WIDTH) || (aYPos >= LOCAL_DISPLAY_HEIGHT)) {
+        return 0;
+    }
+    return HostFrameBuffer[aYPos][aXPos];
+}
+
+/**
+ * Writes framebuffer as binary PPM (P6) with 8 bit per color
+ * @return false if file could not be written
+ */
+bool hostStoreDisplayPPM(const char * aFilename) {
+    FILE * tFile = fopen(aFilename, "wb");
+    if (tFile == NULL) {
+        return false;
+    }
+    fprintf(tFile, "P6\n%u %u\n255\n", LOCAL_DISPLAY_WIDTH, LOCAL_DISPLAY_HEIGHT);
+    uint8_t tLine[LOCAL_DISPLAY_WIDTH * 3];
+    for (unsigned int y = 0; y < LOCAL_DISPLAY_HEIGHT; ++y) {
+        uint8_t * tLinePtr = tLine;
+        for (unsigned int x = 0; x < LOCAL_DISPLAY_WIDTH; ++x) {
+            uint16_t tColor = HostFrameBuffer[y][x];
+            uint8_t tRed = (tColor >> 11) & 0x1F;
+            uint8_t tGreen = (tColor >> 5) & 0x3F;
+            uint8_t tBlue = tColor & 0x1F;
+            // replicate upper bits to get full 8 bit range
+            *tLinePtr++ = (tRed << 3) | (tRed >> 2);
+            *tLinePtr++ = (tGreen << 2) | (tGreen >> 4);
+            *tLinePtr++ = (tBlue << 3) | (tBlue >> 2);
+        }
+        fwrite(tLine, 1, sizeof(tLine), tFile);
+    }
+    bool tReturn = (ferror(tFile) == 0);
+    fclose(tFile);
+    return tReturn;
+}
+
+/**
+ * Host replacement for the BMP to SD card screenshot
+ */
+extern "C" void storeScreenshot(void) {
+    char tFilename[32];
+    snprintf(tFilename, sizeof(tFilename), "screenshot%03d.ppm", sScreenshotNumber++);
+    hostStoreDisplayPPM(tFilename);
+}
+
+/** @} */
+/** @} */
+
+#endif // HOST_SIMULATION
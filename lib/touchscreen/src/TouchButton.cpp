@@ -22,9 +22,12 @@
 
 #include "TouchButton.h"
 #include "TouchButtonAutorepeat.h"
+#include "TouchGrid.h"
 #include "EventHandler.h"
 #include "AssertErrorAndMisc.h"
+#ifndef HOST_SIMULATION
 #include "stm32fx0xPeripherals.h"// for FeedbackToneOK
+#endif
 #ifdef REMOTE_DISPLAY_SUPPORTED
 #include "BlueDisplayProtocol.h"
 #include "BlueSerial.h"
@@ -45,10 +48,8 @@
 /**
  * The preallocated pool of buttons for this application
  */
-TouchButton TouchButton::TouchButtonPool[NUMBER_OF_BUTTONS_IN_POOL]; // 2000 Bytes
-uint8_t TouchButton::sButtonCombinedPoolSize = NUMBER_OF_BUTTONS_IN_POOL;// NUMBER_OF_AUTOREPEAT_BUTTONS_IN_POOL is added while initializing autorepeat pool
-uint8_t TouchButton::sMinButtonPoolSize = NUMBER_OF_BUTTONS_IN_POOL;
-bool TouchButton::sButtonPoolIsInitialized = false;
+TouchButton TouchButton::TouchButtonPool[NUMBER_OF_BUTTONS_IN_POOL]; // 3744 Bytes
+struct TouchPool TouchButton::sButtonPool;
 #endif
 
 /*
@@ -57,10 +58,31 @@ bool TouchButton::sButtonPoolIsInitialized = false;
 TouchButton * TouchButton::sButtonListStart = NULL;
 uint16_t TouchButton::sDefaultCaptionColor = TOUCHBUTTON_DEFAULT_CAPTION_COLOR;
 
+#ifndef DO_NOT_USE_TOUCH_GRID
+/*
+ * Grid of active buttons for checkAllButtons()
+ */
+static void * sButtonGridEntries[BUTTON_GRID_MAX_ENTRIES];
+static struct TouchGrid sButtonGrid = { { 0 }, sButtonGridEntries, BUTTON_GRID_MAX_ENTRIES, false, false };
+#endif
+
+/*
+ * Grid is built again on next touch
+ */
+static void invalidateButtonGrid(void) {
+#ifndef DO_NOT_USE_TOUCH_GRID
+    invalidateTouchGrid(&sButtonGrid);
+#endif
+}
+
 /*
  * Constructor - insert in list
  */
 TouchButton::TouchButton(void) {
+    invalidateButtonGrid();
+#ifdef USE_BUTTON_POOL
+    mPoolEntry.Pool = NULL; // initTouchPool() sets it for pool buttons
+#endif
     mNextObject = NULL;
     if (sButtonListStart == NULL) {
         // first button
@@ -81,6 +103,7 @@ TouchButton::TouchButton(void) {
  * Destructor  - remove from button list
  */
 TouchButton::~TouchButton(void) {
+    invalidateButtonGrid();
     TouchButton * tButtonPointer = sButtonListStart;
     if (tButtonPointer == this) {
         // remove first element of list
@@ -106,7 +129,7 @@ TouchButton * TouchButton::getLocalButtonFromBDButtonHandle(BDButtonHandle_t aBu
     TouchButton * tButtonPointer = sButtonListStart;
 // walk through list
     while (tButtonPointer != NULL) {
-        if (tButtonPointer->mBDButtonPtr->mButtonHandle == aButtonHandleToSearchFor) {
+        if (tButtonPointer->isAllocated() && tButtonPointer->mBDButtonPtr->mButtonHandle == aButtonHandleToSearchFor) {
             break;
         }
         tButtonPointer = tButtonPointer->mNextObject;
@@ -127,13 +150,17 @@ void TouchButton::reinitAllLocalButtonsForRemote(void) {
         sLocalButtonIndex = 0;
 // walk through list
         while (tButtonPointer != NULL) {
+            if (!tButtonPointer->isAllocated()) {
+                tButtonPointer = tButtonPointer->mNextObject;
+                continue;
+            }
             // cannot use BDButton.init since this allocates a new TouchButton
             sendUSARTArgsAndByteBuffer(FUNCTION_BUTTON_CREATE, 11, tButtonPointer->mBDButtonPtr->mButtonHandle,
                     tButtonPointer->mPositionX, tButtonPointer->mPositionY, tButtonPointer->mWidthX,
                     tButtonPointer->mHeightY, tButtonPointer->mButtonColor, tButtonPointer->mCaptionSize,
                     tButtonPointer->mFlags & ~(LOCAL_BUTTON_FLAG_MASK), tButtonPointer->mValue,
                     tButtonPointer->mOnTouchHandler,
-                    (reinterpret_cast<uint32_t>(tButtonPointer->mOnTouchHandler) >> 16),
+                    (reinterpret_cast<uintptr_t>(tButtonPointer->mOnTouchHandler) >> 16),
                     strlen(tButtonPointer->mCaption), tButtonPointer->mCaption);
             if (tButtonPointer->mFlags & BUTTON_FLAG_TYPE_AUTOREPEAT) {
                 TouchButtonAutorepeat * tAutorepeatButtonPointer = (TouchButtonAutorepeat*) tButtonPointer;
@@ -184,6 +211,7 @@ int8_t TouchButton::initButton(uint16_t aPositionX, uint16_t aPositionY, uint16_
 }
 
 int8_t TouchButton::setPosition(uint16_t aPositionX, uint16_t aPositionY) {
+    invalidateButtonGrid();
     int8_t tRetValue = 0;
     mPositionX = aPositionX;
     mPositionY = aPositionY;
@@ -215,7 +243,7 @@ void TouchButton::drawButton() {
  * deactivates the button and redraws its screen space with @a aBackgroundColor
  */
 void TouchButton::removeButton(uint16_t aBackgroundColor) {
-    mFlags &= ~FLAG_IS_ACTIVE;
+    deactivate();
 // Draw rect
     LocalDisplay.fillRectRel(mPositionX, mPositionY, mWidthX, mHeightY, aBackgroundColor);
 
@@ -226,7 +254,7 @@ void TouchButton::removeButton(uint16_t aBackgroundColor) {
  * @retval 0 or error number #TOUCHBUTTON_ERROR_CAPTION_TOO_LONG etc.
  */
 void TouchButton::drawCaption(void) {
-    mFlags |= FLAG_IS_ACTIVE;
+    activate();
     if (mCaptionSize > 0) { // dont render anything if caption size == 0
         if (mCaption != NULL) {
             int tXCaptionPosition;
@@ -236,7 +264,7 @@ void TouchButton::drawCaption(void) {
              * 1. position first string in the middle of the box
              * 2. draw second string just below
              */
-            char * tPosOfNewline = strchr(mCaption, '\n');
+            const char * tPosOfNewline = strchr(mCaption, '\n');
             int tCaptionHeight = getTextHeight(mCaptionSize);
             int tStringlength = strlen(mCaption);
             if (tPosOfNewline != NULL) {
@@ -297,7 +325,8 @@ bool TouchButton::checkButtonInArea(uint16_t aTouchPositionX, uint16_t aTouchPos
  * if no - return false
  */
 bool TouchButton::checkButton(uint16_t aTouchPositionX, uint16_t aTouchPositionY) {
-    if ((mFlags & FLAG_IS_ACTIVE) && mOnTouchHandler != NULL && checkButtonInArea(aTouchPositionX, aTouchPositionY)) {
+    if ((mFlags & FLAG_IS_ACTIVE) && mOnTouchHandler != NULL && isAllocated()
+            && checkButtonInArea(aTouchPositionX, aTouchPositionY)) {
         /*
          *  Touch position is in button - call callback function
          */
@@ -320,10 +349,59 @@ bool TouchButton::checkButton(uint16_t aTouchPositionX, uint16_t aTouchPositionY
     return false;
 }
 
+/**
+ * Adds all active buttons to the grid in list order
+ */
+void TouchButton::buildButtonGrid(void) {
+#ifndef DO_NOT_USE_TOUCH_GRID
+    startTouchGridCount(&sButtonGrid);
+    TouchButton * tButtonPointer = sButtonListStart;
+    while (tButtonPointer != NULL) {
+        if ((tButtonPointer->mFlags & FLAG_IS_ACTIVE) && tButtonPointer->isAllocated()) {
+            // area of checkButtonInArea()
+            countTouchGridArea(&sButtonGrid, tButtonPointer->mPositionX, tButtonPointer->mPositionY,
+                    tButtonPointer->mPositionX + tButtonPointer->mWidthX, tButtonPointer->mPositionY + tButtonPointer->mHeightY);
+        }
+        tButtonPointer = tButtonPointer->mNextObject;
+    }
+    startTouchGridFill(&sButtonGrid);
+    tButtonPointer = sButtonListStart;
+    while (tButtonPointer != NULL) {
+        if ((tButtonPointer->mFlags & FLAG_IS_ACTIVE) && tButtonPointer->isAllocated()) {
+            addToTouchGrid(&sButtonGrid, tButtonPointer, tButtonPointer->mPositionX, tButtonPointer->mPositionY,
+                    tButtonPointer->mPositionX + tButtonPointer->mWidthX, tButtonPointer->mPositionY + tButtonPointer->mHeightY);
+        }
+        tButtonPointer = tButtonPointer->mNextObject;
+    }
+    endTouchGridFill(&sButtonGrid);
+#endif
+}
+
 /**
  * Static convenience method - checks all buttons for matching touch position.
+ * Only the buttons of the touched grid cell are checked.
  */
 uint8_t TouchButton::checkAllButtons(unsigned int aTouchPositionX, unsigned int aTouchPositionY) {
+#ifndef DO_NOT_USE_TOUCH_GRID
+    if (!sButtonGrid.IsValid) {
+        buildButtonGrid();
+    }
+    uint16_t tNumberOfCandidates;
+    void * const * tCandidates = getTouchGridCandidates(&sButtonGrid, aTouchPositionX, aTouchPositionY, &tNumberOfCandidates);
+    if (tCandidates != NULL) {
+        for (uint16_t i = 0; i < tNumberOfCandidates; ++i) {
+            TouchButton * tButtonPointer = (TouchButton *) tCandidates[i];
+            if (tButtonPointer->checkButton(aTouchPositionX, aTouchPositionY)) {
+                if (tButtonPointer->mFlags & BUTTON_FLAG_TYPE_AUTOREPEAT) {
+                    return BUTTON_TOUCHED_AUTOREPEAT;
+                } else {
+                    return BUTTON_TOUCHED;
+                }
+            }
+        }
+        return NOT_TOUCHED;
+    }
+#endif
 // walk through list of active elements
     TouchButton * tButtonPointer = sButtonListStart;
     while (tButtonPointer != NULL) {
@@ -460,15 +538,32 @@ uint16_t TouchButton::getPositionYBottom() const {
 /*
  * activate for touch checking
  */
+/**
+ * @return false if button is a free pool button, which is also the case after freeAllButtonsOfPage()
+ */
+bool TouchButton::isAllocated(void) const {
+#ifdef USE_BUTTON_POOL
+    return isTouchPoolEntryAllocated(&mPoolEntry);
+#else
+    return true;
+#endif
+}
+
 void TouchButton::activate() {
-    mFlags |= FLAG_IS_ACTIVE;
+    if (!(mFlags & FLAG_IS_ACTIVE)) {
+        mFlags |= FLAG_IS_ACTIVE;
+        invalidateButtonGrid();
+    }
 }
 
 /*
  * deactivate for touch checking
  */
 void TouchButton::deactivate() {
-    mFlags &= ~FLAG_IS_ACTIVE;
+    if (mFlags & FLAG_IS_ACTIVE) {
+        mFlags &= ~FLAG_IS_ACTIVE;
+        invalidateButtonGrid();
+    }
 }
 
 void TouchButton::setTouchHandler(void (*aOnTouchHandler)(TouchButton*, int16_t)) {
@@ -544,74 +639,76 @@ TouchButton * TouchButton::allocAndInitButton(uint16_t aPositionX, uint16_t aPos
  ****************************/
 
 /**
- * Allocate / get first button from the unallocated buttons
- * @retval Button pointer or message and NULL pointer if no button available
+ * Initializes the pools of buttons and autorepeat buttons at first use.
+ * All pool buttons are already in the button list by their constructor and stay there.
  */
-TouchButton * TouchButton::allocButton(bool aOnlyAutorepeatButtons) {
-    TouchButton * tButtonPointer;
-    if (!sButtonPoolIsInitialized) {
-        tButtonPointer = NULL;
-        // mark pool as free
-        for (int i = NUMBER_OF_BUTTONS_IN_POOL - 1; i >= 0; i--) {
-            TouchButtonPool[i].mFlags = 0;
-            TouchButtonPool[i].mNextObject = tButtonPointer;
-            tButtonPointer = &TouchButtonPool[i];
-        }
-        sButtonPoolIsInitialized = true;
-        sButtonListStart = &TouchButtonPool[0];
+void TouchButton::initButtonPools(void) {
+    if (!sButtonPool.IsInitialized) {
+        initTouchPool(&sButtonPool, TouchButtonPool, &TouchButtonPool[0].mPoolEntry, sizeof(TouchButton),
+        NUMBER_OF_BUTTONS_IN_POOL);
     }
-
-// walk through list
-    tButtonPointer = sButtonListStart;
-    while (tButtonPointer != NULL && (tButtonPointer->mFlags & FLAG_IS_ALLOCATED)) {
-        tButtonPointer = tButtonPointer->mNextObject;
+    if (!TouchButtonAutorepeat::sAutorepeatButtonPool.IsInitialized) {
+        initTouchPool(&TouchButtonAutorepeat::sAutorepeatButtonPool, TouchButtonAutorepeat::TouchButtonAutorepeatPool,
+                &TouchButtonAutorepeat::TouchButtonAutorepeatPool[0].mPoolEntry, sizeof(TouchButtonAutorepeat),
+                NUMBER_OF_AUTOREPEAT_BUTTONS_IN_POOL);
     }
+}
+
+/**
+ * Allocate / get first button from the free list of unallocated buttons
+ * @retval Button pointer or message and pointer to first pool button if no button available
+ */
+TouchButton * TouchButton::allocButton(bool aOnlyAutorepeatButtons) {
+    initButtonPools();
+    TouchButton * tButtonPointer = (TouchButton *) allocTouchPoolElement(&sButtonPool);
     if (tButtonPointer == NULL) {
-        failParamMessage(sButtonCombinedPoolSize, "No button available");
+        failParamMessage(sButtonPool.NumberOfAllocatedElements, "No button available");
         // to avoid NULL pointer
-        tButtonPointer = sButtonListStart;
+        tButtonPointer = &TouchButtonPool[0];
     } else {
-        tButtonPointer->mFlags |= FLAG_IS_ALLOCATED;
-        sButtonCombinedPoolSize--;
-    }
-
-    if (sButtonCombinedPoolSize < sMinButtonPoolSize) {
-        sMinButtonPoolSize = sButtonCombinedPoolSize;
+        // flags of a button freed by freeAllButtonsOfPage() are still set. Do not touch the live fallback button.
+        tButtonPointer->mFlags = 0;
     }
     return tButtonPointer;
 }
 
 /**
- * Deallocates / free a button and put it back to button bool
- * Do not need to remove from list since FLAG_IS_ALLOCATED ist set
+ * Deallocates / free a button and put it back to button pool
+ * Do not need to remove from list since it is skipped by isAllocated()
  */
 void TouchButton::setFree(void) {
-    assertParamMessage((this != NULL), sButtonCombinedPoolSize, "Button handle is null");
-    sButtonCombinedPoolSize++;
-    mFlags &= ~FLAG_IS_ALLOCATED;
-    mFlags &= ~FLAG_IS_ACTIVE;
+    assertParamMessage((this != NULL), sButtonPool.NumberOfAllocatedElements, "Button handle is null");
+    deactivate();
+    freeTouchPoolEntry(&mPoolEntry);
 }
 
 /**
  * free / release one button to the unallocated buttons
  */
 void TouchButton::freeButton(TouchButton * aTouchButton) {
-    TouchButton * tButtonPointer = sButtonListStart;
-// walk through list
-    while (tButtonPointer != NULL && tButtonPointer != aTouchButton) {
-        tButtonPointer = tButtonPointer->mNextObject;
-    }
-    if (tButtonPointer == NULL) {
-        failParamMessage(aTouchButton, "Button not found in list");
-    } else {
-        sButtonCombinedPoolSize++;
-        tButtonPointer->mFlags &= ~FLAG_IS_ALLOCATED;
-        tButtonPointer->mFlags &= ~FLAG_IS_ACTIVE;
-    }
+    aTouchButton->setFree();
 }
 
 /**
- * prints amount of total, free and active buttons
+ * Buttons allocated from now on belong to a new page, which can be freed at once by freeAllButtonsOfPage()
+ */
+void TouchButton::startButtonPage(void) {
+    initButtonPools();
+    startTouchPoolPage(&sButtonPool);
+    startTouchPoolPage(&TouchButtonAutorepeat::sAutorepeatButtonPool);
+}
+
+/**
+ * Frees all buttons allocated since the last startButtonPage() in constant time
+ */
+void TouchButton::freeAllButtonsOfPage(void) {
+    freeTouchPoolPage(&sButtonPool);
+    freeTouchPoolPage(&TouchButtonAutorepeat::sAutorepeatButtonPool);
+    invalidateButtonGrid();
+}
+
+/**
+ * prints amount of total, free and active buttons in list and allocated and max allocated buttons of both pools
  * @param aStringBuffer the string buffer for the result
  */
 void TouchButton::infoButtonPool(char * aStringBuffer) {
@@ -622,17 +719,18 @@ void TouchButton::infoButtonPool(char * aStringBuffer) {
 // walk through list
     while (tObjectPointer != NULL) {
         tTotal++;
-        if (!(tObjectPointer->mFlags & FLAG_IS_ALLOCATED)) {
+        if (!tObjectPointer->isAllocated()) {
             tFree++;
-        }
-        if (tObjectPointer->mFlags & FLAG_IS_ACTIVE) {
+        } else if (tObjectPointer->mFlags & FLAG_IS_ACTIVE) {
             tActive++;
         }
         tObjectPointer = tObjectPointer->mNextObject;
     }
-// output real and computed free values
-    sprintf(aStringBuffer, "total=%2d free=%2d |%2d min=%2d active=%2d ", tTotal, tFree, sButtonCombinedPoolSize,
-            sMinButtonPoolSize, tActive);
+// output real and computed values
+    sprintf(aStringBuffer, "total=%2d free=%2d used=%2d+%d max=%2d+%d active=%2d ", tTotal, tFree,
+            sButtonPool.NumberOfAllocatedElements, TouchButtonAutorepeat::sAutorepeatButtonPool.NumberOfAllocatedElements,
+            sButtonPool.MaxNumberOfAllocatedElements, TouchButtonAutorepeat::sAutorepeatButtonPool.MaxNumberOfAllocatedElements,
+            tActive);
 }
 #endif
 
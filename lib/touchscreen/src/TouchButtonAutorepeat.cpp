@@ -37,8 +37,7 @@
 
 #ifdef USE_BUTTON_POOL
 TouchButtonAutorepeat TouchButtonAutorepeat::TouchButtonAutorepeatPool[NUMBER_OF_AUTOREPEAT_BUTTONS_IN_POOL];
-TouchButtonAutorepeat * TouchButtonAutorepeat::sAutorepeatButtonListStart = NULL;
-bool TouchButtonAutorepeat::sButtonAutorepeatPoolIsInitialized = false;
+struct TouchPool TouchButtonAutorepeat::sAutorepeatButtonPool;
 #endif
 
 uint8_t TouchButtonAutorepeat::sState;
@@ -140,67 +139,21 @@ bool TouchButtonAutorepeat::autorepeatButtonTimerHandler(int aTouchPositionX, in
 #ifdef USE_BUTTON_POOL
 
 /**
- * Allocate / get first button from the unallocated buttons
- * @retval Button pointer or message and NULL pointer if no button available
+ * Allocate / get first button from the free list of unallocated autorepeat buttons
+ * @retval Button pointer or message and pointer to first pool button if no button available
  */
 TouchButtonAutorepeat * TouchButtonAutorepeat::allocAutorepeatButton() {
-    TouchButtonAutorepeat * tButtonPointer;
-    if (!sButtonAutorepeatPoolIsInitialized) {
-        tButtonPointer = NULL;
-        // mark pool as free
-        for (int i = NUMBER_OF_AUTOREPEAT_BUTTONS_IN_POOL - 1; i >= 0; i--) {
-            TouchButtonAutorepeatPool[i].mFlags = 0;
-            TouchButtonAutorepeatPool[i].mNextObject = tButtonPointer;
-            tButtonPointer = &TouchButtonAutorepeatPool[i];
-        }
-        sButtonAutorepeatPoolIsInitialized = true;
-        sAutorepeatButtonListStart = &TouchButtonAutorepeatPool[0];
-        TouchButton::sButtonCombinedPoolSize += NUMBER_OF_AUTOREPEAT_BUTTONS_IN_POOL;
-    }
-
-    // walk through list
-    tButtonPointer = sAutorepeatButtonListStart;
-    while (tButtonPointer != NULL && (tButtonPointer->mFlags & FLAG_IS_ALLOCATED)) {
-        tButtonPointer = (TouchButtonAutorepeat*) tButtonPointer->mNextObject;
-    }
+    initButtonPools();
+    TouchButtonAutorepeat * tButtonPointer = (TouchButtonAutorepeat *) allocTouchPoolElement(&sAutorepeatButtonPool);
     if (tButtonPointer == NULL) {
-        failParamMessage(sButtonCombinedPoolSize, "No autorepeat button available");
+        failParamMessage(sAutorepeatButtonPool.NumberOfAllocatedElements, "No autorepeat button available");
         // to avoid NULL pointer
-        tButtonPointer = sAutorepeatButtonListStart;
-    } else {
-        tButtonPointer->mFlags |= FLAG_IS_ALLOCATED;
-        sButtonCombinedPoolSize--;
-    }
-
-    if (sButtonCombinedPoolSize < sMinButtonPoolSize) {
-        sMinButtonPoolSize = sButtonCombinedPoolSize;
+        tButtonPointer = &TouchButtonAutorepeatPool[0];
     }
+    // flags of a button freed by freeAllButtonsOfPage() are still set
+    tButtonPointer->mFlags = 0;
     return tButtonPointer;
 }
-
-#ifdef REMOTE_DISPLAY_SUPPORTED
-/*
- * is called once after reconnect, to build up a remote copy of all local buttons
- */
-void TouchButtonAutorepeat::reinitAllLocalAutorepeatButtonsForRemote(void) {
-    if (USART_isBluetoothPaired()) {
-        TouchButtonAutorepeat * tButtonPointer = sAutorepeatButtonListStart;
-// walk through list
-        while (tButtonPointer != NULL) {
-            // cannot use BDButton.init since this allocates a new TouchButton
-            sendUSARTArgsAndByteBuffer(FUNCTION_TAG_BUTTON_CREATE, 10, tButtonPointer->mBDButtonPtr->mButtonHandle,
-                    tButtonPointer->mPositionX, tButtonPointer->mPositionY, tButtonPointer->mWidthX,
-                    tButtonPointer->mHeightY, tButtonPointer->mButtonColor,
-                    tButtonPointer->mCaptionSize | (tButtonPointer->mFlags << 8), tButtonPointer->mValue,
-                    tButtonPointer->mOnTouchHandler,
-                    (reinterpret_cast<uint32_t>(tButtonPointer->mOnTouchHandler) >> 16),
-                    strlen(tButtonPointer->mCaption), tButtonPointer->mCaption);
-            sLocalButtonIndex++;
-            tButtonPointer = (TouchButtonAutorepeat *) tButtonPointer->mNextObject;
-        }
-    }
-}
-#endif
 #endif
 
 /** @} */
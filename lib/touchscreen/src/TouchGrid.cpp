@@ -0,0 +1,112 @@
+/**
+ * @file TouchGrid.cpp
+ *
+ * Grid of cells for fast touch to button and slider lookup. See TouchGrid.h.
+ *
+ * Usage:
+ *  startTouchGridCount(), countTouchGridArea() for each object,
+ *  startTouchGridFill(), addToTouchGrid() for the same objects in the same order, endTouchGridFill().
+ *
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ */
+
+#include "TouchGrid.h"
+
+#include <stddef.h> // for NULL
+#include <string.h> // for memset
+
+static uint8_t getColumn(uint16_t aPositionX) {
+    uint16_t tColumn = aPositionX / TOUCH_GRID_CELL_SIZE;
+    if (tColumn >= TOUCH_GRID_NUMBER_OF_COLUMNS) {
+        tColumn = TOUCH_GRID_NUMBER_OF_COLUMNS - 1;
+    }
+    return tColumn;
+}
+
+static uint8_t getRow(uint16_t aPositionY) {
+    uint16_t tRow = aPositionY / TOUCH_GRID_CELL_SIZE;
+    if (tRow >= TOUCH_GRID_NUMBER_OF_ROWS) {
+        tRow = TOUCH_GRID_NUMBER_OF_ROWS - 1;
+    }
+    return tRow;
+}
+
+/**
+ * Must be called if an object is activated, deactivated, moved, created or deleted
+ */
+void invalidateTouchGrid(struct TouchGrid * aGrid) {
+    aGrid->IsValid = false;
+}
+
+void startTouchGridCount(struct TouchGrid * aGrid) {
+    memset(aGrid->CellStart, 0, sizeof(aGrid->CellStart));
+    aGrid->IsOverflow = false;
+}
+
+/**
+ * Touch area including right and bottom border
+ */
+void countTouchGridArea(struct TouchGrid * aGrid, uint16_t aXLeft, uint16_t aYTop, uint16_t aXRight, uint16_t aYBottom) {
+    uint8_t tColumnRight = getColumn(aXRight);
+    uint8_t tRowBottom = getRow(aYBottom);
+    for (uint8_t tRow = getRow(aYTop); tRow <= tRowBottom; ++tRow) {
+        for (uint8_t tColumn = getColumn(aXLeft); tColumn <= tColumnRight; ++tColumn) {
+            // count is stored in the start of the next cell
+            aGrid->CellStart[tRow * TOUCH_GRID_NUMBER_OF_COLUMNS + tColumn + 1]++;
+        }
+    }
+}
+
+/**
+ * Converts the counts to the start of each cell
+ */
+void startTouchGridFill(struct TouchGrid * aGrid) {
+    for (uint8_t i = 1; i <= TOUCH_GRID_NUMBER_OF_CELLS; ++i) {
+        aGrid->CellStart[i] += aGrid->CellStart[i - 1];
+    }
+    if (aGrid->CellStart[TOUCH_GRID_NUMBER_OF_CELLS] > aGrid->MaxNumberOfEntries) {
+        aGrid->IsOverflow = true;
+    }
+}
+
+/**
+ * Uses CellStart[i] as fill position of cell i, which is afterwards the start of cell i + 1
+ */
+void addToTouchGrid(struct TouchGrid * aGrid, void * aObject, uint16_t aXLeft, uint16_t aYTop, uint16_t aXRight,
+        uint16_t aYBottom) {
+    if (aGrid->IsOverflow) {
+        return;
+    }
+    uint8_t tColumnRight = getColumn(aXRight);
+    uint8_t tRowBottom = getRow(aYBottom);
+    for (uint8_t tRow = getRow(aYTop); tRow <= tRowBottom; ++tRow) {
+        for (uint8_t tColumn = getColumn(aXLeft); tColumn <= tColumnRight; ++tColumn) {
+            aGrid->Entries[aGrid->CellStart[tRow * TOUCH_GRID_NUMBER_OF_COLUMNS + tColumn]++] = aObject;
+        }
+    }
+}
+
+/**
+ * Restores the start of each cell
+ */
+void endTouchGridFill(struct TouchGrid * aGrid) {
+    for (uint8_t i = TOUCH_GRID_NUMBER_OF_CELLS; i > 0; --i) {
+        aGrid->CellStart[i] = aGrid->CellStart[i - 1];
+    }
+    aGrid->CellStart[0] = 0;
+    aGrid->IsValid = true;
+}
+
+/**
+ * @return objects whose touch area overlaps the cell of the touch position in list order,
+ * or NULL if grid is overflowed and all objects must be checked
+ */
+void * const * getTouchGridCandidates(const struct TouchGrid * aGrid, uint16_t aTouchPositionX, uint16_t aTouchPositionY,
+        uint16_t * aNumberOfCandidatesPtr) {
+    if (aGrid->IsOverflow) {
+        return NULL;
+    }
+    uint8_t tCell = getRow(aTouchPositionY) * TOUCH_GRID_NUMBER_OF_COLUMNS + getColumn(aTouchPositionX);
+    *aNumberOfCandidatesPtr = aGrid->CellStart[tCell + 1] - aGrid->CellStart[tCell];
+    return &aGrid->Entries[aGrid->CellStart[tCell]];
+}
@@ -0,0 +1,150 @@
+/**
+ * @file TouchPool.cpp
+ *
+ * Pool of preallocated buttons or sliders. See TouchPool.h.
+ *
+ * Usage:
+ *  initTouchPool() once, allocTouchPoolElement() and freeTouchPoolEntry() for single elements,
+ *  startTouchPoolPage() before allocating the elements of a page and freeTouchPoolPage() to free all of them.
+ *
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ */
+
+#include "TouchPool.h"
+
+#include <stddef.h> // for NULL
+#include <string.h> // for memset
+
+static struct TouchPoolEntry * getEntry(struct TouchPool * aPool, uint8_t aIndex) {
+    return (struct TouchPoolEntry *) (aPool->FirstEntry + aIndex * aPool->ElementSize);
+}
+
+static void pushFreeEntry(struct TouchPool * aPool, struct TouchPoolEntry * aEntry) {
+    aEntry->IsAllocated = false;
+    aEntry->NextFree = aPool->FreeList;
+    aPool->FreeList = aEntry;
+}
+
+/*
+ * Puts all stale entries back into the free list
+ */
+static void reclaimStaleEntries(struct TouchPool * aPool) {
+    for (uint8_t i = 0; i < aPool->NumberOfElements; ++i) {
+        struct TouchPoolEntry * tEntry = getEntry(aPool, i);
+        if (tEntry->IsAllocated && tEntry->PageGeneration != aPool->PageGeneration[tEntry->PageLevel]) {
+            pushFreeEntry(aPool, tEntry);
+        }
+    }
+}
+
+/*
+ * Puts all entries of a page level, which is just freed, back into the free list
+ */
+static void reclaimEntriesOfLevel(struct TouchPool * aPool, uint8_t aLevel) {
+    for (uint8_t i = 0; i < aPool->NumberOfElements; ++i) {
+        struct TouchPoolEntry * tEntry = getEntry(aPool, i);
+        if (tEntry->IsAllocated && tEntry->PageLevel == aLevel) {
+            pushFreeEntry(aPool, tEntry);
+        }
+    }
+}
+
+/**
+ * @param aFirstEntry the TouchPoolEntry member of the first element
+ */
+void initTouchPool(struct TouchPool * aPool, void * aElements, struct TouchPoolEntry * aFirstEntry, uint16_t aElementSize,
+        uint8_t aNumberOfElements) {
+    memset(aPool, 0, sizeof(struct TouchPool));
+    aPool->Elements = (uint8_t *) aElements;
+    aPool->FirstEntry = (uint8_t *) aFirstEntry;
+    aPool->ElementSize = aElementSize;
+    aPool->NumberOfElements = aNumberOfElements;
+    // push in reverse order, so elements are allocated in array order
+    for (int i = aNumberOfElements - 1; i >= 0; i--) {
+        struct TouchPoolEntry * tEntry = getEntry(aPool, i);
+        tEntry->Pool = aPool;
+        pushFreeEntry(aPool, tEntry);
+    }
+    aPool->IsInitialized = true;
+}
+
+/**
+ * Takes the first element of the free list. Only if the free list is empty, the pool is searched for stale elements.
+ * @return pointer to element or NULL if all elements are allocated
+ */
+void * allocTouchPoolElement(struct TouchPool * aPool) {
+    if (aPool->FreeList == NULL) {
+        reclaimStaleEntries(aPool);
+        if (aPool->FreeList == NULL) {
+            return NULL;
+        }
+    }
+    struct TouchPoolEntry * tEntry = aPool->FreeList;
+    aPool->FreeList = tEntry->NextFree;
+    tEntry->NextFree = NULL;
+    tEntry->IsAllocated = true;
+    tEntry->PageLevel = aPool->PageLevel;
+    tEntry->PageGeneration = aPool->PageGeneration[aPool->PageLevel];
+    aPool->PageNumberOfElements[aPool->PageLevel]++;
+    aPool->NumberOfAllocatedElements++;
+    if (aPool->NumberOfAllocatedElements > aPool->MaxNumberOfAllocatedElements) {
+        aPool->MaxNumberOfAllocatedElements = aPool->NumberOfAllocatedElements;
+    }
+    return (uint8_t *) tEntry - (aPool->FirstEntry - aPool->Elements);
+}
+
+bool isTouchPoolEntryAllocated(const struct TouchPoolEntry * aEntry) {
+    if (aEntry->Pool == NULL) {
+        return true;
+    }
+    return aEntry->IsAllocated && aEntry->PageGeneration == aEntry->Pool->PageGeneration[aEntry->PageLevel];
+}
+
+/**
+ * Does nothing for stale, free or not pool elements
+ */
+void freeTouchPoolEntry(struct TouchPoolEntry * aEntry) {
+    if (!isTouchPoolEntryAllocated(aEntry) || aEntry->Pool == NULL) {
+        return;
+    }
+    struct TouchPool * tPool = aEntry->Pool;
+    tPool->PageNumberOfElements[aEntry->PageLevel]--;
+    tPool->NumberOfAllocatedElements--;
+    pushFreeEntry(tPool, aEntry);
+}
+
+/**
+ * Elements allocated from now on belong to a new page level.
+ * Pages deeper than TOUCH_POOL_MAX_PAGE_LEVEL share the deepest level and their elements are freed together with it.
+ */
+void startTouchPoolPage(struct TouchPool * aPool) {
+    if (aPool->PageLevel < TOUCH_POOL_MAX_PAGE_LEVEL) {
+        aPool->PageLevel++;
+        aPool->PageNumberOfElements[aPool->PageLevel] = 0;
+    } else {
+        aPool->PageLevelOverflow++;
+    }
+}
+
+/**
+ * Frees all elements allocated since the last startTouchPoolPage() in constant time and returns to the previous page level.
+ * Only before the generation of the level wraps around, the pool is searched for the elements of the level,
+ * to avoid that stale elements become valid again.
+ */
+void freeTouchPoolPage(struct TouchPool * aPool) {
+    if (aPool->PageLevelOverflow > 0) {
+        aPool->PageLevelOverflow--;
+        return;
+    }
+    uint8_t tLevel = aPool->PageLevel;
+    if (tLevel == 0) {
+        return;
+    }
+    aPool->NumberOfAllocatedElements -= aPool->PageNumberOfElements[tLevel];
+    aPool->PageNumberOfElements[tLevel] = 0;
+    if (aPool->PageGeneration[tLevel] == 0xFF) {
+        reclaimEntriesOfLevel(aPool, tLevel);
+    }
+    aPool->PageGeneration[tLevel]++;
+    aPool->PageLevel--;
+}
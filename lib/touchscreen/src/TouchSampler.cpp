@@ -0,0 +1,179 @@
+/**
+ * @file TouchSampler.cpp
+ *
+ * Timer driven touch sampling with median and IIR filter. See TouchSampler.h.
+ *
+ * Usage:
+ *  initTouchSampler() once, startTouchSamplerDebounce() at the pen interrupt.
+ *  Then for each period debounceTouchSampler() with the level of the pen interrupt line while state is TOUCH_SAMPLER_DEBOUNCE
+ *  and addTouchSamplerSample() with a new raw sample while state is TOUCH_SAMPLER_SAMPLING.
+ *
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ */
+
+#include "TouchSampler.h"
+
+#include <string.h> // for memset
+
+// Only for the compiler. The writer is an interrupt on the same core, so no memory barrier instruction is required.
+#define TOUCH_SNAPSHOT_BARRIER() __asm volatile ("" ::: "memory")
+
+/*
+ * @param aNumberOfValues must be odd
+ */
+static uint16_t getMedian(const uint16_t * aWindow, uint8_t aNumberOfValues) {
+    uint16_t tSorted[TOUCH_SAMPLER_MEDIAN_SIZE];
+    // insertion sort is fastest for this small size
+    for (uint8_t i = 0; i < aNumberOfValues; ++i) {
+        uint16_t tValue = aWindow[i];
+        uint8_t j = i;
+        while (j > 0 && tSorted[j - 1] > tValue) {
+            tSorted[j] = tSorted[j - 1];
+            j--;
+        }
+        tSorted[j] = tValue;
+    }
+    return tSorted[aNumberOfValues / 2];
+}
+
+/*
+ * Strong low pass for a resting finger, weak low pass if finger is moving to reduce lag
+ */
+static bool isOutlier(uint16_t aValue, uint16_t aMedian) {
+    return aValue > aMedian + TOUCH_SAMPLER_OUTLIER_DISTANCE || aValue + TOUCH_SAMPLER_OUTLIER_DISTANCE < aMedian;
+}
+
+static void filter(int32_t * aFilteredValuePtr, uint16_t aMedian) {
+    int32_t tDifference = ((int32_t) aMedian << TOUCH_SAMPLER_FRACTION_SHIFT) - *aFilteredValuePtr;
+    if (tDifference > (TOUCH_SAMPLER_IIR_MOVE_DISTANCE << TOUCH_SAMPLER_FRACTION_SHIFT)
+            || tDifference < -(TOUCH_SAMPLER_IIR_MOVE_DISTANCE << TOUCH_SAMPLER_FRACTION_SHIFT)) {
+        *aFilteredValuePtr += tDifference >> TOUCH_SAMPLER_IIR_MOVE_SHIFT;
+    } else {
+        *aFilteredValuePtr += tDifference >> TOUCH_SAMPLER_IIR_SHIFT;
+    }
+}
+
+void initTouchSampler(struct TouchSampler * aSampler) {
+    memset(aSampler, 0, sizeof(struct TouchSampler));
+}
+
+/**
+ * Called at the falling edge of the pen interrupt line
+ */
+void startTouchSamplerDebounce(struct TouchSampler * aSampler) {
+    aSampler->State = TOUCH_SAMPLER_DEBOUNCE;
+    aSampler->DebounceTicks = 0;
+}
+
+/**
+ * @param aLineIsActive true if pen interrupt line is still low
+ * @return TOUCH_SAMPLER_IDLE if line bounced, TOUCH_SAMPLER_SAMPLING if line was stable for TOUCH_SAMPLER_DEBOUNCE_TICKS
+ */
+uint8_t debounceTouchSampler(struct TouchSampler * aSampler, bool aLineIsActive) {
+    if (!aLineIsActive) {
+        aSampler->State = TOUCH_SAMPLER_IDLE;
+    } else {
+        aSampler->DebounceTicks++;
+        if (aSampler->DebounceTicks >= TOUCH_SAMPLER_DEBOUNCE_TICKS) {
+            aSampler->State = TOUCH_SAMPLER_SAMPLING;
+            aSampler->NumberOfWindowSamples = 0;
+            aSampler->WindowIndex = 0;
+            aSampler->NumberOfInvalidSamples = 0;
+            aSampler->IsDown = false;
+        }
+    }
+    return aSampler->State;
+}
+
+/**
+ * Adds one raw sample. Invalid samples, e.g. with too low pressure, and up to TOUCH_SAMPLER_MAX_OUTLIERS consecutive outliers
+ * are not added.
+ * @return TOUCH_SAMPLER_DOWN for the first median, TOUCH_SAMPLER_NEW_POSITION for each following median,
+ *         TOUCH_SAMPLER_UP after TOUCH_SAMPLER_RELEASE_SAMPLES invalid samples, which also sets state to TOUCH_SAMPLER_IDLE
+ */
+uint8_t addTouchSamplerSample(struct TouchSampler * aSampler, uint16_t aRawX, uint16_t aRawY, bool aIsValid) {
+    aSampler->NumberOfSamples++;
+    if (!aIsValid) {
+        aSampler->NumberOfRejectedSamples++;
+        aSampler->NumberOfInvalidSamples++;
+        if (aSampler->NumberOfInvalidSamples >= TOUCH_SAMPLER_RELEASE_SAMPLES) {
+            aSampler->State = TOUCH_SAMPLER_IDLE;
+            if (aSampler->IsDown) {
+                aSampler->IsDown = false;
+                return TOUCH_SAMPLER_UP;
+            }
+        }
+        return TOUCH_SAMPLER_NO_EVENT;
+    }
+    aSampler->NumberOfInvalidSamples = 0;
+    if (aSampler->IsDown && aSampler->NumberOfOutliers < TOUCH_SAMPLER_MAX_OUTLIERS
+            && (isOutlier(aRawX, aSampler->MedianX) || isOutlier(aRawY, aSampler->MedianY))) {
+        aSampler->NumberOfRejectedSamples++;
+        aSampler->NumberOfOutliers++;
+        return TOUCH_SAMPLER_NO_EVENT;
+    }
+    aSampler->NumberOfOutliers = 0;
+
+    aSampler->WindowX[aSampler->WindowIndex] = aRawX;
+    aSampler->WindowY[aSampler->WindowIndex] = aRawY;
+    aSampler->WindowIndex++;
+    if (aSampler->WindowIndex >= TOUCH_SAMPLER_MEDIAN_SIZE) {
+        aSampler->WindowIndex = 0;
+    }
+    if (aSampler->NumberOfWindowSamples < TOUCH_SAMPLER_MEDIAN_SIZE) {
+        aSampler->NumberOfWindowSamples++;
+    }
+    // until window is filled, use median of first samples in window
+    uint8_t tNumberOfValues = aSampler->NumberOfWindowSamples;
+    if ((tNumberOfValues & 0x01) == 0 || tNumberOfValues < TOUCH_SAMPLER_DOWN_SAMPLES) {
+        return TOUCH_SAMPLER_NO_EVENT;
+    }
+
+    aSampler->MedianX = getMedian(aSampler->WindowX, tNumberOfValues);
+    aSampler->MedianY = getMedian(aSampler->WindowY, tNumberOfValues);
+    if (!aSampler->IsDown) {
+        // start filter with first median
+        aSampler->FilteredX = (int32_t) aSampler->MedianX << TOUCH_SAMPLER_FRACTION_SHIFT;
+        aSampler->FilteredY = (int32_t) aSampler->MedianY << TOUCH_SAMPLER_FRACTION_SHIFT;
+        aSampler->IsDown = true;
+        return TOUCH_SAMPLER_DOWN;
+    }
+    filter(&aSampler->FilteredX, aSampler->MedianX);
+    filter(&aSampler->FilteredY, aSampler->MedianY);
+    return TOUCH_SAMPLER_NEW_POSITION;
+}
+
+/**
+ * @return filtered value rounded to raw resolution
+ */
+uint16_t getTouchSamplerX(const struct TouchSampler * aSampler) {
+    return (aSampler->FilteredX + (1 << (TOUCH_SAMPLER_FRACTION_SHIFT - 1))) >> TOUCH_SAMPLER_FRACTION_SHIFT;
+}
+
+uint16_t getTouchSamplerY(const struct TouchSampler * aSampler) {
+    return (aSampler->FilteredY + (1 << (TOUCH_SAMPLER_FRACTION_SHIFT - 1))) >> TOUCH_SAMPLER_FRACTION_SHIFT;
+}
+
+/**
+ * Must only be called by one writer, which is not interrupted by a reader
+ */
+void writeTouchSnapshot(struct TouchSnapshot * aSnapshot, const struct TouchSnapshotData * aData) {
+    aSnapshot->Sequence++;
+    TOUCH_SNAPSHOT_BARRIER();
+    aSnapshot->Data = *aData;
+    TOUCH_SNAPSHOT_BARRIER();
+    aSnapshot->Sequence++;
+}
+
+/**
+ * Copies the data again if it was written while copying
+ */
+void readTouchSnapshot(const struct TouchSnapshot * aSnapshot, struct TouchSnapshotData * aData) {
+    uint32_t tSequence;
+    do {
+        tSequence = aSnapshot->Sequence;
+        TOUCH_SNAPSHOT_BARRIER();
+        *aData = aSnapshot->Data;
+        TOUCH_SNAPSHOT_BARRIER();
+    } while ((tSequence & 0x01) != 0 || tSequence != aSnapshot->Sequence);
+}
@@ -24,6 +24,7 @@
  */
 
 #include "TouchSlider.h"
+#include "TouchGrid.h"
 
 #include "BlueDisplay.h"
 
@@ -60,12 +61,37 @@ uint16_t TouchSlider::sDefaultValueCaptionBackgroundColor = SLIDER_DEFAULT_CAPTI
 
 uint8_t TouchSlider::sDefaultTouchBorder = SLIDER_DEFAULT_TOUCH_BORDER;
 
+#ifdef USE_SLIDER_POOL
+/**
+ * The preallocated pool of sliders for BDSlider
+ */
+TouchSlider TouchSlider::TouchSliderPool[NUMBER_OF_SLIDERS_IN_POOL];
+struct TouchPool TouchSlider::sSliderPool;
+#endif
+
+#ifndef DO_NOT_USE_TOUCH_GRID
+/*
+ * Grid of active sliders for checkAllSliders()
+ */
+static void * sSliderGridEntries[SLIDER_GRID_MAX_ENTRIES];
+static struct TouchGrid sSliderGrid = { { 0 }, sSliderGridEntries, SLIDER_GRID_MAX_ENTRIES, false, false };
+#endif
+
+/*
+ * Grid is built again on next touch
+ */
+static void invalidateSliderGrid(void) {
+#ifndef DO_NOT_USE_TOUCH_GRID
+    invalidateTouchGrid(&sSliderGrid);
+#endif
+}
+
 #ifdef REMOTE_DISPLAY_SUPPORTED
 TouchSlider * TouchSlider::getLocalSliderFromBDSliderHandle(BDSliderHandle_t aSliderHandleToSearchFor) {
     TouchSlider * tSliderPointer = sSliderListStart;
 // walk through list
     while (tSliderPointer != NULL) {
-        if (tSliderPointer->mBDSliderPtr->mSliderHandle == aSliderHandleToSearchFor) {
+        if (tSliderPointer->isAllocated() && tSliderPointer->mBDSliderPtr->mSliderHandle == aSliderHandleToSearchFor) {
             break;
         }
         tSliderPointer = tSliderPointer->mNextObject;
@@ -82,12 +108,16 @@ void TouchSlider::reinitAllLocalSlidersForRemote(void) {
         sLocalSliderIndex = 0;
 // walk through list
         while (tSliderPointer != NULL) {
+            if (!tSliderPointer->isAllocated()) {
+                tSliderPointer = tSliderPointer->mNextObject;
+                continue;
+            }
             // cannot use BDSlider.init since this allocates a new TouchSlider
             sendUSARTArgs(FUNCTION_SLIDER_CREATE, 12, tSliderPointer->mBDSliderPtr->mSliderHandle, tSliderPointer->mPositionX,
                     tSliderPointer->mPositionY, tSliderPointer->mBarWidth, tSliderPointer->mBarLength,
                     tSliderPointer->mThresholdValue, tSliderPointer->mActualValue, tSliderPointer->mSliderColor,
                     tSliderPointer->mBarColor, tSliderPointer->mFlags, tSliderPointer->mOnChangeHandler,
-                    (reinterpret_cast<uint32_t>(tSliderPointer->mOnChangeHandler) >> 16));
+                    (reinterpret_cast<uintptr_t>(tSliderPointer->mOnChangeHandler) >> 16));
             sLocalSliderIndex++;
             tSliderPointer = tSliderPointer->mNextObject;
         }
@@ -98,6 +128,7 @@ void TouchSlider::reinitAllLocalSlidersForRemote(void) {
  * Destructor  - remove from slider list
  */
 TouchSlider::~TouchSlider(void) {
+    invalidateSliderGrid();
     TouchSlider * tSliderPointer = sSliderListStart;
     if (tSliderPointer == this) {
         // remove first element of list
@@ -121,6 +152,7 @@ void TouchSlider::initSlider(uint16_t aPositionX, uint16_t aPositionY, uint8_t a
         uint16_t aThresholdValue, int16_t aInitalValue, uint16_t aSliderColor, uint16_t aBarColor, uint8_t aOptions,
         void (*aOnChangeHandler)(TouchSlider *, uint16_t)) {
 
+    invalidateSliderGrid();
     mCaption = NULL;
     /*
      * Copy parameter
@@ -189,6 +221,10 @@ void TouchSlider::initSlider(uint16_t aPositionX, uint16_t aPositionY, uint8_t a
  * Constructor - insert in list
  */
 TouchSlider::TouchSlider(void) {
+    invalidateSliderGrid();
+#ifdef USE_SLIDER_POOL
+    mPoolEntry.Pool = NULL; // initTouchPool() sets it for pool sliders
+#endif
     mNextObject = NULL;
     if (sSliderListStart == NULL) {
         // first slider
@@ -299,6 +335,7 @@ void TouchSlider::initSlider(uint16_t aPositionX, uint16_t aPositionY, uintForPg
         uint16_t aThresholdValue, uint16_t aInitalValue, const char * aCaption, int8_t aTouchBorder, uint8_t aOptions,
         void (*aOnChangeHandler)(TouchSlider *, uint16_t), const char * (*aValueHandler)(uint16_t)) {
 
+    invalidateSliderGrid();
     mSliderColor = sDefaultSliderColor;
     mBarColor = sDefaultBarColor;
     /*
@@ -366,7 +403,7 @@ void TouchSlider::initSlider(uint16_t aPositionX, uint16_t aPositionY, uintForPg
 }
 
 void TouchSlider::drawSlider(void) {
-    mIsActive = true;
+    activate();
 
     if ((mFlags & TOUCHFLAG_SLIDER_SHOW_BORDER)) {
         drawBorder();
@@ -577,7 +614,7 @@ bool TouchSlider::checkSlider(uint16_t aTouchPositionX, uint16_t aTouchPositionY
         tPositionBorderY = 0;
     }
     if (!mIsActive || aTouchPositionX < tPositionBorderX || aTouchPositionX > mPositionXRight + mTouchBorder
-            || aTouchPositionY < tPositionBorderY || aTouchPositionY > mPositionYBottom + mTouchBorder) {
+            || aTouchPositionY < tPositionBorderY || aTouchPositionY > mPositionYBottom + mTouchBorder || !isAllocated()) {
         return false;
     }
     uintForPgmSpaceSaving tShortBorderWidth = 0;
@@ -638,11 +675,66 @@ bool TouchSlider::checkSlider(uint16_t aTouchPositionX, uint16_t aTouchPositionY
     return true;
 }
 
+/**
+ * Adds all active sliders including their touch border to the grid in list order
+ */
+void TouchSlider::buildSliderGrid(void) {
+#ifndef DO_NOT_USE_TOUCH_GRID
+    startTouchGridCount(&sSliderGrid);
+    TouchSlider * tObjectPointer = sSliderListStart;
+    while (tObjectPointer != NULL) {
+        if (tObjectPointer->mIsActive && tObjectPointer->isAllocated()) {
+            // area of checkSlider()
+            countTouchGridArea(&sSliderGrid,
+                    (tObjectPointer->mTouchBorder > tObjectPointer->mPositionX) ?
+                            0 : tObjectPointer->mPositionX - tObjectPointer->mTouchBorder,
+                    (tObjectPointer->mTouchBorder > tObjectPointer->mPositionY) ?
+                            0 : tObjectPointer->mPositionY - tObjectPointer->mTouchBorder,
+                    tObjectPointer->mPositionXRight + tObjectPointer->mTouchBorder,
+                    tObjectPointer->mPositionYBottom + tObjectPointer->mTouchBorder);
+        }
+        tObjectPointer = tObjectPointer->mNextObject;
+    }
+    startTouchGridFill(&sSliderGrid);
+    tObjectPointer = sSliderListStart;
+    while (tObjectPointer != NULL) {
+        if (tObjectPointer->mIsActive && tObjectPointer->isAllocated()) {
+            addToTouchGrid(&sSliderGrid, tObjectPointer,
+                    (tObjectPointer->mTouchBorder > tObjectPointer->mPositionX) ?
+                            0 : tObjectPointer->mPositionX - tObjectPointer->mTouchBorder,
+                    (tObjectPointer->mTouchBorder > tObjectPointer->mPositionY) ?
+                            0 : tObjectPointer->mPositionY - tObjectPointer->mTouchBorder,
+                    tObjectPointer->mPositionXRight + tObjectPointer->mTouchBorder,
+                    tObjectPointer->mPositionYBottom + tObjectPointer->mTouchBorder);
+        }
+        tObjectPointer = tObjectPointer->mNextObject;
+    }
+    endTouchGridFill(&sSliderGrid);
+#endif
+}
+
 /**
  * Static convenience method - checks all sliders in for event position.
+ * Only the sliders of the touched grid cell are checked.
  */
 
 bool TouchSlider::checkAllSliders(unsigned int aTouchPositionX, unsigned int aTouchPositionY) {
+#ifndef DO_NOT_USE_TOUCH_GRID
+    if (!sSliderGrid.IsValid) {
+        buildSliderGrid();
+    }
+    uint16_t tNumberOfCandidates;
+    void * const * tCandidates = getTouchGridCandidates(&sSliderGrid, aTouchPositionX, aTouchPositionY, &tNumberOfCandidates);
+    if (tCandidates != NULL) {
+        for (uint16_t i = 0; i < tNumberOfCandidates; ++i) {
+            TouchSlider * tObjectPointer = (TouchSlider *) tCandidates[i];
+            if (tObjectPointer->mIsActive && tObjectPointer->checkSlider(aTouchPositionX, aTouchPositionY)) {
+                return true;
+            }
+        }
+        return false;
+    }
+#endif
     TouchSlider * tObjectPointer = sSliderListStart;
 
 // walk through list of active elements
@@ -691,12 +783,87 @@ uint16_t TouchSlider::getPositionYBottom(void) const {
 }
 
 void TouchSlider::activate(void) {
-    mIsActive = true;
+    if (!mIsActive) {
+        mIsActive = true;
+        invalidateSliderGrid();
+    }
 }
 void TouchSlider::deactivate(void) {
-    mIsActive = false;
+    if (mIsActive) {
+        mIsActive = false;
+        invalidateSliderGrid();
+    }
+}
+
+/**
+ * @return false if slider is a free pool slider, which is also the case after freeAllSlidersOfPage()
+ */
+bool TouchSlider::isAllocated(void) const {
+#ifdef USE_SLIDER_POOL
+    return isTouchPoolEntryAllocated(&mPoolEntry);
+#else
+    return true;
+#endif
+}
+
+#ifdef USE_SLIDER_POOL
+/****************************
+ * Pool functions
+ ****************************/
+/**
+ * Initializes the pool at first use.
+ * All pool sliders are already in the slider list by their constructor and stay there.
+ */
+void TouchSlider::initSliderPool(void) {
+    if (!sSliderPool.IsInitialized) {
+        initTouchPool(&sSliderPool, TouchSliderPool, &TouchSliderPool[0].mPoolEntry, sizeof(TouchSlider),
+        NUMBER_OF_SLIDERS_IN_POOL);
+    }
+}
+
+/**
+ * Allocate / get first slider from the free list of unallocated sliders
+ * @retval Slider pointer or message and pointer to first pool slider if no slider available
+ */
+TouchSlider * TouchSlider::allocSlider(void) {
+    initSliderPool();
+    TouchSlider * tSliderPointer = (TouchSlider *) allocTouchPoolElement(&sSliderPool);
+    if (tSliderPointer == NULL) {
+        failParamMessage(sSliderPool.NumberOfAllocatedElements, "No slider available");
+        // to avoid NULL pointer
+        tSliderPointer = &TouchSliderPool[0];
+    } else {
+        // a slider freed by freeAllSlidersOfPage() may still be active. Do not touch the live fallback slider.
+        tSliderPointer->mIsActive = false;
+    }
+    return tSliderPointer;
 }
 
+/**
+ * Deallocates / free a slider and put it back to slider pool
+ */
+void TouchSlider::setFree(void) {
+    deactivate();
+    freeTouchPoolEntry(&mPoolEntry);
+}
+
+/**
+ * Sliders allocated from now on belong to a new page, which can be freed at once by freeAllSlidersOfPage()
+ */
+void TouchSlider::startSliderPage(void) {
+    initSliderPool();
+    startTouchPoolPage(&sSliderPool);
+}
+
+/**
+ * Frees all sliders allocated since the last startSliderPage() in constant time
+ */
+void TouchSlider::freeAllSlidersOfPage(void) {
+    freeTouchPoolPage(&sSliderPool);
+    invalidateSliderGrid();
+}
+#endif
+
 int8_t TouchSlider::checkParameterValues(void) {
     /**
      * Check and copy parameter
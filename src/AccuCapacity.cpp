@@ -11,6 +11,7 @@
 
 #include "Pages.h"
 #include "Chart.h"
+#include "CooperativeTask.h"
 #include <string.h>
 
 /*
@@ -600,6 +601,7 @@ void initAccuCapacity(void) {
 }
 
 void startAccuCapacity(void) {
+    BDButton::startButtonPage();
     initGUIAccuCapacity();
     // New calibration of chart since VCC may have changed
     ADC_setRawToVoltFactor();
@@ -623,22 +625,7 @@ void stopAccuCapacity(void) {
     // Stop display refresh
     changeDelayCallback(&callbackDisplayRefreshDelay, DISABLE_TIMER_DELAY_VALUE);
 // free buttons
-    for (unsigned int i = 0; i < sizeof(ButtonsChart) / sizeof(ButtonsChart[0]); ++i) {
-        ButtonsChart[i]->deinit();
-    }
-    for (unsigned int i = 0; i < sizeof(TouchButtonsMain) / sizeof(TouchButtonsMain[0]); ++i) {
-        TouchButtonsMain[i].deinit();
-    }
-
-    TouchButtonSetProbeNumber.deinit();
-    TouchButtonSetLoadResistor.deinit();
-    TouchButtonSetStopValue.deinit();
-    TouchButtonSetChargeVoltage.deinit();
-    TouchButtonSetExternalAttenuatorFactor.deinit();
-    TouchButtonBack.deinit();
-
-    TouchButtonAutorepeatSamplePeriodPlus.deinit();
-    TouchButtonAutorepeatSamplePeriodMinus.deinit();
+    BDButton::deinitAllButtonsOfPage();
 
     registerLongTouchDownCallback(NULL, 0);
     registerSwipeEndCallback(NULL);
@@ -660,7 +647,8 @@ void loopAccuCapacity(void) {
         doEndTone = false;
         EndTone();
     }
-    checkAndHandleEvents();
+    // flags are set by delay callbacks
+    checkAndHandleEventsAndIdle(ONE_SECOND);
 }
 
 /************************************************************************
@@ -1044,69 +1032,89 @@ static void doStoreLoadChart(BDButton * aTheTouchedButton, int16_t aProbeIndex)
 #endif
 }
 
+static void playExportFeedbackTone(unsigned int aFeedbackType) {
+#ifdef LOCAL_DISPLAY_EXISTS
+    FeedbackTone(aFeedbackType);
+#else
+    BlueDisplay1.playFeedbackTone(aFeedbackType);
+#endif
+}
+
+static struct CooperativeTask sExportTask;
+// state of export task, since local variables are not preserved across TASK_YIELD()
+static FIL sExportFile;
+static int16_t sExportProbeIndex;
+static int sExportSampleIndex;
+static char sExportBuffer[SIZEOF_STRINGBUFFER]; // StringBuffer may be used by event handlers between two chunks
+#define EXPORT_LINE_MAX_SIZE 24
+
+/*
+ * Writes header at first call and then one buffer of samples for each call
+ */
+static bool exportChartTask(struct CooperativeTask * aTask) {
+    UINT tCount;
+    unsigned int tIndex;
+    FRESULT tOpenResult;
+    DataloggerMeasurementControlStruct * tControl = &DataloggerMeasurementControl[sExportProbeIndex];
+    TASK_BEGIN(aTask);
+    if (!MICROSD_isCardInserted() || tControl->SampleCount == 0) {
+        playExportFeedbackTone(FEEDBACK_TONE_LONG_ERROR);
+        TASK_EXIT(aTask);
+    }
+    tIndex = RTC_getDateStringForFile(StringBuffer);
+    snprintf(&StringBuffer[tIndex], sizeof StringBuffer - tIndex, " probe%d_%s.csv", tControl->ProbeNumber,
+            getModeString(sExportProbeIndex));
+    tOpenResult = f_open(&sExportFile, StringBuffer, FA_CREATE_ALWAYS | FA_WRITE);
+    if (tOpenResult != FR_OK) {
+        failParamMessage(tOpenResult, "f_open");
+        TASK_EXIT(aTask);
+    }
+    {
+        unsigned int tSeconds = DataloggerMeasurementControl[ActualProbe].SamplePeriodSeconds;
+        unsigned int tMinutes = tSeconds / 60;
+        tSeconds %= 60;
+        tIndex = snprintf(StringBuffer, sizeof StringBuffer, "Probe Nr:%d\nSample interval:%u:%02u min\nDate:",
+                tControl->ProbeNumber, tMinutes, tSeconds);
+    }
+    tIndex += RTC_getTimeString(&StringBuffer[tIndex]);
+    snprintf(&StringBuffer[tIndex], (sizeof StringBuffer) - tIndex,
+            "\nCapacity:%4fmAH\nInternal resistance:%5.2f Ohm\nVolt Max;Volt Min;mOhm\n",
+            tControl->Capacity / 1000, tControl->OhmAccuResistance);
+    f_write(&sExportFile, StringBuffer, strlen(StringBuffer), &tCount);
+
+    /**
+     * data
+     */
+    for (sExportSampleIndex = 0; sExportSampleIndex < tControl->SampleCount;) {
+        TASK_YIELD(aTask);
+        // accumulate strings in buffer and write if buffer has no room for another line
+        tIndex = 0;
+        while (sExportSampleIndex < tControl->SampleCount && tIndex < (sizeof sExportBuffer - EXPORT_LINE_MAX_SIZE)) {
+            tIndex += snprintf(&sExportBuffer[tIndex], (sizeof sExportBuffer) - tIndex, "%6.3f;%6.3f;%4d\n",
+                    sADCToVoltFactor * tControl->VoltageDatabuffer[sExportSampleIndex],
+                    sADCToVoltFactor * tControl->MinVoltageDatabuffer[sExportSampleIndex],
+                    tControl->InternalResistanceDataMilliOhm[sExportSampleIndex]);
+            sExportSampleIndex++;
+        }
+        f_write(&sExportFile, sExportBuffer, tIndex, &tCount);
+    }
+    f_close(&sExportFile);
+    playExportFeedbackTone(FEEDBACK_TONE_NO_ERROR);
+    TASK_END(aTask);
+}
+
 /**
- * Export Data Buffer to CSV file
+ * Export Data Buffer to CSV file. The file is written by a cooperative task, so the GUI stays responsive.
  * @param aTheTouchedButton
  * @param aProbeIndex
  */
 static void doExportChart(BDButton * aTheTouchedButton, int16_t aProbeIndex) {
-    unsigned int tFeedbackType = FEEDBACK_TONE_LONG_ERROR;
-    if (MICROSD_isCardInserted()) {
-        FIL tFile;
-        FRESULT tOpenResult;
-        UINT tCount;
-        unsigned int tIndex = RTC_getDateStringForFile(StringBuffer);
-        snprintf(&StringBuffer[tIndex], sizeof StringBuffer - tIndex, " probe%d_%s.csv",
-                DataloggerMeasurementControl[aProbeIndex].ProbeNumber, getModeString(aProbeIndex));
-        if (DataloggerMeasurementControl[aProbeIndex].SampleCount != 0) {
-            tOpenResult = f_open(&tFile, StringBuffer, FA_CREATE_ALWAYS | FA_WRITE);
-            if (tOpenResult != FR_OK) {
-                failParamMessage(tOpenResult, "f_open");
-            } else {
-                unsigned int tSeconds = DataloggerMeasurementControl[ActualProbe].SamplePeriodSeconds;
-                unsigned int tMinutes = tSeconds / 60;
-                tSeconds %= 60;
-                tIndex = snprintf(StringBuffer, sizeof StringBuffer,
-                        "Probe Nr:%d\nSample interval:%u:%02u min\nDate:",
-                        DataloggerMeasurementControl[aProbeIndex].ProbeNumber, tMinutes, tSeconds);
-                tIndex += RTC_getTimeString(&StringBuffer[tIndex]);
-                snprintf(&StringBuffer[tIndex], (sizeof StringBuffer) - tIndex,
-                        "\nCapacity:%4fmAH\nInternal resistance:%5.2f Ohm\nVolt Max;Volt Min;mOhm\n",
-                        DataloggerMeasurementControl[aProbeIndex].Capacity / 1000,
-                        DataloggerMeasurementControl[aProbeIndex].OhmAccuResistance);
-                f_write(&tFile, StringBuffer, strlen(StringBuffer), &tCount);
-
-                /**
-                 * data
-                 */
-                tIndex = 0;
-                uint16_t * tMaxVoltDataPtr = &DataloggerMeasurementControl[aProbeIndex].VoltageDatabuffer[0];
-                uint16_t * tMinVoltDataPtr = &DataloggerMeasurementControl[aProbeIndex].MinVoltageDatabuffer[0];
-                uint16_t * tOhmDataPtr = &DataloggerMeasurementControl[aProbeIndex].InternalResistanceDataMilliOhm[0];
-                for (int i = 0; i < DataloggerMeasurementControl[aProbeIndex].SampleCount; ++i) {
-                    tIndex += snprintf(&StringBuffer[tIndex], (sizeof StringBuffer) - tIndex, "%6.3f;%6.3f;%4d\n",
-                            sADCToVoltFactor * (*tMaxVoltDataPtr++), sADCToVoltFactor * (*tMinVoltDataPtr++),
-                            (*tOhmDataPtr++));
-                    // accumulate strings in buffer and write if buffer almost full
-                    if (tIndex > (sizeof StringBuffer - 15)) {
-                        tIndex = 0;
-                        f_write(&tFile, StringBuffer, strlen(StringBuffer), &tCount);
-                    }
-                }
-                // write last chunk
-                if (tIndex > 0) {
-                    f_write(&tFile, StringBuffer, strlen(StringBuffer), &tCount);
-                }
-                f_close(&tFile);
-                tFeedbackType = FEEDBACK_TONE_NO_ERROR;
-            }
-        }
+    if (isCooperativeTaskRunning(&sExportTask)) {
+        playExportFeedbackTone(FEEDBACK_TONE_SHORT_ERROR);
+        return;
     }
-#ifdef LOCAL_DISPLAY_EXISTS
-    FeedbackTone(tFeedbackType);
-#else
-    BlueDisplay1.playFeedbackTone(tFeedbackType);
-#endif
+    sExportProbeIndex = aProbeIndex;
+    startCooperativeTask(&sExportTask, &exportChartTask);
 }
 
 /***********************************************************************
@@ -39,7 +39,7 @@ unsigned int sHomeMidX = HOME_MID_X;
 unsigned int sHomeMidY = HOME_MID_Y;
 
 void initBobsDemo(void) {
-
+    BDButton::startButtonPage();
     TouchButtonNextLevel.init(BUTTON_WIDTH_3_POS_2, BUTTON_HEIGHT_4_LINE_4, BUTTON_WIDTH_3,
     BUTTON_HEIGHT_4, COLOR_CYAN, "Next", TEXT_SIZE_22, BUTTON_FLAG_DO_BEEP_ON_TOUCH, 0, &doNextLevel);
 }
@@ -65,7 +65,7 @@ void startBobsDemo(void) {
 }
 
 void stopBobsDemo(void) {
-    TouchButtonNextLevel.deinit();
+    BDButton::deinitAllButtonsOfPage();
 }
 
 #pragma GCC diagnostic push
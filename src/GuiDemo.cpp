@@ -130,6 +130,7 @@ BDButton * TouchButtonsGuiDemo[] = { &TouchButtonDemoSettings, &TouchButtonChart
         };
 
 void startGuiDemo(void) {
+    BDButton::startButtonPage();
 #ifdef LOCAL_DISPLAY_EXISTS
     initBacklightElements();
 #endif
@@ -215,9 +216,7 @@ void stopGuiDemo(void) {
     delete[] frame;
 
     // free buttons
-    for (unsigned int i = 0; i < sizeof(TouchButtonsGuiDemo) / sizeof(TouchButtonsGuiDemo[0]); ++i) {
-        TouchButtonsGuiDemo[i]->deinit();
-    }
+    BDButton::deinitAllButtonsOfPage();
     TouchSliderGolSpeed.deinit();
     TouchSliderActionWithoutBorder.deinit();
     TouchSliderAction.deinit();
@@ -490,7 +489,9 @@ void doADS7846Channels(BDButton * aTheTouchedButton, int16_t aValue) {
 
 #define BUTTON_CHECK_INTERVAL 20
 void ADS7846DisplayChannels(void) {
+#ifdef DO_NOT_USE_BACKGROUND_TOUCH_SAMPLING
     static uint8_t aButtonCheckInterval = 0;
+#endif
     uint16_t tPosY = 30;
     int16_t tTemp;
     bool tUseDiffMode = true;
@@ -508,6 +509,7 @@ void ADS7846DisplayChannels(void) {
         BlueDisplay1.drawText(15, tPosY, StringBuffer, TEXT_SIZE_22, COLOR_RED, COLOR_DEMO_BACKGROUND);
         tPosY += TEXT_SIZE_22_HEIGHT;
     }
+#ifdef DO_NOT_USE_BACKGROUND_TOUCH_SAMPLING
     aButtonCheckInterval++;
     if (aButtonCheckInterval >= BUTTON_CHECK_INTERVAL) {
         TouchPanel.rd_data();
@@ -517,6 +519,7 @@ void ADS7846DisplayChannels(void) {
         }
 
     }
+#endif
 }
 #endif
 
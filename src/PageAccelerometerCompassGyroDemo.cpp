@@ -11,7 +11,7 @@
  */
 
 #include "Pages.h"
-#include "thickline.h"
+#include "thickLine.h"
 #include "stm32f3DiscoveryLedsButtons.h"
 #include "l3gdc20_lsm303dlhc_utils.h"
 #include "stm32f3DiscoPeripherals.h"
@@ -137,6 +137,7 @@ void doClearAccelerometerCompassScreen(BDButton * aTheTouchedButton, int16_t aVa
 }
 
 void startAccelerometerCompassPage(void) {
+    BDButton::startButtonPage();
 
     // TODO implement switching from CDC to HID
     //USB_ChangeToJoystick();
@@ -201,6 +202,9 @@ void loopAccelerometerGyroCompassPage(void) {
     MillisLastLoop = tMillis;
     if (MillisSinceLastAction > 50) {
         MillisSinceLastAction = 0;
+        // all vectors are refreshed together at the end
+        struct ThickLine * const tLines[3] = { &AccelerationLine, &CompassLine, &GyroYawLine };
+        int16_t tNewRelEnds[3][2];
         /**
          * Accelerometer data
          */
@@ -209,9 +213,8 @@ void loopAccelerometerGyroCompassPage(void) {
         snprintf(StringBuffer, sizeof StringBuffer, "Accelerometer X=%5d Y=%5d Z=%5d", AccelerometerCompassRawDataBuffer[0],
                 AccelerometerCompassRawDataBuffer[1], AccelerometerCompassRawDataBuffer[2]);
         BlueDisplay1.drawText(TEXT_START_X, TEXT_START_Y, StringBuffer, TEXT_SIZE_11, COLOR_BLACK, COLOR_GREEN);
-        BlueDisplay1.refreshVector(&AccelerationLine, (AccelerometerCompassRawDataBuffer[0] / sAccelerationScale),
-                (AccelerometerCompassRawDataBuffer[1] / sAccelerationScale));
-        BlueDisplay1.drawPixel(AccelerationLine.StartX, AccelerationLine.StartY, COLOR_BLACK);
+        tNewRelEnds[0][0] = AccelerometerCompassRawDataBuffer[0] / sAccelerationScale;
+        tNewRelEnds[0][1] = AccelerometerCompassRawDataBuffer[1] / sAccelerationScale;
 
         /**
          * Send over USB
@@ -227,9 +230,8 @@ void loopAccelerometerGyroCompassPage(void) {
         COLOR_BLACK,
         COLOR_GREEN);
         // values can reach 800
-        BlueDisplay1.refreshVector(&CompassLine, (AccelerometerCompassRawDataBuffer[0] >> 5),
-                -(AccelerometerCompassRawDataBuffer[2] >> 5));
-        BlueDisplay1.drawPixel(CompassLine.StartX, CompassLine.StartY, COLOR_RED);
+        tNewRelEnds[1][0] = AccelerometerCompassRawDataBuffer[0] >> 5;
+        tNewRelEnds[1][1] = -(AccelerometerCompassRawDataBuffer[2] >> 5);
 
         /**
          * Gyroscope data
@@ -246,8 +248,12 @@ void loopAccelerometerGyroCompassPage(void) {
         TouchSliderPitch.setActualValueAndDrawBar(
                 ((int16_t) (GyroscopeRawDataBuffer[1] / (sAccelerationScale / 4))) + VERTICAL_SLIDER_NULL_VALUE);
 
-        BlueDisplay1.refreshVector(&GyroYawLine, -(int16_t) (GyroscopeRawDataBuffer[2] / (2 * sAccelerationScale)),
-                -(2 * COMPASS_RADIUS));
+        tNewRelEnds[2][0] = -(int16_t) (GyroscopeRawDataBuffer[2] / (2 * sAccelerationScale));
+        tNewRelEnds[2][1] = -(2 * COMPASS_RADIUS);
+
+        BlueDisplay1.refreshVectors(tLines, tNewRelEnds, 3);
+        BlueDisplay1.drawPixel(AccelerationLine.StartX, AccelerationLine.StartY, COLOR_BLACK);
+        BlueDisplay1.drawPixel(CompassLine.StartX, CompassLine.StartY, COLOR_RED);
         BlueDisplay1.drawPixel(GyroYawLine.StartX, GyroYawLine.StartY, COLOR_RED);
     }
     checkAndHandleEvents();
@@ -259,10 +265,7 @@ void stopAccelerometerCompassPage(void) {
 
     USBD_Stop(&USBDDeviceHandle);
 
-    TouchButtonSetZero.deinit();
-    TouchButtonClearScreen.deinit();
-    TouchButtonAutorepeatAccScalePlus.deinit();
-    TouchButtonAutorepeatAccScaleMinus.deinit();
+    BDButton::deinitAllButtonsOfPage();
     TouchSliderPitch.deinit();
     TouchSliderRoll.deinit();
 }
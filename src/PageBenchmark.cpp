@@ -0,0 +1,230 @@
+/*
+ * PageBenchmark.cpp
+ *
+ * Benchmark sub page of the tests page, called like the other sub pages of doTestButtons().
+ * Runs the BlueDisplay and signal benchmarks of Benchmark.cpp and benchmarks of DSO functions, SD card and UART,
+ * which need the hardware and are marked as target only in the CSV.
+ * The results can be saved as <date>.csv on the SD card to compare them between firmware versions.
+ * See tools/host/BenchmarkSuite.cpp for the host build of the BlueDisplay benchmarks.
+ *
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ */
+
+#include "Pages.h"
+#include "TouchDSO.h"
+#include "Benchmark.h"
+
+#include <string.h>
+#include <stdlib.h> // for malloc
+extern "C" {
+#include "diskio.h"
+#include "ff.h"
+#include "BlueSerial.h"
+}
+
+// firmware is identified by its compile time
+#define BENCHMARK_VERSION_STRING __DATE__ " " __TIME__
+
+#define BENCHMARK_UART_TEXT_LENGTH 64
+#define BENCHMARK_UART_SENDS 8
+#define BENCHMARK_FILE_NAME "BENCH.TMP"
+
+#define NUMBER_OF_BENCHMARKS (NUMBER_OF_DISPLAY_BENCHMARKS + NUMBER_OF_SIGNAL_BENCHMARKS + 6)
+
+static BDButton TouchButtonBenchmarkRun;
+static BDButton TouchButtonBenchmarkSave;
+
+static struct BenchmarkResult sBenchmarkResults[NUMBER_OF_BENCHMARKS];
+static int sNumberOfBenchmarkResults;
+
+static FIL sBenchmarkFile;
+static BYTE sBenchmarkDrive;
+static DWORD sBenchmarkSector;
+static uint8_t sBenchmarkSectorBuffer[512];
+
+/*
+ * DSO benchmarks, they use a synthetic signal in DataBufferControl.DataBuffer
+ */
+static void benchmarkFFT(int aIteration) {
+    computeFFT(&DataBufferControl.DataBuffer[(aIteration & 1) * FFT_SIZE]);
+}
+
+/*
+ * Trigger is found just before half of the buffer, which is the longest scan without restarting the DMA
+ */
+static void benchmarkTriggerScan(int aIteration __attribute__((unused))) {
+    DMACheckForTriggerCondition();
+}
+
+static void benchmarkMinMax(int aIteration __attribute__((unused))) {
+    computeMinMaxAverageAndPeriodFrequency();
+}
+
+static void benchmarkSDRead(int aIteration __attribute__((unused))) {
+    disk_read(sBenchmarkDrive, sBenchmarkSectorBuffer, sBenchmarkSector, 1);
+}
+
+static void benchmarkSDWrite(int aIteration __attribute__((unused))) {
+    disk_write(sBenchmarkDrive, sBenchmarkSectorBuffer, sBenchmarkSector, 1);
+}
+
+/*
+ * Includes waiting for the end of transmission, so it measures the throughput of the line
+ */
+static void benchmarkUART(int aIteration) {
+    static char sText[BENCHMARK_UART_TEXT_LENGTH + 1];
+    memset(sText, 'A' + (aIteration & 1), BENCHMARK_UART_TEXT_LENGTH);
+    for (int i = 0; i < BENCHMARK_UART_SENDS; ++i) {
+        BlueDisplay1.drawText(0, 200, sText, TEXT_SIZE_11, COLOR_BLACK, COLOR_WHITE);
+    }
+    waitForUSARTSendComplete();
+}
+
+static const struct Benchmark sDSOBenchmarks[] = { { "FFT", &benchmarkFFT, 0, true }, { "trigger scan",
+        &benchmarkTriggerScan, 0, true }, { "min/max", &benchmarkMinMax, 0, true } };
+static const struct Benchmark sSDBenchmarks[] = { { "SD sector read", &benchmarkSDRead, 512, true }, { "SD sector write",
+        &benchmarkSDWrite, 512, true } };
+static const struct Benchmark sUARTBenchmark = { "UART text", &benchmarkUART, BENCHMARK_UART_TEXT_LENGTH
+        * BENCHMARK_UART_SENDS, true };
+
+/*
+ * Square wave with edge before DATABUFFER_SIZE / 2 and the current trigger settings
+ */
+static void runDSOBenchmarks(void) {
+    struct MeasurementControlStruct tMeasurementControl = MeasurementControl;
+    uint16_t * tDisplayStart = DataBufferControl.DataBufferDisplayStart;
+    volatile uint16_t * tEndPointer = DataBufferControl.DataBufferEndPointer;
+    void * tTempBuffer = TempBufferForPreTriggerAdjustAndFFT;
+
+    TempBufferForPreTriggerAdjustAndFFT = malloc(sizeof(float32_t) * 2 * FFT_SIZE);
+    if (TempBufferForPreTriggerAdjustAndFFT != NULL) {
+        for (int i = 0; i < DATABUFFER_SIZE; ++i) {
+            uint16_t tValue = ((i / 32) & 1) ? 3000 : 1000;
+            if (i < DATABUFFER_SIZE / 2 - 32) {
+                tValue = 1000;
+            }
+            DataBufferControl.DataBuffer[i] = tValue;
+        }
+        MeasurementControl.TriggerMode = TRIGGER_MODE_AUTOMATIC;
+        MeasurementControl.TriggerSlopeRising = true;
+        MeasurementControl.RawTriggerLevel = 2000;
+        MeasurementControl.RawTriggerLevelHysteresis = 1900;
+        MeasurementControl.StopRequested = false;
+        MeasurementControl.isEffectiveMinMaxMode = false;
+        for (unsigned int i = 0; i < sizeof(sDSOBenchmarks) / sizeof(sDSOBenchmarks[0]); ++i) {
+            runBenchmark(&sDSOBenchmarks[i], &sBenchmarkResults[sNumberOfBenchmarkResults++]);
+        }
+        free(TempBufferForPreTriggerAdjustAndFFT);
+    }
+
+    TempBufferForPreTriggerAdjustAndFFT = tTempBuffer;
+    DataBufferControl.DataBufferDisplayStart = tDisplayStart;
+    DataBufferControl.DataBufferEndPointer = tEndPointer;
+    MeasurementControl = tMeasurementControl;
+}
+
+/*
+ * Gets a sector of the card by writing a temporary file, so the raw sector access cannot damage the file system
+ */
+static void runSDBenchmarks(void) {
+    if (!MICROSD_isCardInserted()
+            || f_open(&sBenchmarkFile, BENCHMARK_FILE_NAME, FA_CREATE_ALWAYS | FA_WRITE) != FR_OK) {
+        return;
+    }
+    UINT tCount;
+    memset(sBenchmarkSectorBuffer, 0x55, sizeof(sBenchmarkSectorBuffer));
+    f_write(&sBenchmarkFile, sBenchmarkSectorBuffer, sizeof(sBenchmarkSectorBuffer), &tCount);
+    f_sync(&sBenchmarkFile);
+    sBenchmarkDrive = sBenchmarkFile.fs->drv;
+    sBenchmarkSector = sBenchmarkFile.dsect;
+    if (tCount == sizeof(sBenchmarkSectorBuffer) && sBenchmarkSector != 0) {
+        for (unsigned int i = 0; i < sizeof(sSDBenchmarks) / sizeof(sSDBenchmarks[0]); ++i) {
+            runBenchmark(&sSDBenchmarks[i], &sBenchmarkResults[sNumberOfBenchmarkResults++]);
+        }
+    }
+    f_close(&sBenchmarkFile);
+    f_unlink(BENCHMARK_FILE_NAME);
+}
+
+/*
+ * The back button of the tests page is at the right of the first row, so only the area below is cleared
+ */
+static void drawBenchmarkPage(void) {
+    BlueDisplay1.fillRectRel(0, BUTTON_HEIGHT_4, BlueDisplay1.getDisplayWidth(),
+            BlueDisplay1.getDisplayHeight() - BUTTON_HEIGHT_4, COLOR_BACKGROUND_DEFAULT);
+    TouchButtonBenchmarkRun.drawButton();
+    TouchButtonBenchmarkSave.drawButton();
+    BlueDisplay1.drawText(0, BUTTON_HEIGHT_4_LINE_2 - TEXT_SIZE_11_HEIGHT + TEXT_SIZE_11_ASCEND,
+            "median of             cycles      time", TEXT_SIZE_11,
+            COLOR_PAGE_INFO, COLOR_BACKGROUND_DEFAULT);
+    for (int i = 0; i < sNumberOfBenchmarkResults; ++i) {
+        formatBenchmarkResult(StringBuffer, sizeof StringBuffer, &sBenchmarkResults[i]);
+        BlueDisplay1.drawText(0, BUTTON_HEIGHT_4_LINE_2 + i * TEXT_SIZE_11_HEIGHT + TEXT_SIZE_11_ASCEND,
+                StringBuffer, TEXT_SIZE_11, COLOR_BLACK, COLOR_BACKGROUND_DEFAULT);
+    }
+}
+
+static void writeToBenchmarkFile(const char * aText, int aLength) {
+    UINT tCount;
+    f_write(&sBenchmarkFile, aText, aLength, &tCount);
+}
+
+/**
+ * Writes results to <date>.csv on the SD card
+ */
+static bool saveBenchmarkResults(void) {
+    if (sNumberOfBenchmarkResults == 0 || !MICROSD_isCardInserted()) {
+        return false;
+    }
+    RTC_getDateStringForFile(StringBuffer);
+    strcat(StringBuffer, ".csv");
+    if (f_open(&sBenchmarkFile, StringBuffer, FA_CREATE_ALWAYS | FA_WRITE) != FR_OK) {
+        return false;
+    }
+    writeBenchmarkCSV(sBenchmarkResults, sNumberOfBenchmarkResults, BENCHMARK_VERSION_STRING, &writeToBenchmarkFile);
+    f_close(&sBenchmarkFile);
+    return true;
+}
+
+void doBenchmarkButtons(BDButton * aTheTouchedButton, int16_t aValue) {
+    if (aTheTouchedButton->mButtonHandle == TouchButtonBenchmarkRun.mButtonHandle) {
+        sNumberOfBenchmarkResults = 0;
+        for (int i = 0; i < NUMBER_OF_DISPLAY_BENCHMARKS; ++i) {
+            runBenchmark(&DisplayBenchmarks[i], &sBenchmarkResults[sNumberOfBenchmarkResults++]);
+        }
+        for (int i = 0; i < NUMBER_OF_SIGNAL_BENCHMARKS; ++i) {
+            runBenchmark(&SignalBenchmarks[i], &sBenchmarkResults[sNumberOfBenchmarkResults++]);
+        }
+        runDSOBenchmarks();
+        runSDBenchmarks();
+        runBenchmark(&sUARTBenchmark, &sBenchmarkResults[sNumberOfBenchmarkResults++]);
+        drawBenchmarkPage();
+    } else {
+        const char * tMessage = "saved      ";
+        if (!saveBenchmarkResults()) {
+            tMessage = "save failed";
+        }
+        BlueDisplay1.drawText(BUTTON_WIDTH_3_POS_2, BUTTON_HEIGHT_6 + 4 + TEXT_SIZE_11_ASCEND, tMessage, TEXT_SIZE_11,
+        COLOR_PAGE_INFO, COLOR_BACKGROUND_DEFAULT);
+    }
+}
+
+void startBenchmarkPage(void) {
+    BDButton::startButtonPage();
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wwrite-strings"
+    TouchButtonBenchmarkRun.init(0, 0, BUTTON_WIDTH_3, BUTTON_HEIGHT_4, COLOR_GREEN, "Run", TEXT_SIZE_22,
+            BUTTON_FLAG_DO_BEEP_ON_TOUCH, 0, &doBenchmarkButtons);
+    TouchButtonBenchmarkSave.init(BUTTON_WIDTH_3_POS_2, 0, BUTTON_WIDTH_3, BUTTON_HEIGHT_6, COLOR_GREEN, "Save CSV",
+            TEXT_SIZE_11, BUTTON_FLAG_DO_BEEP_ON_TOUCH, 0, &doBenchmarkButtons);
+#pragma GCC diagnostic pop
+    drawBenchmarkPage();
+}
+
+void loopBenchmarkPage(void) {
+    checkAndHandleEvents();
+}
+
+void stopBenchmarkPage(void) {
+    BDButton::deinitAllButtonsOfPage();
+}
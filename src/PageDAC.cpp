@@ -223,6 +223,7 @@ void initDACPage(void) {
 }
 
 void startDACPage(void) {
+    BDButton::startButtonPage();
     //1. row
     int tPosY = 0;
     TouchButtonStartStop.init(BUTTON_WIDTH_3_POS_2, tPosY, BUTTON_WIDTH_3,
@@ -292,10 +293,7 @@ void loopDACPage(void) {
 }
 
 void stopDACPage(void) {
-    TouchButtonStartStop.deinit();
-    TouchButtonSetWaveform.deinit();
-    TouchButtonAutorepeatFrequencyPlus.deinit();
-    TouchButtonAutorepeatFrequencyMinus.deinit();
+    BDButton::deinitAllButtonsOfPage();
     TouchSliderFrequency.deinit();
     TouchSliderAmplitude.deinit();
     TouchSliderOffset.deinit();
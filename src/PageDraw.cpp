@@ -74,6 +74,7 @@ void drawPageTouchDownCallbackHandler(struct TouchEvent * const aActualPositionP
 }
 
 void startDrawPage(void) {
+    BDButton::startButtonPage();
     // Color buttons
     uint16_t tPosY = 0;
     for (uint8_t i = 0; i < 5; ++i) {
@@ -101,9 +102,6 @@ void loopDrawPage(void) {
 
 void stopDrawPage(void) {
 // free buttons
-    for (unsigned int i = 0; i < NUMBER_OF_DRAW_COLORS; ++i) {
-        TouchButtonsDrawColor[i].deinit();
-    }
-    TouchButtonClear.deinit();
+    BDButton::deinitAllButtonsOfPage();
 }
 
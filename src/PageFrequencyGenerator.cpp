@@ -406,6 +406,7 @@ void initFrequencyGeneratorPage(void) {
 
 void startFrequencyGeneratorPage(void) {
 #ifdef LOCAL_DISPLAY_EXISTS
+    BDButton::startButtonPage();
     createGui();
     setFrequencyFactor(sFrequencyFactorIndex);
 #endif
@@ -423,15 +424,7 @@ void loopFrequencyGeneratorPage(void) {
 void stopFrequencyGeneratorPage(void) {
 #ifdef LOCAL_DISPLAY_EXISTS
     // free buttons
-    for (unsigned int i = 0; i < NUMBER_OF_FIXED_FREQUENCY_BUTTONS; ++i) {
-        TouchButtonFixedFrequency[i]->deinit();
-    }
-
-    for (int i = 0; i < NUMBER_OF_FREQUENCY_RANGE_BUTTONS; ++i) {
-        TouchButtonFrequencyRanges[i].deinit();
-    }
-    TouchButtonFrequencyStartStop.deinit();
-    TouchButtonGetFrequency.deinit();
+    BDButton::deinitAllButtonsOfPage();
     TouchSliderFrequency.deinit();
 #else
     TouchSliderFrequency.deactivate();
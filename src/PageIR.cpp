@@ -12,6 +12,7 @@
 #include "main.h"  /* For RCC_Clocks */
 #include "tinyPrint.h"
 #include "l3gdc20_lsm303dlhc_utils.h"
+#include "DeferredWork.h"
 
 extern "C" {
 #include "irmp.h"
@@ -163,6 +164,23 @@ void doVelocitySlider(BDSlider * aTheTouchedSlider, uint16_t aValue) {
     aTheTouchedSlider->printValue(StringBuffer);
 }
 
+#ifdef USE_DEFERRED_WORK
+#define IR_SAMPLES_PER_WORK 32 // 2.1 ms at 15 kHz
+static uint32_t sIRSamples; // one bit per sample, first sample at bit 0
+static uint8_t sIRSampleCount;
+
+/*
+ * Called by PendSV. Decodes the samples in the same order and number, as the timer ISR would have done.
+ */
+static void decodeIRSamples(uint32_t aSamples) {
+    for (int i = 0; i < IR_SAMPLES_PER_WORK; ++i) {
+        irmp_deferred_input = aSamples & 0x01;
+        irmp_ISR();
+        aSamples >>= 1;
+    }
+}
+#endif
+
 /*---------------------------------------------------------------------------------------------------------------------------------------------------
  * timer 15 update handler, called every 1/15000 sec
  *---------------------------------------------------------------------------------------------------------------------------------------------------
@@ -170,7 +188,20 @@ void doVelocitySlider(BDSlider * aTheTouchedSlider, uint16_t aValue) {
 extern "C" void TIM1_BRK_TIM15_IRQHandler(void) {
 // if irsnd_ISR not busy call irmp ISR
     if (!irsnd_ISR()) {
+#ifdef USE_DEFERRED_WORK
+        // only sample here, decoding is done by PendSV
+        if (irmp_read_pin()) {
+            sIRSamples |= 1UL << sIRSampleCount;
+        }
+        sIRSampleCount++;
+        if (sIRSampleCount >= IR_SAMPLES_PER_WORK) {
+            queueDeferredWork(DEFERRED_WORK_QUEUE_IR, &decodeIRSamples, sIRSamples);
+            sIRSamples = 0;
+            sIRSampleCount = 0;
+        }
+#else
         irmp_ISR();
+#endif
     }
 
     BSP_LED_Toggle(LED_GREEN_2); // GREEN RIGHT
@@ -197,7 +228,7 @@ void drawIRPage(void) {
  * use TIM15 as timer and TIM17 as PWM generator
  */
 void startIRPage(void) {
-
+    BDButton::startButtonPage();
     setZeroAccelerometerGyroValue();
     int tXPos = 0;
     for (unsigned int i = 0; i < NUMBER_OF_IR_BUTTONS; ++i) {
@@ -392,13 +423,7 @@ void loopIRPage(void) {
  */
 void stopIRPage(void) {
 // free buttons
-    for (unsigned int i = 0; i < NUMBER_OF_IR_BUTTONS; ++i) {
-        TouchButtonsIRSend[i].deinit();
-    }
-    for (unsigned int i = 0; i < sizeof(TouchButtonsIRControl) / sizeof(TouchButtonsIRControl[0]); ++i) {
-        TouchButtonsIRControl[i]->deinit();
-    }
-
+    BDButton::deinitAllButtonsOfPage();
     TouchSliderVelocity.deinit();
     TouchSliderPitch.deinit();
     TouchSliderYaw.deinit();
@@ -10,6 +10,8 @@
 
 #include "Pages.h"
 #include "EventHandler.h"
+#include "Profiler.h"
+#include "EventTrace.h"
 #include "l3gdc20_lsm303dlhc_utils.h"
 
 #include "tinyPrint.h"
@@ -32,6 +34,13 @@ BDButton TouchButtonInfoFont2;
 BDButton TouchButtonInfoColors;
 BDButton TouchButtonInfoMMC;
 BDButton TouchButtonInfoUSB;
+BDButton TouchButtonInfoBaud;
+#ifdef USE_PC_SAMPLING_PROFILER
+BDButton TouchButtonInfoProfiler;
+#endif
+#ifdef USE_EVENT_TRACE
+BDButton TouchButtonInfoTrace;
+#endif
 
 BDButton TouchButtonInfoSystem;
 
@@ -39,9 +48,9 @@ BDButton TouchButtonInfoSystem;
 BDButton TouchButtonSettingsGamma1;
 BDButton TouchButtonSettingsGamma2;
 
-#define INFO_BUTTONS_NUMBER_TO_DISPLAY 6 // Number of buttons on main info page, without back button
+#define INFO_BUTTONS_NUMBER_TO_DISPLAY 7 // Number of buttons on main info page, without back button
 BDButton * const TouchButtonsInfoPage[] = { &TouchButtonInfoFont1, &TouchButtonInfoFont2, &TouchButtonInfoColors,
-        &TouchButtonInfoMMC, &TouchButtonInfoSystem, &TouchButtonInfoUSB, &TouchButtonBack,
+        &TouchButtonInfoMMC, &TouchButtonInfoSystem, &TouchButtonInfoUSB, &TouchButtonInfoBaud, &TouchButtonBack,
         &TouchButtonSettingsGamma1, &TouchButtonSettingsGamma2 };
 
 /* Private function prototypes -----------------------------------------------*/
@@ -252,6 +261,50 @@ void doInfoButtons(BDButton * aTheTouchedButton, int16_t aValue) {
     }
 }
 
+/**
+ * Steps up the baud rate of the BlueDisplay link. Result is shown by loopInfoPage().
+ */
+void doNegotiateBaudRate(BDButton * aTheTouchedButton, int16_t aValue) {
+    if (USART_isBluetoothPaired()) {
+        negotiateUSARTBaudRate(BAUD_NEGOTIATION_MAX_BAUD_RATE);
+    }
+}
+
+#ifdef USE_PC_SAMPLING_PROFILER
+/**
+ * Starts the profiler or stops it and dumps the histogram to SD card and USB CDC.
+ * aValue is true if profiler was started, since it may have stopped itself.
+ */
+void doProfiler(BDButton * aTheTouchedButton, int16_t aValue) {
+    if (!aValue) {
+        startProfiler();
+        aTheTouchedButton->setValue(true);
+        aTheTouchedButton->setCaptionAndDraw("Stop Profiler");
+    } else {
+        stopProfiler();
+        aTheTouchedButton->setValue(false);
+        aTheTouchedButton->setCaptionAndDraw("Start Profiler");
+        bool tToFile = dumpProfilerToFile();
+        bool tToUSB = dumpProfilerToUSB();
+        snprintf(StringBuffer, sizeof StringBuffer, "Profile %lu samples idle=%lu dropped=%lu %s%s",
+                ProfilerStatistics.Samples, ProfilerStatistics.IdleSamples, ProfilerStatistics.DroppedSamples,
+                tToFile ? "SD " : "", tToUSB ? "USB" : "");
+        BlueDisplay1.drawText(2, BlueDisplay1.getDisplayHeight() - 4 * TEXT_SIZE_11_HEIGHT + TEXT_SIZE_11_ASCEND,
+                StringBuffer, TEXT_SIZE_11, COLOR_PAGE_INFO, COLOR_WHITE);
+        FeedbackTone((tToFile || tToUSB) ? FEEDBACK_TONE_NO_ERROR : FEEDBACK_TONE_LONG_ERROR);
+    }
+}
+#endif
+
+#ifdef USE_EVENT_TRACE
+/**
+ * Saves the last EVENT_TRACE_SIZE trace records to SD card
+ */
+void doSaveTrace(BDButton * aTheTouchedButton, int16_t aValue) {
+    FeedbackTone(dumpEventTraceToFile() ? FEEDBACK_TONE_NO_ERROR : FEEDBACK_TONE_LONG_ERROR);
+}
+#endif
+
 // TODO implement readPixel
 void pickColorPeriodicCallbackHandler(struct TouchEvent * const aActualPositionPtr) {
     // first check button
@@ -283,6 +336,12 @@ void drawInfoPage(void) {
     for (unsigned int i = 0; i < INFO_BUTTONS_NUMBER_TO_DISPLAY; ++i) {
         TouchButtonsInfoPage[i]->drawButton();
     }
+#ifdef USE_PC_SAMPLING_PROFILER
+    TouchButtonInfoProfiler.drawButton();
+#endif
+#ifdef USE_EVENT_TRACE
+    TouchButtonInfoTrace.drawButton();
+#endif
     TouchButtonMainHome.drawButton();
 }
 
@@ -290,6 +349,7 @@ void drawInfoPage(void) {
  * allocate and position all BUTTONS
  */
 void startInfoPage(void) {
+    BDButton::startButtonPage();
     printSetPositionColumnLine(0, 0);
 
 #pragma GCC diagnostic push
@@ -322,6 +382,15 @@ void startInfoPage(void) {
     TouchButtonInfoUSB.init(0, tPosY, BUTTON_WIDTH_3, BUTTON_HEIGHT_4, COLOR_GREEN, "USB Infos",
     TEXT_SIZE_11, BUTTON_FLAG_DO_BEEP_ON_TOUCH, 0, &doInfoButtons);
 
+    TouchButtonInfoBaud.init(BUTTON_WIDTH_3_POS_2, tPosY, BUTTON_WIDTH_3,
+    BUTTON_HEIGHT_4, COLOR_GREEN, "Baud Negotiation", TEXT_SIZE_11, BUTTON_FLAG_DO_BEEP_ON_TOUCH, 0, &doNegotiateBaudRate);
+
+#ifdef USE_PC_SAMPLING_PROFILER
+    TouchButtonInfoProfiler.init(BUTTON_WIDTH_3_POS_3, tPosY, BUTTON_WIDTH_3, BUTTON_HEIGHT_4, COLOR_GREEN,
+            isProfilerRunning() ? "Stop Profiler" : "Start Profiler", TEXT_SIZE_11, BUTTON_FLAG_DO_BEEP_ON_TOUCH,
+            isProfilerRunning(), &doProfiler);
+#endif
+
 // 4. row
     tPosY += BUTTON_HEIGHT_4_LINE_2;
 
@@ -331,10 +400,18 @@ void startInfoPage(void) {
     TouchButtonSettingsGamma2.init(BUTTON_WIDTH_3_POS_2, tPosY, BUTTON_WIDTH_3,
     BUTTON_HEIGHT_4, COLOR_GREEN, NULL, 0, BUTTON_FLAG_DO_BEEP_ON_TOUCH, 1, &doSetGamma);
 
+#ifdef USE_EVENT_TRACE
+    TouchButtonInfoTrace.init(BUTTON_WIDTH_3_POS_3, tPosY, BUTTON_WIDTH_3, BUTTON_HEIGHT_4, COLOR_GREEN, "Save Trace",
+    TEXT_SIZE_11, BUTTON_FLAG_DO_BEEP_ON_TOUCH, 0, &doSaveTrace);
+#endif
+
 #pragma GCC diagnostic pop
 
     drawInfoPage();
     registerRedrawCallback(&drawInfoPage);
+#ifdef USE_TICKLESS_IDLE
+    resetIdleStatistics();
+#endif
 }
 
 void loopInfoPage(void) {
@@ -348,6 +425,25 @@ void loopInfoPage(void) {
             StringBuffer,
             TEXT_SIZE_11, COLOR_PAGE_INFO, COLOR_WHITE);
 
+// display BlueDisplay link speed
+    if (BaudNegotiationStatistics.BaudRate == 0) {
+        snprintf(StringBuffer, sizeof StringBuffer, "BD %lu baud", getUSART_BD_BaudRate());
+    } else {
+        snprintf(StringBuffer, sizeof StringBuffer, "BD %lu baud %lu byte/s fallb.=%u rej.=%u",
+                BaudNegotiationStatistics.BaudRate, BaudNegotiationStatistics.BytesPerSecond,
+                BaudNegotiationStatistics.Fallbacks, BaudNegotiationStatistics.Rejected);
+    }
+    BlueDisplay1.drawText(2, BlueDisplay1.getDisplayHeight() - 2 * TEXT_SIZE_11_HEIGHT + TEXT_SIZE_11_ASCEND,
+            StringBuffer, TEXT_SIZE_11, COLOR_PAGE_INFO, COLOR_WHITE);
+
+#ifdef USE_TICKLESS_IDLE
+    // display sleep time since page start, mainly from the delay below
+    snprintf(StringBuffer, sizeof StringBuffer, "Idle %lu%% sleeps=%lu suppr.=%lu wake up max %luns", getIdlePercent(),
+            IdleStatistics.Sleeps, IdleStatistics.SuppressedSystics, IdleStatistics.MaxWakeUpNanos);
+    BlueDisplay1.drawText(2, BlueDisplay1.getDisplayHeight() - 3 * TEXT_SIZE_11_HEIGHT + TEXT_SIZE_11_ASCEND,
+            StringBuffer, TEXT_SIZE_11, COLOR_PAGE_INFO, COLOR_WHITE);
+#endif
+
     delayMillisWithCheckAndHandleEvents(500);
 }
 
@@ -356,7 +452,5 @@ void loopInfoPage(void) {
  */
 void stopInfoPage(void) {
 // free buttons
-    for (unsigned int i = 0; i < sizeof(TouchButtonsInfoPage) / sizeof(TouchButtonsInfoPage[0]); ++i) {
-        TouchButtonsInfoPage[i]->deinit();
-    }
+    BDButton::deinitAllButtonsOfPage();
 }
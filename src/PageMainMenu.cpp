@@ -28,6 +28,7 @@
 #include "AccuCapacity.h"
 #include "GuiDemo.h"
 #include "stm32f3DiscoveryLedsButtons.h"
+#include "EventTrace.h"
 
 extern "C" {
 #include "diskio.h"
@@ -69,6 +70,7 @@ void drawMainMenuPage(void);
 
 /* Private functions ---------------------------------------------------------*/
 void doMainMenuButtons(BDButton * aTheTouchedButton, int16_t aValue) {
+    TRACE_BEGIN(TRACE_ID_PAGE, aTheTouchedButton->mButtonHandle);
     BDButton::deactivateAllButtons();
     if (aTheTouchedButton->mButtonHandle == TouchButtonDSO.mButtonHandle) {
         startDSOPage();
@@ -234,6 +236,7 @@ void doClearScreen(BDButton * aTheTouchedButton, int16_t aValue) {
  * ends loops in button handler
  */
 void backToMainMenu(void) {
+    TRACE_END(TRACE_ID_PAGE);
     sInApplication = false;
     BDButton::deactivateAllButtons();
     BDSlider::deactivateAllSliders();
@@ -273,6 +276,7 @@ void initMainMenuPage(void) {
 }
 
 void startMainMenuPage(void) {
+    BDButton::startButtonPage();
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wwrite-strings"
     /**
@@ -333,7 +337,8 @@ void startMainMenuPage(void) {
 
 void loopMainMenuPage(void) {
     showRTCTimeEverySecond(0, BUTTON_HEIGHT_4_LINE_4 - TEXT_SIZE_11_DECEND, COLOR_RED, COLOR_BACKGROUND_DEFAULT);
-    checkAndHandleEvents();
+    // RTC is polled
+    checkAndHandleEventsAndIdle(100);
 }
 
 void stopMainMenuPage(void) {
@@ -341,8 +346,6 @@ void stopMainMenuPage(void) {
     registerTouchDownCallback(NULL);
     registerTouchMoveCallback(NULL);
     // free buttons
-    for (unsigned int i = 0; i < sizeof(TouchButtonsMainMenu) / sizeof(TouchButtonsMainMenu[0]); ++i) {
-        (*TouchButtonsMainMenu[i]).deinit();
-    }
+    BDButton::deinitAllButtonsOfPage();
 }
 
@@ -187,6 +187,7 @@ float getNumberFromNumberPad(uint16_t aXStart, uint16_t aYStart, uint16_t aButto
     BDButton::deactivateAllButtons();
     // disable temporarily the end callback function
     setTouchUpCallbackEnabled(false);
+    BDButton::startButtonPage();
     drawNumberPad(aXStart, aYStart, aButtonColor);
     clearNumberPadBuffer();
     numberpadInputHasFinished = false;
@@ -195,9 +196,7 @@ float getNumberFromNumberPad(uint16_t aXStart, uint16_t aYStart, uint16_t aButto
         checkAndHandleEvents();
     }
     // free numberpad buttons
-    for (unsigned int i = 0; i < sizeof(TouchButtonsNumberPad) / sizeof(TouchButtonsNumberPad[0]); ++i) {
-        TouchButtonsNumberPad[i]->deinit();
-    }
+    BDButton::deinitAllButtonsOfPage();
     // to avoid end touch handling of releasing OK or Cancel button of numberpad
     sDisableTouchUpOnce = true;
     setTouchUpCallbackEnabled(true);
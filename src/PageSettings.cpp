@@ -111,6 +111,7 @@ void drawSettingsPage(void) {
 }
 
 void startSettingsPage(void) {
+    BDButton::startButtonPage();
 #ifdef LOCAL_DISPLAY_EXISTS
     initBacklightElements();
 #endif
@@ -148,13 +149,10 @@ void loopSettingsPage(void) {
 }
 
 void stopSettingsPage(void) {
+    BDButton::deinitAllButtonsOfPage();
 #ifdef LOCAL_DISPLAY_EXISTS
-    TouchButtonTPCalibration.deinit();
     deinitBacklightElements();
 #endif
-    TouchButtonTogglePrintMode.deinit();
-    TouchButtonToggleTouchXYDisplay.deinit();
-    deinitClockSettingElements();
 }
 
 /**
@@ -194,12 +192,6 @@ void initClockSettingElements(void) {
     sSetDateMode = 0;
 }
 
-void deinitClockSettingElements(void) {
-    TouchButtonSetDate.deinit();
-    TouchButtonAutorepeatDate_Plus.deinit();
-    TouchButtonAutorepeatDate_Minus.deinit();
-}
-
 void drawClockSettingElements(void) {
     TouchButtonSetDate.drawButton();
     sSetDateMode = 0;
@@ -329,9 +321,10 @@ void initBacklightElements(void) {
 #pragma GCC diagnostic pop
 }
 
+/**
+ * the backlight buttons are freed with the buttons of the page by BDButton::deinitAllButtonsOfPage()
+ */
 void deinitBacklightElements(void) {
-    TouchButtonAutorepeatBacklight_Plus.deinit();
-    TouchButtonAutorepeatBacklight_Minus.deinit();
     TouchSliderBacklight.deinit();
 }
 
@@ -15,6 +15,7 @@
 
 #include "tinyPrint.h"
 #include "main.h"
+#include "CooperativeTask.h"
 #include <string.h>
 #include <locale.h>
 #include <stdlib.h> // for srand
@@ -42,6 +43,7 @@ BDButton TouchButtonTestFunction1;
 BDButton TouchButtonTestFunction2;
 BDButton TouchButtonTestFunction3;
 BDButton TouchButtonTestMandelbrot;
+BDButton TouchButtonTestBenchmark;
 
 BDButton TouchButtonSPIPrescalerPlus;
 BDButton TouchButtonSPIPrescalerMinus;
@@ -53,40 +55,61 @@ BDButton* const TouchButtonsTestPage[] =
         { &TouchButtonTestMandelbrot, &TouchButtonTestExceptions, &TouchButtonTestMisc, &TouchButtonTestReset,
                 &TouchButtonTestGraphics, &TouchButtonTestFunction1, &TouchButtonTestFunction2,
                 &TouchButtonTestFunction3, &TouchButtonAutorepeatBaudPlus, &TouchButtonAutorepeatBaudMinus,
-                &TouchButtonSPIPrescalerPlus, &TouchButtonSPIPrescalerMinus, &TouchButtonBack };
+                &TouchButtonSPIPrescalerPlus, &TouchButtonSPIPrescalerMinus, &TouchButtonTestBenchmark,
+                &TouchButtonBack };
 
 /* Private function prototypes -----------------------------------------------*/
 
 void drawTestsPage(void);
 
 /* Private functions ---------------------------------------------------------*/
-void Mandel(uint16_t size_x, uint16_t size_y, uint16_t offset_x, uint16_t offset_y, uint16_t zoom) {
+void MandelLine(uint16_t size_x, uint16_t y, uint16_t offset_x, uint16_t offset_y, uint16_t zoom) {
     float tmp1, tmp2;
     float num_real, num_img;
     float radius;
     uint8_t i;
-    uint16_t x, y;
-    for (y = 0; y < size_y; y++) {
-        for (x = 0; x < size_x; x++) {
-            num_real = y - offset_y;
-            num_real = num_real / zoom;
-            num_img = x - offset_x;
-            num_img = num_img / zoom;
-            i = 0;
-            radius = 0;
-            while ((i < 256 - 1) && (radius < 4)) {
-                tmp1 = num_real * num_real;
-                tmp2 = num_img * num_img;
-                num_img = 2 * num_real * num_img + 0.6;
-                num_real = tmp1 - tmp2 - 0.4;
-                radius = tmp1 + tmp2;
-                i++;
-            }
-            BlueDisplay1.drawPixel(x, y, RGB(i * 8, i * 18, i * 13));
+    uint16_t x;
+    for (x = 0; x < size_x; x++) {
+        num_real = y - offset_y;
+        num_real = num_real / zoom;
+        num_img = x - offset_x;
+        num_img = num_img / zoom;
+        i = 0;
+        radius = 0;
+        while ((i < 256 - 1) && (radius < 4)) {
+            tmp1 = num_real * num_real;
+            tmp2 = num_img * num_img;
+            num_img = 2 * num_real * num_img + 0.6;
+            num_real = tmp1 - tmp2 - 0.4;
+            radius = tmp1 + tmp2;
+            i++;
         }
+        BlueDisplay1.drawPixel(x, y, RGB(i * 8, i * 18, i * 13));
     }
 }
 
+static struct CooperativeTask sMandelbrotTask;
+static uint16_t sMandelbrotZoom;
+static uint16_t sMandelbrotLine;
+
+/*
+ * Draws one line for each call, with increasing zoom until back button is pressed
+ */
+static bool mandelbrotTask(struct CooperativeTask * aTask) {
+    TASK_BEGIN(aTask);
+    sMandelbrotZoom = 1;
+    while (true) {
+        for (sMandelbrotLine = 0; sMandelbrotLine < 240; sMandelbrotLine++) {
+            MandelLine(320, sMandelbrotLine, 160, 120, sMandelbrotZoom);
+            TASK_YIELD(aTask);
+        }
+        sMandelbrotZoom += 10;
+        if (sMandelbrotZoom > 1000)
+            sMandelbrotZoom = 0;
+    }
+    TASK_END(aTask);
+}
+
 /*********************************************
  * Test stuff
  *********************************************/
@@ -186,14 +209,15 @@ void doTestButtons(BDButton * aTheTouchedButton, int16_t aValue) {
         reset();
 
     } else if (aTheTouchedButton->mButtonHandle == TouchButtonTestMandelbrot.mButtonHandle) {
-        int i = 1;
+        // runs in the page loop, so the back button is handled after each line
+        startCooperativeTask(&sMandelbrotTask, &mandelbrotTask);
+    } else if (aTheTouchedButton->mButtonHandle == TouchButtonTestBenchmark.mButtonHandle) {
+        startBenchmarkPage();
         do {
-            Mandel(320, 240, 160, 120, i);
-            i += 10;
-            if (i > 1000)
-                i = 0;
-            checkAndHandleEvents();
+            loopBenchmarkPage();
         } while (!sBackButtonPressed);
+        stopBenchmarkPage();
+
     } else if (aTheTouchedButton->mButtonHandle == TouchButtonTestGraphics.mButtonHandle) {
         TouchButtonBack.activate();
         BlueDisplay1.testDisplay();
@@ -213,6 +237,7 @@ void doTestButtons(BDButton * aTheTouchedButton, int16_t aValue) {
  * switch back to tests menu
  */
 void doTestsBackButton(BDButton * aTheTouchedButton, int16_t aValue) {
+    stopCooperativeTask(&sMandelbrotTask);
     drawTestsPage();
     sBackButtonPressed = true;
 }
@@ -235,6 +260,7 @@ void initTestPage(void) {
  * allocate and position all BUTTONS
  */
 void startTestsPage(void) {
+    BDButton::startButtonPage();
     printSetPositionColumnLine(0, 0);
 
 #pragma GCC diagnostic push
@@ -282,6 +308,9 @@ void startTestsPage(void) {
     TouchButtonSPIPrescalerMinus.init(BUTTON_WIDTH_6_POS_2, tPosY, BUTTON_WIDTH_6, BUTTON_HEIGHT_5, COLOR_BLUE, "-",
     TEXT_SIZE_22, BUTTON_FLAG_DO_BEEP_ON_TOUCH, -1, &doSetTestvalue);
 
+    TouchButtonTestBenchmark.init(BUTTON_WIDTH_3_POS_2, tPosY, BUTTON_WIDTH_3, BUTTON_HEIGHT_5, COLOR_GREEN,
+            "Benchmark", TEXT_SIZE_11, BUTTON_FLAG_DO_BEEP_ON_TOUCH, 0, &doTestButtons);
+
     TouchButtonAutorepeatBaudPlus.init(BUTTON_WIDTH_6_POS_5, tPosY, BUTTON_WIDTH_6, BUTTON_HEIGHT_5, COLOR_GREEN, "+",
     TEXT_SIZE_22, BUTTON_FLAG_DO_BEEP_ON_TOUCH | BUTTON_FLAG_TYPE_AUTOREPEAT, 1, &doChangeBaudrate);
     TouchButtonAutorepeatBaudPlus.setButtonAutorepeatTiming(600, 100, 10, 20);
@@ -305,8 +334,7 @@ void loopTestsPage(void) {
  * cleanup on leaving this page
  */
 void stopTestsPage(void) {
+    stopCooperativeTask(&sMandelbrotTask);
     // free buttons
-    for (unsigned int i = 0; i < sizeof(TouchButtonsTestPage) / sizeof(TouchButtonsTestPage[0]); ++i) {
-        TouchButtonsTestPage[i]->deinit();
-    }
+    BDButton::deinitAllButtonsOfPage();
 }
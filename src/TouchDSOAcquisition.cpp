@@ -51,6 +51,8 @@ extern "C" {
 
 #include "Chart.h" // for adjustIntWithScaleFactor()
 #include "AssertErrorAndMisc.h" // for failParamMessage()
+#include "DeferredWork.h"
+#include "EventTrace.h"
 
 #include "arm_common_tables.h" // For FFT
 
@@ -324,6 +326,7 @@ void resetAcquisition(void) {
  * setup new interrupt cycle only if not to be stopped
  */
 void startAcquisition(void) {
+    TRACE_INSTANT(TRACE_ID_START_ACQUISITION, MeasurementControl.TimebaseEffectiveIndex);
 
     // Default setting (regular mode)
     // start with waiting for triggering condition
@@ -396,11 +399,11 @@ void startAcquisition(void) {
     } else {
         // ADC -> DMA -> interrupt mode
         if (MeasurementControl.isEffectiveMinMaxMode) {
-            ADC1_DMA_start((uint32_t) &DataBufferControl.DataBufferTempDMAValues[0],
+            ADC1_DMA_start((uintptr_t) &DataBufferControl.DataBufferTempDMAValues[0],
                     MeasurementControl.MinMaxModeTempValuesSize,
                     true);
         } else {
-            ADC1_DMA_start((uint32_t) &DataBufferControl.DataBuffer[0], DATABUFFER_SIZE, false);
+            ADC1_DMA_start((uintptr_t) &DataBufferControl.DataBuffer[0], DATABUFFER_SIZE, false);
         }
     }
 }
@@ -530,7 +533,7 @@ void DMACheckForTriggerCondition(void) {
                 }
 
                 // restart DMA, leave ISR and wait for new interrupt
-                ADC1_DMA_start((uint32_t) &DataBufferControl.DataBuffer[0], DATABUFFER_SIZE, false);
+                ADC1_DMA_start((uintptr_t) &DataBufferControl.DataBuffer[0], DATABUFFER_SIZE, false);
                 // reset transfer complete status before return since this interrupt may happened and must be re enabled
                 __HAL_DMA_CLEAR_FLAG(ADC1Handle.DMA_Handle, DMA_FLAG_TC1);
                 //DMA_ClearITPendingBit (DMA1_IT_TC1);
@@ -547,6 +550,7 @@ void DMACheckForTriggerCondition(void) {
             }
         } while (true); // end with break above
 
+        TRACE_INSTANT(TRACE_ID_TRIGGER, tTriggerStatus == TRIGGER_OK);
         /*
          * set pointer for display of data
          */
@@ -612,6 +616,15 @@ extern "C" void DMAProcessMinMax(bool processFirstHalfOfBuffer) {
     }
 }
 
+#ifdef USE_DEFERRED_WORK
+/*
+ * Called by PendSV, since output of message takes milliseconds
+ */
+static void signalDMAError(uint32_t aPeripheralAddress) {
+    failParamMessage(aPeripheralAddress, "DMA Error");
+}
+#endif
+
 extern "C" void DMA1_Channel1_IRQHandler(void) {
 
     // Test on DMA Transfer Complete interrupt
@@ -620,6 +633,7 @@ extern "C" void DMA1_Channel1_IRQHandler(void) {
         /* Clear DMA  Transfer Complete interrupt pending bit */
         __HAL_DMA_CLEAR_FLAG(ADC1Handle.DMA_Handle, DMA_FLAG_TC1);
         //DMA_ClearITPendingBit(DMA1_IT_TC1);
+        TRACE_INSTANT(TRACE_ID_DMA_COMPLETE, MeasurementControl.isEffectiveMinMaxMode);
         if (MeasurementControl.isEffectiveMinMaxMode) {
             DMAProcessMinMax(false);
         } else {
@@ -634,7 +648,11 @@ extern "C" void DMA1_Channel1_IRQHandler(void) {
     }
     // Test on DMA Transfer Error interrupt
     if (__HAL_DMA_GET_FLAG(ADC1Handle.DMA_Handle, DMA_FLAG_TE1)) {
+#ifdef USE_DEFERRED_WORK
+        queueDeferredWork(DEFERRED_WORK_QUEUE_DSO, &signalDMAError, ADC1Handle.DMA_Handle->Instance->CPAR);
+#else
         failParamMessage(ADC1Handle.DMA_Handle->Instance->CPAR, "DMA Error");
+#endif
         __HAL_DMA_CLEAR_FLAG(ADC1Handle.DMA_Handle, DMA_FLAG_TE1);
 //        DMA_ClearITPendingBit(DMA1_IT_TE1);
     }
@@ -770,6 +788,7 @@ extern "C" void ADC1_2_IRQHandler(void) {
          * Here trigger just found or trigger timeout
          * reset trigger flag and initialize max and min and set data buffer
          */
+        TRACE_INSTANT(TRACE_ID_TRIGGER, tTriggerFound);
         MeasurementControl.TriggerActualPhase = PHASE_POST_TRIGGER;
         DataBufferControl.DataBufferPreTriggerNextPointer = tDataBufferPointer;
         /*
@@ -936,7 +955,8 @@ void computeMinMaxAverageAndPeriodFrequency(void) {
          * allow delta of periods to be at least 1/8 period + 3
          */
         tPeriodDelta = tPeriodMax - tPeriodMin;
-        if (((tLastFoundPosition / (8 * tCount)) + 3) < tPeriodDelta) {
+        // Cortex-M division by zero gives 0, the host traps
+        if (tCount != 0 && ((tLastFoundPosition / (8 * tCount)) + 3) < tPeriodDelta) {
             tReliableValue = false;
         }
 
@@ -17,6 +17,7 @@
 #include "BlueSerial.h"
 #include <string.h>
 #include "Chart.h" // for drawChartDataFloat()
+#include "EventTrace.h"
 
 /*****************************
  * Display stuff
@@ -123,7 +124,7 @@ void drawGridLinesWithHorizLabelsAndTriggerLine(Color_t aColor) {
         } else {
             tLabelColor = COLOR_HOR_GRID_LINE_LABEL_NEGATIVE;
         }
-        BlueDisplay1.drawText(tPosX, tYPos - tCaptionOffset, StringBuffer, TEXT_SIZE_11, tLabelColor,
+        BlueDisplay1.drawRegisteredText(tPosX, tYPos - tCaptionOffset, StringBuffer, TEXT_SIZE_11, tLabelColor,
         COLOR_BACKGROUND_DSO);
         tCaptionOffset = -(TEXT_SIZE_11_ASCEND / 2);
         tActualVoltage += ScaleVoltagePerDiv[MeasurementControl.DisplayRangeIndexForPrint];
@@ -163,6 +164,7 @@ void drawMinMaxLines(void) {
  */
 void drawDataBuffer(uint16_t *aDataBufferPointer, int aLength, Color_t aColor, Color_t aClearBeforeColor,
         int aDrawMode, bool aDrawAlsoMin) {
+    TRACE_SCOPE(TRACE_ID_DRAW_DATA_BUFFER, aLength);
     int i;
     int tValue;
 #ifdef LOCAL_DISPLAY_EXISTS
@@ -583,6 +585,9 @@ void printInfo(void) {
     if (DisplayControl.DisplayPage != CHART || DisplayControl.showInfoMode == INFO_MODE_NO_INFO) {
         return;
     }
+    TRACE_SCOPE(TRACE_ID_PRINT_INFO, 0);
+    // info is sent as replaceable stream, so only the newest info is sent if the Bluetooth link is saturated
+    BlueDisplay1.startReplaceableStream(SEND_STREAM_INFO);
 
 // compute value here, because min and max can have changed by completing another measurement,
 // while printing first line to screen
@@ -776,6 +781,7 @@ void printInfo(void) {
         BlueDisplay1.drawText(0, FONT_SIZE_INFO_SHORT_ASC, StringBuffer, FONT_SIZE_INFO_SHORT, COLOR_BLACK,
         COLOR_INFO_BACKGROUND);
     }
+    BlueDisplay1.endReplaceableStream();
 }
 
 /**
@@ -185,6 +185,9 @@ void redrawDisplay(bool doClearbefore);
 void redrawDisplay(void);
 void longTouchDownHandlerDSO(struct TouchEvent * const);
 void swipeEndHandlerDSO(struct Swipe * const aSwipeInfo);
+#ifndef DO_NOT_USE_KINETIC_SCROLL
+void scrollHandlerDSO(struct Scroll * const aScrollInfo);
+#endif
 void TouchUpHandler(struct TouchEvent * const aTochPosition);
 void doTriggerMode(BDButton * aTheTouchedButton, int16_t aValue);
 void doTriggerSlope(BDButton * aTheTouchedButton, int16_t aValue);
@@ -258,6 +261,7 @@ void startDSOPage(void) {
     resetAcquisition(); // sets MinMaxMode
 
 #ifdef LOCAL_DISPLAY_EXISTS
+    BDButton::startButtonPage();
     initDSOGUI();
     DisplayControl.drawPixelMode = false;
 #endif
@@ -277,6 +281,9 @@ void startDSOPage(void) {
     registerRedrawCallback(&redrawDisplay);
     registerLongTouchDownCallback(&longTouchDownHandlerDSO, TOUCH_STANDARD_LONG_TOUCH_TIMEOUT_MILLIS);
     registerSwipeEndCallback(&swipeEndHandlerDSO);
+#ifndef DO_NOT_USE_KINETIC_SCROLL
+    registerScrollCallback(&scrollHandlerDSO);
+#endif
 // use touch up for buttons in order not to interfere with long touch
     registerTouchUpCallback(&TouchUpHandler);
 
@@ -310,16 +317,14 @@ void stopDSOPage(void) {
 
     registerLongTouchDownCallback(NULL, 0);
     registerSwipeEndCallback(NULL);
+#ifndef DO_NOT_USE_KINETIC_SCROLL
+    registerScrollCallback(NULL);
+#endif
     registerTouchUpCallback(NULL);
 
 #ifdef LOCAL_DISPLAY_EXISTS
     // free buttons
-    for (unsigned int i = 0; i < sizeof(TouchButtonsDSO) / sizeof(TouchButtonsDSO[0]); ++i) {
-        (*TouchButtonsDSO[i]).deinit();
-    }
-    for (unsigned int i = 0; i < NUMBER_OF_CHANNEL_WITH_FIXED_ATTENUATOR; ++i) {
-        TouchButtonChannels[i].deinit();
-    }
+    BDButton::deinitAllButtonsOfPage();
     TouchSliderVoltagePicker.deinit();
     TouchSliderTriggerLevel.deinit();
     TouchSliderBacklight.deinit();
@@ -351,11 +356,13 @@ void loopDSOPage(void) {
 #ifdef LOCAL_DISPLAY_EXISTS
         if (MeasurementControl.ADS7846ChannelsAsDatasource) {
             readADS7846Channels();
+#ifdef DO_NOT_USE_BACKGROUND_TOUCH_SAMPLING
             // check if button pressed - to process stop and channel buttons here
             TouchPanel.rd_data();
             if (TouchPanel.mPressure > MIN_REASONABLE_PRESSURE) {
                 TouchButton::checkAllButtons(TouchPanel.getXActual(), TouchPanel.getYActual());
             }
+#endif
         }
 #endif
         if (DataBufferControl.DataBufferFull) {
@@ -623,12 +630,12 @@ int changeXScale(int aValue) {
 
 /**
  * set start of display in data buffer and draws data - only for analyze mode
- * @param aValue number of DisplayControl.DisplayIncrementPixel to scroll
+ * @param aNumberOfValues number of data buffer values to scroll
  */
-int scrollDisplay(int aValue) {
+static int scrollDisplayByValues(int aNumberOfValues) {
     uint8_t tFeedbackType = FEEDBACK_TONE_NO_ERROR;
     if (DisplayControl.DisplayPage == CHART) {
-        DataBufferControl.DataBufferDisplayStart += aValue * DisplayControl.DisplayIncrementPixel;
+        DataBufferControl.DataBufferDisplayStart += aNumberOfValues;
         // Check begin
         if ((DataBufferControl.DataBufferDisplayStart < &DataBufferControl.DataBuffer[0])) {
             DataBufferControl.DataBufferDisplayStart = &DataBufferControl.DataBuffer[0];
@@ -645,6 +652,13 @@ int scrollDisplay(int aValue) {
     return tFeedbackType;
 }
 
+/**
+ * @param aValue number of DisplayControl.DisplayIncrementPixel to scroll
+ */
+int scrollDisplay(int aValue) {
+    return scrollDisplayByValues(aValue * DisplayControl.DisplayIncrementPixel);
+}
+
 /************************************************************************
  * Callback handler section
  ************************************************************************/
@@ -768,7 +782,12 @@ void swipeEndHandlerDSO(struct Swipe * const aSwipeInfo) {
              * Analyze Mode
              */
             if (aSwipeInfo->TouchStartY > BUTTON_HEIGHT_4_LINE_3 + TEXT_SIZE_22) {
+#ifdef DO_NOT_USE_KINETIC_SCROLL
                 tFeedbackType = scrollDisplay(-tTouchDeltaXGrid);
+#else
+                // already scrolled by scrollHandlerDSO()
+                return;
+#endif
             } else {
                 // scale
                 if (tDeltaGreaterThanOneGrid) {
@@ -784,6 +803,38 @@ void swipeEndHandlerDSO(struct Swipe * const aSwipeInfo) {
     }
 }
 
+#ifndef DO_NOT_USE_KINETIC_SCROLL
+/**
+ * Scrolls the data buffer while dragging and after touch up - only for analyze mode below the scale swipe area.
+ * Like the swipe, a finger movement of one grid scrolls DisplayControl.DisplayIncrementPixel values.
+ * Other drags are stopped here and handled as swipe at touch up.
+ */
+void scrollHandlerDSO(struct Scroll * const aScrollInfo) {
+    static int sNotScrolledValuesTimesGrid = 0;
+    if (DisplayControl.DisplayPage != CHART || MeasurementControl.isRunning
+            || aScrollInfo->TouchStartY <= BUTTON_HEIGHT_4_LINE_3 + TEXT_SIZE_22) {
+        stopScroll();
+        return;
+    }
+    sNotScrolledValuesTimesGrid -= aScrollInfo->DeltaX * DisplayControl.DisplayIncrementPixel;
+    int tNumberOfValues = sNotScrolledValuesTimesGrid / TIMING_GRID_WIDTH;
+    sNotScrolledValuesTimesGrid -= tNumberOfValues * TIMING_GRID_WIDTH;
+    if (aScrollInfo->IsLast) {
+        sNotScrolledValuesTimesGrid = 0;
+    }
+    if (tNumberOfValues != 0 && scrollDisplayByValues(tNumberOfValues) != FEEDBACK_TONE_NO_ERROR) {
+        // start or end of data buffer reached
+        stopScroll();
+        sNotScrolledValuesTimesGrid = 0;
+#ifdef LOCAL_DISPLAY_EXISTS
+        FeedbackTone(FEEDBACK_TONE_SHORT_ERROR);
+#else
+        BlueDisplay1.playFeedbackTone(FEEDBACK_TONE_SHORT_ERROR);
+#endif
+    }
+}
+#endif
+
 /************************************************************************
  * Button handler section
  ************************************************************************/
@@ -1599,9 +1650,9 @@ void drawAnalysisOnlyPartOfGui(void) {
     TouchButtonLoad.drawButton();
 #endif
 
-    BlueDisplay1.drawText(BUTTON_WIDTH_3, BUTTON_HEIGHT_4_LINE_3 - BUTTON_DEFAULT_SPACING + TEXT_SIZE_22_ASCEND, "\xABScale\xBB",
+    BlueDisplay1.drawRegisteredText(BUTTON_WIDTH_3, BUTTON_HEIGHT_4_LINE_3 - BUTTON_DEFAULT_SPACING + TEXT_SIZE_22_ASCEND, "\xABScale\xBB",
     TEXT_SIZE_22, COLOR_YELLOW, COLOR_BACKGROUND_DSO);
-    BlueDisplay1.drawText(BUTTON_WIDTH_3, BUTTON_HEIGHT_4_LINE_4 + BUTTON_DEFAULT_SPACING + TEXT_SIZE_22_ASCEND, "\xABScroll\xBB",
+    BlueDisplay1.drawRegisteredText(BUTTON_WIDTH_3, BUTTON_HEIGHT_4_LINE_4 + BUTTON_DEFAULT_SPACING + TEXT_SIZE_22_ASCEND, "\xABScroll\xBB",
     TEXT_SIZE_22, COLOR_GREEN, COLOR_BACKGROUND_DSO);
 }
 
@@ -1618,7 +1669,7 @@ void drawRunningOnlyPartOfGui(void) {
         BlueDisplay1.drawMLText(TEXT_SIZE_11_WIDTH, TEXT_SIZE_11_HEIGHT + TEXT_SIZE_22_ASCEND, "\xD4\nR\na\nn\ng\ne\n\xD5",
         TEXT_SIZE_22, COLOR_GUI_TRIGGER, COLOR_NO_BACKGROUND);
 #else
-        BlueDisplay1.drawText(TEXT_SIZE_11_WIDTH, TEXT_SIZE_11_HEIGHT + TEXT_SIZE_22_ASCEND,
+        BlueDisplay1.drawRegisteredText(TEXT_SIZE_11_WIDTH, TEXT_SIZE_11_HEIGHT + TEXT_SIZE_22_ASCEND,
                 "\xD4\nR\na\nn\ng\ne\n\xD5",
                 TEXT_SIZE_22, COLOR_GUI_TRIGGER, COLOR_NO_BACKGROUND);
 #endif
@@ -1629,12 +1680,12 @@ void drawRunningOnlyPartOfGui(void) {
         BlueDisplay1.drawMLText(BUTTON_WIDTH_3_POS_3 - TEXT_SIZE_22_WIDTH, TEXT_SIZE_11_HEIGHT + TEXT_SIZE_22_ASCEND,
                 "\xD4\nO\nf\nf\ns\ne\nt\n\xD5", TEXT_SIZE_22, COLOR_GUI_TRIGGER, COLOR_NO_BACKGROUND);
 #else
-        BlueDisplay1.drawText(BUTTON_WIDTH_3_POS_3 - TEXT_SIZE_22_WIDTH, TEXT_SIZE_11_HEIGHT + TEXT_SIZE_22_ASCEND,
+        BlueDisplay1.drawRegisteredText(BUTTON_WIDTH_3_POS_3 - TEXT_SIZE_22_WIDTH, TEXT_SIZE_11_HEIGHT + TEXT_SIZE_22_ASCEND,
                 "\xD4\nO\nf\nf\ns\ne\nt\n\xD5", TEXT_SIZE_22, COLOR_GUI_TRIGGER, COLOR_NO_BACKGROUND);
 #endif
     }
 
-    BlueDisplay1.drawText(BUTTON_WIDTH_8, BUTTON_HEIGHT_4_LINE_4 - TEXT_SIZE_22_DECEND, "\xABTimeBase\xBB",
+    BlueDisplay1.drawRegisteredText(BUTTON_WIDTH_8, BUTTON_HEIGHT_4_LINE_4 - TEXT_SIZE_22_DECEND, "\xABTimeBase\xBB",
     TEXT_SIZE_22,
     COLOR_GUI_SOURCE_TIMEBASE, COLOR_BACKGROUND_DSO);
 
@@ -13,6 +13,8 @@
 #include "Pages.h"
 #include "stm32f3DiscoveryLedsButtons.h"
 #include "stm32f3DiscoPeripherals.h"
+#include "DeferredWork.h"
+#include "EventTrace.h"
 
 extern "C" {
 #include "stm32f3_discovery.h"
@@ -70,6 +72,14 @@ int main(void) {
 
     // sets systic prio to 8
     NVIC_SetPriority(SysTick_IRQn, SYS_TICK_INTERRUPT_PRIO);
+#ifdef USE_DEFERRED_WORK
+    // sets PendSV prio to 15
+    initDeferredWork();
+#endif
+#ifdef USE_EVENT_TRACE
+    // enables DWT cycle counter
+    initEventTrace();
+#endif
 
     initializeLEDs();
     BSP_LED_On(LED_RED);
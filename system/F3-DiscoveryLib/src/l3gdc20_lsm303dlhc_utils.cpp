@@ -11,6 +11,7 @@
 #include "timing.h"
 #include "l3gdc20_lsm303dlhc_utils.h"
 #include "stm32f3DiscoPeripherals.h"
+#include "stm32fx0xPeripherals.h" // for SPI1Busy
 
 extern "C" {
 #include "stm32f3_discovery_accelerometer.h"
@@ -33,8 +34,17 @@ void readAccelerometerZeroCompensated(int16_t * aAccelerometerRawData) {
     aAccelerometerRawData[2] -= AccelerometerZeroCompensation[2];
 }
 
-void readGyroscopeZeroCompensated(float aGyroscopeRawData[]) {
+/*
+ * The gyroscope shares SPI1 with the touch panel and SD card
+ */
+static void readGyroscope(float aGyroscopeRawData[]) {
+    SPI1Busy = true;
     BSP_GYRO_GetXYZ(aGyroscopeRawData);
+    SPI1Busy = false;
+}
+
+void readGyroscopeZeroCompensated(float aGyroscopeRawData[]) {
+    readGyroscope(aGyroscopeRawData);
     aGyroscopeRawData[0] -= GyroscopeZeroCompensation[0];
     aGyroscopeRawData[1] -= GyroscopeZeroCompensation[1];
     aGyroscopeRawData[2] -= GyroscopeZeroCompensation[2];
@@ -58,7 +68,7 @@ void setZeroAccelerometerGyroValue(void) {
         AccelerometerZeroCompensation[1] += AccelerometerCompassRawDataBuffer[1];
         AccelerometerZeroCompensation[2] += AccelerometerCompassRawDataBuffer[2];
         // Gyroscope
-        BSP_GYRO_GetXYZ(GyroscopeRawDataBuffer);
+        readGyroscope(GyroscopeRawDataBuffer);
         GyroscopeZeroCompensation[0] += GyroscopeRawDataBuffer[0];
         GyroscopeZeroCompensation[1] += GyroscopeRawDataBuffer[1];
         GyroscopeZeroCompensation[2] += GyroscopeRawDataBuffer[2];
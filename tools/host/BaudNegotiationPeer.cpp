@@ -0,0 +1,283 @@
+/**
+ * @file BaudNegotiationPeer.cpp
+ *
+ * Host test for negotiateUSARTBaudRate().
+ * A forked process acts as the remote side on the slave of a Linux pty.
+ * It answers FUNCTION_BAUD_NEGOTIATION and FUNCTION_BAUD_TEST_PATTERN and sets the requested baud rate with tcsetattr(),
+ * so it accepts only rates which have a termios speed constant.
+ * The local side is BlueSerial.cpp with the simulated link of BlueSerial_Host.cpp, which writes to and reads from the pty master.
+ *
+ * The line between both is modeled by the sender: data sent while the baud rates of both sides differ is garbled,
+ * data sent with more than the clean maximum baud rate of the scenario gets bit errors.
+ * Each sender is paced to its baud rate, so the measured throughput is realistic.
+ * Prints the negotiated baud rate, effective throughput, fallbacks and rejected rates for some scenarios
+ * and checks that the link works after negotiation.
+ *
+ * Build on x86 Linux from project root with: make -C tools/host build/BaudNegotiationPeer
+ * and run it with: tools/host/build/BaudNegotiationPeer
+ *
+ * Only compiled if HOST_SIMULATION is defined.
+ *
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ */
+
+#ifdef HOST_SIMULATION
+
+#include "BlueDisplay.h"
+#include "HostSupport.h"
+#include "timing.h"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+const unsigned int REMOTE_DISPLAY_HEIGHT = 240;
+const unsigned int REMOTE_DISPLAY_WIDTH = 320;
+
+#define BIT_ERROR_INTERVAL 61 // every n-th byte has a bit error if sent above the clean maximum baud rate
+
+/*
+ * Actual baud rates of both sides, shared between the processes
+ */
+struct LineState {
+    volatile uint32_t LocalBaudRate;
+    volatile uint32_t RemoteBaudRate;
+    uint32_t CleanMaxBaudRate;
+};
+static struct LineState * sLine;
+static int sMasterFd;
+
+/**
+ * Emulates the transmission of aData with aSenderBaudRate to a receiver with aReceiverBaudRate
+ */
+static void writeToLine(int aFd, const uint8_t * aData, size_t aLength, uint32_t aSenderBaudRate,
+        uint32_t aReceiverBaudRate) {
+    std::vector<uint8_t> tLineData(aData, aData + aLength);
+    for (size_t i = 0; i < aLength; ++i) {
+        if (aSenderBaudRate != aReceiverBaudRate) {
+            // receiver samples at the wrong bit times
+            tLineData[i] = (tLineData[i] * 7) ^ 0x3C;
+        } else if (aSenderBaudRate > sLine->CleanMaxBaudRate && i % BIT_ERROR_INTERVAL == BIT_ERROR_INTERVAL - 1) {
+            tLineData[i] ^= 0x10;
+        }
+    }
+    size_t tWritten = 0;
+    while (tWritten < aLength) {
+        ssize_t tResult = write(aFd, &tLineData[tWritten], aLength - tWritten);
+        if (tResult <= 0) {
+            return;
+        }
+        tWritten += tResult;
+    }
+    // time on the line
+    uint64_t tLineNanos = ((uint64_t) aLength * 10 * 1000000000) / aSenderBaudRate;
+    struct timespec tTime = { (time_t) (tLineNanos / 1000000000), (long) (tLineNanos % 1000000000) };
+    nanosleep(&tTime, NULL);
+}
+
+/*
+ * Remote side
+ */
+static speed_t getSpeedConstant(uint32_t aBaudRate) {
+    switch (aBaudRate) {
+    case BAUD_115200:
+        return B115200;
+    case BAUD_230400:
+        return B230400;
+    case BAUD_460800:
+        return B460800;
+    case BAUD_921600:
+        return B921600;
+    default:
+        return B0; // no termios constant e.g. for 1382400
+    }
+}
+
+static void setRemoteBaudRate(int aFd, uint32_t aBaudRate) {
+    struct termios tTermios;
+    tcgetattr(aFd, &tTermios);
+    cfsetspeed(&tTermios, getSpeedConstant(aBaudRate));
+    tcsetattr(aFd, TCSANOW, &tTermios);
+    sLine->RemoteBaudRate = aBaudRate;
+}
+
+static void sendAnswer(int aFd, uint16_t aSubFunction, uint16_t aValue, uint32_t aBaudRate) {
+    struct BaudNegotiationInfo tInfo = { aSubFunction, aValue, aBaudRate };
+    uint8_t tMessage[3 + sizeof(tInfo)];
+    tMessage[0] = sizeof(tMessage);
+    tMessage[1] = EVENT_BAUD_NEGOTIATION;
+    memcpy(&tMessage[2], &tInfo, sizeof(tInfo));
+    tMessage[sizeof(tMessage) - 1] = SYNC_TOKEN;
+    writeToLine(aFd, tMessage, sizeof(tMessage), sLine->RemoteBaudRate, sLine->LocalBaudRate);
+}
+
+static uint16_t getShort(const uint8_t * aPointer) {
+    return aPointer[0] | (aPointer[1] << 8);
+}
+
+/**
+ * Main loop of the remote process. Never returns.
+ * @param aSupportsNegotiation if false, all commands are ignored like an old BlueDisplay app does
+ */
+static void runRemote(const char * aSlaveName, bool aSupportsNegotiation) {
+    int tFd = open(aSlaveName, O_RDWR | O_NOCTTY);
+    struct termios tTermios;
+    tcgetattr(tFd, &tTermios);
+    cfmakeraw(&tTermios);
+    tcsetattr(tFd, TCSANOW, &tTermios);
+    setRemoteBaudRate(tFd, BAUD_115200);
+
+    std::vector<uint8_t> tReceived;
+    uint32_t tOldBaudRate = 0; // != 0 -> switched and not yet confirmed
+    uint32_t tSwitchMillis = 0;
+    while (true) {
+        struct pollfd tPollFd = { tFd, POLLIN, 0 };
+        if (poll(&tPollFd, 1, 10) > 0) {
+            uint8_t tBuffer[1024];
+            ssize_t tLength = read(tFd, tBuffer, sizeof(tBuffer));
+            if (tLength > 0) {
+                tReceived.insert(tReceived.end(), tBuffer, tBuffer + tLength);
+            }
+        }
+        if (tOldBaudRate != 0 && getMillisSinceBoot() - tSwitchMillis > BAUD_NEGOTIATION_REVERT_MILLIS) {
+            setRemoteBaudRate(tFd, tOldBaudRate);
+            tOldBaudRate = 0;
+        }
+
+        /*
+         * Parse commands
+         */
+        size_t tPosition = 0;
+        while (tPosition + 4 <= tReceived.size()) {
+            const uint8_t * tCommand = &tReceived[tPosition];
+            if (tCommand[0] != SYNC_TOKEN) {
+                tPosition++; // resynchronize
+                continue;
+            }
+            uint8_t tFunctionTag = tCommand[1];
+            size_t tCommandLength = 4 + getShort(&tCommand[2]);
+            const uint8_t * tData = NULL;
+            uint16_t tDataLength = 0;
+            if (tFunctionTag > INDEX_LAST_FUNCTION_WITHOUT_DATA) {
+                if (tPosition + tCommandLength + 4 > tReceived.size()) {
+                    break;
+                }
+                if (tCommand[tCommandLength] != SYNC_TOKEN || tCommand[tCommandLength + 1] != DATAFIELD_TAG_BYTE) {
+                    tPosition++;
+                    continue;
+                }
+                tData = tCommand + tCommandLength + 4;
+                tDataLength = getShort(tCommand + tCommandLength + 2);
+                tCommandLength += 4 + tDataLength;
+            }
+            if (tPosition + tCommandLength > tReceived.size()) {
+                break;
+            }
+            tPosition += tCommandLength;
+            if (!aSupportsNegotiation) {
+                continue;
+            }
+
+            if (tFunctionTag == FUNCTION_BAUD_NEGOTIATION && getShort(&tCommand[2]) >= 2) {
+                uint16_t tSubFunction = getShort(&tCommand[4]);
+                if (tSubFunction == SUBFUNCTION_BAUD_PROPOSE && getShort(&tCommand[2]) == 6) {
+                    uint32_t tBaudRate = getShort(&tCommand[6]) | (getShort(&tCommand[8]) << 16);
+                    if (tOldBaudRate == 0 && getSpeedConstant(tBaudRate) != B0) {
+                        sendAnswer(tFd, SUBFUNCTION_BAUD_PROPOSE, 1, tBaudRate);
+                        tOldBaudRate = sLine->RemoteBaudRate;
+                        tSwitchMillis = getMillisSinceBoot();
+                        setRemoteBaudRate(tFd, tBaudRate);
+                    } else {
+                        sendAnswer(tFd, SUBFUNCTION_BAUD_PROPOSE, 0, tBaudRate);
+                    }
+                } else if (tSubFunction == SUBFUNCTION_BAUD_CONFIRM) {
+                    tOldBaudRate = 0;
+                    sendAnswer(tFd, SUBFUNCTION_BAUD_CONFIRM, 1, sLine->RemoteBaudRate);
+                }
+            } else if (tFunctionTag == FUNCTION_BAUD_TEST_PATTERN) {
+                sendAnswer(tFd, SUBFUNCTION_BAUD_TEST_PATTERN, computeCRC16CCITT(tData, tDataLength), tDataLength);
+            }
+        }
+        tReceived.erase(tReceived.begin(), tReceived.begin() + tPosition);
+    }
+}
+
+/*
+ * Local side
+ */
+static void writeLocalData(const uint8_t * aData, size_t aLength) {
+    sLine->LocalBaudRate = getUSART_BD_BaudRate();
+    writeToLine(sMasterFd, aData, aLength, sLine->LocalBaudRate, sLine->RemoteBaudRate);
+}
+
+static void readRemoteData(void) {
+    sLine->LocalBaudRate = getUSART_BD_BaudRate();
+    struct pollfd tPollFd = { sMasterFd, POLLIN, 0 };
+    if (poll(&tPollFd, 1, 1) > 0) {
+        uint8_t tBuffer[256];
+        ssize_t tLength = read(sMasterFd, tBuffer, sizeof(tBuffer));
+        if (tLength > 0) {
+            hostReceiveBytes(tBuffer, tLength);
+        }
+    }
+}
+
+static void runScenario(const char * aName, uint32_t aCleanMaxBaudRate, bool aSupportsNegotiation,
+        uint32_t aExpectedBaudRate) {
+    sLine->LocalBaudRate = BAUD_115200;
+    sLine->RemoteBaudRate = BAUD_115200;
+    sLine->CleanMaxBaudRate = aCleanMaxBaudRate;
+
+    sMasterFd = posix_openpt(O_RDWR | O_NOCTTY);
+    grantpt(sMasterFd);
+    unlockpt(sMasterFd);
+    pid_t tRemotePid = fork();
+    if (tRemotePid == 0) {
+        runRemote(ptsname(sMasterFd), aSupportsNegotiation);
+    }
+    // wait for remote to configure the pty
+    delayMillis(50);
+
+    UART_BD_initialize(BAUD_115200);
+    hostResetLinkCounters();
+    uint32_t tStartMillis = getMillisSinceBoot();
+    uint32_t tBaudRate = negotiateUSARTBaudRate(BAUD_NEGOTIATION_MAX_BAUD_RATE);
+    uint32_t tNegotiationMillis = getMillisSinceBoot() - tStartMillis;
+    // link must work after negotiation, and both sides must use the same baud rate after the remote revert timeout
+    delayMillis(BAUD_NEGOTIATION_REVERT_MILLIS);
+    bool tLinkOK = !aSupportsNegotiation || (measureUSARTThroughput() > 0 && sLine->RemoteBaudRate == tBaudRate);
+
+    printf("%-34s: %7u baud %6u byte/s fallbacks %u rejected %u, %4u ms, link %s %s\n", aName, tBaudRate,
+            BaudNegotiationStatistics.BytesPerSecond, BaudNegotiationStatistics.Fallbacks,
+            BaudNegotiationStatistics.Rejected, tNegotiationMillis, tLinkOK ? "OK" : "BROKEN",
+            tBaudRate == aExpectedBaudRate ? "" : "UNEXPECTED BAUD RATE");
+
+    kill(tRemotePid, SIGTERM);
+    waitpid(tRemotePid, NULL, 0);
+    close(sMasterFd);
+}
+
+int main(void) {
+    sLine = (struct LineState *) mmap(NULL, sizeof(struct LineState), PROT_READ | PROT_WRITE,
+    MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    HostBluetoothPaired = true;
+    HostLinkWriteCallback = &writeLocalData;
+    HostLinkReadCallback = &readRemoteData;
+
+    runScenario("USB serial adapter", BAUD_1382400, true, BAUD_921600);
+    runScenario("line errors above 230400", BAUD_230400, true, BAUD_230400);
+    runScenario("line errors above 115200", BAUD_115200, true, BAUD_115200);
+    runScenario("remote without negotiation support", BAUD_1382400, false, BAUD_115200);
+    return 0;
+}
+
+#endif // HOST_SIMULATION
@@ -0,0 +1,127 @@
+/**
+ * @file BenchmarkSuite.cpp
+ *
+ * Host build of the BlueDisplay and signal benchmarks of Benchmark.cpp, which are also run by the benchmark page
+ * of the firmware. The signal benchmarks are plain C versions of the DSO trigger scan and min/max loops.
+ * The benchmarks of FFT, DSO trigger scan and min/max, SD card and UART need the hardware,
+ * are only in src/PageBenchmark.cpp and are marked as target only in its CSV.
+ *
+ * Runs the suite RUNS times and checks that the medians are reproducible, i.e. differ less than
+ * MAX_MEDIAN_DEVIATION_PERCENT plus the host clock resolution between the runs.
+ * The CSV of the last run is printed or written to the file given as first argument. Compare it with the one of an older version to find regressions.
+ * Host cycles are host nanoseconds scaled to 72 MHz, so only host results should be compared with each other.
+ *
+ * Build on x86 Linux from project root with: make -C tools/host build/BenchmarkSuite
+ * and run it with: tools/host/build/BenchmarkSuite
+ *
+ * Only compiled if HOST_SIMULATION is defined.
+ *
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ */
+
+#ifdef HOST_SIMULATION
+
+#include "BlueDisplay.h"
+#include "BlueSerial.h"
+#include "Benchmark.h"
+#include "HostSupport.h"
+
+#include <stdio.h>
+#include <string.h>
+
+const unsigned int REMOTE_DISPLAY_HEIGHT = 240;
+const unsigned int REMOTE_DISPLAY_WIDTH = 320;
+
+#define RUNS 3
+// host scheduling adds jitter, so the limit is much higher than needed on the target
+#define MAX_MEDIAN_DEVIATION_PERCENT 50
+// resolution of reading the host clock, app. 50 ns
+#define HOST_CLOCK_RESOLUTION_CYCLES 4
+
+#define NUMBER_OF_HOST_BENCHMARKS (NUMBER_OF_DISPLAY_BENCHMARKS + NUMBER_OF_SIGNAL_BENCHMARKS)
+
+static struct BenchmarkResult sResults[RUNS][NUMBER_OF_HOST_BENCHMARKS];
+static FILE * sCSVFile;
+
+static void writeToCSVFile(const char * aText, int aLength) {
+    fwrite(aText, 1, aLength, sCSVFile);
+}
+
+static bool sAllChecksPassed = true;
+
+static void check(bool aCondition, const char * aMessage) {
+    if (!aCondition) {
+        printf("FAILED: %s\n", aMessage);
+        sAllChecksPassed = false;
+    }
+}
+
+int main(int argc, char * argv[]) {
+    HostBluetoothPaired = true;
+    UART_BD_initialize(115200);
+
+    for (int tRun = 0; tRun < RUNS; ++tRun) {
+        for (int i = 0; i < NUMBER_OF_DISPLAY_BENCHMARKS; ++i) {
+            runBenchmark(&DisplayBenchmarks[i], &sResults[tRun][i]);
+        }
+        for (int i = 0; i < NUMBER_OF_SIGNAL_BENCHMARKS; ++i) {
+            runBenchmark(&SignalBenchmarks[i], &sResults[tRun][NUMBER_OF_DISPLAY_BENCHMARKS + i]);
+        }
+    }
+    hostFlushLink();
+    printf("%lu bytes sent in %d runs\n", (unsigned long) HostLinkCounters.Bytes, RUNS);
+    check(HostLinkCounters.Bytes > 0, "no BlueDisplay commands sent");
+
+    for (int i = 0; i < NUMBER_OF_HOST_BENCHMARKS; ++i) {
+        uint32_t tMin = sResults[0][i].MedianCycles;
+        uint32_t tMax = tMin;
+        for (int tRun = 1; tRun < RUNS; ++tRun) {
+            uint32_t tMedian = sResults[tRun][i].MedianCycles;
+            tMin = (tMedian < tMin) ? tMedian : tMin;
+            tMax = (tMedian > tMax) ? tMedian : tMax;
+        }
+        char tLine[64];
+        formatBenchmarkResult(tLine, sizeof(tLine), &sResults[RUNS - 1][i]);
+        printf("%s median of runs %lu to %lu cycles\n", tLine, (unsigned long) tMin, (unsigned long) tMax);
+        check(sResults[RUNS - 1][i].MinCycles <= sResults[RUNS - 1][i].MedianCycles
+                && sResults[RUNS - 1][i].MedianCycles <= sResults[RUNS - 1][i].MaxCycles, "min <= median <= max");
+        check(tMax - tMin <= HOST_CLOCK_RESOLUTION_CYCLES + (uint64_t) tMin * MAX_MEDIAN_DEVIATION_PERCENT / 100,
+                "median not reproducible");
+        check(!sResults[RUNS - 1][i].TargetOnly, "host benchmark marked as target only");
+    }
+
+    /*
+     * CSV must have comment line, header line and one line per benchmark
+     */
+    char tCSV[1024];
+    sCSVFile = fmemopen(tCSV, sizeof(tCSV), "w");
+    writeBenchmarkCSV(sResults[RUNS - 1], NUMBER_OF_HOST_BENCHMARKS, "host", &writeToCSVFile);
+    fclose(sCSVFile);
+    int tLines = 0;
+    for (char * tChar = tCSV; *tChar != '\0'; ++tChar) {
+        tLines += (*tChar == '\n');
+    }
+    check(strncmp(tCSV, "# benchmark host 72000000\nname,iterations,", 42) == 0, "wrong CSV header");
+    check(tLines == NUMBER_OF_HOST_BENCHMARKS + 2, "wrong number of CSV lines");
+    check(strstr(tCSV, ",kbyte/s,target only\nfillRect,") != NULL, "wrong CSV header");
+    check(strstr(tCSV, ",1\n") == NULL, "host CSV line marked as target only");
+
+    sCSVFile = stdout;
+    if (argc > 1) {
+        sCSVFile = fopen(argv[1], "w");
+        if (sCSVFile == NULL) {
+            perror(argv[1]);
+            return 1;
+        }
+    }
+    writeBenchmarkCSV(sResults[RUNS - 1], NUMBER_OF_HOST_BENCHMARKS, "host", &writeToCSVFile);
+    if (argc > 1) {
+        fclose(sCSVFile);
+        printf("CSV written to %s\n", argv[1]);
+    }
+
+    printf("all checks %s\n", sAllChecksPassed ? "passed" : "FAILED");
+    return sAllChecksPassed ? 0 : 1;
+}
+
+#endif // HOST_SIMULATION
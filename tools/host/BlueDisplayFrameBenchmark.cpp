@@ -0,0 +1,113 @@
+/**
+ * @file BlueDisplayFrameBenchmark.cpp
+ *
+ * Host benchmark for BlueDisplay command throughput with and without startFrame()/endFrame() batching.
+ * Sends a typical page of small draw commands over the simulated link of BlueSerial_Host.cpp
+ * and prints DMA transfers, commands/s and bytes/s for 115200 and 921600 baud.
+ * Commands are generated back to back (3 us CPU time each) and interleaved with computation (500 us each).
+ * Back to back the link is the bottleneck and the transfer complete ISR already chains all buffered commands,
+ * so frames mainly help if computation is interleaved, where each command would otherwise get its own transfer.
+ * Inside a frame a transfer is started every SEND_FRAME_FLUSH_THRESHOLD bytes, so sending overlaps computation
+ * and frames must not lower the throughput.
+ *
+ * Build on x86 Linux from project root with: make -C tools/host build/BlueDisplayFrameBenchmark
+ * and run it with: tools/host/build/BlueDisplayFrameBenchmark
+ *
+ * Only compiled if HOST_SIMULATION is defined.
+ *
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ */
+
+#ifdef HOST_SIMULATION
+
+#include "BlueDisplay.h"
+#include "HostSupport.h"
+
+#include <stdio.h>
+
+#define NUMBER_OF_PAGES 100
+// Time the F303 needs to compute and marshal one draw command
+#define CPU_NANOS_PER_COMMAND 3000
+// Time for command including computation of values to draw
+#define CPU_NANOS_PER_COMMAND_INTERLEAVED 500000
+
+const unsigned int REMOTE_DISPLAY_HEIGHT = 240;
+const unsigned int REMOTE_DISPLAY_WIDTH = 320;
+
+static uint32_t sCommandCount;
+static uint32_t sCPUNanosPerCommand;
+
+static void drawPage(void) {
+    BlueDisplay1.clearDisplay(COLOR_WHITE);
+    hostAdvanceLinkTime(sCPUNanosPerCommand);
+    sCommandCount++;
+    for (int i = 0; i < 20; ++i) {
+        BlueDisplay1.fillRectRel(i * 16, 0, 14, 20, COLOR_BLUE);
+        hostAdvanceLinkTime(sCPUNanosPerCommand);
+        BlueDisplay1.drawText(i * 16, 40, "12.5V", 11, COLOR_BLACK, COLOR_WHITE);
+        hostAdvanceLinkTime(sCPUNanosPerCommand);
+        BlueDisplay1.drawLine(i * 16, 60, i * 16 + 10, 200, COLOR_RED);
+        hostAdvanceLinkTime(sCPUNanosPerCommand);
+        BlueDisplay1.drawPixel(i * 16, 220, COLOR_GREEN);
+        hostAdvanceLinkTime(sCPUNanosPerCommand);
+        sCommandCount += 4;
+    }
+}
+
+/*
+ * @return commands/s
+ */
+static double runBenchmark(uint32_t aBaudRate, uint32_t aCPUNanosPerCommand, bool aUseFrames) {
+    sCPUNanosPerCommand = aCPUNanosPerCommand;
+    UART_BD_initialize(aBaudRate);
+    hostResetLinkCounters();
+    sCommandCount = 0;
+
+    uint64_t tHostStart = getHostNanos();
+    for (int i = 0; i < NUMBER_OF_PAGES; ++i) {
+        if (aUseFrames) {
+            BlueDisplay1.startFrame();
+            drawPage();
+            BlueDisplay1.endFrame();
+        } else {
+            drawPage();
+        }
+    }
+    uint64_t tHostNanos = getHostNanos() - tHostStart;
+    hostFlushLink();
+
+    double tSeconds = HostLinkNanos / 1e9;
+    printf("%7u baud %3u us/command %-9s: %5.1f transfers/page %8.0f commands/s %8.0f bytes/s %5u blocking waits %6.1f ms/page (host %4.0f ns/command)\n",
+            aBaudRate, aCPUNanosPerCommand / 1000, aUseFrames ? "frames" : "immediate", (double) HostLinkCounters.Transfers / NUMBER_OF_PAGES,
+            sCommandCount / tSeconds, HostLinkCounters.Bytes / tSeconds, HostLinkCounters.BlockingWaits,
+            tSeconds * 1000 / NUMBER_OF_PAGES, (double) tHostNanos / sCommandCount);
+    return sCommandCount / tSeconds;
+}
+
+static bool sAllChecksPassed = true;
+
+static void check(bool aCondition, const char * aMessage) {
+    if (!aCondition) {
+        printf("FAILED: %s\n", aMessage);
+        sAllChecksPassed = false;
+    }
+}
+
+int main(void) {
+    HostBluetoothPaired = true;
+    printf("%d pages of 81 commands, %u ns overhead per transfer\n", NUMBER_OF_PAGES, HostLinkTransferOverheadNanos);
+    uint32_t tBaudRates[] = { BAUD_115200, BAUD_921600 };
+    uint32_t tCPUNanos[] = { CPU_NANOS_PER_COMMAND, CPU_NANOS_PER_COMMAND_INTERLEAVED };
+    for (unsigned int i = 0; i < sizeof(tBaudRates) / sizeof(tBaudRates[0]); ++i) {
+        for (unsigned int j = 0; j < sizeof(tCPUNanos) / sizeof(tCPUNanos[0]); ++j) {
+            double tImmediateCommandsPerSecond = runBenchmark(tBaudRates[i], tCPUNanos[j], false);
+            double tFrameCommandsPerSecond = runBenchmark(tBaudRates[i], tCPUNanos[j], true);
+            // last transfer of a page is not overlapped
+            check(tFrameCommandsPerSecond >= tImmediateCommandsPerSecond * 0.99, "frames lower throughput");
+        }
+    }
+    printf("all checks %s\n", sAllChecksPassed ? "passed" : "FAILED");
+    return sAllChecksPassed ? 0 : 1;
+}
+
+#endif // HOST_SIMULATION
@@ -0,0 +1,1277 @@
+/**
+ * @file BlueDisplaySimulator.cpp
+ *
+ * Host simulator of the BlueDisplay app on a Linux pseudo terminal.
+ * Opens a pty, prints the name of its slave device and acts as the remote side of BlueDisplayProtocol.h.
+ * Drawing, text, chart, button and slider commands are rendered into an RGB565 frame buffer
+ * which can be saved as PPM image. Touch, button and slider events can be injected by commands.
+ * For each function tag the number of commands, the bytes on the line, the render time
+ * and the mean interval between commands are logged.
+ *
+ * Clients are a host build of an application, which uses the slave as its link,
+ * or a real board, which is connected by e.g. "socat /dev/ttyUSB0,raw,b115200 /dev/pts/<n>,raw".
+ *
+ * Usage: BlueDisplaySimulator [-d <width>x<height>] [-l <link name>] [-o <ppm file>] [<command file>]
+ *  -d sets the display size sent with EVENT_CONNECTION_BUILD_UP. Default is 320x240.
+ *  -l creates a symbolic link to the slave device e.g. /tmp/ttyBlueDisplay.
+ *  -o saves the display content at exit.
+ *  Commands are read from the command file or from stdin, one per line. Type "help" for a list.
+ *  The simulator exits at the end of the command input.
+ *
+ * Callbacks are sent with the 32 bit handler address layout of struct GuiCallback on the STM32,
+ * i.e. the handler is the address the client sent with FUNCTION_BUTTON_CREATE or FUNCTION_SLIDER_CREATE.
+ * Therefore 64 bit host builds of a client receive the callback events, but cannot dispatch them.
+ *
+ * Build on x86 Linux from project root with: make -C tools/host build/BlueDisplaySimulator
+ * and run it with: tools/host/build/BlueDisplaySimulator
+ *
+ * Only compiled if HOST_SIMULATION is defined.
+ *
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ */
+
+#ifdef HOST_SIMULATION
+
+#include "BlueDisplay.h"
+#include "ChartDelta.h"
+#include "StringTable.h"
+#include "HostSupport.h"
+#include "fonts.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+
+// Only required for linking BlueDisplay.cpp
+const unsigned int REMOTE_DISPLAY_HEIGHT = 240;
+const unsigned int REMOTE_DISPLAY_WIDTH = 320;
+
+#define NUMBER_OF_CHARTS 16 // chart index is in the upper 4 bits of the Y offset
+#define MAX_PARAMETER_LENGTH 64 // longer parameter fields are treated as sync error
+#define MAX_OBJECT_INDEX 1024 // for buttons and sliders
+#define COMMAND_LINE_LENGTH 256
+
+static int sMasterFd;
+static uint16_t sDisplayWidth = 320;
+static uint16_t sDisplayHeight = 240;
+static std::vector<Color_t> sFrameBuffer;
+
+/*
+ * Statistics
+ */
+struct TagStatistics {
+    uint32_t Count;
+    uint64_t Bytes;
+    uint64_t RenderNanos;
+    uint64_t FirstNanos;
+    uint64_t LastNanos;
+};
+static struct TagStatistics sTagStatistics[256];
+static uint32_t sSyncErrors;
+static uint32_t sDecodeErrors;
+static uint32_t sEventsSent;
+static uint32_t sEventsDropped;
+static uint64_t sStatisticsStartNanos;
+
+struct FunctionName {
+    uint8_t FunctionTag;
+    const char * Name;
+};
+static const struct FunctionName sFunctionNames[] = { { FUNCTION_GLOBAL_SETTINGS, "GLOBAL_SETTINGS" }, {
+FUNCTION_REQUEST_MAX_CANVAS_SIZE, "REQUEST_MAX_CANVAS_SIZE" }, { FUNCTION_SENSOR_SETTINGS, "SENSOR_SETTINGS" }, {
+FUNCTION_BAUD_NEGOTIATION, "BAUD_NEGOTIATION" }, { FUNCTION_GET_NUMBER, "GET_NUMBER" }, { FUNCTION_GET_TEXT, "GET_TEXT" }, {
+FUNCTION_GET_INFO, "GET_INFO" }, { FUNCTION_PLAY_TONE, "PLAY_TONE" }, { FUNCTION_CLEAR_DISPLAY, "CLEAR_DISPLAY" }, {
+FUNCTION_DRAW_DISPLAY, "DRAW_DISPLAY" }, { FUNCTION_DRAW_PIXEL, "DRAW_PIXEL" }, { FUNCTION_DRAW_CHAR, "DRAW_CHAR" }, {
+FUNCTION_DRAW_REGISTERED_STRING, "DRAW_REGISTERED_STRING" }, {
+FUNCTION_DRAW_LINE_REL, "DRAW_LINE_REL" }, { FUNCTION_DRAW_LINE, "DRAW_LINE" }, { FUNCTION_DRAW_RECT_REL, "DRAW_RECT_REL" }, {
+FUNCTION_FILL_RECT_REL, "FILL_RECT_REL" }, { FUNCTION_DRAW_RECT, "DRAW_RECT" }, { FUNCTION_FILL_RECT, "FILL_RECT" }, {
+FUNCTION_DRAW_CIRCLE, "DRAW_CIRCLE" }, { FUNCTION_FILL_CIRCLE, "FILL_CIRCLE" }, { FUNCTION_WRITE_SETTINGS, "WRITE_SETTINGS" }, {
+FUNCTION_BUTTON_DRAW, "BUTTON_DRAW" }, { FUNCTION_BUTTON_DRAW_CAPTION, "BUTTON_DRAW_CAPTION" }, {
+FUNCTION_BUTTON_SETTINGS, "BUTTON_SETTINGS" }, { FUNCTION_BUTTON_REMOVE, "BUTTON_REMOVE" }, {
+FUNCTION_BUTTON_SET_REGISTERED_CAPTION, "BUTTON_SET_REGISTERED_CAPTION" }, {
+FUNCTION_BUTTON_SET_REGISTERED_CAPTION_AND_DRAW_BUTTON, "BUTTON_SET_REGISTERED_CAPTION_AND_DRAW_BUTTON" }, {
+FUNCTION_BUTTON_ACTIVATE_ALL, "BUTTON_ACTIVATE_ALL" }, { FUNCTION_BUTTON_DEACTIVATE_ALL, "BUTTON_DEACTIVATE_ALL" }, {
+FUNCTION_BUTTON_GLOBAL_SETTINGS, "BUTTON_GLOBAL_SETTINGS" }, { FUNCTION_SLIDER_CREATE, "SLIDER_CREATE" }, {
+FUNCTION_SLIDER_DRAW, "SLIDER_DRAW" }, { FUNCTION_SLIDER_SETTINGS, "SLIDER_SETTINGS" }, {
+FUNCTION_SLIDER_DRAW_BORDER, "SLIDER_DRAW_BORDER" }, { FUNCTION_SLIDER_ACTIVATE_ALL, "SLIDER_ACTIVATE_ALL" }, {
+FUNCTION_SLIDER_DEACTIVATE_ALL, "SLIDER_DEACTIVATE_ALL" }, { FUNCTION_SLIDER_GLOBAL_SETTINGS, "SLIDER_GLOBAL_SETTINGS" }, {
+FUNCTION_DRAW_STRING, "DRAW_STRING" }, { FUNCTION_DEBUG_STRING, "DEBUG_STRING" }, { FUNCTION_WRITE_STRING, "WRITE_STRING" }, {
+FUNCTION_REGISTER_STRING, "REGISTER_STRING" }, {
+FUNCTION_GET_NUMBER_WITH_SHORT_PROMPT, "GET_NUMBER_WITH_SHORT_PROMPT" }, {
+FUNCTION_GET_TEXT_WITH_SHORT_PROMPT, "GET_TEXT_WITH_SHORT_PROMPT" }, { FUNCTION_DRAW_PATH, "DRAW_PATH" }, {
+FUNCTION_FILL_PATH, "FILL_PATH" }, { FUNCTION_DRAW_CHART, "DRAW_CHART" }, {
+FUNCTION_DRAW_CHART_WITHOUT_DIRECT_RENDERING, "DRAW_CHART_WITHOUT_DIRECT_RENDERING" }, {
+FUNCTION_DRAW_CHART_DELTA, "DRAW_CHART_DELTA" }, {
+FUNCTION_DRAW_CHART_DELTA_WITHOUT_DIRECT_RENDERING, "DRAW_CHART_DELTA_WITHOUT_DIRECT_RENDERING" }, {
+FUNCTION_BAUD_TEST_PATTERN, "BAUD_TEST_PATTERN" }, { FUNCTION_BUTTON_CREATE, "BUTTON_CREATE" }, {
+FUNCTION_BUTTON_SET_CAPTION, "BUTTON_SET_CAPTION" }, {
+FUNCTION_BUTTON_SET_CAPTION_AND_DRAW_BUTTON, "BUTTON_SET_CAPTION_AND_DRAW_BUTTON" }, {
+FUNCTION_SLIDER_SET_CAPTION, "SLIDER_SET_CAPTION" }, { FUNCTION_SLIDER_PRINT_VALUE, "SLIDER_PRINT_VALUE" }, { FUNCTION_NOP,
+        "NOP" } };
+
+static const char * getFunctionName(uint8_t aFunctionTag) {
+    for (unsigned int i = 0; i < sizeof(sFunctionNames) / sizeof(sFunctionNames[0]); ++i) {
+        if (sFunctionNames[i].FunctionTag == aFunctionTag) {
+            return sFunctionNames[i].Name;
+        }
+    }
+    return "unknown";
+}
+
+static void resetStatistics(void) {
+    memset(sTagStatistics, 0, sizeof(sTagStatistics));
+    sSyncErrors = 0;
+    sDecodeErrors = 0;
+    sEventsSent = 0;
+    sEventsDropped = 0;
+    sStatisticsStartNanos = getHostNanos();
+}
+
+static void printStatistics(void) {
+    uint32_t tCommands = 0;
+    uint64_t tBytes = 0;
+    printf("Tag  Function                                  Count      Bytes Bytes/cmd Render us/cmd Interval ms\n");
+    for (int i = 0; i < 256; ++i) {
+        struct TagStatistics * tStatistics = &sTagStatistics[i];
+        if (tStatistics->Count == 0) {
+            continue;
+        }
+        double tIntervalMillis = 0;
+        if (tStatistics->Count > 1) {
+            tIntervalMillis = (tStatistics->LastNanos - tStatistics->FirstNanos) / 1e6 / (tStatistics->Count - 1);
+        }
+        printf("0x%02X %-40s %7u %10llu %9.1f %13.2f %11.2f\n", i, getFunctionName(i), tStatistics->Count,
+                (unsigned long long) tStatistics->Bytes, (double) tStatistics->Bytes / tStatistics->Count,
+                tStatistics->RenderNanos / 1e3 / tStatistics->Count, tIntervalMillis);
+        tCommands += tStatistics->Count;
+        tBytes += tStatistics->Bytes;
+    }
+    double tSeconds = (getHostNanos() - sStatisticsStartNanos) / 1e9;
+    printf("%u commands, %llu bytes in %.2f s = %.0f bytes/s %.1f commands/s, sync errors %u, decode errors %u, events sent %u dropped %u\n",
+            tCommands, (unsigned long long) tBytes, tSeconds, tBytes / tSeconds, tCommands / tSeconds, sSyncErrors,
+            sDecodeErrors, sEventsSent, sEventsDropped);
+}
+
+/*
+ * Events to the client
+ */
+static void putShort(uint8_t * aPointer, uint16_t aValue) {
+    aPointer[0] = aValue;
+    aPointer[1] = aValue >> 8;
+}
+
+static void putLong(uint8_t * aPointer, uint32_t aValue) {
+    putShort(aPointer, aValue);
+    putShort(aPointer + 2, aValue >> 16);
+}
+
+/**
+ * Sends gross length, event type, data and sync token. The master is non blocking,
+ * so events are dropped if the client does not read them.
+ */
+static void sendEvent(uint8_t aEventType, const uint8_t * aData, uint8_t aDataLength) {
+    uint8_t tMessage[3 + RECEIVE_MAX_DATA_SIZE];
+    tMessage[0] = aDataLength + 3;
+    tMessage[1] = aEventType;
+    memcpy(&tMessage[2], aData, aDataLength);
+    tMessage[aDataLength + 2] = SYNC_TOKEN;
+    if (write(sMasterFd, tMessage, aDataLength + 3) == aDataLength + 3) {
+        sEventsSent++;
+    } else {
+        sEventsDropped++;
+    }
+}
+
+static void sendDisplaySizeEvent(uint8_t aEventType) {
+    uint8_t tData[8];
+    putShort(tData, sDisplayWidth);
+    putShort(&tData[2], sDisplayHeight);
+    putLong(&tData[4], time(NULL));
+    sendEvent(aEventType, tData, sizeof(tData));
+}
+
+static void sendTouchEvent(uint8_t aEventType, uint16_t aPositionX, uint16_t aPositionY) {
+    uint8_t tData[5];
+    putShort(tData, aPositionX);
+    putShort(&tData[2], aPositionY);
+    tData[4] = 0; // pointer index
+    sendEvent(aEventType, tData, sizeof(tData));
+}
+
+/**
+ * 12 byte struct GuiCallback with 32 bit handler
+ */
+static void sendCallbackEvent(uint8_t aEventType, uint16_t aObjectIndex, uint32_t aHandler, uint32_t aValue) {
+    uint8_t tData[12];
+    putShort(tData, aObjectIndex);
+    putShort(&tData[2], 0);
+    putLong(&tData[4], aHandler);
+    putLong(&tData[8], aValue);
+    sendEvent(aEventType, tData, sizeof(tData));
+}
+
+static void sendBaudNegotiationEvent(uint16_t aSubFunction, uint16_t aValue, uint32_t aBaudRate) {
+    uint8_t tData[8];
+    putShort(tData, aSubFunction);
+    putShort(&tData[2], aValue);
+    putLong(&tData[4], aBaudRate);
+    sendEvent(EVENT_BAUD_NEGOTIATION, tData, sizeof(tData));
+}
+
+/*
+ * Rendering
+ */
+static void setPixel(int aPositionX, int aPositionY, Color_t aColor) {
+    if (aPositionX >= 0 && aPositionX < sDisplayWidth && aPositionY >= 0 && aPositionY < sDisplayHeight) {
+        sFrameBuffer[aPositionY * sDisplayWidth + aPositionX] = aColor;
+    }
+}
+
+/**
+ * End coordinates are inclusive
+ */
+static void fillRect(int aXStart, int aYStart, int aXEnd, int aYEnd, Color_t aColor) {
+    if (aXStart > aXEnd) {
+        int tTemp = aXStart;
+        aXStart = aXEnd;
+        aXEnd = tTemp;
+    }
+    if (aYStart > aYEnd) {
+        int tTemp = aYStart;
+        aYStart = aYEnd;
+        aYEnd = tTemp;
+    }
+    for (int y = aYStart; y <= aYEnd; ++y) {
+        for (int x = aXStart; x <= aXEnd; ++x) {
+            setPixel(x, y, aColor);
+        }
+    }
+}
+
+static void fillRectRel(int aXStart, int aYStart, int aWidth, int aHeight, Color_t aColor) {
+    if (aWidth > 0 && aHeight > 0) {
+        fillRect(aXStart, aYStart, aXStart + aWidth - 1, aYStart + aHeight - 1, aColor);
+    }
+}
+
+static void clearDisplay(Color_t aColor) {
+    for (size_t i = 0; i < sFrameBuffer.size(); ++i) {
+        sFrameBuffer[i] = aColor;
+    }
+}
+
+/**
+ * Bresenham line. Thickness is approximated by a square pen.
+ */
+static void drawLine(int aXStart, int aYStart, int aXEnd, int aYEnd, Color_t aColor, int aThickness) {
+    int tDeltaX = abs(aXEnd - aXStart);
+    int tDeltaY = -abs(aYEnd - aYStart);
+    int tStepX = aXStart < aXEnd ? 1 : -1;
+    int tStepY = aYStart < aYEnd ? 1 : -1;
+    int tError = tDeltaX + tDeltaY;
+    int tPenOffset = (aThickness - 1) / 2;
+    while (true) {
+        if (aThickness <= 1) {
+            setPixel(aXStart, aYStart, aColor);
+        } else {
+            fillRectRel(aXStart - tPenOffset, aYStart - tPenOffset, aThickness, aThickness, aColor);
+        }
+        if (aXStart == aXEnd && aYStart == aYEnd) {
+            break;
+        }
+        int tError2 = 2 * tError;
+        if (tError2 >= tDeltaY) {
+            tError += tDeltaY;
+            aXStart += tStepX;
+        }
+        if (tError2 <= tDeltaX) {
+            tError += tDeltaX;
+            aYStart += tStepY;
+        }
+    }
+}
+
+static void drawRect(int aXStart, int aYStart, int aXEnd, int aYEnd, Color_t aColor, int aStrokeWidth) {
+    if (aStrokeWidth < 1) {
+        aStrokeWidth = 1;
+    }
+    fillRect(aXStart, aYStart, aXEnd, aYStart + aStrokeWidth - 1, aColor);
+    fillRect(aXStart, aYEnd - aStrokeWidth + 1, aXEnd, aYEnd, aColor);
+    fillRect(aXStart, aYStart, aXStart + aStrokeWidth - 1, aYEnd, aColor);
+    fillRect(aXEnd - aStrokeWidth + 1, aYStart, aXEnd, aYEnd, aColor);
+}
+
+/**
+ * Stroke is centered on the radius like on the Android canvas. aStrokeWidth == 0 fills the circle.
+ */
+static void drawCircle(int aXCenter, int aYCenter, int aRadius, Color_t aColor, int aStrokeWidth) {
+    int tOuterRadius = aRadius + aStrokeWidth / 2;
+    int tInnerRadius = aRadius - (aStrokeWidth + 1) / 2;
+    if (aStrokeWidth == 0 || tInnerRadius < 0) {
+        tInnerRadius = -1;
+    }
+    for (int y = -tOuterRadius; y <= tOuterRadius; ++y) {
+        for (int x = -tOuterRadius; x <= tOuterRadius; ++x) {
+            int tSquare = x * x + y * y;
+            if (tSquare <= tOuterRadius * tOuterRadius + tOuterRadius && tSquare > tInnerRadius * tInnerRadius + tInnerRadius) {
+                setPixel(aXCenter + x, aYCenter + y, aColor);
+            }
+        }
+    }
+}
+
+/**
+ * Scales the local 8x12 font to the size the app uses for aTextSize.
+ * @return width of character
+ */
+static int drawChar(int aPositionX, int aPositionY, uint8_t aChar, uint16_t aTextSize, Color_t aFGColor, Color_t aBGColor) {
+    int tWidth = getTextWidth(aTextSize);
+    int tHeight = getTextHeight(aTextSize);
+    if (aChar < FONT_START) {
+        aChar = '?';
+    }
+    const uint8_t * tGlyph = &font[(aChar - FONT_START) * FONT_HEIGHT];
+    for (int y = 0; y < tHeight; ++y) {
+        uint8_t tRow = tGlyph[y * FONT_HEIGHT / tHeight];
+        for (int x = 0; x < tWidth; ++x) {
+            if (tRow & (0x80 >> (x * FONT_WIDTH / tWidth))) {
+                setPixel(aPositionX + x, aPositionY + y, aFGColor);
+            } else if (aBGColor != COLOR_NO_BACKGROUND) {
+                setPixel(aPositionX + x, aPositionY + y, aBGColor);
+            }
+        }
+    }
+    return tWidth;
+}
+
+/**
+ * aPositionY is the upper left corner
+ */
+static void drawText(int aPositionX, int aPositionY, const uint8_t * aText, size_t aLength, uint16_t aTextSize,
+        Color_t aFGColor, Color_t aBGColor) {
+    int tStartX = aPositionX;
+    for (size_t i = 0; i < aLength; ++i) {
+        if (aText[i] == '\n') {
+            aPositionX = tStartX;
+            aPositionY += getTextHeight(aTextSize);
+        } else if (aText[i] != '\r') {
+            aPositionX += drawChar(aPositionX, aPositionY, aText[i], aTextSize, aFGColor, aBGColor);
+        }
+    }
+}
+
+/*
+ * Text console of FUNCTION_WRITE_STRING
+ */
+struct WriteConsole {
+    uint16_t TextSize;
+    Color_t Color;
+    Color_t BackgroundColor;
+    bool ClearOnNewScreen;
+    int PositionX;
+    int PositionY;
+};
+static struct WriteConsole sWriteConsole = { TEXT_SIZE_11, COLOR_BLACK, COLOR_WHITE, false, 0, 0 };
+
+static void writeString(const uint8_t * aText, size_t aLength) {
+    int tWidth = getTextWidth(sWriteConsole.TextSize);
+    int tHeight = getTextHeight(sWriteConsole.TextSize);
+    for (size_t i = 0; i < aLength; ++i) {
+        if (aText[i] == '\r') {
+            sWriteConsole.PositionX = 0;
+            continue;
+        }
+        if (aText[i] == '\n' || sWriteConsole.PositionX + tWidth > sDisplayWidth) {
+            sWriteConsole.PositionX = 0;
+            sWriteConsole.PositionY += tHeight;
+        }
+        if (sWriteConsole.PositionY + tHeight > sDisplayHeight) {
+            sWriteConsole.PositionY = 0;
+            if (sWriteConsole.ClearOnNewScreen) {
+                clearDisplay(sWriteConsole.BackgroundColor);
+            }
+        }
+        if (aText[i] != '\n') {
+            sWriteConsole.PositionX += drawChar(sWriteConsole.PositionX, sWriteConsole.PositionY, aText[i],
+                    sWriteConsole.TextSize, sWriteConsole.Color, sWriteConsole.BackgroundColor);
+        }
+    }
+}
+
+/*
+ * Strings registered by FUNCTION_REGISTER_STRING
+ */
+static struct StringTable sRegisteredStrings;
+
+/*
+ * Charts
+ */
+struct SimulatedChart {
+    bool IsValid;
+    uint16_t XOffset;
+    uint16_t YOffset;
+    std::vector<uint8_t> Data;
+};
+static struct SimulatedChart sCharts[NUMBER_OF_CHARTS];
+
+/**
+ * Values are Y coordinates relative to the Y offset. Consecutive values are connected by vertical lines.
+ */
+static void drawChart(struct SimulatedChart * aChart, Color_t aColor) {
+    for (size_t i = 0; i < aChart->Data.size(); ++i) {
+        int tLastY = aChart->Data[i > 0 ? i - 1 : 0];
+        drawLine(aChart->XOffset + i, aChart->YOffset + tLastY, aChart->XOffset + i, aChart->YOffset + aChart->Data[i], aColor,
+                1);
+    }
+}
+
+static void handleChart(uint8_t aFunctionTag, const uint16_t * aParameters, const uint8_t * aData, uint16_t aDataLength) {
+    struct SimulatedChart * tChart = &sCharts[aParameters[1] >> 12];
+    Color_t tClearBeforeColor = aParameters[3];
+    if (tClearBeforeColor != 0 && tChart->IsValid) {
+        drawChart(tChart, tClearBeforeColor);
+    }
+    if (aFunctionTag == FUNCTION_DRAW_CHART_DELTA || aFunctionTag == FUNCTION_DRAW_CHART_DELTA_WITHOUT_DIRECT_RENDERING) {
+        // last chart with same index is the reference
+        if (!tChart->IsValid || tChart->Data.size() != aParameters[4]
+                || !decodeChartDelta(aData, aDataLength, &tChart->Data[0], aParameters[4])) {
+            sDecodeErrors++;
+            tChart->IsValid = false;
+            return;
+        }
+    } else {
+        tChart->Data.assign(aData, aData + aDataLength);
+    }
+    tChart->IsValid = true;
+    tChart->XOffset = aParameters[0];
+    tChart->YOffset = aParameters[1] & 0x0FFF;
+    drawChart(tChart, aParameters[2]);
+}
+
+/*
+ * Buttons
+ */
+struct SimulatedButton {
+    bool IsActive;
+    uint16_t PositionX;
+    uint16_t PositionY;
+    uint16_t WidthX;
+    uint16_t HeightY;
+    Color_t ButtonColor;
+    Color_t CaptionColor;
+    uint16_t CaptionSize;
+    uint16_t Flags;
+    int16_t Value;
+    uint32_t Handler;
+    std::string Caption;
+};
+static std::vector<struct SimulatedButton> sButtons;
+
+static struct SimulatedButton * getButton(uint16_t aButtonIndex) {
+    if (aButtonIndex >= MAX_OBJECT_INDEX) {
+        return NULL;
+    }
+    if (aButtonIndex >= sButtons.size()) {
+        sButtons.resize(aButtonIndex + 1);
+    }
+    return &sButtons[aButtonIndex];
+}
+
+static void drawButtonCaption(struct SimulatedButton * aButton) {
+    // center each line of the caption
+    int tLineCount = 1;
+    for (size_t i = 0; i < aButton->Caption.size(); ++i) {
+        if (aButton->Caption[i] == '\n') {
+            tLineCount++;
+        }
+    }
+    int tHeight = getTextHeight(aButton->CaptionSize);
+    int tPositionY = aButton->PositionY + ((int) aButton->HeightY - tLineCount * tHeight) / 2;
+    size_t tLineStart = 0;
+    while (tLineStart <= aButton->Caption.size()) {
+        size_t tLineEnd = aButton->Caption.find('\n', tLineStart);
+        if (tLineEnd == std::string::npos) {
+            tLineEnd = aButton->Caption.size();
+        }
+        int tLineWidth = (tLineEnd - tLineStart) * getTextWidth(aButton->CaptionSize);
+        drawText(aButton->PositionX + ((int) aButton->WidthX - tLineWidth) / 2, tPositionY,
+                (const uint8_t *) aButton->Caption.c_str() + tLineStart, tLineEnd - tLineStart, aButton->CaptionSize,
+                aButton->CaptionColor, COLOR_NO_BACKGROUND);
+        tPositionY += tHeight;
+        tLineStart = tLineEnd + 1;
+    }
+}
+
+static void drawButton(struct SimulatedButton * aButton) {
+    Color_t tColor = aButton->ButtonColor;
+    if (aButton->Flags & FLAG_BUTTON_TYPE_AUTO_RED_GREEN) {
+        tColor = aButton->Value ? COLOR_GREEN : COLOR_RED;
+    }
+    fillRectRel(aButton->PositionX, aButton->PositionY, aButton->WidthX, aButton->HeightY, tColor);
+    drawButtonCaption(aButton);
+    aButton->IsActive = true;
+}
+
+static void handleButtonSettings(struct SimulatedButton * aButton, const uint16_t * aParameters) {
+    switch (aParameters[1]) {
+    case SUBFUNCTION_BUTTON_SET_BUTTON_COLOR:
+    case SUBFUNCTION_BUTTON_SET_BUTTON_COLOR_AND_DRAW:
+        aButton->ButtonColor = aParameters[2];
+        break;
+    case SUBFUNCTION_BUTTON_SET_CAPTION_COLOR:
+    case SUBFUNCTION_BUTTON_SET_CAPTION_COLOR_AND_DRAW:
+        aButton->CaptionColor = aParameters[2];
+        break;
+    case SUBFUNCTION_BUTTON_SET_VALUE:
+    case SUBFUNCTION_BUTTON_SET_VALUE_AND_DRAW:
+        aButton->Value = aParameters[2];
+        break;
+    case SUBFUNCTION_BUTTON_SET_COLOR_AND_VALUE:
+    case SUBFUNCTION_BUTTON_SET_COLOR_AND_VALUE_AND_DRAW:
+        aButton->ButtonColor = aParameters[2];
+        aButton->Value = aParameters[3];
+        break;
+    case SUBFUNCTION_BUTTON_SET_POSITION:
+    case SUBFUNCTION_BUTTON_SET_POSITION_AND_DRAW:
+        aButton->PositionX = aParameters[2];
+        aButton->PositionY = aParameters[3];
+        break;
+    case SUBFUNCTION_BUTTON_SET_ACTIVE:
+        aButton->IsActive = true;
+        break;
+    case SUBFUNCTION_BUTTON_RESET_ACTIVE:
+        aButton->IsActive = false;
+        break;
+    default:
+        // autorepeat timing has no effect on single touches
+        break;
+    }
+    // all "AND_DRAW" sub functions are odd and below SUBFUNCTION_BUTTON_SET_ACTIVE
+    if (aParameters[1] < SUBFUNCTION_BUTTON_SET_ACTIVE && (aParameters[1] & 0x01)) {
+        drawButton(aButton);
+    }
+}
+
+/**
+ * Like the app: red/green buttons toggle their value before the callback.
+ */
+static void sendButtonCallback(uint16_t aButtonIndex) {
+    struct SimulatedButton * tButton = &sButtons[aButtonIndex];
+    if (tButton->Flags & FLAG_BUTTON_TYPE_AUTO_RED_GREEN) {
+        tButton->Value = !tButton->Value;
+        drawButton(tButton);
+    }
+    sendCallbackEvent(EVENT_BUTTON_CALLBACK, aButtonIndex, tButton->Handler, tButton->Value);
+}
+
+/*
+ * Sliders
+ */
+struct SimulatedSlider {
+    bool IsActive;
+    uint16_t PositionX;
+    uint16_t PositionY;
+    uint16_t BarWidth;
+    uint16_t BarLength;
+    uint16_t ThresholdValue;
+    int16_t Value;
+    Color_t SliderColor;
+    Color_t BarColor;
+    Color_t BarThresholdColor;
+    Color_t BarBackgroundColor;
+    uint16_t Flags;
+    uint32_t Handler;
+};
+static std::vector<struct SimulatedSlider> sSliders;
+
+static struct SimulatedSlider * getSlider(uint16_t aSliderIndex) {
+    if (aSliderIndex >= MAX_OBJECT_INDEX) {
+        return NULL;
+    }
+    if (aSliderIndex >= sSliders.size()) {
+        sSliders.resize(aSliderIndex + 1);
+    }
+    return &sSliders[aSliderIndex];
+}
+
+/*
+ * Same geometry as TouchSlider of the local display
+ */
+static int getSliderShortBorderWidth(struct SimulatedSlider * aSlider) {
+    return (aSlider->Flags & FLAG_SLIDER_SHOW_BORDER) ? aSlider->BarWidth / 2 : 0;
+}
+
+static int getSliderLongBorderWidth(struct SimulatedSlider * aSlider) {
+    return (aSlider->Flags & FLAG_SLIDER_SHOW_BORDER) ? aSlider->BarWidth : 0;
+}
+
+static int getSliderWidthX(struct SimulatedSlider * aSlider) {
+    if (aSlider->Flags & FLAG_SLIDER_IS_HORIZONTAL) {
+        return aSlider->BarLength + 2 * getSliderShortBorderWidth(aSlider);
+    }
+    return aSlider->BarWidth + 2 * getSliderLongBorderWidth(aSlider);
+}
+
+static int getSliderHeightY(struct SimulatedSlider * aSlider) {
+    if (aSlider->Flags & FLAG_SLIDER_IS_HORIZONTAL) {
+        return aSlider->BarWidth + 2 * getSliderLongBorderWidth(aSlider);
+    }
+    return aSlider->BarLength + 2 * getSliderShortBorderWidth(aSlider);
+}
+
+static void drawSliderBar(struct SimulatedSlider * aSlider) {
+    int tValue = aSlider->Value;
+    if (tValue > aSlider->BarLength) {
+        tValue = aSlider->BarLength;
+    }
+    if (tValue < 0) {
+        tValue = 0;
+    }
+    int tShortBorderWidth = getSliderShortBorderWidth(aSlider);
+    int tLongBorderWidth = getSliderLongBorderWidth(aSlider);
+    Color_t tBarColor = (tValue > aSlider->ThresholdValue) ? aSlider->BarThresholdColor : aSlider->BarColor;
+    if (aSlider->Flags & FLAG_SLIDER_IS_HORIZONTAL) {
+        int tBarX = aSlider->PositionX + tShortBorderWidth;
+        int tBarY = aSlider->PositionY + tLongBorderWidth;
+        fillRectRel(tBarX + tValue, tBarY, aSlider->BarLength - tValue, aSlider->BarWidth, aSlider->BarBackgroundColor);
+        fillRectRel(tBarX, tBarY, tValue, aSlider->BarWidth, tBarColor);
+    } else {
+        int tBarX = aSlider->PositionX + tLongBorderWidth;
+        int tBarY = aSlider->PositionY + tShortBorderWidth;
+        fillRectRel(tBarX, tBarY, aSlider->BarWidth, aSlider->BarLength - tValue, aSlider->BarBackgroundColor);
+        fillRectRel(tBarX, tBarY + aSlider->BarLength - tValue, aSlider->BarWidth, tValue, tBarColor);
+    }
+}
+
+static void drawSlider(struct SimulatedSlider * aSlider, bool aOnlyBorder) {
+    if (aSlider->Flags & FLAG_SLIDER_SHOW_BORDER) {
+        fillRectRel(aSlider->PositionX, aSlider->PositionY, getSliderWidthX(aSlider), getSliderHeightY(aSlider),
+                aSlider->SliderColor);
+    }
+    if (!aOnlyBorder) {
+        drawSliderBar(aSlider);
+        aSlider->IsActive = !(aSlider->Flags & FLAG_SLIDER_IS_ONLY_OUTPUT);
+    }
+}
+
+static void handleSliderSettings(struct SimulatedSlider * aSlider, const uint16_t * aParameters) {
+    switch (aParameters[1]) {
+    case SUBFUNCTION_SLIDER_SET_COLOR_THRESHOLD:
+        aSlider->BarThresholdColor = aParameters[2];
+        break;
+    case SUBFUNCTION_SLIDER_SET_COLOR_BAR_BACKGROUND:
+        aSlider->BarBackgroundColor = aParameters[2];
+        break;
+    case SUBFUNCTION_SLIDER_SET_COLOR_BAR:
+        aSlider->BarColor = aParameters[2];
+        break;
+    case SUBFUNCTION_SLIDER_SET_VALUE_AND_DRAW_BAR:
+        aSlider->Value = aParameters[2];
+        drawSliderBar(aSlider);
+        break;
+    case SUBFUNCTION_SLIDER_SET_POSITION:
+        aSlider->PositionX = aParameters[2];
+        aSlider->PositionY = aParameters[3];
+        break;
+    case SUBFUNCTION_SLIDER_SET_ACTIVE:
+        aSlider->IsActive = true;
+        break;
+    case SUBFUNCTION_SLIDER_RESET_ACTIVE:
+        aSlider->IsActive = false;
+        break;
+    default:
+        // caption, value string and scale factor only affect the value printed by the app
+        break;
+    }
+}
+
+/**
+ * Bar value for a touch position. Touches on the border are clipped to the bar.
+ */
+static int getSliderValue(struct SimulatedSlider * aSlider, int aTouchPositionX, int aTouchPositionY) {
+    int tValue;
+    if (aSlider->Flags & FLAG_SLIDER_IS_HORIZONTAL) {
+        tValue = aTouchPositionX - (aSlider->PositionX + getSliderShortBorderWidth(aSlider));
+    } else {
+        tValue = (aSlider->PositionY + getSliderShortBorderWidth(aSlider) + aSlider->BarLength) - aTouchPositionY;
+    }
+    if (tValue < 0) {
+        tValue = 0;
+    }
+    if (tValue > aSlider->BarLength) {
+        tValue = aSlider->BarLength;
+    }
+    if (aSlider->Flags & FLAG_SLIDER_IS_INVERSE) {
+        tValue = aSlider->BarLength - tValue;
+    }
+    return tValue;
+}
+
+/**
+ * The app draws the new bar itself, unless the value is set by the callback handler.
+ */
+static void sendSliderCallback(uint16_t aSliderIndex, int aValue) {
+    struct SimulatedSlider * tSlider = &sSliders[aSliderIndex];
+    if (!(tSlider->Flags & FLAG_SLIDER_VALUE_BY_CALLBACK)) {
+        tSlider->Value = aValue;
+        drawSliderBar(tSlider);
+    }
+    sendCallbackEvent(EVENT_SLIDER_CALLBACK, aSliderIndex, tSlider->Handler, aValue);
+}
+
+/*
+ * Command parser
+ */
+static uint16_t getShort(const uint8_t * aPointer) {
+    return aPointer[0] | (aPointer[1] << 8);
+}
+
+static void handleCommand(uint8_t aFunctionTag, const uint16_t * aParameters, int aParameterCount, const uint8_t * aData,
+        uint16_t aDataLength) {
+    struct SimulatedButton * tButton = NULL;
+    struct SimulatedSlider * tSlider = NULL;
+    if ((aFunctionTag >= FUNCTION_BUTTON_DRAW && aFunctionTag <= FUNCTION_BUTTON_REMOVE)
+            || aFunctionTag == FUNCTION_BUTTON_CREATE || aFunctionTag == FUNCTION_BUTTON_SET_CAPTION
+            || aFunctionTag == FUNCTION_BUTTON_SET_CAPTION_AND_DRAW_BUTTON
+            || aFunctionTag == FUNCTION_BUTTON_SET_REGISTERED_CAPTION
+            || aFunctionTag == FUNCTION_BUTTON_SET_REGISTERED_CAPTION_AND_DRAW_BUTTON) {
+        tButton = getButton(aParameters[0]);
+        if (tButton == NULL) {
+            sDecodeErrors++;
+            return;
+        }
+    } else if ((aFunctionTag >= FUNCTION_SLIDER_CREATE && aFunctionTag <= FUNCTION_SLIDER_DRAW_BORDER)
+            || aFunctionTag == FUNCTION_SLIDER_SET_CAPTION || aFunctionTag == FUNCTION_SLIDER_PRINT_VALUE) {
+        tSlider = getSlider(aParameters[0]);
+        if (tSlider == NULL) {
+            sDecodeErrors++;
+            return;
+        }
+    }
+
+    switch (aFunctionTag) {
+    case FUNCTION_CLEAR_DISPLAY:
+        clearDisplay(aParameters[0]);
+        sWriteConsole.PositionX = 0;
+        sWriteConsole.PositionY = 0;
+        break;
+    case FUNCTION_DRAW_PIXEL:
+        setPixel(aParameters[0], aParameters[1], aParameters[2]);
+        break;
+    case FUNCTION_DRAW_CHAR:
+        drawChar(aParameters[0], aParameters[1], aParameters[5], aParameters[2], aParameters[3], aParameters[4]);
+        break;
+    case FUNCTION_DRAW_LINE:
+        drawLine(aParameters[0], aParameters[1], aParameters[2], aParameters[3], aParameters[4],
+                aParameterCount > 5 ? aParameters[5] : 1);
+        break;
+    case FUNCTION_DRAW_LINE_REL:
+        drawLine(aParameters[0], aParameters[1], aParameters[0] + (int16_t) aParameters[2],
+                aParameters[1] + (int16_t) aParameters[3], aParameters[4], 1);
+        break;
+    case FUNCTION_DRAW_RECT:
+        drawRect(aParameters[0], aParameters[1], aParameters[2], aParameters[3], aParameters[4], aParameters[5]);
+        break;
+    case FUNCTION_DRAW_RECT_REL:
+        drawRect(aParameters[0], aParameters[1], aParameters[0] + aParameters[2] - 1, aParameters[1] + aParameters[3] - 1,
+                aParameters[4], aParameters[5]);
+        break;
+    case FUNCTION_FILL_RECT:
+        fillRect(aParameters[0], aParameters[1], aParameters[2], aParameters[3], aParameters[4]);
+        break;
+    case FUNCTION_FILL_RECT_REL:
+        fillRectRel(aParameters[0], aParameters[1], aParameters[2], aParameters[3], aParameters[4]);
+        break;
+    case FUNCTION_DRAW_CIRCLE:
+        drawCircle(aParameters[0], aParameters[1], aParameters[2], aParameters[3], aParameters[4] > 0 ? aParameters[4] : 1);
+        break;
+    case FUNCTION_FILL_CIRCLE:
+        drawCircle(aParameters[0], aParameters[1], aParameters[2], aParameters[3], 0);
+        break;
+    case FUNCTION_DRAW_STRING:
+        drawText(aParameters[0], aParameters[1], aData, aDataLength, aParameters[2], aParameters[3], aParameters[4]);
+        break;
+    case FUNCTION_REGISTER_STRING:
+        if (!setStringTableEntry(&sRegisteredStrings, aParameters[0], (const char *) aData, aDataLength)) {
+            sDecodeErrors++;
+        }
+        break;
+    case FUNCTION_DRAW_REGISTERED_STRING: {
+        size_t tLength;
+        const char * tString = getStringTableEntry(&sRegisteredStrings, aParameters[5], &tLength);
+        if (tString == NULL) {
+            sDecodeErrors++;
+            break;
+        }
+        drawText(aParameters[0], aParameters[1], (const uint8_t *) tString, tLength, aParameters[2], aParameters[3],
+                aParameters[4]);
+        break;
+    }
+
+    case FUNCTION_WRITE_SETTINGS:
+        if (aParameters[0] == FLAG_WRITE_SETTINGS_SET_SIZE_AND_COLORS_AND_FLAGS) {
+            sWriteConsole.TextSize = aParameters[1];
+            sWriteConsole.Color = aParameters[2];
+            sWriteConsole.BackgroundColor = aParameters[3];
+            sWriteConsole.ClearOnNewScreen = aParameters[4];
+        } else if (aParameters[0] == FLAG_WRITE_SETTINGS_SET_POSITION) {
+            sWriteConsole.PositionX = aParameters[1];
+            sWriteConsole.PositionY = aParameters[2];
+        } else if (aParameters[0] == FLAG_WRITE_SETTINGS_SET_LINE_COLUMN) {
+            sWriteConsole.PositionX = aParameters[1] * getTextWidth(sWriteConsole.TextSize);
+            sWriteConsole.PositionY = aParameters[2] * getTextHeight(sWriteConsole.TextSize);
+        }
+        break;
+    case FUNCTION_WRITE_STRING:
+        writeString(aData, aDataLength);
+        break;
+    case FUNCTION_DEBUG_STRING:
+        printf("Debug: %.*s\n", aDataLength, aData);
+        break;
+
+    case FUNCTION_DRAW_CHART:
+    case FUNCTION_DRAW_CHART_WITHOUT_DIRECT_RENDERING:
+    case FUNCTION_DRAW_CHART_DELTA:
+    case FUNCTION_DRAW_CHART_DELTA_WITHOUT_DIRECT_RENDERING:
+        handleChart(aFunctionTag, aParameters, aData, aDataLength);
+        break;
+
+    case FUNCTION_BUTTON_CREATE:
+        // 11 parameter from BDButton, 10 parameter with caption size and flags in one word from BlueDisplay::createButton()
+        tButton->IsActive = false;
+        tButton->PositionX = aParameters[1];
+        tButton->PositionY = aParameters[2];
+        tButton->WidthX = aParameters[3];
+        tButton->HeightY = aParameters[4];
+        tButton->ButtonColor = aParameters[5];
+        tButton->CaptionColor = COLOR_BLACK;
+        if (aParameterCount >= 11) {
+            tButton->CaptionSize = aParameters[6];
+            tButton->Flags = aParameters[7];
+            tButton->Value = aParameters[8];
+            tButton->Handler = aParameters[9] | (aParameters[10] << 16);
+        } else {
+            tButton->CaptionSize = aParameters[6] & 0xFF;
+            tButton->Flags = aParameters[6] >> 8;
+            tButton->Value = aParameters[7];
+            tButton->Handler = aParameters[8] | (aParameters[9] << 16);
+        }
+        tButton->Caption.assign((const char *) aData, aDataLength);
+        break;
+    case FUNCTION_BUTTON_DRAW:
+        drawButton(tButton);
+        break;
+    case FUNCTION_BUTTON_DRAW_CAPTION:
+        drawButtonCaption(tButton);
+        break;
+    case FUNCTION_BUTTON_SETTINGS:
+        handleButtonSettings(tButton, aParameters);
+        break;
+    case FUNCTION_BUTTON_REMOVE:
+        fillRectRel(tButton->PositionX, tButton->PositionY, tButton->WidthX, tButton->HeightY, aParameters[1]);
+        tButton->IsActive = false;
+        break;
+    case FUNCTION_BUTTON_SET_CAPTION:
+    case FUNCTION_BUTTON_SET_CAPTION_AND_DRAW_BUTTON:
+        tButton->Caption.assign((const char *) aData, aDataLength);
+        if (aFunctionTag == FUNCTION_BUTTON_SET_CAPTION_AND_DRAW_BUTTON) {
+            drawButton(tButton);
+        }
+        break;
+    case FUNCTION_BUTTON_SET_REGISTERED_CAPTION:
+    case FUNCTION_BUTTON_SET_REGISTERED_CAPTION_AND_DRAW_BUTTON: {
+        size_t tLength;
+        const char * tCaption = getStringTableEntry(&sRegisteredStrings, aParameters[1], &tLength);
+        if (tCaption == NULL) {
+            sDecodeErrors++;
+            break;
+        }
+        tButton->Caption.assign(tCaption, tLength);
+        if (aFunctionTag == FUNCTION_BUTTON_SET_REGISTERED_CAPTION_AND_DRAW_BUTTON) {
+            drawButton(tButton);
+        }
+        break;
+    }
+    case FUNCTION_BUTTON_ACTIVATE_ALL:
+    case FUNCTION_BUTTON_DEACTIVATE_ALL:
+        for (size_t i = 0; i < sButtons.size(); ++i) {
+            sButtons[i].IsActive = (aFunctionTag == FUNCTION_BUTTON_ACTIVATE_ALL);
+        }
+        break;
+
+    case FUNCTION_SLIDER_CREATE:
+        tSlider->IsActive = false;
+        tSlider->PositionX = aParameters[1];
+        tSlider->PositionY = aParameters[2];
+        tSlider->BarWidth = aParameters[3];
+        tSlider->BarLength = aParameters[4];
+        tSlider->ThresholdValue = aParameters[5];
+        tSlider->Value = aParameters[6];
+        tSlider->SliderColor = aParameters[7];
+        tSlider->BarColor = aParameters[8];
+        tSlider->BarThresholdColor = COLOR_RED;
+        tSlider->BarBackgroundColor = COLOR_WHITE;
+        tSlider->Flags = aParameters[9];
+        tSlider->Handler = aParameters[10] | (aParameters[11] << 16);
+        break;
+    case FUNCTION_SLIDER_DRAW:
+    case FUNCTION_SLIDER_DRAW_BORDER:
+        drawSlider(tSlider, aFunctionTag == FUNCTION_SLIDER_DRAW_BORDER);
+        break;
+    case FUNCTION_SLIDER_SETTINGS:
+        handleSliderSettings(tSlider, aParameters);
+        break;
+    case FUNCTION_SLIDER_ACTIVATE_ALL:
+    case FUNCTION_SLIDER_DEACTIVATE_ALL:
+        for (size_t i = 0; i < sSliders.size(); ++i) {
+            sSliders[i].IsActive = (aFunctionTag == FUNCTION_SLIDER_ACTIVATE_ALL);
+        }
+        break;
+
+    case FUNCTION_BAUD_NEGOTIATION:
+        // A pty has no baud rate to switch, so stay at the actual one
+        if (aParameters[0] == SUBFUNCTION_BAUD_PROPOSE) {
+            sendBaudNegotiationEvent(SUBFUNCTION_BAUD_PROPOSE, 0, aParameters[1] | (aParameters[2] << 16));
+        } else if (aParameters[0] == SUBFUNCTION_BAUD_CONFIRM) {
+            sendBaudNegotiationEvent(SUBFUNCTION_BAUD_CONFIRM, 1, 0);
+        }
+        break;
+    case FUNCTION_BAUD_TEST_PATTERN:
+        sendBaudNegotiationEvent(SUBFUNCTION_BAUD_TEST_PATTERN, computeCRC16CCITT(aData, aDataLength), aDataLength);
+        break;
+    case FUNCTION_REQUEST_MAX_CANVAS_SIZE:
+        sendDisplaySizeEvent(EVENT_REORIENTATION);
+        break;
+
+    default:
+        // settings, tones, sensors, paths and requests for user input have no effect on the frame buffer
+        break;
+    }
+}
+
+/**
+ * Parses and executes all complete commands in aReceived. Resynchronizes on the sync token after errors.
+ */
+static void parseReceivedData(std::vector<uint8_t> * aReceived) {
+    size_t tPosition = 0;
+    while (tPosition + 4 <= aReceived->size()) {
+        const uint8_t * tCommand = &(*aReceived)[tPosition];
+        uint16_t tParameterLength = getShort(&tCommand[2]);
+        if (tCommand[0] != SYNC_TOKEN || tParameterLength > MAX_PARAMETER_LENGTH || (tParameterLength & 0x01)) {
+            sSyncErrors++;
+            tPosition++;
+            continue;
+        }
+        uint8_t tFunctionTag = tCommand[1];
+        size_t tCommandLength = 4 + tParameterLength;
+        const uint8_t * tData = NULL;
+        uint16_t tDataLength = 0;
+        if (tFunctionTag > INDEX_LAST_FUNCTION_WITHOUT_DATA) {
+            if (tPosition + tCommandLength + 4 > aReceived->size()) {
+                break;
+            }
+            if (tCommand[tCommandLength] != SYNC_TOKEN || tCommand[tCommandLength + 1] != DATAFIELD_TAG_BYTE) {
+                sSyncErrors++;
+                tPosition++;
+                continue;
+            }
+            tData = tCommand + tCommandLength + 4;
+            tDataLength = getShort(tCommand + tCommandLength + 2);
+            tCommandLength += 4 + tDataLength;
+        }
+        if (tPosition + tCommandLength > aReceived->size()) {
+            break;
+        }
+
+        uint16_t tParameters[MAX_PARAMETER_LENGTH / 2] = { 0 };
+        int tParameterCount = tParameterLength / 2;
+        for (int i = 0; i < tParameterCount; ++i) {
+            tParameters[i] = getShort(&tCommand[4 + 2 * i]);
+        }
+        uint64_t tStartNanos = getHostNanos();
+        handleCommand(tFunctionTag, tParameters, tParameterCount, tData, tDataLength);
+        uint64_t tEndNanos = getHostNanos();
+
+        struct TagStatistics * tStatistics = &sTagStatistics[tFunctionTag];
+        if (tStatistics->Count == 0) {
+            tStatistics->FirstNanos = tStartNanos;
+        }
+        tStatistics->LastNanos = tStartNanos;
+        tStatistics->Count++;
+        tStatistics->Bytes += tCommandLength;
+        tStatistics->RenderNanos += tEndNanos - tStartNanos;
+        tPosition += tCommandLength;
+    }
+    aReceived->erase(aReceived->begin(), aReceived->begin() + tPosition);
+}
+
+/*
+ * Simulator commands
+ */
+static bool savePPM(const char * aFilename) {
+    FILE * tFile = fopen(aFilename, "wb");
+    if (tFile == NULL) {
+        printf("Cannot open %s: %s\n", aFilename, strerror(errno));
+        return false;
+    }
+    fprintf(tFile, "P6\n%u %u\n255\n", sDisplayWidth, sDisplayHeight);
+    for (size_t i = 0; i < sFrameBuffer.size(); ++i) {
+        Color_t tColor = sFrameBuffer[i];
+        uint8_t tRGB[3] = { (uint8_t) GET_RED(tColor), (uint8_t) GET_GREEN(tColor), (uint8_t) GET_BLUE(tColor) };
+        fwrite(tRGB, 1, sizeof(tRGB), tFile);
+    }
+    fclose(tFile);
+    return true;
+}
+
+static bool sTouchIsDown;
+static bool sTouchDownConsumed; // touch down was on a button or slider, so no touch events are sent until up
+static int sCapturedSlider = -1;
+
+/**
+ * Hit test like the app: buttons first, then sliders, otherwise a plain touch event.
+ */
+static void touchDown(uint16_t aPositionX, uint16_t aPositionY) {
+    sTouchIsDown = true;
+    sTouchDownConsumed = true;
+    for (size_t i = 0; i < sButtons.size(); ++i) {
+        struct SimulatedButton * tButton = &sButtons[i];
+        if (tButton->IsActive && aPositionX >= tButton->PositionX && aPositionX < tButton->PositionX + tButton->WidthX
+                && aPositionY >= tButton->PositionY && aPositionY < tButton->PositionY + tButton->HeightY) {
+            sendButtonCallback(i);
+            return;
+        }
+    }
+    for (size_t i = 0; i < sSliders.size(); ++i) {
+        struct SimulatedSlider * tSlider = &sSliders[i];
+        if (tSlider->IsActive && aPositionX >= tSlider->PositionX && aPositionX < tSlider->PositionX + getSliderWidthX(tSlider)
+                && aPositionY >= tSlider->PositionY && aPositionY < tSlider->PositionY + getSliderHeightY(tSlider)) {
+            sCapturedSlider = i;
+            sendSliderCallback(i, getSliderValue(tSlider, aPositionX, aPositionY));
+            return;
+        }
+    }
+    sTouchDownConsumed = false;
+    sendTouchEvent(EVENT_TOUCH_ACTION_DOWN, aPositionX, aPositionY);
+}
+
+static void touchMove(uint16_t aPositionX, uint16_t aPositionY) {
+    if (sCapturedSlider >= 0) {
+        sendSliderCallback(sCapturedSlider, getSliderValue(&sSliders[sCapturedSlider], aPositionX, aPositionY));
+    } else if (sTouchIsDown && !sTouchDownConsumed) {
+        sendTouchEvent(EVENT_TOUCH_ACTION_MOVE, aPositionX, aPositionY);
+    }
+}
+
+static void touchUp(uint16_t aPositionX, uint16_t aPositionY) {
+    if (sTouchIsDown && !sTouchDownConsumed) {
+        sendTouchEvent(EVENT_TOUCH_ACTION_UP, aPositionX, aPositionY);
+    }
+    sTouchIsDown = false;
+    sCapturedSlider = -1;
+}
+
+static void printHelp(void) {
+    printf("touch <x> <y>          down and up, hits buttons and sliders like the app\n"
+            "down|move|up <x> <y>   single touch events\n"
+            "button <index>         button callback, red/green buttons toggle their value\n"
+            "slider <index> <value> slider callback\n"
+            "connect|redraw         send EVENT_CONNECTION_BUILD_UP or EVENT_REDRAW\n"
+            "wait <millis>          process received commands for the given time\n"
+            "save <ppm file>        save display content\n"
+            "stats                  print statistics per function tag\n"
+            "reset                  reset statistics\n"
+            "quit\n");
+}
+
+/**
+ * @return false if simulator should exit
+ */
+static bool executeCommandLine(char * aLine, uint64_t * aWaitUntilNanos) {
+    char tCommand[32];
+    char tArgument[COMMAND_LINE_LENGTH];
+    int tX = 0;
+    int tY = 0;
+    tArgument[0] = '\0';
+    if (sscanf(aLine, "%31s", tCommand) != 1 || tCommand[0] == '#') {
+        return true; // empty line or comment
+    }
+    int tNumberOfArguments = sscanf(aLine, "%*s %d %d", &tX, &tY);
+    sscanf(aLine, "%*s %255s", tArgument);
+
+    if (strcmp(tCommand, "touch") == 0 && tNumberOfArguments == 2) {
+        touchDown(tX, tY);
+        touchUp(tX, tY);
+    } else if (strcmp(tCommand, "down") == 0 && tNumberOfArguments == 2) {
+        touchDown(tX, tY);
+    } else if (strcmp(tCommand, "move") == 0 && tNumberOfArguments == 2) {
+        touchMove(tX, tY);
+    } else if (strcmp(tCommand, "up") == 0 && tNumberOfArguments == 2) {
+        touchUp(tX, tY);
+    } else if (strcmp(tCommand, "button") == 0 && tNumberOfArguments >= 1) {
+        if (tX < 0 || (size_t) tX >= sButtons.size()) {
+            printf("Button %d not created\n", tX);
+        } else {
+            sendButtonCallback(tX);
+        }
+    } else if (strcmp(tCommand, "slider") == 0 && tNumberOfArguments == 2) {
+        if (tX < 0 || (size_t) tX >= sSliders.size()) {
+            printf("Slider %d not created\n", tX);
+        } else {
+            sendSliderCallback(tX, tY);
+        }
+    } else if (strcmp(tCommand, "connect") == 0) {
+        // client registers its strings again
+        clearStringTable(&sRegisteredStrings);
+        sendDisplaySizeEvent(EVENT_CONNECTION_BUILD_UP);
+    } else if (strcmp(tCommand, "redraw") == 0) {
+        sendDisplaySizeEvent(EVENT_REDRAW);
+    } else if (strcmp(tCommand, "wait") == 0 && tNumberOfArguments >= 1) {
+        *aWaitUntilNanos = getHostNanos() + tX * 1000000ULL;
+    } else if (strcmp(tCommand, "save") == 0 && tArgument[0] != '\0') {
+        if (savePPM(tArgument)) {
+            printf("Saved %s\n", tArgument);
+        }
+    } else if (strcmp(tCommand, "stats") == 0) {
+        printStatistics();
+    } else if (strcmp(tCommand, "reset") == 0) {
+        resetStatistics();
+    } else if (strcmp(tCommand, "quit") == 0) {
+        return false;
+    } else {
+        printHelp();
+    }
+    fflush(stdout);
+    return true;
+}
+
+int main(int argc, char * argv[]) {
+    const char * tLinkName = NULL;
+    const char * tOutputFilename = NULL;
+    int tCommandFd = STDIN_FILENO;
+    int tOption;
+    while ((tOption = getopt(argc, argv, "d:l:o:")) != -1) {
+        unsigned int tWidth, tHeight;
+        switch (tOption) {
+        case 'd':
+            if (sscanf(optarg, "%ux%u", &tWidth, &tHeight) != 2 || tWidth == 0 || tHeight == 0) {
+                fprintf(stderr, "Invalid display size %s\n", optarg);
+                return 1;
+            }
+            sDisplayWidth = tWidth;
+            sDisplayHeight = tHeight;
+            break;
+        case 'l':
+            tLinkName = optarg;
+            break;
+        case 'o':
+            tOutputFilename = optarg;
+            break;
+        default:
+            fprintf(stderr, "Usage: %s [-d <width>x<height>] [-l <link name>] [-o <ppm file>] [<command file>]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (optind < argc) {
+        tCommandFd = open(argv[optind], O_RDONLY);
+        if (tCommandFd < 0) {
+            fprintf(stderr, "Cannot open %s: %s\n", argv[optind], strerror(errno));
+            return 1;
+        }
+    }
+
+    sMasterFd = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (sMasterFd < 0 || grantpt(sMasterFd) != 0 || unlockpt(sMasterFd) != 0) {
+        fprintf(stderr, "Cannot open pty: %s\n", strerror(errno));
+        return 1;
+    }
+    const char * tSlaveName = ptsname(sMasterFd);
+    // Keep slave open, so that the master gets no hang up if a client closes it, and set it raw for the clients
+    int tSlaveFd = open(tSlaveName, O_RDWR | O_NOCTTY);
+    struct termios tTermios;
+    tcgetattr(tSlaveFd, &tTermios);
+    cfmakeraw(&tTermios);
+    cfsetspeed(&tTermios, B115200);
+    tcsetattr(tSlaveFd, TCSANOW, &tTermios);
+    if (tLinkName != NULL) {
+        unlink(tLinkName);
+        if (symlink(tSlaveName, tLinkName) != 0) {
+            fprintf(stderr, "Cannot create link %s: %s\n", tLinkName, strerror(errno));
+        }
+    }
+    printf("BlueDisplay simulator %ux%u on %s\n", sDisplayWidth, sDisplayHeight, tSlaveName);
+    fflush(stdout);
+
+    sFrameBuffer.assign(sDisplayWidth * sDisplayHeight, COLOR_WHITE);
+    resetStatistics();
+    sendDisplaySizeEvent(EVENT_CONNECTION_BUILD_UP);
+
+    std::vector<uint8_t> tReceived;
+    char tCommandLine[COMMAND_LINE_LENGTH];
+    size_t tCommandLineLength = 0;
+    uint64_t tWaitUntilNanos = 0;
+    bool tCommandInputOpen = true;
+    while (tCommandInputOpen || getHostNanos() < tWaitUntilNanos) {
+        bool tIsWaiting = getHostNanos() < tWaitUntilNanos;
+        struct pollfd tPollFds[2] = { { sMasterFd, POLLIN, 0 }, { tCommandFd, POLLIN, 0 } };
+        poll(tPollFds, tIsWaiting ? 1 : 2, 10);
+
+        if (tPollFds[0].revents & POLLIN) {
+            uint8_t tBuffer[4096];
+            ssize_t tLength = read(sMasterFd, tBuffer, sizeof(tBuffer));
+            if (tLength > 0) {
+                tReceived.insert(tReceived.end(), tBuffer, tBuffer + tLength);
+                parseReceivedData(&tReceived);
+            }
+        }
+
+        /*
+         * Read one command input line at a time, so that "wait" delays the following commands
+         */
+        if (!tIsWaiting && (tPollFds[1].revents & (POLLIN | POLLHUP))) {
+            char tChar;
+            while (true) {
+                ssize_t tLength = read(tCommandFd, &tChar, 1);
+                if (tLength <= 0) {
+                    tCommandInputOpen = false;
+                    if (tCommandLineLength == 0) {
+                        break;
+                    }
+                    tChar = '\n'; // execute last line without newline
+                }
+                if (tChar != '\n' && tCommandLineLength < sizeof(tCommandLine) - 1) {
+                    tCommandLine[tCommandLineLength++] = tChar;
+                    continue;
+                }
+                tCommandLine[tCommandLineLength] = '\0';
+                tCommandLineLength = 0;
+                if (!executeCommandLine(tCommandLine, &tWaitUntilNanos)) {
+                    tCommandInputOpen = false;
+                    tWaitUntilNanos = 0;
+                }
+                break;
+            }
+        }
+    }
+
+    printStatistics();
+    if (tOutputFilename != NULL && savePPM(tOutputFilename)) {
+        printf("Saved %s\n", tOutputFilename);
+    }
+    if (tLinkName != NULL) {
+        unlink(tLinkName);
+    }
+    close(tSlaveFd);
+    close(sMasterFd);
+    return 0;
+}
+
+#endif // HOST_SIMULATION
@@ -0,0 +1,207 @@
+/**
+ * @file ButtonPoolBenchmark.cpp
+ *
+ * Host benchmark for page switches with the button pool of TouchPool.cpp, which the firmware uses with USE_BUTTON_POOL.
+ * Runs the real BDButton and TouchButton code with the local display emulated by MI0283QT2_Host.cpp.
+ *
+ * Before: the page stop function calls BDButton::deinit() for each button of the page.
+ * After: the page start function calls BDButton::startButtonPage() and the stop function
+ * frees all buttons of the page at once with BDButton::deinitAllButtonsOfPage().
+ *
+ * The main menu stays allocated, while the pages are started and stopped with the nesting of the firmware.
+ * The deepest nesting main menu/DSO/frequency generator/number pad needs all buttons of the pool.
+ * After each stop the buttons of the stopped page must be free and the buttons of the other pages still allocated.
+ *
+ * Build on x86 Linux from project root with: make -C tools/host build/ButtonPoolBenchmark
+ * and run it with: tools/host/build/ButtonPoolBenchmark
+ *
+ * Only compiled if HOST_SIMULATION is defined.
+ *
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ */
+
+#ifdef HOST_SIMULATION
+
+#include "BlueDisplay.h"
+#include "TouchButtonAutorepeat.h"
+#include "HostSupport.h"
+
+#include <stdio.h>
+
+const unsigned int REMOTE_DISPLAY_HEIGHT = 240;
+const unsigned int REMOTE_DISPLAY_WIDTH = 320;
+
+#define PAGE_MAIN_MENU 0
+#define PAGE_DSO 1
+#define PAGE_FREQUENCY_GENERATOR 2
+#define PAGE_NUMBER_PAD 3
+#define PAGE_SETTINGS 4
+#define PAGE_ACCU_CAPACITY 5
+#define NUMBER_OF_PAGES 6
+#define MAX_BUTTONS_OF_PAGE 26
+
+#define MAX_NESTING 3 // below the main menu
+#define NUMBER_OF_CYCLES 20000
+
+/*
+ * Number of buttons as in the start functions of the pages, the autorepeat buttons are the last ones
+ */
+struct Page {
+    const char * Name;
+    int NumberOfButtons;
+    int NumberOfAutorepeatButtons;
+};
+
+static const struct Page sPages[NUMBER_OF_PAGES] = { { "main menu", 13, 0 }, { "DSO", 26, 0 }, { "frequency generator",
+        17, 0 }, { "number pad", 16, 0 }, { "settings", 8, 4 }, { "AccuCapacity", 19, 2 } };
+
+/*
+ * One cycle visits these page nestings below the main menu, -1 ends a nesting
+ */
+static const int sPageNestings[][MAX_NESTING] = { { PAGE_DSO, PAGE_FREQUENCY_GENERATOR, PAGE_NUMBER_PAD }, {
+        PAGE_SETTINGS, -1, -1 }, { PAGE_ACCU_CAPACITY, PAGE_NUMBER_PAD, -1 } };
+#define NUMBER_OF_NESTINGS (sizeof(sPageNestings) / sizeof(sPageNestings[0]))
+
+static BDButton sButtons[NUMBER_OF_PAGES][MAX_BUTTONS_OF_PAGE];
+static bool sPageIsStarted[NUMBER_OF_PAGES];
+static bool sUsePageFree;
+
+static void doButton(BDButton * aTheTouchedButton, int16_t aValue) {
+}
+
+static void startPage(int aPage) {
+    if (sUsePageFree) {
+        BDButton::startButtonPage();
+    }
+    const struct Page * tPage = &sPages[aPage];
+    for (int i = 0; i < tPage->NumberOfButtons; ++i) {
+        uint8_t tFlags = BUTTON_FLAG_DO_BEEP_ON_TOUCH;
+        if (i >= tPage->NumberOfButtons - tPage->NumberOfAutorepeatButtons) {
+            tFlags |= BUTTON_FLAG_TYPE_AUTOREPEAT;
+        }
+        sButtons[aPage][i].init((i % 3) * BUTTON_WIDTH_3_POS_2, (i / 3 % 4) * BUTTON_HEIGHT_4_LINE_2, BUTTON_WIDTH_3,
+        BUTTON_HEIGHT_4, COLOR_RED, "Button", TEXT_SIZE_11, tFlags, aPage * MAX_BUTTONS_OF_PAGE + i, &doButton);
+    }
+    sPageIsStarted[aPage] = true;
+}
+
+/*
+ * Like the stop functions, which deinit the buttons in reverse order of init
+ */
+static void stopPage(int aPage) {
+    if (sUsePageFree) {
+        BDButton::deinitAllButtonsOfPage();
+    } else {
+        for (int i = sPages[aPage].NumberOfButtons - 1; i >= 0; --i) {
+            sButtons[aPage][i].deinit();
+        }
+    }
+    sPageIsStarted[aPage] = false;
+}
+
+static bool sAllChecksPassed = true;
+
+static void check(bool aCondition, const char * aMessage) {
+    if (!aCondition) {
+        printf("FAILED: %s\n", aMessage);
+        sAllChecksPassed = false;
+    }
+}
+
+/*
+ * Buttons of started pages must be allocated with their value, all others free.
+ * The button stack pointer sLocalButtonIndex must be the number of allocated buttons.
+ */
+static void checkAllocatedButtons(void) {
+    int tNumberOfAllocatedButtons = 0;
+    bool tAllocationOK = true;
+    for (int tPage = 0; tPage < NUMBER_OF_PAGES; ++tPage) {
+        for (int i = 0; i < sPages[tPage].NumberOfButtons; ++i) {
+            TouchButton * tButton = sButtons[tPage][i].mLocalButtonPtr;
+            if (!sPageIsStarted[tPage]) {
+                // a free button may be reused by another page
+                continue;
+            }
+            tNumberOfAllocatedButtons++;
+            if (!tButton->isAllocated() || tButton->mValue != tPage * MAX_BUTTONS_OF_PAGE + i
+                    || tButton->mBDButtonPtr != &sButtons[tPage][i]) {
+                tAllocationOK = false;
+            }
+        }
+    }
+    check(tAllocationOK, "button of started page not allocated");
+    check(sLocalButtonIndex == tNumberOfAllocatedButtons, "wrong sLocalButtonIndex");
+
+    char tInfo[80];
+    TouchButton::infoButtonPool(tInfo);
+    int tTotal, tFree, tUsed, tUsedAutorepeat;
+    sscanf(tInfo, "total=%d free=%d used=%d+%d", &tTotal, &tFree, &tUsed, &tUsedAutorepeat);
+    check(tUsed + tUsedAutorepeat == tNumberOfAllocatedButtons, "wrong number of allocated pool buttons");
+    check(tTotal - tFree == tNumberOfAllocatedButtons, "wrong number of free buttons in button list");
+}
+
+/*
+ * @return nanoseconds for all cycles
+ */
+static uint64_t runPageSwitches(int aNumberOfCycles, bool aDoCheck) {
+    uint64_t tStartNanos = getHostNanos();
+    for (int tCycle = 0; tCycle < aNumberOfCycles; ++tCycle) {
+        for (unsigned int tNesting = 0; tNesting < NUMBER_OF_NESTINGS; ++tNesting) {
+            int tLevel = 0;
+            while (tLevel < MAX_NESTING && sPageNestings[tNesting][tLevel] >= 0) {
+                startPage(sPageNestings[tNesting][tLevel++]);
+                if (aDoCheck) {
+                    checkAllocatedButtons();
+                }
+            }
+            while (tLevel > 0) {
+                stopPage(sPageNestings[tNesting][--tLevel]);
+                if (aDoCheck) {
+                    checkAllocatedButtons();
+                }
+            }
+        }
+    }
+    return getHostNanos() - tStartNanos;
+}
+
+int main(void) {
+    HostBluetoothPaired = false;
+    int tNumberOfPageSwitches = 0;
+    for (unsigned int tNesting = 0; tNesting < NUMBER_OF_NESTINGS; ++tNesting) {
+        for (int tLevel = 0; tLevel < MAX_NESTING && sPageNestings[tNesting][tLevel] >= 0; ++tLevel) {
+            tNumberOfPageSwitches += NUMBER_OF_CYCLES;
+        }
+    }
+
+    uint64_t tNanos[2];
+    for (int tVariant = 0; tVariant < 2; ++tVariant) {
+        sUsePageFree = tVariant;
+        startPage(PAGE_MAIN_MENU);
+        runPageSwitches(1, true);
+        tNanos[tVariant] = runPageSwitches(NUMBER_OF_CYCLES, false);
+        runPageSwitches(1, true);
+        stopPage(PAGE_MAIN_MENU);
+        checkAllocatedButtons();
+    }
+
+    char tInfo[80];
+    TouchButton::infoButtonPool(tInfo);
+    int tTotal, tFree, tUsed, tUsedAutorepeat, tMax, tMaxAutorepeat;
+    sscanf(tInfo, "total=%d free=%d used=%d+%d max=%d+%d", &tTotal, &tFree, &tUsed, &tUsedAutorepeat, &tMax,
+            &tMaxAutorepeat);
+    check(tMax == NUMBER_OF_BUTTONS_IN_POOL, "deepest nesting must use the whole pool");
+    check(tMaxAutorepeat <= NUMBER_OF_AUTOREPEAT_BUTTONS_IN_POOL, "autorepeat pool too small");
+
+    printf("%d page starts and stops, %d + %d buttons in pool\n", tNumberOfPageSwitches, NUMBER_OF_BUTTONS_IN_POOL,
+    NUMBER_OF_AUTOREPEAT_BUTTONS_IN_POOL);
+    printf("%s\n", tInfo);
+    printf("deinit() of each button          %8.1f ns per page start and stop\n",
+            (double) tNanos[0] / tNumberOfPageSwitches);
+    printf("deinitAllButtonsOfPage()         %8.1f ns per page start and stop\n",
+            (double) tNanos[1] / tNumberOfPageSwitches);
+    printf("all checks %s\n", sAllChecksPassed ? "passed" : "FAILED");
+    return sAllChecksPassed ? 0 : 1;
+}
+
+#endif // HOST_SIMULATION
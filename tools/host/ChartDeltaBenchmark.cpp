@@ -0,0 +1,182 @@
+/**
+ * @file ChartDeltaBenchmark.cpp
+ *
+ * Host decoder and benchmark for FUNCTION_DRAW_CHART_DELTA.
+ * Sends 320 column DSO traces of typical signals with and without delta encoding over the simulated link
+ * of BlueSerial_Host.cpp, decodes the resulting byte stream like the remote side has to do
+ * and checks the decoded charts against the sent ones.
+ * Prints bytes per frame and the frames/s the link allows at 115200 (HC-05 default) and 921600 baud.
+ *
+ * Build on x86 Linux from project root with: make -C tools/host build/ChartDeltaBenchmark
+ * and run it with: tools/host/build/ChartDeltaBenchmark
+ *
+ * Only compiled if HOST_SIMULATION is defined.
+ *
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ */
+
+#ifdef HOST_SIMULATION
+
+#include "BlueDisplay.h"
+#include "ChartDelta.h"
+#include "HostSupport.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#define NUMBER_OF_FRAMES 256
+#define CHART_LENGTH 320
+#define CHART_HEIGHT 240
+
+const unsigned int REMOTE_DISPLAY_HEIGHT = 240;
+const unsigned int REMOTE_DISPLAY_WIDTH = 320;
+
+enum SignalType {
+    SIGNAL_TRIGGERED_SINE, SIGNAL_TRIGGERED_SQUARE, SIGNAL_DC, SIGNAL_ROLLING_SINE, SIGNAL_NOISE, NUMBER_OF_SIGNALS
+};
+static const char * const sSignalNames[] = { "triggered sine", "triggered square", "DC", "untriggered sine", "full noise" };
+
+static uint32_t sRandomSeed;
+
+static int getRandom(int aRange) {
+    sRandomSeed = sRandomSeed * 1103515245 + 12345;
+    return (sRandomSeed >> 16) % aRange;
+}
+
+/*
+ * Generates display values like the DSO does. aNoise is the peak to peak ADC noise in pixel.
+ */
+static void generateChart(SignalType aSignalType, int aFrameNumber, uint8_t * aChart) {
+    for (int i = 0; i < CHART_LENGTH; ++i) {
+        int tValue;
+        switch (aSignalType) {
+        case SIGNAL_TRIGGERED_SINE:
+            tValue = 120 + 80 * sin(i * 2 * M_PI / 100) + getRandom(3) - 1;
+            break;
+        case SIGNAL_TRIGGERED_SQUARE:
+            // trigger jitter of one column
+            tValue = (((i + (aFrameNumber & 1)) / 50) & 1) ? 40 : 200;
+            tValue += getRandom(3) - 1;
+            break;
+        case SIGNAL_DC:
+            tValue = 160 + getRandom(3) - 1;
+            break;
+        case SIGNAL_ROLLING_SINE:
+            tValue = 120 + 80 * sin((i + aFrameNumber * 7) * 2 * M_PI / 100) + getRandom(3) - 1;
+            break;
+        default:
+            tValue = getRandom(CHART_HEIGHT);
+            break;
+        }
+        aChart[i] = tValue;
+    }
+}
+
+/*
+ * Remote side
+ */
+static std::vector<uint8_t> sLinkData;
+static uint8_t sDecodedCharts[16][CHART_LENGTH];
+static uint32_t sDecodedChartCount;
+static uint32_t sDecodeErrors;
+
+static void captureLinkData(const uint8_t * aData, size_t aLength) {
+    sLinkData.insert(sLinkData.end(), aData, aData + aLength);
+}
+
+static uint16_t getShort(const uint8_t * aPointer) {
+    return aPointer[0] | (aPointer[1] << 8);
+}
+
+/**
+ * Decodes all complete commands in sLinkData.
+ * Keeps the last chart for each chart index as reference for the next delta.
+ */
+static void decodeLinkData(void) {
+    size_t tPosition = 0;
+    while (tPosition + 4 <= sLinkData.size()) {
+        const uint8_t * tCommand = &sLinkData[tPosition];
+        if (tCommand[0] != SYNC_TOKEN) {
+            sDecodeErrors++;
+            tPosition++;
+            continue;
+        }
+        uint8_t tFunctionTag = tCommand[1];
+        uint16_t tParameterLength = getShort(&tCommand[2]);
+        size_t tCommandLength = 4 + tParameterLength;
+        const uint8_t * tData = NULL;
+        uint16_t tDataLength = 0;
+        if (tFunctionTag > INDEX_LAST_FUNCTION_WITHOUT_DATA) {
+            tData = tCommand + tCommandLength + 4;
+            tDataLength = getShort(tCommand + tCommandLength + 2);
+            tCommandLength += 4 + tDataLength;
+        }
+        if (tPosition + tCommandLength > sLinkData.size()) {
+            break;
+        }
+        const uint8_t * tParameter = &tCommand[4];
+        if (tFunctionTag == FUNCTION_DRAW_CHART || tFunctionTag == FUNCTION_DRAW_CHART_WITHOUT_DIRECT_RENDERING) {
+            uint8_t tChartIndex = getShort(&tParameter[2]) >> 12;
+            memcpy(sDecodedCharts[tChartIndex], tData, tDataLength);
+            sDecodedChartCount++;
+        } else if (tFunctionTag == FUNCTION_DRAW_CHART_DELTA
+                || tFunctionTag == FUNCTION_DRAW_CHART_DELTA_WITHOUT_DIRECT_RENDERING) {
+            uint8_t tChartIndex = getShort(&tParameter[2]) >> 12;
+            if (!decodeChartDelta(tData, tDataLength, sDecodedCharts[tChartIndex], getShort(&tParameter[8]))) {
+                sDecodeErrors++;
+            }
+            sDecodedChartCount++;
+        }
+        tPosition += tCommandLength;
+    }
+    sLinkData.erase(sLinkData.begin(), sLinkData.begin() + tPosition);
+}
+
+static void runBenchmark(SignalType aSignalType, uint32_t aBaudRate, bool aUseDelta) {
+    uint8_t tChart[CHART_LENGTH];
+    UART_BD_initialize(aBaudRate);
+    hostResetLinkCounters();
+    BlueDisplay1.setChartDeltaEncoding(aUseDelta);
+    sRandomSeed = 42;
+    sDecodedChartCount = 0;
+    sDecodeErrors = 0;
+    uint32_t tMismatches = 0;
+
+    uint64_t tHostNanos = 0;
+    for (int i = 0; i < NUMBER_OF_FRAMES; ++i) {
+        generateChart(aSignalType, i, tChart);
+        uint64_t tHostStart = getHostNanos();
+        BlueDisplay1.drawChartByteBuffer(0, 0, COLOR_BLUE, COLOR_WHITE, 0, true, tChart, CHART_LENGTH);
+        tHostNanos += getHostNanos() - tHostStart;
+        hostFlushLink();
+        decodeLinkData();
+        if (memcmp(tChart, sDecodedCharts[0], CHART_LENGTH) != 0) {
+            tMismatches++;
+        }
+    }
+
+    double tSeconds = HostLinkNanos / 1e9;
+    printf("%-16s %7u baud %-5s: %6.1f bytes/frame %6.1f frames/s  (host %5.0f ns/frame, %u frames decoded, %u errors)\n",
+            sSignalNames[aSignalType], aBaudRate, aUseDelta ? "delta" : "plain",
+            (double) HostLinkCounters.Bytes / NUMBER_OF_FRAMES, NUMBER_OF_FRAMES / tSeconds,
+            (double) tHostNanos / NUMBER_OF_FRAMES, sDecodedChartCount, sDecodeErrors + tMismatches);
+}
+
+int main(void) {
+    HostBluetoothPaired = true;
+    HostLinkWriteCallback = &captureLinkData;
+    printf("%d frames of %d columns, key frame every %d frames\n", NUMBER_OF_FRAMES, CHART_LENGTH,
+    CHART_DELTA_KEY_FRAME_INTERVAL);
+    uint32_t tBaudRates[] = { BAUD_115200, BAUD_921600 };
+    for (unsigned int i = 0; i < sizeof(tBaudRates) / sizeof(tBaudRates[0]); ++i) {
+        for (int tSignal = 0; tSignal < NUMBER_OF_SIGNALS; ++tSignal) {
+            runBenchmark((SignalType) tSignal, tBaudRates[i], false);
+            runBenchmark((SignalType) tSignal, tBaudRates[i], true);
+        }
+    }
+    return 0;
+}
+
+#endif // HOST_SIMULATION
@@ -0,0 +1,161 @@
+/**
+ * @file CommandEncoderBenchmark.cpp
+ *
+ * Host micro benchmark for the command encoders of BlueSerial.h.
+ * Sends drawPixel, drawLine and drawText commands with the va_list based sendUSARTArgs() and sendUSARTArgsAndByteBuffer(),
+ * with the fixed sendUSART5Args() and sendUSART5ArgsAndByteBuffer() and with the templates sendUSARTCommand()
+ * and sendUSARTCommandAndByteBuffer().
+ * Prints host CPU cycles (TSC on x86) and nanoseconds per command including the copy into the send buffer,
+ * and checks that all encoders produce the same bytes on the link.
+ *
+ * Build on x86 Linux from project root with: make -C tools/host build/CommandEncoderBenchmark
+ * and run it with: tools/host/build/CommandEncoderBenchmark
+ *
+ * Only compiled if HOST_SIMULATION is defined.
+ *
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ */
+
+#ifdef HOST_SIMULATION
+
+#include "BlueDisplay.h"
+#include "HostSupport.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define getHostCycles() __rdtsc()
+#else
+#define getHostCycles() 0ULL
+#endif
+
+#define NUMBER_OF_COMMANDS 200000
+#define NUMBER_OF_CHECKED_COMMANDS 100
+#define TEXT_LENGTH 11
+
+const unsigned int REMOTE_DISPLAY_HEIGHT = 240;
+const unsigned int REMOTE_DISPLAY_WIDTH = 320;
+
+enum CommandType {
+    COMMAND_DRAW_PIXEL, COMMAND_DRAW_LINE, COMMAND_DRAW_TEXT, NUMBER_OF_COMMAND_TYPES
+};
+static const char * const sCommandNames[] = { "drawPixel", "drawLine", "drawText" };
+
+enum EncoderType {
+    ENCODER_VA_LIST, ENCODER_FIXED_5_ARGS, ENCODER_TEMPLATE, NUMBER_OF_ENCODER_TYPES
+};
+static const char * const sEncoderNames[] = { "va_list", "5 args", "template" };
+
+static const char sText[TEXT_LENGTH + 1] = "12.34 V/div";
+
+static bool sCaptureLinkData;
+static std::vector<uint8_t> sLinkData;
+
+static void captureLinkData(const uint8_t * aData, size_t aLength) {
+    if (sCaptureLinkData) {
+        sLinkData.insert(sLinkData.end(), aData, aData + aLength);
+    }
+}
+
+static void sendCommand(CommandType aCommandType, EncoderType aEncoderType, uint16_t i) {
+    uint16_t tX = i % REMOTE_DISPLAY_WIDTH;
+    uint16_t tY = i % REMOTE_DISPLAY_HEIGHT;
+    switch (aCommandType) {
+    case COMMAND_DRAW_PIXEL:
+        if (aEncoderType == ENCODER_TEMPLATE) {
+            sendUSARTCommand<FUNCTION_DRAW_PIXEL>(tX, tY, COLOR_RED);
+        } else {
+            // there is no fixed 3 args function
+            sendUSARTArgs(FUNCTION_DRAW_PIXEL, 3, tX, tY, COLOR_RED);
+        }
+        break;
+    case COMMAND_DRAW_LINE:
+        if (aEncoderType == ENCODER_TEMPLATE) {
+            sendUSARTCommand<FUNCTION_DRAW_LINE>(tX, tY, (uint16_t) (tX + 10), (uint16_t) (tY + 10), COLOR_RED);
+        } else if (aEncoderType == ENCODER_FIXED_5_ARGS) {
+            sendUSART5Args(FUNCTION_DRAW_LINE, tX, tY, tX + 10, tY + 10, COLOR_RED);
+        } else {
+            sendUSARTArgs(FUNCTION_DRAW_LINE, 5, tX, tY, tX + 10, tY + 10, COLOR_RED);
+        }
+        break;
+    default:
+        if (aEncoderType == ENCODER_TEMPLATE) {
+            sendUSARTCommandAndByteBuffer<FUNCTION_DRAW_STRING>(sText, TEXT_LENGTH, tX, tY, (uint16_t) TEXT_SIZE_11, COLOR_BLACK,
+                    COLOR_WHITE);
+        } else if (aEncoderType == ENCODER_FIXED_5_ARGS) {
+            sendUSART5ArgsAndByteBuffer(FUNCTION_DRAW_STRING, tX, tY, TEXT_SIZE_11, COLOR_BLACK, COLOR_WHITE, (uint8_t*) sText,
+            TEXT_LENGTH);
+        } else {
+            sendUSARTArgsAndByteBuffer(FUNCTION_DRAW_STRING, 5, tX, tY, TEXT_SIZE_11, COLOR_BLACK, COLOR_WHITE, TEXT_LENGTH,
+                    sText);
+        }
+        break;
+    }
+}
+
+/**
+ * Sends the commands in frames of 32 commands, which fit into the send buffer.
+ * So every command is copied to the send buffer and the simulated DMA transfer is started only once per frame.
+ * @return true if link data is the same as for the reference encoder
+ */
+static bool runBenchmark(CommandType aCommandType, EncoderType aEncoderType, std::vector<uint8_t> * aReferenceData) {
+    UART_BD_initialize(BAUD_921600);
+    hostResetLinkCounters();
+
+    // reference bytes
+    sLinkData.clear();
+    sCaptureLinkData = true;
+    for (int i = 0; i < NUMBER_OF_CHECKED_COMMANDS; ++i) {
+        sendCommand(aCommandType, aEncoderType, i);
+    }
+    hostFlushLink();
+    sCaptureLinkData = false;
+    bool tDataOK = true;
+    if (aReferenceData->empty()) {
+        *aReferenceData = sLinkData;
+    } else {
+        tDataOK = (*aReferenceData == sLinkData);
+    }
+
+    uint64_t tNanos = 0;
+    uint64_t tCycles = 0;
+    for (int i = 0; i < NUMBER_OF_COMMANDS; i += 32) {
+        startSendFrame();
+        uint64_t tStartNanos = getHostNanos();
+        uint64_t tStartCycles = getHostCycles();
+        for (int j = i; j < i + 32; ++j) {
+            sendCommand(aCommandType, aEncoderType, j);
+        }
+        tCycles += getHostCycles() - tStartCycles;
+        tNanos += getHostNanos() - tStartNanos;
+        endSendFrame();
+        hostFlushLink();
+    }
+
+    printf("%-9s %-8s: %6.1f cycles %5.1f ns per command, link data %s\n", sCommandNames[aCommandType],
+            sEncoderNames[aEncoderType], (double) tCycles / NUMBER_OF_COMMANDS, (double) tNanos / NUMBER_OF_COMMANDS,
+            tDataOK ? "identical" : "DIFFERS");
+    return tDataOK;
+}
+
+int main(void) {
+    HostBluetoothPaired = true;
+    HostLinkWriteCallback = &captureLinkData;
+
+    printf("%d commands in frames of 32 commands, host CPU time including copy into send buffer\n", NUMBER_OF_COMMANDS);
+    bool tAllOK = true;
+    for (int tCommand = 0; tCommand < NUMBER_OF_COMMAND_TYPES; ++tCommand) {
+        std::vector<uint8_t> tReferenceData;
+        for (int tEncoder = 0; tEncoder < NUMBER_OF_ENCODER_TYPES; ++tEncoder) {
+            if (tCommand == COMMAND_DRAW_PIXEL && tEncoder == ENCODER_FIXED_5_ARGS) {
+                continue;
+            }
+            tAllOK &= runBenchmark((CommandType) tCommand, (EncoderType) tEncoder, &tReferenceData);
+        }
+    }
+    return tAllOK ? 0 : 1;
+}
+
+#endif // HOST_SIMULATION
@@ -0,0 +1,212 @@
+/**
+ * @file CooperativeTaskBenchmark.cpp
+ *
+ * Host simulation of the event latency during a screenshot, which blocks the main loop or runs as cooperative task.
+ * The screenshot is modelled like screenshotTask() of MI0283QT2.cpp, with simulated time for opening the file,
+ * for reading and writing each chunk of 4 display lines and for closing the file.
+ * Before, storeScreenshot() was called by the user button ISR and wrote the whole BMP file at once.
+ * After, it starts the task, which writes one chunk at each call of checkAndHandleEvents().
+ *
+ * The remote app sends taps at 115200 baud with pseudo random gaps of 5 to 15 ms.
+ * Prints the duration of the screenshot, the longest time between two calls of checkAndHandleEvents(),
+ * the number of messages received while the screenshot is running, the number of them lost by overflow of the receive buffer
+ * and the mean and maximum latency from end of a received message until its touch callback.
+ *
+ * Build on x86 Linux from project root with: make -C tools/host build/CooperativeTaskBenchmark
+ * and run it with: tools/host/build/CooperativeTaskBenchmark
+ *
+ * Only compiled if HOST_SIMULATION is defined.
+ *
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ */
+
+#ifdef HOST_SIMULATION
+
+#include "BlueDisplay.h"
+#include "EventHandler.h"
+#include "CooperativeTask.h"
+#include "HostSupport.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define MAIN_LOOP_NANOS 5000
+#define SIMULATION_NANOS 2000000000ULL
+#define SCREENSHOT_START_NANOS 500000000ULL
+/*
+ * Assumed times on the F303 at 72 MHz with SD card at 18 MHz SPI
+ */
+#define SCREENSHOT_OPEN_NANOS 20000000 // f_open() with directory update and header write
+#define SCREENSHOT_CHUNK_NANOS 2500000 // reading 4 display lines and f_write() of 2560 bytes
+#define SCREENSHOT_CLOSE_NANOS 10000000 // f_close() with FAT update
+#define SCREENSHOT_CHUNKS (240 / 4)
+
+#define TOUCH_MESSAGE_SIZE 8 // length, event type, 5 byte TouchEvent and sync token
+#define MESSAGE_NANOS (TOUCH_MESSAGE_SIZE * 10 * 1000000000ULL / 115200)
+#define MAX_MESSAGES 512
+
+const unsigned int REMOTE_DISPLAY_HEIGHT = 240;
+const unsigned int REMOTE_DISPLAY_WIDTH = 320;
+
+/*
+ * Remote side
+ */
+static uint64_t sMessageCompleteNanos[MAX_MESSAGES];
+static int sNumberOfMessages;
+static int sNextMessageIndex;
+static int sNumberOfHandledMessages;
+
+static void createMessages(void) {
+    uint32_t tRandom = 12345;
+    uint64_t tStartNanos = 100 * 1000000ULL;
+    sNumberOfMessages = 0;
+    while (sNumberOfMessages < MAX_MESSAGES && tStartNanos < SIMULATION_NANOS - 100 * 1000000ULL) {
+        sMessageCompleteNanos[sNumberOfMessages++] = tStartNanos + MESSAGE_NANOS;
+        tRandom = tRandom * 1103515245 + 12345;
+        tStartNanos += (5 + (tRandom >> 16) % 10) * 1000000ULL + 123457;
+    }
+}
+
+static void feedMessagesUntilLinkTime(void) {
+    while (sNextMessageIndex < sNumberOfMessages && sMessageCompleteNanos[sNextMessageIndex] <= HostLinkNanos) {
+        // alternating down and up, x position is message index
+        uint8_t tMessage[TOUCH_MESSAGE_SIZE] = { TOUCH_MESSAGE_SIZE, (uint8_t) (
+                (sNextMessageIndex & 1) ? EVENT_TOUCH_ACTION_UP : EVENT_TOUCH_ACTION_DOWN), (uint8_t) sNextMessageIndex,
+                (uint8_t) (sNextMessageIndex >> 8), 100, 0, 0, SYNC_TOKEN };
+        hostReceiveBytes(tMessage, TOUCH_MESSAGE_SIZE);
+        sNextMessageIndex++;
+    }
+}
+
+/*
+ * Local side
+ */
+static uint64_t sScreenshotStartNanos;
+static uint64_t sScreenshotEndNanos;
+
+struct RunResult {
+    uint32_t Messages; // received during screenshot
+    uint64_t SumLatencyNanos;
+    uint64_t MaxLatencyNanos;
+    uint64_t MaxLoopNanos; // longest time between two calls of checkAndHandleEvents()
+};
+static struct RunResult sResult;
+
+static void recordEvent(struct TouchEvent * aActualPositionPtr) {
+    uint64_t tCompleteNanos = sMessageCompleteNanos[aActualPositionPtr->TouchPosition.PosX];
+    sNumberOfHandledMessages++;
+    if (tCompleteNanos >= sScreenshotStartNanos && (sScreenshotEndNanos == 0 || tCompleteNanos < sScreenshotEndNanos)) {
+        uint64_t tLatencyNanos = HostLinkNanos - tCompleteNanos;
+        sResult.Messages++;
+        sResult.SumLatencyNanos += tLatencyNanos;
+        if (sResult.MaxLatencyNanos < tLatencyNanos) {
+            sResult.MaxLatencyNanos = tLatencyNanos;
+        }
+    }
+}
+
+/*
+ * Old variant, the whole file at once
+ */
+static void storeScreenshotBlocking(void) {
+    hostAdvanceLinkTime(SCREENSHOT_OPEN_NANOS);
+    for (int i = 0; i < SCREENSHOT_CHUNKS; ++i) {
+        hostAdvanceLinkTime(SCREENSHOT_CHUNK_NANOS);
+    }
+    hostAdvanceLinkTime(SCREENSHOT_CLOSE_NANOS);
+    sScreenshotEndNanos = HostLinkNanos;
+}
+
+/*
+ * New variant, structured like screenshotTask()
+ */
+static struct CooperativeTask sScreenshotTask;
+static int sScreenshotChunk;
+
+static bool screenshotTask(struct CooperativeTask * aTask) {
+    TASK_BEGIN(aTask);
+    hostAdvanceLinkTime(SCREENSHOT_OPEN_NANOS);
+    for (sScreenshotChunk = 0; sScreenshotChunk < SCREENSHOT_CHUNKS; ++sScreenshotChunk) {
+        TASK_YIELD(aTask);
+        hostAdvanceLinkTime(SCREENSHOT_CHUNK_NANOS);
+    }
+    hostAdvanceLinkTime(SCREENSHOT_CLOSE_NANOS);
+    sScreenshotEndNanos = HostLinkNanos;
+    TASK_END(aTask);
+}
+
+static void run(bool aUseTask) {
+    memset(&sResult, 0, sizeof(sResult));
+    HostLinkNanos = 0;
+    UART_BD_initialize(BAUD_115200);
+    hostResetLinkCounters();
+    resetReceiveStatistics();
+    sNextMessageIndex = 0;
+    sNumberOfHandledMessages = 0;
+    sScreenshotStartNanos = SCREENSHOT_START_NANOS;
+    sScreenshotEndNanos = 0;
+    bool tScreenshotStarted = false;
+    uint64_t tLastLoopNanos = 0;
+
+    while (HostLinkNanos < SIMULATION_NANOS) {
+        if (sResult.MaxLoopNanos < HostLinkNanos - tLastLoopNanos) {
+            sResult.MaxLoopNanos = HostLinkNanos - tLastLoopNanos;
+        }
+        tLastLoopNanos = HostLinkNanos;
+        checkAndHandleEvents();
+        if (!tScreenshotStarted && HostLinkNanos >= SCREENSHOT_START_NANOS) {
+            tScreenshotStarted = true;
+            sScreenshotStartNanos = HostLinkNanos;
+            if (aUseTask) {
+                startCooperativeTask(&sScreenshotTask, &screenshotTask);
+            } else {
+                storeScreenshotBlocking();
+            }
+        }
+        hostAdvanceLinkTime(MAIN_LOOP_NANOS);
+    }
+}
+
+static bool sAllChecksPassed = true;
+
+static void printAndCheckResult(const char * aName) {
+    uint32_t tMessagesDuringScreenshot = 0;
+    for (int i = 0; i < sNumberOfMessages; ++i) {
+        if (sMessageCompleteNanos[i] >= sScreenshotStartNanos && sMessageCompleteNanos[i] < sScreenshotEndNanos) {
+            tMessagesDuringScreenshot++;
+        }
+    }
+    printf("%-16s %7.1f ms %7.2f ms %8u %5u %9.2f ms %9.2f ms\n", aName, (sScreenshotEndNanos - sScreenshotStartNanos) / 1e6,
+            sResult.MaxLoopNanos / 1e6, tMessagesDuringScreenshot, tMessagesDuringScreenshot - sResult.Messages,
+            sResult.Messages == 0 ? 0.0 : sResult.SumLatencyNanos / 1e6 / sResult.Messages, sResult.MaxLatencyNanos / 1e6);
+    if (sScreenshotEndNanos == 0) {
+        printf("%-16s FAILED: screenshot not finished\n", aName);
+        sAllChecksPassed = false;
+    }
+}
+
+int main(void) {
+    HostBluetoothPaired = true;
+    HostMillisFollowLinkTime = true;
+    HostLinkReadCallback = &feedMessagesUntilLinkTime;
+    registerTouchDownCallback(&recordEvent);
+    registerTouchUpCallback(&recordEvent);
+    createMessages();
+
+    printf("Screenshot with %d chunks of %.1f ms, open %.1f ms and close %.1f ms, touch messages every 5 to 15 ms\n",
+            SCREENSHOT_CHUNKS, SCREENSHOT_CHUNK_NANOS / 1e6, SCREENSHOT_OPEN_NANOS / 1e6, SCREENSHOT_CLOSE_NANOS / 1e6);
+    printf("%-16s %10s %10s %8s %5s %12s %12s\n", "", "screenshot", "max block", "messages", "lost", "mean lat.",
+            "max lat.");
+    run(false);
+    printAndCheckResult("blocking");
+    run(true);
+    printAndCheckResult("cooperative task");
+    if (sNumberOfHandledMessages != sNumberOfMessages) {
+        printf("cooperative task FAILED: %d of %d messages handled\n", sNumberOfHandledMessages, sNumberOfMessages);
+        sAllChecksPassed = false;
+    }
+    printf("all checks %s\n", sAllChecksPassed ? "passed" : "FAILED");
+    return sAllChecksPassed ? 0 : 1;
+}
+
+#endif // HOST_SIMULATION
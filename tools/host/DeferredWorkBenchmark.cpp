@@ -0,0 +1,393 @@
+/**
+ * @file DeferredWorkBenchmark.cpp
+ *
+ * Host simulation of the interrupt latencies of the Cortex-M4 at 72 MHz while DSO acquisition and IR receive are running,
+ * with and without deferring the IR decoding and the DMA error message to PendSV.
+ * The NVIC is simulated cycle by cycle: a pending interrupt preempts the running one if its priority value is lower,
+ * PendSV has the lowest priority 15 and the main loop disables interrupts for short critical sections.
+ * The deferred work is queued and executed by the code of DeferredWork.cpp.
+ *
+ * Interrupts and their assumed costs in cycles, priorities as set by stm32fx0xPeripherals.cpp and main.cpp:
+ *  ADC1_2 prio 1 every 10 us, 180 cycles for storing and trigger state machine.
+ *  UART prio 3, a 8 byte message every 5 ms at 115200 baud, 120 cycles per byte.
+ *  TIM15 (IR) prio 7 at 15 kHz, 80 cycles for irsnd_ISR() and the ISR itself.
+ *      Before, irmp_ISR() adds 60 cycles per sample, 150 at an edge and 900 for decoding at the end of a frame.
+ *      After, the sample is stored in 20 cycles and every 32. sample the work is queued in 40 cycles.
+ *  SysTick prio 8 every ms, 100 cycles.
+ *  DMA1_Channel1 (ADC) prio 13 every 2 ms, 40000 cycles for the trigger scan of DMACheckForTriggerCondition().
+ *      A DMA error occurs at DMA_ERROR_CYCLE. failParamMessage() takes 3 ms and is called by the ISR before
+ *      and by PendSV after.
+ * The main loop disables interrupts for 40 cycles with pseudo random gaps of 0 to 1 ms.
+ * A NEC frame with 32 bits is received every 108 ms.
+ *
+ * Prints the maximum latency from request to ISR entry for each interrupt, the number of overruns,
+ * the time from end of each IR frame until it is decoded and the number of decoded frames.
+ *
+ * Build on x86 Linux from project root with: make -C tools/host build/DeferredWorkBenchmark
+ * and run it with: tools/host/build/DeferredWorkBenchmark
+ *
+ * Only compiled if HOST_SIMULATION is defined.
+ *
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ */
+
+#ifdef HOST_SIMULATION
+
+#include "DeferredWork.h"
+
+#include <stdio.h>
+#include <string.h>
+
+const unsigned int REMOTE_DISPLAY_HEIGHT = 240;
+const unsigned int REMOTE_DISPLAY_WIDTH = 320;
+
+#define CYCLES_PER_MICROSECOND 72
+#define SIMULATION_CYCLES (1000000ULL * CYCLES_PER_MICROSECOND) // 1 second
+#define ENTRY_CYCLES 12 // stacking of registers
+
+#define ADC_PERIOD_CYCLES (10 * CYCLES_PER_MICROSECOND)
+#define ADC_CYCLES 180
+#define UART_MESSAGE_PERIOD_CYCLES (5000 * CYCLES_PER_MICROSECOND)
+#define UART_BYTE_CYCLES (10 * 1000000ULL * CYCLES_PER_MICROSECOND / 115200)
+#define UART_BYTES_PER_MESSAGE 8
+#define UART_CYCLES 120
+#define IR_PERIOD_CYCLES (1000000 * CYCLES_PER_MICROSECOND / 15000)
+#define IR_ISR_CYCLES 80
+#define IRMP_CYCLES 60
+#define IRMP_EDGE_CYCLES 150
+#define IRMP_DECODE_CYCLES 900
+#define IR_SAMPLE_CYCLES 20
+#define IR_QUEUE_CYCLES 40
+#define IR_SAMPLES_PER_WORK 32 // as in PageIR.cpp
+#define SYSTIC_PERIOD_CYCLES (1000 * CYCLES_PER_MICROSECOND)
+#define SYSTIC_CYCLES 100
+#define DMA_PERIOD_CYCLES (2000 * CYCLES_PER_MICROSECOND)
+#define DMA_CYCLES 40000
+#define DMA_ERROR_CYCLE (500000ULL * CYCLES_PER_MICROSECOND)
+#define DMA_ERROR_MESSAGE_CYCLES (3000 * CYCLES_PER_MICROSECOND)
+#define CRITICAL_SECTION_CYCLES 40 // e.g. startCooperativeTask() or the timer wheel
+
+/*
+ * IR signal of a NEC frame in samples of 66.7 us
+ */
+#define NEC_START_PULSE_SAMPLES 135 // 9 ms
+#define NEC_START_PAUSE_SAMPLES 68 // 4.5 ms
+#define NEC_PULSE_SAMPLES 8 // 560 us
+#define NEC_0_PAUSE_SAMPLES 8
+#define NEC_1_PAUSE_SAMPLES 25
+#define NEC_FRAME_PERIOD_SAMPLES 1620 // 108 ms
+#define NEC_FRAME_DATA 0x00FF04FB // address 0xFB04, command 0x00FF
+
+static uint8_t sIRSignal[NEC_FRAME_PERIOD_SAMPLES]; // 1 -> dark, since the receiver output is active low
+static int sIRFrameEndSample; // sample after the stop bit, where irmp decodes the frame
+
+static void createIRSignal(void) {
+    memset(sIRSignal, 1, sizeof(sIRSignal));
+    int tSample = 0;
+    memset(&sIRSignal[tSample], 0, NEC_START_PULSE_SAMPLES);
+    tSample += NEC_START_PULSE_SAMPLES + NEC_START_PAUSE_SAMPLES;
+    for (int i = 0; i < 32; ++i) {
+        memset(&sIRSignal[tSample], 0, NEC_PULSE_SAMPLES);
+        tSample += NEC_PULSE_SAMPLES + (((NEC_FRAME_DATA >> i) & 0x01) ? NEC_1_PAUSE_SAMPLES : NEC_0_PAUSE_SAMPLES);
+    }
+    // stop bit
+    memset(&sIRSignal[tSample], 0, NEC_PULSE_SAMPLES);
+    sIRFrameEndSample = tSample + NEC_PULSE_SAMPLES;
+}
+
+/*
+ * Interrupt sources
+ */
+#define SOURCE_ADC 0
+#define SOURCE_UART 1
+#define SOURCE_IR 2
+#define SOURCE_SYSTIC 3
+#define SOURCE_DMA 4
+#define SOURCE_PENDSV 5
+#define NUMBER_OF_SOURCES 6
+#define THREAD_PRIO 0x100
+
+struct InterruptSource {
+    const char * Name;
+    uint16_t Prio;
+    bool IsPending;
+    uint64_t RequestCycle;
+    uint32_t RemainingCycles; // of the running or preempted ISR
+    uint64_t MaxLatencyCycles;
+    uint32_t Overruns; // request while still pending
+};
+
+static struct InterruptSource sSources[NUMBER_OF_SOURCES];
+static int sActiveSources[NUMBER_OF_SOURCES + 1]; // stack of running and preempted ISRs
+static int sNumberOfActiveSources;
+
+static bool sUseDeferredWork;
+static uint64_t sCycle;
+static uint32_t sPendSVCycles; // accumulated by the deferred work while running
+
+static uint32_t sIRSampleIndex; // of the whole simulation
+static uint32_t sIRFirstSampleIndex;
+static uint8_t sIRSampleCount;
+static uint32_t sDecodedFrames;
+static uint64_t sMaxDecodeDelayCycles;
+static uint32_t sUARTBytesLeft;
+static bool sDMAErrorOccurred;
+
+static uint32_t irmpCycles(uint32_t aSampleIndex) {
+    uint32_t tSampleInFrame = aSampleIndex % NEC_FRAME_PERIOD_SAMPLES;
+    if ((int) tSampleInFrame == sIRFrameEndSample) {
+        return IRMP_DECODE_CYCLES;
+    }
+    if (tSampleInFrame > 0 && sIRSignal[tSampleInFrame] != sIRSignal[tSampleInFrame - 1]) {
+        return IRMP_EDGE_CYCLES;
+    }
+    return IRMP_CYCLES;
+}
+
+static void recordDecode(uint32_t aSampleIndex, uint64_t aDecodeEndCycle) {
+    if ((int) (aSampleIndex % NEC_FRAME_PERIOD_SAMPLES) == sIRFrameEndSample) {
+        sDecodedFrames++;
+        // frame end sample was requested at aSampleIndex * IR_PERIOD_CYCLES
+        uint64_t tDelay = aDecodeEndCycle - (uint64_t) aSampleIndex * IR_PERIOD_CYCLES;
+        if (sMaxDecodeDelayCycles < tDelay) {
+            sMaxDecodeDelayCycles = tDelay;
+        }
+    }
+}
+
+/*
+ * Deferred work, called by runDeferredWork() at start of PendSV. The cycles are then executed by PendSV.
+ */
+static void decodeIRSamples(uint32_t aFirstSampleIndex) {
+    for (uint32_t i = aFirstSampleIndex; i < aFirstSampleIndex + IR_SAMPLES_PER_WORK; ++i) {
+        sPendSVCycles += irmpCycles(i) + 4;
+        // decode is finished, when PendSV has spent these cycles, it is an estimation if PendSV is preempted
+        recordDecode(i, sCycle + sPendSVCycles);
+    }
+}
+
+static void signalDMAError(uint32_t aPeripheralAddress) {
+    (void) aPeripheralAddress;
+    sPendSVCycles += DMA_ERROR_MESSAGE_CYCLES;
+}
+
+/*
+ * @return cycles of ISR body
+ */
+static uint32_t runISR(int aSource) {
+    uint32_t tCycles = 0;
+    switch (aSource) {
+    case SOURCE_ADC:
+        tCycles = ADC_CYCLES;
+        break;
+    case SOURCE_UART:
+        tCycles = UART_CYCLES;
+        break;
+    case SOURCE_IR:
+        tCycles = IR_ISR_CYCLES;
+        if (sUseDeferredWork) {
+            tCycles += IR_SAMPLE_CYCLES;
+            if (sIRSampleCount == 0) {
+                sIRFirstSampleIndex = sIRSampleIndex;
+            }
+            sIRSampleCount++;
+            if (sIRSampleCount >= IR_SAMPLES_PER_WORK) {
+                tCycles += IR_QUEUE_CYCLES;
+                queueDeferredWork(DEFERRED_WORK_QUEUE_IR, &decodeIRSamples, sIRFirstSampleIndex);
+                sIRSampleCount = 0;
+                sSources[SOURCE_PENDSV].IsPending = true;
+            }
+        } else {
+            tCycles += irmpCycles(sIRSampleIndex);
+            recordDecode(sIRSampleIndex, sCycle + tCycles);
+        }
+        sIRSampleIndex++;
+        break;
+    case SOURCE_SYSTIC:
+        tCycles = SYSTIC_CYCLES;
+        break;
+    case SOURCE_DMA:
+        tCycles = DMA_CYCLES;
+        if (!sDMAErrorOccurred && sCycle >= DMA_ERROR_CYCLE) {
+            sDMAErrorOccurred = true;
+            if (sUseDeferredWork) {
+                tCycles += IR_QUEUE_CYCLES;
+                queueDeferredWork(DEFERRED_WORK_QUEUE_DSO, &signalDMAError, 0x40012440);
+                sSources[SOURCE_PENDSV].IsPending = true;
+            } else {
+                tCycles += DMA_ERROR_MESSAGE_CYCLES;
+            }
+        }
+        break;
+    case SOURCE_PENDSV:
+        sPendSVCycles = 0;
+        runDeferredWork();
+        tCycles = sPendSVCycles;
+        break;
+    }
+    return tCycles;
+}
+
+static void request(int aSource) {
+    struct InterruptSource * tSource = &sSources[aSource];
+    if (tSource->IsPending) {
+        tSource->Overruns++;
+    } else {
+        tSource->IsPending = true;
+        tSource->RequestCycle = sCycle;
+    }
+}
+
+static void initSource(int aSource, const char * aName, uint16_t aPrio) {
+    memset(&sSources[aSource], 0, sizeof(sSources[aSource]));
+    sSources[aSource].Name = aName;
+    sSources[aSource].Prio = aPrio;
+}
+
+static void run(bool aUseDeferredWork) {
+    sUseDeferredWork = aUseDeferredWork;
+    initDeferredWork();
+    initSource(SOURCE_ADC, "ADC", 1);
+    initSource(SOURCE_UART, "UART", 3);
+    initSource(SOURCE_IR, "TIM15 IR", 7);
+    initSource(SOURCE_SYSTIC, "SysTick", 8);
+    initSource(SOURCE_DMA, "DMA", 13);
+    initSource(SOURCE_PENDSV, "PendSV", 15);
+    sNumberOfActiveSources = 0;
+    sIRSampleIndex = 0;
+    sIRSampleCount = 0;
+    sDecodedFrames = 0;
+    sMaxDecodeDelayCycles = 0;
+    sUARTBytesLeft = 0;
+    sDMAErrorOccurred = false;
+    uint32_t tCriticalSectionCycles = 0;
+    uint64_t tNextCriticalSectionCycle = 0;
+    uint32_t tRandom = 12345;
+
+    for (sCycle = 0; sCycle < SIMULATION_CYCLES; ++sCycle) {
+        /*
+         * Requests by the peripherals
+         */
+        if (sCycle % ADC_PERIOD_CYCLES == 0) {
+            request(SOURCE_ADC);
+        }
+        if (sCycle % UART_MESSAGE_PERIOD_CYCLES == 0) {
+            sUARTBytesLeft = UART_BYTES_PER_MESSAGE;
+        }
+        if (sUARTBytesLeft > 0 && (sCycle % UART_MESSAGE_PERIOD_CYCLES) % UART_BYTE_CYCLES == UART_BYTE_CYCLES - 1) {
+            sUARTBytesLeft--;
+            request(SOURCE_UART);
+        }
+        if (sCycle % IR_PERIOD_CYCLES == 0) {
+            request(SOURCE_IR);
+        }
+        if (sCycle % SYSTIC_PERIOD_CYCLES == 0) {
+            request(SOURCE_SYSTIC);
+        }
+        if (sCycle % DMA_PERIOD_CYCLES == DMA_PERIOD_CYCLES / 2) {
+            request(SOURCE_DMA);
+        }
+        if (sNumberOfActiveSources == 0 && sCycle >= tNextCriticalSectionCycle) {
+            tCriticalSectionCycles = CRITICAL_SECTION_CYCLES;
+            tRandom = tRandom * 1103515245 + 12345;
+            tNextCriticalSectionCycle = sCycle + (tRandom >> 16) % (1000 * CYCLES_PER_MICROSECOND);
+        }
+
+        /*
+         * Preemption by the pending source with the highest priority
+         */
+        if (tCriticalSectionCycles == 0) {
+            uint16_t tActualPrio =
+                    (sNumberOfActiveSources == 0) ? THREAD_PRIO : sSources[sActiveSources[sNumberOfActiveSources - 1]].Prio;
+            int tPreemptingSource = -1;
+            for (int i = 0; i < NUMBER_OF_SOURCES; ++i) {
+                if (sSources[i].IsPending && sSources[i].Prio < tActualPrio) {
+                    tActualPrio = sSources[i].Prio;
+                    tPreemptingSource = i;
+                }
+            }
+            if (tPreemptingSource >= 0) {
+                struct InterruptSource * tSource = &sSources[tPreemptingSource];
+                tSource->IsPending = false;
+                if (tPreemptingSource != SOURCE_PENDSV) {
+                    uint64_t tLatency = sCycle - tSource->RequestCycle + ENTRY_CYCLES;
+                    if (tSource->MaxLatencyCycles < tLatency) {
+                        tSource->MaxLatencyCycles = tLatency;
+                    }
+                }
+                sActiveSources[sNumberOfActiveSources++] = tPreemptingSource;
+                tSource->RemainingCycles = ENTRY_CYCLES + runISR(tPreemptingSource);
+            }
+        }
+
+        /*
+         * Execute one cycle
+         */
+        if (sNumberOfActiveSources > 0) {
+            struct InterruptSource * tSource = &sSources[sActiveSources[sNumberOfActiveSources - 1]];
+            tSource->RemainingCycles--;
+            if (tSource->RemainingCycles == 0) {
+                sNumberOfActiveSources--;
+            }
+        } else if (tCriticalSectionCycles > 0) {
+            tCriticalSectionCycles--;
+        }
+    }
+}
+
+static bool sAllChecksPassed = true;
+static uint32_t sDecodedFramesBefore;
+static uint64_t sMaxSysticLatencyBefore;
+
+static void printAndCheckResult(const char * aName) {
+    printf("%-14s", aName);
+    for (int i = 0; i < SOURCE_PENDSV; ++i) {
+        printf(" %9.2f", sSources[i].MaxLatencyCycles / (double) CYCLES_PER_MICROSECOND);
+    }
+    uint32_t tOverruns = 0;
+    for (int i = 0; i < NUMBER_OF_SOURCES; ++i) {
+        tOverruns += sSources[i].Overruns;
+    }
+    uint32_t tQueueOverflows = getDeferredWorkQueue(DEFERRED_WORK_QUEUE_IR)->Overflows
+            + getDeferredWorkQueue(DEFERRED_WORK_QUEUE_DSO)->Overflows;
+    printf(" %8u %10.2f ms %7u %5u\n", tOverruns, sMaxDecodeDelayCycles / (CYCLES_PER_MICROSECOND * 1000.0), sDecodedFrames,
+            tQueueOverflows);
+
+    if (sSources[SOURCE_IR].Overruns != 0 || sSources[SOURCE_ADC].Overruns != 0) {
+        printf("%-14s FAILED: ADC or IR interrupt lost\n", aName);
+        sAllChecksPassed = false;
+    }
+    if (tQueueOverflows != 0) {
+        printf("%-14s FAILED: deferred work queue overflow\n", aName);
+        sAllChecksPassed = false;
+    }
+    if (!sUseDeferredWork) {
+        sDecodedFramesBefore = sDecodedFrames;
+        sMaxSysticLatencyBefore = sSources[SOURCE_SYSTIC].MaxLatencyCycles;
+    } else {
+        // the last partial work of 32 samples may not be executed
+        if (sDecodedFrames != sDecodedFramesBefore) {
+            printf("%-14s FAILED: %u instead of %u frames decoded\n", aName, sDecodedFrames, sDecodedFramesBefore);
+            sAllChecksPassed = false;
+        }
+        if (sSources[SOURCE_SYSTIC].MaxLatencyCycles >= sMaxSysticLatencyBefore) {
+            printf("%-14s FAILED: SysTick latency not improved\n", aName);
+            sAllChecksPassed = false;
+        }
+    }
+}
+
+int main(void) {
+    createIRSignal();
+    printf("Max interrupt latency in microseconds from request to ISR entry at 72 MHz, 1 s simulated\n");
+    printf("%-14s %9s %9s %9s %9s %9s %8s %13s %7s %5s\n", "", "ADC", "UART", "TIM15 IR", "SysTick", "DMA", "overruns",
+            "IR decode", "frames", "lost");
+    run(false);
+    printAndCheckResult("in ISR");
+    run(true);
+    printAndCheckResult("deferred work");
+    printf("all checks %s\n", sAllChecksPassed ? "passed" : "FAILED");
+    return sAllChecksPassed ? 0 : 1;
+}
+
+#endif // HOST_SIMULATION
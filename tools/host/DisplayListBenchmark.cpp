@@ -0,0 +1,242 @@
+/**
+ * @file DisplayListBenchmark.cpp
+ *
+ * Host benchmark for the retained display list of BlueSerial.cpp.
+ * Draws the DSO chart page in analyze mode with buttons, grid, registered texts, a 320 byte chart and an info line,
+ * and updates chart and info line 100 times like the running DSO.
+ * Then the remote side reconnects with EVENT_CONNECTION_BUILD_UP and the time from receiving the event
+ * to the last byte of the complete screen on the simulated link is measured,
+ * once with the redraw callback, which recomputes the chart from the raw samples, and once with replay of the display list.
+ * The computation of the redraw callback is modeled with REDRAW_COMPUTE_NANOS of simulated time.
+ *
+ * The commands sent for the reconnect are decoded and the drawing commands with resolved registered strings
+ * are compared for both variants. The order is ignored, since a chart which does not fit into the send buffer
+ * during the redraw callback is sent after the page as waiting stream message.
+ *
+ * Build on x86 Linux from project root with: make -C tools/host build/DisplayListBenchmark
+ * and run it with: tools/host/build/DisplayListBenchmark
+ *
+ * Only compiled if HOST_SIMULATION is defined.
+ *
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ */
+
+#ifdef HOST_SIMULATION
+
+#include "BlueDisplay.h"
+#include "StringTable.h"
+#include "HostSupport.h"
+
+#include <stdio.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#define NUMBER_OF_UPDATES 100
+#define CHART_LENGTH 320
+#define NUMBER_OF_HORIZONTAL_GRID_LINES 6
+#define NUMBER_OF_VERTICAL_GRID_LINES 10
+#define NUMBER_OF_BUTTONS 6
+#define REDRAW_COMPUTE_NANOS 10000000 // computing the display buffer from the raw samples
+#define UPDATE_INTERVAL_NANOS 20000000
+#define CONNECTION_EVENT_SIZE 11 // length, event type, 8 byte DisplaySizeAndTimestamp and sync token
+
+#ifndef USE_DISPLAY_LIST
+#error "DisplayListBenchmark must be compiled with -DUSE_DISPLAY_LIST"
+#endif
+
+const unsigned int REMOTE_DISPLAY_HEIGHT = 240;
+const unsigned int REMOTE_DISPLAY_WIDTH = 320;
+
+static const char * const sGridLabels[] = { "0.0", "0.5", "1.0", "1.5", "2.0", "2.5" };
+
+static BDButton sButtons[NUMBER_OF_BUTTONS];
+static uint8_t sRawSamples[CHART_LENGTH];
+static uint8_t sDisplayBuffer[CHART_LENGTH];
+static int sUpdateNumber;
+
+/*
+ * Remote side
+ */
+static bool sCaptureLinkData;
+static std::vector<uint8_t> sLinkData;
+
+static void captureLinkData(const uint8_t * aData, size_t aLength) {
+    if (sCaptureLinkData) {
+        sLinkData.insert(sLinkData.end(), aData, aData + aLength);
+    }
+}
+
+static uint16_t getShort(const uint8_t * aPointer) {
+    return aPointer[0] | (aPointer[1] << 8);
+}
+
+static void putConnectionEvent(void) {
+    uint8_t tMessage[CONNECTION_EVENT_SIZE] = { CONNECTION_EVENT_SIZE, EVENT_CONNECTION_BUILD_UP, (uint8_t) REMOTE_DISPLAY_WIDTH,
+            (uint8_t) (REMOTE_DISPLAY_WIDTH >> 8), (uint8_t) REMOTE_DISPLAY_HEIGHT, (uint8_t) (REMOTE_DISPLAY_HEIGHT >> 8), 0, 0,
+            0, 0, SYNC_TOKEN };
+    hostReceiveBytes(tMessage, CONNECTION_EVENT_SIZE);
+}
+
+/**
+ * @return drawing commands of sLinkData with the registered strings appended to FUNCTION_DRAW_REGISTERED_STRING
+ */
+static std::vector<std::string> decodeDrawingCommands(void) {
+    std::vector<std::string> tCommands;
+    struct StringTable tRemoteStringTable;
+    clearStringTable(&tRemoteStringTable);
+    size_t tPosition = 0;
+    while (tPosition + 4 <= sLinkData.size()) {
+        const uint8_t * tCommand = &sLinkData[tPosition];
+        size_t tCommandLength = getDisplayListCommandLength(tCommand);
+        if (tCommand[0] != SYNC_TOKEN || tPosition + tCommandLength > sLinkData.size()) {
+            tCommands.push_back("decode error");
+            break;
+        }
+        uint8_t tFunctionTag = tCommand[1];
+        size_t tParameterEnd = 4 + getShort(&tCommand[2]);
+        if (tFunctionTag == FUNCTION_REGISTER_STRING) {
+            setStringTableEntry(&tRemoteStringTable, getShort(&tCommand[4]), (const char *) &tCommand[tParameterEnd + 4],
+                    tCommandLength - tParameterEnd - 4);
+        } else if (isDisplayListFunction(tFunctionTag)) {
+            std::string tEntry((const char *) tCommand, tCommandLength);
+            if (tFunctionTag == FUNCTION_DRAW_REGISTERED_STRING) {
+                size_t tLength;
+                const char * tString = getStringTableEntry(&tRemoteStringTable, getShort(&tCommand[14]), &tLength);
+                tEntry.append(tString != NULL ? std::string(tString, tLength) : "unregistered");
+            }
+            tCommands.push_back(tEntry);
+        }
+        tPosition += tCommandLength;
+    }
+    std::sort(tCommands.begin(), tCommands.end());
+    return tCommands;
+}
+
+/*
+ * Local side
+ */
+static void initDisplay(void) {
+    BlueDisplay1.setFlagsAndSize(BD_FLAG_FIRST_RESET_ALL | BD_FLAG_TOUCH_BASIC_DISABLE, REMOTE_DISPLAY_WIDTH,
+            REMOTE_DISPLAY_HEIGHT);
+    for (int i = 0; i < NUMBER_OF_BUTTONS; ++i) {
+        sButtons[i].init(0, i * 40, 80, 36, COLOR_GREEN, "Chart", TEXT_SIZE_11, 0, 0, NULL);
+    }
+}
+
+static void computeDisplayBuffer(void) {
+    for (int i = 0; i < CHART_LENGTH; ++i) {
+        sDisplayBuffer[i] = sRawSamples[i] / 2;
+    }
+    hostAdvanceLinkTime(REDRAW_COMPUTE_NANOS);
+}
+
+static void drawChartAndInfo(void) {
+    BlueDisplay1.drawChartByteBuffer(0, 0, COLOR_BLUE, COLOR_WHITE, 0, true, sDisplayBuffer, CHART_LENGTH);
+    char tInfoLine[48];
+    snprintf(tInfoLine, sizeof(tInfoLine), "%2d.%02dms Ch. 0 Min=0.%02dV Max=2.%02dV", sUpdateNumber % 100,
+            (sUpdateNumber * 3) % 100, sUpdateNumber % 100, (sUpdateNumber * 5) % 100);
+    BlueDisplay1.drawText(0, TEXT_SIZE_11_ASCEND, tInfoLine, TEXT_SIZE_11, COLOR_BLACK, COLOR_WHITE);
+}
+
+/**
+ * Like redrawDisplay() for the chart page in analyze mode
+ */
+static void redrawDisplay(void) {
+    computeDisplayBuffer();
+    BlueDisplay1.clearDisplay(COLOR_WHITE);
+    for (int i = 0; i < NUMBER_OF_BUTTONS; ++i) {
+        sButtons[i].drawButton();
+    }
+    BlueDisplay1.drawRegisteredText(110, 130, "\xABScale\xBB", TEXT_SIZE_22, COLOR_YELLOW, COLOR_WHITE);
+    BlueDisplay1.drawRegisteredText(110, 200, "\xABScroll\xBB", TEXT_SIZE_22, COLOR_GREEN, COLOR_WHITE);
+    BlueDisplay1.drawRegisteredText(40, 220, "\xABTimeBase\xBB", TEXT_SIZE_22, COLOR_BLUE, COLOR_WHITE);
+    for (int i = 1; i <= NUMBER_OF_VERTICAL_GRID_LINES; ++i) {
+        BlueDisplay1.drawLine(i * 31, 0, i * 31, REMOTE_DISPLAY_HEIGHT - 1, COLOR_BLACK);
+    }
+    for (int i = 0; i < NUMBER_OF_HORIZONTAL_GRID_LINES; ++i) {
+        uint16_t tYPos = REMOTE_DISPLAY_HEIGHT - 1 - i * 40;
+        BlueDisplay1.drawLine(0, tYPos, REMOTE_DISPLAY_WIDTH - 1, tYPos, COLOR_BLACK);
+        BlueDisplay1.drawRegisteredText(REMOTE_DISPLAY_WIDTH - 3 * TEXT_SIZE_11_WIDTH, tYPos, sGridLabels[i], TEXT_SIZE_11,
+                COLOR_BLUE, COLOR_WHITE);
+    }
+    drawChartAndInfo();
+}
+
+/**
+ * Like the DSO loop: new samples, then chart and info line are sent as replaceable streams
+ */
+static void updateDisplay(void) {
+    sUpdateNumber++;
+    for (int i = 0; i < CHART_LENGTH; ++i) {
+        sRawSamples[i] = (i + sUpdateNumber * 7) & 0xFF;
+    }
+    for (int i = 0; i < CHART_LENGTH; ++i) {
+        sDisplayBuffer[i] = sRawSamples[i] / 2;
+    }
+    drawChartAndInfo();
+    hostAdvanceLinkTime(UPDATE_INTERVAL_NANOS);
+    checkAndHandleEvents();
+}
+
+static std::vector<std::string> runBenchmark(uint32_t aBaudRate, bool aUseDisplayList) {
+    UART_BD_initialize(aBaudRate);
+    hostResetLinkCounters();
+    setDisplayListRecording(aUseDisplayList);
+    BlueDisplay1.setStringRegistration(true);
+    sUpdateNumber = 0;
+
+    // first connect and updates
+    putConnectionEvent();
+    checkAndHandleEvents();
+    for (int i = 0; i < NUMBER_OF_UPDATES; ++i) {
+        updateDisplay();
+    }
+    hostFlushLink();
+
+    // reconnect
+    sLinkData.clear();
+    sCaptureLinkData = true;
+    hostResetLinkCounters();
+    uint64_t tStartNanos = HostLinkNanos;
+    putConnectionEvent();
+    checkAndHandleEvents();
+    hostFlushLink();
+    // waiting stream messages are sent by the next checkAndHandleEvents()
+    while (isSendStreamPending(SEND_STREAM_CHART_0) || isSendStreamPending(SEND_STREAM_INFO)) {
+        checkAndHandleEvents();
+        hostFlushLink();
+    }
+    uint64_t tCompleteNanos = HostLinkNanos - tStartNanos;
+    sCaptureLinkData = false;
+
+    printf("%7u baud %-16s: reconnect to complete screen %6.2f ms, %4u bytes", aBaudRate,
+            aUseDisplayList ? "display list" : "redraw callback", tCompleteNanos / 1e6, HostLinkCounters.Bytes);
+    if (aUseDisplayList) {
+        printf(", list %u bytes %u commands%s", RetainedDisplayList.Length, RetainedDisplayList.NumberOfCommands,
+                isDisplayListReplayable() ? "" : " INCOMPLETE");
+    }
+    printf("\n");
+    return decodeDrawingCommands();
+}
+
+int main(void) {
+    HostBluetoothPaired = true;
+    HostLinkWriteCallback = &captureLinkData;
+    registerConnectCallback(&initDisplay);
+    registerRedrawCallback(&redrawDisplay);
+
+    printf("DSO chart page with %d updates, redraw callback computes for %d ms\n", NUMBER_OF_UPDATES,
+    REDRAW_COMPUTE_NANOS / 1000000);
+    bool tAllIdentical = true;
+    uint32_t tBaudRates[] = { BAUD_115200, BAUD_921600 };
+    for (unsigned int i = 0; i < sizeof(tBaudRates) / sizeof(tBaudRates[0]); ++i) {
+        std::vector<std::string> tCallbackCommands = runBenchmark(tBaudRates[i], false);
+        std::vector<std::string> tReplayedCommands = runBenchmark(tBaudRates[i], true);
+        tAllIdentical &= (tCallbackCommands == tReplayedCommands);
+    }
+    printf("Drawing commands of both variants %s\n", tAllIdentical ? "are identical" : "DIFFER");
+    return tAllIdentical ? 0 : 1;
+}
+
+#endif // HOST_SIMULATION
@@ -0,0 +1,154 @@
+/**
+ * @file DragRedrawBenchmark.cpp
+ *
+ * Host benchmark for the coalescing of touch move events in EventHandler.cpp.
+ * The remote app sends a 2 second horizontal drag with 100 touch moves per second at 115200 baud.
+ * The touch move callback redraws like scrollDisplay() of the DSO in analyze mode (320 byte chart)
+ * or just draws a cursor line. The main loop is idle and calls checkAndHandleEvents() every millisecond.
+ * Prints redraws per second during the drag, moves lost by receive queue overflow, the lag between sending
+ * a move on the remote side and its redraw and if the final position was drawn,
+ * with every move dispatched and with coalescing.
+ *
+ * Slider callbacks are coalesced the same way, but cannot be simulated on a 64 bit host,
+ * since the handler address does not fit into the 32 bit event layout.
+ *
+ * Build on x86 Linux from project root with: make -C tools/host build/DragRedrawBenchmark
+ * and run it with: tools/host/build/DragRedrawBenchmark
+ *
+ * Only compiled if HOST_SIMULATION is defined.
+ *
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ */
+
+#ifdef HOST_SIMULATION
+
+#include "BlueDisplay.h"
+#include "EventHandler.h"
+#include "HostSupport.h"
+
+#include <stdio.h>
+
+#define DRAG_MOVES 200
+#define MOVES_PER_SECOND 100
+#define MOVE_INTERVAL_NANOS (1000000000ULL / MOVES_PER_SECOND)
+#define MAIN_LOOP_NANOS 1000000
+#define AFTER_DRAG_NANOS 1000000000ULL // time to process the backlog
+#define CHART_LENGTH 320
+#define TOUCH_MESSAGE_SIZE 8 // length, event type, 5 byte TouchEvent and sync token
+
+const unsigned int REMOTE_DISPLAY_HEIGHT = 240;
+const unsigned int REMOTE_DISPLAY_WIDTH = 320;
+
+/*
+ * Remote side
+ * The move number is sent as X position, so the lag of each redraw can be computed
+ */
+static uint64_t sNextMessageNanos;
+static uint32_t sNextMoveNumber;
+static bool sUpSent;
+
+static void putTouchMessage(uint8_t aEventType, uint16_t aPosX) {
+    uint8_t tMessage[TOUCH_MESSAGE_SIZE] = { TOUCH_MESSAGE_SIZE, aEventType, (uint8_t) aPosX, (uint8_t) (aPosX >> 8), 100, 0,
+            0, SYNC_TOKEN };
+    hostReceiveBytes(tMessage, TOUCH_MESSAGE_SIZE);
+}
+
+static void feedDragUntilLinkTime(void) {
+    while (!sUpSent && sNextMessageNanos <= HostLinkNanos) {
+        if (sNextMoveNumber == 0) {
+            putTouchMessage(EVENT_TOUCH_ACTION_DOWN, 0);
+        } else if (sNextMoveNumber <= DRAG_MOVES) {
+            putTouchMessage(EVENT_TOUCH_ACTION_MOVE, sNextMoveNumber);
+        } else {
+            putTouchMessage(EVENT_TOUCH_ACTION_UP, DRAG_MOVES);
+            sUpSent = true;
+        }
+        sNextMoveNumber++;
+        sNextMessageNanos += MOVE_INTERVAL_NANOS;
+    }
+}
+
+/*
+ * Local side
+ */
+static bool sDrawChart;
+static uint8_t sChart[CHART_LENGTH];
+static uint32_t sRedraws;
+static uint32_t sRedrawsDuringDrag;
+static uint64_t sSumOfLagNanos;
+static uint64_t sMaxLagNanos;
+static uint16_t sLastDrawnPosition;
+
+static void redrawForMove(struct TouchEvent * aActualPositionPtr) {
+    uint16_t tMoveNumber = aActualPositionPtr->TouchPosition.PosX;
+    if (sDrawChart) {
+        // like scrollDisplay()
+        for (int i = 0; i < CHART_LENGTH; ++i) {
+            sChart[i] = (tMoveNumber + i) & 0x7F;
+        }
+        sendUSARTArgsAndByteBuffer(FUNCTION_DRAW_CHART, 4, 0, 0, COLOR_BLUE, COLOR_WHITE, CHART_LENGTH, sChart);
+    } else {
+        BlueDisplay1.fillRectRel(sLastDrawnPosition, 0, 1, REMOTE_DISPLAY_HEIGHT, COLOR_WHITE);
+        BlueDisplay1.drawLine(tMoveNumber, 0, tMoveNumber, REMOTE_DISPLAY_HEIGHT - 1, COLOR_RED);
+    }
+    sLastDrawnPosition = tMoveNumber;
+    sRedraws++;
+    if (tMoveNumber <= DRAG_MOVES) {
+        // move was sent at tMoveNumber * MOVE_INTERVAL_NANOS
+        uint64_t tLagNanos = HostLinkNanos - tMoveNumber * MOVE_INTERVAL_NANOS;
+        sSumOfLagNanos += tLagNanos;
+        if (sMaxLagNanos < tLagNanos) {
+            sMaxLagNanos = tLagNanos;
+        }
+    }
+    if (HostLinkNanos <= (DRAG_MOVES + 1) * MOVE_INTERVAL_NANOS) {
+        sRedrawsDuringDrag++;
+    }
+}
+
+static void runBenchmark(bool aDrawChart, bool aCoalesce) {
+    UART_BD_initialize(BAUD_115200);
+    hostResetLinkCounters();
+    resetReceiveStatistics();
+    resetMoveEventStatistics();
+    setMoveEventCoalescingEnabled(aCoalesce);
+    sDrawChart = aDrawChart;
+    sNextMessageNanos = 0;
+    sNextMoveNumber = 0;
+    sUpSent = false;
+    sRedraws = 0;
+    sRedrawsDuringDrag = 0;
+    sSumOfLagNanos = 0;
+    sMaxLagNanos = 0;
+    sLastDrawnPosition = 0;
+
+    uint64_t tEndNanos = (DRAG_MOVES + 1) * MOVE_INTERVAL_NANOS + AFTER_DRAG_NANOS;
+    while (HostLinkNanos < tEndNanos) {
+        hostAdvanceLinkTime(MAIN_LOOP_NANOS);
+        checkAndHandleEvents();
+    }
+    hostFlushLink();
+
+    double tDragSeconds = (DRAG_MOVES + 1) * MOVE_INTERVAL_NANOS / 1e9;
+    printf("%-6s %-9s: %5.1f redraws/s %3u redraws, %3u moves lost, lag average %5.1f ms max %5.1f ms, final position %s\n",
+            aDrawChart ? "chart" : "cursor", aCoalesce ? "coalesced" : "each", sRedrawsDuringDrag / tDragSeconds, sRedraws,
+            DRAG_MOVES - MoveEventStatistics.Received, sRedraws ? sSumOfLagNanos / 1e6 / sRedraws : 0.0, sMaxLagNanos / 1e6,
+            sLastDrawnPosition == DRAG_MOVES ? "drawn" : "MISSING");
+}
+
+int main(void) {
+    HostBluetoothPaired = true;
+    HostMillisFollowLinkTime = true;
+    HostLinkReadCallback = &feedDragUntilLinkTime;
+    registerTouchMoveCallback(&redrawForMove);
+
+    printf("Drag with %d moves/s for %d ms at 115200 baud, idle main loop\n", MOVES_PER_SECOND,
+            (int) ((DRAG_MOVES + 1) * MOVE_INTERVAL_NANOS / 1000000));
+    runBenchmark(true, false);
+    runBenchmark(true, true);
+    runBenchmark(false, false);
+    runBenchmark(false, true);
+    return 0;
+}
+
+#endif // HOST_SIMULATION
@@ -0,0 +1,189 @@
+/**
+ * @file EventTraceBenchmark.cpp
+ *
+ * Host benchmark and check for the trace ring of EventTrace.cpp.
+ *
+ * 1. Records RECORDS instant events and prints the time per event. Checks that the dump contains the last
+ *    EVENT_TRACE_SIZE records in order and the number of overwritten records.
+ * 2. Records some DSO like frames with the trace points of the firmware. The BlueDisplay commands sent by
+ *    drawing in the frames are recorded by the trace point in sendUSARTBufferNoSizeCheck().
+ *    The dump is written to the file given as first argument. It can be converted with
+ *    tools/host/traceToChrome.py <file> trace.json and loaded into chrome://tracing or ui.perfetto.dev.
+ *
+ * The cost of one event on the target is the check of EventTraceIsEnabled, saving and restoring PRIMASK,
+ * reading CYCCNT and IPSR and 4 stores, i.e. about 20 cycles at -O2.
+ *
+ * Build on x86 Linux from project root with: make -C tools/host build/EventTraceBenchmark
+ * and run it with: tools/host/build/EventTraceBenchmark
+ *
+ * Only compiled if HOST_SIMULATION is defined.
+ *
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ */
+
+#ifdef HOST_SIMULATION
+
+#include "BlueDisplay.h"
+#include "BlueSerial.h"
+#include "EventTrace.h"
+#include "HostSupport.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#ifndef USE_EVENT_TRACE
+#error "EventTraceBenchmark must be compiled with -DUSE_EVENT_TRACE"
+#endif
+
+const unsigned int REMOTE_DISPLAY_HEIGHT = 240;
+const unsigned int REMOTE_DISPLAY_WIDTH = 320;
+
+#define RECORDS 1000000
+#define FRAMES 8
+
+static uint8_t sDump[16384];
+static int sDumpLength;
+
+static void writeToDump(const char * aData, int aLength) {
+    if (sDumpLength + aLength <= (int) sizeof(sDump)) {
+        memcpy(&sDump[sDumpLength], aData, aLength);
+    }
+    sDumpLength += aLength;
+}
+
+static uint32_t readUint32(const uint8_t * aData) {
+    return aData[0] | (aData[1] << 8) | (aData[2] << 16) | ((uint32_t) aData[3] << 24);
+}
+
+static uint16_t readUint16(const uint8_t * aData) {
+    return aData[0] | (aData[1] << 8);
+}
+
+/**
+ * @return pointer to first record of sDump
+ */
+static const uint8_t * parseDumpHeader(uint16_t * aNumberOfRecords, uint32_t * aOverwritten) {
+    if (memcmp(sDump, "ETRC", 4) != 0 || readUint16(&sDump[4]) != EVENT_TRACE_VERSION) {
+        return NULL;
+    }
+    *aNumberOfRecords = readUint16(&sDump[6]);
+    *aOverwritten = readUint32(&sDump[12]);
+    const uint8_t * tData = &sDump[17];
+    for (int i = 0; i < sDump[16]; ++i) {
+        tData += strlen((const char *) tData) + 1;
+    }
+    return tData;
+}
+
+static bool sAllChecksPassed = true;
+
+static void check(bool aCondition, const char * aMessage) {
+    if (!aCondition) {
+        printf("FAILED: %s\n", aMessage);
+        sAllChecksPassed = false;
+    }
+}
+
+int main(int argc, char * argv[]) {
+    /*
+     * 1. Cost and wrap around
+     */
+    initEventTrace();
+    uint64_t tStartNanos = getHostNanos();
+    for (int i = 0; i < RECORDS; ++i) {
+        TRACE_INSTANT(TRACE_ID_DMA_COMPLETE, (uint16_t ) i);
+    }
+    uint64_t tNanos = getHostNanos() - tStartNanos;
+    printf("%.1f host ns per event incl. clock_gettime()\n", (double) tNanos / RECORDS);
+
+    sDumpLength = 0;
+    dumpEventTrace(&writeToDump);
+    uint16_t tNumberOfRecords;
+    uint32_t tOverwritten;
+    const uint8_t * tRecord = parseDumpHeader(&tNumberOfRecords, &tOverwritten);
+    check(tRecord != NULL, "wrong dump header");
+    if (tRecord != NULL) {
+        check(tNumberOfRecords == EVENT_TRACE_SIZE, "number of records != EVENT_TRACE_SIZE");
+        check(tOverwritten == RECORDS - EVENT_TRACE_SIZE, "wrong number of overwritten records");
+        check(sDumpLength == (tRecord - sDump) + EVENT_TRACE_SIZE * 8, "wrong dump length");
+        bool tInOrder = true;
+        uint32_t tLastCycles = readUint32(tRecord);
+        for (int i = 0; i < tNumberOfRecords; ++i) {
+            uint16_t tExpectedArgument = (uint16_t) (RECORDS - EVENT_TRACE_SIZE + i);
+            uint32_t tCycles = readUint32(&tRecord[i * 8]);
+            if (readUint16(&tRecord[i * 8 + 4]) != tExpectedArgument
+                    || tRecord[i * 8 + 6] != ((TRACE_TYPE_INSTANT << TRACE_TYPE_SHIFT) | TRACE_ID_DMA_COMPLETE)
+                    || (int32_t) (tCycles - tLastCycles) < 0) {
+                tInOrder = false;
+            }
+            tLastCycles = tCycles;
+        }
+        check(tInOrder, "records not in order");
+    }
+
+    /*
+     * 2. DSO like frames
+     */
+    HostBluetoothPaired = true;
+    UART_BD_initialize(115200);
+    initEventTrace();
+    TRACE_BEGIN(TRACE_ID_PAGE, 1);
+    for (int tFrame = 0; tFrame < FRAMES; ++tFrame) {
+        TRACE_INSTANT(TRACE_ID_START_ACQUISITION, 3);
+        TRACE_INSTANT(TRACE_ID_TRIGGER, 1);
+        TRACE_INSTANT(TRACE_ID_DMA_COMPLETE, 0);
+        {
+            TRACE_SCOPE(TRACE_ID_DRAW_DATA_BUFFER, 320);
+            BlueDisplay1.fillRectRel(0, 0, 320, 200, COLOR_WHITE);
+            for (int i = 0; i < 10; ++i) {
+                BlueDisplay1.drawLine(i * 32, 100, i * 32 + 32, 100 + (i & 1) * 20, COLOR_BLUE);
+            }
+        }
+        {
+            TRACE_SCOPE(TRACE_ID_PRINT_INFO, 0);
+            BlueDisplay1.drawText(0, 220, "1.234V 50Hz", 11, COLOR_BLACK, COLOR_WHITE);
+        }
+    }
+    TRACE_END(TRACE_ID_PAGE);
+    hostFlushLink();
+
+    sDumpLength = 0;
+    dumpEventTrace(&writeToDump);
+    tRecord = parseDumpHeader(&tNumberOfRecords, &tOverwritten);
+    int tSendRecords = 0;
+    int tOpenScopes = 0;
+    bool tNested = true;
+    for (int i = 0; tRecord != NULL && i < tNumberOfRecords; ++i) {
+        uint8_t tTypeAndId = tRecord[i * 8 + 6];
+        if ((tTypeAndId >> TRACE_TYPE_SHIFT) == TRACE_TYPE_BEGIN) {
+            tOpenScopes++;
+            if ((tTypeAndId & TRACE_ID_MASK) == TRACE_ID_SEND_USART) {
+                tSendRecords++;
+                // each send is inside the page and a draw scope
+                tNested &= (tOpenScopes == 3);
+            }
+        } else if ((tTypeAndId >> TRACE_TYPE_SHIFT) == TRACE_TYPE_END) {
+            tOpenScopes--;
+        }
+    }
+    printf("%u records for %d frames, %d BlueDisplay commands\n", tNumberOfRecords, FRAMES, tSendRecords);
+    check(tOverwritten == 0 && tOpenScopes == 0, "scopes not closed");
+    check(tSendRecords == FRAMES * 12, "wrong number of BlueDisplay commands");
+    check(tNested, "BlueDisplay command outside of draw scope");
+
+    if (argc > 1) {
+        FILE * tFile = fopen(argv[1], "wb");
+        if (tFile == NULL) {
+            perror(argv[1]);
+            return 1;
+        }
+        fwrite(sDump, 1, sDumpLength, tFile);
+        fclose(tFile);
+        printf("trace written to %s\n", argv[1]);
+    }
+
+    printf("all checks %s\n", sAllChecksPassed ? "passed" : "FAILED");
+    return sAllChecksPassed ? 0 : 1;
+}
+
+#endif // HOST_SIMULATION
@@ -0,0 +1,276 @@
+/**
+ * @file GuiStateCacheBenchmark.cpp
+ *
+ * Host benchmark for the cache of button and slider state of BlueDisplay.cpp.
+ * Models the DSO page, which refreshes button captions and colors in its loop, with setButtonCaptions() and
+ * setChannelButtonsCaption() like TouchDSOGui.cpp, the colors of the 4 channel buttons, the value of the history button
+ * and a trigger level slider. The state changes only every few loops, like after a touch or a new trigger level.
+ * Prints commands and bytes per second on the link with the cache disabled and enabled,
+ * and checks that the remote side ends with the same button and slider state for both.
+ *
+ * Build on x86 Linux from project root with: make -C tools/host build/GuiStateCacheBenchmark
+ * and run it with: tools/host/build/GuiStateCacheBenchmark
+ *
+ * Only compiled if HOST_SIMULATION is defined.
+ *
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ */
+
+#ifdef HOST_SIMULATION
+
+#include "BlueDisplay.h"
+#include "HostSupport.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <map>
+#include <string>
+#include <vector>
+
+#define NUMBER_OF_LOOPS 1000
+#define LOOPS_PER_SECOND 50 // DSO display refresh
+#define LOOPS_PER_TOUCH 40 // state of one button is changed
+#define LOOPS_PER_TRIGGER_LEVEL_CHANGE 10
+#define NUMBER_OF_CHANNEL_BUTTONS 3
+
+#ifdef DO_NOT_CACHE_GUI_STATE
+#error "GuiStateCacheBenchmark must be compiled without DO_NOT_CACHE_GUI_STATE"
+#endif
+
+const unsigned int REMOTE_DISPLAY_HEIGHT = 240;
+const unsigned int REMOTE_DISPLAY_WIDTH = 320;
+
+/*
+ * Local side modeled after TouchDSOGui.cpp
+ */
+static const char * const ChartHistoryButtonStrings[] = { "history\nOff", "history\nOn", "history\nL" };
+static char ChartHistoryButtonString[] = "history\nOff";
+#define ChartHistoryButtonStringChangeIndex 8
+static const char ChannelDivByButtonStrings[NUMBER_OF_CHANNEL_BUTTONS][5] = { "\xF7" "1", "\xF7" "10", "\xF7" "100" };
+
+static BDButton TouchButtonChartHistory;
+static BDButton TouchButtonMinMaxMode;
+static BDButton TouchButtonACRangeOnOff;
+static BDButton TouchButtonChannels[NUMBER_OF_CHANNEL_BUTTONS];
+static BDButton TouchButtonChannelSelect;
+static BDSlider TouchSliderTriggerLevel;
+
+static int sEraseColorIndex;
+static bool sIsMinMaxMode;
+static bool sChannelIsACMode;
+static int sChannelIndex;
+static int sTriggerLevel;
+
+static void setButtonCaptions(void) {
+    strcpy(&ChartHistoryButtonString[ChartHistoryButtonStringChangeIndex], ChartHistoryButtonStrings[sEraseColorIndex] + 8);
+    TouchButtonChartHistory.setCaption(ChartHistoryButtonString);
+
+    if (sIsMinMaxMode) {
+        TouchButtonMinMaxMode.setCaption("Min/Max\nmode");
+    } else {
+        TouchButtonMinMaxMode.setCaption("Sample\nmode");
+    }
+    if (sChannelIsACMode) {
+        TouchButtonACRangeOnOff.setCaption("AC");
+    } else {
+        TouchButtonACRangeOnOff.setCaption("DC");
+    }
+}
+
+static void setChannelButtonsCaption(void) {
+    for (uint8_t i = 0; i < NUMBER_OF_CHANNEL_BUTTONS; ++i) {
+        TouchButtonChannels[i].setCaption(ChannelDivByButtonStrings[i]);
+    }
+}
+
+static void setChannelButtonsColor(void) {
+    for (int i = 0; i < NUMBER_OF_CHANNEL_BUTTONS; ++i) {
+        TouchButtonChannels[i].setButtonColor(
+                (i == sChannelIndex) ? BUTTON_AUTO_RED_GREEN_TRUE_COLOR : BUTTON_AUTO_RED_GREEN_FALSE_COLOR);
+    }
+    TouchButtonChannelSelect.setButtonColor(
+            (sChannelIndex >= NUMBER_OF_CHANNEL_BUTTONS) ? BUTTON_AUTO_RED_GREEN_TRUE_COLOR : BUTTON_AUTO_RED_GREEN_FALSE_COLOR);
+}
+
+static void initDSOGUI(void) {
+    BDButton::resetAllButtons();
+    BDSlider::resetAllSliders();
+    sEraseColorIndex = 0;
+    sIsMinMaxMode = true;
+    sChannelIsACMode = false;
+    sChannelIndex = 0;
+    sTriggerLevel = 100;
+    strcpy(ChartHistoryButtonString, ChartHistoryButtonStrings[0]);
+    TouchButtonChartHistory.init(0, 0, 80, 36, COLOR_GREEN, ChartHistoryButtonString, TEXT_SIZE_11, 0, 0, NULL);
+    TouchButtonMinMaxMode.init(0, 40, 80, 36, COLOR_GREEN, "Min/Max\nmode", TEXT_SIZE_11, 0, 0, NULL);
+    TouchButtonACRangeOnOff.init(0, 80, 80, 36, COLOR_GREEN, "DC", TEXT_SIZE_11, 0, 0, NULL);
+    for (int i = 0; i < NUMBER_OF_CHANNEL_BUTTONS; ++i) {
+        TouchButtonChannels[i].init(i * 60, 120, 56, 36, BUTTON_AUTO_RED_GREEN_FALSE_COLOR, ChannelDivByButtonStrings[i],
+                TEXT_SIZE_11, 0, 0, NULL);
+    }
+    TouchButtonChannelSelect.init(180, 120, 56, 36, BUTTON_AUTO_RED_GREEN_FALSE_COLOR, "T", TEXT_SIZE_11, 0, 0, NULL);
+    TouchSliderTriggerLevel.init(300, 0, 4, 200, 0, sTriggerLevel, COLOR_BLUE, COLOR_GREEN, FLAG_SLIDER_IS_ONLY_OUTPUT,
+            NULL);
+    BlueDisplay1.clearDisplay(COLOR_WHITE);
+    TouchSliderTriggerLevel.drawSlider();
+}
+
+/**
+ * Changes one state every LOOPS_PER_TOUCH loops, like the touch handlers of the DSO
+ */
+static void changeState(int aLoop) {
+    if (aLoop % LOOPS_PER_TOUCH == 0) {
+        switch ((aLoop / LOOPS_PER_TOUCH) % 4) {
+        case 0:
+            sEraseColorIndex = (sEraseColorIndex + 1) % 3;
+            TouchButtonChartHistory.setValue(sEraseColorIndex != 0);
+            break;
+        case 1:
+            sIsMinMaxMode = !sIsMinMaxMode;
+            break;
+        case 2:
+            sChannelIsACMode = !sChannelIsACMode;
+            break;
+        default:
+            sChannelIndex = (sChannelIndex + 1) % (NUMBER_OF_CHANNEL_BUTTONS + 1);
+            break;
+        }
+    }
+    if (aLoop % LOOPS_PER_TRIGGER_LEVEL_CHANGE == 0) {
+        sTriggerLevel = 100 + (aLoop / LOOPS_PER_TRIGGER_LEVEL_CHANGE) % 7;
+    }
+}
+
+static void loopDSOPage(int aLoop) {
+    changeState(aLoop);
+    setButtonCaptions();
+    setChannelButtonsCaption();
+    setChannelButtonsColor();
+    TouchButtonChartHistory.setValue(sEraseColorIndex != 0);
+    TouchSliderTriggerLevel.setActualValueAndDrawBar(sTriggerLevel);
+}
+
+/*
+ * Remote side
+ */
+struct RemoteState {
+    std::map<int, std::string> ButtonCaptions;
+    std::map<int, int> ButtonColors;
+    std::map<int, int> ButtonValues;
+    std::map<int, int> SliderValues;
+    bool operator==(const RemoteState & aOther) const {
+        return ButtonCaptions == aOther.ButtonCaptions && ButtonColors == aOther.ButtonColors
+                && ButtonValues == aOther.ButtonValues && SliderValues == aOther.SliderValues;
+    }
+};
+
+static bool sCaptureLinkData;
+static std::vector<uint8_t> sLinkData;
+
+static void captureLinkData(const uint8_t * aData, size_t aLength) {
+    if (sCaptureLinkData) {
+        sLinkData.insert(sLinkData.end(), aData, aData + aLength);
+    }
+}
+
+static uint16_t getShort(const uint8_t * aPointer) {
+    return aPointer[0] | (aPointer[1] << 8);
+}
+
+/**
+ * Applies the button and slider commands of sLinkData to aState
+ * @return number of commands or -1 on decode error
+ */
+static int decodeCommands(RemoteState * aState) {
+    int tNumberOfCommands = 0;
+    size_t tPosition = 0;
+    while (tPosition + 4 <= sLinkData.size()) {
+        const uint8_t * tCommand = &sLinkData[tPosition];
+        if (tCommand[0] != SYNC_TOKEN) {
+            return -1;
+        }
+        uint8_t tFunctionTag = tCommand[1];
+        const uint8_t * tParameters = &tCommand[4];
+        size_t tCommandLength = 4 + getShort(&tCommand[2]);
+        const char * tData = NULL;
+        size_t tDataLength = 0;
+        if (tFunctionTag > INDEX_LAST_FUNCTION_WITHOUT_DATA) {
+            const uint8_t * tDataHeader = &tCommand[tCommandLength];
+            tDataLength = getShort(&tDataHeader[2]);
+            tData = (const char *) &tDataHeader[4];
+            tCommandLength += 4 + tDataLength;
+        }
+        if (tPosition + tCommandLength > sLinkData.size()) {
+            return -1;
+        }
+        int tHandle = getShort(&tParameters[0]);
+        if (tFunctionTag == FUNCTION_BUTTON_CREATE) {
+            aState->ButtonColors[tHandle] = getShort(&tParameters[10]);
+            aState->ButtonValues[tHandle] = (int16_t) getShort(&tParameters[16]);
+            aState->ButtonCaptions[tHandle] = std::string(tData, tDataLength);
+        } else if (tFunctionTag == FUNCTION_BUTTON_SET_CAPTION || tFunctionTag == FUNCTION_BUTTON_SET_CAPTION_AND_DRAW_BUTTON) {
+            aState->ButtonCaptions[tHandle] = std::string(tData, tDataLength);
+        } else if (tFunctionTag == FUNCTION_BUTTON_SETTINGS) {
+            uint16_t tSubfunction = getShort(&tParameters[2]);
+            if (tSubfunction == SUBFUNCTION_BUTTON_SET_VALUE || tSubfunction == SUBFUNCTION_BUTTON_SET_VALUE_AND_DRAW) {
+                aState->ButtonValues[tHandle] = (int16_t) getShort(&tParameters[4]);
+            } else if (tSubfunction == SUBFUNCTION_BUTTON_SET_BUTTON_COLOR
+                    || tSubfunction == SUBFUNCTION_BUTTON_SET_BUTTON_COLOR_AND_DRAW) {
+                aState->ButtonColors[tHandle] = getShort(&tParameters[4]);
+            }
+        } else if (tFunctionTag == FUNCTION_SLIDER_CREATE) {
+            aState->SliderValues[tHandle] = (int16_t) getShort(&tParameters[12]);
+        } else if (tFunctionTag == FUNCTION_SLIDER_SETTINGS
+                && getShort(&tParameters[2]) == SUBFUNCTION_SLIDER_SET_VALUE_AND_DRAW_BAR) {
+            aState->SliderValues[tHandle] = (int16_t) getShort(&tParameters[4]);
+        }
+        tNumberOfCommands++;
+        tPosition += tCommandLength;
+    }
+    return tNumberOfCommands;
+}
+
+/**
+ * @return number of commands sent by the loop
+ */
+static int runBenchmark(bool aEnableCache, RemoteState * aState) {
+    UART_BD_initialize(BAUD_115200);
+    BlueDisplay1.setGUIStateCaching(aEnableCache);
+    sLinkData.clear();
+    sCaptureLinkData = true;
+    initDSOGUI();
+    hostFlushLink();
+    decodeCommands(aState);
+
+    sLinkData.clear();
+    hostResetLinkCounters();
+    for (int i = 1; i <= NUMBER_OF_LOOPS; ++i) {
+        loopDSOPage(i);
+        hostFlushLink();
+    }
+    sCaptureLinkData = false;
+    int tNumberOfCommands = decodeCommands(aState);
+    double tSeconds = (double) NUMBER_OF_LOOPS / LOOPS_PER_SECOND;
+    printf("Cache %-8s: %5d commands %6.1f commands/s %7.0f bytes/s %4.1f commands per loop\n",
+            aEnableCache ? "enabled" : "disabled", tNumberOfCommands, tNumberOfCommands / tSeconds,
+            HostLinkCounters.Bytes / tSeconds, (double) tNumberOfCommands / NUMBER_OF_LOOPS);
+    return tNumberOfCommands;
+}
+
+int main(void) {
+    HostBluetoothPaired = true;
+    HostLinkWriteCallback = &captureLinkData;
+
+    printf("DSO page loop at %d loops/s for %d loops, one state change every %d loops\n", LOOPS_PER_SECOND, NUMBER_OF_LOOPS,
+    LOOPS_PER_TOUCH);
+    RemoteState tStateWithoutCache;
+    RemoteState tStateWithCache;
+    int tCommandsWithoutCache = runBenchmark(false, &tStateWithoutCache);
+    int tCommandsWithCache = runBenchmark(true, &tStateWithCache);
+    bool tStateOK = (tCommandsWithoutCache > 0 && tCommandsWithCache > 0 && tStateWithoutCache == tStateWithCache);
+    printf("Reduction %.1f %%, remote state %s\n", 100.0 * (tCommandsWithoutCache - tCommandsWithCache) / tCommandsWithoutCache,
+            tStateOK ? "identical" : "DIFFERS");
+    return tStateOK ? 0 : 1;
+}
+
+#endif // HOST_SIMULATION
@@ -0,0 +1,303 @@
+/**
+ * @file HostDSO.cpp
+ *
+ * Replacements for the parts of stm32fx0xPeripherals.cpp and CMSIS-DSP, which are used by TouchDSOGui.cpp,
+ * TouchDSODisplay.cpp and TouchDSOAcquisition.cpp, for programs built with HOST_SIMULATION on x86 Linux.
+ *
+ * The ADC converts the values of HostADCSampleCallback, when runHostADC() is called.
+ * The simulated time advances by one period of the DSO timer for each conversion, so the input signal can be given in seconds.
+ * In interrupt mode each value is written to the data register and ADC1_2_IRQHandler() is called.
+ * In DMA mode the DMA writes the whole transfer at once, then the half transfer and the transfer complete interrupt
+ * are raised by calling DMA1_Channel1_IRQHandler(). So the trigger search of DMACheckForTriggerCondition()
+ * always sees a completely written buffer, like on a target where the DMA is faster than the search.
+ *
+ * The FFT computes the same result as the CMSIS-DSP radix 4 FFT with a plain radix 2 FFT.
+ *
+ * Only compiled if HOST_SIMULATION is defined.
+ *
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ */
+
+#ifdef HOST_SIMULATION
+
+#include "stm32fx0xPeripherals.h"
+#include "TouchDSO.h" // for ATTENUATOR_TYPE_ACTIVE_ATTENUATOR
+#include "arm_common_tables.h"
+#include "timing.h"
+
+#include <math.h>
+#include <stdio.h>
+
+extern "C" void ADC1_2_IRQHandler(void);
+extern "C" void DMA1_Channel1_IRQHandler(void);
+
+GPIO_TypeDef HostGPIO[6];
+DMA_TypeDef HostDMA1;
+DMA_Channel_TypeDef HostDMA1Channel1;
+
+static ADC_TypeDef sHostADC1;
+static ADC_TypeDef sHostADC2;
+static TIM_TypeDef sHostDSOTimer;
+
+DMA_HandleTypeDef DMA11_ADC1_Handle = { DMA1_Channel1 };
+ADC_HandleTypeDef ADC1Handle = { &sHostADC1, &DMA11_ADC1_Handle };
+ADC_HandleTypeDef ADC2Handle = { &sHostADC2, NULL };
+TIM_HandleTypeDef TIM_DSOHandle = { &sHostDSOTimer };
+
+/*
+ * Values of a chip with VDDA = 3.3 V, see ADC_setRawToVoltFactor() in stm32fx0xPeripherals.cpp
+ */
+float sADCToVoltFactor;
+uint16_t sReading3Volt;
+uint16_t sRefintActualReading;
+unsigned int sADCScaleFactorShift18;
+float sVDDA;
+
+bool RTC_DateIsValid = false;
+
+uint16_t (*HostADCSampleCallback)(double aSeconds) = NULL;
+uint32_t HostADCConversions = 0;
+
+#define HOST_DSO_TIMER_CLOCK_HERTZ 72000000.0
+static double sHostADCSeconds;
+
+static uint16_t sDMATransferSize;
+static uint32_t sDMAStartCount; // to detect a restart of the transfer by the interrupt handler
+
+void ADC_setRawToVoltFactor(void) {
+    sVDDA = 3.3;
+    sRefintActualReading = 1490; // VREFINT_CAL of a typical chip
+    sADCScaleFactorShift18 = 16896; // 0,064453125 * 2^18
+    sReading3Volt = (3.0 * 4096) / 3.3;
+    sADCToVoltFactor = 3.3 / 4096;
+}
+
+static uint16_t getHostADCValue(void) {
+    HostADCConversions++;
+    if (HostADCSampleCallback == NULL) {
+        return (ADC_MAX_CONVERSION_VALUE + 1) / 2;
+    }
+    return HostADCSampleCallback(sHostADCSeconds);
+}
+
+/*
+ * Period of the update event of the DSO timer, which starts the conversions
+ */
+double getHostADCSamplePeriodSeconds(void) {
+    TIM_TypeDef * tTimer = TIM_DSOHandle.Instance;
+    return ((tTimer->PSC + 1.0) * (tTimer->ARR + 1.0)) / HOST_DSO_TIMER_CLOCK_HERTZ;
+}
+
+static uint16_t getNextHostADCValue(void) {
+    sHostADCSeconds += getHostADCSamplePeriodSeconds();
+    return getHostADCValue();
+}
+
+uint16_t ADC1_getChannelValue(uint8_t aChannel, int aOversamplingExponent) {
+    (void) aOversamplingExponent;
+    if (aChannel == ADC_CHANNEL_VREFINT) {
+        return sRefintActualReading;
+    }
+    return getHostADCValue();
+}
+
+void ADC_enableAndWait(ADC_HandleTypeDef* aADCHandle) {
+    SET_BIT(aADCHandle->Instance->CR2, ADC_CR2_ADON);
+}
+
+void ADC_disableAndWait(ADC_HandleTypeDef* aADCHandle) {
+    CLEAR_BIT(aADCHandle->Instance->CR2, ADC_CR2_ADON);
+}
+
+void ADC_SelectChannelAndSetSampleTime(ADC_HandleTypeDef* aADCHandle, uint8_t aChannelNumber, bool aFastMode) {
+    (void) aADCHandle;
+    (void) aChannelNumber;
+    (void) aFastMode;
+}
+
+void ADC_SetTimerPeriod(uint16_t aDivider, uint16_t aPrescalerDivider) {
+    TIM_DSOHandle.Instance->ARR = aDivider - 1;
+    TIM_DSOHandle.Instance->PSC = aPrescalerDivider - 1;
+}
+
+void ADC1_DMA_start(uintptr_t aMemoryBaseAddr, uint16_t aBufferSize, bool aModeCircular) {
+    DMA_Channel_TypeDef * tChannel = ADC1Handle.DMA_Handle->Instance;
+    CLEAR_BIT(tChannel->CCR, DMA_CCR_EN);
+    if (aModeCircular) {
+        SET_BIT(tChannel->CCR, DMA_CCR_CIRC);
+    } else {
+        CLEAR_BIT(tChannel->CCR, DMA_CCR_CIRC);
+    }
+    tChannel->CMAR = aMemoryBaseAddr;
+    tChannel->CNDTR = aBufferSize;
+    sDMATransferSize = aBufferSize;
+    sDMAStartCount++;
+    SET_BIT(tChannel->CCR, DMA_CCR_EN | DMA_CCR_TCIE | DMA_CCR_HTIE | DMA_CCR_TEIE);
+    SET_BIT(ADC1Handle.Instance->CR2, ADC_CR2_EXTTRIG);
+}
+
+void ADC1_DMA_stop(void) {
+    CLEAR_BIT(ADC1Handle.DMA_Handle->Instance->CCR, DMA_CCR_EN);
+    __HAL_DMA_CLEAR_FLAG(ADC1Handle.DMA_Handle, DMA_FLAG_GL1 | DMA_FLAG_TC1 | DMA_FLAG_HT1 | DMA_FLAG_TE1);
+}
+
+static bool isHostDMATransferPending(void) {
+    DMA_Channel_TypeDef * tChannel = ADC1Handle.DMA_Handle->Instance;
+    return (tChannel->CCR & DMA_CCR_EN) && tChannel->CNDTR > 0;
+}
+
+/*
+ * The timer triggers the conversions, the results are read by DMA or by the EOC interrupt
+ */
+bool isHostADCRunning(void) {
+    return (TIM_DSOHandle.Instance->CR1 & TIM_CR1_CEN) && (ADC1Handle.Instance->CR2 & ADC_CR2_EXTTRIG)
+            && (isHostDMATransferPending() || (ADC1Handle.Instance->CR1 & ADC_IT_EOC));
+}
+
+/**
+ * Converts at least aNumberOfConversions values or until the acquisition is stopped by the DSO code.
+ * A DMA transfer is always completed, even if it has more values left.
+ */
+void runHostADC(uint32_t aNumberOfConversions) {
+    uint32_t tEndConversions = HostADCConversions + aNumberOfConversions;
+    while (HostADCConversions < tEndConversions && isHostADCRunning()) {
+        if (isHostDMATransferPending()) {
+            DMA_Channel_TypeDef * tChannel = ADC1Handle.DMA_Handle->Instance;
+            uint16_t * tBuffer = (uint16_t *) tChannel->CMAR;
+            while (tChannel->CNDTR > 0) {
+                tBuffer[sDMATransferSize - tChannel->CNDTR] = getNextHostADCValue();
+                tChannel->CNDTR--;
+            }
+            uint32_t tStartCount = sDMAStartCount;
+            SET_BIT(DMA1->ISR, DMA_FLAG_GL1 | DMA_FLAG_HT1);
+            DMA1_Channel1_IRQHandler();
+            if (tStartCount != sDMAStartCount || !(tChannel->CCR & DMA_CCR_EN)) {
+                // restarted or stopped by the half transfer interrupt
+                continue;
+            }
+            if (tChannel->CCR & DMA_CCR_CIRC) {
+                tChannel->CNDTR = sDMATransferSize;
+            }
+            SET_BIT(DMA1->ISR, DMA_FLAG_GL1 | DMA_FLAG_TC1);
+            DMA1_Channel1_IRQHandler();
+        } else {
+            ADC1Handle.Instance->DR = getNextHostADCValue();
+            SET_BIT(ADC1Handle.Instance->SR, ADC_SR_EOC);
+            ADC1_2_IRQHandler();
+        }
+    }
+}
+
+/*
+ * Like the STM32F30X code of initAcquisition(). The attenuator only switches the range, the input is not scaled.
+ */
+int DSO_detectAttenuatorType(void) {
+    return ATTENUATOR_TYPE_ACTIVE_ATTENUATOR;
+}
+
+void DSO_setAttenuator(uint8_t aValue) {
+    DSO_ATTENUATOR_PORT->ODR = (DSO_ATTENUATOR_PORT->ODR & ~0x380) | ((aValue << 7) & 0x380);
+}
+
+void DSO_setACMode(bool aValue) {
+    if (aValue) {
+        DSO_ATTENUATOR_PORT->ODR |= DSO_AC_RANGE_PIN;
+    } else {
+        DSO_ATTENUATOR_PORT->ODR &= ~DSO_AC_RANGE_PIN;
+    }
+}
+
+bool DSO_getACMode(void) {
+    return (DSO_ATTENUATOR_PORT->ODR & DSO_AC_RANGE_PIN);
+}
+
+/*
+ * No RTC on host, the time starts at boot
+ */
+uint8_t RTC_getSecond(void) {
+    return (getMillisSinceBoot() / 1000) % 60;
+}
+
+int RTC_getTimeString(char * aStringBuffer) {
+    uint32_t tSeconds = getMillisSinceBoot() / 1000;
+    return sprintf(aStringBuffer, "%02u:%02u:%02u", (unsigned int) (tSeconds / 3600) % 24,
+            (unsigned int) (tSeconds / 60) % 60, (unsigned int) tSeconds % 60);
+}
+
+/*
+ * CMSIS-DSP FFT
+ */
+const float32_t twiddleCoef_256[512] = { 0 };
+
+static void reverseBitOrder(float32_t * aData, uint16_t aFFTSize) {
+    for (uint16_t i = 1, j = 0; i < aFFTSize; i++) {
+        uint16_t tBit = aFFTSize >> 1;
+        for (; j & tBit; tBit >>= 1) {
+            j ^= tBit;
+        }
+        j ^= tBit;
+        if (i < j) {
+            float32_t tReal = aData[2 * i];
+            float32_t tImaginary = aData[2 * i + 1];
+            aData[2 * i] = aData[2 * j];
+            aData[2 * i + 1] = aData[2 * j + 1];
+            aData[2 * j] = tReal;
+            aData[2 * j + 1] = tImaginary;
+        }
+    }
+}
+
+/**
+ * Computes the complex FFT of interleaved real and imaginary values in place, like arm_radix4_butterfly_f32().
+ * Like there, the result is left in bit reversed order for arm_bitreversal_f32().
+ * The twiddle factors are computed, so aCoefficients is not used.
+ */
+extern "C" void arm_radix4_butterfly_f32(float32_t * aData, uint16_t aFFTSize, float32_t * aCoefficients,
+        uint16_t aCoefficientModifier) {
+    (void) aCoefficients;
+    (void) aCoefficientModifier;
+    reverseBitOrder(aData, aFFTSize);
+    for (uint16_t tLength = 2; tLength <= aFFTSize; tLength <<= 1) {
+        double tAngle = -2 * M_PI / tLength;
+        for (uint16_t i = 0; i < aFFTSize; i += tLength) {
+            for (uint16_t k = 0; k < tLength / 2; k++) {
+                float32_t tCos = cos(tAngle * k);
+                float32_t tSin = sin(tAngle * k);
+                float32_t * tUpper = &aData[2 * (i + k)];
+                float32_t * tLower = &aData[2 * (i + k + tLength / 2)];
+                float32_t tReal = tLower[0] * tCos - tLower[1] * tSin;
+                float32_t tImaginary = tLower[0] * tSin + tLower[1] * tCos;
+                tLower[0] = tUpper[0] - tReal;
+                tLower[1] = tUpper[1] - tImaginary;
+                tUpper[0] += tReal;
+                tUpper[1] += tImaginary;
+            }
+        }
+    }
+    // natural order -> bit reversed order
+    reverseBitOrder(aData, aFFTSize);
+}
+
+/**
+ * The permutation is computed, so aBitReverseTable is not used
+ */
+extern "C" void arm_bitreversal_f32(float32_t * aData, uint16_t aFFTSize, uint16_t aBitReverseFactor,
+        uint16_t * aBitReverseTable) {
+    (void) aBitReverseFactor;
+    (void) aBitReverseTable;
+    reverseBitOrder(aData, aFFTSize);
+}
+
+#ifdef HOST_NEEDS_STRLCPY
+size_t strlcpy(char * aDestination, const char * aSource, size_t aSize) {
+    size_t tLength = strlen(aSource);
+    if (aSize > 0) {
+        size_t tCopyLength = (tLength >= aSize) ? aSize - 1 : tLength;
+        memcpy(aDestination, aSource, tCopyLength);
+        aDestination[tCopyLength] = '\0';
+    }
+    return tLength;
+}
+#endif
+
+#endif // HOST_SIMULATION
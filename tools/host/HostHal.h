@@ -0,0 +1,182 @@
+/**
+ * @file HostHal.h
+ *
+ * Stand-ins for the HAL handles, registers and macros, which are used by stm32fx0xPeripherals.h and the DSO code,
+ * for programs built with HOST_SIMULATION on x86 Linux.
+ * The registers are plain variables. The simulated ADC and DMA of HostDSO.cpp read and write them
+ * like the hardware does, so the register accesses of TouchDSOAcquisition.cpp work unchanged.
+ *
+ * Only the F1 register layout is provided, since STM32F30X is not defined on host.
+ *
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ */
+
+#ifndef TOOLS_HOST_HOSTHAL_H_
+#define TOOLS_HOST_HOSTHAL_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#define __STATIC_INLINE static inline
+
+#define SET_BIT(REG, BIT)     ((REG) |= (BIT))
+#define CLEAR_BIT(REG, BIT)   ((REG) &= ~(BIT))
+#define READ_BIT(REG, BIT)    ((REG) & (BIT))
+
+/*
+ * GPIO
+ */
+typedef struct {
+    volatile uint32_t ODR;
+    volatile uint32_t BSRR;
+} GPIO_TypeDef;
+
+extern GPIO_TypeDef HostGPIO[6];
+#define GPIOA (&HostGPIO[0])
+#define GPIOB (&HostGPIO[1])
+#define GPIOC (&HostGPIO[2])
+#define GPIOD (&HostGPIO[3])
+#define GPIOE (&HostGPIO[4])
+#define GPIOF (&HostGPIO[5])
+
+#define GPIO_PIN_0  ((uint16_t)0x0001)
+#define GPIO_PIN_1  ((uint16_t)0x0002)
+#define GPIO_PIN_2  ((uint16_t)0x0004)
+#define GPIO_PIN_3  ((uint16_t)0x0008)
+#define GPIO_PIN_4  ((uint16_t)0x0010)
+#define GPIO_PIN_5  ((uint16_t)0x0020)
+#define GPIO_PIN_6  ((uint16_t)0x0040)
+#define GPIO_PIN_7  ((uint16_t)0x0080)
+#define GPIO_PIN_8  ((uint16_t)0x0100)
+#define GPIO_PIN_9  ((uint16_t)0x0200)
+#define GPIO_PIN_10 ((uint16_t)0x0400)
+#define GPIO_PIN_11 ((uint16_t)0x0800)
+#define GPIO_PIN_12 ((uint16_t)0x1000)
+#define GPIO_PIN_13 ((uint16_t)0x2000)
+#define GPIO_PIN_14 ((uint16_t)0x4000)
+#define GPIO_PIN_15 ((uint16_t)0x8000)
+
+/*
+ * ADC
+ */
+typedef struct {
+    volatile uint32_t SR;
+    volatile uint32_t CR1;
+    volatile uint32_t CR2;
+    volatile uint32_t DR;
+} ADC_TypeDef;
+
+#define ADC_SR_EOC          0x00000002
+#define ADC_CR1_EOCIE       0x00000020
+#define ADC_CR2_ADON        0x00000001
+#define ADC_CR2_EXTTRIG     0x00100000
+
+#define ADC_IT_EOC          ADC_CR1_EOCIE
+#define ADC_FLAG_EOC        ADC_SR_EOC
+
+#define ADC_CHANNEL_0               0
+#define ADC_CHANNEL_1               1
+#define ADC_CHANNEL_2               2
+#define ADC_CHANNEL_3               3
+#define ADC_CHANNEL_4               4
+#define ADC_CHANNEL_TEMPSENSOR      16
+#define ADC_CHANNEL_VREFINT         17
+
+/*
+ * DMA
+ */
+typedef struct {
+    volatile uint32_t CCR;
+    volatile uint32_t CNDTR;
+    volatile uintptr_t CPAR;
+    volatile uintptr_t CMAR;
+} DMA_Channel_TypeDef;
+
+typedef struct {
+    volatile uint32_t ISR;
+    volatile uint32_t IFCR;
+} DMA_TypeDef;
+
+#define DMA_CCR_EN          0x00000001
+#define DMA_CCR_TCIE        0x00000002
+#define DMA_CCR_HTIE        0x00000004
+#define DMA_CCR_TEIE        0x00000008
+#define DMA_CCR_CIRC        0x00000020
+
+#define DMA_FLAG_GL1        0x00000001
+#define DMA_FLAG_TC1        0x00000002
+#define DMA_FLAG_HT1        0x00000004
+#define DMA_FLAG_TE1        0x00000008
+
+extern DMA_TypeDef HostDMA1;
+extern DMA_Channel_TypeDef HostDMA1Channel1;
+#define DMA1                (&HostDMA1)
+#define DMA1_Channel1       (&HostDMA1Channel1)
+
+typedef struct {
+    DMA_Channel_TypeDef * Instance;
+} DMA_HandleTypeDef;
+
+typedef struct {
+    ADC_TypeDef * Instance;
+    DMA_HandleTypeDef * DMA_Handle;
+} ADC_HandleTypeDef;
+
+#define __HAL_ADC_ENABLE_IT(__HANDLE__, __INTERRUPT__)  SET_BIT((__HANDLE__)->Instance->CR1, (__INTERRUPT__))
+#define __HAL_ADC_DISABLE_IT(__HANDLE__, __INTERRUPT__) CLEAR_BIT((__HANDLE__)->Instance->CR1, (__INTERRUPT__))
+// __INTERRUPT__ is given instead of the flag by ADC1_clearITPendingBit()
+#define __HAL_ADC_CLEAR_FLAG(__HANDLE__, __FLAG__)      CLEAR_BIT((__HANDLE__)->Instance->SR, ADC_FLAG_EOC)
+
+// The only channel is DMA1 channel 1, so the handle is not evaluated
+#define __HAL_DMA_GET_FLAG(__HANDLE__, __FLAG__)        (DMA1->ISR & (__FLAG__))
+#define __HAL_DMA_CLEAR_FLAG(__HANDLE__, __FLAG__)      CLEAR_BIT(DMA1->ISR, (__FLAG__))
+
+/*
+ * Timer
+ */
+typedef struct {
+    volatile uint32_t CR1;
+    volatile uint32_t PSC;
+    volatile uint32_t ARR;
+} TIM_TypeDef;
+
+#define TIM_CR1_CEN         0x00000001
+
+typedef struct {
+    TIM_TypeDef * Instance;
+} TIM_HandleTypeDef;
+
+#define __HAL_TIM_ENABLE(__HANDLE__)    SET_BIT((__HANDLE__)->Instance->CR1, TIM_CR1_CEN)
+#define __HAL_TIM_DISABLE(__HANDLE__)   CLEAR_BIT((__HANDLE__)->Instance->CR1, TIM_CR1_CEN)
+
+/*
+ * Not used on host, only for the declarations of stm32fx0xPeripherals.h
+ */
+typedef struct {
+    void * Instance;
+} RTC_HandleTypeDef;
+
+typedef struct {
+    void * Instance;
+} SPI_HandleTypeDef;
+
+/*
+ * Newlib function used by the firmware, which glibc has only since 2.38
+ */
+#if defined(__GLIBC__) && (__GLIBC__ == 2 && __GLIBC_MINOR__ < 38)
+extern "C" size_t strlcpy(char * aDestination, const char * aSource, size_t aSize);
+#define HOST_NEEDS_STRLCPY
+#endif
+
+/*
+ * Host side of the simulated ADC of HostDSO.cpp
+ */
+// Returns the raw ADC value of the simulated input signal at aSeconds after the first conversion
+extern uint16_t (*HostADCSampleCallback)(double aSeconds);
+extern uint32_t HostADCConversions;
+double getHostADCSamplePeriodSeconds(void);
+void runHostADC(uint32_t aNumberOfConversions);
+bool isHostADCRunning(void);
+
+#endif /* TOOLS_HOST_HOSTHAL_H_ */
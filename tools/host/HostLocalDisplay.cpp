@@ -0,0 +1,50 @@
+/**
+ * @file HostLocalDisplay.cpp
+ *
+ * Replacements for the parts of ADS7846.cpp and stm32fx0xPeripherals.cpp, which are used by the local display code
+ * of TouchButton.cpp, TouchSlider.cpp, EventHandler.cpp and the DSO, for programs built with HOST_SIMULATION
+ * and LOCAL_DISPLAY_EXISTS on x86 Linux.
+ * The display itself is emulated by MI0283QT2_Host.cpp.
+ *
+ * Only compiled if HOST_SIMULATION is defined.
+ *
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ */
+
+#ifdef HOST_SIMULATION
+
+#include "TouchButton.h" // for FeedbackToneOK()
+#include "ADS7846.h"
+#include "stm32fx0xPeripherals.h" // for FeedbackTone()
+
+/*
+ * No touch panel on host, the programs call the check functions with their own positions
+ */
+ADS7846::ADS7846(void) {
+}
+
+ADS7846 TouchPanel;
+
+const char * const ADS7846ChannelStrings[] = { "Z Pos 1", "Z Pos 2", "X Pos", "Y Pos", "Temp. 0", "Temp. 1", "VCC",
+        "Aux In" };
+unsigned char ADS7846ChannelMapping[] = { 3, 4, 1, 5, 0, 7, 2, 6 };
+
+// the DSO can use the channels of the touch controller as input
+uint16_t ADS7846::readChannel(uint8_t channel, bool use12Bit, bool useDiffMode, int numberOfReadingsToIntegrate) {
+    (void) channel;
+    (void) useDiffMode;
+    (void) numberOfReadingsToIntegrate;
+    return use12Bit ? 2048 : 128;
+}
+
+/*
+ * No tone on host
+ */
+void FeedbackToneOK(void) {
+}
+
+void FeedbackTone(unsigned int aFeedbackType) {
+    (void) aFeedbackType;
+}
+
+#endif // HOST_SIMULATION
@@ -0,0 +1,118 @@
+/**
+ * @file HostSupport.cpp
+ *
+ * Replacements for the timing and assert functions of timing.cpp and AssertErrorAndMisc.cpp
+ * for programs built with HOST_SIMULATION on x86 Linux.
+ *
+ * Only compiled if HOST_SIMULATION is defined.
+ *
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ */
+
+#ifdef HOST_SIMULATION
+
+#include "HostSupport.h"
+#include "BlueSerial.h"
+#include "timing.h"
+#include "AssertErrorAndMisc.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+int sLockCount = 0;
+int DebugValue1;
+int DebugValue2;
+int DebugValue3;
+int DebugValue4;
+
+volatile uint32_t TimeoutCounterForThread;
+static uint64_t sTimeoutNanos;
+bool HostMillisFollowLinkTime = false;
+
+/**
+ * @return monotonic time of host in nanoseconds
+ */
+uint64_t getHostNanos(void) {
+    struct timespec tTime;
+    clock_gettime(CLOCK_MONOTONIC, &tTime);
+    return (uint64_t) tTime.tv_sec * 1000000000 + tTime.tv_nsec;
+}
+
+/**
+ * @return host time in cycles of the 72 MHz target
+ */
+uint32_t getCycleCount(void) {
+    return (uint32_t) (getHostNanos() * 72 / 1000);
+}
+
+uint32_t getMillisSinceBoot(void) {
+    if (HostMillisFollowLinkTime) {
+        return HostLinkNanos / 1000000;
+    }
+    static uint64_t sStartNanos = getHostNanos();
+    return (getHostNanos() - sStartNanos) / 1000000;
+}
+
+void delayMillis(int32_t aTimeMillis) {
+    struct timespec tTime;
+    tTime.tv_sec = aTimeMillis / 1000;
+    tTime.tv_nsec = (aTimeMillis % 1000) * 1000000L;
+    nanosleep(&tTime, NULL);
+}
+
+void delayNanos(int32_t aTimeNanos) {
+    struct timespec tTime;
+    tTime.tv_sec = 0;
+    tTime.tv_nsec = aTimeNanos;
+    nanosleep(&tTime, NULL);
+}
+
+void setTimeoutMillis(int32_t aTimeMillis) {
+    sTimeoutNanos = getHostNanos() + (uint64_t) aTimeMillis * 1000000;
+}
+
+bool isTimeoutSimple(void) {
+    return (getHostNanos() > sTimeoutNanos);
+}
+
+bool isTimeoutVerbose(uint8_t* aFile, uint32_t aLine, uint32_t aLinkRegister, int32_t aMessageDisplayTimeMillis) {
+    if (isTimeoutSimple()) {
+        fprintf(stderr, "Timeout on line: %u file: %s\n", aLine, (char *) aFile);
+        return true;
+    }
+    return false;
+}
+
+/*
+ * Delay callbacks are not supported on host
+ */
+void registerDelayCallback(void (*aGenericCallback)(void), int32_t aTimeMillis) {
+}
+
+void changeDelayCallback(void (*aGenericCallback)(void), int32_t aTimeMillis) {
+}
+
+/*
+ * No sleep on host. If HostIdleCallback is set, the test program simulates the sleep by advancing the link time.
+ */
+uint32_t (*HostIdleCallback)(uint32_t aMaxMillis) = NULL;
+
+uint32_t idleMillis(uint32_t aMaxMillis, bool (*aIsWorkPendingFunction)(void)) {
+    if (aMaxMillis == 0 || HostIdleCallback == NULL || (aIsWorkPendingFunction != NULL && aIsWorkPendingFunction())) {
+        return 0;
+    }
+    return HostIdleCallback(aMaxMillis);
+}
+
+extern "C" void assertFailedParamMessage(uint8_t* aFile, uint32_t aLine, uint32_t aLinkRegister, int aWrongParameter,
+        const char * aMessage) {
+    fprintf(stderr, "Assert on line: %u file: %s param: %d %s\n", aLine, (char *) aFile, aWrongParameter, aMessage);
+    abort();
+}
+
+extern "C" void printError(uint8_t* aFile, uint32_t aLine) {
+    fprintf(stderr, "Error on line: %u file: %s\n", aLine, (char *) aFile);
+}
+
+#endif // HOST_SIMULATION
@@ -0,0 +1,20 @@
+/**
+ * @file HostSupport.h
+ *
+ * Support functions for programs built with HOST_SIMULATION on x86 Linux.
+ *
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ */
+
+#ifndef TOOLS_HOST_HOSTSUPPORT_H_
+#define TOOLS_HOST_HOSTSUPPORT_H_
+
+#include <stdint.h>
+
+uint64_t getHostNanos(void);
+// if true, getMillisSinceBoot() returns the simulated link time HostLinkNanos instead of the host time
+extern bool HostMillisFollowLinkTime;
+// if set, idleMillis() calls it to simulate the sleep, returns number of suppressed systics
+extern uint32_t (*HostIdleCallback)(uint32_t aMaxMillis);
+
+#endif /* TOOLS_HOST_HOSTSUPPORT_H_ */
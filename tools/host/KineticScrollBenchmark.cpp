@@ -0,0 +1,307 @@
+/**
+ * @file KineticScrollBenchmark.cpp
+ *
+ * Host test of velocity estimation and kinetic scrolling of KineticScroll.cpp with touch traces.
+ * The remote app sends each trace with jittered touch moves every 10 ms at 115200 baud, the main loop is idle
+ * and calls checkAndHandleEvents() every millisecond. The scroll callback records each call.
+ *
+ * For each trace prints the number of scroll callbacks while dragging and after touch up, the shortest period between
+ * two callbacks, the time from touch down until the content is moved first, the total scrolled distance,
+ * the distance scrolled beyond the touch up position and the estimated velocity at touch up compared with the velocity of the trace.
+ * Before, only the swipe end callback was available, which moves the content once at touch up by the dragged distance.
+ *
+ * Build on x86 Linux from project root with: make -C tools/host build/KineticScrollBenchmark
+ * and run it with: tools/host/build/KineticScrollBenchmark
+ *
+ * Only compiled if HOST_SIMULATION is defined.
+ *
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ */
+
+#ifdef HOST_SIMULATION
+
+#include "BlueDisplay.h"
+#include "EventHandler.h"
+#include "HostSupport.h"
+#include "timing.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define MOVE_INTERVAL_MILLIS 10
+#define MAIN_LOOP_NANOS 1000000
+#define AFTER_TRACE_MILLIS 2000 // time for the fling to end
+#define TOUCH_MESSAGE_SIZE 8 // length, event type, 5 byte TouchEvent and sync token
+#define TRACE_MAX_SIZE 64
+#define MAX_CALLBACKS 256
+
+const unsigned int REMOTE_DISPLAY_HEIGHT = 240;
+const unsigned int REMOTE_DISPLAY_WIDTH = 320;
+
+// of EventHandler.cpp
+extern struct KineticScroll sKineticScroll;
+
+/*
+ * Remote side
+ */
+struct TraceEntry {
+    uint32_t Millis;
+    uint8_t EventType;
+    uint16_t PositionX;
+};
+
+static struct TraceEntry sTrace[TRACE_MAX_SIZE];
+static int sTraceLength;
+static int sNextTraceIndex;
+
+static void addTraceEntry(uint32_t aMillis, uint8_t aEventType, uint16_t aPositionX) {
+    sTrace[sTraceLength].Millis = aMillis;
+    sTrace[sTraceLength].EventType = aEventType;
+    sTrace[sTraceLength].PositionX = aPositionX;
+    sTraceLength++;
+}
+
+// noise of touch panel
+static const int8_t sJitter[] = { 0, 2, -1, 1, -2, 1, 0, -1 };
+
+/*
+ * Touch down at aStartMillis, moves with constant velocity and some jitter for aDurationMillis,
+ * then rests for aRestMillis and goes up
+ * @return millis of touch up
+ */
+static uint32_t addDrag(uint32_t aStartMillis, int aStartX, int aVelocity, uint32_t aDurationMillis, uint32_t aRestMillis) {
+    addTraceEntry(aStartMillis, EVENT_TOUCH_ACTION_DOWN, aStartX);
+    int tPositionX = aStartX;
+    for (uint32_t tMillis = MOVE_INTERVAL_MILLIS; tMillis <= aDurationMillis; tMillis += MOVE_INTERVAL_MILLIS) {
+        tPositionX = aStartX + (aVelocity * (int) tMillis) / 1000;
+        addTraceEntry(aStartMillis + tMillis, EVENT_TOUCH_ACTION_MOVE,
+                tPositionX + sJitter[(tMillis / MOVE_INTERVAL_MILLIS) % sizeof(sJitter)]);
+    }
+    uint32_t tUpMillis = aStartMillis + aDurationMillis + aRestMillis;
+    addTraceEntry(tUpMillis, EVENT_TOUCH_ACTION_UP, tPositionX);
+    return tUpMillis;
+}
+
+static void putTouchMessage(uint8_t aEventType, uint16_t aPosX) {
+    uint8_t tMessage[TOUCH_MESSAGE_SIZE] = { TOUCH_MESSAGE_SIZE, aEventType, (uint8_t) aPosX, (uint8_t) (aPosX >> 8), 200, 0,
+            0, SYNC_TOKEN };
+    hostReceiveBytes(tMessage, TOUCH_MESSAGE_SIZE);
+}
+
+static void feedTraceUntilLinkTime(void) {
+    while (sNextTraceIndex < sTraceLength && sTrace[sNextTraceIndex].Millis * 1000000ULL <= HostLinkNanos) {
+        putTouchMessage(sTrace[sNextTraceIndex].EventType, sTrace[sNextTraceIndex].PositionX);
+        sNextTraceIndex++;
+    }
+}
+
+/*
+ * Local side
+ */
+struct ScrollCallback {
+    uint32_t Millis;
+    struct Scroll Info;
+};
+
+static struct ScrollCallback sCallbacks[MAX_CALLBACKS];
+static int sNumberOfCallbacks;
+static int sNumberOfTouchUpCallbacks;
+
+static void recordScroll(struct Scroll * aScrollInfo) {
+    if (sNumberOfCallbacks < MAX_CALLBACKS) {
+        sCallbacks[sNumberOfCallbacks].Millis = getMillisSinceBoot();
+        sCallbacks[sNumberOfCallbacks].Info = *aScrollInfo;
+        sNumberOfCallbacks++;
+    }
+}
+
+static void recordTouchUp(struct TouchEvent * aActualPositionPtr) {
+    (void) aActualPositionPtr;
+    sNumberOfTouchUpCallbacks++;
+}
+
+static bool sAllChecksPassed = true;
+
+static void check(bool aCondition, const char * aTraceName, const char * aText) {
+    if (!aCondition) {
+        printf("%-12s FAILED: %s\n", aTraceName, aText);
+        sAllChecksPassed = false;
+    }
+}
+
+struct TraceResult {
+    int DragCallbacks;
+    int FlingCallbacks;
+    int LastCallbacks;
+    int MinPeriodMillis;
+    int FirstMoveMillis; // -1 -> content was not moved
+    int TotalDistance;
+    int FlingDistance; // beyond touch up position
+    int FlingVelocity; // estimated at touch up
+    uint32_t LastFlingMillis; // of last callback with delta
+};
+
+/*
+ * Sends the trace and evaluates the recorded callbacks
+ */
+static void runTrace(uint32_t aEndMillis, int aTraceDistance, struct TraceResult * aResult) {
+    UART_BD_initialize(BAUD_115200);
+    hostResetLinkCounters();
+    resetReceiveStatistics();
+    sNextTraceIndex = 0;
+    sNumberOfCallbacks = 0;
+    sNumberOfTouchUpCallbacks = 0;
+
+    uint32_t tFirstUpMillis = 0;
+    for (int i = 0; i < sTraceLength; ++i) {
+        if (sTrace[i].EventType == EVENT_TOUCH_ACTION_UP) {
+            tFirstUpMillis = sTrace[i].Millis;
+            break;
+        }
+    }
+    aResult->FlingVelocity = 0;
+    bool tUpSeen = false;
+    while (HostLinkNanos < (aEndMillis + AFTER_TRACE_MILLIS) * 1000000ULL) {
+        hostAdvanceLinkTime(MAIN_LOOP_NANOS);
+        checkAndHandleEvents();
+        if (!tUpSeen && sKineticScroll.IsDragging == false && getMillisSinceBoot() >= tFirstUpMillis) {
+            tUpSeen = true;
+            aResult->FlingVelocity = sKineticScroll.VelocityX;
+        }
+    }
+    hostFlushLink();
+
+    aResult->DragCallbacks = 0;
+    aResult->FlingCallbacks = 0;
+    aResult->LastCallbacks = 0;
+    aResult->MinPeriodMillis = 1000;
+    aResult->FirstMoveMillis = -1;
+    aResult->TotalDistance = 0;
+    aResult->LastFlingMillis = 0;
+    for (int i = 0; i < sNumberOfCallbacks; ++i) {
+        struct Scroll * tInfo = &sCallbacks[i].Info;
+        if (tInfo->IsKinetic) {
+            aResult->FlingCallbacks++;
+            if (tInfo->DeltaX != 0) {
+                aResult->LastFlingMillis = sCallbacks[i].Millis;
+            }
+        } else {
+            aResult->DragCallbacks++;
+        }
+        aResult->TotalDistance += tInfo->DeltaX;
+        if (tInfo->IsLast) {
+            aResult->LastCallbacks++;
+        }
+        if (aResult->FirstMoveMillis < 0 && tInfo->DeltaX != 0) {
+            aResult->FirstMoveMillis = sCallbacks[i].Millis - sTrace[0].Millis;
+        }
+        if (i > 0 && (int) (sCallbacks[i].Millis - sCallbacks[i - 1].Millis) < aResult->MinPeriodMillis) {
+            aResult->MinPeriodMillis = sCallbacks[i].Millis - sCallbacks[i - 1].Millis;
+        }
+    }
+    aResult->FlingDistance = (sNumberOfCallbacks == 0) ? 0 : aResult->TotalDistance - aTraceDistance;
+}
+
+static void printResult(const char * aTraceName, struct TraceResult * aResult, int aTraceVelocity, int aSwipeDistance,
+        uint32_t aUpMillis) {
+    printf("%-12s %3d %3d %4d ms %4d ms %5d px %5d px %5d px/s %5d px/s | %4u ms %5d px\n", aTraceName, aResult->DragCallbacks,
+            aResult->FlingCallbacks, aResult->MinPeriodMillis == 1000 ? 0 : aResult->MinPeriodMillis, aResult->FirstMoveMillis,
+            aResult->TotalDistance, aResult->FlingDistance, aResult->FlingVelocity, aTraceVelocity, aUpMillis - sTrace[0].Millis,
+            aSwipeDistance);
+}
+
+static void checkCommon(const char * aTraceName, struct TraceResult * aResult) {
+    check(sNumberOfCallbacks == 0 || aResult->MinPeriodMillis >= SCROLL_FRAME_PERIOD_MILLIS, aTraceName,
+            "scroll callbacks faster than frame period");
+    check(sNumberOfCallbacks == 0 || aResult->LastCallbacks == 1, aTraceName, "not exactly one last callback");
+    check(sNumberOfCallbacks == 0 || sCallbacks[sNumberOfCallbacks - 1].Info.IsLast, aTraceName,
+            "callback after last callback");
+    check(sNumberOfCallbacks < MAX_CALLBACKS, aTraceName, "too many callbacks");
+}
+
+/*
+ * Estimated velocity must be within 10 percent and fling distance near velocity * time constant
+ */
+static void checkFling(const char * aTraceName, struct TraceResult * aResult, int aTraceVelocity) {
+    check(abs(aResult->FlingVelocity - aTraceVelocity) <= abs(aTraceVelocity) / 10, aTraceName, "velocity estimation");
+    int tExpectedDistance = (aResult->FlingVelocity * KINETIC_SCROLL_TIME_CONSTANT_MILLIS) / 1000;
+    check(abs(aResult->FlingDistance - tExpectedDistance) <= abs(tExpectedDistance) / 10, aTraceName, "fling distance");
+}
+
+int main(void) {
+    HostBluetoothPaired = true;
+    HostMillisFollowLinkTime = true;
+    HostLinkReadCallback = &feedTraceUntilLinkTime;
+    registerScrollCallback(&recordScroll);
+    registerTouchUpCallback(&recordTouchUp);
+
+    printf("Touch traces with moves every %d ms at 115200 baud, scroll frame period %d ms\n", MOVE_INTERVAL_MILLIS,
+            SCROLL_FRAME_PERIOD_MILLIS);
+    printf("                 scroll callbacks                                                   | swipe end only\n");
+    printf("trace        drag   up period first scrolled   flinged   velocity   of trace | first   moved\n");
+
+    struct TraceResult tResult;
+    uint32_t tStartMillis = 1000;
+
+    /*
+     * Tap, moves less than threshold
+     */
+    sTraceLength = 0;
+    uint32_t tUpMillis = addDrag(tStartMillis, 100, 50, 80, 0);
+    runTrace(tUpMillis, 0, &tResult);
+    printResult("tap", &tResult, 0, 0, tUpMillis);
+    check(sNumberOfCallbacks == 0, "tap", "scroll callback for tap");
+    check(sNumberOfTouchUpCallbacks == 1, "tap", "no touch up callback for tap");
+
+    /*
+     * Slow drag, finger rests before touch up -> no fling
+     */
+    tStartMillis = getMillisSinceBoot() + 100;
+    sTraceLength = 0;
+    tUpMillis = addDrag(tStartMillis, 40, 200, 500, 300);
+    runTrace(tUpMillis, 100, &tResult);
+    printResult("slow drag", &tResult, 0, 100, tUpMillis);
+    checkCommon("slow drag", &tResult);
+    check(tResult.TotalDistance == 100, "slow drag", "scrolled distance");
+    check(tResult.FlingDistance == 0 && tResult.FlingVelocity == 0, "slow drag", "fling after rest");
+    check(sNumberOfTouchUpCallbacks == 0, "slow drag", "touch up callback after scroll");
+
+    /*
+     * Flick to the right and to the left
+     */
+    tStartMillis = getMillisSinceBoot() + 100;
+    sTraceLength = 0;
+    tUpMillis = addDrag(tStartMillis, 40, 800, 150, 0);
+    runTrace(tUpMillis, 120, &tResult);
+    printResult("flick right", &tResult, 800, 120, tUpMillis);
+    checkCommon("flick right", &tResult);
+    checkFling("flick right", &tResult, 800);
+
+    tStartMillis = getMillisSinceBoot() + 100;
+    sTraceLength = 0;
+    tUpMillis = addDrag(tStartMillis, 280, -1500, 150, 0);
+    runTrace(tUpMillis, -225, &tResult);
+    printResult("flick left", &tResult, -1500, -225, tUpMillis);
+    checkCommon("flick left", &tResult);
+    checkFling("flick left", &tResult, -1500);
+
+    /*
+     * Flick, which is caught 100 ms after touch up
+     */
+    tStartMillis = getMillisSinceBoot() + 100;
+    sTraceLength = 0;
+    tUpMillis = addDrag(tStartMillis, 40, 800, 150, 0);
+    uint32_t tCatchMillis = tUpMillis + 100;
+    addTraceEntry(tCatchMillis, EVENT_TOUCH_ACTION_DOWN, 200);
+    addTraceEntry(tCatchMillis + 50, EVENT_TOUCH_ACTION_UP, 200);
+    runTrace(tCatchMillis + 50, 120, &tResult);
+    printResult("flick caught", &tResult, 800, 120, tUpMillis);
+    check(tResult.LastFlingMillis <= tCatchMillis + 1, "flick caught", "fling continues after touch down");
+    check(tResult.FlingDistance < (800 * KINETIC_SCROLL_TIME_CONSTANT_MILLIS) / 1000 / 2, "flick caught", "fling not stopped");
+    check(sNumberOfTouchUpCallbacks == 1, "flick caught", "no touch up callback for catching tap");
+
+    printf("all trace checks %s\n", sAllChecksPassed ? "passed" : "FAILED");
+    return sAllChecksPassed ? 0 : 1;
+}
+
+#endif // HOST_SIMULATION
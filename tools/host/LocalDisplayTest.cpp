@@ -0,0 +1,146 @@
+/**
+ * @file LocalDisplayTest.cpp
+ *
+ * Golden image test of the local display drawing code. Links the unchanged MI0283QT2.cpp, thickLine.cpp and Chart.cpp
+ * with the host backend MI0283QT2_Host.cpp, draws a fixed scene into its framebuffer
+ * and compares the result pixel by pixel with reference/LocalDisplayTest.ppm.
+ *
+ * On a difference the rendered image is written to LocalDisplayTest.ppm in the current directory.
+ * After an intended change of the drawing code, write a new reference with: tools/host/build/LocalDisplayTest -w
+ *
+ * Build on x86 Linux from project root with: make -C tools/host build/LocalDisplayTest
+ * and run it with: tools/host/build/LocalDisplayTest
+ *
+ * Only compiled if HOST_SIMULATION is defined.
+ *
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ */
+
+#ifdef HOST_SIMULATION
+
+#include "BlueDisplay.h"
+#include "MI0283QT2.h"
+#include "thickLine.h"
+#include "Chart.h"
+#include "HostSupport.h"
+
+#include <stdio.h>
+#include <string.h>
+
+const unsigned int REMOTE_DISPLAY_HEIGHT = 240;
+const unsigned int REMOTE_DISPLAY_WIDTH = 320;
+
+#ifndef REFERENCE_PPM
+#define REFERENCE_PPM "reference/LocalDisplayTest.ppm"
+#endif
+#define RENDERED_PPM "LocalDisplayTest.ppm"
+#define PPM_HEADER_SIZE 15 // "P6\n320 240\n255\n"
+
+static uint8_t sReference[PPM_HEADER_SIZE + LOCAL_DISPLAY_WIDTH * LOCAL_DISPLAY_HEIGHT * 3];
+static uint8_t sRendered[sizeof(sReference)];
+
+static bool sAllChecksPassed = true;
+
+static void check(bool aCondition, const char * aMessage) {
+    if (!aCondition) {
+        printf("FAILED: %s\n", aMessage);
+        sAllChecksPassed = false;
+    }
+}
+
+/*
+ * Uses the primitives of MI0283QT2.cpp directly and Chart.cpp via BlueDisplay1, which draws on the local display
+ */
+static void drawScene(void) {
+    BlueDisplay1.clearDisplay(COLOR_WHITE);
+
+    LocalDisplay.fillRect(4, 4, 60, 40, COLOR_RED);
+    LocalDisplay.fillRectRel(64, 4, 57, 37, COLOR_GREEN);
+    LocalDisplay.drawRect(124, 4, 180, 40, COLOR_BLUE);
+    LocalDisplay.drawLine(184, 4, 240, 40, COLOR_BLACK);
+    LocalDisplay.drawLine(184, 40, 240, 4, COLOR_BLACK);
+    LocalDisplay.drawCircle(270, 22, 18, COLOR_MAGENTA);
+    LocalDisplay.fillCircle(300, 22, 10, COLOR_CYAN);
+    for (uint16_t x = 4; x < 316; x += 3) {
+        LocalDisplay.drawPixel(x, 44, COLOR_BLACK);
+    }
+
+    LocalDisplay.drawText(4, 48, "Text 11 0123456789", 1, COLOR_BLACK, COLOR_YELLOW);
+    LocalDisplay.drawText(4, 62, "Text 22", 2, COLOR_BLUE, COLOR_WHITE);
+    LocalDisplay.drawTextVertical(300, 48, "Vert", 1, COLOR_RED, COLOR_WHITE);
+
+    drawThickLine(150, 50, 290, 80, 5, LINE_THICKNESS_MIDDLE, COLOR_RED);
+    drawThickLine(150, 90, 200, 60, 3, LINE_THICKNESS_DRAW_CLOCKWISE, COLOR_BLUE);
+    drawThickLineSimple(210, 90, 290, 90, 4, LINE_THICKNESS_DRAW_COUNTERCLOCKWISE, COLOR_GREEN);
+    drawLineOverlap(4, 100, 140, 110, LINE_OVERLAP_BOTH, COLOR_MAGENTA);
+
+    /*
+     * Chart with grid, labels and triangle signal
+     */
+    Chart tChart;
+    int16_t tData[200];
+    for (int i = 0; i < 200; ++i) {
+        tData[i] = (i % 50 < 25) ? (i % 50) * 4 : (50 - i % 50) * 4;
+    }
+    tChart.initChartColors(COLOR_RED, CHART_DEFAULT_AXES_COLOR, CHART_DEFAULT_GRID_COLOR, CHART_DEFAULT_LABEL_COLOR,
+    CHART_DEFAULT_BACKGROUND_COLOR);
+    tChart.initChart(40, 215, 200, 90, 2, true, 25, 20);
+    tChart.initXLabelInt(0, 10, 1, 2);
+    tChart.initYLabelInt(0, 20, 1.0, 3);
+    tChart.drawAxesAndGrid();
+    tChart.drawChartData(tData, &tData[200], CHART_MODE_LINE);
+}
+
+static bool readFile(const char * aFilename, uint8_t * aBuffer, size_t aSize) {
+    FILE * tFile = fopen(aFilename, "rb");
+    if (tFile == NULL) {
+        return false;
+    }
+    size_t tCount = fread(aBuffer, 1, aSize, tFile);
+    bool tIsEndOfFile = (fgetc(tFile) == EOF);
+    fclose(tFile);
+    return tCount == aSize && tIsEndOfFile;
+}
+
+int main(int argc, char * argv[]) {
+    // only the local display is drawn
+    HostBluetoothPaired = false;
+    hostResetDisplayCounters();
+    drawScene();
+    hostPrintDisplayCounters(stdout);
+
+    if (argc > 1 && strcmp(argv[1], "-w") == 0) {
+        bool tSuccess = hostStoreDisplayPPM(REFERENCE_PPM);
+        printf("reference %s %s\n", REFERENCE_PPM, tSuccess ? "written" : "could not be written");
+        return tSuccess ? 0 : 1;
+    }
+
+    check(hostStoreDisplayPPM(RENDERED_PPM) && readFile(RENDERED_PPM, sRendered, sizeof(sRendered)),
+            "rendered image could not be written");
+    if (!readFile(REFERENCE_PPM, sReference, sizeof(sReference))) {
+        check(false, "reference " REFERENCE_PPM " missing or of wrong size");
+    } else {
+        check(memcmp(sReference, sRendered, PPM_HEADER_SIZE) == 0, "wrong PPM header");
+        int tDifferentPixels = 0;
+        for (unsigned int i = PPM_HEADER_SIZE; i < sizeof(sReference); i += 3) {
+            if (memcmp(&sReference[i], &sRendered[i], 3) != 0) {
+                if (tDifferentPixels == 0) {
+                    unsigned int tPixelIndex = (i - PPM_HEADER_SIZE) / 3;
+                    printf("first difference at x=%u y=%u\n", tPixelIndex % LOCAL_DISPLAY_WIDTH,
+                            tPixelIndex / LOCAL_DISPLAY_WIDTH);
+                }
+                tDifferentPixels++;
+            }
+        }
+        printf("%d pixels differ from reference\n", tDifferentPixels);
+        check(tDifferentPixels == 0, "image differs from reference, see " RENDERED_PPM);
+    }
+    if (sAllChecksPassed) {
+        remove(RENDERED_PPM);
+    }
+
+    printf("all checks %s\n", sAllChecksPassed ? "passed" : "FAILED");
+    return sAllChecksPassed ? 0 : 1;
+}
+
+#endif // HOST_SIMULATION
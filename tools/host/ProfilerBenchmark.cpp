@@ -0,0 +1,232 @@
+/**
+ * @file ProfilerBenchmark.cpp
+ *
+ * Host benchmark and check for the PC histogram of Profiler.cpp.
+ *
+ * 1. Samples PCs of up to NUMBER_OF_FUNCTIONS functions of 32 to 512 bytes with a Zipf like distribution,
+ *    as they come from a main loop with some hot functions. Prints the time per recordProfilerSample() call
+ *    and the bucket size. The dumped count of each bucket must be exact.
+ *    Prints the error of the TOP_FUNCTIONS most frequently sampled functions, if the samples of the buckets are
+ *    distributed to the functions like symbolizeProfile.py does.
+ * 2. Samples PCs inside the functions workA(), workB() and workC() of this program in the ratio 5:3:2.
+ *    The dump is written to the file given as first argument. It can be symbolized with
+ *    tools/host/symbolizeProfile.py --nm nm tools/host/build/ProfilerBenchmark <file>, which must print 50%, 30% and 20%.
+ *
+ * The cost of one sample on the target is the exception entry and exit (24 cycles), the trampoline of
+ * SysTick_Handler() (5 cycles) and recordProfilerSample() with app. 15 cycles,
+ * i.e. about 45 of 72000 cycles or 0.06% at 1 kHz.
+ *
+ * Build on x86 Linux from project root with: make -C tools/host build/ProfilerBenchmark
+ * and run it with: tools/host/build/ProfilerBenchmark
+ *
+ * Only compiled if HOST_SIMULATION is defined.
+ *
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ */
+
+#ifdef HOST_SIMULATION
+
+#include "Profiler.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#ifndef USE_PC_SAMPLING_PROFILER
+#error "ProfilerBenchmark must be compiled with -DUSE_PC_SAMPLING_PROFILER"
+#endif
+
+const unsigned int REMOTE_DISPLAY_HEIGHT = 240;
+const unsigned int REMOTE_DISPLAY_WIDTH = 320;
+
+#define CODE_START (PROFILER_CODE_START + 0x190) // behind vector table
+#define NUMBER_OF_FUNCTIONS 300
+#define SAMPLES 1000000
+#define TOP_FUNCTIONS 20
+
+/*
+ * Functions to be found by the symbolizer. Aligned and in an own section, so that no bucket is shared with other functions.
+ */
+extern "C" __attribute__((noinline, aligned(64), section(".text.work"))) int workA(int aValue) {
+    return aValue * 3 + 1;
+}
+extern "C" __attribute__((noinline, aligned(64), section(".text.work"))) int workB(int aValue) {
+    return aValue * 5 + 2;
+}
+extern "C" __attribute__((noinline, aligned(64), section(".text.work"))) int workC(int aValue) {
+    return aValue * 7 + 3;
+}
+extern "C" __attribute__((noinline, aligned(64), section(".text.work"))) int workEnd(int aValue) {
+    return aValue;
+}
+
+extern char CodeEnd asm("_etext");
+
+static uint32_t sFunctionStarts[NUMBER_OF_FUNCTIONS + 1];
+static int sNumberOfFunctions;
+static uint32_t sCumulatedWeights[NUMBER_OF_FUNCTIONS]; // Zipf: weight of rank i is 1/(i+1)
+static uint32_t sTrueCounts[NUMBER_OF_FUNCTIONS];
+static double sDumpedCounts[NUMBER_OF_FUNCTIONS];
+static uint32_t sTrueBucketCounts[PROFILER_HISTOGRAM_SIZE];
+
+static uint32_t sDumpedSamples;
+static uint32_t sWrongBuckets;
+static FILE * sDumpFile;
+
+static void countDump(const char * aText, int aLength) {
+    unsigned int tBucketStart;
+    unsigned int tCount;
+    if (sscanf(aText, "%x %u", &tBucketStart, &tCount) == 2 && aLength > 9) {
+        sDumpedSamples += tCount;
+        uint32_t tBucketSize = 1 << ProfilerStatistics.BucketShift;
+        uint32_t tBucketIndex = (tBucketStart - PROFILER_CODE_START) >> ProfilerStatistics.BucketShift;
+        if (tBucketIndex < PROFILER_HISTOGRAM_SIZE && sTrueBucketCounts[tBucketIndex] != tCount) {
+            sWrongBuckets++;
+        }
+        // distribute the samples in proportion to the bytes of the functions in the bucket
+        for (int i = 0; i < sNumberOfFunctions; ++i) {
+            uint32_t tStart = sFunctionStarts[i] > tBucketStart ? sFunctionStarts[i] : tBucketStart;
+            uint32_t tEnd = sFunctionStarts[i + 1] < tBucketStart + tBucketSize ? sFunctionStarts[i + 1] : tBucketStart + tBucketSize;
+            if (tStart < tEnd) {
+                sDumpedCounts[i] += (double) tCount * (tEnd - tStart) / tBucketSize;
+            }
+        }
+    }
+    if (sDumpFile != NULL) {
+        fwrite(aText, 1, aLength, sDumpFile);
+    }
+}
+
+static bool sAllChecksPassed = true;
+
+static void check(bool aCondition, const char * aMessage) {
+    if (!aCondition) {
+        printf("FAILED: %s\n", aMessage);
+        sAllChecksPassed = false;
+    }
+}
+
+int main(int argc, char * argv[]) {
+    /*
+     * 1. Load with more sampled buckets than entries
+     */
+    uint32_t tRandom = 12345;
+    double tWeightSum = 0;
+    sFunctionStarts[0] = CODE_START;
+    // the profiler only accepts PCs up to the end of code of this program
+    while (sNumberOfFunctions < NUMBER_OF_FUNCTIONS) {
+        tRandom = tRandom * 1103515245 + 12345;
+        uint32_t tNextStart = sFunctionStarts[sNumberOfFunctions] + 32 + ((tRandom >> 16) % 31) * 16;
+        if (tNextStart > (uint32_t) (uintptr_t) &CodeEnd) {
+            break;
+        }
+        sFunctionStarts[sNumberOfFunctions + 1] = tNextStart;
+        tWeightSum += 1.0 / (sNumberOfFunctions + 1);
+        sCumulatedWeights[sNumberOfFunctions] = (uint32_t) (tWeightSum * 1000000);
+        sNumberOfFunctions++;
+    }
+    uint32_t tWeightTotal = sCumulatedWeights[sNumberOfFunctions - 1];
+    static uint32_t sSamplePCs[SAMPLES];
+    for (int i = 0; i < SAMPLES; ++i) {
+        tRandom = tRandom * 1103515245 + 12345;
+        uint32_t tWeight = (tRandom >> 4) % tWeightTotal;
+        int tRank = 0;
+        int tHigh = sNumberOfFunctions - 1;
+        while (tRank < tHigh) {
+            int tMiddle = (tRank + tHigh) / 2;
+            if (sCumulatedWeights[tMiddle] <= tWeight) {
+                tRank = tMiddle + 1;
+            } else {
+                tHigh = tMiddle;
+            }
+        }
+        // any halfword in function
+        tRandom = tRandom * 1103515245 + 12345;
+        uint32_t tSize = sFunctionStarts[tRank + 1] - sFunctionStarts[tRank];
+        sSamplePCs[i] = sFunctionStarts[tRank] + ((tRandom >> 8) % tSize & ~1);
+        sTrueCounts[tRank]++;
+    }
+    startProfiler(); // to get the bucket size
+    for (int i = 0; i < SAMPLES; ++i) {
+        sTrueBucketCounts[(sSamplePCs[i] - PROFILER_CODE_START) >> ProfilerStatistics.BucketShift]++;
+    }
+
+    struct timespec tStart, tEnd;
+    clock_gettime(CLOCK_MONOTONIC, &tStart);
+    for (int i = 0; i < SAMPLES; ++i) {
+        recordProfilerSample(sSamplePCs[i]);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &tEnd);
+    stopProfiler();
+    double tNanosPerSample = ((tEnd.tv_sec - tStart.tv_sec) * 1e9 + (tEnd.tv_nsec - tStart.tv_nsec)) / SAMPLES;
+    addProfilerIdleSamples(100); // must be ignored, since stopped
+
+    sDumpedSamples = 0;
+    dumpProfiler(&countDump);
+    printf("%d samples of %d functions with %lu bytes of code\n", SAMPLES, sNumberOfFunctions,
+            (unsigned long) (sFunctionStarts[sNumberOfFunctions] - sFunctionStarts[0]));
+    printf("%.1f host ns per sample, bucket size %d for %lu bytes of code, %u buckets used\n", tNanosPerSample,
+            1 << ProfilerStatistics.BucketShift, (unsigned long) (ProfilerStatistics.CodeEnd - PROFILER_CODE_START),
+            ProfilerStatistics.UsedBuckets);
+    check(ProfilerStatistics.Samples == SAMPLES, "sample count");
+    check(ProfilerStatistics.DroppedSamples == 0, "samples dropped");
+    check(sDumpedSamples == SAMPLES, "dumped samples != samples");
+    check(sWrongBuckets == 0, "wrong bucket counts");
+    double tMaxErrorPercent = 0;
+    for (int i = 0; i < TOP_FUNCTIONS; ++i) {
+        double tErrorPercent = fabs(sTrueCounts[i] - sDumpedCounts[i]) * 100.0 / sTrueCounts[i];
+        if (tMaxErrorPercent < tErrorPercent) {
+            tMaxErrorPercent = tErrorPercent;
+        }
+    }
+    printf("max error of samples of the %d most frequent functions by distributing buckets %.2f%%\n", TOP_FUNCTIONS,
+            tMaxErrorPercent);
+
+    /*
+     * Counter overflow stops profiler
+     */
+    startProfiler();
+    for (int i = 0; i < 0x10000; ++i) {
+        recordProfilerSample(CODE_START);
+    }
+    check(!isProfilerRunning() && ProfilerStatistics.Samples == 0xFFFF, "profiler not stopped at counter overflow");
+
+    /*
+     * 2. Known functions for the symbolizer
+     */
+    startProfiler();
+    for (int i = 0; i < 1000; ++i) {
+        uint32_t tPC;
+        if (i % 10 < 5) {
+            tPC = (uint32_t) (uintptr_t) &workA;
+        } else if (i % 10 < 8) {
+            tPC = (uint32_t) (uintptr_t) &workB;
+        } else {
+            tPC = (uint32_t) (uintptr_t) &workC;
+        }
+        recordProfilerSample(tPC + (i % 2) * 2);
+    }
+    addProfilerIdleSamples(0);
+    stopProfiler();
+    sDumpFile = NULL;
+    if (argc > 1) {
+        sDumpFile = fopen(argv[1], "w");
+        if (sDumpFile == NULL) {
+            perror(argv[1]);
+            return 1;
+        }
+    }
+    sDumpedSamples = 0;
+    dumpProfiler(&countDump);
+    if (sDumpFile != NULL) {
+        fclose(sDumpFile);
+        printf("profile of workA(), workB() and workC() written to %s\n", argv[1]);
+    }
+    check(sDumpedSamples == 1000, "known functions not completely dumped");
+
+    printf("all checks %s\n", sAllChecksPassed ? "passed" : "FAILED");
+    return sAllChecksPassed ? 0 : 1;
+}
+
+#endif // HOST_SIMULATION
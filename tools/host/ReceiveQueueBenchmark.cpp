@@ -0,0 +1,237 @@
+/**
+ * @file ReceiveQueueBenchmark.cpp
+ *
+ * Host benchmark for the block receive parser and the event queue of BlueSerial.cpp.
+ * The remote side is a byte stream of numbered touch move events, which is fed into the receive buffer
+ * like the circular RX DMA does. The event number is coded in the touch position, so lost events are detected.
+ *
+ * 1. Parser throughput: Host CPU time per event for the block parser compared with the previous byte by byte parser,
+ *    which is included below as reference. Every 1000th event is corrupted to check resynchronization.
+ * 2. Busy main loop: The main loop computes for 20 ms and then sends a 1000 byte data buffer at 115200 baud,
+ *    which blocks for about 70 ms, while the remote side sends touch moves with different rates.
+ *    Prints events delivered and lost, queue overflows and the maximum queue length.
+ *
+ * Build on x86 Linux from project root with: make -C tools/host build/ReceiveQueueBenchmark
+ * and run it with: tools/host/build/ReceiveQueueBenchmark
+ *
+ * Only compiled if HOST_SIMULATION is defined.
+ *
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ */
+
+#ifdef HOST_SIMULATION
+
+#include "BlueDisplay.h"
+#include "EventHandler.h"
+#include "HostSupport.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#define NUMBER_OF_THROUGHPUT_EVENTS 200000
+#define CORRUPTED_EVENT_INTERVAL 1000
+#define FEED_CHUNK_SIZE 128 // less than USART_RECEIVE_BUFFER_SIZE, so the receive buffer never overruns
+#define TOUCH_MESSAGE_SIZE 8 // length, event type, 5 byte TouchEvent and sync token
+
+#define NUMBER_OF_LOOPS 200
+#define CPU_NANOS_PER_LOOP 20000000
+#define DATA_BUFFER_SIZE 1000
+
+const unsigned int REMOTE_DISPLAY_HEIGHT = 240;
+const unsigned int REMOTE_DISPLAY_WIDTH = 320;
+
+extern bool sReceiveBufferOutOfSync;
+extern uint8_t getReceiveBufferByte(void);
+
+/*
+ * Local side
+ */
+static uint32_t sExpectedEventNumber;
+static uint32_t sEventsDelivered;
+static uint32_t sEventsLost;
+
+static void checkTouchMove(struct TouchEvent * aTouchEvent) {
+    uint32_t tEventNumber = aTouchEvent->TouchPosition.PosX | (aTouchEvent->TouchPosition.PosY << 16);
+    if (tEventNumber > sExpectedEventNumber) {
+        sEventsLost += tEventNumber - sExpectedEventNumber;
+    }
+    sExpectedEventNumber = tEventNumber + 1;
+    sEventsDelivered++;
+}
+
+/*
+ * Previous implementation, which reads one byte at a time and handles at most one event per call
+ */
+static uint8_t sReceivedEventType = EVENT_NO_EVENT;
+static uint8_t sReceivedDataSize;
+
+static void checkAndHandleMessageReceivedBytewise(void) {
+    int32_t tBytesAvailable = getReceiveBytesAvailable();
+    if (tBytesAvailable == 0) {
+        return;
+    }
+    if (sReceiveBufferOutOfSync) {
+        while (tBytesAvailable-- > 0) {
+            if (getReceiveBufferByte() == SYNC_TOKEN) {
+                sReceiveBufferOutOfSync = false;
+                sReceivedEventType = EVENT_NO_EVENT;
+                break;
+            }
+        }
+    }
+    if (!sReceiveBufferOutOfSync) {
+        if (sReceivedEventType == EVENT_NO_EVENT) {
+            if (tBytesAvailable >= 2) {
+                sReceivedDataSize = getReceiveBufferByte() - 3;
+                if (sReceivedDataSize > RECEIVE_MAX_DATA_SIZE) {
+                    sReceiveBufferOutOfSync = true;
+                    return;
+                }
+                sReceivedEventType = getReceiveBufferByte();
+                tBytesAvailable -= 2;
+            }
+        }
+        if (sReceivedEventType != EVENT_NO_EVENT) {
+            if (tBytesAvailable > sReceivedDataSize) {
+                unsigned char * tByteArrayPtr = remoteEvent.EventData.ByteArray;
+                for (int i = 0; i < sReceivedDataSize; ++i) {
+                    *tByteArrayPtr++ = getReceiveBufferByte();
+                }
+                if (getReceiveBufferByte() == SYNC_TOKEN) {
+                    remoteEvent.EventType = sReceivedEventType;
+                    sReceivedEventType = EVENT_NO_EVENT;
+                    handleEvent(&remoteEvent);
+                } else {
+                    sReceiveBufferOutOfSync = true;
+                }
+            }
+        }
+    }
+}
+
+/*
+ * Remote side
+ */
+static void putTouchMoveMessage(uint8_t * aMessage, uint32_t aEventNumber) {
+    aMessage[0] = TOUCH_MESSAGE_SIZE;
+    aMessage[1] = EVENT_TOUCH_ACTION_MOVE;
+    aMessage[2] = aEventNumber;
+    aMessage[3] = aEventNumber >> 8;
+    aMessage[4] = aEventNumber >> 16;
+    aMessage[5] = aEventNumber >> 24;
+    aMessage[6] = 0; // pointer index
+    aMessage[7] = SYNC_TOKEN;
+}
+
+static void resetReceiver(void) {
+    UART_BD_initialize(BAUD_115200);
+    hostResetLinkCounters();
+    resetReceiveStatistics();
+    // empty event queue
+    checkAndHandleMessageReceived();
+    sReceiveBufferOutOfSync = false;
+    sReceivedEventType = EVENT_NO_EVENT;
+    sExpectedEventNumber = 0;
+    sEventsDelivered = 0;
+    sEventsLost = 0;
+}
+
+static void runThroughputBenchmark(bool aUseBlockParser) {
+    std::vector<uint8_t> tStream(NUMBER_OF_THROUGHPUT_EVENTS * TOUCH_MESSAGE_SIZE);
+    for (uint32_t i = 0; i < NUMBER_OF_THROUGHPUT_EVENTS; ++i) {
+        putTouchMoveMessage(&tStream[i * TOUCH_MESSAGE_SIZE], i);
+        if (i % CORRUPTED_EVENT_INTERVAL == CORRUPTED_EVENT_INTERVAL - 1) {
+            tStream[i * TOUCH_MESSAGE_SIZE + 7] = 0; // sync token missing
+        }
+    }
+    resetReceiver();
+
+    uint64_t tParserNanos = 0;
+    for (size_t tPosition = 0; tPosition < tStream.size(); tPosition += FEED_CHUNK_SIZE) {
+        size_t tLength = tStream.size() - tPosition;
+        if (tLength > FEED_CHUNK_SIZE) {
+            tLength = FEED_CHUNK_SIZE;
+        }
+        hostReceiveBytes(&tStream[tPosition], tLength);
+        uint64_t tStart = getHostNanos();
+        if (aUseBlockParser) {
+            checkAndHandleMessageReceived();
+        } else {
+            // the main loop calls it until all available events are handled
+            while (getReceiveBytesAvailable() >= TOUCH_MESSAGE_SIZE) {
+                checkAndHandleMessageReceivedBytewise();
+            }
+        }
+        tParserNanos += getHostNanos() - tStart;
+    }
+
+    printf("%-9s parser: %5.1f ns/event %6.1f MByte/s, %u events delivered, %u lost (%u corrupted)\n",
+            aUseBlockParser ? "block" : "bytewise", (double) tParserNanos / NUMBER_OF_THROUGHPUT_EVENTS,
+            tStream.size() * 1e3 / tParserNanos, sEventsDelivered, sEventsLost,
+            NUMBER_OF_THROUGHPUT_EVENTS / CORRUPTED_EVENT_INTERVAL);
+}
+
+/*
+ * Busy main loop
+ */
+static uint64_t sEventIntervalNanos;
+static uint64_t sNextEventNanos;
+static uint32_t sNextEventNumber;
+
+/**
+ * Puts all events, which the remote side has sent up to the actual link time, into the receive buffer
+ */
+static void feedEventsUntilLinkTime(void) {
+    while (sNextEventNanos <= HostLinkNanos) {
+        uint8_t tMessage[TOUCH_MESSAGE_SIZE];
+        putTouchMoveMessage(tMessage, sNextEventNumber++);
+        hostReceiveBytes(tMessage, TOUCH_MESSAGE_SIZE);
+        sNextEventNanos += sEventIntervalNanos;
+    }
+}
+
+static void runBusyLoopBenchmark(uint32_t aEventsPerSecond) {
+    static uint8_t tDataBuffer[DATA_BUFFER_SIZE];
+    resetReceiver();
+    sEventIntervalNanos = 1000000000ULL / aEventsPerSecond;
+    sNextEventNanos = sEventIntervalNanos;
+    sNextEventNumber = 0;
+    HostLinkReadCallback = &feedEventsUntilLinkTime;
+
+    for (int i = 0; i < NUMBER_OF_LOOPS; ++i) {
+        hostAdvanceLinkTime(CPU_NANOS_PER_LOOP);
+        checkAndHandleEvents();
+        sendUSARTArgsAndByteBuffer(FUNCTION_DRAW_STRING, 5, 0, 0, 11, COLOR_BLACK, COLOR_WHITE, DATA_BUFFER_SIZE,
+                tDataBuffer);
+    }
+    hostFlushLink();
+    checkAndHandleEvents();
+    HostLinkReadCallback = NULL;
+
+    printf("%4u events/s: %5u sent %5u delivered %4u lost, queue overflows %4u max length %2u, sync errors %u\n",
+            aEventsPerSecond, sNextEventNumber, sEventsDelivered, sNextEventNumber - sEventsDelivered,
+            ReceiveStatistics.Overflows, ReceiveStatistics.MaxQueueLength, ReceiveStatistics.SyncErrors);
+}
+
+int main(void) {
+    HostBluetoothPaired = true;
+    // every event is checked for its number
+    setMoveEventCoalescingEnabled(false);
+    registerTouchMoveCallback(&checkTouchMove);
+
+    printf("%d touch move events fed in %d byte chunks, host CPU time of parser and handleEvent()\n",
+    NUMBER_OF_THROUGHPUT_EVENTS, FEED_CHUNK_SIZE);
+    runThroughputBenchmark(false);
+    runThroughputBenchmark(true);
+
+    printf("\n%d main loops of %d ms CPU time and a %d byte command at 115200 baud, receive buffer %d bytes, event queue %d\n",
+    NUMBER_OF_LOOPS, CPU_NANOS_PER_LOOP / 1000000, DATA_BUFFER_SIZE, USART_RECEIVE_BUFFER_SIZE, RECEIVE_EVENT_QUEUE_SIZE - 1);
+    uint32_t tEventRates[] = { 60, 120, 250 };
+    for (unsigned int i = 0; i < sizeof(tEventRates) / sizeof(tEventRates[0]); ++i) {
+        runBusyLoopBenchmark(tEventRates[i]);
+    }
+    return 0;
+}
+
+#endif // HOST_SIMULATION
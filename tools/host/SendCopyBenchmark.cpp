@@ -0,0 +1,90 @@
+/**
+ * @file SendCopyBenchmark.cpp
+ *
+ * Host benchmark for sendUSARTBufferNoCopy() compared with sendUSARTBufferNoSizeCheck(), which copies the data to the send buffer.
+ * Sends commands with 32, 320 and 1000 byte payloads over a fast simulated link, so that the sender never has to wait,
+ * and measures the CPU time of the send calls per transmitted kilobyte and the number of DMA transfers per kilobyte.
+ * The received byte stream is compared with the sent data.
+ *
+ * Build on x86 Linux from project root with: make -C tools/host build/SendCopyBenchmark
+ * and run it with: tools/host/build/SendCopyBenchmark
+ *
+ * Only compiled if HOST_SIMULATION is defined.
+ *
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ */
+
+#ifdef HOST_SIMULATION
+
+#include "BlueDisplay.h"
+#include "HostSupport.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#define NUMBER_OF_COMMANDS 20000
+#define LINK_BAUD_RATE 100000000 // no waiting for the link
+#define NUMBER_OF_PAYLOAD_BUFFERS USART_NO_COPY_QUEUE_SIZE // buffer is not reused before its transfer is complete
+#define MAX_PAYLOAD_LENGTH 1000
+
+const unsigned int REMOTE_DISPLAY_HEIGHT = 240;
+const unsigned int REMOTE_DISPLAY_WIDTH = 320;
+
+static std::vector<uint8_t> sLinkData;
+static std::vector<uint8_t> sExpectedData;
+static uint8_t sPayloadBuffers[NUMBER_OF_PAYLOAD_BUFFERS][MAX_PAYLOAD_LENGTH];
+
+static void captureLinkData(const uint8_t * aData, size_t aLength) {
+    sLinkData.insert(sLinkData.end(), aData, aData + aLength);
+}
+
+static void runBenchmark(size_t aPayloadLength, bool aUseNoCopy) {
+    UART_BD_initialize(LINK_BAUD_RATE);
+    hostResetLinkCounters();
+    sLinkData.clear();
+    sExpectedData.clear();
+    uint64_t tSendNanos = 0;
+
+    for (int i = 0; i < NUMBER_OF_COMMANDS; ++i) {
+        uint8_t * tPayload = sPayloadBuffers[i % NUMBER_OF_PAYLOAD_BUFFERS];
+        for (size_t j = 0; j < aPayloadLength; ++j) {
+            tPayload[j] = i + j;
+        }
+        uint16_t tHeader[9] = { FUNCTION_DRAW_STRING << 8 | SYNC_TOKEN, 10, (uint16_t) i, 0, 11, COLOR_BLACK, COLOR_WHITE,
+        DATAFIELD_TAG_BYTE << 8 | SYNC_TOKEN, (uint16_t) aPayloadLength };
+        sExpectedData.insert(sExpectedData.end(), (uint8_t *) tHeader, (uint8_t *) tHeader + sizeof(tHeader));
+        sExpectedData.insert(sExpectedData.end(), tPayload, tPayload + aPayloadLength);
+
+        uint64_t tStart = getHostNanos();
+        if (aUseNoCopy) {
+            sendUSARTBufferNoCopy((uint8_t *) tHeader, sizeof(tHeader), tPayload, aPayloadLength);
+        } else {
+            sendUSARTBuffer((uint8_t *) tHeader, sizeof(tHeader), tPayload, aPayloadLength);
+        }
+        tSendNanos += getHostNanos() - tStart;
+        // time to compute next payload
+        hostAdvanceLinkTime((aPayloadLength + sizeof(tHeader)) * 200);
+    }
+    hostFlushLink();
+    bool tDataOK = (sLinkData == sExpectedData);
+
+    double tKilobytes = HostLinkCounters.Bytes / 1024.0;
+    printf("%4u byte payload %-7s: %6.0f ns/KB %6.1f transfers/KB  received data %s\n", (unsigned int) aPayloadLength,
+            aUseNoCopy ? "no copy" : "copy", tSendNanos / tKilobytes, HostLinkCounters.Transfers / tKilobytes,
+            tDataOK ? "OK" : "CORRUPTED");
+}
+
+int main(void) {
+    HostBluetoothPaired = true;
+    HostLinkWriteCallback = &captureLinkData;
+    printf("%d commands, host CPU time for send calls per transmitted kilobyte\n", NUMBER_OF_COMMANDS);
+    size_t tPayloadLengths[] = { 32, 320, MAX_PAYLOAD_LENGTH };
+    for (unsigned int i = 0; i < sizeof(tPayloadLengths) / sizeof(tPayloadLengths[0]); ++i) {
+        runBenchmark(tPayloadLengths[i], false);
+        runBenchmark(tPayloadLengths[i], true);
+    }
+    return 0;
+}
+
+#endif // HOST_SIMULATION
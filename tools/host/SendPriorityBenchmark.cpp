@@ -0,0 +1,159 @@
+/**
+ * @file SendPriorityBenchmark.cpp
+ *
+ * Host benchmark for the replaceable streams of the BlueDisplay send path.
+ * Simulates a DSO main loop, which sends a 320 byte chart and 3 lines of info text for every acquisition
+ * and a numbered control command (button caption) every 10th acquisition, over a saturated 115200 baud link.
+ * Compares sending all data as blocking control traffic with sending chart and info as replaceable streams.
+ * Prints acquisitions/s, maximum blocking time, superseded and dropped messages
+ * and checks that all control commands arrived in order.
+ *
+ * Build on x86 Linux from project root with: make -C tools/host build/SendPriorityBenchmark
+ * and run it with: tools/host/build/SendPriorityBenchmark
+ *
+ * Only compiled if HOST_SIMULATION is defined.
+ *
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ */
+
+#ifdef HOST_SIMULATION
+
+#include "BlueDisplay.h"
+#include "HostSupport.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#define NUMBER_OF_ACQUISITIONS 500
+#define CONTROL_COMMAND_INTERVAL 10
+// Time for acquisition and computing of display values
+#define CPU_NANOS_PER_ACQUISITION 10000000
+#define CHART_LENGTH 320
+
+const unsigned int REMOTE_DISPLAY_HEIGHT = 240;
+const unsigned int REMOTE_DISPLAY_WIDTH = 320;
+
+extern volatile bool sDMATransferOngoing;
+
+/*
+ * Remote side
+ */
+static std::vector<uint8_t> sLinkData;
+static uint32_t sChartsReceived;
+static uint32_t sControlCommandsReceived;
+static uint32_t sControlCommandsOutOfOrder;
+
+static void captureLinkData(const uint8_t * aData, size_t aLength) {
+    sLinkData.insert(sLinkData.end(), aData, aData + aLength);
+}
+
+static uint16_t getShort(const uint8_t * aPointer) {
+    return aPointer[0] | (aPointer[1] << 8);
+}
+
+static void parseLinkData(void) {
+    size_t tPosition = 0;
+    while (tPosition + 4 <= sLinkData.size()) {
+        const uint8_t * tCommand = &sLinkData[tPosition];
+        uint8_t tFunctionTag = tCommand[1];
+        size_t tCommandLength = 4 + getShort(&tCommand[2]);
+        const uint8_t * tData = tCommand + tCommandLength + 4;
+        uint16_t tDataLength = 0;
+        if (tFunctionTag > INDEX_LAST_FUNCTION_WITHOUT_DATA) {
+            if (tPosition + tCommandLength + 4 > sLinkData.size()) {
+                break;
+            }
+            tDataLength = getShort(tCommand + tCommandLength + 2);
+            tCommandLength += 4 + tDataLength;
+        }
+        if (tPosition + tCommandLength > sLinkData.size()) {
+            break;
+        }
+        if (tFunctionTag == FUNCTION_DRAW_CHART) {
+            sChartsReceived++;
+        } else if (tFunctionTag == FUNCTION_BUTTON_SET_CAPTION && tDataLength > 5 && memcmp(tData, "Ctrl ", 5) == 0) {
+            char tNumber[8] = { 0 };
+            memcpy(tNumber, tData + 5, tDataLength - 5 < 7 ? tDataLength - 5 : 7);
+            if ((uint32_t) atoi(tNumber) != sControlCommandsReceived) {
+                sControlCommandsOutOfOrder++;
+            }
+            sControlCommandsReceived++;
+        }
+        tPosition += tCommandLength;
+    }
+    sLinkData.erase(sLinkData.begin(), sLinkData.begin() + tPosition);
+}
+
+/*
+ * Local side
+ */
+static void sendInfo(int aAcquisitionNumber) {
+    char tStringBuffer[48];
+    for (int i = 0; i < 3; ++i) {
+        snprintf(tStringBuffer, sizeof tStringBuffer, "Av%6.3fV Min%6.3f Max%6.3f P2P%6.3fV", aAcquisitionNumber * 0.001,
+                0.1 * i, 3.2, 3.1);
+        BlueDisplay1.drawText(0, 11 + i * 11, tStringBuffer, 11, COLOR_BLACK, COLOR_WHITE);
+    }
+}
+
+static void runBenchmark(bool aUseStreams) {
+    uint8_t tChart[CHART_LENGTH];
+    char tCaption[16];
+    UART_BD_initialize(BAUD_115200);
+    hostResetLinkCounters();
+    resetSendStatistics();
+    sLinkData.clear();
+    sChartsReceived = 0;
+    sControlCommandsReceived = 0;
+    sControlCommandsOutOfOrder = 0;
+    uint32_t tControlCommandsSent = 0;
+
+    for (int i = 0; i < NUMBER_OF_ACQUISITIONS; ++i) {
+        hostAdvanceLinkTime(CPU_NANOS_PER_ACQUISITION);
+        for (int j = 0; j < CHART_LENGTH; ++j) {
+            tChart[j] = (i + j) & 0x7F;
+        }
+        if (aUseStreams) {
+            BlueDisplay1.drawChartByteBuffer(0, 0, COLOR_BLUE, COLOR_WHITE, 0, true, tChart, CHART_LENGTH);
+            BlueDisplay1.startReplaceableStream(SEND_STREAM_INFO);
+            sendInfo(i);
+            BlueDisplay1.endReplaceableStream();
+        } else {
+            sendUSARTArgsAndByteBuffer(FUNCTION_DRAW_CHART, 4, 0, 0, COLOR_BLUE, COLOR_WHITE, CHART_LENGTH, tChart);
+            sendInfo(i);
+        }
+        if (i % CONTROL_COMMAND_INTERVAL == 0) {
+            snprintf(tCaption, sizeof tCaption, "Ctrl %u", tControlCommandsSent++);
+            sendUSARTArgsAndByteBuffer(FUNCTION_BUTTON_SET_CAPTION, 1, 0, strlen(tCaption), tCaption);
+        }
+        // like checkAndHandleEvents()
+        flushSendStreams();
+        parseLinkData();
+    }
+    uint64_t tLoopNanos = HostLinkNanos;
+    // send remaining data
+    while (sDMATransferOngoing || isSendStreamPending(SEND_STREAM_CHART_0) || isSendStreamPending(SEND_STREAM_INFO)) {
+        hostFlushLink();
+        flushSendStreams();
+    }
+    parseLinkData();
+
+    printf("%-9s: %5.1f acquisitions/s %4u/%u charts sent, max blocking %3u ms, timeouts %u, superseded %4u, dropped %u, control %u/%u received %u out of order\n",
+            aUseStreams ? "streams" : "blocking", NUMBER_OF_ACQUISITIONS / (tLoopNanos / 1e9), sChartsReceived,
+            NUMBER_OF_ACQUISITIONS, SendStatistics.MaxBlockingMillis, SendStatistics.Timeouts, SendStatistics.Superseded, SendStatistics.Dropped,
+            sControlCommandsReceived, tControlCommandsSent, sControlCommandsOutOfOrder);
+}
+
+int main(void) {
+    HostBluetoothPaired = true;
+    HostLinkWriteCallback = &captureLinkData;
+    printf("%d acquisitions with %d ms CPU time each, chart + 3 info lines each at 115200 baud\n", NUMBER_OF_ACQUISITIONS,
+            CPU_NANOS_PER_ACQUISITION / 1000000);
+    runBenchmark(false);
+    runBenchmark(true);
+    return 0;
+}
+
+#endif // HOST_SIMULATION
@@ -0,0 +1,268 @@
+/**
+ * @file StringTableBenchmark.cpp
+ *
+ * Host benchmark for the registered strings of BlueDisplay.cpp.
+ * Redraws the DSO chart page in analyze mode and the DSO settings page like redrawDisplay() and startDSOSettingsPage()
+ * with the constant texts, grid labels and button captions, a 320 byte chart and a dynamic info line.
+ * Prints the bytes sent for the first redraw, which includes the registration of the strings,
+ * and for each following redraw, with and without string registration.
+ *
+ * The captured link data is decoded like the remote side does and the sequence of drawn texts and captions
+ * is compared with the sequence of the run without registration.
+ *
+ * Build on x86 Linux from project root with: make -C tools/host build/StringTableBenchmark
+ * and run it with: tools/host/build/StringTableBenchmark
+ *
+ * Only compiled if HOST_SIMULATION is defined.
+ *
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ */
+
+#ifdef HOST_SIMULATION
+
+#include "BlueDisplay.h"
+#include "StringTable.h"
+#include "HostSupport.h"
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#define NUMBER_OF_REDRAWS 10
+#define CHART_LENGTH 320
+#define NUMBER_OF_HORIZONTAL_GRID_LINES 6
+#define NUMBER_OF_VERTICAL_GRID_LINES 10
+#define NUMBER_OF_CHANNEL_BUTTONS 3
+
+const unsigned int REMOTE_DISPLAY_HEIGHT = 240;
+const unsigned int REMOTE_DISPLAY_WIDTH = 320;
+
+/*
+ * Texts and captions of TouchDSOGui.cpp
+ */
+static const char * const sGridLabels[] = { "0.0", "0.5", "1.0", "1.5", "2.0", "2.5" };
+static const char * const sChannelStrings[] = { "Ch. 0", "Ch. 1", "Ch. 2" };
+static const char * const sHistoryStrings[] = { "History\n off", "History\n low" };
+
+static BDButton sButtonsChartPage[6];
+static BDButton sButtonsSettingsPage[11];
+static BDButton sButtonChartHistory;
+static BDButton sButtonMinMaxMode;
+static BDButton sButtonACRange;
+static BDButton sButtonChannels[NUMBER_OF_CHANNEL_BUTTONS];
+
+/*
+ * Remote side
+ */
+static std::vector<uint8_t> sLinkData;
+static struct StringTable sRemoteStringTable;
+static std::vector<std::string> sDrawnStrings; // texts and captions in the order they are drawn
+static uint32_t sDecodeErrors;
+static double sBytesPerFollowingRedraw[2]; // chart and settings page, index is aRegisterStrings
+
+static void captureLinkData(const uint8_t * aData, size_t aLength) {
+    sLinkData.insert(sLinkData.end(), aData, aData + aLength);
+}
+
+static uint16_t getShort(const uint8_t * aPointer) {
+    return aPointer[0] | (aPointer[1] << 8);
+}
+
+static void addDrawnString(char aKind, uint16_t aButtonHandle, const char * aString, size_t aLength) {
+    if (aString == NULL) {
+        sDecodeErrors++;
+        return;
+    }
+    std::string tEntry(1, aKind);
+    tEntry += (char) aButtonHandle;
+    tEntry.append(aString, aLength);
+    sDrawnStrings.push_back(tEntry);
+}
+
+/**
+ * Decodes all complete commands in sLinkData and records the drawn texts and captions
+ */
+static void decodeLinkData(void) {
+    size_t tPosition = 0;
+    while (tPosition + 4 <= sLinkData.size()) {
+        const uint8_t * tCommand = &sLinkData[tPosition];
+        if (tCommand[0] != SYNC_TOKEN) {
+            sDecodeErrors++;
+            tPosition++;
+            continue;
+        }
+        uint8_t tFunctionTag = tCommand[1];
+        uint16_t tParameterLength = getShort(&tCommand[2]);
+        size_t tCommandLength = 4 + tParameterLength;
+        const char * tData = NULL;
+        uint16_t tDataLength = 0;
+        if (tFunctionTag > INDEX_LAST_FUNCTION_WITHOUT_DATA) {
+            tData = (const char *) (tCommand + tCommandLength + 4);
+            tDataLength = getShort(tCommand + tCommandLength + 2);
+            tCommandLength += 4 + tDataLength;
+        }
+        if (tPosition + tCommandLength > sLinkData.size()) {
+            break;
+        }
+        const uint8_t * tParameter = &tCommand[4];
+        size_t tLength = 0;
+        const char * tString;
+        switch (tFunctionTag) {
+        case FUNCTION_REGISTER_STRING:
+            if (!setStringTableEntry(&sRemoteStringTable, getShort(&tParameter[0]), tData, tDataLength)) {
+                sDecodeErrors++;
+            }
+            break;
+        case FUNCTION_DRAW_STRING:
+            addDrawnString('T', 0, tData, tDataLength);
+            break;
+        case FUNCTION_DRAW_REGISTERED_STRING:
+            tString = getStringTableEntry(&sRemoteStringTable, getShort(&tParameter[10]), &tLength);
+            addDrawnString('T', 0, tString, tLength);
+            break;
+        case FUNCTION_BUTTON_SET_CAPTION:
+        case FUNCTION_BUTTON_SET_CAPTION_AND_DRAW_BUTTON:
+            addDrawnString('C', getShort(&tParameter[0]), tData, tDataLength);
+            break;
+        case FUNCTION_BUTTON_SET_REGISTERED_CAPTION:
+        case FUNCTION_BUTTON_SET_REGISTERED_CAPTION_AND_DRAW_BUTTON:
+            tString = getStringTableEntry(&sRemoteStringTable, getShort(&tParameter[2]), &tLength);
+            addDrawnString('C', getShort(&tParameter[0]), tString, tLength);
+            break;
+        default:
+            break;
+        }
+        tPosition += tCommandLength;
+    }
+    sLinkData.erase(sLinkData.begin(), sLinkData.begin() + tPosition);
+}
+
+/*
+ * Local side
+ */
+static void initButtons(void) {
+    for (unsigned int i = 0; i < sizeof(sButtonsChartPage) / sizeof(sButtonsChartPage[0]); ++i) {
+        sButtonsChartPage[i].init(0, i * 40, 80, 36, COLOR_GREEN, "Chart", TEXT_SIZE_11, 0, 0, NULL);
+    }
+    for (unsigned int i = 0; i < sizeof(sButtonsSettingsPage) / sizeof(sButtonsSettingsPage[0]); ++i) {
+        sButtonsSettingsPage[i].init((i % 3) * 110, (i / 3) * 48, 100, 44, COLOR_RED, "Setting", TEXT_SIZE_11, 0, 0, NULL);
+    }
+    sButtonChartHistory.init(0, 192, 100, 44, COLOR_RED, sHistoryStrings[0], TEXT_SIZE_11, 0, 0, NULL);
+    sButtonMinMaxMode.init(110, 192, 100, 44, COLOR_RED, "Min/Max\nmode", TEXT_SIZE_11, 0, 0, NULL);
+    sButtonACRange.init(220, 192, 100, 44, COLOR_RED, "DC", TEXT_SIZE_11, 0, 0, NULL);
+    for (int i = 0; i < NUMBER_OF_CHANNEL_BUTTONS; ++i) {
+        sButtonChannels[i].init(i * 70, 144, 64, 44, COLOR_RED, sChannelStrings[i], TEXT_SIZE_11, 0, 0, NULL);
+    }
+}
+
+/**
+ * Like redrawDisplay() for the chart page in analyze mode
+ */
+static void drawChartPage(int aRedrawNumber) {
+    static uint8_t tChart[CHART_LENGTH];
+    BlueDisplay1.clearDisplay(COLOR_WHITE);
+    for (unsigned int i = 0; i < sizeof(sButtonsChartPage) / sizeof(sButtonsChartPage[0]); ++i) {
+        sButtonsChartPage[i].drawButton();
+    }
+    BlueDisplay1.drawRegisteredText(110, 130, "\xABScale\xBB", TEXT_SIZE_22, COLOR_YELLOW, COLOR_WHITE);
+    BlueDisplay1.drawRegisteredText(110, 200, "\xABScroll\xBB", TEXT_SIZE_22, COLOR_GREEN, COLOR_WHITE);
+    BlueDisplay1.drawRegisteredText(40, 220, "\xABTimeBase\xBB", TEXT_SIZE_22, COLOR_BLUE, COLOR_WHITE);
+
+    // like drawGridLinesWithHorizLabelsAndTriggerLine()
+    for (int i = 1; i <= NUMBER_OF_VERTICAL_GRID_LINES; ++i) {
+        BlueDisplay1.drawLine(i * 31, 0, i * 31, REMOTE_DISPLAY_HEIGHT - 1, COLOR_BLACK);
+    }
+    for (int i = 0; i < NUMBER_OF_HORIZONTAL_GRID_LINES; ++i) {
+        uint16_t tYPos = REMOTE_DISPLAY_HEIGHT - 1 - i * 40;
+        BlueDisplay1.drawLine(0, tYPos, REMOTE_DISPLAY_WIDTH - 1, tYPos, COLOR_BLACK);
+        BlueDisplay1.drawRegisteredText(REMOTE_DISPLAY_WIDTH - 3 * TEXT_SIZE_11_WIDTH, tYPos, sGridLabels[i], TEXT_SIZE_11,
+                COLOR_BLUE, COLOR_WHITE);
+    }
+
+    for (int i = 0; i < CHART_LENGTH; ++i) {
+        tChart[i] = (i + aRedrawNumber * 7) & 0x7F;
+    }
+    BlueDisplay1.drawChartByteBuffer(0, 0, COLOR_BLUE, COLOR_WHITE, 0, true, tChart, CHART_LENGTH);
+
+    // like printInfo() the info line changes with every redraw
+    char tInfoLine[48];
+    snprintf(tInfoLine, sizeof(tInfoLine), "%2d.%02dms Ch. 0 Min=0.%02dV Max=2.%02dV", aRedrawNumber, aRedrawNumber * 3,
+            aRedrawNumber, aRedrawNumber * 5);
+    BlueDisplay1.drawText(0, TEXT_SIZE_11_ASCEND, tInfoLine, TEXT_SIZE_11, COLOR_BLACK, COLOR_WHITE);
+}
+
+/**
+ * Like setButtonCaptions(), setChannelButtonsCaption() and drawDSOSettingsPageGui()
+ */
+static void drawSettingsPage(int aRedrawNumber) {
+    BlueDisplay1.clearDisplay(COLOR_WHITE);
+    sButtonChartHistory.setCaption(sHistoryStrings[aRedrawNumber & 1]);
+    sButtonMinMaxMode.setCaption((aRedrawNumber & 1) ? "Sample\nmode" : "Min/Max\nmode");
+    sButtonACRange.setCaption((aRedrawNumber & 1) ? "AC" : "DC");
+    for (int i = 0; i < NUMBER_OF_CHANNEL_BUTTONS; ++i) {
+        sButtonChannels[i].setCaption(sChannelStrings[i], true);
+    }
+    for (unsigned int i = 0; i < sizeof(sButtonsSettingsPage) / sizeof(sButtonsSettingsPage[0]); ++i) {
+        sButtonsSettingsPage[i].drawButton();
+    }
+    sButtonChartHistory.drawButton();
+    sButtonMinMaxMode.drawButton();
+    sButtonACRange.drawButton();
+}
+
+static std::vector<std::string> runBenchmark(bool aRegisterStrings) {
+    UART_BD_initialize(BAUD_115200);
+    BlueDisplay1.setStringRegistration(aRegisterStrings);
+    clearStringTable(&sRemoteStringTable);
+    sDecodeErrors = 0;
+    sDrawnStrings.clear();
+
+    uint32_t tFirstChartPageBytes = 0, tFirstSettingsPageBytes = 0;
+    uint32_t tChartPageBytes = 0, tSettingsPageBytes = 0;
+    for (int i = 0; i < NUMBER_OF_REDRAWS; ++i) {
+        hostResetLinkCounters();
+        drawChartPage(i);
+        hostFlushLink();
+        uint32_t tBytes = HostLinkCounters.Bytes;
+        hostResetLinkCounters();
+        drawSettingsPage(i);
+        hostFlushLink();
+        decodeLinkData();
+        if (i == 0) {
+            tFirstChartPageBytes = tBytes;
+            tFirstSettingsPageBytes = HostLinkCounters.Bytes;
+        } else {
+            tChartPageBytes += tBytes;
+            tSettingsPageBytes += HostLinkCounters.Bytes;
+        }
+    }
+
+    printf("%-10s: chart page %5u bytes first, %6.1f bytes following, settings page %4u bytes first, %6.1f bytes following"
+            " (%u strings drawn, %u errors)\n", aRegisterStrings ? "registered" : "inline", tFirstChartPageBytes,
+            (double) tChartPageBytes / (NUMBER_OF_REDRAWS - 1), tFirstSettingsPageBytes,
+            (double) tSettingsPageBytes / (NUMBER_OF_REDRAWS - 1), (unsigned int) sDrawnStrings.size(), sDecodeErrors);
+    sBytesPerFollowingRedraw[aRegisterStrings] = (double) (tChartPageBytes + tSettingsPageBytes) / (NUMBER_OF_REDRAWS - 1);
+    return sDrawnStrings;
+}
+
+int main(void) {
+    HostBluetoothPaired = true;
+    HostLinkWriteCallback = &captureLinkData;
+    UART_BD_initialize(BAUD_115200);
+    // both variants must send all captions of each redraw
+    BlueDisplay1.setGUIStateCaching(false);
+    initButtons();
+    hostFlushLink();
+    sLinkData.clear();
+
+    printf("%d redraws of the DSO chart and settings page at 115200 baud, string table of %d entries\n", NUMBER_OF_REDRAWS,
+    STRING_TABLE_SIZE);
+    std::vector<std::string> tInlineStrings = runBenchmark(false);
+    std::vector<std::string> tRegisteredStrings = runBenchmark(true);
+    printf("Bytes saved per following redraw of both pages: %.1f (%.1f%%)\n", sBytesPerFollowingRedraw[0] - sBytesPerFollowingRedraw[1],
+            (sBytesPerFollowingRedraw[0] - sBytesPerFollowingRedraw[1]) * 100 / sBytesPerFollowingRedraw[0]);
+    printf("Decoded texts and captions %s\n", tInlineStrings == tRegisteredStrings ? "are identical" : "DIFFER");
+    return 0;
+}
+
+#endif // HOST_SIMULATION
@@ -0,0 +1,242 @@
+/**
+ * @file TicklessIdleBenchmark.cpp
+ *
+ * Host simulation of an event driven main loop with and without tickless idle.
+ * The main loop is like loopAccuCapacity(), it calls checkAndHandleEventsAndIdle() and handles a flag,
+ * which is set every second by a delay callback. The remote app sends taps at 115200 baud at random times.
+ *
+ * The systic is simulated by a timer wheel like the one of timing.cpp, which is ticked at each millisecond of the link time.
+ * The sleep of idleMillis() is simulated by HostIdleCallback. It advances the link time until the next timer wheel deadline
+ * or until the UART idle line interrupt after the next received message, whichever comes first.
+ * Without HostIdleCallback the main loop runs busy, like before, with MAIN_LOOP_NANOS for each loop.
+ *
+ * Prints the percentage of time sleeping, the number of wake ups and suppressed systics,
+ * the latency from end of a received message until its touch callback and from setting the flag until it is handled.
+ *
+ * Build on x86 Linux from project root with: make -C tools/host build/TicklessIdleBenchmark
+ * and run it with: tools/host/build/TicklessIdleBenchmark
+ *
+ * Only compiled if HOST_SIMULATION is defined.
+ *
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ */
+
+#ifdef HOST_SIMULATION
+
+#include "BlueDisplay.h"
+#include "EventHandler.h"
+#include "HostSupport.h"
+#include "TimerWheel.h"
+#include "timing.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#ifndef USE_TICKLESS_IDLE
+#error "TicklessIdleBenchmark must be compiled with -DUSE_TICKLESS_IDLE"
+#endif
+
+#define NANOS_PER_SYSTIC 1000000
+#define SIMULATION_MILLIS 60000
+#define FLAG_PERIOD_MILLIS 1000
+#define MAIN_LOOP_NANOS 5000 // checkAndHandleEvents() and the loop body without work
+#define WAKE_UP_NANOS 3000 // restart of SysTick and catch up of the suppressed systics
+#define TOUCH_MESSAGE_SIZE 8 // length, event type, 5 byte TouchEvent and sync token
+#define CHARACTER_NANOS (10 * 1000000000ULL / 115200)
+#define MESSAGE_NANOS (TOUCH_MESSAGE_SIZE * CHARACTER_NANOS)
+#define TAP_DURATION_MILLIS 80
+#define MAX_MESSAGES 512
+
+const unsigned int REMOTE_DISPLAY_HEIGHT = 240;
+const unsigned int REMOTE_DISPLAY_WIDTH = 320;
+
+/*
+ * Remote side
+ */
+struct Message {
+    uint64_t CompleteNanos; // last byte received
+    uint8_t EventType;
+};
+
+static struct Message sMessages[MAX_MESSAGES];
+static int sNumberOfMessages;
+static int sNextMessageIndex; // next message to be received
+static int sNumberOfHandledMessages;
+
+/*
+ * Taps with pseudo random gaps of 100 to 900 ms
+ */
+static void createMessages(void) {
+    uint32_t tRandom = 12345;
+    uint64_t tStartNanos = 500 * 1000000ULL;
+    sNumberOfMessages = 0;
+    while (sNumberOfMessages < MAX_MESSAGES - 1 && tStartNanos < (SIMULATION_MILLIS - 1000) * 1000000ULL) {
+        sMessages[sNumberOfMessages].CompleteNanos = tStartNanos + MESSAGE_NANOS;
+        sMessages[sNumberOfMessages].EventType = EVENT_TOUCH_ACTION_DOWN;
+        sNumberOfMessages++;
+        sMessages[sNumberOfMessages].CompleteNanos = tStartNanos + TAP_DURATION_MILLIS * 1000000ULL + MESSAGE_NANOS;
+        sMessages[sNumberOfMessages].EventType = EVENT_TOUCH_ACTION_UP;
+        sNumberOfMessages++;
+        tRandom = tRandom * 1103515245 + 12345;
+        // odd number of nanos to get all positions relative to systic
+        tStartNanos += (100 + (tRandom >> 16) % 800) * 1000000ULL + 123457;
+    }
+}
+
+static void feedMessagesUntilLinkTime(void) {
+    while (sNextMessageIndex < sNumberOfMessages && sMessages[sNextMessageIndex].CompleteNanos <= HostLinkNanos) {
+        uint8_t tMessage[TOUCH_MESSAGE_SIZE] = { TOUCH_MESSAGE_SIZE, sMessages[sNextMessageIndex].EventType, 100, 0, 100, 0, 0,
+        SYNC_TOKEN };
+        hostReceiveBytes(tMessage, TOUCH_MESSAGE_SIZE);
+        sNextMessageIndex++;
+    }
+}
+
+/*
+ * Local side
+ */
+struct RunResult {
+    uint64_t SleepNanos;
+    uint32_t WakeUps;
+    uint32_t SuppressedSystics;
+    uint32_t Systics;
+    uint32_t MainLoops;
+    uint64_t SumEventLatencyNanos;
+    uint64_t MaxEventLatencyNanos;
+    uint32_t FlagsHandled;
+    uint64_t MaxFlagLatencyNanos;
+    uint32_t LateFlags; // handled after the next systic
+};
+
+static struct RunResult sResult;
+
+static struct TimerWheelEntry sDelayCallbackEntries[16];
+static struct TimerWheel sDelayCallbackWheel;
+
+static volatile bool sFlag;
+static uint64_t sFlagSetNanos;
+
+static void setFlagCallback(void) {
+    sFlag = true;
+    sFlagSetNanos = HostLinkNanos;
+    addTimerWheelCallback(&sDelayCallbackWheel, &setFlagCallback, FLAG_PERIOD_MILLIS);
+}
+
+/*
+ * Advances the link time and calls the systic for each millisecond passed
+ */
+static void advanceTime(uint64_t aNanos) {
+    uint64_t tEndNanos = HostLinkNanos + aNanos;
+    uint64_t tSysticNanos = (HostLinkNanos / NANOS_PER_SYSTIC + 1) * NANOS_PER_SYSTIC;
+    while (tSysticNanos <= tEndNanos) {
+        hostAdvanceLinkTime(tSysticNanos - HostLinkNanos);
+        doTimerWheelTick(&sDelayCallbackWheel);
+        sResult.Systics++;
+        tSysticNanos += NANOS_PER_SYSTIC;
+    }
+    hostAdvanceLinkTime(tEndNanos - HostLinkNanos);
+}
+
+/*
+ * Sleeps like idleMillis() of timing.cpp until the systic of the next timer wheel deadline or the UART idle line interrupt
+ */
+static uint32_t simulateIdle(uint32_t aMaxMillis) {
+    uint32_t tTicks = getTimerWheelTicksUntilNextExpiry(&sDelayCallbackWheel, aMaxMillis);
+    uint64_t tWakeUpNanos = (HostLinkNanos / NANOS_PER_SYSTIC + tTicks) * NANOS_PER_SYSTIC;
+    if (sNextMessageIndex < sNumberOfMessages) {
+        uint64_t tIdleLineNanos = sMessages[sNextMessageIndex].CompleteNanos + CHARACTER_NANOS;
+        if (tIdleLineNanos < tWakeUpNanos) {
+            tWakeUpNanos = tIdleLineNanos;
+        }
+    }
+    uint32_t tStartSystics = sResult.Systics;
+    sResult.SleepNanos += tWakeUpNanos - HostLinkNanos;
+    sResult.WakeUps++;
+    advanceTime(tWakeUpNanos - HostLinkNanos);
+    uint32_t tSuppressedSystics = sResult.Systics - tStartSystics;
+    sResult.SuppressedSystics += tSuppressedSystics;
+    advanceTime(WAKE_UP_NANOS);
+    return tSuppressedSystics;
+}
+
+static void recordEvent(struct TouchEvent * aActualPositionPtr) {
+    (void) aActualPositionPtr;
+    uint64_t tLatencyNanos = HostLinkNanos - sMessages[sNumberOfHandledMessages].CompleteNanos;
+    sNumberOfHandledMessages++;
+    sResult.SumEventLatencyNanos += tLatencyNanos;
+    if (sResult.MaxEventLatencyNanos < tLatencyNanos) {
+        sResult.MaxEventLatencyNanos = tLatencyNanos;
+    }
+}
+
+static void run(bool aUseTicklessIdle) {
+    memset(&sResult, 0, sizeof(sResult));
+    HostLinkNanos = 0;
+    UART_BD_initialize(BAUD_115200);
+    hostResetLinkCounters();
+    resetReceiveStatistics();
+    sNextMessageIndex = 0;
+    sNumberOfHandledMessages = 0;
+    sFlag = false;
+    initTimerWheel(&sDelayCallbackWheel, sDelayCallbackEntries, 16);
+    addTimerWheelCallback(&sDelayCallbackWheel, &setFlagCallback, FLAG_PERIOD_MILLIS);
+    HostIdleCallback = aUseTicklessIdle ? &simulateIdle : NULL;
+
+    // end between two flags
+    while (HostLinkNanos < (SIMULATION_MILLIS + FLAG_PERIOD_MILLIS / 2) * 1000000ULL) {
+        checkAndHandleEventsAndIdle(ONE_SECOND);
+        if (sFlag) {
+            sFlag = false;
+            uint64_t tLatencyNanos = HostLinkNanos - sFlagSetNanos;
+            sResult.FlagsHandled++;
+            if (sResult.MaxFlagLatencyNanos < tLatencyNanos) {
+                sResult.MaxFlagLatencyNanos = tLatencyNanos;
+            }
+            if (tLatencyNanos >= NANOS_PER_SYSTIC) {
+                sResult.LateFlags++;
+            }
+        }
+        sResult.MainLoops++;
+        advanceTime(MAIN_LOOP_NANOS);
+    }
+}
+
+static bool sAllChecksPassed = true;
+
+static void printAndCheckResult(const char * aName) {
+    uint32_t tMillis = getMillisSinceBoot();
+    printf("%-14s %7.3f%% %8u %8u %9u %7.1f us %7.1f us %5u %7.1f us %4u\n", aName, sResult.SleepNanos * 100.0 / HostLinkNanos,
+            sResult.MainLoops, sResult.WakeUps, sResult.SuppressedSystics,
+            sNumberOfHandledMessages == 0 ? 0.0 : sResult.SumEventLatencyNanos / 1000.0 / sNumberOfHandledMessages,
+            sResult.MaxEventLatencyNanos / 1000.0, sResult.FlagsHandled, sResult.MaxFlagLatencyNanos / 1000.0, sResult.LateFlags);
+    if (sNumberOfHandledMessages != sNumberOfMessages) {
+        printf("%-14s FAILED: %d of %d messages handled\n", aName, sNumberOfHandledMessages, sNumberOfMessages);
+        sAllChecksPassed = false;
+    }
+    if (sResult.Systics != tMillis || sResult.FlagsHandled != tMillis / FLAG_PERIOD_MILLIS || sResult.LateFlags != 0) {
+        printf("%-14s FAILED: %u systics for %u ms, %u flags\n", aName, sResult.Systics, tMillis, sResult.FlagsHandled);
+        sAllChecksPassed = false;
+    }
+}
+
+int main(void) {
+    HostBluetoothPaired = true;
+    HostMillisFollowLinkTime = true;
+    HostLinkReadCallback = &feedMessagesUntilLinkTime;
+    registerTouchDownCallback(&recordEvent);
+    registerTouchUpCallback(&recordEvent);
+    createMessages();
+
+    printf("%d s main loop with %d taps at 115200 baud and a delay callback every %d ms, %d ns per main loop\n",
+            SIMULATION_MILLIS / 1000, sNumberOfMessages / 2, FLAG_PERIOD_MILLIS, MAIN_LOOP_NANOS);
+    printf("%-14s %8s %8s %8s %9s %10s %10s %5s %10s %4s\n", "", "sleep", "loops", "wake ups", "suppr.", "event lat.",
+            "max", "flags", "max lat.", "late");
+    run(false);
+    printAndCheckResult("busy loop");
+    run(true);
+    printAndCheckResult("tickless idle");
+    printf("all checks %s\n", sAllChecksPassed ? "passed" : "FAILED");
+    return sAllChecksPassed ? 0 : 1;
+}
+
+#endif // HOST_SIMULATION
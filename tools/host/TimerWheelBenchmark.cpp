@@ -0,0 +1,222 @@
+/**
+ * @file TimerWheelBenchmark.cpp
+ *
+ * Host benchmark for the delay callbacks of timing.cpp with thousands of timers.
+ * timing.cpp needs the HAL and cannot be compiled on the host, so the old array scan is modelled here
+ * with the code of registerDelayCallback(), changeDelayCallback() and doOneSystic() before the timer wheel.
+ *
+ * Before: each systic decrements all CALLBACK_ENTRIES_SIZE entries and register and change search the array.
+ * After: each systic only visits the expiring timers of TimerWheel.cpp, register and cancel are O(1).
+ *
+ * TIMER_COUNT timers with 16 different callbacks are running. Each callback registers itself again
+ * with a delay of 1 to MAX_DELAY_MILLIS milliseconds, computed from the tick and the callback number.
+ * An additional single callback is changed or cancelled from the main loop every CHANGE_PERIOD_TICKS ticks.
+ * For each variant the ticks and callback numbers of all calls are summed up and compared.
+ *
+ * The cost of one systic is measured with the time stamp counter of the host, i.e. host cycles and not Cortex-M cycles.
+ *
+ * Build on x86 Linux from project root with: make -C tools/host build/TimerWheelBenchmark
+ * and run it with: tools/host/build/TimerWheelBenchmark
+ *
+ * Only compiled if HOST_SIMULATION is defined.
+ *
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ */
+
+#ifdef HOST_SIMULATION
+
+#include "TimerWheel.h"
+#include "HostSupport.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <x86intrin.h> // for __rdtsc
+
+#define NUMBER_OF_ENTRIES 4096 // CALLBACK_ENTRIES_SIZE of both variants
+#define TIMER_COUNT 3000
+#define NUMBER_OF_CALLBACKS 16
+#define MAX_DELAY_MILLIS 5000
+#define NUMBER_OF_TICKS 100000
+#define CHANGE_PERIOD_TICKS 7
+#define CHANGED_CALLBACK_NUMBER NUMBER_OF_CALLBACKS
+
+static uint32_t sTick; // number of actual or next systic
+
+/*
+ * Statistics of the callbacks
+ */
+struct CallStatistics {
+    uint32_t NumberOfCalls;
+    uint64_t Checksum;
+};
+static struct CallStatistics sStatistics;
+
+static void (*sRegisterFunction)(void (*aDelayCallback)(void), int32_t aTimeMillis);
+
+static int32_t getDelayMillis(uint32_t aTick, int aCallbackNumber) {
+    uint32_t tHash = (aTick * 2654435761UL) ^ (aCallbackNumber * 40503UL);
+    tHash ^= tHash >> 13;
+    return 1 + (tHash * 2246822519UL >> 7) % MAX_DELAY_MILLIS;
+}
+
+static void recordCall(int aCallbackNumber) {
+    sStatistics.NumberOfCalls++;
+    sStatistics.Checksum += (sTick * 2654435761ULL) ^ (aCallbackNumber * 0x9E3779B97F4A7C15ULL);
+}
+
+template<int N> static void timerCallback(void) {
+    recordCall(N);
+    sRegisterFunction(&timerCallback<N>, getDelayMillis(sTick, N));
+}
+
+static void changedCallback(void) {
+    recordCall(CHANGED_CALLBACK_NUMBER);
+}
+
+static void (* const sCallbacks[NUMBER_OF_CALLBACKS])(void) = { &timerCallback<0>, &timerCallback<1>, &timerCallback<2>,
+        &timerCallback<3>, &timerCallback<4>, &timerCallback<5>, &timerCallback<6>, &timerCallback<7>, &timerCallback<8>,
+        &timerCallback<9>, &timerCallback<10>, &timerCallback<11>, &timerCallback<12>, &timerCallback<13>,
+        &timerCallback<14>, &timerCallback<15> };
+
+/*
+ * Old variant like timing.cpp before the timer wheel
+ */
+static void (*DelayCallbackPointer[NUMBER_OF_ENTRIES])(void);
+static volatile int32_t DelayCallbackMillis[NUMBER_OF_ENTRIES];
+
+static void registerDelayCallbackScan(void (*aDelayCallback)(void), int32_t aTimeMillis) {
+    int i;
+    for (i = 0; i < NUMBER_OF_ENTRIES; ++i) {
+        if (DelayCallbackMillis[i] == 0) {
+            DelayCallbackPointer[i] = aDelayCallback;
+            DelayCallbackMillis[i] = aTimeMillis;
+            return;
+        }
+    }
+    printf("No more free callback entries\n");
+}
+
+static void changeDelayCallbackScan(void (*aDelayCallback)(void), int32_t aTimeMillis) {
+    int i;
+    for (i = 0; i < NUMBER_OF_ENTRIES; ++i) {
+        if (DelayCallbackPointer[i] == aDelayCallback) {
+            DelayCallbackMillis[i] = aTimeMillis;
+            return;
+        }
+    }
+    registerDelayCallbackScan(aDelayCallback, aTimeMillis);
+}
+
+static void doOneSysticScan(void) {
+    int i;
+    for (i = 0; i < NUMBER_OF_ENTRIES; ++i) {
+        if (DelayCallbackMillis[i] > 0) {
+            DelayCallbackMillis[i]--;
+            if (DelayCallbackMillis[i] == 0) {
+                DelayCallbackPointer[i]();
+            }
+        }
+    }
+}
+
+/*
+ * New variant like timing.cpp
+ */
+static struct TimerWheelEntry sDelayCallbackEntries[NUMBER_OF_ENTRIES];
+static struct TimerWheel sDelayCallbackWheel;
+
+static void registerDelayCallbackWheel(void (*aDelayCallback)(void), int32_t aTimeMillis) {
+    if (!addTimerWheelCallback(&sDelayCallbackWheel, aDelayCallback, aTimeMillis)) {
+        printf("No more free callback entries\n");
+    }
+}
+
+static void changeDelayCallbackWheel(void (*aDelayCallback)(void), int32_t aTimeMillis) {
+    changeTimerWheelCallback(&sDelayCallbackWheel, aDelayCallback, aTimeMillis);
+}
+
+static void doOneSysticWheel(void) {
+    doTimerWheelTick(&sDelayCallbackWheel);
+}
+
+struct RunResult {
+    struct CallStatistics Statistics;
+    double NanosPerTick;
+    double CyclesPerTick;
+    uint64_t MaxCyclesPerTick;
+    double NanosPerChange;
+};
+
+/*
+ * Registers the timers and runs NUMBER_OF_TICKS systics
+ */
+static void run(void (*aRegisterFunction)(void (*aDelayCallback)(void), int32_t aTimeMillis),
+        void (*aChangeFunction)(void (*aDelayCallback)(void), int32_t aTimeMillis), void (*aSysticFunction)(void),
+        struct RunResult * aResult) {
+    memset(&sStatistics, 0, sizeof(sStatistics));
+    sTick = 0;
+    sRegisterFunction = aRegisterFunction;
+    for (int i = 0; i < TIMER_COUNT; ++i) {
+        aRegisterFunction(sCallbacks[i % NUMBER_OF_CALLBACKS], getDelayMillis(0, i));
+    }
+
+    uint64_t tCycles = 0;
+    uint64_t tMaxCycles = 0;
+    uint64_t tChangeNanos = 0;
+    uint64_t tStartNanos = getHostNanos();
+    while (sTick < NUMBER_OF_TICKS) {
+        if (sTick % CHANGE_PERIOD_TICKS == 0) {
+            // cancel every 4th change
+            int32_t tMillis =
+                    (sTick % (4 * CHANGE_PERIOD_TICKS) == 0) ? 0 : getDelayMillis(sTick, CHANGED_CALLBACK_NUMBER) % 50 + 1;
+            uint64_t tChangeStartNanos = getHostNanos();
+            aChangeFunction(&changedCallback, tMillis);
+            tChangeNanos += getHostNanos() - tChangeStartNanos;
+        }
+        uint64_t tStartCycles = __rdtsc();
+        aSysticFunction();
+        uint64_t tTickCycles = __rdtsc() - tStartCycles;
+        tCycles += tTickCycles;
+        if (tMaxCycles < tTickCycles) {
+            tMaxCycles = tTickCycles;
+        }
+        sTick++;
+    }
+    uint64_t tNanos = getHostNanos() - tStartNanos - tChangeNanos;
+
+    aResult->Statistics = sStatistics;
+    aResult->NanosPerTick = (double) tNanos / NUMBER_OF_TICKS;
+    aResult->CyclesPerTick = (double) tCycles / NUMBER_OF_TICKS;
+    aResult->MaxCyclesPerTick = tMaxCycles;
+    aResult->NanosPerChange = (double) tChangeNanos / (NUMBER_OF_TICKS / CHANGE_PERIOD_TICKS);
+}
+
+static void printResult(const char * aName, struct RunResult * aResult) {
+    printf("%-12s %8.1f %10.1f %10llu %10.1f %8u\n", aName, aResult->NanosPerTick, aResult->CyclesPerTick,
+            (unsigned long long) aResult->MaxCyclesPerTick, aResult->NanosPerChange, aResult->Statistics.NumberOfCalls);
+}
+
+int main(void) {
+    struct RunResult tScan, tWheel;
+
+    run(&registerDelayCallbackScan, &changeDelayCallbackScan, &doOneSysticScan, &tScan);
+
+    initTimerWheel(&sDelayCallbackWheel, sDelayCallbackEntries, NUMBER_OF_ENTRIES);
+    run(&registerDelayCallbackWheel, &changeDelayCallbackWheel, &doOneSysticWheel, &tWheel);
+
+    bool tIdentical = tScan.Statistics.NumberOfCalls == tWheel.Statistics.NumberOfCalls
+            && tScan.Statistics.Checksum == tWheel.Statistics.Checksum;
+
+    printf("%d timers with %d callbacks and delays up to %d ms, %d entries, %d systics\n", TIMER_COUNT, NUMBER_OF_CALLBACKS,
+            MAX_DELAY_MILLIS, NUMBER_OF_ENTRIES, NUMBER_OF_TICKS);
+    printf("%-12s %8s %10s %10s %10s %8s\n", "", "ns/tick", "cyc/tick", "max cyc", "ns/change", "calls");
+    printResult("array scan", &tScan);
+    printResult("timer wheel", &tWheel);
+    printf("timer wheel: max %u active timers, %.2f redistributed timers per tick\n",
+            sDelayCallbackWheel.MaxNumberOfActiveTimers,
+            (double) sDelayCallbackWheel.NumberOfRedistributedTimers / NUMBER_OF_TICKS);
+    printf("calls of array scan and timer wheel %s\n", tIdentical ? "identical" : "DIFFER");
+    return tIdentical ? 0 : 1;
+}
+
+#endif
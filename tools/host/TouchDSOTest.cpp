@@ -0,0 +1,174 @@
+/**
+ * @file TouchDSOTest.cpp
+ *
+ * Test of the DSO application. Links the unchanged TouchDSOGui.cpp, TouchDSODisplay.cpp and TouchDSOAcquisition.cpp
+ * with the simulated ADC, DMA and FFT of HostDSO.cpp and the host backend of the local display.
+ * A sine signal is acquired with an interrupt timebase in Min/Max mode, an interrupt timebase in sample mode
+ * and a fast DMA timebase. For each timebase the measured min, max and frequency and the peak bin of the FFT are checked.
+ * The time of the simulated signal is taken from the DSO timer registers, so a wrong timer setting for a timebase
+ * shows up as a wrong frequency.
+ *
+ * Build on x86 Linux from project root with: make -C tools/host build/TouchDSOTest
+ * and run it with: tools/host/build/TouchDSOTest
+ *
+ * Only compiled if HOST_SIMULATION is defined.
+ *
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ */
+
+#ifdef HOST_SIMULATION
+
+#include "Pages.h"
+#include "TouchDSO.h"
+#include "MI0283QT2.h"
+#include "myStrings.h"
+#include "HostSupport.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/*
+ * Definitions of the pages, which are not linked
+ */
+const unsigned int REMOTE_DISPLAY_HEIGHT = 240;
+const unsigned int REMOTE_DISPLAY_WIDTH = 320;
+
+BDButton TouchButtonMainHome;
+uint32_t MillisLastLoop;
+uint32_t MillisSinceLastAction;
+
+void doMainMenuHomeButton(BDButton * aTheTouchedButton, int16_t aValue) {
+    (void) aTheTouchedButton;
+    (void) aValue;
+}
+
+void doBacklightSlider(BDSlider * aTheTouchedSlider, uint16_t aBrightness) {
+    (void) aTheTouchedSlider;
+    (void) aBrightness;
+}
+
+float getNumberFromNumberPad(uint16_t aXStart, uint16_t aYStart, uint16_t aButtonColor) {
+    (void) aXStart;
+    (void) aYStart;
+    (void) aButtonColor;
+    return 0;
+}
+
+// from TouchDSOGui.cpp
+void doStartStopDSO(BDButton * aTheTouchedButton, int16_t aValue);
+int changeTimeBaseValue(int aChangeValue);
+
+#define SIGNAL_RAW_OFFSET 2048
+#define SIGNAL_RAW_AMPLITUDE 1000
+#define RAW_VALUE_TOLERANCE 20 // sampled sine may miss the peaks
+#define BUFFERS_PER_TIMEBASE 4 // the first buffers are used for timebase change, auto range and auto trigger
+#define MAX_CONVERSIONS_PER_BUFFER 1000000
+
+static double sSignalHertz;
+
+static bool sAllChecksPassed = true;
+
+static void check(bool aCondition, const char * aMessage) {
+    if (!aCondition) {
+        printf("FAILED: %s\n", aMessage);
+        sAllChecksPassed = false;
+    }
+}
+
+static uint16_t getSineSample(double aSeconds) {
+    return SIGNAL_RAW_OFFSET + lround(SIGNAL_RAW_AMPLITUDE * sin(2 * M_PI * sSignalHertz * aSeconds));
+}
+
+/*
+ * Runs the simulated ADC until the DSO has a full buffer, then lets the main loop of the DSO process it
+ */
+static bool acquireBuffers(int aNumberOfBuffers) {
+    for (int i = 0; i < aNumberOfBuffers; ++i) {
+        uint32_t tStartConversions = HostADCConversions;
+        while (!DataBufferControl.DataBufferFull) {
+            if (!isHostADCRunning() || HostADCConversions - tStartConversions > MAX_CONVERSIONS_PER_BUFFER) {
+                return false;
+            }
+            runHostADC(DATABUFFER_DISPLAY_RESOLUTION);
+        }
+        loopDSOPage();
+    }
+    return true;
+}
+
+/**
+ * Acquires a sine, which gives a peak at aFFTBin for the FFT of the first FFT_SIZE displayed values
+ */
+static void checkTimebase(int aTimebaseIndex, int aFFTBin) {
+    changeTimeBaseValue(aTimebaseIndex - MeasurementControl.TimebaseEffectiveIndex);
+    // the new timebase is set by the main loop of the DSO after the next buffer
+    bool tAcquired = acquireBuffers(1);
+    double tDisplayValuePeriodSeconds = getHostADCSamplePeriodSeconds();
+    if (MeasurementControl.isEffectiveMinMaxMode) {
+        tDisplayValuePeriodSeconds *= MeasurementControl.MinMaxModeTempValuesSize;
+    }
+    sSignalHertz = aFFTBin / (FFT_SIZE * tDisplayValuePeriodSeconds);
+    tAcquired = tAcquired && acquireBuffers(BUFFERS_PER_TIMEBASE);
+    computeFFT(DataBufferControl.DataBufferDisplayStart);
+
+    printf("timebase index %2d %s %s: signal %8.1f Hz, measured %6u Hz min %4u max %4u, FFT peak at bin %3d\n",
+            aTimebaseIndex, MeasurementControl.TimebaseFastDMAMode ? "DMA      " : "interrupt",
+            MeasurementControl.isEffectiveMinMaxMode ? "Min/Max" : "sample ", sSignalHertz,
+            (unsigned int) MeasurementControl.FrequencyHertz, MeasurementControl.RawValueMin,
+            MeasurementControl.RawValueMax, FFTInfo.MaxIndex);
+
+    check(tAcquired, "acquisition stopped or buffer not filled");
+    check(MeasurementControl.TimebaseEffectiveIndex == aTimebaseIndex, "timebase not changed");
+    check(MeasurementControl.TimebaseFastDMAMode == (aTimebaseIndex < TIMEBASE_FAST_MODES), "wrong acquisition mode");
+    check(abs(MeasurementControl.RawValueMin - (SIGNAL_RAW_OFFSET - SIGNAL_RAW_AMPLITUDE)) <= RAW_VALUE_TOLERANCE,
+            "wrong min value");
+    check(abs(MeasurementControl.RawValueMax - (SIGNAL_RAW_OFFSET + SIGNAL_RAW_AMPLITUDE)) <= RAW_VALUE_TOLERANCE,
+            "wrong max value");
+    check(FFTInfo.MaxIndex == aFFTBin, "wrong FFT peak bin");
+    /*
+     * The host uses the F1 tables, since STM32F30X is not defined. Their exact timebase values of the XScale timebases
+     * are for a grid of 32 pixels and not of 32 values, so the frequency is only checked without XScale.
+     */
+    if (DisplayControl.XScale == 0) {
+        check(fabs(MeasurementControl.FrequencyHertz - sSignalHertz) < sSignalHertz / 100, "wrong frequency");
+    }
+}
+
+static int countPixelsOfColor(Color_t aColor) {
+    int tCount = 0;
+    for (int y = 0; y < LOCAL_DISPLAY_HEIGHT; ++y) {
+        for (int x = 0; x < LOCAL_DISPLAY_WIDTH; ++x) {
+            if (HostFrameBuffer[y][x] == aColor) {
+                tCount++;
+            }
+        }
+    }
+    return tCount;
+}
+
+int main(void) {
+    // only the local display is drawn
+    HostBluetoothPaired = false;
+    HostADCSampleCallback = &getSineSample;
+
+    // like initMainMenuPage()
+    TouchButtonMainHome.init(BUTTON_WIDTH_5_POS_5, 0, BUTTON_WIDTH_5, BUTTON_HEIGHT_4, COLOR_RED, StringHomeChar,
+            TEXT_SIZE_22, BUTTON_FLAG_DO_BEEP_ON_TOUCH, 0, &doMainMenuHomeButton);
+    initDSOPage();
+    startDSOPage();
+    doStartStopDSO(NULL, 0);
+    check(MeasurementControl.isRunning, "DSO not started");
+
+    checkTimebase(TIMEBASE_INDEX_START_VALUE, 8);
+    check(countPixelsOfColor(COLOR_DATA_RUN) > DSO_DISPLAY_WIDTH / 2, "chart not drawn");
+    checkTimebase(TIMEBASE_FAST_MODES, 10);
+    checkTimebase(TIMEBASE_FAST_MODES - 1, 16);
+
+    stopDSOPage();
+
+    printf("all checks %s\n", sAllChecksPassed ? "passed" : "FAILED");
+    return sAllChecksPassed ? 0 : 1;
+}
+
+#endif // HOST_SIMULATION
@@ -0,0 +1,196 @@
+/**
+ * @file TouchGridBenchmark.cpp
+ *
+ * Host benchmark for the touch grid of TouchGrid.cpp, which is used by TouchButton::checkAllButtons().
+ * Runs the real TouchButton.cpp with the host stubs of HostLocalDisplay.cpp.
+ * The grid lookup including the grid build is TouchButton::checkAllButtons(), the list scan is the loop of
+ * checkAllButtons() with DO_NOT_USE_TOUCH_GRID, which calls TouchButton::checkButton() for all buttons in list order.
+ *
+ * Three pages with 149 buttons in total, a 12 x 10 keypad, a DSO like page and a settings page.
+ * Only the buttons of one page and one back button are active. For each page random touches are checked
+ * with the list scan and with the grid and the touched buttons are compared.
+ * Page switches deactivate and activate buttons, so the grid is built again on the first touch after each switch.
+ *
+ * Build on x86 Linux from project root with: make -C tools/host build/TouchGridBenchmark
+ * and run it with: tools/host/build/TouchGridBenchmark
+ *
+ * Only compiled if HOST_SIMULATION is defined.
+ *
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ */
+
+#ifdef HOST_SIMULATION
+
+#include "BlueDisplay.h" // for FLAG_IS_ACTIVE
+#include "TouchButton.h"
+#include "TouchGrid.h"
+#include "HostSupport.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+const unsigned int REMOTE_DISPLAY_HEIGHT = 240;
+const unsigned int REMOTE_DISPLAY_WIDTH = 320;
+
+#define NUMBER_OF_BUTTONS 149
+#define NUMBER_OF_PAGES 3
+#define NUMBER_OF_TOUCHES 1000000
+#define NUMBER_OF_PAGE_SWITCHES 10000
+
+/*
+ * The constructors put the buttons into the button list in array order
+ */
+static TouchButton sButtons[NUMBER_OF_BUTTONS];
+static uint8_t sButtonPages[NUMBER_OF_BUTTONS]; // NUMBER_OF_PAGES -> active on all pages
+static int sNumberOfButtons = 0;
+
+static TouchButton * sTouchedButton;
+
+static void doTouch(TouchButton * aTheTouchedButton, int16_t aValue) {
+    sTouchedButton = aTheTouchedButton;
+}
+
+static void addButton(uint16_t aPositionX, uint16_t aPositionY, uint16_t aWidthX, uint16_t aHeightY, uint8_t aPage) {
+    // not active until showPage()
+    sButtons[sNumberOfButtons].initButton(aPositionX, aPositionY, aWidthX, aHeightY, COLOR_RED, "", TEXT_SIZE_11, 0,
+            sNumberOfButtons, &doTouch);
+    sButtonPages[sNumberOfButtons] = aPage;
+    sNumberOfButtons++;
+}
+
+static void createPages(void) {
+    // back button on all pages
+    addButton(LOCAL_DISPLAY_WIDTH - 40, 0, 39, 24, NUMBER_OF_PAGES);
+    // page 0 - keypad of 12 x 10 buttons below the back button
+    for (int tRow = 0; tRow < 10; ++tRow) {
+        for (int tColumn = 0; tColumn < 12; ++tColumn) {
+            addButton(tColumn * 26 + 2, tRow * 21 + 28, 24, 19, 0);
+        }
+    }
+    // page 1 - DSO like, buttons on the right, some on the bottom
+    for (int i = 0; i < 8; ++i) {
+        addButton(LOCAL_DISPLAY_WIDTH - 64, 28 + i * 26, 63, 24, 1);
+    }
+    for (int i = 0; i < 4; ++i) {
+        addButton(i * 64, LOCAL_DISPLAY_HEIGHT - 26, 62, 25, 1);
+    }
+    // page 2 - settings, 2 columns of wide buttons
+    for (int i = 0; i < 16; ++i) {
+        addButton((i & 1) * 150 + 5, 28 + (i / 2) * 26, 140, 24, 2);
+    }
+}
+
+/*
+ * activate() and deactivate() invalidate the grid only if the state changes
+ */
+static void showPage(uint8_t aPage) {
+    for (int i = 0; i < sNumberOfButtons; ++i) {
+        if (sButtonPages[i] == aPage || sButtonPages[i] == NUMBER_OF_PAGES) {
+            sButtons[i].activate();
+        } else {
+            sButtons[i].deactivate();
+        }
+    }
+}
+
+/*
+ * The list scan of TouchButton::checkAllButtons() with DO_NOT_USE_TOUCH_GRID
+ * @return touched button or NULL
+ */
+static TouchButton * checkAllButtonsByList(unsigned int aTouchPositionX, unsigned int aTouchPositionY) {
+    sTouchedButton = NULL;
+    for (int i = 0; i < sNumberOfButtons; ++i) {
+        if ((sButtons[i].mFlags & FLAG_IS_ACTIVE) && sButtons[i].checkButton(aTouchPositionX, aTouchPositionY)) {
+            break;
+        }
+    }
+    return sTouchedButton;
+}
+
+/*
+ * @return touched button or NULL
+ */
+static TouchButton * checkAllButtonsByGrid(unsigned int aTouchPositionX, unsigned int aTouchPositionY) {
+    sTouchedButton = NULL;
+    TouchButton::checkAllButtons(aTouchPositionX, aTouchPositionY);
+    return sTouchedButton;
+}
+
+static uint16_t sTouchX[NUMBER_OF_TOUCHES];
+static uint16_t sTouchY[NUMBER_OF_TOUCHES];
+
+int main(void) {
+    createPages();
+    srand(4711);
+    for (int i = 0; i < NUMBER_OF_TOUCHES; ++i) {
+        sTouchX[i] = rand() % LOCAL_DISPLAY_WIDTH;
+        sTouchY[i] = rand() % LOCAL_DISPLAY_HEIGHT;
+    }
+
+    printf("%d buttons on %d pages, grid of %d x %d cells of %d pixel\n", sNumberOfButtons, NUMBER_OF_PAGES,
+    TOUCH_GRID_NUMBER_OF_COLUMNS, TOUCH_GRID_NUMBER_OF_ROWS, TOUCH_GRID_CELL_SIZE);
+    printf("page active  list ns/touch  grid ns/touch  hits     result\n");
+
+    bool tAllIdentical = true;
+    uintptr_t tSink = 0;
+    for (uint8_t tPage = 0; tPage < NUMBER_OF_PAGES; ++tPage) {
+        showPage(tPage);
+        int tNumberOfActiveButtons = 0;
+        for (int i = 0; i < sNumberOfButtons; ++i) {
+            if (sButtons[i].mFlags & FLAG_IS_ACTIVE) {
+                tNumberOfActiveButtons++;
+            }
+        }
+
+        uint64_t tStartNanos = getHostNanos();
+        for (int i = 0; i < NUMBER_OF_TOUCHES; ++i) {
+            tSink += (uintptr_t) checkAllButtonsByList(sTouchX[i], sTouchY[i]);
+        }
+        uint64_t tListNanos = getHostNanos() - tStartNanos;
+
+        tStartNanos = getHostNanos();
+        for (int i = 0; i < NUMBER_OF_TOUCHES; ++i) {
+            tSink += (uintptr_t) checkAllButtonsByGrid(sTouchX[i], sTouchY[i]);
+        }
+        uint64_t tGridNanos = getHostNanos() - tStartNanos;
+
+        int tNumberOfHits = 0;
+        bool tIdentical = true;
+        for (int i = 0; i < NUMBER_OF_TOUCHES; ++i) {
+            TouchButton * tButton = checkAllButtonsByList(sTouchX[i], sTouchY[i]);
+            if (tButton != NULL) {
+                tNumberOfHits++;
+            }
+            if (tButton != checkAllButtonsByGrid(sTouchX[i], sTouchY[i])) {
+                tIdentical = false;
+            }
+        }
+        tAllIdentical &= tIdentical;
+
+        printf("%4d %6d %14.1f %14.1f %9d  %s\n", tPage, tNumberOfActiveButtons, (double) tListNanos / NUMBER_OF_TOUCHES,
+                (double) tGridNanos / NUMBER_OF_TOUCHES, tNumberOfHits, tIdentical ? "identical" : "DIFFER");
+    }
+
+    /*
+     * Page switch followed by one touch, which builds the grid again
+     */
+    uint64_t tStartNanos = getHostNanos();
+    for (int i = 0; i < NUMBER_OF_PAGE_SWITCHES; ++i) {
+        showPage(i % NUMBER_OF_PAGES);
+        tSink += (uintptr_t) checkAllButtonsByGrid(sTouchX[i], sTouchY[i]);
+    }
+    uint64_t tSwitchNanos = getHostNanos() - tStartNanos;
+    tStartNanos = getHostNanos();
+    for (int i = 0; i < NUMBER_OF_PAGE_SWITCHES; ++i) {
+        showPage(i % NUMBER_OF_PAGES);
+        tSink += (uintptr_t) checkAllButtonsByList(sTouchX[i], sTouchY[i]);
+    }
+    uint64_t tSwitchListNanos = getHostNanos() - tStartNanos;
+    printf("page switch and first touch: list %.1f ns, grid including build %.1f ns\n",
+            (double) tSwitchListNanos / NUMBER_OF_PAGE_SWITCHES, (double) tSwitchNanos / NUMBER_OF_PAGE_SWITCHES);
+
+    printf("list and grid results %s (%lu)\n", tAllIdentical ? "identical" : "DIFFER", (unsigned long) (tSink & 0xFF));
+    return tAllIdentical ? 0 : 1;
+}
+
+#endif
@@ -0,0 +1,602 @@
+/**
+ * @file TouchSamplingBenchmark.cpp
+ *
+ * Host benchmark for touch sampling with a model of the ADS7846 touch controller.
+ * ADS7846.cpp needs the SPI and interrupt hardware and cannot be compiled on the host, so both variants are modelled here
+ * with a 1 ms SysTick and the sampling state machine of TouchSampler.cpp.
+ *
+ * Before: the pen interrupt waits 10 ms for debouncing and reads the panel with rd_data(4),
+ * then a 20 ms SysTick callback reads it again, pages with ADS7846 channels poll rd_data() in the main loop.
+ * localTouchEvent holds only one event, so an up event overwrites a down event not yet handled by the main loop.
+ * After: the pen interrupt starts the sampling state machine, which takes one raw sample every 2 ms,
+ * rejects outliers, filters it by median of 5 and IIR and publishes the position as snapshot. Events are queued until the main loop takes them.
+ *
+ * The model panel has gaussian noise, which is higher for Y, 3% spikes, a bouncing interrupt line
+ * and low pressure at the start and end of each touch. The touches are holds of 600 ms, taps of 40 ms and swipes of 300 ms.
+ *
+ * Build on x86 Linux from project root with: make -C tools/host build/TouchSamplingBenchmark
+ * and run it with: tools/host/build/TouchSamplingBenchmark
+ *
+ * Only compiled if HOST_SIMULATION is defined.
+ *
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ */
+
+#ifdef HOST_SIMULATION
+
+#include "TouchSampler.h"
+#include "BlueDisplayProtocol.h" // for EVENT_TOUCH_ACTION_*
+#include "HostSupport.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#define NUMBER_OF_TOUCHES 300
+#define TOUCH_GAP_MILLIS 100
+#define TOUCH_TYPE_HOLD 0
+#define TOUCH_TYPE_TAP 1
+#define TOUCH_TYPE_SWIPE 2
+static const uint32_t sTouchDurationMillis[3] = { 600, 40, 300 };
+
+#define HOLD_SETTLE_MILLIS 100 // start of holds and swipes is not used for statistics
+
+// as in ADS7846.cpp
+#define TOUCH_DELAY_AFTER_READ_MILLIS 3
+#define TOUCH_DEBOUNCE_DELAY_MILLIS 10
+#define TOUCH_SWIPE_RESOLUTION_MILLIS 20
+#define MIN_REASONABLE_PRESSURE 9
+#define ADS7846_READ_OVERSAMPLING_DEFAULT 4
+#define TOUCH_EVENT_QUEUE_SIZE 8
+
+#define SPI_BYTE_NANOS 7111 // 8 bit at 72 MHz / 64
+#define RD_DATA_SPI_BYTES (4 + ADS7846_READ_OVERSAMPLING_DEFAULT * 9 + 4) // pressure, 4 x (X + 2 x Y), pressure
+#define RAW_SAMPLE_SPI_BYTES 10 // pressure, X, Y
+
+#define NOISE_SIGMA_X 4.0 // 12 bit raw units
+#define NOISE_SIGMA_Y 10.0
+#define SPIKE_PERCENT 3
+#define SPIKE_MIN 150
+#define SPIKE_MAX 400
+
+// sInitalMatrix of ADS7846.cpp
+static const long sMatrix[7] = { 320300, -1400, -52443300, -3500, 237700, -21783300, 1857905 };
+
+struct ModelTouch {
+    uint32_t StartMillis;
+    uint32_t EndMillis; // first millisecond without touch
+    int Type;
+    float StartX; // 11 bit raw units
+    float StartY;
+    float EndX;
+    float EndY;
+};
+
+static ModelTouch sTouches[NUMBER_OF_TOUCHES];
+static uint32_t sEndMillis;
+
+/*
+ * Deterministic random numbers, so every variant sees the same panel
+ */
+static uint32_t sRandomState;
+
+static uint32_t getRandom(void) {
+    sRandomState = sRandomState * 1664525 + 1013904223;
+    return sRandomState >> 8;
+}
+
+static double getRandomUnit(void) {
+    return (getRandom() + 0.5) / (double) (1 << 24);
+}
+
+static double getGaussian(void) {
+    return sqrt(-2.0 * log(getRandomUnit())) * cos(2.0 * M_PI * getRandomUnit());
+}
+
+static void createTouches(void) {
+    sRandomState = 4711;
+    uint32_t tMillis = 50;
+    for (int i = 0; i < NUMBER_OF_TOUCHES; ++i) {
+        ModelTouch * tTouch = &sTouches[i];
+        tTouch->Type = i % 3;
+        tTouch->StartMillis = tMillis;
+        tTouch->EndMillis = tMillis + sTouchDurationMillis[tTouch->Type];
+        tTouch->StartX = 400 + getRandom() % 1400;
+        tTouch->StartY = 400 + getRandom() % 1200;
+        tTouch->EndX = tTouch->StartX;
+        tTouch->EndY = tTouch->StartY;
+        if (tTouch->Type == TOUCH_TYPE_SWIPE) {
+            tTouch->EndX = 400 + getRandom() % 1400;
+        }
+        tMillis = tTouch->EndMillis + TOUCH_GAP_MILLIS;
+    }
+    sEndMillis = tMillis;
+}
+
+static const ModelTouch * getTouch(uint32_t aMillis) {
+    for (int i = 0; i < NUMBER_OF_TOUCHES; ++i) {
+        if (aMillis < sTouches[i].StartMillis) {
+            return NULL;
+        }
+        if (aMillis < sTouches[i].EndMillis) {
+            return &sTouches[i];
+        }
+    }
+    return NULL;
+}
+
+static float getTrueX(const ModelTouch * aTouch, uint32_t aMillis) {
+    float tRatio = (float) (aMillis - aTouch->StartMillis) / (aTouch->EndMillis - aTouch->StartMillis);
+    return aTouch->StartX + (aTouch->EndX - aTouch->StartX) * tRatio;
+}
+
+static float getTrueY(const ModelTouch * aTouch, uint32_t aMillis) {
+    float tRatio = (float) (aMillis - aTouch->StartMillis) / (aTouch->EndMillis - aTouch->StartMillis);
+    return aTouch->StartY + (aTouch->EndY - aTouch->StartY) * tRatio;
+}
+
+/*
+ * Line is low while touched, but bounces at 1 and 4 ms after the start of a touch
+ */
+static bool isLineActive(uint32_t aMillis) {
+    const ModelTouch * tTouch = getTouch(aMillis);
+    if (tTouch == NULL) {
+        return false;
+    }
+    uint32_t tOffset = aMillis - tTouch->StartMillis;
+    return tOffset != 1 && tOffset != 4;
+}
+
+static int readPressure(uint32_t aMillis) {
+    const ModelTouch * tTouch = getTouch(aMillis);
+    if (tTouch == NULL) {
+        return getRandom() % 4;
+    }
+    if (aMillis - tTouch->StartMillis < 2 || tTouch->EndMillis - aMillis <= 2) {
+        // finger is just touching or leaving
+        return 4 + getRandom() % 4;
+    }
+    return 40 + (int) (getGaussian() * 3);
+}
+
+static int getSpike(void) {
+    if (getRandom() % 100 < SPIKE_PERCENT) {
+        int tSpike = SPIKE_MIN + getRandom() % (SPIKE_MAX - SPIKE_MIN);
+        return (getRandom() & 1) ? tSpike : -tSpike;
+    }
+    return 0;
+}
+
+static uint16_t clipConversion(double aValue) {
+    if (aValue < 0) {
+        return 0;
+    }
+    if (aValue > 4095) {
+        return 4095;
+    }
+    return aValue;
+}
+
+/*
+ * 12 bit conversion results of the ADS7846, X is reversed
+ */
+static uint16_t convertX(uint32_t aMillis) {
+    const ModelTouch * tTouch = getTouch(aMillis);
+    if (tTouch == NULL) {
+        return 4095;
+    }
+    return clipConversion(4048 - 2 * getTrueX(tTouch, aMillis) + getGaussian() * NOISE_SIGMA_X + getSpike());
+}
+
+static uint16_t convertY(uint32_t aMillis) {
+    const ModelTouch * tTouch = getTouch(aMillis);
+    if (tTouch == NULL) {
+        return 0;
+    }
+    return clipConversion(2 * getTrueY(tTouch, aMillis) + getGaussian() * NOISE_SIGMA_Y + getSpike());
+}
+
+/*
+ * Like ADS7846::calibrate()
+ */
+static XYPosition calibrate(long aRawX, long aRawY) {
+    XYPosition tPosition;
+    long x = ((sMatrix[0] * aRawX) + (sMatrix[1] * aRawY) + sMatrix[2]) / sMatrix[6];
+    long y = ((sMatrix[3] * aRawX) + (sMatrix[4] * aRawY) + sMatrix[5]) / sMatrix[6];
+    tPosition.PosX = x < 0 ? 0 : (x > 319 ? 319 : x);
+    tPosition.PosY = y < 0 ? 0 : (y > 239 ? 239 : y);
+    return tPosition;
+}
+
+/*
+ * Results of one variant with one main loop period
+ */
+struct SamplingResult {
+    int NumberOfDownEventsHandled;
+    int NumberOfUpEventsHandled;
+    uint32_t SumOfDownLatencyMillis;
+    int NumberOfDownEvents;
+    uint64_t InterruptNanos;
+    uint64_t LongestInterruptNanos;
+    // hold statistics
+    double SumOfSquaredDeviation;
+    double MaxDeviation;
+    uint32_t NumberOfHoldSamples;
+    uint32_t NumberOfHoldMoves;
+    // swipe statistics
+    double SumOfSwipeDeviation;
+    uint32_t NumberOfSwipeSamples;
+};
+
+static void addInterruptTime(SamplingResult * aResult, uint64_t aNanos) {
+    aResult->InterruptNanos += aNanos;
+    if (aNanos > aResult->LongestInterruptNanos) {
+        aResult->LongestInterruptNanos = aNanos;
+    }
+}
+
+/*
+ * Reported position while the main loop polls every millisecond, compared with the true position during holds and swipes
+ */
+static void addPositionStatistics(SamplingResult * aResult, uint32_t aMillis, bool aIsTouched, XYPosition aPosition) {
+    const ModelTouch * tTouch = getTouch(aMillis);
+    if (tTouch == NULL || tTouch->Type == TOUCH_TYPE_TAP || !aIsTouched
+            || aMillis < tTouch->StartMillis + HOLD_SETTLE_MILLIS || aMillis + 50 > tTouch->EndMillis) {
+        return;
+    }
+    XYPosition tTruePosition = calibrate(getTrueX(tTouch, aMillis), getTrueY(tTouch, aMillis));
+    double tDeviationX = aPosition.PosX - tTruePosition.PosX;
+    double tDeviationY = aPosition.PosY - tTruePosition.PosY;
+    double tSquaredDeviation = tDeviationX * tDeviationX + tDeviationY * tDeviationY;
+    if (tTouch->Type == TOUCH_TYPE_SWIPE) {
+        aResult->SumOfSwipeDeviation += sqrt(tSquaredDeviation);
+        aResult->NumberOfSwipeSamples++;
+        return;
+    }
+    aResult->SumOfSquaredDeviation += tSquaredDeviation;
+    if (sqrt(tSquaredDeviation) > aResult->MaxDeviation) {
+        aResult->MaxDeviation = sqrt(tSquaredDeviation);
+    }
+    aResult->NumberOfHoldSamples++;
+}
+
+static void countHoldMove(SamplingResult * aResult, uint32_t aMillis) {
+    const ModelTouch * tTouch = getTouch(aMillis);
+    if (tTouch != NULL && tTouch->Type == TOUCH_TYPE_HOLD && aMillis >= tTouch->StartMillis + HOLD_SETTLE_MILLIS
+            && aMillis + 50 <= tTouch->EndMillis) {
+        aResult->NumberOfHoldMoves++;
+    }
+}
+
+static void addDownLatency(SamplingResult * aResult, uint32_t aMillis) {
+    const ModelTouch * tTouch = getTouch(aMillis);
+    if (tTouch != NULL) {
+        aResult->SumOfDownLatencyMillis += aMillis - tTouch->StartMillis;
+        aResult->NumberOfDownEvents++;
+    }
+}
+
+/*
+ * The main loop takes the event of localTouchEvent every aMainLoopPeriodMillis
+ */
+static void runMainLoop(SamplingResult * aResult, uint8_t * aLocalTouchEventTypePtr) {
+    if (*aLocalTouchEventTypePtr == EVENT_TOUCH_ACTION_DOWN) {
+        aResult->NumberOfDownEventsHandled++;
+    } else if (*aLocalTouchEventTypePtr == EVENT_TOUCH_ACTION_UP) {
+        aResult->NumberOfUpEventsHandled++;
+    }
+    *aLocalTouchEventTypePtr = EVENT_NO_EVENT;
+}
+
+/*****************************************************************
+ * Before: rd_data() in pen interrupt and move recognition callback
+ *****************************************************************/
+struct OldPanel {
+    XYPosition ActualPosition;
+    XYPosition LastPosition;
+    bool TouchActive;
+};
+
+/*
+ * Like ADS7846::rd_data(ADS7846_READ_OVERSAMPLING_DEFAULT)
+ */
+static void rd_data(OldPanel * aPanel, uint32_t aMillis) {
+    int tPressure = readPressure(aMillis);
+    aPanel->TouchActive = false;
+    if (tPressure >= MIN_REASONABLE_PRESSURE) {
+        uint32_t tXValue = 0, tYValue = 0;
+        int j = 0;
+        for (int i = ADS7846_READ_OVERSAMPLING_DEFAULT; i != 0; i--) {
+            uint32_t tX = convertX(aMillis);
+            if (tX >= 4000) {
+                break;
+            }
+            tXValue += 4048 - tX;
+            uint32_t tY = convertY(aMillis);
+            if (tY <= 100) {
+                break;
+            }
+            tYValue += tY + convertY(aMillis);
+            j += 2;
+        }
+        if (j == (ADS7846_READ_OVERSAMPLING_DEFAULT * 2)) {
+            tXValue /= j;
+            tYValue /= 2 * j;
+            if (readPressure(aMillis) > (tPressure - (tPressure >> 3)) && tXValue >= 10 && tYValue >= 10) {
+                aPanel->ActualPosition = calibrate(tXValue, tYValue);
+                aPanel->TouchActive = true;
+            }
+        }
+    }
+}
+
+static void runOld(SamplingResult * aResult, uint32_t aMainLoopPeriodMillis) {
+    memset(aResult, 0, sizeof(SamplingResult));
+    sRandomState = 1;
+    OldPanel tPanel;
+    memset(&tPanel, 0, sizeof(tPanel));
+    uint8_t tEventType = EVENT_NO_EVENT;
+    uint32_t tInterruptEnableMillis = 0;
+    uint32_t tMoveRecognitionMillis = 0; // 0 -> disabled
+    uint32_t tBlockedUntilMillis = 0; // main loop and SysTick callbacks are blocked by the debounce delay of the pen interrupt
+    bool tLastLineActive = false;
+    uint64_t tRdDataNanos = (uint64_t) RD_DATA_SPI_BYTES * SPI_BYTE_NANOS;
+
+    for (uint32_t tMillis = 0; tMillis < sEndMillis; ++tMillis) {
+        bool tLineActive = isLineActive(tMillis);
+        if (tMillis >= tBlockedUntilMillis) {
+            /*
+             * Pen interrupt on both edges, like EXTI1_IRQHandler()
+             */
+            if (tLineActive != tLastLineActive && tMillis >= tInterruptEnableMillis) {
+                uint32_t tReadMillis = tMillis + TOUCH_DEBOUNCE_DELAY_MILLIS;
+                tBlockedUntilMillis = tReadMillis;
+                if (isLineActive(tReadMillis)) {
+                    rd_data(&tPanel, tReadMillis);
+                    addInterruptTime(aResult, TOUCH_DEBOUNCE_DELAY_MILLIS * 1000000ULL + tRdDataNanos);
+                    tInterruptEnableMillis = tReadMillis + TOUCH_DELAY_AFTER_READ_MILLIS;
+                    tPanel.LastPosition = tPanel.ActualPosition;
+                    tEventType = EVENT_TOUCH_ACTION_DOWN;
+                    addDownLatency(aResult, tReadMillis);
+                    if (tPanel.TouchActive) {
+                        tMoveRecognitionMillis = tReadMillis + TOUCH_SWIPE_RESOLUTION_MILLIS;
+                    }
+                } else {
+                    addInterruptTime(aResult, TOUCH_DEBOUNCE_DELAY_MILLIS * 1000000ULL);
+                    tMoveRecognitionMillis = 0;
+                    if (tPanel.TouchActive) {
+                        tPanel.TouchActive = false;
+                        tEventType = EVENT_TOUCH_ACTION_UP;
+                    }
+                }
+            }
+            /*
+             * Like callbackADS7846MoveRecognition()
+             */
+            if (tMillis == tMoveRecognitionMillis) {
+                tMoveRecognitionMillis = 0;
+                if (tLineActive) {
+                    rd_data(&tPanel, tMillis);
+                    addInterruptTime(aResult, tRdDataNanos);
+                    tInterruptEnableMillis = tMillis + TOUCH_DELAY_AFTER_READ_MILLIS;
+                    if (!tPanel.TouchActive) {
+                        tEventType = EVENT_TOUCH_ACTION_UP;
+                    } else {
+                        if (tPanel.LastPosition.PosX != tPanel.ActualPosition.PosX
+                                || tPanel.LastPosition.PosY != tPanel.ActualPosition.PosY) {
+                            tPanel.LastPosition = tPanel.ActualPosition;
+                            countHoldMove(aResult, tMillis);
+                            if (tEventType == EVENT_NO_EVENT) {
+                                tEventType = EVENT_TOUCH_ACTION_MOVE;
+                            }
+                        }
+                        tMoveRecognitionMillis = tMillis + TOUCH_SWIPE_RESOLUTION_MILLIS;
+                    }
+                } else if (tPanel.TouchActive) {
+                    tPanel.TouchActive = false;
+                    tEventType = EVENT_TOUCH_ACTION_UP;
+                }
+            }
+            if (tMillis % aMainLoopPeriodMillis == 0) {
+                runMainLoop(aResult, &tEventType);
+            }
+        }
+        tLastLineActive = tLineActive;
+        addPositionStatistics(aResult, tMillis, tPanel.TouchActive, tPanel.ActualPosition);
+    }
+}
+
+/*****************************************************************
+ * After: sampling state machine, like ADS7846::doSamplingStep()
+ *****************************************************************/
+struct QueueEntry {
+    uint8_t EventType;
+    XYPosition Position;
+};
+static QueueEntry sQueue[TOUCH_EVENT_QUEUE_SIZE];
+static uint8_t sQueueOut;
+static uint8_t sQueueCount;
+
+static void queueTouchEvent(uint8_t aEventType, XYPosition aPosition) {
+    if (sQueueCount > 0) {
+        QueueEntry * tLastEntry = &sQueue[(sQueueOut + sQueueCount - 1) % TOUCH_EVENT_QUEUE_SIZE];
+        if (aEventType == EVENT_TOUCH_ACTION_MOVE && tLastEntry->EventType == EVENT_TOUCH_ACTION_MOVE) {
+            tLastEntry->Position = aPosition;
+            return;
+        }
+    }
+    if (sQueueCount >= TOUCH_EVENT_QUEUE_SIZE) {
+        return;
+    }
+    QueueEntry * tEntry = &sQueue[(sQueueOut + sQueueCount) % TOUCH_EVENT_QUEUE_SIZE];
+    tEntry->EventType = aEventType;
+    tEntry->Position = aPosition;
+    sQueueCount++;
+}
+
+static void deliverTouchEvent(uint8_t * aLocalTouchEventTypePtr) {
+    if (sQueueCount > 0
+            && (*aLocalTouchEventTypePtr == EVENT_NO_EVENT || *aLocalTouchEventTypePtr == EVENT_TOUCH_ACTION_MOVE)) {
+        *aLocalTouchEventTypePtr = sQueue[sQueueOut].EventType;
+        sQueueOut = (sQueueOut + 1) % TOUCH_EVENT_QUEUE_SIZE;
+        sQueueCount--;
+    }
+}
+
+static TouchSnapshot sSnapshot;
+
+static void runNew(SamplingResult * aResult, uint32_t aMainLoopPeriodMillis) {
+    memset(aResult, 0, sizeof(SamplingResult));
+    sRandomState = 1;
+    sQueueOut = 0;
+    sQueueCount = 0;
+    TouchSampler tSampler;
+    initTouchSampler(&tSampler);
+    memset(&sSnapshot, 0, sizeof(sSnapshot));
+    uint8_t tEventType = EVENT_NO_EVENT;
+    bool tInterruptEnabled = true;
+    uint32_t tEnableInterruptMillis = 0; // 0 -> disabled
+    uint32_t tSamplingMillis = 0; // 0 -> disabled
+    bool tLastLineActive = false;
+    XYPosition tActualPosition = { 0, 0 };
+    XYPosition tLastPosition = { 0, 0 };
+    uint64_t tRawSampleNanos = (uint64_t) RAW_SAMPLE_SPI_BYTES * SPI_BYTE_NANOS;
+
+    for (uint32_t tMillis = 0; tMillis < sEndMillis; ++tMillis) {
+        bool tLineActive = isLineActive(tMillis);
+        bool tStartSampling = false;
+        // like callbackADS7846EnableInterrupt()
+        if (tMillis == tEnableInterruptMillis) {
+            tEnableInterruptMillis = 0;
+            if (tSampler.State == TOUCH_SAMPLER_IDLE) {
+                tInterruptEnabled = true;
+                tStartSampling = tLineActive;
+            }
+        }
+        // like EXTI1_IRQHandler()
+        if (tInterruptEnabled && tLineActive && !tLastLineActive) {
+            tStartSampling = true;
+        }
+        if (tStartSampling && tSampler.State == TOUCH_SAMPLER_IDLE) {
+            tInterruptEnabled = false;
+            startTouchSamplerDebounce(&tSampler);
+            tSamplingMillis = tMillis + TOUCH_SAMPLER_PERIOD_MILLIS;
+        }
+
+        if (tMillis == tSamplingMillis) {
+            tSamplingMillis = 0;
+            if (tSampler.State == TOUCH_SAMPLER_DEBOUNCE) {
+                if (debounceTouchSampler(&tSampler, tLineActive) == TOUCH_SAMPLER_IDLE) {
+                    tInterruptEnabled = true;
+                }
+            } else if (tSampler.State == TOUCH_SAMPLER_SAMPLING) {
+                // like ADS7846::readRawSample()
+                int tPressure = readPressure(tMillis);
+                uint16_t tX = convertX(tMillis);
+                uint16_t tY = convertY(tMillis);
+                bool tIsValid = tPressure >= MIN_REASONABLE_PRESSURE && tX < 4000 && tY > 100;
+                addInterruptTime(aResult, tRawSampleNanos);
+                uint8_t tResult = addTouchSamplerSample(&tSampler, 4048 - tX, tY, tIsValid);
+                struct TouchSnapshotData tData;
+                if (tResult == TOUCH_SAMPLER_DOWN || tResult == TOUCH_SAMPLER_NEW_POSITION) {
+                    tActualPosition = calibrate(getTouchSamplerX(&tSampler) >> 1, getTouchSamplerY(&tSampler) >> 1);
+                    if (tResult == TOUCH_SAMPLER_DOWN) {
+                        tLastPosition = tActualPosition;
+                        queueTouchEvent(EVENT_TOUCH_ACTION_DOWN, tActualPosition);
+                        addDownLatency(aResult, tMillis);
+                    } else if (tLastPosition.PosX != tActualPosition.PosX || tLastPosition.PosY != tActualPosition.PosY) {
+                        tLastPosition = tActualPosition;
+                        queueTouchEvent(EVENT_TOUCH_ACTION_MOVE, tActualPosition);
+                        countHoldMove(aResult, tMillis);
+                    }
+                    tData.PositionX = tActualPosition.PosX;
+                    tData.PositionY = tActualPosition.PosY;
+                    tData.Pressure = tPressure;
+                    tData.IsTouched = true;
+                    writeTouchSnapshot(&sSnapshot, &tData);
+                } else if (tResult == TOUCH_SAMPLER_UP) {
+                    queueTouchEvent(EVENT_TOUCH_ACTION_UP, tLastPosition);
+                    tData = sSnapshot.Data;
+                    tData.IsTouched = false;
+                    writeTouchSnapshot(&sSnapshot, &tData);
+                }
+                if (tSampler.State == TOUCH_SAMPLER_IDLE) {
+                    tEnableInterruptMillis = tMillis + TOUCH_DELAY_AFTER_READ_MILLIS;
+                }
+            }
+            deliverTouchEvent(&tEventType);
+            if (tSampler.State != TOUCH_SAMPLER_IDLE || sQueueCount > 0) {
+                tSamplingMillis = tMillis + TOUCH_SAMPLER_PERIOD_MILLIS;
+            }
+        }
+        if (tMillis % aMainLoopPeriodMillis == 0) {
+            runMainLoop(aResult, &tEventType);
+        }
+        tLastLineActive = tLineActive;
+
+        struct TouchSnapshotData tData;
+        readTouchSnapshot(&sSnapshot, &tData);
+        XYPosition tPosition = { tData.PositionX, tData.PositionY };
+        addPositionStatistics(aResult, tMillis, tData.IsTouched, tPosition);
+    }
+}
+
+static void printResult(const char * aName, const SamplingResult * aResult, const SamplingResult * aSlowResult,
+        double aTouchSeconds) {
+    printf("%s\n", aName);
+    printf("  down events handled, main loop 1 ms / 50 ms %5d / %5d of %d touches, up events %d / %d\n",
+            aResult->NumberOfDownEventsHandled, aSlowResult->NumberOfDownEventsHandled, NUMBER_OF_TOUCHES,
+            aResult->NumberOfUpEventsHandled, aSlowResult->NumberOfUpEventsHandled);
+    printf("  down latency                                %8.1f ms\n",
+            (double) aResult->SumOfDownLatencyMillis / aResult->NumberOfDownEvents);
+    printf("  hold jitter rms / max                       %8.2f / %.2f pixel\n",
+            sqrt(aResult->SumOfSquaredDeviation / aResult->NumberOfHoldSamples), aResult->MaxDeviation);
+    printf("  mean distance to finger while swiping       %8.2f pixel\n",
+            aResult->SumOfSwipeDeviation / aResult->NumberOfSwipeSamples);
+    printf("  move events while holding                   %8.1f per second\n",
+            aResult->NumberOfHoldMoves / (aResult->NumberOfHoldSamples / 1000.0));
+    printf("  interrupt time                              %8.1f ms per touched second, longest %.1f us\n",
+            aResult->InterruptNanos / 1000000.0 / aTouchSeconds, aResult->LongestInterruptNanos / 1000.0);
+}
+
+int main(void) {
+    createTouches();
+    double tTouchSeconds = 0;
+    for (int i = 0; i < NUMBER_OF_TOUCHES; ++i) {
+        tTouchSeconds += (sTouches[i].EndMillis - sTouches[i].StartMillis) / 1000.0;
+    }
+
+    SamplingResult tOldResult, tOldSlowResult, tNewResult, tNewSlowResult;
+    runOld(&tOldResult, 1);
+    runOld(&tOldSlowResult, 50);
+    runNew(&tNewResult, 1);
+    runNew(&tNewSlowResult, 50);
+
+    /*
+     * Main loop time for reading the position, polled rd_data() versus snapshot
+     */
+    struct TouchSnapshotData tData;
+    volatile uint32_t tChecksum = 0;
+    uint64_t tStartNanos = getHostNanos();
+    for (int i = 0; i < 10000000; ++i) {
+        readTouchSnapshot(&sSnapshot, &tData);
+        tChecksum += tData.PositionX;
+    }
+    double tSnapshotNanos = (getHostNanos() - tStartNanos) / 10000000.0;
+
+    printf("%d touches (holds %u ms, taps %u ms, swipes %u ms), %.1f touched seconds\n", NUMBER_OF_TOUCHES,
+            sTouchDurationMillis[TOUCH_TYPE_HOLD], sTouchDurationMillis[TOUCH_TYPE_TAP], sTouchDurationMillis[TOUCH_TYPE_SWIPE],
+            tTouchSeconds);
+    printResult("rd_data() in pen interrupt and every 20 ms", &tOldResult, &tOldSlowResult, tTouchSeconds);
+    printResult("sampling every 2 ms, median of 5 and IIR", &tNewResult, &tNewSlowResult, tTouchSeconds);
+    printf("main loop time for reading the position: rd_data() %.1f us (SPI), snapshot %.1f ns (host)\n",
+            RD_DATA_SPI_BYTES * SPI_BYTE_NANOS / 1000.0, tSnapshotNanos);
+
+    bool tAllDownEventsHandled = tNewSlowResult.NumberOfDownEventsHandled == NUMBER_OF_TOUCHES
+            && tNewResult.NumberOfDownEventsHandled == NUMBER_OF_TOUCHES
+            && tNewSlowResult.NumberOfUpEventsHandled == NUMBER_OF_TOUCHES;
+    printf("all touches handled with background sampling %s\n", tAllDownEventsHandled ? "yes" : "NO");
+    return tAllDownEventsHandled ? 0 : 1;
+}
+
+#endif
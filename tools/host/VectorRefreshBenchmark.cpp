@@ -0,0 +1,254 @@
+/**
+ * @file VectorRefreshBenchmark.cpp
+ *
+ * Host benchmark for refreshVector() and refreshVectors() of BlueDisplay.cpp.
+ * Models the accelerometer, compass and gyroscope vectors of PageAccelerometerCompassGyroDemo.cpp, which are updated every 50 ms.
+ * The acceleration vector moves with sensor noise, the compass vector turns slowly and the gyroscope vector
+ * is mostly at rest, so some updates do not move the end point by a pixel.
+ * For each frame the time from the start of the update to the last byte on the simulated link is measured,
+ * once with one refreshVector() per vector and once with one refreshVectors() for all vectors.
+ *
+ * The drawing commands are rendered with a simple thick line model and compared after each frame
+ * with the vectors drawn from scratch, to count pixels left erased where vectors cross.
+ *
+ * Build on x86 Linux from project root with: make -C tools/host build/VectorRefreshBenchmark
+ * and run it with: tools/host/build/VectorRefreshBenchmark
+ *
+ * Only compiled if HOST_SIMULATION is defined.
+ *
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ */
+
+#ifdef HOST_SIMULATION
+
+#include "BlueDisplay.h"
+#include "HostSupport.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#define NUMBER_OF_FRAMES 1000
+#define NUMBER_OF_VECTORS 3
+#define FRAME_INTERVAL_NANOS 50000000
+
+const unsigned int REMOTE_DISPLAY_HEIGHT = 240;
+const unsigned int REMOTE_DISPLAY_WIDTH = 320;
+
+#define COLOR_ACC_GYRO_BACKGROUND COLOR_CYAN
+#define COMPASS_RADIUS 40
+
+static struct ThickLine sLines[NUMBER_OF_VECTORS];
+static struct ThickLine * const sLinePointers[NUMBER_OF_VECTORS] = { &sLines[0], &sLines[1], &sLines[2] };
+
+/*
+ * Remote side with a simple thick line model: a square brush of thickness along the Bresenham line
+ */
+static Color_t sCanvas[REMOTE_DISPLAY_HEIGHT][REMOTE_DISPLAY_WIDTH];
+static Color_t sReferenceCanvas[REMOTE_DISPLAY_HEIGHT][REMOTE_DISPLAY_WIDTH];
+static std::vector<uint8_t> sLinkData;
+
+static void captureLinkData(const uint8_t * aData, size_t aLength) {
+    sLinkData.insert(sLinkData.end(), aData, aData + aLength);
+}
+
+static uint16_t getShort(const uint8_t * aPointer) {
+    return aPointer[0] | (aPointer[1] << 8);
+}
+
+static void drawThickLineOnCanvas(Color_t aCanvas[][REMOTE_DISPLAY_WIDTH], int aXStart, int aYStart, int aXEnd, int aYEnd,
+        int aThickness, Color_t aColor) {
+    int tDeltaX = abs(aXEnd - aXStart);
+    int tDeltaY = -abs(aYEnd - aYStart);
+    int tStepX = (aXStart < aXEnd) ? 1 : -1;
+    int tStepY = (aYStart < aYEnd) ? 1 : -1;
+    int tError = tDeltaX + tDeltaY;
+    int tOffset = aThickness / 2;
+    while (true) {
+        for (int y = aYStart - tOffset; y < aYStart - tOffset + aThickness; ++y) {
+            for (int x = aXStart - tOffset; x < aXStart - tOffset + aThickness; ++x) {
+                if (x >= 0 && x < (int) REMOTE_DISPLAY_WIDTH && y >= 0 && y < (int) REMOTE_DISPLAY_HEIGHT) {
+                    aCanvas[y][x] = aColor;
+                }
+            }
+        }
+        if (aXStart == aXEnd && aYStart == aYEnd) {
+            break;
+        }
+        int tError2 = 2 * tError;
+        if (tError2 >= tDeltaY) {
+            tError += tDeltaY;
+            aXStart += tStepX;
+        }
+        if (tError2 <= tDeltaX) {
+            tError += tDeltaX;
+            aYStart += tStepY;
+        }
+    }
+}
+
+static void fillCanvas(Color_t aCanvas[][REMOTE_DISPLAY_WIDTH], Color_t aColor) {
+    for (unsigned int y = 0; y < REMOTE_DISPLAY_HEIGHT; ++y) {
+        for (unsigned int x = 0; x < REMOTE_DISPLAY_WIDTH; ++x) {
+            aCanvas[y][x] = aColor;
+        }
+    }
+}
+
+/**
+ * @return number of commands of sLinkData or -1 on decode error
+ */
+static int renderLinkData(void) {
+    int tNumberOfCommands = 0;
+    size_t tPosition = 0;
+    while (tPosition + 4 <= sLinkData.size()) {
+        const uint8_t * tCommand = &sLinkData[tPosition];
+        size_t tCommandLength = 4 + getShort(&tCommand[2]);
+        if (tCommand[0] != SYNC_TOKEN || tCommand[1] > INDEX_LAST_FUNCTION_WITHOUT_DATA
+                || tPosition + tCommandLength > sLinkData.size()) {
+            return -1;
+        }
+        const uint8_t * tParameters = &tCommand[4];
+        if (tCommand[1] == FUNCTION_DRAW_LINE) {
+            drawThickLineOnCanvas(sCanvas, getShort(&tParameters[0]), getShort(&tParameters[2]), getShort(&tParameters[4]),
+                    getShort(&tParameters[6]), getShort(&tParameters[10]), getShort(&tParameters[8]));
+        }
+        tNumberOfCommands++;
+        tPosition += tCommandLength;
+    }
+    sLinkData.clear();
+    return tNumberOfCommands;
+}
+
+/**
+ * @return number of pixels which differ from the vectors drawn on a cleared canvas
+ */
+static int compareWithReference(void) {
+    fillCanvas(sReferenceCanvas, COLOR_ACC_GYRO_BACKGROUND);
+    for (int i = 0; i < NUMBER_OF_VECTORS; ++i) {
+        drawThickLineOnCanvas(sReferenceCanvas, sLines[i].StartX, sLines[i].StartY, sLines[i].EndX, sLines[i].EndY,
+                sLines[i].Thickness, sLines[i].Color);
+    }
+    int tDifferentPixels = 0;
+    for (unsigned int y = 0; y < REMOTE_DISPLAY_HEIGHT; ++y) {
+        for (unsigned int x = 0; x < REMOTE_DISPLAY_WIDTH; ++x) {
+            if (sCanvas[y][x] != sReferenceCanvas[y][x]) {
+                tDifferentPixels++;
+            }
+        }
+    }
+    return tDifferentPixels;
+}
+
+/*
+ * Local side modeled after PageAccelerometerCompassGyroDemo.cpp
+ */
+static void initLines(void) {
+    const int16_t tStarts[NUMBER_OF_VECTORS][2] = { { REMOTE_DISPLAY_WIDTH / 2, REMOTE_DISPLAY_HEIGHT / 2 }, {
+    COMPASS_RADIUS + 10, REMOTE_DISPLAY_HEIGHT / 2 }, { BUTTON_WIDTH_3_POS_3, 200 } };
+    const int16_t tThickness[NUMBER_OF_VECTORS] = { 5, 5, 3 };
+    const Color_t tColors[NUMBER_OF_VECTORS] = { COLOR_RED, COLOR_BLACK, COLOR_BLUE };
+    for (int i = 0; i < NUMBER_OF_VECTORS; ++i) {
+        sLines[i].StartX = tStarts[i][0];
+        sLines[i].StartY = tStarts[i][1];
+        sLines[i].EndX = tStarts[i][0];
+        sLines[i].EndY = tStarts[i][1];
+        sLines[i].Thickness = tThickness[i];
+        sLines[i].Color = tColors[i];
+        sLines[i].BackgroundColor = COLOR_ACC_GYRO_BACKGROUND;
+    }
+}
+
+/**
+ * Deterministic sensor values, so both variants get the same input
+ */
+static void getSensorVectors(int aFrame, int16_t aNewRelEnds[][2]) {
+    static uint32_t sRandom;
+    if (aFrame == 0) {
+        sRandom = 4711;
+    }
+    sRandom = sRandom * 1103515245 + 12345;
+    int tNoise = (sRandom >> 16) % 5 - 2;
+    // acceleration with the board tilted back and forth
+    double tTilt = sin(aFrame * 0.02) * 60;
+    aNewRelEnds[0][0] = (int16_t) tTilt + tNoise;
+    aNewRelEnds[0][1] = (int16_t) (tTilt / 2);
+    // compass pointing slowly around
+    double tAngle = aFrame * 0.005;
+    aNewRelEnds[1][0] = (int16_t) (cos(tAngle) * (COMPASS_RADIUS - 5));
+    aNewRelEnds[1][1] = (int16_t) (-sin(tAngle) * (COMPASS_RADIUS - 5));
+    // gyroscope yaw at rest except for some turns
+    int tYaw = ((aFrame / 100) % 4 == 1) ? (aFrame % 100) - 50 : 0;
+    aNewRelEnds[2][0] = -tYaw;
+    aNewRelEnds[2][1] = -(2 * COMPASS_RADIUS);
+}
+
+static void runBenchmark(uint32_t aBaudRate, bool aBatched) {
+    UART_BD_initialize(aBaudRate);
+    sLinkData.clear();
+    initLines();
+    fillCanvas(sCanvas, COLOR_ACC_GYRO_BACKGROUND);
+    hostResetLinkCounters();
+
+    uint64_t tLinkNanos = 0;
+    uint64_t tMaxLinkNanos = 0;
+    uint64_t tHostNanos = 0;
+    int tNumberOfCommands = 0;
+    int tDifferentPixels = 0;
+    int tFramesWithDifferences = 0;
+    for (int i = 0; i < NUMBER_OF_FRAMES; ++i) {
+        int16_t tNewRelEnds[NUMBER_OF_VECTORS][2];
+        getSensorVectors(i, tNewRelEnds);
+
+        uint64_t tStartLinkNanos = HostLinkNanos;
+        uint64_t tStartHostNanos = getHostNanos();
+        if (aBatched) {
+            BlueDisplay1.refreshVectors(sLinePointers, tNewRelEnds, NUMBER_OF_VECTORS);
+        } else {
+            for (int j = 0; j < NUMBER_OF_VECTORS; ++j) {
+                BlueDisplay1.refreshVector(&sLines[j], tNewRelEnds[j][0], tNewRelEnds[j][1]);
+            }
+        }
+        tHostNanos += getHostNanos() - tStartHostNanos;
+        hostFlushLink();
+        uint64_t tFrameLinkNanos = HostLinkNanos - tStartLinkNanos;
+        tLinkNanos += tFrameLinkNanos;
+        if (tFrameLinkNanos > tMaxLinkNanos) {
+            tMaxLinkNanos = tFrameLinkNanos;
+        }
+
+        tNumberOfCommands += renderLinkData();
+        int tDifference = compareWithReference();
+        tDifferentPixels += tDifference;
+        if (tDifference > 0) {
+            tFramesWithDifferences++;
+        }
+        hostAdvanceLinkTime(FRAME_INTERVAL_NANOS - (uint32_t) tFrameLinkNanos);
+    }
+
+    printf("%6lu baud %-15s: %5.3f ms per frame (max %5.3f), %4.1f commands %5.1f bytes %4.2f transfers per frame,"
+            " host %4.0f ns, %3d frames with %5d wrong pixels\n", (unsigned long) aBaudRate,
+            aBatched ? "refreshVectors" : "refreshVector", tLinkNanos / 1e6 / NUMBER_OF_FRAMES, tMaxLinkNanos / 1e6,
+            (double) tNumberOfCommands / NUMBER_OF_FRAMES, (double) HostLinkCounters.Bytes / NUMBER_OF_FRAMES,
+            (double) HostLinkCounters.Transfers / NUMBER_OF_FRAMES, (double) tHostNanos / NUMBER_OF_FRAMES,
+            tFramesWithDifferences, tDifferentPixels);
+}
+
+int main(void) {
+    HostBluetoothPaired = true;
+    HostLinkWriteCallback = &captureLinkData;
+    BlueDisplay1.mReferenceDisplaySize.XWidth = REMOTE_DISPLAY_WIDTH;
+    BlueDisplay1.mReferenceDisplaySize.YHeight = REMOTE_DISPLAY_HEIGHT;
+
+    printf("%d frames of %d vectors, update time is start of update to last byte on link, %u ns overhead per transfer\n",
+    NUMBER_OF_FRAMES, NUMBER_OF_VECTORS, HostLinkTransferOverheadNanos);
+    runBenchmark(BAUD_115200, false);
+    runBenchmark(BAUD_115200, true);
+    runBenchmark(BAUD_921600, false);
+    runBenchmark(BAUD_921600, true);
+    return 0;
+}
+
+#endif // HOST_SIMULATION
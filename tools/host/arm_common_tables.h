@@ -0,0 +1,17 @@
+/**
+ * @file arm_common_tables.h
+ *
+ * Stand-in for the CMSIS-DSP table header for programs built with HOST_SIMULATION on x86 Linux.
+ *
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ */
+
+#ifndef TOOLS_HOST_ARM_COMMON_TABLES_H_
+#define TOOLS_HOST_ARM_COMMON_TABLES_H_
+
+#include "arm_math.h"
+
+// only for the parameter of arm_radix4_butterfly_f32(), the FFT of HostDSO.cpp computes its own twiddle factors
+extern const float32_t twiddleCoef_256[512];
+
+#endif /* TOOLS_HOST_ARM_COMMON_TABLES_H_ */
@@ -0,0 +1,18 @@
+/**
+ * @file arm_math.h
+ *
+ * Stand-in for the CMSIS-DSP header for programs built with HOST_SIMULATION on x86 Linux.
+ * Only the type is provided. The FFT functions used by TouchDSOAcquisition.cpp are declared there
+ * and implemented for host in HostDSO.cpp.
+ *
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ */
+
+#ifndef TOOLS_HOST_ARM_MATH_H_
+#define TOOLS_HOST_ARM_MATH_H_
+
+#include <stdint.h>
+
+typedef float float32_t;
+
+#endif /* TOOLS_HOST_ARM_MATH_H_ */
@@ -0,0 +1,120 @@
+#!/usr/bin/env python3
+"""
+symbolizeProfile.py
+
+Prints a flat profile per function for a PC histogram dumped by dumpProfilerToFile() or dumpProfilerToUSB()
+of lib/src/Profiler.cpp. The addresses are resolved with the symbol table of the ELF file of the same firmware.
+The samples of a bucket, which contains the end of one function and the start of the next one,
+are distributed to the functions in proportion to their bytes in the bucket.
+
+Usage on x86 Linux from project root:
+  tools/host/symbolizeProfile.py Debug/STMF3-Discovery-Demos.elf 20161017.prf
+  tools/host/symbolizeProfile.py --nm nm --top 20 a.out profile.prf
+
+ @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+"""
+
+import argparse
+import bisect
+import subprocess
+import sys
+
+
+def readSymbols(aNm, aElfFile):
+    """ returns sorted list of (start, end, name) of all code symbols """
+    tOutput = subprocess.check_output([aNm, "-n", "-S", "-C", "--defined-only", aElfFile], universal_newlines=True)
+    tSymbols = []
+    for tLine in tOutput.splitlines():
+        tFields = tLine.split(None, 3)
+        # with size: address size type name, without size: address type name
+        if len(tFields) == 4 and len(tFields[2]) == 1:
+            tAddress, tSize, tType, tName = int(tFields[0], 16), int(tFields[1], 16), tFields[2], tFields[3]
+        elif len(tFields) >= 3 and len(tFields[1]) == 1:
+            tAddress, tSize, tType, tName = int(tFields[0], 16), 0, tFields[1], tLine.split(None, 2)[2]
+        else:
+            continue
+        # skip data and ARM mapping symbols like $t and $d
+        if tType not in "tTwW" or tName.startswith("$"):
+            continue
+        tSymbols.append([tAddress & ~1, tSize, tName])
+    tSymbols.sort()
+    # keep only one of the aliases of a function
+    tSymbols = [tSymbol for i, tSymbol in enumerate(tSymbols) if i == 0 or tSymbol[0] != tSymbols[i - 1][0]]
+    tResult = []
+    for i, (tAddress, tSize, tName) in enumerate(tSymbols):
+        if i + 1 < len(tSymbols):
+            # up to next symbol to include alignment padding and literal pool
+            tSize = max(tSize, tSymbols[i + 1][0] - tAddress)
+        elif tSize == 0:
+            tSize = 4
+        tResult.append((tAddress, tAddress + tSize, tName))
+    return tResult
+
+
+def readProfile(aProfileFile):
+    tHeader = {}
+    tHistogram = []
+    with open(aProfileFile) as tFile:
+        for tLine in tFile:
+            tFields = tLine.split()
+            if not tFields or tFields[0].startswith("#"):
+                continue
+            if tFields[0] == "end":
+                break
+            if tFields[0] in ("samples", "idle", "dropped", "bucket"):
+                tHeader[tFields[0]] = int(tFields[1])
+            else:
+                tHistogram.append((int(tFields[0], 16), int(tFields[1])))
+    if "samples" not in tHeader:
+        sys.exit("%s is no PC profile" % aProfileFile)
+    return tHeader, tHistogram
+
+
+def main():
+    tParser = argparse.ArgumentParser(description="Flat profile per function from a PC histogram")
+    tParser.add_argument("elf", help="ELF file of the profiled firmware")
+    tParser.add_argument("profile", help="profile dump")
+    tParser.add_argument("--nm", default="arm-none-eabi-nm", help="nm of the toolchain (default: %(default)s)")
+    tParser.add_argument("--top", type=int, default=0, help="print only the first TOP functions")
+    tArgs = tParser.parse_args()
+
+    tSymbols = readSymbols(tArgs.nm, tArgs.elf)
+    tStarts = [tSymbol[0] for tSymbol in tSymbols]
+    tHeader, tHistogram = readProfile(tArgs.profile)
+
+    tBucketSize = tHeader.get("bucket", 2)
+    tCounts = {}
+    for tBucketStart, tCount in tHistogram:
+        tBucketEnd = tBucketStart + tBucketSize
+        tIndex = max(bisect.bisect_right(tStarts, tBucketStart) - 1, 0)
+        tCoveredBytes = 0
+        # functions overlapping the bucket
+        while tIndex < len(tSymbols) and tSymbols[tIndex][0] < tBucketEnd:
+            tOverlap = min(tSymbols[tIndex][1], tBucketEnd) - max(tSymbols[tIndex][0], tBucketStart)
+            if tOverlap > 0:
+                tName = tSymbols[tIndex][2]
+                tCounts[tName] = tCounts.get(tName, 0) + tCount * tOverlap / tBucketSize
+                tCoveredBytes += tOverlap
+            tIndex += 1
+        if tCoveredBytes < tBucketSize:
+            tName = "?? 0x%08X" % tBucketStart
+            tCounts[tName] = tCounts.get(tName, 0) + tCount * (tBucketSize - tCoveredBytes) / tBucketSize
+    if tHeader.get("idle", 0) > 0:
+        tCounts["<tickless idle>"] = tHeader["idle"]
+    if tHeader.get("dropped", 0) > 0:
+        tCounts["<dropped, histogram full>"] = tHeader["dropped"]
+
+    tTotal = tHeader["samples"]
+    print("%d samples, %d functions" % (tTotal, len(tCounts)))
+    print("%7s %10s %7s  %s" % ("%", "samples", "cum. %", "function"))
+    tCumulated = 0
+    tSorted = sorted(tCounts.items(), key=lambda tItem: (-tItem[1], tItem[0]))
+    if tArgs.top > 0:
+        tSorted = tSorted[:tArgs.top]
+    for tName, tCount in tSorted:
+        tCumulated += tCount
+        print("%7.2f %10.1f %7.2f  %s" % (100.0 * tCount / tTotal, tCount, 100.0 * tCumulated / tTotal, tName))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,109 @@
+#!/usr/bin/env python3
+"""
+traceToChrome.py
+
+Converts a trace ring dumped by dumpEventTraceToFile() of lib/src/EventTrace.cpp to the JSON trace event format,
+which is displayed by chrome://tracing and https://ui.perfetto.dev.
+Thread mode code and each ISR get their own track, page transitions are shown on an extra track.
+The 32 bit cycle counter is unwrapped, so the gap between two records must be less than 59 seconds at 72 MHz.
+End records without begin, which can occur at the start of a wrapped ring, are skipped.
+
+Usage on x86 Linux from project root:
+  tools/host/traceToChrome.py 20161017.trc trace.json
+
+ @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+"""
+
+import argparse
+import json
+import struct
+import sys
+
+TRACE_TYPE_BEGIN = 0
+TRACE_TYPE_END = 1
+TRACE_TYPE_INSTANT = 2
+TRACE_ID_PAGE = 6
+PAGE_TRACK = 1000
+
+# exception numbers of the ISRs with trace points, see startup_stm32f30x.S
+EXCEPTION_NAMES = {27: "DMA1_Channel1", 34: "ADC1_2"}
+
+
+def readTrace(aFileName):
+    with open(aFileName, "rb") as tFile:
+        tData = tFile.read()
+    if tData[0:4] != b"ETRC":
+        sys.exit("%s is no event trace" % aFileName)
+    tVersion, tNumberOfRecords, tCyclesPerSecond, tOverwritten, tNumberOfNames = struct.unpack_from("<HHIIB", tData, 4)
+    if tVersion != 1:
+        sys.exit("unknown trace version %d" % tVersion)
+    tOffset = 17
+    tNames = []
+    for _ in range(tNumberOfNames):
+        tEnd = tData.index(b"\0", tOffset)
+        tNames.append(tData[tOffset:tEnd].decode("ascii"))
+        tOffset = tEnd + 1
+    tRecords = [struct.unpack_from("<IHBB", tData, tOffset + i * 8) for i in range(tNumberOfRecords)]
+    return tCyclesPerSecond, tOverwritten, tNames, tRecords
+
+
+def main():
+    tParser = argparse.ArgumentParser(description="Convert event trace dump to Chrome / Perfetto JSON")
+    tParser.add_argument("trace", help="trace dump")
+    tParser.add_argument("json", help="output file")
+    tArgs = tParser.parse_args()
+
+    tCyclesPerSecond, tOverwritten, tNames, tRecords = readTrace(tArgs.trace)
+    tEvents = [{"name": "thread_name", "ph": "M", "pid": 1, "tid": 0, "args": {"name": "main loop"}},
+            {"name": "thread_name", "ph": "M", "pid": 1, "tid": PAGE_TRACK, "args": {"name": "pages"}}]
+    tOpenScopes = {}  # track -> list of open IDs
+    tTracks = set()
+    tCycles = 0
+    tLastCycles = tRecords[0][0] if tRecords else 0
+    tSkipped = 0
+    for tCounter, tArgument, tTypeAndId, tException in tRecords:
+        tCycles += (tCounter - tLastCycles) & 0xFFFFFFFF
+        tLastCycles = tCounter
+        tType = tTypeAndId >> 6
+        tId = tTypeAndId & 0x3F
+        tName = tNames[tId] if tId < len(tNames) else "id %d" % tId
+        tTrack = PAGE_TRACK if tId == TRACE_ID_PAGE else tException
+        if tTrack not in tTracks and tTrack != 0 and tTrack != PAGE_TRACK:
+            tTracks.add(tTrack)
+            tEvents.append({"name": "thread_name", "ph": "M", "pid": 1, "tid": tTrack,
+                    "args": {"name": EXCEPTION_NAMES.get(tTrack, "exception %d" % tTrack)}})
+        tEvent = {"name": tName, "pid": 1, "tid": tTrack, "ts": tCycles * 1e6 / tCyclesPerSecond}
+        tStack = tOpenScopes.setdefault(tTrack, [])
+        if tType == TRACE_TYPE_BEGIN:
+            if tId == TRACE_ID_PAGE and tStack:
+                # page left without backToMainMenu()
+                tEvents.append({"name": tName, "ph": "E", "pid": 1, "tid": tTrack, "ts": tEvent["ts"]})
+                tStack.pop()
+            tEvent["ph"] = "B"
+            tEvent["args"] = {"argument": tArgument}
+            tStack.append(tId)
+        elif tType == TRACE_TYPE_END:
+            if tId not in tStack:
+                tSkipped += 1
+                continue
+            # close scopes left open by lost records
+            while tStack[-1] != tId:
+                tEvents.append({"name": tNames[tStack.pop()], "ph": "E", "pid": 1, "tid": tTrack, "ts": tEvent["ts"]})
+            tStack.pop()
+            tEvent["ph"] = "E"
+        else:
+            tEvent["ph"] = "i"
+            tEvent["s"] = "t"
+            tEvent["args"] = {"argument": tArgument}
+        tEvents.append(tEvent)
+
+    with open(tArgs.json, "w") as tFile:
+        json.dump({"traceEvents": tEvents, "displayTimeUnit": "ns",
+                "otherData": {"cycles per second": tCyclesPerSecond, "overwritten records": tOverwritten}}, tFile,
+                indent=0)
+    print("%d records, %d overwritten, %d end records without begin skipped, %.3f ms" % (len(tRecords), tOverwritten,
+            tSkipped, tCycles * 1e3 / tCyclesPerSecond))
+
+
+if __name__ == "__main__":
+    main()